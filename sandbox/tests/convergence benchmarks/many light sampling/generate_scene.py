@@ -0,0 +1,257 @@
+
+#
+# This source file is part of appleseed.
+# Visit https://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2018 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+# Generates the many-light scene used by measure_convergence.py: a ground plane lit
+# by a cloud of small emitting triangles with random orientations. About half of the
+# triangles face away from the ground, which makes the scene sensitive to whether the
+# light sampler accounts for the orientation of the lights.
+#
+# data/emitters.obj is not under version control: run
+#
+#   python generate_scene.py
+#
+# to (re)generate it along with the scene file. measure_convergence.py does it automatically
+# when the mesh is missing. The output only depends on the parameters below.
+
+from __future__ import print_function
+
+import math
+import os
+import random
+
+# Scene parameters.
+GridSize = 32                   # the scene contains GridSize x GridSize emitting triangles
+GridExtent = 40.0               # the emitters cover [-GridExtent/2, GridExtent/2]^2
+MinHeight = 1.0
+MaxHeight = 6.0
+TriangleSize = 0.6
+GroundSize = 60.0
+Seed = 42
+ColorCount = 4
+
+SceneFilename = "many oriented emitters.appleseed"
+EmittersFilename = os.path.join("data", "emitters.obj")
+GroundFilename = os.path.join("data", "ground.obj")
+
+
+def normalize(v):
+    n = math.sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2])
+    return (v[0] / n, v[1] / n, v[2] / n)
+
+
+def cross(a, b):
+    return (a[1] * b[2] - a[2] * b[1],
+            a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0])
+
+
+def random_direction(rng):
+    z = rng.uniform(-1.0, 1.0)
+    phi = rng.uniform(0.0, 2.0 * math.pi)
+    r = math.sqrt(1.0 - z * z)
+    return (r * math.cos(phi), z, r * math.sin(phi))
+
+
+def make_triangle(center, normal):
+    # Build an orthonormal basis around the normal.
+    helper = (1.0, 0.0, 0.0) if abs(normal[0]) < 0.9 else (0.0, 0.0, 1.0)
+    u = normalize(cross(helper, normal))
+    v = cross(normal, u)
+
+    vertices = []
+    for i in range(3):
+        angle = 2.0 * math.pi * i / 3.0
+        cu = math.cos(angle) * TriangleSize
+        cv = math.sin(angle) * TriangleSize
+        vertices.append(tuple(center[k] + cu * u[k] + cv * v[k] for k in range(3)))
+
+    return vertices
+
+
+def write_emitters(rng):
+    with open(EmittersFilename, "w") as f:
+        f.write("# {0} randomly oriented emitting triangles.\n".format(GridSize * GridSize))
+
+        triangles = [[] for _ in range(ColorCount)]
+        step = GridExtent / GridSize
+        for j in range(GridSize):
+            for i in range(GridSize):
+                center = (-0.5 * GridExtent + (i + rng.uniform(0.25, 0.75)) * step,
+                          rng.uniform(MinHeight, MaxHeight),
+                          -0.5 * GridExtent + (j + rng.uniform(0.25, 0.75)) * step)
+                normal = random_direction(rng)
+                triangles[rng.randrange(ColorCount)].append((make_triangle(center, normal), normal))
+
+        vertex_index = 1
+        for color_index in range(ColorCount):
+            f.write("o part_{0}\n".format(color_index))
+            for vertices, normal in triangles[color_index]:
+                for vertex in vertices:
+                    f.write("v {0:.6f} {1:.6f} {2:.6f}\n".format(*vertex))
+                f.write("vn {0:.6f} {1:.6f} {2:.6f}\n".format(*normal))
+            f.write("usemtl default\n")
+            for vertices, normal in triangles[color_index]:
+                normal_index = (vertex_index - 1) // 3 + 1
+                f.write("f {0}//{3} {1}//{3} {2}//{3}\n".format(
+                    vertex_index, vertex_index + 1, vertex_index + 2, normal_index))
+                vertex_index += 3
+
+
+def write_ground():
+    h = 0.5 * GroundSize
+    with open(GroundFilename, "w") as f:
+        f.write("v {0} 0 {0}\nv {1} 0 {0}\nv {1} 0 {1}\nv {0} 0 {1}\n".format(-h, h))
+        f.write("vn 0 1 0\n")
+        f.write("o ground\n")
+        f.write("usemtl default\n")
+        f.write("f 1//1 4//1 3//1 2//1\n")
+
+
+def write_scene(rng):
+    colors = ""
+    edfs = ""
+    materials = ""
+    instances = ""
+
+    for i in range(ColorCount):
+        hue = float(i) / ColorCount
+        rgb = [0.5 + 0.5 * math.cos(2.0 * math.pi * (hue + k / 3.0)) for k in range(3)]
+        colors += """            <color name="light_color_{0}">
+                <parameter name="color_space" value="linear_rgb" />
+                <values>
+                    {1:.6f} {2:.6f} {3:.6f}
+                </values>
+            </color>
+""".format(i, *rgb)
+        edfs += """            <edf name="light_edf_{0}" model="diffuse_edf">
+                <parameter name="radiance" value="light_color_{0}" />
+                <parameter name="radiance_multiplier" value="{1:.3f}" />
+            </edf>
+""".format(i, rng.uniform(5.0, 20.0))
+        materials += """            <material name="light_material_{0}" model="generic_material">
+                <parameter name="edf" value="light_edf_{0}" />
+                <parameter name="surface_shader" value="physical_shader" />
+            </material>
+""".format(i)
+        instances += """            <object_instance name="emitters_{0}_inst" object="emitters.part_{0}">
+                <parameters name="visibility">
+                    <parameter name="camera" value="false" />
+                </parameters>
+                <assign_material slot="default" side="front" material="light_material_{0}" />
+                <assign_material slot="default" side="back" material="ground_material" />
+            </object_instance>
+""".format(i)
+
+    with open(SceneFilename, "w") as f:
+        f.write("""<?xml version="1.0" encoding="UTF-8"?>
+<!-- File generated by generate_scene.py. -->
+<project format_revision="27">
+    <search_paths>
+        <search_path>
+            data
+        </search_path>
+    </search_paths>
+    <scene>
+        <camera name="camera" model="pinhole_camera">
+            <parameter name="film_dimensions" value="0.025 0.025" />
+            <parameter name="focal_length" value="0.02" />
+            <transform>
+                <look_at origin="0 30 32" target="0 0 0" up="0 1 0" />
+            </transform>
+        </camera>
+        <assembly name="assembly">
+{colors}            <color name="grey">
+                <parameter name="color_space" value="linear_rgb" />
+                <values>
+                    0.500000
+                </values>
+            </color>
+{edfs}            <bsdf name="ground_brdf" model="lambertian_brdf">
+                <parameter name="reflectance" value="grey" />
+            </bsdf>
+            <surface_shader name="physical_shader" model="physical_surface_shader" />
+            <material name="ground_material" model="generic_material">
+                <parameter name="bsdf" value="ground_brdf" />
+                <parameter name="surface_shader" value="physical_shader" />
+            </material>
+{materials}            <object name="ground" model="mesh_object">
+                <parameter name="filename" value="ground.obj" />
+            </object>
+            <object name="emitters" model="mesh_object">
+                <parameter name="filename" value="emitters.obj" />
+            </object>
+            <object_instance name="ground_inst" object="ground.ground">
+                <assign_material slot="default" side="front" material="ground_material" />
+                <assign_material slot="default" side="back" material="ground_material" />
+            </object_instance>
+{instances}        </assembly>
+        <assembly_instance name="assembly_inst" assembly="assembly">
+        </assembly_instance>
+    </scene>
+    <output>
+        <frame name="beauty">
+            <parameter name="camera" value="camera" />
+            <parameter name="filter" value="box" />
+            <parameter name="filter_size" value="0.5" />
+            <parameter name="resolution" value="256 256" />
+            <parameter name="tile_size" value="32 32" />
+        </frame>
+    </output>
+    <configurations>
+        <configuration name="final" base="base_final">
+            <parameter name="pixel_renderer" value="uniform" />
+            <parameters name="pt">
+                <parameter name="max_bounces" value="1" />
+            </parameters>
+            <parameters name="uniform_pixel_renderer">
+                <parameter name="samples" value="16" />
+            </parameters>
+        </configuration>
+        <configuration name="interactive" base="base_interactive" />
+    </configurations>
+</project>
+""".format(colors=colors, edfs=edfs, materials=materials, instances=instances))
+
+
+def main():
+    os.chdir(os.path.dirname(os.path.realpath(__file__)))
+
+    rng = random.Random(Seed)
+
+    if not os.path.isdir("data"):
+        os.makedirs("data")
+
+    write_emitters(rng)
+    write_ground()
+    write_scene(rng)
+
+    print("Wrote {0}.".format(SceneFilename))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+
+#
+# This source file is part of appleseed.
+# Visit https://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2018 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+# Measures the convergence of the light sampling strategies of the path tracer on the
+# many-light scene generated by generate_scene.py. Every strategy renders the scene at
+# the same numbers of samples per pixel; the script reports render time and RMS error
+# with respect to a high sample count reference rendered with the CDF light sampler.
+#
+# The emitters mesh is generated by generate_scene.py the first time the script runs.
+#
+# Requires the OpenImageIO Python bindings to read the rendered OpenEXR images.
+
+from __future__ import print_function
+
+import argparse
+import math
+import os
+import re
+import subprocess
+
+import OpenImageIO as oiio
+
+import generate_scene
+
+
+SceneFilename = "many oriented emitters.appleseed"
+OutputDirectory = "renders"
+
+Strategies = [
+    ("cdf", ["light_sampler.algorithm=cdf"]),
+    ("light tree", ["light_sampler.algorithm=lighttree"]),
+    ("light tree + splitting", ["light_sampler.algorithm=lighttree",
+                                "light_sampler.lighttree_split_threshold=0.5",
+                                "light_sampler.lighttree_max_split_count=8"]),
+]
+
+
+def render(appleseed_path, params, spp, output_filename, threads):
+    command_line = [appleseed_path, SceneFilename, "--benchmark-mode",
+                    "--samples", str(spp), str(spp),
+                    "-o", output_filename]
+
+    if threads is not None:
+        command_line += ["--threads", str(threads)]
+
+    for param in params:
+        command_line += ["-p", param]
+
+    output = subprocess.check_output(command_line, stderr=subprocess.STDOUT).decode("utf-8")
+
+    match = re.search(r"^render_time=(.*)[\r\n]+$", output, re.MULTILINE)
+    if match is None:
+        raise RuntimeError("failed to render {0}:\n{1}".format(output_filename, output))
+
+    return float(match.group(1))
+
+
+def read_image(filename):
+    image = oiio.ImageInput.open(filename)
+    if image is None:
+        raise RuntimeError("failed to open {0}: {1}".format(filename, oiio.geterror()))
+
+    spec = image.spec()
+    pixels = image.read_image(oiio.FLOAT)
+    image.close()
+
+    return spec.width, spec.height, spec.nchannels, pixels
+
+
+def compute_rms_error(filename, reference):
+    width, height, channels, pixels = read_image(filename)
+    ref_width, ref_height, ref_channels, ref_pixels = reference
+    assert (width, height) == (ref_width, ref_height)
+
+    # Only compare the RGB channels.
+    total = 0.0
+    for y in range(height):
+        for x in range(width):
+            for c in range(3):
+                d = float(pixels[y][x][c]) - float(ref_pixels[y][x][c])
+                total += d * d
+
+    return math.sqrt(total / (width * height * 3))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="measure the convergence of light sampling strategies.")
+    parser.add_argument("appleseed_path", help="path to the appleseed.cli executable")
+    parser.add_argument("--spp", nargs="+", type=int, default=[1, 2, 4, 8, 16, 32],
+                        help="numbers of samples per pixel to render each strategy with")
+    parser.add_argument("--reference-spp", type=int, default=4096,
+                        help="number of samples per pixel of the reference image")
+    parser.add_argument("--threads", type=int, help="number of rendering threads")
+    args = parser.parse_args()
+
+    script_directory = os.path.dirname(os.path.realpath(__file__))
+    os.chdir(script_directory)
+
+    if not os.path.isfile(generate_scene.EmittersFilename):
+        print("Generating the scene...")
+        generate_scene.main()
+
+    if not os.path.isdir(OutputDirectory):
+        os.makedirs(OutputDirectory)
+
+    reference_filename = os.path.join(OutputDirectory, "reference.exr")
+    if not os.path.isfile(reference_filename):
+        print("Rendering reference image at {0} spp...".format(args.reference_spp))
+        render(args.appleseed_path, Strategies[0][1], args.reference_spp, reference_filename, args.threads)
+    reference = read_image(reference_filename)
+
+    print("{0:<24} {1:>6} {2:>12} {3:>12}".format("strategy", "spp", "time (s)", "rms error"))
+
+    for name, params in Strategies:
+        for spp in args.spp:
+            output_filename = os.path.join(
+                OutputDirectory, "{0} - {1} spp.exr".format(name.replace(" + ", " "), spp))
+            render_time = render(args.appleseed_path, params, spp, output_filename, args.threads)
+            rms_error = compute_rms_error(output_filename, reference)
+            print("{0:<24} {1:>6} {2:>12.3f} {3:>12.6f}".format(name, spp, render_time, rms_error))
+
+
+if __name__ == "__main__":
+    main()
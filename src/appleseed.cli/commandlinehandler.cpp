@@ -153,7 +153,7 @@ CommandLineHandler::CommandLineHandler()
     parser().add_option_handler(
         &m_checkpoint_create
             .add_name("--checkpoint-create")
-            .set_description("write a rendering checkpoint after each pass")
+            .set_description("write a rendering checkpoint after each tile and pass")
             .set_syntax("filename")
             .set_min_value_count(0)
             .set_max_value_count(1));
@@ -166,6 +166,11 @@ CommandLineHandler::CommandLineHandler()
             .set_min_value_count(0)
             .set_max_value_count(1));
 
+    parser().add_option_handler(
+        &m_stream_output
+            .add_name("--stream-output")
+            .set_description("write the output file as a multipart openexr file, tile by tile while rendering"));
+
     parser().add_option_handler(
         &m_send_to_stdout
             .add_name("--to-stdout")
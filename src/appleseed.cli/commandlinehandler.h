@@ -78,6 +78,7 @@ class CommandLineHandler
 #endif
     foundation::ValueOptionHandler<std::string>         m_checkpoint_create;
     foundation::ValueOptionHandler<std::string>         m_checkpoint_resume;
+    foundation::FlagOptionHandler                       m_stream_output;
     foundation::FlagOptionHandler                       m_send_to_stdout;
     foundation::FlagOptionHandler                       m_disable_autosave;
     foundation::ValueOptionHandler<std::string>         m_save_light_paths;
@@ -376,6 +376,15 @@ namespace
                     : "");
         }
 
+        if (g_cl.m_stream_output.is_set() && !g_cl.m_output.is_set())
+        {
+            LOG_ERROR(
+                g_logger,
+                "output path must be specified when using %s",
+                g_cl.m_stream_output.get_name().c_str());
+            return false;
+        }
+
         if (g_cl.m_passes.is_set())
             params.insert_path("passes", g_cl.m_passes.values()[0]);
 
@@ -548,6 +557,21 @@ namespace
             }
         }
 
+        // Optionally write the output file while rendering.
+        unique_ptr<StreamingEXRTileCallbackFactory> streaming_tile_callback_factory;
+        TileCallbackCollectionFactory tile_callback_collection_factory;
+        if (g_cl.m_stream_output.is_set())
+        {
+            streaming_tile_callback_factory.reset(
+                new StreamingEXRTileCallbackFactory(
+                    g_cl.m_output.value().c_str(),
+                    params.get_optional<size_t>("passes", 1)));
+
+            if (tile_callback_factory)
+                tile_callback_collection_factory.insert(tile_callback_factory.get());
+            tile_callback_collection_factory.insert(streaming_tile_callback_factory.get());
+        }
+
         SearchPaths resource_search_paths;
         Application::initialize_resource_search_paths(resource_search_paths);
 
@@ -558,7 +582,9 @@ namespace
             params,
             resource_search_paths,
             &renderer_controller,
-            tile_callback_factory.get());
+            streaming_tile_callback_factory
+                ? &tile_callback_collection_factory
+                : tile_callback_factory.get());
 
         // Render the frame.
         LOG_INFO(g_logger, "rendering frame...");
@@ -601,7 +627,16 @@ namespace
         }
 
         // Optionally write the frame to disk.
-        if (g_cl.m_output.is_set())
+        if (streaming_tile_callback_factory)
+        {
+            // Only write the frame if it could not be written while rendering.
+            if (!streaming_tile_callback_factory->is_complete())
+            {
+                const char* file_path = g_cl.m_output.value().c_str();
+                project->get_frame()->write_main_and_aov_images_to_multipart_exr(file_path);
+            }
+        }
+        else if (g_cl.m_output.is_set())
         {
             const char* file_path = g_cl.m_output.value().c_str();
             if (!project->get_frame()->write_main_image(file_path))
@@ -129,7 +129,7 @@ void ObjectCollectionItem::slot_import_objects()
         get_open_filenames(
             treeWidget(),
             "Import Objects...",
-            "Geometry Files (*.binarymesh *.obj);;All Files (*.*)",
+            "Geometry Files (*.binarymesh *.mappedmesh *.obj);;All Files (*.*)",
             m_editor_context.m_settings,
             SETTINGS_FILE_DIALOG_PROJECTS);
 
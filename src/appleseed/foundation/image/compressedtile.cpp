@@ -0,0 +1,438 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "compressedtile.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace foundation
+{
+
+namespace
+{
+    //
+    // Conversion tables from 8-bit values to floating-point values.
+    //
+
+    struct ConversionTables
+    {
+        float   m_linear[256];
+        float   m_srgb_to_linear_rgb[256];
+
+        ConversionTables()
+        {
+            for (size_t i = 0; i < 256; ++i)
+            {
+                m_linear[i] = static_cast<float>(i) / 255.0f;
+                m_srgb_to_linear_rgb[i] = srgb_to_linear_rgb(m_linear[i]);
+            }
+        }
+    };
+
+    const ConversionTables& get_conversion_tables()
+    {
+        static const ConversionTables tables;
+        return tables;
+    }
+
+    //
+    // Block encoding.
+    //
+
+    typedef uint8 BlockPixels[16][4];
+
+    inline uint16 quantize_565(const int r, const int g, const int b)
+    {
+        return
+            static_cast<uint16>(
+                ((r * 31 + 127) / 255) << 11 |
+                ((g * 63 + 127) / 255) << 5 |
+                ((b * 31 + 127) / 255));
+    }
+
+    inline void expand_565(const uint16 c, int rgb[3])
+    {
+        const int r = (c >> 11) & 31;
+        const int g = (c >> 5) & 63;
+        const int b = c & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    inline int clamp_to_uint8(const float x)
+    {
+        return min(max(static_cast<int>(x + 0.5f), 0), 255);
+    }
+
+    // Use the corners of the bounding box of the block's colors as endpoints.
+    void compute_bbox_endpoints(const BlockPixels& pixels, uint16& q0, uint16& q1)
+    {
+        int lo[3] = { 255, 255, 255 };
+        int hi[3] = { 0, 0, 0 };
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                lo[c] = min<int>(lo[c], pixels[i][c]);
+                hi[c] = max<int>(hi[c], pixels[i][c]);
+            }
+        }
+
+        q0 = quantize_565(lo[0], lo[1], lo[2]);
+        q1 = quantize_565(hi[0], hi[1], hi[2]);
+    }
+
+    // Use the extremes of the block's colors along the principal axis of these colors as endpoints.
+    // Unlike the bounding box, this follows gradients between colors of different hues.
+    void compute_principal_axis_endpoints(const BlockPixels& pixels, uint16& q0, uint16& q1)
+    {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            for (size_t c = 0; c < 3; ++c)
+                mean[c] += pixels[i][c];
+        }
+
+        for (size_t c = 0; c < 3; ++c)
+            mean[c] *= 1.0f / 16;
+
+        // Covariance matrix of the colors.
+        float cov[3][3] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            float d[3];
+
+            for (size_t c = 0; c < 3; ++c)
+                d[c] = pixels[i][c] - mean[c];
+
+            for (size_t r = 0; r < 3; ++r)
+            {
+                for (size_t c = 0; c < 3; ++c)
+                    cov[r][c] += d[r] * d[c];
+            }
+        }
+
+        // Start the power iteration from the row of largest variance, which is never
+        // orthogonal to the principal axis unless the block is uniform.
+        size_t start_row = 0;
+
+        for (size_t r = 1; r < 3; ++r)
+        {
+            if (cov[r][r] > cov[start_row][start_row])
+                start_row = r;
+        }
+
+        if (cov[start_row][start_row] == 0.0f)
+        {
+            // Uniform block.
+            q0 = q1 =
+                quantize_565(
+                    clamp_to_uint8(mean[0]),
+                    clamp_to_uint8(mean[1]),
+                    clamp_to_uint8(mean[2]));
+            return;
+        }
+
+        float axis[3] = { cov[start_row][0], cov[start_row][1], cov[start_row][2] };
+
+        for (size_t k = 0; k < 8; ++k)
+        {
+            float next[3];
+
+            for (size_t r = 0; r < 3; ++r)
+                next[r] = cov[r][0] * axis[0] + cov[r][1] * axis[1] + cov[r][2] * axis[2];
+
+            const float norm = sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+
+            for (size_t c = 0; c < 3; ++c)
+                axis[c] = next[c] / norm;
+        }
+
+        // Project the colors onto the axis.
+        float t_min = numeric_limits<float>::max();
+        float t_max = -numeric_limits<float>::max();
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            float t = 0.0f;
+
+            for (size_t c = 0; c < 3; ++c)
+                t += (pixels[i][c] - mean[c]) * axis[c];
+
+            t_min = min(t_min, t);
+            t_max = max(t_max, t);
+        }
+
+        int e0[3], e1[3];
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            e0[c] = clamp_to_uint8(mean[c] + t_min * axis[c]);
+            e1[c] = clamp_to_uint8(mean[c] + t_max * axis[c]);
+        }
+
+        q0 = quantize_565(e0[0], e0[1], e0[2]);
+        q1 = quantize_565(e1[0], e1[1], e1[2]);
+    }
+
+    // Pick for each pixel the closest of the four colors interpolated between two endpoints.
+    // Return the sum of the squared errors of the block.
+    int compute_bc1_indices(
+        const BlockPixels&  pixels,
+        const uint16        q0,
+        const uint16        q1,
+        uint32&             indices)
+    {
+        int e0[3], e1[3];
+        expand_565(q0, e0);
+        expand_565(q1, e1);
+
+        int error = 0;
+        indices = 0;
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            size_t best_index = 0;
+            int best_distance = numeric_limits<int>::max();
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                int distance = 0;
+
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    const int d = impl::interpolate_bc1(e0[c], e1[c], j) - pixels[i][c];
+                    distance += d * d;
+                }
+
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best_index = j;
+                }
+            }
+
+            indices |= static_cast<uint32>(best_index) << (2 * i);
+            error += best_distance;
+        }
+
+        return error;
+    }
+
+    void encode_bc1(const BlockPixels& pixels, uint8* block)
+    {
+        uint16 q0, q1;
+        compute_principal_axis_endpoints(pixels, q0, q1);
+
+        uint32 indices;
+        const int error = compute_bc1_indices(pixels, q0, q1, indices);
+
+        // Quantization of the endpoints may occasionally make the bounding box a better fit.
+        if (error > 0)
+        {
+            uint16 bbox_q0, bbox_q1;
+            compute_bbox_endpoints(pixels, bbox_q0, bbox_q1);
+
+            uint32 bbox_indices;
+            if (compute_bc1_indices(pixels, bbox_q0, bbox_q1, bbox_indices) < error)
+            {
+                q0 = bbox_q0;
+                q1 = bbox_q1;
+                indices = bbox_indices;
+            }
+        }
+
+        block[0] = static_cast<uint8>(q0 & 0xFF);
+        block[1] = static_cast<uint8>(q0 >> 8);
+        block[2] = static_cast<uint8>(q1 & 0xFF);
+        block[3] = static_cast<uint8>(q1 >> 8);
+
+        for (size_t i = 0; i < 4; ++i)
+            block[4 + i] = static_cast<uint8>(indices >> (8 * i));
+    }
+
+    void encode_bc4(const BlockPixels& pixels, const size_t channel, uint8* block)
+    {
+        int lo = 255;
+        int hi = 0;
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            lo = min<int>(lo, pixels[i][channel]);
+            hi = max<int>(hi, pixels[i][channel]);
+        }
+
+        // Pick for each pixel the closest of the eight evenly spaced values between the endpoints.
+        uint64 indices = 0;
+
+        if (hi > lo)
+        {
+            const int range = hi - lo;
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                const int index = ((pixels[i][channel] - lo) * 7 + range / 2) / range;
+                indices |= static_cast<uint64>(index) << (3 * i);
+            }
+        }
+
+        block[0] = static_cast<uint8>(lo);
+        block[1] = static_cast<uint8>(hi);
+
+        for (size_t i = 0; i < 6; ++i)
+            block[2 + i] = static_cast<uint8>(indices >> (8 * i));
+    }
+
+    size_t compute_block_size(const size_t channel_count)
+    {
+        // One BC1 block for RGB channels, one BC4 block for each other channel.
+        return channel_count >= 3 ? 8 * (channel_count - 2) : 8 * channel_count;
+    }
+}
+
+bool CompressedTile::is_compressible(
+    const Tile&             tile,
+    const ColorSpace        color_space)
+{
+    return
+        tile.get_pixel_format() == PixelFormatUInt8 &&
+        tile.get_channel_count() >= 1 &&
+        tile.get_channel_count() <= 4 &&
+        (color_space == ColorSpaceLinearRGB || color_space == ColorSpaceSRGB);
+}
+
+CompressedTile::CompressedTile(
+    const Tile&             tile,
+    const ColorSpace        color_space)
+  : m_width(tile.get_width())
+  , m_height(tile.get_height())
+  , m_channel_count(tile.get_channel_count())
+  , m_block_count_x((m_width + 3) / 4)
+  , m_block_size(compute_block_size(m_channel_count))
+  , m_color_table(
+        color_space == ColorSpaceSRGB
+            ? get_conversion_tables().m_srgb_to_linear_rgb
+            : get_conversion_tables().m_linear)
+  , m_alpha_table(get_conversion_tables().m_linear)
+{
+    assert(is_compressible(tile, color_space));
+
+    const size_t block_count_y = (m_height + 3) / 4;
+    m_blocks.resize(m_block_count_x * block_count_y * m_block_size);
+
+    uint8* block = &m_blocks[0];
+
+    for (size_t by = 0; by < block_count_y; ++by)
+    {
+        for (size_t bx = 0; bx < m_block_count_x; ++bx)
+        {
+            // Gather the pixels of the block, replicating edge pixels in partial blocks.
+            BlockPixels pixels;
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                const size_t x = min(bx * 4 + (i & 3), m_width - 1);
+                const size_t y = min(by * 4 + (i >> 2), m_height - 1);
+                tile.get_pixel(x, y, pixels[i], m_channel_count);
+            }
+
+            if (m_channel_count >= 3)
+            {
+                encode_bc1(pixels, block);
+
+                if (m_channel_count == 4)
+                    encode_bc4(pixels, 3, block + 8);
+            }
+            else
+            {
+                for (size_t c = 0; c < m_channel_count; ++c)
+                    encode_bc4(pixels, c, block + 8 * c);
+            }
+
+            block += m_block_size;
+        }
+    }
+}
+
+size_t CompressedTile::get_memory_size() const
+{
+    return sizeof(*this) + m_blocks.capacity();
+}
+
+Tile* CompressedTile::decompress() const
+{
+    Tile* tile = new Tile(m_width, m_height, m_channel_count, PixelFormatFloat);
+
+    for (size_t y = 0; y < m_height; ++y)
+    {
+        for (size_t x = 0; x < m_width; ++x)
+        {
+            Color4f color;
+            get_pixel(x, y, color);
+
+            switch (m_channel_count)
+            {
+              case 1:
+                tile->set_component(x, y, 0, color.r);
+                break;
+
+              case 2:
+                tile->set_component(x, y, 0, color.r);
+                tile->set_component(x, y, 1, color.a);
+                break;
+
+              case 3:
+                tile->set_pixel(x, y, color.rgb());
+                break;
+
+              default:
+                tile->set_pixel(x, y, color);
+                break;
+            }
+        }
+    }
+
+    return tile;
+}
+
+}   // namespace foundation
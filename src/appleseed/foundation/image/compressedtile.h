@@ -0,0 +1,228 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Tile; }
+
+namespace foundation
+{
+
+//
+// A block-compressed, read-only copy of an 8-bit tile.
+//
+// Pixels are compressed in blocks of 4x4 pixels. RGB channels are compressed together
+// using 8 bytes per block (two RGB 5:6:5 endpoints and 2-bit indices, as in BC1), while
+// each remaining channel (grey, or alpha) is compressed separately using 8 bytes per block
+// (two 8-bit endpoints and 3-bit indices, as in BC4). Compared to the original 8-bit
+// pixels, this is a 6:1 ratio for RGB tiles, 4:1 for RGBA tiles and 2:1 for grey tiles.
+//
+// Pixels are decoded one by one on access. When the source tile is in the sRGB color
+// space, the conversion to linear RGB is folded into the decoding.
+//
+
+class APPLESEED_DLLSYMBOL CompressedTile
+  : public NonCopyable
+{
+  public:
+    // Return true if a given tile can be compressed, i.e. if it is an 8-bit tile
+    // with 1 to 4 channels in the linear RGB or sRGB color space.
+    static bool is_compressible(
+        const Tile&         tile,
+        const ColorSpace    color_space);
+
+    // Constructor.
+    CompressedTile(
+        const Tile&         tile,
+        const ColorSpace    color_space);
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Tile properties.
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_channel_count() const;
+
+    // Decode a given pixel. Return a color in the linear RGB color space.
+    // Grey tiles are expanded to RGB and missing alpha channels are set to 1.
+    void get_pixel(
+        const size_t        x,
+        const size_t        y,
+        Color4f&            color) const;
+
+    // Decode the whole tile into a new floating-point tile in the linear RGB color space.
+    Tile* decompress() const;
+
+  private:
+    const size_t            m_width;
+    const size_t            m_height;
+    const size_t            m_channel_count;
+    const size_t            m_block_count_x;
+    const size_t            m_block_size;       // size in bytes of one block
+    const float*            m_color_table;      // 8-bit value to linear RGB conversion table
+    const float*            m_alpha_table;      // 8-bit value to alpha conversion table
+    std::vector<uint8>      m_blocks;
+
+    void decode_bc1(
+        const uint8*        block,
+        const size_t        i,
+        Color4f&            color) const;
+
+    static float decode_bc4(
+        const uint8*        block,
+        const size_t        i,
+        const float*        table);
+};
+
+
+//
+// CompressedTile class implementation.
+//
+
+namespace impl
+{
+    // Interpolate between two 8-bit endpoints of a BC1 block according to a 2-bit index.
+    inline int interpolate_bc1(
+        const int           e0,
+        const int           e1,
+        const size_t        index)
+    {
+        switch (index)
+        {
+          case 0: return e0;
+          case 1: return e1;
+          case 2: return (2 * e0 + e1 + 1) / 3;
+          default: return (e0 + 2 * e1 + 1) / 3;
+        }
+    }
+}
+
+inline size_t CompressedTile::get_width() const
+{
+    return m_width;
+}
+
+inline size_t CompressedTile::get_height() const
+{
+    return m_height;
+}
+
+inline size_t CompressedTile::get_channel_count() const
+{
+    return m_channel_count;
+}
+
+inline void CompressedTile::get_pixel(
+    const size_t            x,
+    const size_t            y,
+    Color4f&                color) const
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    const uint8* block = &m_blocks[((y >> 2) * m_block_count_x + (x >> 2)) * m_block_size];
+    const size_t i = (y & 3) * 4 + (x & 3);
+
+    switch (m_channel_count)
+    {
+      case 1:
+        color.r = color.g = color.b = decode_bc4(block, i, m_color_table);
+        color.a = 1.0f;
+        break;
+
+      case 2:
+        color.r = color.g = color.b = decode_bc4(block, i, m_color_table);
+        color.a = decode_bc4(block + 8, i, m_alpha_table);
+        break;
+
+      case 3:
+        decode_bc1(block, i, color);
+        color.a = 1.0f;
+        break;
+
+      default:
+        assert(m_channel_count == 4);
+        decode_bc1(block, i, color);
+        color.a = decode_bc4(block + 8, i, m_alpha_table);
+        break;
+    }
+}
+
+inline void CompressedTile::decode_bc1(
+    const uint8*            block,
+    const size_t            i,
+    Color4f&                color) const
+{
+    // Expand the 5:6:5 endpoints to 8 bits per channel.
+    const int q0 = block[0] | (block[1] << 8);
+    const int q1 = block[2] | (block[3] << 8);
+    const int r0 = (q0 >> 11) & 31, g0 = (q0 >> 5) & 63, b0 = q0 & 31;
+    const int r1 = (q1 >> 11) & 31, g1 = (q1 >> 5) & 63, b1 = q1 & 31;
+
+    const size_t index = (block[4 + (i >> 2)] >> (2 * (i & 3))) & 3;
+
+    color.r = m_color_table[impl::interpolate_bc1((r0 << 3) | (r0 >> 2), (r1 << 3) | (r1 >> 2), index)];
+    color.g = m_color_table[impl::interpolate_bc1((g0 << 2) | (g0 >> 4), (g1 << 2) | (g1 >> 4), index)];
+    color.b = m_color_table[impl::interpolate_bc1((b0 << 3) | (b0 >> 2), (b1 << 3) | (b1 >> 2), index)];
+}
+
+inline float CompressedTile::decode_bc4(
+    const uint8*            block,
+    const size_t            i,
+    const float*            table)
+{
+    const int lo = block[0];
+    const int hi = block[1];
+
+    // Extract the 3-bit index of the pixel from the 48-bit index field.
+    const size_t bit = 3 * i;
+    const size_t byte = 2 + (bit >> 3);
+    const int bits = block[byte] | (byte < 7 ? block[byte + 1] << 8 : 0);
+    const int index = (bits >> (bit & 7)) & 7;
+
+    return table[(lo * (7 - index) + hi * index + 3) / 7];
+}
+
+}   // namespace foundation
@@ -256,6 +256,22 @@ bool GenericProgressiveImageFileReader::choose_subimage(const size_t subimage) c
     return success;
 }
 
+bool GenericProgressiveImageFileReader::choose_mip_level(const size_t level)
+{
+    assert(is_open());
+
+    OIIO::ImageSpec spec;
+    const bool success = impl->m_input->seek_subimage(
+        impl->m_input->current_subimage(),
+        static_cast<int>(level),
+        spec);
+
+    if (success)
+        impl->read_spec(spec);
+
+    return success;
+}
+
 Tile* GenericProgressiveImageFileReader::read_tile(
     const size_t        tile_x,
     const size_t        tile_y)
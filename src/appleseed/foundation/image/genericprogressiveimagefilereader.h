@@ -82,6 +82,10 @@ class APPLESEED_DLLSYMBOL GenericProgressiveImageFileReader
     // Choose the layer in the image file if available.
     bool choose_subimage(const size_t subimage) const;
 
+    // Choose a MIP level of the current layer if available. Level 0 is the full resolution image.
+    // Canvas properties and tiles are then read from that level.
+    bool choose_mip_level(const size_t level);
+
     // Read an image tile. Returns a newly allocated tile.
     Tile* read_tile(
         const size_t        tile_x,
@@ -0,0 +1,351 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "tiledexrimagefilewriter.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/imageattributes.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/iostreamop.h"
+
+// OpenEXR headers.
+#include "foundation/platform/_beginexrheaders.h"
+#include "OpenEXR/ImathVec.h"
+#include "OpenEXR/ImfChannelList.h"
+#include "OpenEXR/ImfChromaticities.h"
+#include "OpenEXR/ImfCompression.h"
+#include "OpenEXR/ImfFloatAttribute.h"
+#include "OpenEXR/ImfFrameBuffer.h"
+#include "OpenEXR/ImfHeader.h"
+#include "OpenEXR/ImfMultiPartOutputFile.h"
+#include "OpenEXR/ImfPartType.h"
+#include "OpenEXR/ImfStandardAttributes.h"
+#include "OpenEXR/ImfStringAttribute.h"
+#include "OpenEXR/ImfTileDescription.h"
+#include "OpenEXR/ImfTiledOutputPart.h"
+#include "foundation/platform/_endexrheaders.h"
+
+// Standard headers.
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace foundation
+{
+
+namespace
+{
+    Imf::PixelType convert_pixel_format(const PixelFormat format)
+    {
+        switch (format)
+        {
+          case PixelFormatUInt32: return Imf::UINT;
+          case PixelFormatHalf: return Imf::HALF;
+          case PixelFormatFloat: return Imf::FLOAT;
+          default: throw ExceptionIOError("pixel format is not supported by openexr");
+        }
+    }
+
+    Imf::Compression convert_compression(const std::string& compression)
+    {
+        if (compression == "none") return Imf::NO_COMPRESSION;
+        if (compression == "rle") return Imf::RLE_COMPRESSION;
+        if (compression == "zips") return Imf::ZIPS_COMPRESSION;
+        if (compression == "zip") return Imf::ZIP_COMPRESSION;
+        if (compression == "piz") return Imf::PIZ_COMPRESSION;
+        if (compression == "pxr24") return Imf::PXR24_COMPRESSION;
+        if (compression == "b44") return Imf::B44_COMPRESSION;
+        if (compression == "b44a") return Imf::B44A_COMPRESSION;
+        if (compression == "dwaa") return Imf::DWAA_COMPRESSION;
+        if (compression == "dwab") return Imf::DWAB_COMPRESSION;
+        throw ExceptionIOError("unknown openexr compression method", compression.c_str());
+    }
+
+    void set_image_attributes(
+        const ImageAttributes&  image_attributes,
+        Imf::Header&            header)
+    {
+        if (image_attributes.exist("white_xy_chromaticity") &&
+            image_attributes.exist("red_xy_chromaticity") &&
+            image_attributes.exist("green_xy_chromaticity") &&
+            image_attributes.exist("blue_xy_chromaticity"))
+        {
+            const Vector2f red = image_attributes.get<Vector2f>("red_xy_chromaticity");
+            const Vector2f green = image_attributes.get<Vector2f>("green_xy_chromaticity");
+            const Vector2f blue = image_attributes.get<Vector2f>("blue_xy_chromaticity");
+            const Vector2f white = image_attributes.get<Vector2f>("white_xy_chromaticity");
+
+            Imf::addChromaticities(
+                header,
+                Imf::Chromaticities(
+                    Imath::V2f(red[0], red[1]),
+                    Imath::V2f(green[0], green[1]),
+                    Imath::V2f(blue[0], blue[1]),
+                    Imath::V2f(white[0], white[1])));
+        }
+
+        for (auto& i : image_attributes)
+        {
+            // Fetch the name and the value of the attribute.
+            const std::string attr_name = i.key();
+            const std::string attr_value = i.value<std::string>();
+
+            if (attr_name == "author")
+                Imf::addOwner(header, attr_value);
+            else if (attr_name == "description")
+                Imf::addComments(header, attr_value);
+            else if (attr_name == "date")
+                Imf::addCapDate(header, attr_value);
+            else if (attr_name == "compression")
+                header.compression() = convert_compression(attr_value);
+            else if (attr_name == "dwa_compression_lvl")
+                header.insert("dwaCompressionLevel", Imf::FloatAttribute(i.value<float>()));
+            else if (attr_name == "image_name" ||
+                     attr_name == "color_space" ||
+                     attr_name == "dpi" ||
+                     attr_name == "dither" ||
+                     attr_name == "white_xy_chromaticity" ||
+                     attr_name == "red_xy_chromaticity" ||
+                     attr_name == "green_xy_chromaticity" ||
+                     attr_name == "blue_xy_chromaticity")
+            {
+                // These attributes are either handled elsewhere or meaningless for tiled OpenEXR files.
+            }
+            else
+            {
+                // Write all other attributes as string attributes.
+                header.insert(attr_name, Imf::StringAttribute(attr_value));
+            }
+        }
+    }
+}
+
+struct TiledEXRImageFileWriter::Impl
+{
+    struct Part
+    {
+        Imf::Header                 m_header;
+        size_t                      m_tile_width;
+        size_t                      m_tile_height;
+        size_t                      m_tile_count_x;
+        size_t                      m_tile_count_y;
+        size_t                      m_channel_count;
+        PixelFormat                 m_pixel_format;
+        std::vector<std::string>    m_channel_names;
+    };
+
+    const std::string                                   m_filename;
+    std::vector<Part>                                   m_parts;
+    std::unique_ptr<Imf::MultiPartOutputFile>           m_file;
+    std::vector<std::unique_ptr<Imf::TiledOutputPart>>  m_output_parts;
+    boost::mutex                                        m_mutex;
+
+    explicit Impl(const char* filename)
+      : m_filename(filename)
+    {
+    }
+};
+
+TiledEXRImageFileWriter::TiledEXRImageFileWriter(const char* filename)
+  : impl(new Impl(filename))
+{
+}
+
+TiledEXRImageFileWriter::~TiledEXRImageFileWriter()
+{
+    close();
+    delete impl;
+}
+
+size_t TiledEXRImageFileWriter::append_part(
+    const char*                 name,
+    const CanvasProperties&     props,
+    const char**                channel_names,
+    const PixelFormat           output_pixel_format,
+    const ImageAttributes&      image_attributes)
+{
+    assert(name);
+    assert(!is_open());
+    assert(channel_names != nullptr || props.m_channel_count <= 4);
+
+    Impl::Part part;
+    part.m_tile_width = props.m_tile_width;
+    part.m_tile_height = props.m_tile_height;
+    part.m_tile_count_x = props.m_tile_count_x;
+    part.m_tile_count_y = props.m_tile_count_y;
+    part.m_channel_count = props.m_channel_count;
+    part.m_pixel_format = props.m_pixel_format;
+
+    // Channel names.
+    const char* DefaultChannelNames[] = { "R", "G", "B", "A" };
+    for (size_t i = 0; i < props.m_channel_count; ++i)
+        part.m_channel_names.push_back(channel_names ? channel_names[i] : DefaultChannelNames[i]);
+
+    try
+    {
+        // Tiles are stored in the order in which they are written.
+        Imf::Header& header = part.m_header;
+        header = Imf::Header(
+            static_cast<int>(props.m_canvas_width),
+            static_cast<int>(props.m_canvas_height));
+        header.setName(name);
+        header.setType(Imf::TILEDIMAGE);
+        header.setTileDescription(
+            Imf::TileDescription(
+                static_cast<unsigned int>(props.m_tile_width),
+                static_cast<unsigned int>(props.m_tile_height),
+                Imf::ONE_LEVEL));
+        header.lineOrder() = Imf::RANDOM_Y;
+
+        const Imf::PixelType output_type = convert_pixel_format(output_pixel_format);
+        for (const std::string& channel_name : part.m_channel_names)
+            header.channels().insert(channel_name, Imf::Channel(output_type));
+
+        set_image_attributes(image_attributes, header);
+    }
+    catch (const std::exception& e)
+    {
+        throw ExceptionIOError(e.what());
+    }
+
+    impl->m_parts.push_back(part);
+
+    return impl->m_parts.size() - 1;
+}
+
+size_t TiledEXRImageFileWriter::get_part_count() const
+{
+    return impl->m_parts.size();
+}
+
+void TiledEXRImageFileWriter::open()
+{
+    assert(!is_open());
+    assert(!impl->m_parts.empty());
+
+    std::vector<Imf::Header> headers;
+    headers.reserve(impl->m_parts.size());
+    for (const Impl::Part& part : impl->m_parts)
+        headers.push_back(part.m_header);
+
+    try
+    {
+        impl->m_file.reset(
+            new Imf::MultiPartOutputFile(
+                impl->m_filename.c_str(),
+                &headers[0],
+                static_cast<int>(headers.size())));
+
+        for (size_t i = 0, e = impl->m_parts.size(); i < e; ++i)
+        {
+            impl->m_output_parts.emplace_back(
+                new Imf::TiledOutputPart(*impl->m_file, static_cast<int>(i)));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        impl->m_output_parts.clear();
+        impl->m_file.reset();
+        throw ExceptionIOError(e.what());
+    }
+}
+
+bool TiledEXRImageFileWriter::is_open() const
+{
+    return impl->m_file.get() != nullptr;
+}
+
+void TiledEXRImageFileWriter::write_tile(
+    const size_t                part_index,
+    const size_t                tile_x,
+    const size_t                tile_y,
+    const Tile&                 tile)
+{
+    assert(is_open());
+    assert(part_index < impl->m_parts.size());
+
+    const Impl::Part& part = impl->m_parts[part_index];
+    assert(tile_x < part.m_tile_count_x);
+    assert(tile_y < part.m_tile_count_y);
+    assert(tile.get_channel_count() == part.m_channel_count);
+    assert(tile.get_pixel_format() == part.m_pixel_format);
+
+    // Describe the pixels of the tile, using coordinates relative to the tile's origin.
+    const Imf::PixelType type = convert_pixel_format(part.m_pixel_format);
+    const size_t channel_size = Pixel::size(part.m_pixel_format);
+    const size_t xstride = channel_size * part.m_channel_count;
+    const size_t ystride = xstride * tile.get_width();
+    char* base = reinterpret_cast<char*>(tile.get_storage());
+
+    Imf::FrameBuffer frame_buffer;
+    for (size_t i = 0; i < part.m_channel_count; ++i)
+    {
+        frame_buffer.insert(
+            part.m_channel_names[i],
+            Imf::Slice(
+                type,
+                base + i * channel_size,
+                xstride,
+                ystride,
+                1, 1,           // no subsampling
+                0.0,            // fill value
+                true, true));   // tile coordinates
+    }
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    try
+    {
+        Imf::TiledOutputPart& output_part = *impl->m_output_parts[part_index];
+        output_part.setFrameBuffer(frame_buffer);
+        output_part.writeTile(static_cast<int>(tile_x), static_cast<int>(tile_y));
+    }
+    catch (const std::exception& e)
+    {
+        throw ExceptionIOError(e.what());
+    }
+}
+
+void TiledEXRImageFileWriter::close()
+{
+    if (!is_open())
+        return;
+
+    // The offsets of the tiles are written when the file is destroyed.
+    impl->m_output_parts.clear();
+    impl->m_file.reset();
+}
+
+}   // namespace foundation
@@ -0,0 +1,104 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/pixel.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation { class CanvasProperties; }
+namespace foundation { class ImageAttributes; }
+namespace foundation { class Tile; }
+
+namespace foundation
+{
+
+//
+// Writes a tiled, multipart OpenEXR file one tile at a time.
+//
+// Unlike GenericImageFileWriter, which writes whole images, this writer lets tiles of any
+// part be written in any order as soon as they are available. Tiles that were not written
+// yet when the file is closed are missing from it, but the rest of the file remains valid.
+//
+// Methods throw foundation::ExceptionIOError on failure.
+//
+
+class APPLESEED_DLLSYMBOL TiledEXRImageFileWriter
+  : public NonCopyable
+{
+  public:
+    // Constructor. The file is only created by open().
+    explicit TiledEXRImageFileWriter(const char* filename);
+
+    // Destructor. Closes the file if it is still open.
+    ~TiledEXRImageFileWriter();
+
+    // Add a part to the file and return its index. All parts must have the same canvas
+    // and tile dimensions. If channel_names is nullptr, channels are named R, G, B and A.
+    size_t append_part(
+        const char*                 name,
+        const CanvasProperties&     props,
+        const char**                channel_names,
+        const PixelFormat           output_pixel_format,
+        const ImageAttributes&      image_attributes);
+
+    // Return the number of parts in the file.
+    size_t get_part_count() const;
+
+    // Create the file and write its header.
+    void open();
+
+    // Return true if the file is open.
+    bool is_open() const;
+
+    // Write a given tile of a given part. Each tile can only be written once.
+    // The tile must have the pixel format and channel count of the canvas of the part.
+    // Thread-safe.
+    void write_tile(
+        const size_t                part_index,
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const Tile&                 tile);
+
+    // Close the file.
+    void close();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace foundation
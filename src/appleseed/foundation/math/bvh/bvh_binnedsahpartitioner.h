@@ -0,0 +1,317 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace foundation {
+namespace bvh {
+
+//
+// A BVH partitioner based on the Surface Area Heuristic (SAH) evaluated on a fixed
+// number of bins along each dimension instead of at every item boundary.
+//
+// Items are binned according to the center of their bounding boxes. Contrary to
+// SAHPartitioner, no pre-sorted index arrays are maintained: the partitioner only
+// reorders items in [begin, end) when partitioning them, so that partition() may be
+// called concurrently on disjoint sets of items.
+//
+// Reference:
+//
+//   On fast Construction of SAH-based Bounding Volume Hierarchies
+//   http://www.sci.utah.edu/~wald/Publications/2007/ParallelBVHBuild/fastbuild.pdf
+//
+
+template <typename AABBVector>
+class BinnedSAHPartitioner
+  : public NonCopyable
+{
+  public:
+    typedef AABBVector AABBVectorType;
+    typedef typename AABBVectorType::value_type AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef typename AABBType::VectorType VectorType;
+
+    // Maximum number of bins per dimension.
+    static const size_t MaxBinCount = 256;
+
+    // Constructor.
+    BinnedSAHPartitioner(
+        const AABBVectorType&   bboxes,
+        const size_t            max_leaf_size = 1,
+        const size_t            bin_count = 32,
+        const ValueType         interior_node_traversal_cost = ValueType(1.0),
+        const ValueType         item_intersection_cost = ValueType(1.0));
+
+    // Compute the bounding box of a given set of items.
+    AABBType compute_bbox(
+        const size_t            begin,
+        const size_t            end) const;
+
+    // Partition a set of items into two distinct sets.
+    // Thread-safe as long as concurrent calls operate on disjoint sets of items.
+    size_t partition(
+        const size_t            begin,
+        const size_t            end,
+        const AABBType&         bbox);
+
+    // Return the items ordering.
+    const std::vector<size_t>& get_item_ordering() const;
+
+  private:
+    static const size_t Dimension = AABBType::Dimension;
+
+    struct Bin
+    {
+        AABBType    m_bbox;
+        size_t      m_count;
+    };
+
+    const AABBVectorType&       m_bboxes;
+    const size_t                m_max_leaf_size;
+    const size_t                m_bin_count;
+    const ValueType             m_interior_node_traversal_cost;
+    const ValueType             m_item_intersection_cost;
+    std::vector<size_t>         m_indices;
+    std::vector<VectorType>     m_centers;
+
+    static size_t compute_bin_index(
+        const ValueType         center,
+        const ValueType         center_min,
+        const ValueType         scale,
+        const size_t            bin_count);
+};
+
+
+//
+// BinnedSAHPartitioner class implementation.
+//
+
+template <typename AABBVector>
+BinnedSAHPartitioner<AABBVector>::BinnedSAHPartitioner(
+    const AABBVectorType&       bboxes,
+    const size_t                max_leaf_size,
+    const size_t                bin_count,
+    const ValueType             interior_node_traversal_cost,
+    const ValueType             item_intersection_cost)
+  : m_bboxes(bboxes)
+  , m_max_leaf_size(max_leaf_size)
+  , m_bin_count(std::min(std::max<size_t>(bin_count, 2), MaxBinCount))
+  , m_interior_node_traversal_cost(interior_node_traversal_cost)
+  , m_item_intersection_cost(item_intersection_cost)
+{
+    const size_t size = m_bboxes.size();
+
+    // Identity ordering.
+    m_indices.resize(size);
+    for (size_t i = 0; i < size; ++i)
+        m_indices[i] = i;
+
+    // Precompute the centers of the bounding boxes.
+    m_centers.resize(size);
+    for (size_t i = 0; i < size; ++i)
+        m_centers[i] = m_bboxes[i].center();
+}
+
+template <typename AABBVector>
+typename AABBVector::value_type BinnedSAHPartitioner<AABBVector>::compute_bbox(
+    const size_t                begin,
+    const size_t                end) const
+{
+    AABBType bbox;
+    bbox.invalidate();
+
+    for (size_t i = begin; i < end; ++i)
+        bbox.insert(m_bboxes[m_indices[i]]);
+
+    return bbox;
+}
+
+template <typename AABBVector>
+size_t BinnedSAHPartitioner<AABBVector>::partition(
+    const size_t                begin,
+    const size_t                end,
+    const AABBType&             bbox)
+{
+    // Don't split leaves containing only degenerate triangles.
+    if (bbox.rank() < Dimension - 1)
+        return end;
+
+    const size_t count = end - begin;
+    assert(count > 1);
+
+    // Don't split leaves containing less than a predefined number of items.
+    if (count <= m_max_leaf_size)
+        return end;
+
+    // Compute the bounding box of the centers of the items.
+    AABBType center_bbox;
+    center_bbox.invalidate();
+    for (size_t i = begin; i < end; ++i)
+        center_bbox.insert(m_centers[m_indices[i]]);
+
+    // Small sets of items don't need as many bins.
+    const size_t bin_count = std::min(m_bin_count, std::max<size_t>(count, 2));
+
+    ValueType best_split_cost = std::numeric_limits<ValueType>::max();
+    size_t best_split_dim = 0;
+    size_t best_split_bin = 0;
+
+    Bin bins[MaxBinCount];
+    ValueType left_costs[MaxBinCount];
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        const ValueType center_min = center_bbox.min[d];
+        const ValueType center_extent = center_bbox.max[d] - center_min;
+
+        // All centers coincide along this dimension.
+        if (center_extent <= ValueType(0.0))
+            continue;
+
+        const ValueType scale = bin_count / center_extent;
+
+        // Bin the items.
+        for (size_t b = 0; b < bin_count; ++b)
+        {
+            bins[b].m_bbox.invalidate();
+            bins[b].m_count = 0;
+        }
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const size_t index = m_indices[i];
+            Bin& bin = bins[compute_bin_index(m_centers[index][d], center_min, scale, bin_count)];
+            bin.m_bbox.insert(m_bboxes[index]);
+            ++bin.m_count;
+        }
+
+        AABBType bbox_accumulator;
+        size_t count_accumulator;
+
+        // Left-to-right sweep to accumulate bounding boxes and compute the cost of left partitions.
+        bbox_accumulator.invalidate();
+        count_accumulator = 0;
+        for (size_t b = 0; b < bin_count - 1; ++b)
+        {
+            bbox_accumulator.insert(bins[b].m_bbox);
+            count_accumulator += bins[b].m_count;
+            left_costs[b] =
+                count_accumulator > 0
+                    ? half_surface_area(bbox_accumulator) * count_accumulator
+                    : ValueType(0.0);
+        }
+
+        // Right-to-left sweep to accumulate bounding boxes and find the best partition.
+        // A split after bin b puts bins [0, b] on the left and bins [b + 1, bin_count) on the right.
+        bbox_accumulator.invalidate();
+        count_accumulator = 0;
+        for (size_t b = bin_count - 1; b > 0; --b)
+        {
+            bbox_accumulator.insert(bins[b].m_bbox);
+            count_accumulator += bins[b].m_count;
+
+            // Skip partitions leaving one side empty.
+            if (count_accumulator == 0 || count_accumulator == count)
+                continue;
+
+            // Compute the cost of this partition.
+            const ValueType right_cost = half_surface_area(bbox_accumulator) * count_accumulator;
+            const ValueType split_cost = left_costs[b - 1] + right_cost;
+
+            // Keep track of the partition with the lowest cost.
+            if (best_split_cost > split_cost)
+            {
+                best_split_cost = split_cost;
+                best_split_dim = d;
+                best_split_bin = b - 1;
+            }
+        }
+    }
+
+    // No valid partition was found.
+    if (best_split_cost == std::numeric_limits<ValueType>::max())
+        return end;
+
+    // Don't split if it's cheaper to make a leaf.
+    const ValueType split_cost =
+        m_interior_node_traversal_cost +
+        best_split_cost / half_surface_area(bbox) * m_item_intersection_cost;
+    const ValueType leaf_cost = count * m_item_intersection_cost;
+    if (leaf_cost <= split_cost)
+        return end;
+
+    // Partition the items.
+    const ValueType center_min = center_bbox.min[best_split_dim];
+    const ValueType scale = bin_count / (center_bbox.max[best_split_dim] - center_min);
+    size_t pivot = begin;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const size_t index = m_indices[i];
+        const size_t b = compute_bin_index(m_centers[index][best_split_dim], center_min, scale, bin_count);
+
+        if (b <= best_split_bin)
+            std::swap(m_indices[i], m_indices[pivot++]);
+    }
+
+    assert(pivot > begin);
+    assert(pivot < end);
+
+    return pivot;
+}
+
+template <typename AABBVector>
+inline const std::vector<size_t>& BinnedSAHPartitioner<AABBVector>::get_item_ordering() const
+{
+    return m_indices;
+}
+
+template <typename AABBVector>
+inline size_t BinnedSAHPartitioner<AABBVector>::compute_bin_index(
+    const ValueType             center,
+    const ValueType             center_min,
+    const ValueType             scale,
+    const size_t                bin_count)
+{
+    const size_t b = static_cast<size_t>((center - center_min) * scale);
+    return std::min(b, bin_count - 1);
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,551 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_tree.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Intersector for packets of rays.
+//
+// All the rays of a packet share a single traversal of the BVH: a node is visited
+// as long as at least one ray of the packet hits it, and the bounding boxes of each
+// node are tested against all the rays of the packet at once (with SSE2 or AVX
+// instructions when intersecting double-precision 3D bounding boxes). This pays off
+// when the rays of a packet are coherent, such as camera rays of a single pixel or
+// shadow rays leaving the same point.
+//
+// The Visitor class must conform to the following prototype:
+//
+//      class Visitor
+//        : public foundation::NonCopyable
+//      {
+//        public:
+//          // Visit a leaf with the rays whose bit is set in 'ray_mask'.
+//          // For each of these rays, 'distances[i]' should be set to the distance to
+//          // the closest hit so far. Return the mask of the rays for which traversal
+//          // should continue.
+//          uint32 visit(
+//              const NodeType&             node,
+//              const uint32                ray_mask,
+//              const RayType*              rays,
+//              const RayInfoType*          ray_infos,
+//              ValueType*                  distances
+//      #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+//              , TraversalStatistics&      stats
+//      #endif
+//              );
+//      };
+//
+// PacketSize is the maximum number of rays in a packet; it must be a multiple of 4
+// and at most 32.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize = 8,
+    size_t StackSize = 64
+>
+class PacketIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, AABBType::Dimension> RayInfoType;
+
+    static_assert(PacketSize % 4 == 0 && PacketSize <= 32, "Invalid ray packet size");
+
+    // Intersect a packet of up to PacketSize rays with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType*          rays,
+        const RayInfoType*      ray_infos,
+        const size_t            ray_count,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+};
+
+
+//
+// Ray packet-vs-box intersection.
+//
+
+namespace packetintersector_impl
+{
+    template <typename T, size_t PacketSize, size_t N>
+    class RayPacketBoxIntersector
+    {
+      public:
+        template <typename RayType, typename RayInfoType>
+        RayPacketBoxIntersector(
+            const RayType*      rays,
+            const RayInfoType*  ray_infos,
+            const size_t        ray_count)
+        {
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                if (i < ray_count)
+                {
+                    for (size_t d = 0; d < N; ++d)
+                    {
+                        m_org[d][i] = static_cast<T>(rays[i].m_org[d]);
+                        m_rcp_dir[d][i] = static_cast<T>(ray_infos[i].m_rcp_dir[d]);
+                    }
+
+                    m_tmin[i] = static_cast<T>(rays[i].m_tmin);
+                    m_tmax[i] = static_cast<T>(rays[i].m_tmax);
+                }
+                else
+                {
+                    // Unused slots of the packet never hit anything.
+                    for (size_t d = 0; d < N; ++d)
+                    {
+                        m_org[d][i] = T(0.0);
+                        m_rcp_dir[d][i] = T(0.0);
+                    }
+
+                    m_tmin[i] = T(1.0);
+                    m_tmax[i] = T(0.0);
+                }
+            }
+        }
+
+        // Shrink the valid interval of a given ray.
+        void set_tmax(const size_t i, const T tmax)
+        {
+            if (m_tmax[i] > tmax)
+                m_tmax[i] = tmax;
+        }
+
+        // Return a bit mask of the rays of 'ray_mask' that hit a given bounding box
+        // and store their entry distances into tmin.
+        uint32 intersect(
+            const AABB<T, N>&   bbox,
+            const uint32        ray_mask,
+            T                   tmin[PacketSize]) const
+        {
+            uint32 hits = 0;
+
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                if (!(ray_mask & (1u << i)))
+                    continue;
+
+                T t0 = m_tmin[i];
+                T t1 = m_tmax[i];
+
+                for (size_t d = 0; d < N; ++d)
+                {
+                    const T tl1 = m_rcp_dir[d][i] * (bbox.min[d] - m_org[d][i]);
+                    const T tl2 = m_rcp_dir[d][i] * (bbox.max[d] - m_org[d][i]);
+                    t0 = ssemax(ssemin(tl1, tl2), t0);
+                    t1 = ssemin(ssemax(tl1, tl2), t1);
+                }
+
+                if (t0 <= t1)
+                    hits |= 1u << i;
+
+                tmin[i] = t0;
+            }
+
+            return hits;
+        }
+
+      private:
+        T       m_org[N][PacketSize];
+        T       m_rcp_dir[N][PacketSize];
+        T       m_tmin[PacketSize];
+        T       m_tmax[PacketSize];
+    };
+
+#ifdef APPLESEED_USE_SSE
+
+    template <size_t PacketSize>
+    class RayPacketBoxIntersector<double, PacketSize, 3>
+    {
+      public:
+        template <typename RayType, typename RayInfoType>
+        RayPacketBoxIntersector(
+            const RayType*      rays,
+            const RayInfoType*  ray_infos,
+            const size_t        ray_count)
+        {
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                if (i < ray_count)
+                {
+                    for (size_t d = 0; d < 3; ++d)
+                    {
+                        m_org[d][i] = rays[i].m_org[d];
+                        m_rcp_dir[d][i] = ray_infos[i].m_rcp_dir[d];
+                    }
+
+                    m_tmin[i] = rays[i].m_tmin;
+                    m_tmax[i] = rays[i].m_tmax;
+                }
+                else
+                {
+                    // Unused slots of the packet never hit anything.
+                    for (size_t d = 0; d < 3; ++d)
+                    {
+                        m_org[d][i] = 0.0;
+                        m_rcp_dir[d][i] = 0.0;
+                    }
+
+                    m_tmin[i] = 1.0;
+                    m_tmax[i] = 0.0;
+                }
+            }
+        }
+
+        // Shrink the valid interval of a given ray.
+        void set_tmax(const size_t i, const double tmax)
+        {
+            if (m_tmax[i] > tmax)
+                m_tmax[i] = tmax;
+        }
+
+        // Return a bit mask of the rays of 'ray_mask' that hit a given bounding box
+        // and store their entry distances into tmin. tmin must be aligned on a 32-byte boundary.
+        //
+        // When a ray lies in the plane of a slab and is parallel to it, the slab test
+        // produces NaNs; the operand order of the min/max operations ensures that the
+        // slab is then ignored instead of poisoning the result.
+        uint32 intersect(
+            const AABB3d&       bbox,
+            const uint32        ray_mask,
+            double              tmin[PacketSize]) const
+        {
+            uint32 hits = 0;
+
+#ifdef APPLESEED_USE_AVX
+
+            const __m256d bbox_min_x = _mm256_set1_pd(bbox.min.x);
+            const __m256d bbox_min_y = _mm256_set1_pd(bbox.min.y);
+            const __m256d bbox_min_z = _mm256_set1_pd(bbox.min.z);
+            const __m256d bbox_max_x = _mm256_set1_pd(bbox.max.x);
+            const __m256d bbox_max_y = _mm256_set1_pd(bbox.max.y);
+            const __m256d bbox_max_z = _mm256_set1_pd(bbox.max.z);
+
+            for (size_t i = 0; i < PacketSize; i += 4)
+            {
+                if (!((ray_mask >> i) & 15))
+                    continue;
+
+                const __m256d org_x = _mm256_load_pd(m_org[0] + i);
+                const __m256d org_y = _mm256_load_pd(m_org[1] + i);
+                const __m256d org_z = _mm256_load_pd(m_org[2] + i);
+                const __m256d rcp_dir_x = _mm256_load_pd(m_rcp_dir[0] + i);
+                const __m256d rcp_dir_y = _mm256_load_pd(m_rcp_dir[1] + i);
+                const __m256d rcp_dir_z = _mm256_load_pd(m_rcp_dir[2] + i);
+
+                const __m256d xl1 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(bbox_min_x, org_x));
+                const __m256d xl2 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(bbox_max_x, org_x));
+                const __m256d yl1 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(bbox_min_y, org_y));
+                const __m256d yl2 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(bbox_max_y, org_y));
+                const __m256d zl1 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(bbox_min_z, org_z));
+                const __m256d zl2 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(bbox_max_z, org_z));
+
+                __m256d t0 = _mm256_load_pd(m_tmin + i);
+                __m256d t1 = _mm256_load_pd(m_tmax + i);
+                t0 = _mm256_max_pd(_mm256_min_pd(xl1, xl2), t0);
+                t1 = _mm256_min_pd(_mm256_max_pd(xl1, xl2), t1);
+                t0 = _mm256_max_pd(_mm256_min_pd(yl1, yl2), t0);
+                t1 = _mm256_min_pd(_mm256_max_pd(yl1, yl2), t1);
+                t0 = _mm256_max_pd(_mm256_min_pd(zl1, zl2), t0);
+                t1 = _mm256_min_pd(_mm256_max_pd(zl1, zl2), t1);
+
+                hits |= static_cast<uint32>(_mm256_movemask_pd(_mm256_cmp_pd(t0, t1, _CMP_LE_OQ))) << i;
+
+                _mm256_store_pd(tmin + i, t0);
+            }
+
+#else
+
+            const __m128d bbox_min_x = _mm_set1_pd(bbox.min.x);
+            const __m128d bbox_min_y = _mm_set1_pd(bbox.min.y);
+            const __m128d bbox_min_z = _mm_set1_pd(bbox.min.z);
+            const __m128d bbox_max_x = _mm_set1_pd(bbox.max.x);
+            const __m128d bbox_max_y = _mm_set1_pd(bbox.max.y);
+            const __m128d bbox_max_z = _mm_set1_pd(bbox.max.z);
+
+            for (size_t i = 0; i < PacketSize; i += 2)
+            {
+                if (!((ray_mask >> i) & 3))
+                    continue;
+
+                const __m128d org_x = _mm_load_pd(m_org[0] + i);
+                const __m128d org_y = _mm_load_pd(m_org[1] + i);
+                const __m128d org_z = _mm_load_pd(m_org[2] + i);
+                const __m128d rcp_dir_x = _mm_load_pd(m_rcp_dir[0] + i);
+                const __m128d rcp_dir_y = _mm_load_pd(m_rcp_dir[1] + i);
+                const __m128d rcp_dir_z = _mm_load_pd(m_rcp_dir[2] + i);
+
+                const __m128d xl1 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(bbox_min_x, org_x));
+                const __m128d xl2 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(bbox_max_x, org_x));
+                const __m128d yl1 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(bbox_min_y, org_y));
+                const __m128d yl2 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(bbox_max_y, org_y));
+                const __m128d zl1 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(bbox_min_z, org_z));
+                const __m128d zl2 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(bbox_max_z, org_z));
+
+                __m128d t0 = _mm_load_pd(m_tmin + i);
+                __m128d t1 = _mm_load_pd(m_tmax + i);
+                t0 = _mm_max_pd(_mm_min_pd(xl1, xl2), t0);
+                t1 = _mm_min_pd(_mm_max_pd(xl1, xl2), t1);
+                t0 = _mm_max_pd(_mm_min_pd(yl1, yl2), t0);
+                t1 = _mm_min_pd(_mm_max_pd(yl1, yl2), t1);
+                t0 = _mm_max_pd(_mm_min_pd(zl1, zl2), t0);
+                t1 = _mm_min_pd(_mm_max_pd(zl1, zl2), t1);
+
+                hits |= static_cast<uint32>(_mm_movemask_pd(_mm_cmple_pd(t0, t1))) << i;
+
+                _mm_store_pd(tmin + i, t0);
+            }
+
+#endif
+
+            return hits & ray_mask;
+        }
+
+      private:
+        APPLESEED_SIMD8_ALIGN double m_org[3][PacketSize];
+        APPLESEED_SIMD8_ALIGN double m_rcp_dir[3][PacketSize];
+        APPLESEED_SIMD8_ALIGN double m_tmin[PacketSize];
+        APPLESEED_SIMD8_ALIGN double m_tmax[PacketSize];
+    };
+
+#endif  // APPLESEED_USE_SSE
+
+    // Return the index of the lowest bit set in a non-zero mask.
+    inline size_t lowest_set_bit(uint32 mask)
+    {
+        assert(mask != 0);
+
+        size_t index = 0;
+
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++index;
+        }
+
+        return index;
+    }
+}
+
+
+//
+// PacketIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize
+>
+void PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType*              rays,
+    const RayInfoType*          ray_infos,
+    const size_t                ray_count,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_nodes.empty());
+
+    assert(ray_count <= PacketSize);
+
+    if (ray_count == 0)
+        return;
+
+    packetintersector_impl::RayPacketBoxIntersector<ValueType, PacketSize, AABBType::Dimension>
+        packet_box_intersector(rays, ray_infos, ray_count);
+
+    // Rays for which traversal continues.
+    uint32 active_rays =
+        ray_count == 32 ? ~uint32(0) : (uint32(1) << ray_count) - 1;
+
+    // Node stack. Each entry stores the rays that hit the node when it was pushed.
+    struct StackEntry
+    {
+        const NodeType*     m_node;
+        uint32              m_ray_mask;
+    };
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node and rays that hit it.
+    const NodeType* node_ptr = &tree.m_nodes[0];
+    uint32 node_rays = active_rays;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (node_ptr->is_interior())
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += 2);
+
+            APPLESEED_SIMD8_ALIGN ValueType tmin_left[PacketSize];
+            APPLESEED_SIMD8_ALIGN ValueType tmin_right[PacketSize];
+
+            // Intersect the left and right bounding boxes with all the rays that hit this node.
+            const uint32 hit_left =
+                packet_box_intersector.intersect(node_ptr->get_left_bbox(), node_rays, tmin_left);
+            const uint32 hit_right =
+                packet_box_intersector.intersect(node_ptr->get_right_bbox(), node_rays, tmin_right);
+
+            const NodeType* child_ptr = &tree.m_nodes[node_ptr->get_child_node_index()];
+
+            if (hit_left && hit_right)
+            {
+                // Let the first ray that hit both children decide which one is the near child.
+                const uint32 hit_both = hit_left & hit_right;
+                const size_t leader =
+                    packetintersector_impl::lowest_set_bit(hit_both ? hit_both : hit_left);
+                const bool left_is_near = !hit_both || tmin_left[leader] <= tmin_right[leader];
+
+                // Push the far child node to the stack, continue with the near child node.
+                assert(stack_ptr < stack + StackSize);
+                stack_ptr->m_node = left_is_near ? child_ptr + 1 : child_ptr;
+                stack_ptr->m_ray_mask = left_is_near ? hit_right : hit_left;
+                ++stack_ptr;
+                node_ptr = left_is_near ? child_ptr : child_ptr + 1;
+                node_rays = left_is_near ? hit_left : hit_right;
+                continue;
+            }
+
+            if (hit_left | hit_right)
+            {
+                // Continue with the left or right child node.
+                FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+                node_ptr = hit_left ? child_ptr : child_ptr + 1;
+                node_rays = hit_left | hit_right;
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += 2);
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distances[PacketSize];
+            const uint32 proceed =
+                visitor.visit(
+                    *node_ptr,
+                    node_rays,
+                    rays,
+                    ray_infos,
+                    distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+
+            // Retire the rays for which the visitor decided to terminate traversal.
+            active_rays &= ~(node_rays & ~proceed);
+
+            // Terminate traversal if there are no more active rays.
+            if (active_rays == 0)
+                break;
+
+            // Keep track of the distance to the closest intersection of the remaining rays.
+            for (uint32 mask = node_rays & proceed; mask; mask &= mask - 1)
+            {
+                const size_t i = packetintersector_impl::lowest_set_bit(mask);
+                assert(distances[i] >= ValueType(0.0));
+                packet_box_intersector.set_tmax(i, distances[i]);
+            }
+        }
+
+        // Pop the top node with active rays from the stack.
+        node_rays = 0;
+        while (node_rays == 0 && stack_ptr > stack)
+        {
+            --stack_ptr;
+            node_ptr = stack_ptr->m_node;
+            node_rays = stack_ptr->m_ray_mask & active_rays;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (node_rays == 0)
+            break;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,394 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+
+namespace foundation {
+namespace bvh {
+
+//
+// Multithreaded BVH builder.
+//
+// The top of the tree is built on the calling thread. Whenever a subtree contains
+// fewer than a given number of items, it is handed over to a pool of worker threads
+// that build it into a separate node array. Subtrees are spliced into the tree once
+// all of them have been built. The resulting tree is identical to the one built by
+// the (single-threaded) Builder class, except for the order of the nodes.
+//
+// The Partitioner class must conform to the prototype described in bvh_builder.h,
+// and its partition() method must be safe to call concurrently on disjoint sets of
+// items (this is for instance the case of BinnedSAHPartitioner).
+//
+
+template <typename Tree, typename Partitioner>
+class ParallelBuilder
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    ParallelBuilder(
+        Logger&         logger,
+        const size_t    thread_count,
+        const size_t    min_parallel_subtree_size = 16 * 1024);
+
+    // Build a tree.
+    template <typename Timer>
+    void build(
+        Tree&           tree,
+        Partitioner&    partitioner,
+        const size_t    size,
+        const size_t    items_per_leaf_hint);
+
+    // Return the construction time.
+    double get_build_time() const;
+
+    // Return the number of subtrees built by worker threads.
+    size_t get_parallel_subtree_count() const;
+
+  private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+
+    struct Subtree
+    {
+        size_t          m_node_index;       // index of the subtree root in the tree
+        size_t          m_begin;
+        size_t          m_end;
+        AABBType        m_bbox;
+        NodeVectorType  m_nodes;
+
+        explicit Subtree(const typename NodeVectorType::allocator_type& allocator)
+          : m_nodes(allocator)
+        {
+        }
+    };
+
+    class SubtreeJob
+      : public IJob
+    {
+      public:
+        SubtreeJob(
+            ParallelBuilder&    builder,
+            Partitioner&        partitioner,
+            Subtree&            subtree)
+          : m_builder(builder)
+          , m_partitioner(partitioner)
+          , m_subtree(subtree)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_subtree.m_nodes.push_back(NodeType());
+            m_builder.subdivide_recurse(
+                m_subtree.m_nodes,
+                m_partitioner,
+                0,
+                m_subtree.m_begin,
+                m_subtree.m_end,
+                m_subtree.m_bbox,
+                nullptr);
+        }
+
+      private:
+        ParallelBuilder&    m_builder;
+        Partitioner&        m_partitioner;
+        Subtree&            m_subtree;
+    };
+
+    Logger&                                 m_logger;
+    const size_t                            m_thread_count;
+    const size_t                            m_min_parallel_subtree_size;
+    double                                  m_build_time;
+    size_t                                  m_parallel_subtree_count;
+
+    std::vector<std::unique_ptr<Subtree>>   m_subtrees;
+
+    // Recursively subdivide the tree. Subtrees are handed over to worker threads if job_queue is not null.
+    void subdivide_recurse(
+        NodeVectorType& nodes,
+        Partitioner&    partitioner,
+        const size_t    node_index,
+        const size_t    begin,
+        const size_t    end,
+        const AABBType& bbox,
+        JobQueue*       job_queue);
+
+    // Splice a subtree into the tree.
+    static void splice_subtree(
+        NodeVectorType& nodes,
+        const Subtree&  subtree);
+};
+
+
+//
+// ParallelBuilder class implementation.
+//
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::ParallelBuilder(
+    Logger&             logger,
+    const size_t        thread_count,
+    const size_t        min_parallel_subtree_size)
+  : m_logger(logger)
+  , m_thread_count(thread_count)
+  , m_min_parallel_subtree_size(min_parallel_subtree_size)
+  , m_build_time(0.0)
+  , m_parallel_subtree_count(0)
+{
+}
+
+template <typename Tree, typename Partitioner>
+template <typename Timer>
+void ParallelBuilder<Tree, Partitioner>::build(
+    Tree&               tree,
+    Partitioner&        partitioner,
+    const size_t        size,
+    const size_t        items_per_leaf_hint)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the tree.
+    tree.m_nodes.clear();
+
+    // Create the root node of the tree.
+    tree.m_nodes.push_back(NodeType());
+
+    // Compute the bounding box of the tree.
+    const AABBType root_bbox(partitioner.compute_bbox(0, size));
+
+    if (m_thread_count > 1 && size > m_min_parallel_subtree_size)
+    {
+        JobQueue job_queue;
+        JobManager job_manager(
+            m_logger,
+            job_queue,
+            m_thread_count,
+            JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+
+        // Build the top of the tree and schedule the construction of subtrees.
+        subdivide_recurse(
+            tree.m_nodes,
+            partitioner,
+            0,              // node index
+            0,              // begin
+            size,           // end
+            root_bbox,
+            &job_queue);
+
+        // Wait until all subtrees are built.
+        job_queue.wait_until_completion();
+        job_manager.stop();
+
+        // Reserve memory for the nodes.
+        size_t node_count = tree.m_nodes.size();
+        for (size_t i = 0; i < m_subtrees.size(); ++i)
+            node_count += m_subtrees[i]->m_nodes.size() - 1;
+        tree.m_nodes.reserve(node_count);
+
+        // Splice subtrees into the tree.
+        for (size_t i = 0; i < m_subtrees.size(); ++i)
+        {
+            splice_subtree(tree.m_nodes, *m_subtrees[i]);
+            m_subtrees[i].reset();
+        }
+
+        m_parallel_subtree_count = m_subtrees.size();
+        m_subtrees.clear();
+    }
+    else
+    {
+        // Reserve memory for the nodes.
+        const size_t leaf_count_guess = size / items_per_leaf_hint;
+        const size_t node_count_guess = leaf_count_guess > 0 ? 2 * leaf_count_guess - 1 : 0;
+        tree.m_nodes.reserve(node_count_guess);
+
+        // Build the whole tree on the calling thread.
+        subdivide_recurse(
+            tree.m_nodes,
+            partitioner,
+            0,              // node index
+            0,              // begin
+            size,           // end
+            root_bbox,
+            nullptr);
+
+        m_parallel_subtree_count = 0;
+    }
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t ParallelBuilder<Tree, Partitioner>::get_parallel_subtree_count() const
+{
+    return m_parallel_subtree_count;
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::subdivide_recurse(
+    NodeVectorType&     nodes,
+    Partitioner&        partitioner,
+    const size_t        node_index,
+    const size_t        begin,
+    const size_t        end,
+    const AABBType&     bbox,
+    JobQueue*           job_queue)
+{
+    assert(node_index < nodes.size());
+
+    // Hand small enough subtrees over to worker threads.
+    if (job_queue && end - begin <= m_min_parallel_subtree_size)
+    {
+        m_subtrees.push_back(
+            std::unique_ptr<Subtree>(new Subtree(nodes.get_allocator())));
+
+        Subtree& subtree = *m_subtrees.back();
+        subtree.m_node_index = node_index;
+        subtree.m_begin = begin;
+        subtree.m_end = end;
+        subtree.m_bbox = bbox;
+
+        job_queue->schedule(new SubtreeJob(*this, partitioner, subtree));
+
+        return;
+    }
+
+    // Try to partition the set of items.
+    size_t pivot = end;
+    if (end - begin > 1)
+    {
+        pivot = partitioner.partition(begin, end, typename Partitioner::AABBType(bbox));
+        assert(pivot > begin);
+        assert(pivot <= end);
+    }
+
+    if (pivot == end)
+    {
+        // Turn the current node into a leaf node.
+        NodeType& node = nodes[node_index];
+        node.make_leaf();
+        node.set_item_index(begin);
+        node.set_item_count(end - begin);
+    }
+    else
+    {
+        // Compute the bounding box of the child nodes.
+        const AABBType left_bbox(partitioner.compute_bbox(begin, pivot));
+        const AABBType right_bbox(partitioner.compute_bbox(pivot, end));
+
+        // Compute the indices of the child nodes.
+        const size_t left_node_index = nodes.size();
+        const size_t right_node_index = left_node_index + 1;
+
+        // Turn the current node into an interior node.
+        NodeType& node = nodes[node_index];
+        node.make_interior();
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+        node.set_child_node_index(left_node_index);
+
+        // Create the child nodes.
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+
+        // Recurse into the left subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            left_node_index,
+            begin,
+            pivot,
+            left_bbox,
+            job_queue);
+
+        // Recurse into the right subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            right_node_index,
+            pivot,
+            end,
+            right_bbox,
+            job_queue);
+    }
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::splice_subtree(
+    NodeVectorType&     nodes,
+    const Subtree&      subtree)
+{
+    assert(!subtree.m_nodes.empty());
+
+    // Node 0 of the subtree replaces the placeholder node in the tree,
+    // other nodes are appended to the tree in the same order.
+    const size_t base = nodes.size() - 1;
+
+    for (size_t i = 0; i < subtree.m_nodes.size(); ++i)
+    {
+        NodeType node = subtree.m_nodes[i];
+
+        if (node.is_interior())
+            node.set_child_node_index(base + node.get_child_node_index());
+
+        if (i == 0)
+            nodes[subtree.m_node_index] = node;
+        else nodes.push_back(node);
+    }
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,171 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// BVH refitter.
+//
+// Recomputes the bounding boxes of the nodes of a tree, bottom-up, from updated
+// bounding boxes of its items, without changing the topology of the tree. Item
+// bounding boxes are indexed like the items referenced by the leaves.
+//
+// Motion bounding boxes are not refitted, and wide nodes must be rebuilt with
+// bvh::WideBuilder after refitting.
+//
+
+template <typename Tree, typename AABBVector>
+class Refitter
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+
+    // Constructor.
+    Refitter();
+
+    // Refit a tree.
+    template <typename Timer>
+    void refit(
+        Tree&               tree,
+        const AABBVector&   item_bboxes);
+
+    // Return the bounding box of the refitted tree.
+    const AABBType& get_root_bbox() const;
+
+    // Return the refitting time.
+    double get_refit_time() const;
+
+  private:
+    AABBType    m_root_bbox;
+    double      m_refit_time;
+
+    // Recursively refit the subtree rooted at a given node and return its bounding box.
+    static AABBType refit_recurse(
+        Tree&               tree,
+        const AABBVector&   item_bboxes,
+        const size_t        node_index);
+};
+
+
+//
+// Refitter class implementation.
+//
+
+template <typename Tree, typename AABBVector>
+Refitter<Tree, AABBVector>::Refitter()
+  : m_root_bbox(AABBType::invalid())
+  , m_refit_time(0.0)
+{
+}
+
+template <typename Tree, typename AABBVector>
+template <typename Timer>
+void Refitter<Tree, AABBVector>::refit(
+    Tree&                   tree,
+    const AABBVector&       item_bboxes)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    m_root_bbox =
+        tree.m_nodes.empty()
+            ? AABBType::invalid()
+            : refit_recurse(tree, item_bboxes, 0);
+
+    // Measure and save refitting time.
+    stopwatch.measure();
+    m_refit_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename AABBVector>
+inline const typename Refitter<Tree, AABBVector>::AABBType& Refitter<Tree, AABBVector>::get_root_bbox() const
+{
+    return m_root_bbox;
+}
+
+template <typename Tree, typename AABBVector>
+inline double Refitter<Tree, AABBVector>::get_refit_time() const
+{
+    return m_refit_time;
+}
+
+template <typename Tree, typename AABBVector>
+typename Refitter<Tree, AABBVector>::AABBType Refitter<Tree, AABBVector>::refit_recurse(
+    Tree&                   tree,
+    const AABBVector&       item_bboxes,
+    const size_t            node_index)
+{
+    assert(node_index < tree.m_nodes.size());
+
+    if (tree.m_nodes[node_index].is_leaf())
+    {
+        const NodeType& node = tree.m_nodes[node_index];
+        const size_t item_begin = node.get_item_index();
+        const size_t item_end = item_begin + node.get_item_count();
+        assert(item_end <= item_bboxes.size());
+
+        AABBType bbox;
+        bbox.invalidate();
+
+        for (size_t i = item_begin; i < item_end; ++i)
+            bbox.insert(AABBType(item_bboxes[i]));
+
+        return bbox;
+    }
+
+    // Child nodes are stored after their parent: refit them before the parent is updated.
+    const size_t child_index = tree.m_nodes[node_index].get_child_node_index();
+    const AABBType left_bbox = refit_recurse(tree, item_bboxes, child_index);
+    const AABBType right_bbox = refit_recurse(tree, item_bboxes, child_index + 1);
+
+    NodeType& node = tree.m_nodes[node_index];
+    node.set_left_bbox(left_bbox);
+    node.set_right_bbox(right_bbox);
+
+    AABBType bbox(left_bbox);
+    bbox.insert(right_bbox);
+
+    return bbox;
+}
+
+}   // namespace bvh
+}   // namespace foundation
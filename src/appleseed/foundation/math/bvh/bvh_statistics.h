@@ -31,6 +31,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
 #include "foundation/math/population.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
@@ -77,6 +78,36 @@ class TreeStatistics
 };
 
 
+//
+// Evaluate the cost of a BVH according to the Surface Area Heuristic (SAH).
+//
+// The cost is expressed relatively to the cost of intersecting the bounding box
+// of the tree, and therefore allows to compare trees built by different builders.
+//
+
+template <typename Tree>
+class TreeSAHCost
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+
+    static double evaluate(
+        const Tree&         tree,
+        const AABBType&     tree_bbox,
+        const double        interior_node_traversal_cost = 1.0,
+        const double        item_intersection_cost = 1.0);
+
+  private:
+    static double evaluate_recurse(
+        const Tree&         tree,
+        const NodeType&     node,
+        const AABBType&     bbox,
+        const double        interior_node_traversal_cost,
+        const double        item_intersection_cost);
+};
+
+
 //
 // BVH traversal statistics.
 //
@@ -167,5 +198,66 @@ void TreeStatistics<Tree>::collect_stats_recurse(
     }
 }
 
+
+//
+// TreeSAHCost class implementation.
+//
+
+template <typename Tree>
+double TreeSAHCost<Tree>::evaluate(
+    const Tree&             tree,
+    const AABBType&         tree_bbox,
+    const double            interior_node_traversal_cost,
+    const double            item_intersection_cost)
+{
+    assert(!tree.m_nodes.empty());
+
+    const double tree_area = static_cast<double>(half_surface_area(tree_bbox));
+
+    if (tree_area == 0.0)
+        return 0.0;
+
+    const double cost =
+        evaluate_recurse(
+            tree,
+            tree.m_nodes.front(),
+            tree_bbox,
+            interior_node_traversal_cost,
+            item_intersection_cost);
+
+    return cost / tree_area;
+}
+
+template <typename Tree>
+double TreeSAHCost<Tree>::evaluate_recurse(
+    const Tree&             tree,
+    const NodeType&         node,
+    const AABBType&         bbox,
+    const double            interior_node_traversal_cost,
+    const double            item_intersection_cost)
+{
+    const double area = bbox.is_valid() ? static_cast<double>(half_surface_area(bbox)) : 0.0;
+
+    if (node.is_leaf())
+        return area * node.get_item_count() * item_intersection_cost;
+
+    const size_t child_index = node.get_child_node_index();
+
+    return
+          area * interior_node_traversal_cost
+        + evaluate_recurse(
+              tree,
+              tree.m_nodes[child_index],
+              node.get_left_bbox(),
+              interior_node_traversal_cost,
+              item_intersection_cost)
+        + evaluate_recurse(
+              tree,
+              tree.m_nodes[child_index + 1],
+              node.get_right_bbox(),
+              interior_node_traversal_cost,
+              item_intersection_cost);
+}
+
 }   // namespace bvh
 }   // namespace foundation
@@ -29,6 +29,10 @@
 
 #pragma once
 
+// appleseed.foundation headers.
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/utility/alignedvector.h"
+
 // Standard headers.
 #include <cstddef>
 #include <vector>
@@ -49,12 +53,21 @@ class Tree
     typedef typename NodeVectorType::value_type NodeType;
     typedef typename NodeVectorType::allocator_type AllocatorType;
 
+    typedef WideNode<typename NodeType::AABBType, 4> Wide4NodeType;
+    typedef WideNode<typename NodeType::AABBType, 8> Wide8NodeType;
+    typedef AlignedVector<Wide4NodeType> Wide4NodeVectorType;
+    typedef AlignedVector<Wide8NodeType> Wide8NodeVectorType;
+
     // Constructor.
     explicit Tree(const AllocatorType& allocator = AllocatorType());
 
     // Clear the tree.
     void clear();
 
+    // Return the number of children per node used during traversal:
+    // 2 unless wide nodes were built with bvh::WideBuilder.
+    size_t get_node_width() const;
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -65,17 +78,66 @@ class Tree
     template <typename Tree, typename Partitioner>
     friend class SpatialBuilder;
 
+    template <typename Tree, typename Partitioner>
+    friend class ParallelBuilder;
+
+    template <typename Tree, typename AABBVector>
+    friend class Refitter;
+
     template <typename Tree>
     friend class TreeStatistics;
 
+    template <typename Tree>
+    friend class TreeSAHCost;
+
     template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
     friend class Intersector;
 
+    template <typename Tree, typename Visitor, typename Ray, size_t PacketSize, size_t StackSize>
+    friend class PacketIntersector;
+
+    template <typename Tree, size_t Width>
+    friend class WideBuilder;
+
+    template <typename Tree, typename Visitor, typename Ray, size_t Width, size_t StackSize>
+    friend class WideIntersector;
+
+    template <typename Tree, size_t Width>
+    friend struct WideNodes;
+
     typedef typename NodeType::AABBType AABBType;
     typedef std::vector<AABBType> AABBVector;
 
-    NodeVector  m_nodes;
-    AABBVector  m_node_bboxes;
+    NodeVector          m_nodes;
+    AABBVector          m_node_bboxes;
+    Wide4NodeVectorType m_wide4_nodes;
+    Wide8NodeVectorType m_wide8_nodes;
+};
+
+
+//
+// Access to the wide nodes of a given width of a BVH.
+//
+
+template <typename Tree, size_t Width>
+struct WideNodes;
+
+template <typename Tree>
+struct WideNodes<Tree, 4>
+{
+    typedef typename Tree::Wide4NodeVectorType VectorType;
+
+    static VectorType& get(Tree& tree)              { return tree.m_wide4_nodes; }
+    static const VectorType& get(const Tree& tree)  { return tree.m_wide4_nodes; }
+};
+
+template <typename Tree>
+struct WideNodes<Tree, 8>
+{
+    typedef typename Tree::Wide8NodeVectorType VectorType;
+
+    static VectorType& get(Tree& tree)              { return tree.m_wide8_nodes; }
+    static const VectorType& get(const Tree& tree)  { return tree.m_wide8_nodes; }
 };
 
 
@@ -86,6 +148,8 @@ class Tree
 template <typename NodeVector>
 Tree<NodeVector>::Tree(const AllocatorType& allocator)
   : m_nodes(allocator)
+  , m_wide4_nodes(typename Wide4NodeVectorType::allocator_type(64))     // wide nodes are aligned on 64-byte boundaries
+  , m_wide8_nodes(typename Wide8NodeVectorType::allocator_type(64))
 {
     clear();
 }
@@ -94,6 +158,17 @@ template <typename NodeVector>
 void Tree<NodeVector>::clear()
 {
     m_nodes.clear();
+    m_wide4_nodes.clear();
+    m_wide8_nodes.clear();
+}
+
+template <typename NodeVector>
+size_t Tree<NodeVector>::get_node_width() const
+{
+    return
+        !m_wide8_nodes.empty() ? 8 :
+        !m_wide4_nodes.empty() ? 4 :
+        2;
 }
 
 template <typename NodeVector>
@@ -101,7 +176,9 @@ size_t Tree<NodeVector>::get_memory_size() const
 {
     return
           sizeof(*this)
-        + m_nodes.capacity() * sizeof(NodeType);
+        + m_nodes.capacity() * sizeof(NodeType)
+        + m_wide4_nodes.capacity() * sizeof(Wide4NodeType)
+        + m_wide8_nodes.capacity() * sizeof(Wide8NodeType);
 }
 
 }   // namespace bvh
@@ -0,0 +1,277 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_tree.h"
+#include "foundation/math/population.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Builds the wide nodes of a BVH by collapsing its binary nodes.
+//
+// Starting from the children of a binary interior node, the interior child with
+// the largest surface area is repeatedly replaced by its own two children until
+// Width children are gathered or only leaves remain. The binary nodes are left
+// untouched since wide nodes reference its leaves.
+//
+// Motion bounding boxes are not collapsed: trees with motion must keep being
+// traversed with bvh::Intersector::intersect_motion().
+//
+
+template <typename Tree, size_t Width>
+class WideBuilder
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    WideBuilder();
+
+    // Build the wide nodes of a tree whose binary nodes have already been built.
+    template <typename Timer>
+    void build(Tree& tree);
+
+    // Return the construction time.
+    double get_build_time() const;
+
+    // Return statistics about the wide nodes.
+    Statistics get_statistics() const;
+
+  private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef typename WideNodes<Tree, Width>::VectorType WideNodeVectorType;
+    typedef typename WideNodeVectorType::value_type WideNodeType;
+
+    struct Child
+    {
+        size_t      m_node_index;
+        AABBType    m_bbox;
+    };
+
+    double              m_build_time;
+    size_t              m_wide_node_count;
+    Population<size_t>  m_child_count;
+
+    // Recursively collapse the binary node with index node_index into the wide node with index wide_node_index.
+    void collapse_recurse(
+        const NodeVectorType&   nodes,
+        WideNodeVectorType&     wide_nodes,
+        const size_t            node_index,
+        const size_t            wide_node_index);
+
+    static ValueType half_surface_area(const AABBType& bbox);
+};
+
+
+//
+// WideBuilder class implementation.
+//
+
+template <typename Tree, size_t Width>
+WideBuilder<Tree, Width>::WideBuilder()
+  : m_build_time(0.0)
+  , m_wide_node_count(0)
+{
+}
+
+template <typename Tree, size_t Width>
+template <typename Timer>
+void WideBuilder<Tree, Width>::build(Tree& tree)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    const NodeVectorType& nodes = tree.m_nodes;
+    WideNodeVectorType& wide_nodes = WideNodes<Tree, Width>::get(tree);
+
+    // Only keep wide nodes of a single width.
+    tree.m_wide4_nodes.clear();
+    tree.m_wide8_nodes.clear();
+
+    if (!nodes.empty())
+    {
+        // A binary BVH with n leaves has n - 1 interior nodes; a wide BVH needs at least (n - 1) / (Width - 1).
+        wide_nodes.reserve(nodes.size() / (2 * (Width - 1)) + 1);
+
+        // Create the root node of the wide BVH.
+        wide_nodes.push_back(WideNodeType());
+        wide_nodes.back().clear();
+
+        if (nodes.front().is_leaf())
+        {
+            // The root of the binary BVH is a leaf of unknown extent.
+            AABBType bbox;
+            for (size_t d = 0; d < AABBType::Dimension; ++d)
+            {
+                bbox.min[d] = -std::numeric_limits<ValueType>::max();
+                bbox.max[d] = std::numeric_limits<ValueType>::max();
+            }
+
+            wide_nodes.front().add_leaf_child(bbox, 0);
+            m_child_count.insert(1);
+        }
+        else collapse_recurse(nodes, wide_nodes, 0, 0);
+    }
+
+    m_wide_node_count = wide_nodes.size();
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, size_t Width>
+inline double WideBuilder<Tree, Width>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename Tree, size_t Width>
+Statistics WideBuilder<Tree, Width>::get_statistics() const
+{
+    Statistics stats;
+    stats.insert("node width", Width);
+    stats.insert("wide nodes", m_wide_node_count);
+    stats.insert("children per wide node", m_child_count);
+    return stats;
+}
+
+template <typename Tree, size_t Width>
+void WideBuilder<Tree, Width>::collapse_recurse(
+    const NodeVectorType&       nodes,
+    WideNodeVectorType&         wide_nodes,
+    const size_t                node_index,
+    const size_t                wide_node_index)
+{
+    const NodeType& node = nodes[node_index];
+    assert(node.is_interior());
+
+    // Start with the two children of the binary node.
+    Child children[Width];
+    children[0].m_node_index = node.get_child_node_index();
+    children[0].m_bbox = node.get_left_bbox();
+    children[1].m_node_index = node.get_child_node_index() + 1;
+    children[1].m_bbox = node.get_right_bbox();
+    size_t child_count = 2;
+
+    // Open the interior child with the largest surface area until the wide node is full.
+    while (child_count < Width)
+    {
+        size_t best_child = Width;
+        ValueType best_area = ValueType(-1.0);
+
+        for (size_t i = 0; i < child_count; ++i)
+        {
+            if (nodes[children[i].m_node_index].is_interior())
+            {
+                const ValueType area = half_surface_area(children[i].m_bbox);
+                if (best_area < area)
+                {
+                    best_area = area;
+                    best_child = i;
+                }
+            }
+        }
+
+        // Only leaves remain.
+        if (best_child == Width)
+            break;
+
+        const NodeType& child_node = nodes[children[best_child].m_node_index];
+        children[child_count].m_node_index = child_node.get_child_node_index() + 1;
+        children[child_count].m_bbox = child_node.get_right_bbox();
+        children[best_child].m_node_index = child_node.get_child_node_index();
+        children[best_child].m_bbox = child_node.get_left_bbox();
+        ++child_count;
+    }
+
+    m_child_count.insert(child_count);
+
+    // Allocate the wide nodes of the interior children contiguously.
+    size_t wide_child_indices[Width];
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        if (nodes[children[i].m_node_index].is_interior())
+        {
+            wide_child_indices[i] = wide_nodes.size();
+            wide_nodes.push_back(WideNodeType());
+            wide_nodes.back().clear();
+            wide_nodes[wide_node_index].add_interior_child(children[i].m_bbox, wide_child_indices[i]);
+        }
+        else wide_nodes[wide_node_index].add_leaf_child(children[i].m_bbox, children[i].m_node_index);
+    }
+
+    // Recurse into the interior children.
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        if (nodes[children[i].m_node_index].is_interior())
+        {
+            collapse_recurse(
+                nodes,
+                wide_nodes,
+                children[i].m_node_index,
+                wide_child_indices[i]);
+        }
+    }
+}
+
+template <typename Tree, size_t Width>
+inline typename WideBuilder<Tree, Width>::ValueType WideBuilder<Tree, Width>::half_surface_area(const AABBType& bbox)
+{
+    // Sum of the areas of the faces of the bounding box that share a given corner;
+    // this is only a relative measure in dimensions other than 3.
+    const typename AABBType::VectorType e = bbox.extent();
+    ValueType area(0.0);
+
+    for (size_t i = 0; i < AABBType::Dimension; ++i)
+    {
+        for (size_t j = i + 1; j < AABBType::Dimension; ++j)
+            area += e[i] * e[j];
+    }
+
+    return area;
+}
+
+}   // namespace bvh
+}   // namespace foundation
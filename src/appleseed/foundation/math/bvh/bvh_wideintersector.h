@@ -0,0 +1,437 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_tree.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Intersector for BVHs whose wide nodes were built with bvh::WideBuilder.
+//
+// All children of a wide node are tested against the ray at once (with SSE2 or AVX
+// instructions when intersecting double-precision 3D bounding boxes), and the
+// children that are hit are then visited in front-to-back order.
+//
+// The Visitor class must conform to the prototype described in bvh_intersector.h;
+// it is invoked on the leaf nodes of the binary BVH.
+//
+// StackSize is the maximum depth of the binary BVH.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t Width,
+    size_t StackSize = 64
+>
+class WideIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, AABBType::Dimension> RayInfoType;
+
+    // Intersect a ray with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    typedef typename WideNodes<Tree, Width>::VectorType WideNodeVectorType;
+    typedef typename WideNodeVectorType::value_type WideNodeType;
+};
+
+
+//
+// Ray-vs-wide node intersection.
+//
+
+namespace wideintersector_impl
+{
+    template <typename T, size_t Width, size_t N>
+    class RayBoxesIntersector
+    {
+      public:
+        template <typename RayType, typename RayInfoType>
+        RayBoxesIntersector(
+            const RayType&      ray,
+            const RayInfoType&  ray_info)
+          : m_ray_tmin(static_cast<T>(ray.m_tmin))
+        {
+            for (size_t d = 0; d < N; ++d)
+            {
+                m_org[d] = static_cast<T>(ray.m_org[d]);
+                m_rcp_dir[d] = static_cast<T>(ray_info.m_rcp_dir[d]);
+                m_near[d] = (2 * d + 1 - ray_info.m_sgn_dir[d]) * Width;
+                m_far[d] = (2 * d + ray_info.m_sgn_dir[d]) * Width;
+            }
+        }
+
+        // Return a bit mask of the bounding boxes hit by the ray and store entry distances into tmin.
+        size_t intersect(
+            const T*            bbox_data,
+            const T             ray_tmax,
+            T                   tmin[Width]) const
+        {
+            size_t hits = 0;
+
+            for (size_t i = 0; i < Width; ++i)
+            {
+                T t0 = m_ray_tmin;
+                T t1 = ray_tmax;
+
+                for (size_t d = 0; d < N; ++d)
+                {
+                    const T tnear = m_rcp_dir[d] * (bbox_data[m_near[d] + i] - m_org[d]);
+                    const T tfar = m_rcp_dir[d] * (bbox_data[m_far[d] + i] - m_org[d]);
+                    t0 = tnear > t0 ? tnear : t0;
+                    t1 = tfar < t1 ? tfar : t1;
+                }
+
+                if (!(t0 > t1 || t1 < m_ray_tmin || t0 >= ray_tmax))
+                    hits |= size_t(1) << i;
+
+                tmin[i] = t0;
+            }
+
+            return hits;
+        }
+
+      private:
+        T       m_org[N];
+        T       m_rcp_dir[N];
+        size_t  m_near[N];
+        size_t  m_far[N];
+        T       m_ray_tmin;
+    };
+
+#ifdef APPLESEED_USE_SSE
+
+    template <size_t Width>
+    class RayBoxesIntersector<double, Width, 3>
+    {
+      public:
+        template <typename RayType, typename RayInfoType>
+        RayBoxesIntersector(
+            const RayType&      ray,
+            const RayInfoType&  ray_info)
+        {
+            for (size_t d = 0; d < 3; ++d)
+            {
+                m_near[d] = (2 * d + 1 - ray_info.m_sgn_dir[d]) * Width;
+                m_far[d] = (2 * d + ray_info.m_sgn_dir[d]) * Width;
+            }
+
+#ifdef APPLESEED_USE_AVX
+            static_assert(Width % 4 == 0, "Wide node width must be a multiple of 4");
+            m_org_x = _mm256_set1_pd(ray.m_org.x);
+            m_org_y = _mm256_set1_pd(ray.m_org.y);
+            m_org_z = _mm256_set1_pd(ray.m_org.z);
+            m_rcp_dir_x = _mm256_set1_pd(ray_info.m_rcp_dir.x);
+            m_rcp_dir_y = _mm256_set1_pd(ray_info.m_rcp_dir.y);
+            m_rcp_dir_z = _mm256_set1_pd(ray_info.m_rcp_dir.z);
+            m_ray_tmin = _mm256_set1_pd(ray.m_tmin);
+#else
+            static_assert(Width % 2 == 0, "Wide node width must be a multiple of 2");
+            m_org_x = _mm_set1_pd(ray.m_org.x);
+            m_org_y = _mm_set1_pd(ray.m_org.y);
+            m_org_z = _mm_set1_pd(ray.m_org.z);
+            m_rcp_dir_x = _mm_set1_pd(ray_info.m_rcp_dir.x);
+            m_rcp_dir_y = _mm_set1_pd(ray_info.m_rcp_dir.y);
+            m_rcp_dir_z = _mm_set1_pd(ray_info.m_rcp_dir.z);
+            m_ray_tmin = _mm_set1_pd(ray.m_tmin);
+#endif
+        }
+
+        // Return a bit mask of the bounding boxes hit by the ray and store entry distances into tmin.
+        // bbox_data and tmin must be aligned on a 32-byte boundary.
+        size_t intersect(
+            const double*       bbox_data,
+            const double        ray_tmax,
+            double              tmin[Width]) const
+        {
+            size_t hits = 0;
+
+#ifdef APPLESEED_USE_AVX
+
+            const __m256d tmax_limit = _mm256_set1_pd(ray_tmax);
+
+            for (size_t i = 0; i < Width; i += 4)
+            {
+                const __m256d xl1 = _mm256_mul_pd(m_rcp_dir_x, _mm256_sub_pd(_mm256_load_pd(bbox_data + m_near[0] + i), m_org_x));
+                const __m256d xl2 = _mm256_mul_pd(m_rcp_dir_x, _mm256_sub_pd(_mm256_load_pd(bbox_data + m_far[0] + i), m_org_x));
+                const __m256d yl1 = _mm256_mul_pd(m_rcp_dir_y, _mm256_sub_pd(_mm256_load_pd(bbox_data + m_near[1] + i), m_org_y));
+                const __m256d yl2 = _mm256_mul_pd(m_rcp_dir_y, _mm256_sub_pd(_mm256_load_pd(bbox_data + m_far[1] + i), m_org_y));
+                const __m256d zl1 = _mm256_mul_pd(m_rcp_dir_z, _mm256_sub_pd(_mm256_load_pd(bbox_data + m_near[2] + i), m_org_z));
+                const __m256d zl2 = _mm256_mul_pd(m_rcp_dir_z, _mm256_sub_pd(_mm256_load_pd(bbox_data + m_far[2] + i), m_org_z));
+
+                const __m256d t0 = _mm256_max_pd(zl1, _mm256_max_pd(yl1, _mm256_max_pd(xl1, m_ray_tmin)));
+                const __m256d t1 = _mm256_min_pd(zl2, _mm256_min_pd(yl2, _mm256_min_pd(xl2, tmax_limit)));
+
+                const int misses =
+                    _mm256_movemask_pd(
+                        _mm256_or_pd(
+                            _mm256_cmp_pd(t0, t1, _CMP_GT_OQ),
+                            _mm256_or_pd(
+                                _mm256_cmp_pd(t1, m_ray_tmin, _CMP_LT_OQ),
+                                _mm256_cmp_pd(t0, tmax_limit, _CMP_GE_OQ))));
+
+                hits |= static_cast<size_t>(misses ^ 15) << i;
+
+                _mm256_store_pd(tmin + i, t0);
+            }
+
+#else
+
+            const __m128d tmax_limit = _mm_set1_pd(ray_tmax);
+
+            for (size_t i = 0; i < Width; i += 2)
+            {
+                const __m128d xl1 = _mm_mul_pd(m_rcp_dir_x, _mm_sub_pd(_mm_load_pd(bbox_data + m_near[0] + i), m_org_x));
+                const __m128d xl2 = _mm_mul_pd(m_rcp_dir_x, _mm_sub_pd(_mm_load_pd(bbox_data + m_far[0] + i), m_org_x));
+                const __m128d yl1 = _mm_mul_pd(m_rcp_dir_y, _mm_sub_pd(_mm_load_pd(bbox_data + m_near[1] + i), m_org_y));
+                const __m128d yl2 = _mm_mul_pd(m_rcp_dir_y, _mm_sub_pd(_mm_load_pd(bbox_data + m_far[1] + i), m_org_y));
+                const __m128d zl1 = _mm_mul_pd(m_rcp_dir_z, _mm_sub_pd(_mm_load_pd(bbox_data + m_near[2] + i), m_org_z));
+                const __m128d zl2 = _mm_mul_pd(m_rcp_dir_z, _mm_sub_pd(_mm_load_pd(bbox_data + m_far[2] + i), m_org_z));
+
+                const __m128d t0 = _mm_max_pd(zl1, _mm_max_pd(yl1, _mm_max_pd(xl1, m_ray_tmin)));
+                const __m128d t1 = _mm_min_pd(zl2, _mm_min_pd(yl2, _mm_min_pd(xl2, tmax_limit)));
+
+                const int misses =
+                    _mm_movemask_pd(
+                        _mm_or_pd(
+                            _mm_cmpgt_pd(t0, t1),
+                            _mm_or_pd(
+                                _mm_cmplt_pd(t1, m_ray_tmin),
+                                _mm_cmpge_pd(t0, tmax_limit))));
+
+                hits |= static_cast<size_t>(misses ^ 3) << i;
+
+                _mm_store_pd(tmin + i, t0);
+            }
+
+#endif
+
+            return hits;
+        }
+
+      private:
+#ifdef APPLESEED_USE_AVX
+        __m256d m_org_x, m_org_y, m_org_z;
+        __m256d m_rcp_dir_x, m_rcp_dir_y, m_rcp_dir_z;
+        __m256d m_ray_tmin;
+#else
+        __m128d m_org_x, m_org_y, m_org_z;
+        __m128d m_rcp_dir_x, m_rcp_dir_y, m_rcp_dir_z;
+        __m128d m_ray_tmin;
+#endif
+        size_t  m_near[3];
+        size_t  m_far[3];
+    };
+
+#endif  // APPLESEED_USE_SSE
+}
+
+
+//
+// WideIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t Width,
+    size_t StackSize
+>
+void WideIntersector<Tree, Visitor, Ray, Width, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    const WideNodeVectorType& wide_nodes = WideNodes<Tree, Width>::get(tree);
+
+    // Make sure the wide nodes were built.
+    assert(!wide_nodes.empty());
+
+    const wideintersector_impl::RayBoxesIntersector<ValueType, Width, AABBType::Dimension>
+        ray_boxes_intersector(ray, ray_info);
+
+    // Node stack. Each visited wide node pushes at most Width - 1 children.
+    uint32 stack[StackSize * (Width - 1)];
+    uint32* stack_ptr = stack;
+
+    // Current node.
+    uint32 node_ref = 0;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (!(node_ref & WideNodeType::LeafFlag))
+        {
+            const WideNodeType& node = wide_nodes[node_ref];
+            const size_t child_count = node.get_child_count();
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += child_count);
+
+            // Intersect the bounding boxes of all the children at once.
+            APPLESEED_SIMD8_ALIGN ValueType tmin[Width];
+            const size_t hits =
+                ray_boxes_intersector.intersect(node.m_bbox_data, ray_tmax, tmin);
+
+            // Sort the children that were hit by increasing distance.
+            uint32 hit_children[Width];
+            ValueType hit_tmin[Width];
+            size_t hit_count = 0;
+            for (size_t i = 0; i < child_count; ++i)
+            {
+                if (hits & (size_t(1) << i))
+                {
+                    size_t j = hit_count++;
+                    while (j > 0 && hit_tmin[j - 1] > tmin[i])
+                    {
+                        hit_children[j] = hit_children[j - 1];
+                        hit_tmin[j] = hit_tmin[j - 1];
+                        --j;
+                    }
+                    hit_children[j] = node.m_children[i];
+                    hit_tmin[j] = tmin[i];
+                }
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count - hit_count);
+
+            if (hit_count > 0)
+            {
+                // Push the far child nodes to the stack, continue with the nearest child node.
+                for (size_t i = hit_count - 1; i > 0; --i)
+                {
+                    assert(stack_ptr < stack + StackSize * (Width - 1));
+                    *stack_ptr++ = hit_children[i];
+                }
+                node_ref = hit_children[0];
+                continue;
+            }
+
+            // Terminate traversal if the node stack is empty.
+            if (stack_ptr == stack)
+                break;
+
+            // Pop the top node from the stack.
+            node_ref = *--stack_ptr;
+            continue;
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_nodes[node_ref & ~WideNodeType::LeafFlag],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+                ray_tmax = distance;
+
+            // Terminate traversal if the node stack is empty.
+            if (stack_ptr == stack)
+                break;
+
+            // Pop the top node from the stack.
+            node_ref = *--stack_ptr;
+        }
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,188 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Interior node with up to Width children of a collapsed (wide) BVH.
+//
+// Wide nodes are built on top of a binary BVH: interior children reference other
+// wide nodes while leaf children reference leaf nodes of the binary BVH, so that
+// leaf visitors written for binary BVHs can be used unchanged.
+//
+// Child bounding boxes are stored in structure-of-arrays layout so that a ray can
+// be tested against all children at once with a few SIMD instructions. Unused
+// slots hold empty bounding boxes that no ray can hit.
+//
+
+template <typename AABB, size_t Width>
+class APPLESEED_ALIGN(64) WideNode
+{
+  public:
+    typedef AABB AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    static const size_t Dimension = AABBType::Dimension;
+    static const size_t MaxChildCount = Width;
+
+    // Remove all children.
+    void clear();
+
+    // Return the number of children.
+    size_t get_child_count() const;
+
+    // Append a child referencing another wide node.
+    void add_interior_child(const AABBType& bbox, const size_t wide_node_index);
+
+    // Append a child referencing a leaf node of the binary BVH.
+    void add_leaf_child(const AABBType& bbox, const size_t leaf_node_index);
+
+    // Access the children.
+    AABBType get_child_bbox(const size_t i) const;
+    bool is_leaf_child(const size_t i) const;
+    size_t get_child_node_index(const size_t i) const;
+
+  private:
+    template <typename Tree, typename Visitor, typename Ray, size_t W, size_t StackSize>
+    friend class WideIntersector;
+
+    static const uint32 LeafFlag = 0x80000000u;
+
+    // Bounding boxes of the children, stored as [dimension][min, max][child].
+    APPLESEED_SIMD8_ALIGN ValueType m_bbox_data[2 * Dimension * Width];
+
+    uint32                          m_children[Width];
+    uint32                          m_child_count;
+
+    void add_child(const AABBType& bbox, const uint32 child);
+};
+
+
+//
+// WideNode class implementation.
+//
+
+template <typename AABB, size_t Width>
+inline void WideNode<AABB, Width>::clear()
+{
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        for (size_t i = 0; i < Width; ++i)
+        {
+            m_bbox_data[(2 * d + 0) * Width + i] = std::numeric_limits<ValueType>::max();
+            m_bbox_data[(2 * d + 1) * Width + i] = -std::numeric_limits<ValueType>::max();
+        }
+    }
+
+    for (size_t i = 0; i < Width; ++i)
+        m_children[i] = 0;
+
+    m_child_count = 0;
+}
+
+template <typename AABB, size_t Width>
+inline size_t WideNode<AABB, Width>::get_child_count() const
+{
+    return static_cast<size_t>(m_child_count);
+}
+
+template <typename AABB, size_t Width>
+inline void WideNode<AABB, Width>::add_interior_child(const AABBType& bbox, const size_t wide_node_index)
+{
+    assert(wide_node_index < LeafFlag);
+    add_child(bbox, static_cast<uint32>(wide_node_index));
+}
+
+template <typename AABB, size_t Width>
+inline void WideNode<AABB, Width>::add_leaf_child(const AABBType& bbox, const size_t leaf_node_index)
+{
+    assert(leaf_node_index < LeafFlag);
+    add_child(bbox, static_cast<uint32>(leaf_node_index) | LeafFlag);
+}
+
+template <typename AABB, size_t Width>
+inline AABB WideNode<AABB, Width>::get_child_bbox(const size_t i) const
+{
+    assert(i < m_child_count);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = m_bbox_data[(2 * d + 0) * Width + i];
+        bbox.max[d] = m_bbox_data[(2 * d + 1) * Width + i];
+    }
+
+    return bbox;
+}
+
+template <typename AABB, size_t Width>
+inline bool WideNode<AABB, Width>::is_leaf_child(const size_t i) const
+{
+    assert(i < m_child_count);
+    return (m_children[i] & LeafFlag) != 0;
+}
+
+template <typename AABB, size_t Width>
+inline size_t WideNode<AABB, Width>::get_child_node_index(const size_t i) const
+{
+    assert(i < m_child_count);
+    return static_cast<size_t>(m_children[i] & ~LeafFlag);
+}
+
+template <typename AABB, size_t Width>
+inline void WideNode<AABB, Width>::add_child(const AABBType& bbox, const uint32 child)
+{
+    assert(m_child_count < Width);
+
+    const size_t i = m_child_count++;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_bbox_data[(2 * d + 0) * Width + i] = bbox.min[d];
+        m_bbox_data[(2 * d + 1) * Width + i] = bbox.max[d];
+    }
+
+    m_children[i] = child;
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,393 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// A group of Moeller-Trumbore triangles stored in SoA form, intersected in a single pass.
+//
+// Triangles are stored in the same representation as TriangleMT (first vertex and two
+// edges). Intersections are computed in double precision with the exact same sequence
+// of operations as TriangleMT<double>, so that a group returns bit-identical results
+// to the equivalent sequence of individual triangles. Groups of four single-precision
+// triangles are intersected with SSE2 or AVX instructions.
+//
+
+template <typename T, size_t Width>
+struct TriangleMTGroup
+{
+    // Types.
+    typedef T ValueType;
+    typedef TriangleMT<T> TriangleType;
+    typedef Ray<double, 3> RayType;
+
+    // Number of triangles in the group.
+    static const size_t Size = Width;
+
+    // First vertices, then first and second edges, one array of Width values per coordinate.
+    ValueType   m_v0[3][Width];
+    ValueType   m_e0[3][Width];
+    ValueType   m_e1[3][Width];
+
+    // Set or get a triangle of the group.
+    void set(const size_t index, const TriangleType& triangle);
+    TriangleType get(const size_t index) const;
+
+    // Make a slot of the group degenerate so that it is never hit.
+    void clear(const size_t index);
+
+    // Intersect all triangles of the group. Return a bit mask of the triangles that are hit;
+    // the distance and barycentric coordinates of these hits are stored into t, u and v.
+    size_t intersect(
+        const RayType&  ray,
+        double          t[Width],
+        double          u[Width],
+        double          v[Width]) const;
+
+    // Return a bit mask of the triangles of the group hit by a ray.
+    size_t intersect(const RayType& ray) const;
+};
+
+
+//
+// TriangleMTGroup class implementation.
+//
+
+namespace trianglemtgroup_impl
+{
+    template <typename T, size_t Width>
+    struct Intersector
+    {
+        template <bool ComputeHits>
+        static size_t intersect(
+            const TriangleMTGroup<T, Width>&    group,
+            const Ray<double, 3>&               ray,
+            double                              t[Width],
+            double                              u[Width],
+            double                              v[Width])
+        {
+            size_t hits = 0;
+
+            for (size_t i = 0; i < Width; ++i)
+            {
+                const TriangleMT<double> triangle(group.get(i));
+
+                if (ComputeHits)
+                {
+                    if (triangle.intersect(ray, t[i], u[i], v[i]))
+                        hits |= size_t(1) << i;
+                }
+                else
+                {
+                    if (triangle.intersect(ray))
+                        hits |= size_t(1) << i;
+                }
+            }
+
+            return hits;
+        }
+    };
+
+#ifdef APPLESEED_USE_SSE
+
+    template <>
+    struct Intersector<float, 4>
+    {
+#ifdef APPLESEED_USE_AVX
+        // Load four single-precision values and convert them to double precision.
+        static __m256d load(const float* values)
+        {
+            return _mm256_cvtps_pd(_mm_loadu_ps(values));
+        }
+#else
+        // Load two single-precision values and convert them to double precision.
+        static __m128d load(const float* values)
+        {
+            return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values))));
+        }
+#endif
+
+        template <bool ComputeHits>
+        static size_t intersect(
+            const TriangleMTGroup<float, 4>&    group,
+            const Ray<double, 3>&               ray,
+            double                              t[4],
+            double                              u[4],
+            double                              v[4])
+        {
+#ifdef APPLESEED_USE_AVX
+
+            const __m256d v0x = load(group.m_v0[0]), v0y = load(group.m_v0[1]), v0z = load(group.m_v0[2]);
+            const __m256d e0x = load(group.m_e0[0]), e0y = load(group.m_e0[1]), e0z = load(group.m_e0[2]);
+            const __m256d e1x = load(group.m_e1[0]), e1y = load(group.m_e1[1]), e1z = load(group.m_e1[2]);
+
+            const __m256d dx = _mm256_set1_pd(ray.m_dir.x);
+            const __m256d dy = _mm256_set1_pd(ray.m_dir.y);
+            const __m256d dz = _mm256_set1_pd(ray.m_dir.z);
+
+            // Calculate determinant.
+            const __m256d px = _mm256_sub_pd(_mm256_mul_pd(dy, e1z), _mm256_mul_pd(e1y, dz));
+            const __m256d py = _mm256_sub_pd(_mm256_mul_pd(dz, e1x), _mm256_mul_pd(e1z, dx));
+            const __m256d pz = _mm256_sub_pd(_mm256_mul_pd(dx, e1y), _mm256_mul_pd(e1x, dy));
+            const __m256d det =
+                _mm256_add_pd(
+                    _mm256_add_pd(_mm256_mul_pd(e0x, px), _mm256_mul_pd(e0y, py)),
+                    _mm256_mul_pd(e0z, pz));
+
+            // Calculate distance from v0 to ray origin.
+            const __m256d tx = _mm256_sub_pd(_mm256_set1_pd(ray.m_org.x), v0x);
+            const __m256d ty = _mm256_sub_pd(_mm256_set1_pd(ray.m_org.y), v0y);
+            const __m256d tz = _mm256_sub_pd(_mm256_set1_pd(ray.m_org.z), v0z);
+
+            // Calculate u parameter.
+            const __m256d uu =
+                _mm256_add_pd(
+                    _mm256_add_pd(_mm256_mul_pd(tx, px), _mm256_mul_pd(ty, py)),
+                    _mm256_mul_pd(tz, pz));
+
+            // Calculate v and t parameters.
+            const __m256d qx = _mm256_sub_pd(_mm256_mul_pd(ty, e0z), _mm256_mul_pd(e0y, tz));
+            const __m256d qy = _mm256_sub_pd(_mm256_mul_pd(tz, e0x), _mm256_mul_pd(e0z, tx));
+            const __m256d qz = _mm256_sub_pd(_mm256_mul_pd(tx, e0y), _mm256_mul_pd(e0x, ty));
+            const __m256d vv =
+                _mm256_add_pd(
+                    _mm256_add_pd(_mm256_mul_pd(dx, qx), _mm256_mul_pd(dy, qy)),
+                    _mm256_mul_pd(dz, qz));
+            const __m256d tt =
+                _mm256_add_pd(
+                    _mm256_add_pd(_mm256_mul_pd(e1x, qx), _mm256_mul_pd(e1y, qy)),
+                    _mm256_mul_pd(e1z, qz));
+
+            // Test bounds. Rejections are expressed exactly as in TriangleMT::intersect()
+            // so that NaN values are handled identically.
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256d uv = _mm256_add_pd(uu, vv);
+            const __m256d tmax_det = _mm256_mul_pd(_mm256_set1_pd(ray.m_tmax), det);
+            const __m256d tmin_det = _mm256_mul_pd(_mm256_set1_pd(ray.m_tmin), det);
+
+            const __m256d pos_rejected =
+                _mm256_or_pd(
+                    _mm256_or_pd(
+                        _mm256_or_pd(_mm256_cmp_pd(uu, zero, _CMP_LT_OQ), _mm256_cmp_pd(uu, det, _CMP_GT_OQ)),
+                        _mm256_or_pd(_mm256_cmp_pd(vv, zero, _CMP_LT_OQ), _mm256_cmp_pd(uv, det, _CMP_GT_OQ))),
+                    _mm256_or_pd(_mm256_cmp_pd(tt, tmax_det, _CMP_GE_OQ), _mm256_cmp_pd(tt, tmin_det, _CMP_LT_OQ)));
+
+            const __m256d neg_rejected =
+                _mm256_or_pd(
+                    _mm256_or_pd(
+                        _mm256_or_pd(_mm256_cmp_pd(uu, zero, _CMP_GT_OQ), _mm256_cmp_pd(uu, det, _CMP_LT_OQ)),
+                        _mm256_or_pd(_mm256_cmp_pd(vv, zero, _CMP_GT_OQ), _mm256_cmp_pd(uv, det, _CMP_LT_OQ))),
+                    _mm256_or_pd(_mm256_cmp_pd(tt, tmax_det, _CMP_LE_OQ), _mm256_cmp_pd(tt, tmin_det, _CMP_GT_OQ)));
+
+            const __m256d rejected =
+                _mm256_blendv_pd(neg_rejected, pos_rejected, _mm256_cmp_pd(det, zero, _CMP_GT_OQ));
+
+            const size_t hits = static_cast<size_t>(_mm256_movemask_pd(rejected) ^ 15);
+
+            if (ComputeHits && hits != 0)
+            {
+                // Scale parameters.
+                const __m256d rcp_det = _mm256_div_pd(_mm256_set1_pd(1.0), det);
+                _mm256_storeu_pd(t, _mm256_mul_pd(tt, rcp_det));
+                _mm256_storeu_pd(u, _mm256_mul_pd(uu, rcp_det));
+                _mm256_storeu_pd(v, _mm256_mul_pd(vv, rcp_det));
+            }
+
+            return hits;
+
+#else
+
+            size_t hits = 0;
+
+            const __m128d dx = _mm_set1_pd(ray.m_dir.x);
+            const __m128d dy = _mm_set1_pd(ray.m_dir.y);
+            const __m128d dz = _mm_set1_pd(ray.m_dir.z);
+            const __m128d ox = _mm_set1_pd(ray.m_org.x);
+            const __m128d oy = _mm_set1_pd(ray.m_org.y);
+            const __m128d oz = _mm_set1_pd(ray.m_org.z);
+            const __m128d ray_tmax = _mm_set1_pd(ray.m_tmax);
+            const __m128d ray_tmin = _mm_set1_pd(ray.m_tmin);
+            const __m128d zero = _mm_setzero_pd();
+
+            for (size_t i = 0; i < 4; i += 2)
+            {
+                const __m128d v0x = load(group.m_v0[0] + i), v0y = load(group.m_v0[1] + i), v0z = load(group.m_v0[2] + i);
+                const __m128d e0x = load(group.m_e0[0] + i), e0y = load(group.m_e0[1] + i), e0z = load(group.m_e0[2] + i);
+                const __m128d e1x = load(group.m_e1[0] + i), e1y = load(group.m_e1[1] + i), e1z = load(group.m_e1[2] + i);
+
+                // Calculate determinant.
+                const __m128d px = _mm_sub_pd(_mm_mul_pd(dy, e1z), _mm_mul_pd(e1y, dz));
+                const __m128d py = _mm_sub_pd(_mm_mul_pd(dz, e1x), _mm_mul_pd(e1z, dx));
+                const __m128d pz = _mm_sub_pd(_mm_mul_pd(dx, e1y), _mm_mul_pd(e1x, dy));
+                const __m128d det =
+                    _mm_add_pd(
+                        _mm_add_pd(_mm_mul_pd(e0x, px), _mm_mul_pd(e0y, py)),
+                        _mm_mul_pd(e0z, pz));
+
+                // Calculate distance from v0 to ray origin.
+                const __m128d tx = _mm_sub_pd(ox, v0x);
+                const __m128d ty = _mm_sub_pd(oy, v0y);
+                const __m128d tz = _mm_sub_pd(oz, v0z);
+
+                // Calculate u parameter.
+                const __m128d uu =
+                    _mm_add_pd(
+                        _mm_add_pd(_mm_mul_pd(tx, px), _mm_mul_pd(ty, py)),
+                        _mm_mul_pd(tz, pz));
+
+                // Calculate v and t parameters.
+                const __m128d qx = _mm_sub_pd(_mm_mul_pd(ty, e0z), _mm_mul_pd(e0y, tz));
+                const __m128d qy = _mm_sub_pd(_mm_mul_pd(tz, e0x), _mm_mul_pd(e0z, tx));
+                const __m128d qz = _mm_sub_pd(_mm_mul_pd(tx, e0y), _mm_mul_pd(e0x, ty));
+                const __m128d vv =
+                    _mm_add_pd(
+                        _mm_add_pd(_mm_mul_pd(dx, qx), _mm_mul_pd(dy, qy)),
+                        _mm_mul_pd(dz, qz));
+                const __m128d tt =
+                    _mm_add_pd(
+                        _mm_add_pd(_mm_mul_pd(e1x, qx), _mm_mul_pd(e1y, qy)),
+                        _mm_mul_pd(e1z, qz));
+
+                // Test bounds. Rejections are expressed exactly as in TriangleMT::intersect()
+                // so that NaN values are handled identically.
+                const __m128d uv = _mm_add_pd(uu, vv);
+                const __m128d tmax_det = _mm_mul_pd(ray_tmax, det);
+                const __m128d tmin_det = _mm_mul_pd(ray_tmin, det);
+
+                const __m128d pos_rejected =
+                    _mm_or_pd(
+                        _mm_or_pd(
+                            _mm_or_pd(_mm_cmplt_pd(uu, zero), _mm_cmpgt_pd(uu, det)),
+                            _mm_or_pd(_mm_cmplt_pd(vv, zero), _mm_cmpgt_pd(uv, det))),
+                        _mm_or_pd(_mm_cmpge_pd(tt, tmax_det), _mm_cmplt_pd(tt, tmin_det)));
+
+                const __m128d neg_rejected =
+                    _mm_or_pd(
+                        _mm_or_pd(
+                            _mm_or_pd(_mm_cmpgt_pd(uu, zero), _mm_cmplt_pd(uu, det)),
+                            _mm_or_pd(_mm_cmpgt_pd(vv, zero), _mm_cmplt_pd(uv, det))),
+                        _mm_or_pd(_mm_cmple_pd(tt, tmax_det), _mm_cmpgt_pd(tt, tmin_det)));
+
+                const __m128d positive = _mm_cmpgt_pd(det, zero);
+                const __m128d rejected =
+                    _mm_or_pd(
+                        _mm_and_pd(positive, pos_rejected),
+                        _mm_andnot_pd(positive, neg_rejected));
+
+                const size_t half_hits = static_cast<size_t>(_mm_movemask_pd(rejected) ^ 3);
+                hits |= half_hits << i;
+
+                if (ComputeHits && half_hits != 0)
+                {
+                    // Scale parameters.
+                    const __m128d rcp_det = _mm_div_pd(_mm_set1_pd(1.0), det);
+                    _mm_storeu_pd(t + i, _mm_mul_pd(tt, rcp_det));
+                    _mm_storeu_pd(u + i, _mm_mul_pd(uu, rcp_det));
+                    _mm_storeu_pd(v + i, _mm_mul_pd(vv, rcp_det));
+                }
+            }
+
+            return hits;
+
+#endif
+        }
+    };
+
+#endif  // APPLESEED_USE_SSE
+}
+
+template <typename T, size_t Width>
+inline void TriangleMTGroup<T, Width>::set(const size_t index, const TriangleType& triangle)
+{
+    for (size_t d = 0; d < 3; ++d)
+    {
+        m_v0[d][index] = triangle.m_v0[d];
+        m_e0[d][index] = triangle.m_e0[d];
+        m_e1[d][index] = triangle.m_e1[d];
+    }
+}
+
+template <typename T, size_t Width>
+inline TriangleMT<T> TriangleMTGroup<T, Width>::get(const size_t index) const
+{
+    TriangleType triangle;
+
+    for (size_t d = 0; d < 3; ++d)
+    {
+        triangle.m_v0[d] = m_v0[d][index];
+        triangle.m_e0[d] = m_e0[d][index];
+        triangle.m_e1[d] = m_e1[d][index];
+    }
+
+    return triangle;
+}
+
+template <typename T, size_t Width>
+inline void TriangleMTGroup<T, Width>::clear(const size_t index)
+{
+    for (size_t d = 0; d < 3; ++d)
+    {
+        m_v0[d][index] = T(0.0);
+        m_e0[d][index] = T(0.0);
+        m_e1[d][index] = T(0.0);
+    }
+}
+
+template <typename T, size_t Width>
+APPLESEED_FORCE_INLINE size_t TriangleMTGroup<T, Width>::intersect(
+    const RayType&          ray,
+    double                  t[Width],
+    double                  u[Width],
+    double                  v[Width]) const
+{
+    return trianglemtgroup_impl::Intersector<T, Width>::template intersect<true>(*this, ray, t, u, v);
+}
+
+template <typename T, size_t Width>
+APPLESEED_FORCE_INLINE size_t TriangleMTGroup<T, Width>::intersect(const RayType& ray) const
+{
+    double t[Width], u[Width], v[Width];
+    return trianglemtgroup_impl::Intersector<T, Width>::template intersect<false>(*this, ray, t, u, v);
+}
+
+}   // namespace foundation
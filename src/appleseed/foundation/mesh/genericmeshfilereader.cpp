@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionunsupportedfileformat.h"
 #include "foundation/mesh/binarymeshfilereader.h"
+#include "foundation/mesh/mappedmeshfilereader.h"
 #include "foundation/mesh/objmeshfilereader.h"
 #include "foundation/utility/string.h"
 
@@ -91,6 +92,11 @@ void GenericMeshFileReader::read(IMeshBuilder& builder)
         BinaryMeshFileReader reader(impl->m_filename);
         reader.read(builder);
     }
+    else if (extension == ".mappedmesh")
+    {
+        MappedMeshFileReader reader(impl->m_filename);
+        reader.read(builder);
+    }
     else
     {
         throw ExceptionUnsupportedFileFormat(impl->m_filename.c_str());
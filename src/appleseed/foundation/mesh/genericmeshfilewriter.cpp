@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionunsupportedfileformat.h"
 #include "foundation/mesh/binarymeshfilewriter.h"
+#include "foundation/mesh/mappedmeshfilewriter.h"
 #include "foundation/mesh/objmeshfilewriter.h"
 #include "foundation/utility/string.h"
 
@@ -57,6 +58,8 @@ GenericMeshFileWriter::GenericMeshFileWriter(const char* filename)
         m_writer = new OBJMeshFileWriter(filename);
     else if (extension == ".binarymesh")
         m_writer = new BinaryMeshFileWriter(filename);
+    else if (extension == ".mappedmesh")
+        m_writer = new MappedMeshFileWriter(filename);
     else throw ExceptionUnsupportedFileFormat(filename);
 }
 
@@ -0,0 +1,155 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "mappedmeshfile.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+
+// Standard headers.
+#include <cstring>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// MappedMeshFile class implementation.
+//
+
+static_assert(sizeof(MappedMeshFile::FileHeader) == MappedMeshFile::Alignment, "Unexpected size of MappedMeshFile::FileHeader");
+static_assert(sizeof(MappedMeshFile::MeshHeader) % MappedMeshFile::Alignment == 0, "Unexpected size of MappedMeshFile::MeshHeader");
+static_assert(sizeof(MappedMeshFile::Triangle) == 10 * sizeof(uint32), "Unexpected size of MappedMeshFile::Triangle");
+static_assert(sizeof(Vector3f) == 3 * sizeof(float), "Unexpected size of foundation::Vector3f");
+static_assert(sizeof(Vector2f) == 2 * sizeof(float), "Unexpected size of foundation::Vector2f");
+
+namespace
+{
+    bool is_valid_array(
+        const uint64    mesh_size,
+        const uint64    offset,
+        const uint64    count,
+        const size_t    item_size)
+    {
+        return
+            offset % MappedMeshFile::Alignment == 0 &&
+            offset <= mesh_size &&
+            count <= (mesh_size - offset) / item_size;
+    }
+
+    template <typename T>
+    T* get_array(uint8* mesh_base, const uint64 offset, const uint64 count)
+    {
+        return count > 0 ? reinterpret_cast<T*>(mesh_base + offset) : nullptr;
+    }
+}
+
+const char* MappedMeshFile::get_signature()
+{
+    return "MAPPEDMESH";
+}
+
+MappedMeshFile::MappedMeshFile(const char* filename)
+  : m_file(filename)
+{
+    uint8* base = static_cast<uint8*>(m_file.data());
+    const size_t file_size = m_file.size();
+
+    // Check the file header.
+    if (file_size < sizeof(FileHeader))
+        throw ExceptionIOError("invalid mappedmesh file: file is too small");
+    const FileHeader& file_header = *reinterpret_cast<const FileHeader*>(base);
+    if (memcmp(file_header.m_signature, get_signature(), sizeof(file_header.m_signature)))
+        throw ExceptionIOError("invalid mappedmesh format signature");
+    if (file_header.m_byte_order_mark != ByteOrderMark)
+        throw ExceptionIOError("mappedmesh file was written on a machine with a different byte order");
+    if (file_header.m_version != Version)
+        throw ExceptionIOError("unknown mappedmesh format version");
+
+    uint64 mesh_offset = file_header.m_first_mesh_offset;
+
+    while (mesh_offset < file_size)
+    {
+        // Check the mesh header.
+        if (mesh_offset % Alignment != 0 || file_size - mesh_offset < sizeof(MeshHeader))
+            throw ExceptionIOError("invalid mappedmesh file: invalid mesh header offset");
+        uint8* mesh_base = base + mesh_offset;
+        const MeshHeader& header = *reinterpret_cast<const MeshHeader*>(mesh_base);
+        if (header.m_size < sizeof(MeshHeader) || header.m_size > file_size - mesh_offset)
+            throw ExceptionIOError("invalid mappedmesh file: invalid mesh size");
+
+        // Check the arrays. Triangle indices are not checked as doing so would
+        // require touching every page of the triangle arrays.
+        if (!is_valid_array(header.m_size, header.m_name_offset, header.m_name_length + 1, 1) ||
+            !is_valid_array(header.m_size, header.m_vertex_offset, header.m_vertex_count, sizeof(Vector3f)) ||
+            !is_valid_array(header.m_size, header.m_vertex_normal_offset, header.m_vertex_normal_count, sizeof(Vector3f)) ||
+            !is_valid_array(header.m_size, header.m_tex_coords_offset, header.m_tex_coords_count, sizeof(Vector2f)) ||
+            !is_valid_array(header.m_size, header.m_triangle_offset, header.m_triangle_count, sizeof(Triangle)) ||
+            !is_valid_array(header.m_size, header.m_material_slot_offset, header.m_material_slot_size, 1))
+            throw ExceptionIOError("invalid mappedmesh file: invalid array bounds");
+
+        Mesh mesh;
+
+        // Name.
+        mesh.m_name = reinterpret_cast<const char*>(mesh_base + header.m_name_offset);
+        if (mesh.m_name[header.m_name_length] != '\0')
+            throw ExceptionIOError("invalid mappedmesh file: invalid mesh name");
+
+        // Geometry.
+        mesh.m_vertices = get_array<Vector3f>(mesh_base, header.m_vertex_offset, header.m_vertex_count);
+        mesh.m_vertex_count = static_cast<size_t>(header.m_vertex_count);
+        mesh.m_vertex_normals = get_array<Vector3f>(mesh_base, header.m_vertex_normal_offset, header.m_vertex_normal_count);
+        mesh.m_vertex_normal_count = static_cast<size_t>(header.m_vertex_normal_count);
+        mesh.m_tex_coords = get_array<Vector2f>(mesh_base, header.m_tex_coords_offset, header.m_tex_coords_count);
+        mesh.m_tex_coords_count = static_cast<size_t>(header.m_tex_coords_count);
+        mesh.m_triangles = get_array<Triangle>(mesh_base, header.m_triangle_offset, header.m_triangle_count);
+        mesh.m_triangle_count = static_cast<size_t>(header.m_triangle_count);
+
+        // Material slots.
+        const char* slot = reinterpret_cast<const char*>(mesh_base + header.m_material_slot_offset);
+        const char* slots_end = slot + header.m_material_slot_size;
+        mesh.m_material_slots.reserve(static_cast<size_t>(header.m_material_slot_count));
+        for (uint64 i = 0; i < header.m_material_slot_count; ++i)
+        {
+            const void* slot_end = memchr(slot, '\0', slots_end - slot);
+            if (slot_end == nullptr)
+                throw ExceptionIOError("invalid mappedmesh file: invalid material slot");
+            mesh.m_material_slots.push_back(slot);
+            slot = static_cast<const char*>(slot_end) + 1;
+        }
+
+        m_meshes.push_back(mesh);
+
+        mesh_offset += header.m_size;
+    }
+}
+
+}   // namespace foundation
@@ -0,0 +1,166 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A mesh file in the MappedMesh format, mapped into memory.
+//
+// The MappedMesh format stores the geometry of each mesh as contiguous arrays
+// of single-precision vertices, unit-length vertex normals, texture coordinates
+// and triangles, laid out exactly as they are in memory and aligned on cache
+// line boundaries. Meshes can therefore be rendered straight from the mapped
+// file, without being decoded or copied, and the operating system only pages
+// in the parts of the file that are actually accessed.
+//
+// File layout:
+//
+//   FileHeader
+//   MeshHeader, name, vertices, vertex normals, texture coordinates, triangles, material slots     (mesh #0)
+//   MeshHeader, name, vertices, vertex normals, texture coordinates, triangles, material slots     (mesh #1)
+//   ...
+//
+// Integers are stored in the native byte order of the machine that wrote the
+// file. Offsets in a mesh header are relative to the beginning of the header.
+// Names and material slots are stored as null-terminated strings.
+//
+
+class MappedMeshFile
+  : public NonCopyable
+{
+  public:
+    // Version of the MappedMesh file format.
+    static const uint16 Version = 1;
+
+    // Alignment in bytes of the mesh headers and of all arrays.
+    static const size_t Alignment = 64;
+
+    // Value written in file headers to detect byte order mismatches.
+    static const uint32 ByteOrderMark = 0x01020304;
+
+    struct FileHeader
+    {
+        char        m_signature[10];            // "MAPPEDMESH"
+        uint16      m_version;
+        uint32      m_byte_order_mark;
+        uint64      m_first_mesh_offset;
+        uint8       m_reserved[40];
+    };
+
+    struct MeshHeader
+    {
+        uint64      m_size;                     // total size of the mesh including this header
+        uint64      m_name_offset;
+        uint64      m_name_length;              // excluding the terminating null character
+        uint64      m_vertex_offset;
+        uint64      m_vertex_count;
+        uint64      m_vertex_normal_offset;
+        uint64      m_vertex_normal_count;
+        uint64      m_tex_coords_offset;
+        uint64      m_tex_coords_count;
+        uint64      m_triangle_offset;
+        uint64      m_triangle_count;
+        uint64      m_material_slot_offset;
+        uint64      m_material_slot_count;
+        uint64      m_material_slot_size;       // size in bytes of all material slot strings
+        uint64      m_reserved[2];
+    };
+
+    struct Triangle
+    {
+        // Special index value used to indicate that a feature is not present.
+        static const uint32 None = ~uint32(0);
+
+        uint32      m_v0, m_v1, m_v2;           // vertex indices
+        uint32      m_n0, m_n1, m_n2;           // vertex normal indices
+        uint32      m_a0, m_a1, m_a2;           // texture coordinates indices
+        uint32      m_material;                 // material slot index
+    };
+
+    // A view of a mesh inside the mapped file.
+    // The arrays may be modified in place (see foundation::MemoryMappedFile).
+    struct Mesh
+    {
+        const char*                 m_name;
+        Vector3f*                   m_vertices;
+        size_t                      m_vertex_count;
+        Vector3f*                   m_vertex_normals;
+        size_t                      m_vertex_normal_count;
+        Vector2f*                   m_tex_coords;
+        size_t                      m_tex_coords_count;
+        Triangle*                   m_triangles;
+        size_t                      m_triangle_count;
+        std::vector<const char*>    m_material_slots;
+    };
+
+    // Return the file signature.
+    static const char* get_signature();
+
+    // Map a mesh file into memory and check its structure. Throws foundation::ExceptionCannotMapFile
+    // if the file cannot be mapped, or foundation::ExceptionIOError if it is not a valid MappedMesh file.
+    explicit MappedMeshFile(const char* filename);
+
+    // Access the meshes of the file.
+    size_t get_mesh_count() const;
+    const Mesh& get_mesh(const size_t index) const;
+
+  private:
+    MemoryMappedFile    m_file;
+    std::vector<Mesh>   m_meshes;
+};
+
+
+//
+// MappedMeshFile class implementation.
+//
+
+inline size_t MappedMeshFile::get_mesh_count() const
+{
+    return m_meshes.size();
+}
+
+inline const MappedMeshFile::Mesh& MappedMeshFile::get_mesh(const size_t index) const
+{
+    return m_meshes[index];
+}
+
+}   // namespace foundation
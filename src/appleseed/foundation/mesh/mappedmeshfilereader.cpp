@@ -0,0 +1,108 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "mappedmeshfilereader.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/mesh/imeshbuilder.h"
+#include "foundation/mesh/mappedmeshfile.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// MappedMeshFileReader class implementation.
+//
+
+MappedMeshFileReader::MappedMeshFileReader(const string& filename)
+  : m_filename(filename)
+{
+}
+
+void MappedMeshFileReader::read(IMeshBuilder& builder)
+{
+    const MappedMeshFile file(m_filename.c_str());
+
+    for (size_t i = 0, e = file.get_mesh_count(); i < e; ++i)
+    {
+        const MappedMeshFile::Mesh& mesh = file.get_mesh(i);
+
+        builder.begin_mesh(mesh.m_name);
+
+        for (size_t j = 0; j < mesh.m_vertex_count; ++j)
+            builder.push_vertex(Vector3d(mesh.m_vertices[j]));
+
+        for (size_t j = 0; j < mesh.m_vertex_normal_count; ++j)
+            builder.push_vertex_normal(Vector3d(mesh.m_vertex_normals[j]));
+
+        for (size_t j = 0; j < mesh.m_tex_coords_count; ++j)
+            builder.push_tex_coords(Vector2d(mesh.m_tex_coords[j]));
+
+        for (size_t j = 0; j < mesh.m_material_slots.size(); ++j)
+            builder.push_material_slot(mesh.m_material_slots[j]);
+
+        for (size_t j = 0; j < mesh.m_triangle_count; ++j)
+        {
+            const MappedMeshFile::Triangle& triangle = mesh.m_triangles[j];
+
+            builder.begin_face(3);
+
+            const size_t vertices[3] = { triangle.m_v0, triangle.m_v1, triangle.m_v2 };
+            builder.set_face_vertices(vertices);
+
+            if (triangle.m_n0 != MappedMeshFile::Triangle::None)
+            {
+                const size_t normals[3] = { triangle.m_n0, triangle.m_n1, triangle.m_n2 };
+                builder.set_face_vertex_normals(normals);
+            }
+
+            if (triangle.m_a0 != MappedMeshFile::Triangle::None)
+            {
+                const size_t tex_coords[3] = { triangle.m_a0, triangle.m_a1, triangle.m_a2 };
+                builder.set_face_vertex_tex_coords(tex_coords);
+            }
+
+            if (triangle.m_material != MappedMeshFile::Triangle::None)
+                builder.set_face_material(triangle.m_material);
+
+            builder.end_face();
+        }
+
+        builder.end_mesh();
+    }
+}
+
+}   // namespace foundation
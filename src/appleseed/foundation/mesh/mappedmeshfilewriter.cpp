@@ -0,0 +1,310 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "mappedmeshfilewriter.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/math/vector.h"
+#include "foundation/mesh/imeshwalker.h"
+#include "foundation/utility/memory.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstring>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// MappedMeshFileWriter class implementation.
+//
+
+namespace
+{
+    uint64 align_offset(const uint64 offset)
+    {
+        const uint64 a = MappedMeshFile::Alignment - 1;
+        return (offset + a) & ~a;
+    }
+}
+
+MappedMeshFileWriter::MappedMeshFileWriter(const string& filename)
+  : m_filename(filename)
+  , m_mesh_position(0)
+  , m_triangulator(Triangulator<double>::KeepDegenerateTriangles)
+{
+}
+
+void MappedMeshFileWriter::write(const IMeshWalker& walker)
+{
+    if (!m_file.is_open())
+    {
+        m_file.open(
+            m_filename.c_str(),
+            BufferedFile::BinaryType,
+            BufferedFile::WriteMode);
+
+        if (!m_file.is_open())
+            throw ExceptionIOError();
+
+        write_file_header();
+    }
+
+    write_mesh(walker);
+}
+
+void MappedMeshFileWriter::write_file_header()
+{
+    MappedMeshFile::FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_signature, MappedMeshFile::get_signature(), sizeof(header.m_signature));
+    header.m_version = MappedMeshFile::Version;
+    header.m_byte_order_mark = MappedMeshFile::ByteOrderMark;
+    header.m_first_mesh_offset = sizeof(header);
+
+    checked_write(m_file, header);
+}
+
+void MappedMeshFileWriter::write_mesh(const IMeshWalker& walker)
+{
+    MappedMeshFile::MeshHeader header;
+    memset(&header, 0, sizeof(header));
+
+    // Compute the layout of the mesh.
+    uint64 offset = sizeof(header);
+
+    header.m_name_offset = offset;
+    header.m_name_length = strlen(walker.get_name());
+    offset = align_offset(offset + header.m_name_length + 1);
+
+    header.m_vertex_offset = offset;
+    header.m_vertex_count = walker.get_vertex_count();
+    offset = align_offset(offset + header.m_vertex_count * sizeof(Vector3f));
+
+    header.m_vertex_normal_offset = offset;
+    header.m_vertex_normal_count = walker.get_vertex_normal_count();
+    offset = align_offset(offset + header.m_vertex_normal_count * sizeof(Vector3f));
+
+    header.m_tex_coords_offset = offset;
+    header.m_tex_coords_count = walker.get_tex_coords_count();
+    offset = align_offset(offset + header.m_tex_coords_count * sizeof(Vector2f));
+
+    // A polygonal face with n vertices always yields n - 2 triangles.
+    header.m_triangle_offset = offset;
+    for (size_t i = 0, e = walker.get_face_count(); i < e; ++i)
+    {
+        assert(walker.get_face_vertex_count(i) >= 3);
+        header.m_triangle_count += walker.get_face_vertex_count(i) - 2;
+    }
+    offset = align_offset(offset + header.m_triangle_count * sizeof(MappedMeshFile::Triangle));
+
+    header.m_material_slot_offset = offset;
+    header.m_material_slot_count = walker.get_material_slot_count();
+    for (size_t i = 0, e = walker.get_material_slot_count(); i < e; ++i)
+        header.m_material_slot_size += strlen(walker.get_material_slot(i)) + 1;
+    offset = align_offset(offset + header.m_material_slot_size);
+
+    header.m_size = offset;
+
+    // Write the mesh.
+    m_mesh_position = 0;
+    write_value(header);
+    pad_to(header.m_name_offset);
+    write_name(walker);
+    pad_to(header.m_vertex_offset);
+    write_vertices(walker);
+    pad_to(header.m_vertex_normal_offset);
+    write_vertex_normals(walker);
+    pad_to(header.m_tex_coords_offset);
+    write_texture_coordinates(walker);
+    pad_to(header.m_triangle_offset);
+    write_triangles(walker);
+    assert(m_mesh_position == header.m_triangle_offset + header.m_triangle_count * sizeof(MappedMeshFile::Triangle));
+    pad_to(header.m_material_slot_offset);
+    write_material_slots(walker);
+    pad_to(header.m_size);
+}
+
+void MappedMeshFileWriter::write_name(const IMeshWalker& walker)
+{
+    const char* name = walker.get_name();
+    write_bytes(name, strlen(name) + 1);
+}
+
+void MappedMeshFileWriter::write_vertices(const IMeshWalker& walker)
+{
+    for (size_t i = 0, e = walker.get_vertex_count(); i < e; ++i)
+        write_value(Vector3f(walker.get_vertex(i)));
+}
+
+void MappedMeshFileWriter::write_vertex_normals(const IMeshWalker& walker)
+{
+    for (size_t i = 0, e = walker.get_vertex_normal_count(); i < e; ++i)
+    {
+        Vector3f n(walker.get_vertex_normal(i));
+
+        const float norm_n = norm(n);
+
+        if (norm_n > 0.0f)
+            n /= norm_n;
+        else n = Vector3f(1.0f, 0.0f, 0.0f);
+
+        write_value(n);
+    }
+}
+
+void MappedMeshFileWriter::write_texture_coordinates(const IMeshWalker& walker)
+{
+    for (size_t i = 0, e = walker.get_tex_coords_count(); i < e; ++i)
+        write_value(Vector2f(walker.get_tex_coords(i)));
+}
+
+void MappedMeshFileWriter::write_triangles(const IMeshWalker& walker)
+{
+    for (size_t i = 0, e = walker.get_face_count(); i < e; ++i)
+        write_face(walker, i);
+}
+
+void MappedMeshFileWriter::write_face(const IMeshWalker& walker, const size_t face_index)
+{
+    const size_t vertex_count = walker.get_face_vertex_count(face_index);
+
+    if (vertex_count == 3)
+    {
+        write_triangle(walker, face_index, 0, 1, 2);
+        return;
+    }
+
+    clear_keep_memory(m_polygon);
+    clear_keep_memory(m_triangles);
+
+    for (size_t i = 0; i < vertex_count; ++i)
+        m_polygon.push_back(walker.get_vertex(walker.get_face_vertex(face_index, i)));
+
+    if (m_triangulator.triangulate(m_polygon, m_triangles))
+    {
+        for (size_t i = 0, e = m_triangles.size(); i < e; i += 3)
+        {
+            write_triangle(
+                walker,
+                face_index,
+                m_triangles[i + 0],
+                m_triangles[i + 1],
+                m_triangles[i + 2]);
+        }
+    }
+    else
+    {
+        // The polygon could not be triangulated: insert zero-area triangles
+        // to preserve the number of triangles announced in the mesh header.
+        for (size_t i = 0; i < vertex_count - 2; ++i)
+            write_triangle(walker, face_index, 0, 0, 0);
+    }
+}
+
+void MappedMeshFileWriter::write_triangle(
+    const IMeshWalker&      walker,
+    const size_t            face_index,
+    const size_t            v0_index,
+    const size_t            v1_index,
+    const size_t            v2_index)
+{
+    MappedMeshFile::Triangle triangle;
+
+    triangle.m_v0 = static_cast<uint32>(walker.get_face_vertex(face_index, v0_index));
+    triangle.m_v1 = static_cast<uint32>(walker.get_face_vertex(face_index, v1_index));
+    triangle.m_v2 = static_cast<uint32>(walker.get_face_vertex(face_index, v2_index));
+
+    if (walker.get_vertex_normal_count() > 0)
+    {
+        triangle.m_n0 = static_cast<uint32>(walker.get_face_vertex_normal(face_index, v0_index));
+        triangle.m_n1 = static_cast<uint32>(walker.get_face_vertex_normal(face_index, v1_index));
+        triangle.m_n2 = static_cast<uint32>(walker.get_face_vertex_normal(face_index, v2_index));
+    }
+    else
+    {
+        triangle.m_n0 = MappedMeshFile::Triangle::None;
+        triangle.m_n1 = MappedMeshFile::Triangle::None;
+        triangle.m_n2 = MappedMeshFile::Triangle::None;
+    }
+
+    if (walker.get_tex_coords_count() > 0)
+    {
+        triangle.m_a0 = static_cast<uint32>(walker.get_face_tex_coords(face_index, v0_index));
+        triangle.m_a1 = static_cast<uint32>(walker.get_face_tex_coords(face_index, v1_index));
+        triangle.m_a2 = static_cast<uint32>(walker.get_face_tex_coords(face_index, v2_index));
+    }
+    else
+    {
+        triangle.m_a0 = MappedMeshFile::Triangle::None;
+        triangle.m_a1 = MappedMeshFile::Triangle::None;
+        triangle.m_a2 = MappedMeshFile::Triangle::None;
+    }
+
+    triangle.m_material = static_cast<uint32>(walker.get_face_material(face_index));
+
+    write_value(triangle);
+}
+
+void MappedMeshFileWriter::write_material_slots(const IMeshWalker& walker)
+{
+    for (size_t i = 0, e = walker.get_material_slot_count(); i < e; ++i)
+    {
+        const char* slot = walker.get_material_slot(i);
+        write_bytes(slot, strlen(slot) + 1);
+    }
+}
+
+void MappedMeshFileWriter::write_bytes(const void* bytes, const size_t size)
+{
+    checked_write(m_file, bytes, size);
+    m_mesh_position += size;
+}
+
+template <typename T>
+void MappedMeshFileWriter::write_value(const T& value)
+{
+    write_bytes(&value, sizeof(T));
+}
+
+void MappedMeshFileWriter::pad_to(const uint64 offset)
+{
+    static const uint8 Zeros[MappedMeshFile::Alignment] = { 0 };
+
+    assert(offset >= m_mesh_position);
+    assert(offset - m_mesh_position <= sizeof(Zeros));
+
+    write_bytes(Zeros, static_cast<size_t>(offset - m_mesh_position));
+}
+
+}   // namespace foundation
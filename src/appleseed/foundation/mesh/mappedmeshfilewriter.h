@@ -0,0 +1,98 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/triangulator.h"
+#include "foundation/mesh/imeshfilewriter.h"
+#include "foundation/mesh/mappedmeshfile.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/bufferedfile.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class IMeshWalker; }
+
+namespace foundation
+{
+
+//
+// Writer for the MappedMesh file format (see foundation::MappedMeshFile).
+//
+// Polygonal faces are triangulated and vertex normals are normalized
+// so that the meshes can be used as is once mapped into memory.
+//
+
+class MappedMeshFileWriter
+  : public IMeshFileWriter
+{
+  public:
+    // Constructor.
+    explicit MappedMeshFileWriter(const std::string& filename);
+
+    // Write a mesh.
+    void write(const IMeshWalker& walker) override;
+
+  private:
+    const std::string                   m_filename;
+    BufferedFile                        m_file;
+    uint64                              m_mesh_position;
+
+    Triangulator<double>                m_triangulator;
+    Triangulator<double>::Polygon3      m_polygon;
+    Triangulator<double>::IndexArray    m_triangles;
+
+    void write_file_header();
+
+    void write_mesh(const IMeshWalker& walker);
+    void write_name(const IMeshWalker& walker);
+    void write_vertices(const IMeshWalker& walker);
+    void write_vertex_normals(const IMeshWalker& walker);
+    void write_texture_coordinates(const IMeshWalker& walker);
+    void write_triangles(const IMeshWalker& walker);
+    void write_face(const IMeshWalker& walker, const size_t face_index);
+    void write_triangle(
+        const IMeshWalker&  walker,
+        const size_t        face_index,
+        const size_t        v0_index,
+        const size_t        v1_index,
+        const size_t        v2_index);
+    void write_material_slots(const IMeshWalker& walker);
+
+    void write_bytes(const void* bytes, const size_t size);
+    template <typename T> void write_value(const T& value);
+    void pad_to(const uint64 offset);
+};
+
+}   // namespace foundation
@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/alignedvector.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/log.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+BENCHMARK_SUITE(Foundation_Math_BVH_Builder)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef vector<AABB3d> AABBVector;
+    typedef bvh::Tree<NodeVector> Tree;
+
+    const size_t ItemCount = 100000;
+    const size_t MaxLeafSize = 4;
+
+    struct Fixture
+    {
+        AABBVector  m_bboxes;
+        Logger      m_logger;
+        Tree        m_tree;
+
+        Fixture()
+        {
+            MersenneTwister rng;
+
+            m_bboxes.reserve(ItemCount);
+
+            for (size_t i = 0; i < ItemCount; ++i)
+            {
+                const Vector3d center(
+                    rand_double1(rng, -100.0, 100.0),
+                    rand_double1(rng, -100.0, 100.0),
+                    rand_double1(rng, -100.0, 100.0));
+                const Vector3d extent(
+                    rand_double1(rng, 0.1, 2.0),
+                    rand_double1(rng, 0.1, 2.0),
+                    rand_double1(rng, 0.1, 2.0));
+                m_bboxes.emplace_back(center - extent, center + extent);
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(SweepSAHPartitioner, Fixture)
+    {
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(m_bboxes, MaxLeafSize);
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(m_tree, partitioner, ItemCount, MaxLeafSize);
+    }
+
+    BENCHMARK_CASE_F(BinnedSAHPartitioner, Fixture)
+    {
+        typedef bvh::BinnedSAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(m_bboxes, MaxLeafSize);
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(m_tree, partitioner, ItemCount, MaxLeafSize);
+    }
+
+    BENCHMARK_CASE_F(BinnedSAHPartitioner_ParallelBuilder, Fixture)
+    {
+        typedef bvh::BinnedSAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(m_bboxes, MaxLeafSize);
+        bvh::ParallelBuilder<Tree, Partitioner> builder(
+            m_logger,
+            System::get_logical_cpu_core_count(),
+            4 * 1024);
+        builder.build<DefaultWallclockTimer>(m_tree, partitioner, ItemCount, MaxLeafSize);
+    }
+}
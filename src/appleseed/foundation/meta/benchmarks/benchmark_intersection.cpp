@@ -29,6 +29,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
 #include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/intersection/raytrianglemt.h"
 #include "foundation/math/intersection/raytrianglessk.h"
@@ -38,11 +39,15 @@
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/timers.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/alignedvector.h"
 #include "foundation/utility/benchmark.h"
 
 // Standard headers.
 #include <cstddef>
 #include <limits>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -317,3 +322,235 @@ BENCHMARK_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
     BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs66Percents, FixtureDouble66) { payload(); }
     BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs100Percents, FixtureDouble100) { payload(); }
 };
+
+BENCHMARK_SUITE(Foundation_Math_Intersection_RayBVH)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef vector<AABB3d> AABBVector;
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        double                  m_closest;
+
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_closest(numeric_limits<double>::max())
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&   node,
+            const Ray3d&            ray,
+            const RayInfo3d&        ray_info,
+            double&                 distance)
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[m_ordering[i]], tmin) && tmin < m_closest)
+                    m_closest = tmin;
+            }
+
+            distance = m_closest;
+            return true;
+        }
+    };
+
+    struct PacketVisitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        double                  m_closest[8];
+
+        PacketVisitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+        {
+            for (size_t i = 0; i < 8; ++i)
+                m_closest[i] = numeric_limits<double>::max();
+        }
+
+        uint32 visit(
+            const Tree::NodeType&   node,
+            const uint32            ray_mask,
+            const Ray3d*            rays,
+            const RayInfo3d*        ray_infos,
+            double*                 distances)
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t r = 0; r < 8; ++r)
+            {
+                if (!(ray_mask & (1u << r)))
+                    continue;
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    double tmin;
+                    if (intersect(rays[r], ray_infos[r], m_bboxes[m_ordering[i]], tmin) && tmin < m_closest[r])
+                        m_closest[r] = tmin;
+                }
+
+                distances[r] = m_closest[r];
+            }
+
+            return ray_mask;
+        }
+    };
+
+    template <size_t Width>
+    struct Fixture
+      : public FixtureBase<double>
+    {
+        static const size_t BoxCount = 50000;
+        static const size_t RayCount = 1000;
+
+        AABBVector      m_bboxes;
+        Partitioner     m_partitioner;
+        Tree            m_tree;
+        Ray3d           m_ray[RayCount];
+        RayInfo3d       m_ray_info[RayCount];
+        double          m_distance;
+
+        Fixture()
+          : m_bboxes(generate_bboxes())
+          , m_partitioner(m_bboxes, 2)
+          , m_distance(0.0)
+        {
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, m_partitioner, BoxCount, 2);
+
+            build_wide_nodes(m_tree);
+
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < RayCount; ++i)
+                get_random_ray(rng, 20.0, m_ray[i], m_ray_info[i]);
+        }
+
+        static AABBVector generate_bboxes()
+        {
+            MersenneTwister rng;
+            AABBVector bboxes;
+            bboxes.reserve(BoxCount);
+
+            for (size_t i = 0; i < BoxCount; ++i)
+            {
+                const Vector3d center = get_random_vector<3>(rng, -10.0, 10.0);
+                const Vector3d extent = get_random_vector<3>(rng, 0.01, 0.1);
+                bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            return bboxes;
+        }
+
+        static void build_wide_nodes(Tree& tree)
+        {
+            bvh::WideBuilder<Tree, Width> builder;
+            builder.template build<DefaultWallclockTimer>(tree);
+        }
+    };
+
+    template <>
+    void Fixture<2>::build_wide_nodes(Tree&)
+    {
+    }
+
+    typedef Fixture<2> BinaryFixture;
+    typedef Fixture<4> Wide4Fixture;
+    typedef Fixture<8> Wide8Fixture;
+
+    struct CoherentFixture
+      : public Fixture<2>
+    {
+        // Rays are generated in groups of 8 leaving the same point in similar directions,
+        // similar to camera rays of neighboring pixels or shadow rays from a shading point.
+        CoherentFixture()
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < RayCount; i += 8)
+            {
+                Ray3d base_ray;
+                get_random_ray(rng, 20.0, base_ray);
+
+                for (size_t j = 0; j < 8; ++j)
+                {
+                    const Vector3d target = get_random_vector<3>(rng, -1.0, 1.0);
+                    m_ray[i + j] = Ray3d(base_ray.m_org, normalize(target - base_ray.m_org));
+                    m_ray_info[i + j] = RayInfo3d(m_ray[i + j]);
+                }
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(Intersect_BinaryNodes, BinaryFixture)
+    {
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+            bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+            intersector.intersect_no_motion(m_tree, m_ray[i], m_ray_info[i], visitor);
+            m_distance += visitor.m_closest;
+        }
+    }
+
+    BENCHMARK_CASE_F(Intersect_Wide4Nodes, Wide4Fixture)
+    {
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+            bvh::WideIntersector<Tree, Visitor, Ray3d, 4> intersector;
+            intersector.intersect_no_motion(m_tree, m_ray[i], m_ray_info[i], visitor);
+            m_distance += visitor.m_closest;
+        }
+    }
+
+    BENCHMARK_CASE_F(Intersect_Wide8Nodes, Wide8Fixture)
+    {
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+            bvh::WideIntersector<Tree, Visitor, Ray3d, 8> intersector;
+            intersector.intersect_no_motion(m_tree, m_ray[i], m_ray_info[i], visitor);
+            m_distance += visitor.m_closest;
+        }
+    }
+
+    BENCHMARK_CASE_F(Intersect_CoherentRays_OneByOne, CoherentFixture)
+    {
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+            bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+            intersector.intersect_no_motion(m_tree, m_ray[i], m_ray_info[i], visitor);
+            m_distance += visitor.m_closest;
+        }
+    }
+
+    BENCHMARK_CASE_F(Intersect_CoherentRays_InPacketsOf8, CoherentFixture)
+    {
+        for (size_t i = 0; i < RayCount; i += 8)
+        {
+            PacketVisitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+            bvh::PacketIntersector<Tree, PacketVisitor, Ray3d, 8> intersector;
+            intersector.intersect_no_motion(m_tree, &m_ray[i], &m_ray_info[i], 8, visitor);
+
+            for (size_t j = 0; j < 8; ++j)
+                m_distance += visitor.m_closest[j];
+        }
+    }
+}
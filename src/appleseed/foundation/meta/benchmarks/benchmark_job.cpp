@@ -28,18 +28,23 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
 #include "foundation/utility/benchmark.h"
 #include "foundation/utility/job.h"
 #include "foundation/utility/log.h"
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
 
 BENCHMARK_SUITE(Foundation_Utility_Job)
 {
+    // Divide the runtime of a case by JobCount to get the scheduling overhead per job.
+    const size_t JobCount = 256;
+
     struct EmptyJob
       : public IJob
     {
@@ -48,7 +53,31 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
-    template <size_t ThreadCount>
+    // A job that reschedules itself, like the progressive renderer's sample generator jobs.
+    class ReschedulingJob
+      : public IJob
+    {
+      public:
+        ReschedulingJob(
+            JobQueue&               job_queue,
+            boost::atomic<int>&     remaining_executions)
+          : m_job_queue(job_queue)
+          , m_remaining_executions(remaining_executions)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            if (m_remaining_executions-- > 0)
+                m_job_queue.schedule(this, false);
+        }
+
+      private:
+        JobQueue&                   m_job_queue;
+        boost::atomic<int>&         m_remaining_executions;
+    };
+
+    template <size_t ThreadCount, int Flags = 0>
     struct Fixture
     {
         Logger      m_logger;
@@ -56,14 +85,13 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         JobManager  m_job_manager;
 
         Fixture()
-          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue | Flags)
         {
             m_job_manager.start();
         }
 
         void payload()
         {
-            const size_t JobCount = 256;
             EmptyJob jobs[JobCount];
 
             for (size_t i = 0; i < JobCount; ++i)
@@ -71,8 +99,33 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
 
             m_job_queue.wait_until_completion();
         }
+
+        void rescheduling_payload()
+        {
+            boost::atomic<int> remaining_executions(static_cast<int>(JobCount));
+
+            vector<ReschedulingJob*> jobs;
+            for (size_t i = 0; i < ThreadCount; ++i)
+                jobs.push_back(new ReschedulingJob(m_job_queue, remaining_executions));
+
+            for (size_t i = 0; i < ThreadCount; ++i)
+                m_job_queue.schedule(jobs[i], false);
+
+            m_job_queue.wait_until_completion();
+
+            for (size_t i = 0; i < ThreadCount; ++i)
+                delete jobs[i];
+        }
     };
 
+    typedef Fixture<8> Fixture8Threads;
+    typedef Fixture<32> Fixture32Threads;
+    typedef Fixture<128> Fixture128Threads;
+
+    typedef Fixture<8, JobManager::WorkStealing> WorkStealingFixture8Threads;
+    typedef Fixture<32, JobManager::WorkStealing> WorkStealingFixture32Threads;
+    typedef Fixture<128, JobManager::WorkStealing> WorkStealingFixture128Threads;
+
     BENCHMARK_CASE_F(SingleThreadedJobExecution, Fixture<1>)
     {
         payload();
@@ -82,4 +135,64 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
     {
         payload();
     }
+
+    BENCHMARK_CASE_F(JobExecution_8Threads, Fixture8Threads)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecution_32Threads, Fixture32Threads)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecution_128Threads, Fixture128Threads)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecution_WorkStealing_8Threads, WorkStealingFixture8Threads)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecution_WorkStealing_32Threads, WorkStealingFixture32Threads)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecution_WorkStealing_128Threads, WorkStealingFixture128Threads)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(ReschedulingJobExecution_8Threads, Fixture8Threads)
+    {
+        rescheduling_payload();
+    }
+
+    BENCHMARK_CASE_F(ReschedulingJobExecution_32Threads, Fixture32Threads)
+    {
+        rescheduling_payload();
+    }
+
+    BENCHMARK_CASE_F(ReschedulingJobExecution_128Threads, Fixture128Threads)
+    {
+        rescheduling_payload();
+    }
+
+    BENCHMARK_CASE_F(ReschedulingJobExecution_WorkStealing_8Threads, WorkStealingFixture8Threads)
+    {
+        rescheduling_payload();
+    }
+
+    BENCHMARK_CASE_F(ReschedulingJobExecution_WorkStealing_32Threads, WorkStealingFixture32Threads)
+    {
+        rescheduling_payload();
+    }
+
+    BENCHMARK_CASE_F(ReschedulingJobExecution_WorkStealing_128Threads, WorkStealingFixture128Threads)
+    {
+        rescheduling_payload();
+    }
 }
@@ -0,0 +1,115 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/utility/aliasablevector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Utility_AliasableVector)
+{
+    TEST_CASE(Alias_GivenExternalBuffer_ReferencesBufferInPlace)
+    {
+        int buffer[3] = { 1, 2, 3 };
+
+        AliasableVector<int> v;
+        v.alias(buffer, 3);
+
+        EXPECT_TRUE(v.is_aliasing());
+        ASSERT_EQ(3, v.size());
+        EXPECT_EQ(buffer, v.data());
+
+        v[1] = 42;
+
+        EXPECT_EQ(42, buffer[1]);
+    }
+
+    TEST_CASE(PushBack_GivenAliasingVector_CopiesElementsAndLeavesBufferUntouched)
+    {
+        int buffer[3] = { 1, 2, 3 };
+
+        AliasableVector<int> v;
+        v.alias(buffer, 3);
+        v.push_back(4);
+
+        EXPECT_FALSE(v.is_aliasing());
+        ASSERT_EQ(4, v.size());
+        EXPECT_EQ(1, v[0]);
+        EXPECT_EQ(4, v[3]);
+
+        v[0] = 42;
+
+        EXPECT_EQ(1, buffer[0]);
+    }
+
+    TEST_CASE(Clear_GivenAliasingVector_StopsAliasing)
+    {
+        int buffer[3] = { 1, 2, 3 };
+
+        AliasableVector<int> v;
+        v.alias(buffer, 3);
+        v.clear();
+
+        EXPECT_FALSE(v.is_aliasing());
+        EXPECT_TRUE(v.empty());
+    }
+
+    TEST_CASE(CopyConstructor_GivenOwningVector_CopiesElements)
+    {
+        AliasableVector<int> v;
+        v.push_back(1);
+        v.push_back(2);
+
+        AliasableVector<int> copy(v);
+        copy[0] = 42;
+
+        ASSERT_EQ(2, copy.size());
+        EXPECT_EQ(1, v[0]);
+        EXPECT_EQ(2, copy[1]);
+    }
+
+    TEST_CASE(RangeBasedFor_IteratesOverAllElements)
+    {
+        int buffer[3] = { 1, 2, 3 };
+
+        AliasableVector<int> v;
+        v.alias(buffer, 3);
+
+        int sum = 0;
+        for (const int x : v)
+            sum += x;
+
+        EXPECT_EQ(6, sum);
+    }
+}
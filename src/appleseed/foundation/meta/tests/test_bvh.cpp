@@ -30,14 +30,23 @@
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/vector.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/platform/timers.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
+#include <limits>
 #include <vector>
 
 using namespace foundation;
@@ -121,6 +130,599 @@ TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
     }
 }
 
+TEST_SUITE(Foundation_Math_BVH_ParallelBuilder)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef vector<AABB3d> AABBVector;
+
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::BinnedSAHPartitioner<AABBVector> Partitioner;
+
+    void generate_bboxes(AABBVector& bboxes, const size_t count)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Vector3d center(
+                rand_double1(rng, -100.0, 100.0),
+                rand_double1(rng, -100.0, 100.0),
+                rand_double1(rng, -100.0, 100.0));
+            const Vector3d extent(
+                rand_double1(rng, 0.1, 2.0),
+                rand_double1(rng, 0.1, 2.0),
+                rand_double1(rng, 0.1, 2.0));
+            bboxes.emplace_back(center - extent, center + extent);
+        }
+    }
+
+    TEST_CASE(Build_ProducesSameTreeAsSingleThreadedBuilder)
+    {
+        const size_t ItemCount = 4096;
+
+        AABBVector bboxes;
+        generate_bboxes(bboxes, ItemCount);
+
+        Tree reference_tree;
+        Partitioner reference_partitioner(bboxes, 4);
+        bvh::Builder<Tree, Partitioner> reference_builder;
+        reference_builder.build<DefaultWallclockTimer>(reference_tree, reference_partitioner, ItemCount, 4);
+
+        Logger logger;
+        Tree tree;
+        Partitioner partitioner(bboxes, 4);
+        bvh::ParallelBuilder<Tree, Partitioner> builder(logger, 4, 64);
+        builder.build<DefaultWallclockTimer>(tree, partitioner, ItemCount, 4);
+
+        EXPECT_GT(0, builder.get_parallel_subtree_count());
+        EXPECT_EQ(reference_partitioner.get_item_ordering(), partitioner.get_item_ordering());
+
+        const AABB3d root_bbox(reference_partitioner.compute_bbox(0, ItemCount));
+        EXPECT_FEQ(
+            bvh::TreeSAHCost<Tree>::evaluate(reference_tree, root_bbox),
+            bvh::TreeSAHCost<Tree>::evaluate(tree, root_bbox));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Refitter)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef vector<AABB3d> AABBVector;
+
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    struct Fixture
+    {
+        AABBVector  m_bboxes;           // in tree order
+        Tree        m_tree;
+
+        Fixture()
+        {
+            const size_t ItemCount = 1000;
+
+            MersenneTwister rng;
+            AABBVector bboxes;
+
+            for (size_t i = 0; i < ItemCount; ++i)
+            {
+                const Vector3d center = rand_vector1<Vector3d>(rng) * 100.0;
+                bboxes.emplace_back(center - Vector3d(1.0), center + Vector3d(1.0));
+            }
+
+            Partitioner partitioner(bboxes, 2);
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, ItemCount, 2);
+
+            const vector<size_t>& ordering = partitioner.get_item_ordering();
+            for (size_t i = 0; i < ItemCount; ++i)
+                m_bboxes.push_back(bboxes[ordering[i]]);
+        }
+    };
+
+    TEST_CASE_F(Refit_GivenUnchangedItems_PreservesSAHCost, Fixture)
+    {
+        const Tree reference_tree = m_tree;
+
+        bvh::Refitter<Tree, AABBVector> refitter;
+        refitter.refit<DefaultWallclockTimer>(m_tree, m_bboxes);
+
+        EXPECT_EQ(
+            bvh::TreeSAHCost<Tree>::evaluate(reference_tree, refitter.get_root_bbox()),
+            bvh::TreeSAHCost<Tree>::evaluate(m_tree, refitter.get_root_bbox()));
+    }
+
+    TEST_CASE_F(Refit_GivenTranslatedItems_TranslatesRootBoundingBox, Fixture)
+    {
+        const Vector3d Offset(10.0, -20.0, 30.0);
+
+        bvh::Refitter<Tree, AABBVector> refitter;
+        refitter.refit<DefaultWallclockTimer>(m_tree, m_bboxes);
+        const AABB3d root_bbox = refitter.get_root_bbox();
+        const double sah_cost = bvh::TreeSAHCost<Tree>::evaluate(m_tree, root_bbox);
+
+        for (size_t i = 0; i < m_bboxes.size(); ++i)
+        {
+            m_bboxes[i].min += Offset;
+            m_bboxes[i].max += Offset;
+        }
+
+        refitter.refit<DefaultWallclockTimer>(m_tree, m_bboxes);
+
+        EXPECT_FEQ(root_bbox.min + Offset, refitter.get_root_bbox().min);
+        EXPECT_FEQ(root_bbox.max + Offset, refitter.get_root_bbox().max);
+        EXPECT_FEQ(sah_cost, bvh::TreeSAHCost<Tree>::evaluate(m_tree, refitter.get_root_bbox()));
+    }
+
+    TEST_CASE_F(Refit_GivenScatteredItems_IncreasesSAHCost, Fixture)
+    {
+        bvh::Refitter<Tree, AABBVector> refitter;
+        refitter.refit<DefaultWallclockTimer>(m_tree, m_bboxes);
+        const double sah_cost = bvh::TreeSAHCost<Tree>::evaluate(m_tree, refitter.get_root_bbox());
+
+        // Swap items from both ends of the tree ordering.
+        for (size_t i = 0, e = m_bboxes.size(); i < e / 4; ++i)
+            swap(m_bboxes[i], m_bboxes[e - 1 - i]);
+
+        refitter.refit<DefaultWallclockTimer>(m_tree, m_bboxes);
+
+        EXPECT_GT(sah_cost, bvh::TreeSAHCost<Tree>::evaluate(m_tree, refitter.get_root_bbox()));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_WideIntersector)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef vector<AABB3d> AABBVector;
+
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        double                  m_closest;
+
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_closest(numeric_limits<double>::max())
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&   node,
+            const Ray3d&            ray,
+            const RayInfo3d&        ray_info,
+            double&                 distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[m_ordering[i]], tmin) && tmin < m_closest)
+                    m_closest = tmin;
+            }
+
+            distance = m_closest;
+            return true;
+        }
+    };
+
+    struct Fixture
+    {
+        static const size_t BoxCount = 2000;
+        static const size_t RayCount = 1000;
+
+        AABBVector      m_bboxes;
+        Partitioner     m_partitioner;
+        Tree            m_tree;
+        vector<Ray3d>   m_rays;
+        vector<double>  m_expected_distances;
+
+        Fixture()
+          : m_bboxes(generate_bboxes())
+          , m_partitioner(m_bboxes, 2)
+        {
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, m_partitioner, BoxCount, 2);
+
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                const Vector3d org = 20.0 * sample_sphere_uniform(rand_vector2<Vector2d>(rng));
+                const Vector3d target(
+                    rand_double1(rng, -5.0, 5.0),
+                    rand_double1(rng, -5.0, 5.0),
+                    rand_double1(rng, -5.0, 5.0));
+                m_rays.emplace_back(org, normalize(target - org));
+            }
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                const RayInfo3d ray_info(m_rays[i]);
+                Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+                bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+                intersector.intersect_no_motion(
+                    m_tree,
+                    m_rays[i],
+                    ray_info,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_stats
+#endif
+                    );
+                m_expected_distances.push_back(visitor.m_closest);
+            }
+        }
+
+        static AABBVector generate_bboxes()
+        {
+            MersenneTwister rng;
+            AABBVector bboxes;
+
+            for (size_t i = 0; i < BoxCount; ++i)
+            {
+                const Vector3d center(
+                    rand_double1(rng, -10.0, 10.0),
+                    rand_double1(rng, -10.0, 10.0),
+                    rand_double1(rng, -10.0, 10.0));
+                const Vector3d extent(
+                    rand_double1(rng, 0.1, 0.5),
+                    rand_double1(rng, 0.1, 0.5),
+                    rand_double1(rng, 0.1, 0.5));
+                bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            return bboxes;
+        }
+
+        template <size_t Width>
+        size_t count_mismatches()
+        {
+            bvh::WideBuilder<Tree, Width> builder;
+            builder.template build<DefaultWallclockTimer>(m_tree);
+
+            size_t mismatches = 0;
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                const RayInfo3d ray_info(m_rays[i]);
+                Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+                bvh::WideIntersector<Tree, Visitor, Ray3d, Width> intersector;
+                intersector.intersect_no_motion(
+                    m_tree,
+                    m_rays[i],
+                    ray_info,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_stats
+#endif
+                    );
+
+                if (visitor.m_closest != m_expected_distances[i])
+                    ++mismatches;
+            }
+
+            return mismatches;
+        }
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics m_stats;
+#endif
+    };
+
+    TEST_CASE_F(IntersectNoMotion_Width4_FindsSameHitsAsBinaryIntersector, Fixture)
+    {
+        EXPECT_EQ(0, count_mismatches<4>());
+        EXPECT_EQ(4, m_tree.get_node_width());
+    }
+
+    TEST_CASE_F(IntersectNoMotion_Width8_FindsSameHitsAsBinaryIntersector, Fixture)
+    {
+        EXPECT_EQ(0, count_mismatches<8>());
+        EXPECT_EQ(8, m_tree.get_node_width());
+    }
+
+    TEST_CASE(IntersectNoMotion_RootIsLeaf_VisitsLeaf)
+    {
+        AABBVector bboxes;
+        bboxes.emplace_back(Vector3d(-1.0), Vector3d(1.0));
+
+        Tree tree;
+        Partitioner partitioner(bboxes, 2);
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 2);
+
+        bvh::WideBuilder<Tree, 4> wide_builder;
+        wide_builder.build<DefaultWallclockTimer>(tree);
+
+        const Ray3d ray(Vector3d(0.0, 0.0, -5.0), Vector3d(0.0, 0.0, 1.0));
+        const RayInfo3d ray_info(ray);
+        Visitor visitor(bboxes, partitioner.get_item_ordering());
+        bvh::WideIntersector<Tree, Visitor, Ray3d, 4> intersector;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+        intersector.intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+
+        EXPECT_FEQ(4.0, visitor.m_closest);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_PacketIntersector)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef vector<AABB3d> AABBVector;
+
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    const size_t PacketSize = 8;
+
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        double                  m_closest;
+
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_closest(numeric_limits<double>::max())
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&   node,
+            const Ray3d&            ray,
+            const RayInfo3d&        ray_info,
+            double&                 distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[m_ordering[i]], tmin) && tmin < m_closest)
+                    m_closest = tmin;
+            }
+
+            distance = m_closest;
+            return true;
+        }
+    };
+
+    struct PacketVisitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        const bool              m_probe;
+        double                  m_closest[PacketSize];
+
+        PacketVisitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            const bool              probe)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_probe(probe)
+        {
+            for (size_t i = 0; i < PacketSize; ++i)
+                m_closest[i] = numeric_limits<double>::max();
+        }
+
+        uint32 visit(
+            const Tree::NodeType&   node,
+            const uint32            ray_mask,
+            const Ray3d*            rays,
+            const RayInfo3d*        ray_infos,
+            double*                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            uint32 continue_mask = ray_mask;
+
+            for (size_t r = 0; r < PacketSize; ++r)
+            {
+                if (!(ray_mask & (1u << r)))
+                    continue;
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    double tmin;
+                    if (intersect(rays[r], ray_infos[r], m_bboxes[m_ordering[i]], tmin) && tmin < m_closest[r])
+                    {
+                        m_closest[r] = tmin;
+
+                        // Probe rays stop at the first hit.
+                        if (m_probe)
+                            continue_mask &= ~(1u << r);
+                    }
+                }
+
+                distances[r] = m_closest[r];
+            }
+
+            return continue_mask;
+        }
+    };
+
+    struct Fixture
+    {
+        static const size_t BoxCount = 2000;
+        static const size_t PacketCount = 200;
+
+        AABBVector          m_bboxes;
+        Partitioner         m_partitioner;
+        Tree                m_tree;
+        vector<Ray3d>       m_rays;
+        vector<RayInfo3d>   m_ray_infos;
+        vector<double>      m_expected_distances;
+
+        Fixture()
+          : m_bboxes(generate_bboxes())
+          , m_partitioner(m_bboxes, 2)
+        {
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, m_partitioner, BoxCount, 2);
+
+            MersenneTwister rng;
+
+            // Generate packets of rays leaving the same point in similar directions.
+            for (size_t i = 0; i < PacketCount; ++i)
+            {
+                const Vector3d org = 20.0 * sample_sphere_uniform(rand_vector2<Vector2d>(rng));
+                const Vector3d target(
+                    rand_double1(rng, -5.0, 5.0),
+                    rand_double1(rng, -5.0, 5.0),
+                    rand_double1(rng, -5.0, 5.0));
+
+                for (size_t j = 0; j < PacketSize; ++j)
+                {
+                    const Vector3d jitter(
+                        rand_double1(rng, -1.0, 1.0),
+                        rand_double1(rng, -1.0, 1.0),
+                        rand_double1(rng, -1.0, 1.0));
+                    m_rays.emplace_back(org, normalize(target + jitter - org));
+                    m_ray_infos.emplace_back(m_rays.back());
+                }
+            }
+
+            for (size_t i = 0; i < m_rays.size(); ++i)
+            {
+                Visitor visitor(m_bboxes, m_partitioner.get_item_ordering());
+                bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+                intersector.intersect_no_motion(
+                    m_tree,
+                    m_rays[i],
+                    m_ray_infos[i],
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_stats
+#endif
+                    );
+                m_expected_distances.push_back(visitor.m_closest);
+            }
+        }
+
+        static AABBVector generate_bboxes()
+        {
+            MersenneTwister rng;
+            AABBVector bboxes;
+
+            for (size_t i = 0; i < BoxCount; ++i)
+            {
+                const Vector3d center(
+                    rand_double1(rng, -10.0, 10.0),
+                    rand_double1(rng, -10.0, 10.0),
+                    rand_double1(rng, -10.0, 10.0));
+                const Vector3d extent(
+                    rand_double1(rng, 0.1, 0.5),
+                    rand_double1(rng, 0.1, 0.5),
+                    rand_double1(rng, 0.1, 0.5));
+                bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            return bboxes;
+        }
+
+        size_t count_mismatches(const size_t ray_count, const bool probe)
+        {
+            size_t mismatches = 0;
+
+            for (size_t i = 0; i < m_rays.size(); i += PacketSize)
+            {
+                PacketVisitor visitor(m_bboxes, m_partitioner.get_item_ordering(), probe);
+                bvh::PacketIntersector<Tree, PacketVisitor, Ray3d, PacketSize> intersector;
+                intersector.intersect_no_motion(
+                    m_tree,
+                    &m_rays[i],
+                    &m_ray_infos[i],
+                    ray_count,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_stats
+#endif
+                    );
+
+                for (size_t j = 0; j < PacketSize; ++j)
+                {
+                    const double expected =
+                        j < ray_count
+                            ? m_expected_distances[i + j]
+                            : numeric_limits<double>::max();
+
+                    const bool mismatch =
+                        probe
+                            ? (visitor.m_closest[j] < numeric_limits<double>::max()) !=
+                              (expected < numeric_limits<double>::max())
+                            : visitor.m_closest[j] != expected;
+
+                    if (mismatch)
+                        ++mismatches;
+                }
+            }
+
+            return mismatches;
+        }
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics m_stats;
+#endif
+    };
+
+    TEST_CASE_F(IntersectNoMotion_FullPackets_FindsSameHitsAsIntersector, Fixture)
+    {
+        EXPECT_EQ(0, count_mismatches(PacketSize, false));
+    }
+
+    TEST_CASE_F(IntersectNoMotion_PartialPackets_FindsSameHitsAsIntersector, Fixture)
+    {
+        EXPECT_EQ(0, count_mismatches(3, false));
+    }
+
+    TEST_CASE_F(IntersectNoMotion_SingleRayPackets_FindsSameHitsAsIntersector, Fixture)
+    {
+        EXPECT_EQ(0, count_mismatches(1, false));
+    }
+
+    TEST_CASE_F(IntersectNoMotion_ProbePackets_FindsSameHitsAsIntersector, Fixture)
+    {
+        EXPECT_EQ(0, count_mismatches(PacketSize, true));
+    }
+}
+
 TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
 {
     typedef bvh::Node<AABB2d> NodeType;
@@ -159,3 +159,55 @@ TEST_SUITE(Foundation_Math_BVH_MiddlePartitioner)
         EXPECT_EQ(3, pivot2);
     }
 }
+
+TEST_SUITE(Foundation_Math_BVH_BinnedSAHPartitioner)
+{
+    typedef std::vector<AABB3d> AABB3dVector;
+
+    TEST_CASE(Partition_TwoClustersAlongX_SeparatesClusters)
+    {
+        AABB3dVector bboxes;
+        bboxes.emplace_back(Vector3d( 10.0, 0.0, 0.0), Vector3d( 11.0, 1.0, 1.0));
+        bboxes.emplace_back(Vector3d(-11.0, 0.0, 0.0), Vector3d(-10.0, 1.0, 1.0));
+        bboxes.emplace_back(Vector3d( 11.0, 0.0, 0.0), Vector3d( 12.0, 1.0, 1.0));
+        bboxes.emplace_back(Vector3d(-12.0, 0.0, 0.0), Vector3d(-11.0, 1.0, 1.0));
+
+        BinnedSAHPartitioner<AABB3dVector> partitioner(bboxes, 1, 8);
+        const AABB3d root_bbox(partitioner.compute_bbox(0, bboxes.size()));
+
+        const size_t pivot = partitioner.partition(0, bboxes.size(), root_bbox);
+
+        ASSERT_EQ(2, pivot);
+        EXPECT_GT(0.0, partitioner.compute_bbox(pivot, bboxes.size()).min.x);
+        EXPECT_LT(0.0, partitioner.compute_bbox(0, pivot).max.x);
+    }
+
+    TEST_CASE(Partition_FewerItemsThanMaxLeafSize_ReturnsEnd)
+    {
+        AABB3dVector bboxes;
+        bboxes.emplace_back(Vector3d(0.0, 0.0, 0.0), Vector3d(1.0, 1.0, 1.0));
+        bboxes.emplace_back(Vector3d(4.0, 0.0, 0.0), Vector3d(5.0, 1.0, 1.0));
+
+        BinnedSAHPartitioner<AABB3dVector> partitioner(bboxes, 2);
+        const AABB3d root_bbox(partitioner.compute_bbox(0, bboxes.size()));
+
+        const size_t pivot = partitioner.partition(0, bboxes.size(), root_bbox);
+
+        EXPECT_EQ(bboxes.size(), pivot);
+    }
+
+    TEST_CASE(Partition_BBoxesOverlapping_ReturnsEnd)
+    {
+        AABB3dVector bboxes;
+        bboxes.emplace_back(Vector3d(-1.0), Vector3d(1.0));
+        bboxes.emplace_back(Vector3d(-1.0), Vector3d(1.0));
+        bboxes.emplace_back(Vector3d(-1.0), Vector3d(1.0));
+
+        BinnedSAHPartitioner<AABB3dVector> partitioner(bboxes, 1);
+        const AABB3d root_bbox(partitioner.compute_bbox(0, bboxes.size()));
+
+        const size_t pivot = partitioner.partition(0, bboxes.size(), root_bbox);
+
+        EXPECT_EQ(bboxes.size(), pivot);
+    }
+}
@@ -189,6 +189,30 @@ TEST_SUITE(Foundation_Utility_Cache_LRUCache)
         cache.get(9);   // flushes 6, cache contains 9
         ASSERT_EQ(9000, element_swapper.m_memory_size);
     }
+
+    bool is_odd(const Key key)
+    {
+        return (key & 1) != 0;
+    }
+
+    TEST_CASE(RemoveIf_UnloadsAndRemovesMatchingElements)
+    {
+        KeyHasher key_hasher;
+        ElementSwapperTrackingSize element_swapper;
+        LRUCache<Key, KeyHasher, Element, ElementSwapperTrackingSize> cache(key_hasher, element_swapper);
+
+        cache.get(1);
+        cache.get(2);
+        cache.get(3);
+
+        EXPECT_EQ(2, cache.remove_if(is_odd));
+        EXPECT_EQ(2000, element_swapper.m_memory_size);
+
+        // Removed elements are loaded again on the next access.
+        cache.get(1);
+        EXPECT_EQ(3000, element_swapper.m_memory_size);
+        EXPECT_EQ(4, cache.get_miss_count());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Cache_DualStageCache)
@@ -0,0 +1,180 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/compressedtile.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Image_CompressedTile)
+{
+    TEST_CASE(IsCompressible_GivenFloatTile_ReturnsFalse)
+    {
+        const Tile tile(8, 8, 3, PixelFormatFloat);
+
+        EXPECT_FALSE(CompressedTile::is_compressible(tile, ColorSpaceLinearRGB));
+    }
+
+    TEST_CASE(IsCompressible_GivenCIEXYZTile_ReturnsFalse)
+    {
+        const Tile tile(8, 8, 3, PixelFormatUInt8);
+
+        EXPECT_FALSE(CompressedTile::is_compressible(tile, ColorSpaceCIEXYZ));
+    }
+
+    TEST_CASE(GetPixel_GivenUniformRGBTile_ReturnsOriginalColor)
+    {
+        Tile tile(6, 5, 3, PixelFormatUInt8);
+        tile.clear(Color<uint8, 3>(255, 0, 255));
+
+        const CompressedTile compressed(tile, ColorSpaceLinearRGB);
+
+        Color4f c;
+        compressed.get_pixel(0, 0, c);
+        EXPECT_FEQ(Color4f(1.0f, 0.0f, 1.0f, 1.0f), c);
+        compressed.get_pixel(5, 4, c);
+        EXPECT_FEQ(Color4f(1.0f, 0.0f, 1.0f, 1.0f), c);
+    }
+
+    TEST_CASE(GetPixel_GivenGreyGradient_ReturnsValuesWithinQuantizationError)
+    {
+        Tile tile(8, 8, 1, PixelFormatUInt8);
+
+        for (size_t y = 0; y < 8; ++y)
+        {
+            for (size_t x = 0; x < 8; ++x)
+                tile.set_component(x, y, 0, static_cast<uint8>(x * 16 + y));
+        }
+
+        const CompressedTile compressed(tile, ColorSpaceLinearRGB);
+
+        for (size_t y = 0; y < 8; ++y)
+        {
+            for (size_t x = 0; x < 8; ++x)
+            {
+                Color4f c;
+                compressed.get_pixel(x, y, c);
+
+                const float expected = (x * 16 + y) / 255.0f;
+                EXPECT_LT(0.02f, abs(c.r - expected));
+                EXPECT_EQ(c.r, c.g);
+                EXPECT_EQ(1.0f, c.a);
+            }
+        }
+    }
+
+    TEST_CASE(GetPixel_GivenSRGBTile_ConvertsToLinearRGB)
+    {
+        Tile tile(4, 4, 4, PixelFormatUInt8);
+        tile.clear(Color<uint8, 4>(128, 128, 128, 51));
+
+        const CompressedTile compressed(tile, ColorSpaceSRGB);
+
+        Color4f c;
+        compressed.get_pixel(2, 2, c);
+
+        // The 5:6:5 endpoints quantize 128 to 132 for red and blue, and to 130 for green.
+        EXPECT_FEQ_EPS(srgb_to_linear_rgb(132.0f / 255.0f), c.r, 1.0e-6f);
+        EXPECT_FEQ_EPS(srgb_to_linear_rgb(130.0f / 255.0f), c.g, 1.0e-6f);
+        EXPECT_FEQ_EPS(0.2f, c.a, 1.0e-6f);
+    }
+
+    TEST_CASE(GetPixel_GivenGradientBetweenDifferentHues_ReturnsColorsWithinQuantizationError)
+    {
+        // Colors evenly spaced from orange to blue, which the four colors of a block can represent.
+        // The corners of the bounding box of these colors are unrelated to any of them.
+        const Color3f Colors[4] =
+        {
+            Color3f(240.0f,  96.0f,  16.0f),
+            Color3f(168.0f,  88.0f,  88.0f),
+            Color3f( 96.0f,  80.0f, 160.0f),
+            Color3f( 24.0f,  72.0f, 232.0f)
+        };
+
+        Tile tile(4, 4, 3, PixelFormatUInt8);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const Color3f& color = Colors[(i * 7) % 4];
+            tile.set_pixel(i, Color<uint8, 3>(color));
+        }
+
+        const CompressedTile compressed(tile, ColorSpaceLinearRGB);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            Color4f c;
+            compressed.get_pixel(i % 4, i / 4, c);
+
+            // Error of 5:6:5 endpoints and of the rounding of interpolated colors.
+            const Color3f expected = Colors[(i * 7) % 4] / 255.0f;
+            EXPECT_LT(10.0f / 255, abs(c.r - expected.r));
+            EXPECT_LT(10.0f / 255, abs(c.g - expected.g));
+            EXPECT_LT(10.0f / 255, abs(c.b - expected.b));
+        }
+    }
+
+    TEST_CASE(GetMemorySize_GivenRGBTile_ReturnsAboutSixTimesLessThanTile)
+    {
+        const Tile tile(64, 64, 3, PixelFormatUInt8);
+
+        const CompressedTile compressed(tile, ColorSpaceLinearRGB);
+
+        EXPECT_EQ(64 * 64 * 3 / 6, compressed.get_memory_size() - sizeof(CompressedTile));
+    }
+
+    TEST_CASE(Decompress_ReturnsFloatTileWithDecodedPixels)
+    {
+        Tile tile(4, 4, 3, PixelFormatUInt8);
+        tile.clear(Color<uint8, 3>(0, 255, 0));
+
+        const CompressedTile compressed(tile, ColorSpaceLinearRGB);
+        const unique_ptr<Tile> decompressed(compressed.decompress());
+
+        EXPECT_EQ(PixelFormatFloat, decompressed->get_pixel_format());
+        EXPECT_EQ(3, decompressed->get_channel_count());
+
+        Color3f c;
+        decompressed->get_pixel(3, 3, c);
+        EXPECT_FEQ(Color3f(0.0f, 1.0f, 0.0f), c);
+    }
+}
@@ -0,0 +1,174 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/diskcache.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+namespace bf = boost::filesystem;
+
+TEST_SUITE(Foundation_Utility_DiskCache)
+{
+    const uint32 Format = 42;
+
+    string make_empty_directory(const char* name)
+    {
+        const string directory = string("unit tests/outputs/") + name;
+        bf::remove_all(directory);
+        return directory;
+    }
+
+    string find_entry_path(const string& directory)
+    {
+        for (bf::directory_iterator i(directory), e; i != e; ++i)
+        {
+            if (i->path().extension() == ".cache")
+                return i->path().string();
+        }
+
+        return string();
+    }
+
+    bool store_bytes(DiskCache& cache, const uint64 key, const vector<uint8>& bytes)
+    {
+        const DiskCache::Section section(&bytes[0], bytes.size());
+        return cache.store(key, Format, &section, 1);
+    }
+
+    TEST_CASE(Load_GivenMissingEntry_ReturnsNullptr)
+    {
+        DiskCache cache(make_empty_directory("test_diskcache_missing").c_str(), 1024 * 1024);
+
+        const unique_ptr<DiskCache::Entry> entry = cache.load(1, Format);
+
+        EXPECT_TRUE(entry.get() == nullptr);
+    }
+
+    TEST_CASE(Load_GivenStoredEntry_ReturnsIdenticalSections)
+    {
+        DiskCache cache(make_empty_directory("test_diskcache_roundtrip").c_str(), 1024 * 1024);
+
+        const uint32 values[] = { 1, 2, 3, 4, 5 };
+        const char text[] = "section";
+        const DiskCache::Section sections[] =
+        {
+            DiskCache::Section(values, sizeof(values)),
+            DiskCache::Section(nullptr, 0),
+            DiskCache::Section(text, sizeof(text))
+        };
+        ASSERT_TRUE(cache.store(7, Format, sections, 3));
+
+        const unique_ptr<DiskCache::Entry> entry = cache.load(7, Format);
+
+        ASSERT_TRUE(entry.get() != nullptr);
+        ASSERT_EQ(3, entry->get_section_count());
+        ASSERT_EQ(sizeof(values), entry->get_section(0).m_size);
+        EXPECT_EQ(0, memcmp(values, entry->get_section(0).m_data, sizeof(values)));
+        EXPECT_EQ(0, entry->get_section(1).m_size);
+        ASSERT_EQ(sizeof(text), entry->get_section(2).m_size);
+        EXPECT_EQ(0, memcmp(text, entry->get_section(2).m_data, sizeof(text)));
+        EXPECT_EQ(0, reinterpret_cast<size_t>(entry->get_section(2).m_data) % 64);
+    }
+
+    TEST_CASE(Load_GivenEntryStoredWithDifferentFormat_ReturnsNullptr)
+    {
+        DiskCache cache(make_empty_directory("test_diskcache_format").c_str(), 1024 * 1024);
+        ASSERT_TRUE(store_bytes(cache, 7, vector<uint8>(100, 1)));
+
+        const unique_ptr<DiskCache::Entry> entry = cache.load(7, Format + 1);
+
+        EXPECT_TRUE(entry.get() == nullptr);
+    }
+
+    TEST_CASE(Load_GivenCorruptedEntry_ReturnsNullptrAndDeletesEntry)
+    {
+        const string directory = make_empty_directory("test_diskcache_corrupted");
+        DiskCache cache(directory.c_str(), 1024 * 1024);
+        ASSERT_TRUE(store_bytes(cache, 7, vector<uint8>(100, 1)));
+
+        // Flip the last byte of the section.
+        const string path = find_entry_path(directory);
+        {
+            FILE* file = fopen(path.c_str(), "r+b");
+            ASSERT_TRUE(file != nullptr);
+            fseek(file, 64 + 16 + 99, SEEK_SET);
+            fputc(2, file);
+            fclose(file);
+        }
+
+        const unique_ptr<DiskCache::Entry> entry = cache.load(7, Format);
+
+        EXPECT_TRUE(entry.get() == nullptr);
+        EXPECT_FALSE(bf::exists(path));
+    }
+
+    TEST_CASE(Store_GivenEntriesExceedingMaxSize_EvictsLeastRecentlyUsedEntries)
+    {
+        const string directory = make_empty_directory("test_diskcache_eviction");
+        DiskCache cache(directory.c_str(), 5000);
+
+        // Each entry occupies 2048 + 128 bytes on disk.
+        const vector<uint8> bytes(2048, 1);
+        ASSERT_TRUE(store_bytes(cache, 1, bytes));
+        ASSERT_TRUE(store_bytes(cache, 2, bytes));
+        bf::last_write_time(find_entry_path(directory), 0);    // make the first entry found the oldest one
+
+        ASSERT_TRUE(store_bytes(cache, 3, bytes));
+
+        size_t entry_count = 0;
+        for (uint64 key = 1; key <= 3; ++key)
+        {
+            if (cache.load(key, Format).get() != nullptr)
+                ++entry_count;
+        }
+        EXPECT_EQ(2, entry_count);
+    }
+
+    TEST_CASE(Store_GivenEntryLargerThanMaxSize_ReturnsFalse)
+    {
+        DiskCache cache(make_empty_directory("test_diskcache_toolarge").c_str(), 1000);
+
+        EXPECT_FALSE(store_bytes(cache, 1, vector<uint8>(2000, 1)));
+        EXPECT_TRUE(cache.load(1, Format).get() == nullptr);
+    }
+}
@@ -29,11 +29,17 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/intersection/raytrianglemtgroup.h"
 #include "foundation/math/intersection/raytrianglessk.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cstddef>
+
 using namespace foundation;
 
 namespace
@@ -110,6 +116,84 @@ TEST_SUITE(Foundation_Math_Intersection_RayTriangleMT)
     }
 }
 
+TEST_SUITE(Foundation_Math_Intersection_RayTriangleMTGroup)
+{
+    typedef TriangleMTGroup<float, 4> TriangleGroup;
+
+    Vector3f random_point(MersenneTwister& rng)
+    {
+        return Vector3f(
+            rand_float1(rng, -1.0f, 1.0f),
+            rand_float1(rng, -1.0f, 1.0f),
+            rand_float1(rng, -1.0f, 1.0f));
+    }
+
+    TEST_CASE(Intersect_GivenRandomTrianglesAndRays_MatchesIndividualTriangles)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            TriangleGroup group;
+            TriangleMT<float> triangles[4];
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                triangles[j] = TriangleMT<float>(random_point(rng), random_point(rng), random_point(rng));
+                group.set(j, triangles[j]);
+            }
+
+            const Ray3d ray(
+                Vector3d(random_point(rng)) * 2.0,
+                normalize(Vector3d(random_point(rng))),
+                0.0,
+                rand_double1(rng, 0.5, 4.0));
+
+            double t[4], u[4], v[4];
+            const size_t hits = group.intersect(ray, t, u, v);
+
+            EXPECT_EQ(hits, group.intersect(ray));
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                double expected_t, expected_u, expected_v;
+                const bool expected_hit =
+                    TriangleMT<double>(triangles[j]).intersect(ray, expected_t, expected_u, expected_v);
+
+                ASSERT_EQ(expected_hit, (hits & (size_t(1) << j)) != 0);
+
+                if (expected_hit)
+                {
+                    EXPECT_EQ(expected_t, t[j]);
+                    EXPECT_EQ(expected_u, u[j]);
+                    EXPECT_EQ(expected_v, v[j]);
+                }
+            }
+        }
+    }
+
+    TEST_CASE(Intersect_GivenClearedSlot_ReturnsNoHitForThisSlot)
+    {
+        TriangleGroup group;
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            group.set(
+                j,
+                TriangleMT<float>(
+                    Vector3f(0.5f, 0.0f, 0.5f),
+                    Vector3f(-0.5f, 0.0f, 0.5f),
+                    Vector3f(-0.5f, 0.0f, -0.5f)));
+        }
+
+        group.clear(2);
+
+        const Ray3d ray(Vector3d(0.0, 1.0, 0.0), Vector3d(0.0, -1.0, 0.0));
+
+        EXPECT_EQ(11, group.intersect(ray));
+    }
+}
+
 TEST_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
 {
     typedef RayTriangleFixture<TriangleSSK<double>> Fixture;
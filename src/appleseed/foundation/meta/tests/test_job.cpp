@@ -376,6 +376,100 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
     }
 }
 
+TEST_SUITE(Foundation_Utility_Job_JobManager_WorkStealing)
+{
+    struct FixtureJobManager
+    {
+        Logger      logger;
+        JobQueue    job_queue;
+        JobManager  job_manager;
+
+        FixtureJobManager()
+          : job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue | JobManager::WorkStealing)
+        {
+        }
+    };
+
+    class JobCreatingOtherJobs
+      : public IJob
+    {
+      public:
+        JobCreatingOtherJobs(
+            JobQueue&           job_queue,
+            const size_t        job_count,
+            volatile uint32*    execution_count)
+          : m_job_queue(job_queue)
+          , m_job_count(job_count)
+          , m_execution_count(execution_count)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = 0; i < m_job_count; ++i)
+            {
+                m_job_queue.schedule(
+                    new JobNotifyingAboutExecution(m_execution_count));
+            }
+        }
+
+      private:
+        JobQueue&           m_job_queue;
+        const size_t        m_job_count;
+        volatile uint32*    m_execution_count;
+    };
+
+    TEST_CASE_F(JobManagerExecutesJobsScheduledBeforeStart, FixtureJobManager)
+    {
+        volatile uint32 execution_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            job_queue.schedule(
+                new JobNotifyingAboutExecution(&execution_count));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(1000, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE_F(JobManagerExecutesJobsScheduledAfterStart, FixtureJobManager)
+    {
+        volatile uint32 execution_count = 0;
+
+        job_manager.start();
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            job_queue.schedule(
+                new JobNotifyingAboutExecution(&execution_count));
+        }
+
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(1000, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE_F(JobManagerExecutesSubJobs, FixtureJobManager)
+    {
+        volatile uint32 execution_count = 0;
+
+        // All sub-jobs land in the deque of a single worker thread and must be stolen by others.
+        job_queue.schedule(
+            new JobCreatingOtherJobs(job_queue, 1000, &execution_count));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(1000, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+}
+
 TEST_SUITE(Foundation_Utility_Job_WorkerThread)
 {
     class TimeoutChecker
@@ -0,0 +1,240 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/math/vector.h"
+#include "foundation/mesh/imeshwalker.h"
+#include "foundation/mesh/mappedmeshfile.h"
+#include "foundation/mesh/mappedmeshfilereader.h"
+#include "foundation/mesh/mappedmeshfilewriter.h"
+#include "foundation/mesh/meshbuilderbase.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/memory.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Mesh_MappedMeshFile)
+{
+    // A unit square made of a single quad, with non-normalized vertex normals.
+    struct QuadMeshWalker
+      : public IMeshWalker
+    {
+        const string m_name;
+
+        explicit QuadMeshWalker(const string& name)
+          : m_name(name)
+        {
+        }
+
+        const char* get_name() const override
+        {
+            return m_name.c_str();
+        }
+
+        size_t get_vertex_count() const override
+        {
+            return 4;
+        }
+
+        Vector3d get_vertex(const size_t i) const override
+        {
+            return Vector3d(i == 1 || i == 2 ? 1.0 : 0.0, i >= 2 ? 1.0 : 0.0, 0.0);
+        }
+
+        size_t get_vertex_normal_count() const override
+        {
+            return 1;
+        }
+
+        Vector3d get_vertex_normal(const size_t i) const override
+        {
+            return Vector3d(0.0, 0.0, 2.0);
+        }
+
+        size_t get_tex_coords_count() const override
+        {
+            return 4;
+        }
+
+        Vector2d get_tex_coords(const size_t i) const override
+        {
+            return Vector2d(get_vertex(i)[0], get_vertex(i)[1]);
+        }
+
+        size_t get_material_slot_count() const override
+        {
+            return 2;
+        }
+
+        const char* get_material_slot(const size_t i) const override
+        {
+            return i == 0 ? "front" : "back";
+        }
+
+        size_t get_face_count() const override
+        {
+            return 1;
+        }
+
+        size_t get_face_vertex_count(const size_t face_index) const override
+        {
+            return 4;
+        }
+
+        size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const override
+        {
+            return vertex_index;
+        }
+
+        size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const override
+        {
+            return 0;
+        }
+
+        size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const override
+        {
+            return vertex_index;
+        }
+
+        size_t get_face_material(const size_t face_index) const override
+        {
+            return 1;
+        }
+    };
+
+    struct FaceCountingMeshBuilder
+      : public MeshBuilderBase
+    {
+        vector<string>  m_names;
+        vector<size_t>  m_face_counts;
+
+        void begin_mesh(const char* name) override
+        {
+            m_names.push_back(name);
+            m_face_counts.push_back(0);
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            ++m_face_counts.back();
+        }
+    };
+
+    void write_two_quads(const char* filename)
+    {
+        MappedMeshFileWriter writer(filename);
+        writer.write(QuadMeshWalker("quad1"));
+        writer.write(QuadMeshWalker("quad2"));
+    }
+
+    TEST_CASE(Constructor_GivenFileWithTwoMeshes_MapsBothMeshes)
+    {
+        const char* Filename = "unit tests/outputs/test_mappedmeshfile_twomeshes.mappedmesh";
+        write_two_quads(Filename);
+
+        const MappedMeshFile file(Filename);
+
+        ASSERT_EQ(2, file.get_mesh_count());
+        EXPECT_EQ(string("quad1"), file.get_mesh(0).m_name);
+        EXPECT_EQ(string("quad2"), file.get_mesh(1).m_name);
+    }
+
+    TEST_CASE(Constructor_GivenQuad_MapsTriangulatedGeometryInPlace)
+    {
+        const char* Filename = "unit tests/outputs/test_mappedmeshfile_quad.mappedmesh";
+        write_two_quads(Filename);
+
+        const MappedMeshFile file(Filename);
+        const MappedMeshFile::Mesh& mesh = file.get_mesh(1);
+
+        ASSERT_EQ(4, mesh.m_vertex_count);
+        EXPECT_TRUE(is_aligned(mesh.m_vertices, MappedMeshFile::Alignment));
+        EXPECT_EQ(Vector3f(1.0f, 1.0f, 0.0f), mesh.m_vertices[2]);
+
+        ASSERT_EQ(1, mesh.m_vertex_normal_count);
+        EXPECT_TRUE(is_aligned(mesh.m_vertex_normals, MappedMeshFile::Alignment));
+        EXPECT_EQ(Vector3f(0.0f, 0.0f, 1.0f), mesh.m_vertex_normals[0]);
+
+        ASSERT_EQ(4, mesh.m_tex_coords_count);
+        EXPECT_TRUE(is_aligned(mesh.m_tex_coords, MappedMeshFile::Alignment));
+        EXPECT_EQ(Vector2f(1.0f, 0.0f), mesh.m_tex_coords[1]);
+
+        ASSERT_EQ(2, mesh.m_triangle_count);
+        EXPECT_TRUE(is_aligned(mesh.m_triangles, MappedMeshFile::Alignment));
+        for (size_t i = 0; i < mesh.m_triangle_count; ++i)
+        {
+            EXPECT_EQ(0, mesh.m_triangles[i].m_n0);
+            EXPECT_EQ(1, mesh.m_triangles[i].m_material);
+        }
+
+        ASSERT_EQ(2, mesh.m_material_slots.size());
+        EXPECT_EQ(string("front"), mesh.m_material_slots[0]);
+        EXPECT_EQ(string("back"), mesh.m_material_slots[1]);
+    }
+
+    TEST_CASE(Constructor_GivenFileWithInvalidSignature_ThrowsExceptionIOError)
+    {
+        const char* Filename = "unit tests/outputs/test_mappedmeshfile_invalid.mappedmesh";
+
+        FILE* file = fopen(Filename, "wt");
+        ASSERT_NEQ(nullptr, file);
+        for (size_t i = 0; i < 100; ++i)
+            fputs("not a mesh\n", file);
+        fclose(file);
+
+        EXPECT_EXCEPTION(ExceptionIOError,
+        {
+            const MappedMeshFile mapped_file(Filename);
+        });
+    }
+
+    TEST_CASE(MappedMeshFileReader_GivenQuad_BuildsTwoTriangles)
+    {
+        const char* Filename = "unit tests/outputs/test_mappedmeshfile_reader.mappedmesh";
+        write_two_quads(Filename);
+
+        MappedMeshFileReader reader(Filename);
+        FaceCountingMeshBuilder builder;
+        reader.read(builder);
+
+        ASSERT_EQ(2, builder.m_names.size());
+        EXPECT_EQ(string("quad1"), builder.m_names[0]);
+        EXPECT_EQ(2, builder.m_face_counts[0]);
+        EXPECT_EQ(2, builder.m_face_counts[1]);
+    }
+}
@@ -0,0 +1,104 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/genericimagefilereader.h"
+#include "foundation/image/image.h"
+#include "foundation/image/imageattributes.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tiledexrimagefilewriter.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Image_TiledEXRImageFileWriter)
+{
+    TEST_CASE(WriteTile_GivenTilesInReverseOrder_CorrectlyWritesImagePixels)
+    {
+        const char* ImageFilePath = "unit tests/outputs/test_tiledexrimagefilewriter_pixels.exr";
+
+        {
+            // 3x3 image made of four tiles, including smaller border tiles.
+            Image image(3, 3, 2, 2, 4, PixelFormatFloat);
+            for (size_t y = 0; y < 3; ++y)
+            {
+                for (size_t x = 0; x < 3; ++x)
+                    image.set_pixel(x, y, Color4f(0.125f * x, 0.25f * y, 0.5f, 1.0f));
+            }
+
+            Image aov(3, 3, 2, 2, 3, PixelFormatFloat);
+            aov.clear(Color3f(1.0f, 2.0f, 3.0f));
+            const char* AOVChannelNames[] = { "X", "Y", "Z" };
+
+            const ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+
+            TiledEXRImageFileWriter writer(ImageFilePath);
+            EXPECT_EQ(0, writer.append_part("beauty", image.properties(), nullptr, PixelFormatHalf, image_attributes));
+            EXPECT_EQ(1, writer.append_part("aov", aov.properties(), AOVChannelNames, PixelFormatFloat, image_attributes));
+            writer.open();
+
+            for (size_t ty = 2; ty-- > 0; )
+            {
+                for (size_t tx = 2; tx-- > 0; )
+                {
+                    writer.write_tile(1, tx, ty, aov.tile(tx, ty));
+                    writer.write_tile(0, tx, ty, image.tile(tx, ty));
+                }
+            }
+
+            writer.close();
+            EXPECT_FALSE(writer.is_open());
+        }
+
+        {
+            GenericImageFileReader reader;
+            unique_ptr<Image> image(reader.read(ImageFilePath));
+
+            ASSERT_EQ(3, image->properties().m_canvas_width);
+            ASSERT_EQ(3, image->properties().m_canvas_height);
+
+            for (size_t y = 0; y < 3; ++y)
+            {
+                for (size_t x = 0; x < 3; ++x)
+                {
+                    // These values are exactly representable as half floats.
+                    Color4f c;
+                    image->get_pixel(x, y, c);
+                    EXPECT_EQ(Color4f(0.125f * x, 0.25f * y, 0.5f, 1.0f), c);
+                }
+            }
+        }
+    }
+}
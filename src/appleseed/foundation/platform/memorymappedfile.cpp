@@ -0,0 +1,192 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "memorymappedfile.h"
+
+// Standard headers.
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+// Platform headers.
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// ExceptionCannotMapFile class implementation.
+//
+
+ExceptionCannotMapFile::ExceptionCannotMapFile(
+    const char* path,
+    const char* error_msg)
+{
+    string err("Cannot map file ");
+    err += path;
+    err += " into memory: ";
+    err += error_msg;
+    set_what(err.c_str());
+}
+
+
+//
+// MemoryMappedFile class implementation.
+//
+
+#ifdef _WIN32
+
+MemoryMappedFile::MemoryMappedFile(const char* path)
+  : m_file_handle(INVALID_HANDLE_VALUE)
+  , m_mapping_handle(nullptr)
+  , m_data(nullptr)
+  , m_size(0)
+{
+    m_file_handle =
+        CreateFileA(
+            path,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+    if (m_file_handle == INVALID_HANDLE_VALUE)
+        throw ExceptionCannotMapFile(path, get_windows_last_error_message().c_str());
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(m_file_handle, &file_size))
+    {
+        const string error_msg = get_windows_last_error_message();
+        CloseHandle(m_file_handle);
+        throw ExceptionCannotMapFile(path, error_msg.c_str());
+    }
+
+    m_size = static_cast<size_t>(file_size.QuadPart);
+
+    // Empty files cannot be mapped.
+    if (m_size == 0)
+        return;
+
+    m_mapping_handle =
+        CreateFileMappingA(
+            m_file_handle,
+            nullptr,
+            PAGE_WRITECOPY,
+            0,
+            0,
+            nullptr);
+
+    if (m_mapping_handle == nullptr)
+    {
+        const string error_msg = get_windows_last_error_message();
+        CloseHandle(m_file_handle);
+        throw ExceptionCannotMapFile(path, error_msg.c_str());
+    }
+
+    m_data = MapViewOfFile(m_mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+
+    if (m_data == nullptr)
+    {
+        const string error_msg = get_windows_last_error_message();
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file_handle);
+        throw ExceptionCannotMapFile(path, error_msg.c_str());
+    }
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+
+    if (m_mapping_handle != nullptr)
+        CloseHandle(m_mapping_handle);
+
+    CloseHandle(m_file_handle);
+}
+
+#else
+
+MemoryMappedFile::MemoryMappedFile(const char* path)
+  : m_data(nullptr)
+  , m_size(0)
+{
+    const int fd = open(path, O_RDONLY);
+
+    if (fd == -1)
+        throw ExceptionCannotMapFile(path, strerror(errno));
+
+    struct stat file_stats;
+    if (fstat(fd, &file_stats) == -1)
+    {
+        const int error = errno;
+        close(fd);
+        throw ExceptionCannotMapFile(path, strerror(error));
+    }
+
+    m_size = static_cast<size_t>(file_stats.st_size);
+
+    // Empty files cannot be mapped.
+    if (m_size > 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED)
+        {
+            const int error = errno;
+            close(fd);
+            throw ExceptionCannotMapFile(path, strerror(error));
+        }
+
+        m_data = data;
+    }
+
+    // The mapping remains valid after the file descriptor is closed.
+    close(fd);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+}
+
+#endif
+
+}   // namespace foundation
@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/core/exceptions/exception.h"
+#ifdef _WIN32
+#include "foundation/platform/windows.h"
+#endif
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Exception thrown when a file cannot be mapped into memory.
+//
+
+class ExceptionCannotMapFile
+  : public Exception
+{
+  public:
+    // Constructor.
+    ExceptionCannotMapFile(
+        const char* path,
+        const char* error_msg);
+};
+
+
+//
+// A read-only file mapped into the address space of the process.
+//
+// The mapping is private and copy-on-write: the mapped bytes may be modified
+// in place, but modifications only affect the pages that are written to and
+// are never written back to the file.
+//
+
+class MemoryMappedFile
+  : public NonCopyable
+{
+  public:
+    // Constructor. Throws ExceptionCannotMapFile on failure.
+    explicit MemoryMappedFile(const char* path);
+
+    // Destructor.
+    ~MemoryMappedFile();
+
+    // Return the size in bytes of the mapped file.
+    size_t size() const;
+
+    // Return the address of the first byte of the mapped file.
+    // The returned address is aligned on a page boundary.
+    // A null pointer is returned if the file is empty.
+    void* data() const;
+
+  private:
+#ifdef _WIN32
+    HANDLE  m_file_handle;
+    HANDLE  m_mapping_handle;
+#endif
+    void*   m_data;
+    size_t  m_size;
+};
+
+
+//
+// MemoryMappedFile class implementation.
+//
+
+inline size_t MemoryMappedFile::size() const
+{
+    return m_size;
+}
+
+inline void* MemoryMappedFile::data() const
+{
+    return m_data;
+}
+
+}   // namespace foundation
@@ -49,9 +49,13 @@
 #if defined __APPLE__
 #include <pthread.h>
 #elif defined __FreeBSD__
+#include <sys/param.h>
+#include <sys/cpuset.h>
 #include <pthread.h>
 #include <pthread_np.h>
 #elif defined __linux__
+#include <pthread.h>
+#include <sched.h>
 #include <sys/prctl.h>
 #endif
 
@@ -101,6 +105,17 @@ namespace foundation
         }
     }
 
+    bool set_current_thread_affinity(const size_t logical_core)
+    {
+        // Only the first 64 logical cores (the first processor group) can be targeted.
+        const size_t mask_bits = sizeof(DWORD_PTR) * 8;
+        if (logical_core >= mask_bits)
+            return false;
+
+        const DWORD_PTR mask = static_cast<DWORD_PTR>(1) << logical_core;
+        return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    }
+
 // macOS.
 #elif defined __APPLE__
 
@@ -109,6 +124,12 @@ namespace foundation
         pthread_setname_np(name);
     }
 
+    bool set_current_thread_affinity(const size_t logical_core)
+    {
+        // macOS does not allow binding threads to cores.
+        return false;
+    }
+
 // FreeBSD.
 #elif defined __FreeBSD__
 
@@ -117,6 +138,18 @@ namespace foundation
         pthread_set_name_np(pthread_self(), name);
     }
 
+    bool set_current_thread_affinity(const size_t logical_core)
+    {
+        if (logical_core >= CPU_SETSIZE)
+            return false;
+
+        cpuset_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(logical_core, &cpuset);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0;
+    }
+
 // Linux.
 #elif defined __linux__
 
@@ -125,6 +158,18 @@ namespace foundation
         prctl(PR_SET_NAME, (unsigned long)name, 0, 0, 0);
     }
 
+    bool set_current_thread_affinity(const size_t logical_core)
+    {
+        if (logical_core >= CPU_SETSIZE)
+            return false;
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(logical_core, &cpuset);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0;
+    }
+
 // Other platforms.
 #else
 
@@ -133,6 +178,11 @@ namespace foundation
         // Do nothing.
     }
 
+    bool set_current_thread_affinity(const size_t logical_core)
+    {
+        return false;
+    }
+
 #endif
 
 void sleep(const uint32 ms)
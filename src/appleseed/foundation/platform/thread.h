@@ -43,6 +43,9 @@
 #include "boost/thread/mutex.hpp"
 #include "boost/thread/thread.hpp"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Logger; }
@@ -58,6 +61,10 @@ namespace foundation
 // For portability, limit the name to 16 characters, including the terminating zero.
 APPLESEED_DLLSYMBOL void set_current_thread_name(const char* name);
 
+// Bind the current thread to a given logical CPU core.
+// Return false if the platform does not support it or if the operation failed.
+APPLESEED_DLLSYMBOL bool set_current_thread_affinity(const size_t logical_core);
+
 // Suspend the current thread for a given number of milliseconds.
 APPLESEED_DLLSYMBOL void sleep(const uint32 ms);
 APPLESEED_DLLSYMBOL void sleep(const uint32 ms, IAbortSwitch& abort_switch);
@@ -0,0 +1,318 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A std::vector-like array whose elements either live in storage owned by
+// the array, or alias an external buffer such as a memory-mapped file.
+//
+// Aliasing arrays allow in-place modification of their elements, but growing,
+// shrinking or clearing an aliasing array first copies its elements to owned
+// storage. The external buffer must outlive the aliasing period.
+//
+
+template <typename T>
+class AliasableVector
+{
+  public:
+    // Types.
+    typedef T value_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef size_t size_type;
+
+    // Constructor.
+    AliasableVector();
+
+    // Copy constructor and assignment operator.
+    AliasableVector(const AliasableVector& rhs);
+    AliasableVector& operator=(const AliasableVector& rhs);
+
+    // Make the array alias an external buffer, discarding its current content.
+    void alias(T* data, const size_t size);
+
+    // Return true if the array currently aliases an external buffer.
+    bool is_aliasing() const;
+
+    // Size.
+    bool empty() const;
+    size_t size() const;
+
+    // Modify the size of the array. These methods stop aliasing.
+    void reserve(const size_t count);
+    void resize(const size_t count);
+    void push_back(const T& value);
+    template <typename... Args> void emplace_back(Args&&... args);
+    void clear();
+
+    // Element access.
+    T& operator[](const size_t index);
+    const T& operator[](const size_t index) const;
+    T& front();
+    const T& front() const;
+    T& back();
+    const T& back() const;
+    T* data();
+    const T* data() const;
+
+    // Iteration.
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+  private:
+    std::vector<T>  m_storage;
+    T*              m_begin;
+    size_t          m_size;
+    bool            m_aliasing;
+
+    void own();
+    void update_view();
+};
+
+
+//
+// AliasableVector class implementation.
+//
+
+template <typename T>
+inline AliasableVector<T>::AliasableVector()
+  : m_begin(nullptr)
+  , m_size(0)
+  , m_aliasing(false)
+{
+}
+
+template <typename T>
+inline AliasableVector<T>::AliasableVector(const AliasableVector& rhs)
+  : m_storage(rhs.m_storage)
+  , m_begin(rhs.m_begin)
+  , m_size(rhs.m_size)
+  , m_aliasing(rhs.m_aliasing)
+{
+    if (!m_aliasing)
+        update_view();
+}
+
+template <typename T>
+inline AliasableVector<T>& AliasableVector<T>::operator=(const AliasableVector& rhs)
+{
+    m_storage = rhs.m_storage;
+    m_begin = rhs.m_begin;
+    m_size = rhs.m_size;
+    m_aliasing = rhs.m_aliasing;
+
+    if (!m_aliasing)
+        update_view();
+
+    return *this;
+}
+
+template <typename T>
+void AliasableVector<T>::alias(T* data, const size_t size)
+{
+    assert(data != nullptr || size == 0);
+
+    std::vector<T>().swap(m_storage);
+
+    m_begin = data;
+    m_size = size;
+    m_aliasing = true;
+}
+
+template <typename T>
+inline bool AliasableVector<T>::is_aliasing() const
+{
+    return m_aliasing;
+}
+
+template <typename T>
+inline bool AliasableVector<T>::empty() const
+{
+    return m_size == 0;
+}
+
+template <typename T>
+inline size_t AliasableVector<T>::size() const
+{
+    return m_size;
+}
+
+template <typename T>
+inline void AliasableVector<T>::reserve(const size_t count)
+{
+    own();
+    m_storage.reserve(count);
+    update_view();
+}
+
+template <typename T>
+inline void AliasableVector<T>::resize(const size_t count)
+{
+    own();
+    m_storage.resize(count);
+    update_view();
+}
+
+template <typename T>
+inline void AliasableVector<T>::push_back(const T& value)
+{
+    own();
+    m_storage.push_back(value);
+    update_view();
+}
+
+template <typename T>
+template <typename... Args>
+inline void AliasableVector<T>::emplace_back(Args&&... args)
+{
+    own();
+    m_storage.emplace_back(std::forward<Args>(args)...);
+    update_view();
+}
+
+template <typename T>
+inline void AliasableVector<T>::clear()
+{
+    m_aliasing = false;
+    m_storage.clear();
+    update_view();
+}
+
+template <typename T>
+inline T& AliasableVector<T>::operator[](const size_t index)
+{
+    assert(index < m_size);
+    return m_begin[index];
+}
+
+template <typename T>
+inline const T& AliasableVector<T>::operator[](const size_t index) const
+{
+    assert(index < m_size);
+    return m_begin[index];
+}
+
+template <typename T>
+inline T& AliasableVector<T>::front()
+{
+    assert(m_size > 0);
+    return m_begin[0];
+}
+
+template <typename T>
+inline const T& AliasableVector<T>::front() const
+{
+    assert(m_size > 0);
+    return m_begin[0];
+}
+
+template <typename T>
+inline T& AliasableVector<T>::back()
+{
+    assert(m_size > 0);
+    return m_begin[m_size - 1];
+}
+
+template <typename T>
+inline const T& AliasableVector<T>::back() const
+{
+    assert(m_size > 0);
+    return m_begin[m_size - 1];
+}
+
+template <typename T>
+inline T* AliasableVector<T>::data()
+{
+    return m_begin;
+}
+
+template <typename T>
+inline const T* AliasableVector<T>::data() const
+{
+    return m_begin;
+}
+
+template <typename T>
+inline typename AliasableVector<T>::iterator AliasableVector<T>::begin()
+{
+    return m_begin;
+}
+
+template <typename T>
+inline typename AliasableVector<T>::iterator AliasableVector<T>::end()
+{
+    return m_begin + m_size;
+}
+
+template <typename T>
+inline typename AliasableVector<T>::const_iterator AliasableVector<T>::begin() const
+{
+    return m_begin;
+}
+
+template <typename T>
+inline typename AliasableVector<T>::const_iterator AliasableVector<T>::end() const
+{
+    return m_begin + m_size;
+}
+
+template <typename T>
+void AliasableVector<T>::own()
+{
+    if (m_aliasing)
+    {
+        m_storage.assign(m_begin, m_begin + m_size);
+        m_aliasing = false;
+    }
+}
+
+template <typename T>
+inline void AliasableVector<T>::update_view()
+{
+    assert(!m_aliasing);
+
+    m_begin = m_storage.empty() ? nullptr : &m_storage.front();
+    m_size = m_storage.size();
+}
+
+}   // namespace foundation
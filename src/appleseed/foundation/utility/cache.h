@@ -469,6 +469,11 @@ class LRUCache
     // Clear the cache.
     void clear();
 
+    // Unload and remove the elements whose key satisfies a given predicate.
+    // Elements that cannot be unloaded are kept. Return the number of removed elements.
+    template <typename Predicate>
+    size_t remove_if(Predicate predicate);
+
     // Get an element from the cache.
     ElementType& get(const KeyType& key);
 
@@ -897,6 +902,26 @@ clear()
     m_queue_size = 0;
 }
 
+FOUNDATION_LRUCACHE_TEMPLATE_DEF(template <typename Predicate> size_t)
+remove_if(Predicate predicate)
+{
+    size_t removed_count = 0;
+
+    for (QueueIterator i = m_queue.begin(); i != m_queue.end(); )
+    {
+        if (predicate(i->m_key) && m_element_swapper.unload(i->m_key, i->m_element))
+        {
+            m_index.erase(i->m_key);
+            i = m_queue.erase(i);
+            --m_queue_size;
+            ++removed_count;
+        }
+        else ++i;
+    }
+
+    return removed_count;
+}
+
 FOUNDATION_LRUCACHE_TEMPLATE_DEF(inline Element&)
 get(const KeyType& key)
 {
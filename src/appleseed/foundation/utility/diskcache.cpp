@@ -0,0 +1,378 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "diskcache.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/siphash.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+#include "boost/system/error_code.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+namespace bf = boost::filesystem;
+namespace bs = boost::system;
+
+namespace foundation
+{
+
+//
+// DiskCache class implementation.
+//
+
+namespace
+{
+    const char Signature[8] = { 'A', 'S', 'C', 'A', 'C', 'H', 'E', '\0' };
+    const uint32 Version = 1;
+    const uint32 ByteOrderMark = 0x01020304;
+    const uint64 Alignment = 64;
+    const char* EntryExtension = ".cache";
+
+    struct FileHeader
+    {
+        char        m_signature[8];
+        uint32      m_version;
+        uint32      m_byte_order_mark;
+        uint64      m_key;
+        uint32      m_format;
+        uint32      m_section_count;
+        uint64      m_file_size;
+        uint64      m_checksum;         // of the section headers and the section contents
+        uint8       m_reserved[16];
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "Unexpected size of foundation::DiskCache file header");
+
+    struct SectionHeader
+    {
+        uint64      m_offset;           // from the beginning of the file
+        uint64      m_size;
+    };
+
+    uint64 align(const uint64 offset)
+    {
+        return (offset + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    uint64 compute_checksum(
+        const vector<SectionHeader>&    section_headers,
+        const DiskCache::Section        sections[])
+    {
+        SipHashAccumulator hash;
+
+        if (!section_headers.empty())
+            hash.append(&section_headers[0], section_headers.size() * sizeof(SectionHeader));
+
+        for (size_t i = 0, e = section_headers.size(); i < e; ++i)
+            hash.append(sections[i].m_data, sections[i].m_size);
+
+        return hash.get_hash();
+    }
+
+    bool write_padding(BufferedFile& file, const uint64 offset)
+    {
+        static const uint8 Zeros[Alignment] = { 0 };
+        const size_t padding = static_cast<size_t>(align(offset) - offset);
+        return padding == 0 || file.write(Zeros, padding) == padding;
+    }
+
+    bool write_entry(
+        const string&                   path,
+        const FileHeader&               file_header,
+        const vector<SectionHeader>&    section_headers,
+        const DiskCache::Section        sections[])
+    {
+        BufferedFile file(path.c_str(), BufferedFile::BinaryType, BufferedFile::WriteMode);
+
+        if (!file.is_open())
+            return false;
+
+        uint64 offset = sizeof(FileHeader) + section_headers.size() * sizeof(SectionHeader);
+
+        if (file.write(file_header) != sizeof(FileHeader))
+            return false;
+
+        for (const SectionHeader& section_header : section_headers)
+        {
+            if (file.write(section_header) != sizeof(SectionHeader))
+                return false;
+        }
+
+        for (size_t i = 0, e = section_headers.size(); i < e; ++i)
+        {
+            if (!write_padding(file, offset))
+                return false;
+
+            assert(align(offset) == section_headers[i].m_offset);
+
+            if (sections[i].m_size > 0 &&
+                file.write(sections[i].m_data, sections[i].m_size) != sections[i].m_size)
+                return false;
+
+            offset = section_headers[i].m_offset + sections[i].m_size;
+        }
+
+        if (!write_padding(file, offset))
+            return false;
+
+        return file.close();
+    }
+
+    bool read_entry(
+        const MemoryMappedFile&         file,
+        const uint64                    key,
+        const uint32                    format,
+        vector<DiskCache::Section>&     sections)
+    {
+        const uint8* base = static_cast<const uint8*>(file.data());
+        const uint64 file_size = file.size();
+
+        if (file_size < sizeof(FileHeader))
+            return false;
+
+        const FileHeader& file_header = *reinterpret_cast<const FileHeader*>(base);
+
+        if (memcmp(file_header.m_signature, Signature, sizeof(Signature)) != 0 ||
+            file_header.m_version != Version ||
+            file_header.m_byte_order_mark != ByteOrderMark ||
+            file_header.m_key != key ||
+            file_header.m_format != format ||
+            file_header.m_file_size != file_size)
+            return false;
+
+        const uint64 section_count = file_header.m_section_count;
+
+        if (section_count > (file_size - sizeof(FileHeader)) / sizeof(SectionHeader))
+            return false;
+
+        const SectionHeader* section_header_ptr =
+            reinterpret_cast<const SectionHeader*>(base + sizeof(FileHeader));
+        const vector<SectionHeader> section_headers(
+            section_header_ptr,
+            section_header_ptr + section_count);
+
+        sections.resize(section_count);
+
+        for (size_t i = 0; i < section_count; ++i)
+        {
+            const SectionHeader& section_header = section_headers[i];
+
+            if (section_header.m_offset % Alignment != 0 ||
+                section_header.m_offset > file_size ||
+                section_header.m_size > file_size - section_header.m_offset)
+                return false;
+
+            sections[i] =
+                DiskCache::Section(
+                    base + section_header.m_offset,
+                    static_cast<size_t>(section_header.m_size));
+        }
+
+        return compute_checksum(section_headers, sections.empty() ? nullptr : &sections[0]) == file_header.m_checksum;
+    }
+}
+
+DiskCache::Entry::Entry(const char* path)
+  : m_file(path)
+{
+}
+
+DiskCache::DiskCache(
+    const char*     directory,
+    const uint64    max_size)
+  : m_directory(directory)
+  , m_max_size(max_size)
+{
+    bs::error_code ec;
+    bf::create_directories(m_directory, ec);
+}
+
+bool DiskCache::store(
+    const uint64    key,
+    const uint32    format,
+    const Section   sections[],
+    const size_t    section_count)
+{
+    // Lay out the sections.
+    vector<SectionHeader> section_headers(section_count);
+    uint64 offset = sizeof(FileHeader) + section_count * sizeof(SectionHeader);
+    for (size_t i = 0; i < section_count; ++i)
+    {
+        section_headers[i].m_offset = align(offset);
+        section_headers[i].m_size = sections[i].m_size;
+        offset = section_headers[i].m_offset + section_headers[i].m_size;
+    }
+    const uint64 file_size = align(offset);
+
+    // Don't bother storing entries that would immediately be evicted.
+    if (file_size > m_max_size)
+        return false;
+
+    FileHeader file_header;
+    memset(&file_header, 0, sizeof(FileHeader));
+    memcpy(file_header.m_signature, Signature, sizeof(Signature));
+    file_header.m_version = Version;
+    file_header.m_byte_order_mark = ByteOrderMark;
+    file_header.m_key = key;
+    file_header.m_format = format;
+    file_header.m_section_count = static_cast<uint32>(section_count);
+    file_header.m_file_size = file_size;
+    file_header.m_checksum = compute_checksum(section_headers, sections);
+
+    // Write the entry to a temporary file, then move it into place.
+    const string path = get_entry_path(key);
+    const string temp_path = path + "." + bf::unique_path().string() + ".tmp";
+    bs::error_code ec;
+
+    if (!write_entry(temp_path, file_header, section_headers, sections))
+    {
+        bf::remove(temp_path, ec);
+        return false;
+    }
+
+    bf::rename(temp_path, path, ec);
+
+    if (ec)
+    {
+        bf::remove(temp_path, ec);
+        return false;
+    }
+
+    evict();
+
+    return true;
+}
+
+unique_ptr<DiskCache::Entry> DiskCache::load(
+    const uint64    key,
+    const uint32    format)
+{
+    const string path = get_entry_path(key);
+    bs::error_code ec;
+
+    if (!bf::exists(path, ec))
+        return unique_ptr<Entry>();
+
+    unique_ptr<Entry> entry;
+
+    try
+    {
+        entry.reset(new Entry(path.c_str()));
+    }
+    catch (const ExceptionCannotMapFile&)
+    {
+        return unique_ptr<Entry>();
+    }
+
+    if (!read_entry(entry->m_file, key, format, entry->m_sections))
+    {
+        // Delete truncated, corrupted or outdated entries.
+        entry.reset();
+        bf::remove(path, ec);
+        return unique_ptr<Entry>();
+    }
+
+    // Mark the entry as recently used.
+    bf::last_write_time(path, time(nullptr), ec);
+
+    return entry;
+}
+
+void DiskCache::evict()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    struct EntryInfo
+    {
+        bf::path    m_path;
+        time_t      m_time;
+        uint64      m_size;
+
+        bool operator<(const EntryInfo& rhs) const
+        {
+            return m_time < rhs.m_time;
+        }
+    };
+
+    // Collect the entries of the cache.
+    vector<EntryInfo> entries;
+    uint64 total_size = 0;
+    bs::error_code ec;
+    for (bf::directory_iterator i(m_directory, ec), e; !ec && i != e; i.increment(ec))
+    {
+        if (i->path().extension() != EntryExtension)
+            continue;
+
+        EntryInfo info;
+        info.m_path = i->path();
+        info.m_time = bf::last_write_time(info.m_path, ec);
+        if (ec)
+            continue;
+        info.m_size = bf::file_size(info.m_path, ec);
+        if (ec)
+            continue;
+
+        entries.push_back(info);
+        total_size += info.m_size;
+    }
+
+    if (total_size <= m_max_size)
+        return;
+
+    // Delete least recently used entries first.
+    sort(entries.begin(), entries.end());
+    for (const EntryInfo& info : entries)
+    {
+        if (total_size <= m_max_size)
+            break;
+
+        if (bf::remove(info.m_path, ec))
+            total_size -= info.m_size;
+    }
+}
+
+string DiskCache::get_entry_path(const uint64 key) const
+{
+    stringstream filename;
+    filename << hex << setfill('0') << setw(16) << key << EntryExtension;
+    return (bf::path(m_directory) / filename.str()).string();
+}
+
+}   // namespace foundation
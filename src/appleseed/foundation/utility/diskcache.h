@@ -0,0 +1,163 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A persistent, size-bounded, content-addressed cache of binary data.
+//
+// Entries are stored as individual files in a cache directory and are identified
+// by a 64-bit key, typically a hash of everything the cached data was derived from.
+// An entry is made of one or several sections of bytes; each section starts on a
+// 64-byte boundary in the file.
+//
+// Entries are written to a temporary file which is then atomically renamed, so that
+// several processes may share the same cache directory. When an entry is loaded, its
+// file is memory-mapped and validated (signature, key, format, sizes and checksum);
+// invalid entries are deleted. When the total size of the entries exceeds the bound
+// of the cache, least recently used entries are deleted.
+//
+
+class DiskCache
+  : public NonCopyable
+{
+  public:
+    // A section of bytes.
+    struct Section
+    {
+        const void*     m_data;
+        size_t          m_size;
+
+        Section() {}
+        Section(const void* data, const size_t size)
+          : m_data(data)
+          , m_size(size)
+        {
+        }
+    };
+
+    // A valid entry, mapped into memory.
+    class Entry
+      : public NonCopyable
+    {
+      public:
+        // Return the number of sections of this entry.
+        size_t get_section_count() const;
+
+        // Return a given section of this entry.
+        const Section& get_section(const size_t index) const;
+
+      private:
+        friend class DiskCache;
+
+        MemoryMappedFile        m_file;
+        std::vector<Section>    m_sections;
+
+        explicit Entry(const char* path);
+    };
+
+    // Constructor. The cache directory is created if it doesn't exist.
+    DiskCache(
+        const char*             directory,
+        const uint64            max_size);
+
+    // Return the cache directory.
+    const std::string& get_directory() const;
+
+    // Return the maximum size in bytes of all the entries of the cache.
+    uint64 get_max_size() const;
+
+    // Store an entry. The format is an arbitrary identifier of the layout
+    // of the sections that must match when the entry is loaded back.
+    // Returns true on success, false on failure.
+    bool store(
+        const uint64            key,
+        const uint32            format,
+        const Section           sections[],
+        const size_t            section_count);
+
+    // Load an entry. Returns nullptr if there is no valid entry with this key and format.
+    std::unique_ptr<Entry> load(
+        const uint64            key,
+        const uint32            format);
+
+    // Delete least recently used entries until the cache fits within its maximum size.
+    void evict();
+
+  private:
+    const std::string           m_directory;
+    const uint64                m_max_size;
+    boost::mutex                m_mutex;
+
+    std::string get_entry_path(const uint64 key) const;
+};
+
+
+//
+// DiskCache class implementation.
+//
+
+inline size_t DiskCache::Entry::get_section_count() const
+{
+    return m_sections.size();
+}
+
+inline const DiskCache::Section& DiskCache::Entry::get_section(const size_t index) const
+{
+    return m_sections[index];
+}
+
+inline const std::string& DiskCache::get_directory() const
+{
+    return m_directory;
+}
+
+inline uint64 DiskCache::get_max_size() const
+{
+    return m_max_size;
+}
+
+}   // namespace foundation
@@ -103,6 +103,9 @@ void JobManager::start()
     // Create worker threads if they don't already exist.
     if (impl->m_worker_threads.empty())
     {
+        if (impl->m_flags & WorkStealing)
+            impl->m_job_queue.enable_work_stealing(impl->m_thread_count);
+
         for (size_t i = 0; i < impl->m_thread_count; ++i)
         {
             impl->m_worker_threads.push_back(
@@ -50,6 +50,8 @@ namespace foundation
 //
 // The job manager itself is thread-local: none of its methods are thread-safe.
 //
+// With the WorkStealing flag, the job queue must only be served by this job manager.
+//
 
 class APPLESEED_DLLSYMBOL JobManager
   : public NonCopyable
@@ -58,7 +60,9 @@ class APPLESEED_DLLSYMBOL JobManager
     enum Flags
     {
         KeepRunningOnEmptyQueue = 1UL << 0,     // the worker thread keeps running even if the job queue is empty
-        KeepRunningOnJobFailure = 1UL << 1      // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        KeepRunningOnJobFailure = 1UL << 1,     // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        WorkStealing            = 1UL << 2,     // each worker thread has its own deque of jobs and steals jobs from other worker threads when it runs out of jobs
+        PinWorkerThreads        = 1UL << 3      // each worker thread is bound to a single logical CPU core
     };
 
     // Constructor.
@@ -31,6 +31,8 @@
 #include "jobqueue.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
@@ -42,23 +44,73 @@
 
 // Standard headers.
 #include <cassert>
+#include <deque>
+#include <vector>
 
 using namespace std;
 
 namespace foundation
 {
 
+namespace
+{
+    // The job queue served by the calling thread, if it is a worker thread, and its index.
+    APPLESEED_TLS const JobQueue*   s_worker_job_queue = nullptr;
+    APPLESEED_TLS size_t            s_worker_index = 0;
+}
+
+
 //
 // JobQueue class implementation.
 //
 
 struct JobQueue::Impl
 {
+    // Scheduled jobs of one worker thread, when work stealing is enabled.
+    struct WorkerDeque
+    {
+        Spinlock                    m_lock;
+        deque<JobInfo>              m_jobs;
+        boost::atomic<size_t>       m_job_count;    // allows to skip empty deques without locking
+
+        WorkerDeque()
+          : m_job_count(0)
+        {
+        }
+    };
+
     mutable boost::mutex            m_mutex;
     boost::condition_variable_any   m_event;
     JobList                         m_scheduled_jobs;
     JobList                         m_running_jobs;
 
+    // Work stealing. When enabled, m_scheduled_jobs and m_running_jobs are not used.
+    vector<WorkerDeque*>            m_deques;
+    boost::condition_variable_any   m_idle_worker_event;        // signaled when a job is scheduled
+    boost::atomic<size_t>           m_next_deque;               // round robin over deques for non-worker threads
+    boost::atomic<size_t>           m_ws_scheduled_job_count;
+    boost::atomic<size_t>           m_ws_total_job_count;       // scheduled and running jobs
+    boost::atomic<size_t>           m_idle_worker_count;
+
+    Impl()
+      : m_next_deque(0)
+      , m_ws_scheduled_job_count(0)
+      , m_ws_total_job_count(0)
+      , m_idle_worker_count(0)
+    {
+    }
+
+    ~Impl()
+    {
+        for (each<vector<WorkerDeque*>> i = m_deques; i; ++i)
+            delete *i;
+    }
+
+    bool is_work_stealing_enabled() const
+    {
+        return !m_deques.empty();
+    }
+
     static void delete_jobs(JobList& list)
     {
         for (each<JobList> i = list; i; ++i)
@@ -69,6 +121,99 @@ struct JobQueue::Impl
 
         list.clear();
     }
+
+    size_t delete_deque_jobs()
+    {
+        size_t deleted_job_count = 0;
+
+        for (each<vector<WorkerDeque*>> i = m_deques; i; ++i)
+        {
+            WorkerDeque& d = **i;
+            Spinlock::ScopedLock lock(d.m_lock);
+
+            for (each<deque<JobInfo>> j = d.m_jobs; j; ++j)
+            {
+                if (j->m_owned)
+                    delete j->m_job;
+            }
+
+            deleted_job_count += d.m_jobs.size();
+            d.m_job_count -= d.m_jobs.size();
+            d.m_jobs.clear();
+        }
+
+        return deleted_job_count;
+    }
+
+    void push_job(const JobInfo& job_info, const size_t deque_index)
+    {
+        // Count the job before it becomes visible so that the counters never underflow.
+        ++m_ws_total_job_count;
+        ++m_ws_scheduled_job_count;
+
+        WorkerDeque& d = *m_deques[deque_index];
+
+        {
+            Spinlock::ScopedLock lock(d.m_lock);
+            d.m_jobs.push_back(job_info);
+            ++d.m_job_count;
+        }
+
+        // Only take the mutex if some worker threads are waiting for jobs.
+        if (m_idle_worker_count > 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_idle_worker_event.notify_all();
+        }
+    }
+
+    JobInfo pop_job(const size_t worker_index)
+    {
+        const size_t deque_count = m_deques.size();
+
+        // Worker threads take jobs from the front of their own deque and steal jobs from the
+        // back of other deques, which preserves the order in which jobs were scheduled as much
+        // as possible (for instance the tile ordering of the generic frame renderer).
+        for (size_t k = 0; k < deque_count; ++k)
+        {
+            WorkerDeque& d = *m_deques[(worker_index + k) % deque_count];
+
+            if (d.m_job_count == 0)
+                continue;
+
+            Spinlock::ScopedLock lock(d.m_lock);
+
+            if (d.m_jobs.empty())
+                continue;
+
+            const JobInfo job_info = k == 0 ? d.m_jobs.front() : d.m_jobs.back();
+
+            if (k == 0)
+                d.m_jobs.pop_front();
+            else
+                d.m_jobs.pop_back();
+
+            --d.m_job_count;
+            --m_ws_scheduled_job_count;
+
+            return job_info;
+        }
+
+        return JobInfo(nullptr, false);
+    }
+
+    void retire_job(const JobInfo& job_info)
+    {
+        if (job_info.m_owned)
+            delete job_info.m_job;
+
+        // Wake up threads waiting for completion when the last job is retired.
+        if (--m_ws_total_job_count == 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_event.notify_all();
+        }
+    }
 };
 
 JobQueue::JobQueue()
@@ -82,15 +227,24 @@ JobQueue::~JobQueue()
 
     // At this point, no job must be running.
     assert(impl->m_running_jobs.empty());
+    assert(impl->m_ws_total_job_count == impl->m_ws_scheduled_job_count);
 
     // Delete all scheduled jobs that the queue owns.
     Impl::delete_jobs(impl->m_scheduled_jobs);
+    impl->delete_deque_jobs();
 
     delete impl;
 }
 
 void JobQueue::clear_scheduled_jobs()
 {
+    if (impl->is_work_stealing_enabled())
+    {
+        const size_t deleted_job_count = impl->delete_deque_jobs();
+        impl->m_ws_scheduled_job_count -= deleted_job_count;
+        impl->m_ws_total_job_count -= deleted_job_count;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->delete_jobs(impl->m_scheduled_jobs);
@@ -101,6 +255,9 @@ void JobQueue::clear_scheduled_jobs()
 
 bool JobQueue::has_scheduled_jobs() const
 {
+    if (impl->is_work_stealing_enabled())
+        return impl->m_ws_scheduled_job_count > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty();
@@ -108,6 +265,9 @@ bool JobQueue::has_scheduled_jobs() const
 
 bool JobQueue::has_running_jobs() const
 {
+    if (impl->is_work_stealing_enabled())
+        return get_running_job_count() > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_running_jobs.empty();
@@ -115,6 +275,9 @@ bool JobQueue::has_running_jobs() const
 
 bool JobQueue::has_scheduled_or_running_jobs() const
 {
+    if (impl->is_work_stealing_enabled())
+        return impl->m_ws_total_job_count > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty();
@@ -122,6 +285,9 @@ bool JobQueue::has_scheduled_or_running_jobs() const
 
 size_t JobQueue::get_scheduled_job_count() const
 {
+    if (impl->is_work_stealing_enabled())
+        return impl->m_ws_scheduled_job_count;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size();
@@ -129,6 +295,14 @@ size_t JobQueue::get_scheduled_job_count() const
 
 size_t JobQueue::get_running_job_count() const
 {
+    if (impl->is_work_stealing_enabled())
+    {
+        // Read the scheduled job count last: it may only decrease in favor of the total count.
+        const size_t total_job_count = impl->m_ws_total_job_count;
+        const size_t scheduled_job_count = impl->m_ws_scheduled_job_count;
+        return total_job_count > scheduled_job_count ? total_job_count - scheduled_job_count : 0;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_running_jobs.size();
@@ -136,6 +310,9 @@ size_t JobQueue::get_running_job_count() const
 
 size_t JobQueue::get_total_job_count() const
 {
+    if (impl->is_work_stealing_enabled())
+        return impl->m_ws_total_job_count;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size() + impl->m_running_jobs.size();
@@ -145,6 +322,18 @@ void JobQueue::schedule(IJob* job, const bool transfer_ownership)
 {
     assert(job);
 
+    if (impl->is_work_stealing_enabled())
+    {
+        // Jobs scheduled by a worker thread go to its own deque.
+        const size_t deque_index =
+            s_worker_job_queue == this
+                ? s_worker_index
+                : impl->m_next_deque++ % impl->m_deques.size();
+
+        impl->push_job(JobInfo(job, transfer_ownership), deque_index);
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
@@ -158,12 +347,18 @@ void JobQueue::wait_until_completion()
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait until there is no more scheduled or running jobs.
-    while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty())
+    while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty() || impl->m_ws_total_job_count > 0)
         impl->m_event.wait(lock);
 }
 
 JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
 {
+    if (impl->is_work_stealing_enabled())
+    {
+        const size_t worker_index = s_worker_job_queue == this ? s_worker_index : 0;
+        return RunningJobInfo(impl->pop_job(worker_index), impl->m_running_jobs.end());
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return acquire_scheduled_job_no_lock();
@@ -188,6 +383,29 @@ JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_no_lock()
 
 JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
 {
+    if (impl->is_work_stealing_enabled())
+    {
+        const size_t worker_index = s_worker_job_queue == this ? s_worker_index : 0;
+
+        while (!abort_switch.is_aborted())
+        {
+            const JobInfo job_info = impl->pop_job(worker_index);
+
+            if (job_info.m_job)
+                return RunningJobInfo(job_info, impl->m_running_jobs.end());
+
+            // Wait for a scheduled job to be available. Workers must be counted as idle
+            // before the scheduled job count is checked, see Impl::push_job().
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            ++impl->m_idle_worker_count;
+            while (!abort_switch.is_aborted() && impl->m_ws_scheduled_job_count == 0)   // order matters
+                impl->m_idle_worker_event.wait(lock);
+            --impl->m_idle_worker_count;
+        }
+
+        return RunningJobInfo(JobInfo(nullptr, false), impl->m_running_jobs.end());
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait for a scheduled job to be available.
@@ -199,6 +417,12 @@ JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_swi
 
 void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 {
+    if (impl->is_work_stealing_enabled())
+    {
+        impl->retire_job(running_job_info.first);
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Remove the job from the running list.
@@ -217,6 +441,42 @@ void JobQueue::signal_event()
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->m_event.notify_all();
+    impl->m_idle_worker_event.notify_all();
+}
+
+void JobQueue::enable_work_stealing(const size_t worker_count)
+{
+    assert(worker_count > 0);
+
+    if (impl->m_deques.size() == worker_count)
+        return;
+
+    // Work stealing can only be enabled once, before any job runs.
+    assert(!impl->is_work_stealing_enabled());
+    assert(impl->m_running_jobs.empty());
+
+    for (size_t i = 0; i < worker_count; ++i)
+        impl->m_deques.push_back(new Impl::WorkerDeque());
+
+    // Spread the jobs that were already scheduled over the deques.
+    for (each<JobList> i = impl->m_scheduled_jobs; i; ++i)
+        impl->push_job(*i, impl->m_next_deque++ % worker_count);
+
+    impl->m_scheduled_jobs.clear();
+}
+
+void JobQueue::register_worker_thread(const size_t worker_index)
+{
+    assert(!impl->is_work_stealing_enabled() || worker_index < impl->m_deques.size());
+
+    s_worker_job_queue = this;
+    s_worker_index = worker_index;
+}
+
+void JobQueue::unregister_worker_thread()
+{
+    if (s_worker_job_queue == this)
+        s_worker_job_queue = nullptr;
 }
 
 }   // namespace foundation
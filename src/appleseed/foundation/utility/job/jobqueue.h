@@ -66,6 +66,12 @@ namespace foundation
 //   - scheduled: the job was inserted into the job queue, but hasn't yet been executed
 //   - running: the job is currently being executed
 //
+// By default, scheduled jobs are kept in a single list shared by all worker threads.
+// When the job queue is served by a JobManager created with the JobManager::WorkStealing
+// flag, each worker thread gets its own deque of scheduled jobs instead: jobs scheduled
+// by a worker thread go to its own deque, jobs scheduled by other threads are spread over
+// all deques, and a worker thread whose deque is empty steals jobs from other deques.
+//
 
 class APPLESEED_DLLSYMBOL JobQueue
   : public NonCopyable
@@ -106,6 +112,7 @@ class APPLESEED_DLLSYMBOL JobQueue
     void wait_until_completion();
 
   private:
+    friend class JobManager;
     friend class WorkerThread;
 
     struct Impl;
@@ -147,6 +154,17 @@ class APPLESEED_DLLSYMBOL JobQueue
 
     // Signal a queue event.
     void signal_event();
+
+    // Give each of a given number of worker threads its own deque of scheduled jobs.
+    // Jobs already scheduled are spread over the deques. Not thread-safe.
+    void enable_work_stealing(const size_t worker_count);
+
+    // Declare the calling thread as the worker thread with a given index.
+    // With work stealing, jobs scheduled by this thread go to its own deque.
+    void register_worker_thread(const size_t worker_index);
+
+    // Declare that the calling thread is no longer a worker thread of this queue.
+    void unregister_worker_thread();
 };
 
 }   // namespace foundation
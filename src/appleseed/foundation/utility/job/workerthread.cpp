@@ -35,6 +35,7 @@
 #ifdef APPLESEED_USE_SSE42
 #include "foundation/platform/sse.h"
 #endif
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/job/ijob.h"
 #include "foundation/utility/job/jobmanager.h"
@@ -136,10 +137,33 @@ void WorkerThread::set_thread_name()
     set_current_thread_name(thread_name);
 }
 
+void WorkerThread::pin_thread()
+{
+    // Consecutive worker threads go to consecutive logical cores. Operating systems usually
+    // number logical cores so that this fills physical cores (and NUMA nodes) one at a time.
+    const size_t core_count = System::get_logical_cpu_core_count();
+    const size_t logical_core = m_index % core_count;
+
+    if (!set_current_thread_affinity(logical_core))
+    {
+        LOG_DEBUG(
+            m_logger,
+            "worker thread " FMT_SIZE_T ": could not bind thread to logical core " FMT_SIZE_T ".",
+            m_index,
+            logical_core);
+    }
+}
+
 void WorkerThread::run()
 {
     set_thread_name();
 
+    if (m_flags & JobManager::PinWorkerThreads)
+        pin_thread();
+
+    // Jobs scheduled by this thread are tied to it when work stealing is enabled.
+    m_job_queue.register_worker_thread(m_index);
+
 #if defined APPLESEED_WITH_EMBREE && defined APPLESEED_USE_SSE42
 
     //
@@ -201,6 +225,8 @@ void WorkerThread::run()
             break;
         }
     }
+
+    m_job_queue.unregister_worker_thread();
 }
 
 bool WorkerThread::execute_job(IJob& job)
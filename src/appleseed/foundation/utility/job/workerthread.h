@@ -113,6 +113,9 @@ class WorkerThread
 
     void set_thread_name();
 
+    // Bind the thread to a logical core. See JobManager::PinWorkerThreads.
+    void pin_thread();
+
     // Main line of the worker thread.
     void run();
 
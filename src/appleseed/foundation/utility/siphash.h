@@ -36,6 +36,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstring>
 
 namespace foundation
 {
@@ -93,4 +94,44 @@ inline uint64 siphash24(const uint64 a, const uint64 b)
     return siphash24(&pair, sizeof(pair));
 }
 
+
+//
+// Incrementally hash a sequence of byte ranges. Each range is hashed using
+// the hash of all preceding ranges as key, so the result depends on both
+// the content and the boundaries of the ranges.
+//
+
+class SipHashAccumulator
+{
+  public:
+    SipHashAccumulator()
+      : m_hash(0)
+    {
+    }
+
+    void append(const void* bytes, const size_t size)
+    {
+        m_hash = siphash24(bytes, size, m_hash, size);
+    }
+
+    void append(const char* str)
+    {
+        append(str, std::strlen(str) + 1);
+    }
+
+    template <typename T>
+    void append(const T& object)
+    {
+        append(&object, sizeof(T));
+    }
+
+    uint64 get_hash() const
+    {
+        return m_hash;
+    }
+
+  private:
+    uint64 m_hash;
+};
+
 }   // namespace foundation
@@ -30,6 +30,7 @@
 
 // API headers.
 #include "renderer/modeling/volume/genericvolume.h"
+#include "renderer/modeling/volume/heterogeneousvolume.h"
 #include "renderer/modeling/volume/ivolumefactory.h"
 #include "renderer/modeling/volume/volume.h"
 #include "renderer/modeling/volume/volumefactoryregistrar.h"
@@ -34,7 +34,9 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/job/iabortswitch.h"
 
 // BCD headers.
@@ -60,22 +62,24 @@ namespace renderer
 namespace
 {
 
-    void image_to_deepimage(const Image& src, Deepimf& dst)
+    void image_to_deepimage(const Image& src, const AABB2u& rect, Deepimf& dst)
     {
-        const CanvasProperties& src_props = src.properties();
-        assert(src_props.m_channel_count == 4);
+        assert(src.properties().m_channel_count == 4);
+
+        const size_t width = rect.extent()[0] + 1;
+        const size_t height = rect.extent()[1] + 1;
 
         dst.resize(
-            static_cast<int>(src_props.m_canvas_width),
-            static_cast<int>(src_props.m_canvas_height),
+            static_cast<int>(width),
+            static_cast<int>(height),
             3);
 
-        for (size_t j = 0; j < src_props.m_canvas_height; ++j)
+        for (size_t j = 0; j < height; ++j)
         {
-            for (size_t i = 0; i < src_props.m_canvas_width; ++i)
+            for (size_t i = 0; i < width; ++i)
             {
                 Color4f c;
-                src.get_pixel(i, j, c);
+                src.get_pixel(rect.min[0] + i, rect.min[1] + j, c);
                 c.unpremultiply_in_place();
 
                 dst.set(static_cast<int>(j), static_cast<int>(i), 0, c[0]);
@@ -85,6 +89,18 @@ namespace
         }
     }
 
+    void image_to_deepimage(const Image& src, Deepimf& dst)
+    {
+        const CanvasProperties& src_props = src.properties();
+
+        image_to_deepimage(
+            src,
+            AABB2u(
+                Vector2u(0, 0),
+                Vector2u(src_props.m_canvas_width - 1, src_props.m_canvas_height - 1)),
+            dst);
+    }
+
     void deepimage_to_image(const Deepimf& src, Image& dst)
     {
         const CanvasProperties& dst_props = dst.properties();
@@ -206,6 +222,14 @@ namespace
 
 }
 
+size_t get_denoising_radius(const DenoiserOptions& options)
+{
+    // A pixel is influenced by the patches centered in its search window, each scale
+    // doubles the radius and the interpolation between scales adds one pixel per scale.
+    const size_t radius = 2 * options.m_patch_radius + options.m_search_window_radius + 1;
+    return options.m_num_scales > 1 ? radius << (options.m_num_scales - 1) : radius;
+}
+
 bool denoise_beauty_image(
     Image&                  img,
     Deepimf&                num_samples,
@@ -281,4 +305,73 @@ bool denoise_aov_image(
     return success;
 }
 
+bool denoise_beauty_image_region(
+    const Image&            img,
+    const AABB2u&           rect,
+    Deepimf&                num_samples,
+    Deepimf&                histograms,
+    Deepimf&                covariances,
+    const DenoiserOptions&  options,
+    IAbortSwitch*           abort_switch,
+    Deepimf&                denoised)
+{
+    Deepimf src;
+    image_to_deepimage(img, rect, src);
+
+    if (options.m_prefilter_spikes)
+    {
+        SpikeRemovalFilter::filter(
+            src,
+            num_samples,
+            histograms,
+            covariances,
+            options.m_prefilter_threshold_stddev_factor);
+    }
+
+    denoised = src;
+
+    return
+        do_denoise_image(
+            src,
+            num_samples,
+            histograms,
+            covariances,
+            options,
+            abort_switch,
+            denoised);
+}
+
+bool denoise_aov_image_region(
+    const Image&            img,
+    const AABB2u&           rect,
+    const Deepimf&          num_samples,
+    const Deepimf&          histograms,
+    const Deepimf&          covariances,
+    const DenoiserOptions&  options,
+    IAbortSwitch*           abort_switch,
+    Deepimf&                denoised)
+{
+    Deepimf src;
+    image_to_deepimage(img, rect, src);
+
+    if (options.m_prefilter_spikes)
+    {
+        SpikeRemovalFilter::filter(
+            src,
+            options.m_prefilter_threshold_stddev_factor);
+    }
+
+    denoised = src;
+
+    return
+        do_denoise_image(
+            src,
+            num_samples,
+            histograms,
+            covariances,
+            options,
+            abort_switch,
+            denoised);
+}
+
 }   // namespace renderer
@@ -28,9 +28,15 @@
 
 #pragma once
 
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+
 // BCD headers.
 #include "bcd/DeepImage.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Image; }
@@ -69,6 +75,9 @@ class DenoiserOptions
     }
 };
 
+// Return the distance in pixels beyond which pixels do not influence the denoised value of a pixel.
+size_t get_denoising_radius(const DenoiserOptions& options);
+
 bool denoise_beauty_image(
     foundation::Image&          img,
     bcd::Deepimf&               num_samples,
@@ -85,4 +94,28 @@ bool denoise_aov_image(
     const DenoiserOptions&      options,
     foundation::IAbortSwitch*   abort_switch);
 
+// Denoise the pixels of an image within a rectangle (inclusive on all sides) and store
+// them into `denoised`, leaving the image untouched. The statistics images cover the
+// rectangle. Pixels closer to the sides of the rectangle than the denoising radius are
+// denoised using fewer neighbors than when denoising the whole image.
+bool denoise_beauty_image_region(
+    const foundation::Image&    img,
+    const foundation::AABB2u&   rect,
+    bcd::Deepimf&               num_samples,
+    bcd::Deepimf&               histograms,
+    bcd::Deepimf&               covariances,
+    const DenoiserOptions&      options,
+    foundation::IAbortSwitch*   abort_switch,
+    bcd::Deepimf&               denoised);
+
+bool denoise_aov_image_region(
+    const foundation::Image&    img,
+    const foundation::AABB2u&   rect,
+    const bcd::Deepimf&         num_samples,
+    const bcd::Deepimf&         histograms,
+    const bcd::Deepimf&         covariances,
+    const DenoiserOptions&      options,
+    foundation::IAbortSwitch*   abort_switch,
+    bcd::Deepimf&               denoised);
+
 }   // namespace renderer
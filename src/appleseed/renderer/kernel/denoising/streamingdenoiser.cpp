@@ -0,0 +1,407 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "streamingdenoiser.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/aov/aov.h"
+#include "renderer/modeling/aov/aovcontainer.h"
+#include "renderer/modeling/aov/denoiseraov.h"
+#include "renderer/modeling/frame/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace bcd;
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    size_t get_memory_size(const vector<Deepimf>& images)
+    {
+        size_t size = 0;
+
+        for (const Deepimf& image : images)
+            size += static_cast<size_t>(image.getSize()) * sizeof(float);
+
+        return size;
+    }
+
+    // Return the pixels of a tile (inclusive on all sides).
+    AABB2u get_tile_rect(
+        const CanvasProperties&     props,
+        const size_t                tile_x,
+        const size_t                tile_y)
+    {
+        const size_t x0 = tile_x * props.m_tile_width;
+        const size_t y0 = tile_y * props.m_tile_height;
+
+        return
+            AABB2u(
+                Vector2u(x0, y0),
+                Vector2u(
+                    x0 + props.get_tile_width(tile_x) - 1,
+                    y0 + props.get_tile_height(tile_y) - 1));
+    }
+
+    // Copy a rectangle of an image into another image.
+    void crop(
+        const Deepimf&              src,
+        const size_t                x0,
+        const size_t                y0,
+        const size_t                width,
+        const size_t                height,
+        Deepimf&                    dst)
+    {
+        dst.resize(static_cast<int>(width), static_cast<int>(height), src.getDepth());
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                dst.set(
+                    static_cast<int>(y),
+                    static_cast<int>(x),
+                    &src.get(static_cast<int>(y0 + y), static_cast<int>(x0 + x), 0));
+            }
+        }
+    }
+}
+
+
+//
+// StreamingDenoiser class implementation.
+//
+
+StreamingDenoiser::StreamingDenoiser(
+    const Frame&                frame,
+    DenoiserAOV&                denoiser_aov,
+    const DenoiserOptions&      options,
+    IAbortSwitch*               abort_switch)
+  : m_frame(frame)
+  , m_denoiser_aov(denoiser_aov)
+  , m_options(options)
+  , m_abort_switch(abort_switch)
+  , m_denoised_tile_count(0)
+  , m_pending_memory_size(0)
+  , m_peak_memory_size(0)
+  , m_accumulator_channel_count(0)
+  , m_denoising_time(0.0)
+{
+    assert(denoiser_aov.has_tiled_storage());
+
+    // Tiles are denoised in parallel by the rendering threads.
+    m_options.m_num_cores = 1;
+
+    // Collect the images to denoise.
+    m_images.push_back(&frame.image());
+    for (const AOV& aov : frame.aovs())
+    {
+        if (aov.has_color_data())
+            m_images.push_back(&aov.get_image());
+    }
+
+    const CanvasProperties& props = frame.image().properties();
+    m_radius = get_denoising_radius(m_options);
+    m_tile_radius_x = (m_radius + props.m_tile_width - 1) / props.m_tile_width;
+    m_tile_radius_y = (m_radius + props.m_tile_height - 1) / props.m_tile_height;
+
+    // Neighborhoods are symmetric: a tile belongs to as many neighborhoods as it has neighbors.
+    m_tiles.resize(props.m_tile_count);
+    for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+        {
+            const AABB2u neighborhood = get_tile_neighborhood(tx, ty);
+            const Vector2u extent = neighborhood.extent();
+            const size_t neighbor_count = (extent[0] + 1) * (extent[1] + 1);
+
+            TileState& tile = m_tiles[ty * props.m_tile_count_x + tx];
+            tile.m_missing_tile_count = neighbor_count;
+            tile.m_user_count = neighbor_count;
+        }
+    }
+}
+
+void StreamingDenoiser::on_tile_end(
+    const size_t                tile_x,
+    const size_t                tile_y)
+{
+    const CanvasProperties& props = m_frame.image().properties();
+    const AABB2u neighborhood = get_tile_neighborhood(tile_x, tile_y);
+
+    // Find the tiles whose neighborhoods are now complete.
+    vector<size_t> ready_tiles;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        for (size_t ty = neighborhood.min[1]; ty <= neighborhood.max[1]; ++ty)
+        {
+            for (size_t tx = neighborhood.min[0]; tx <= neighborhood.max[0]; ++tx)
+            {
+                const size_t tile_index = ty * props.m_tile_count_x + tx;
+                assert(m_tiles[tile_index].m_missing_tile_count > 0);
+
+                if (--m_tiles[tile_index].m_missing_tile_count == 0)
+                    ready_tiles.push_back(tile_index);
+            }
+        }
+
+        update_peak_memory_size();
+    }
+
+    for (const size_t tile_index : ready_tiles)
+    {
+        if (m_abort_switch && m_abort_switch->is_aborted())
+            break;
+
+        denoise_tile(
+            tile_index % props.m_tile_count_x,
+            tile_index / props.m_tile_count_x);
+    }
+}
+
+bool StreamingDenoiser::is_complete() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_denoised_tile_count == m_tiles.size();
+}
+
+void StreamingDenoiser::print_statistics() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    // Memory that denoising the whole frame after rendering requires: the accumulators,
+    // the sample counts, the covariances and the noisy and denoised colors.
+    const CanvasProperties& props = m_frame.image().properties();
+    const size_t whole_frame_memory_size =
+        props.m_pixel_count * (m_accumulator_channel_count + 1 + 6 + 3 + 3) * sizeof(float);
+
+    Statistics stats;
+    stats.insert("denoised tiles", m_denoised_tile_count);
+    stats.insert("denoising radius", m_radius, "pixels");
+    stats.insert_time("denoising time", m_denoising_time);
+    stats.insert_size("peak memory", m_peak_memory_size);
+    stats.insert_size("whole frame memory", whole_frame_memory_size);
+
+    RENDERER_LOG_INFO(
+        "%s",
+        StatisticsVector::make("streaming denoiser statistics", stats).to_string().c_str());
+}
+
+AABB2u StreamingDenoiser::get_tile_neighborhood(
+    const size_t                tile_x,
+    const size_t                tile_y) const
+{
+    const CanvasProperties& props = m_frame.image().properties();
+
+    return
+        AABB2u(
+            Vector2u(
+                tile_x > m_tile_radius_x ? tile_x - m_tile_radius_x : 0,
+                tile_y > m_tile_radius_y ? tile_y - m_tile_radius_y : 0),
+            Vector2u(
+                min(tile_x + m_tile_radius_x, props.m_tile_count_x - 1),
+                min(tile_y + m_tile_radius_y, props.m_tile_count_y - 1)));
+}
+
+void StreamingDenoiser::denoise_tile(
+    const size_t                tile_x,
+    const size_t                tile_y)
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    const CanvasProperties& props = m_frame.image().properties();
+    const AABB2u tile_rect = get_tile_rect(props, tile_x, tile_y);
+
+    // Pixels within the denoising radius of the tile.
+    const AABB2u rect(
+        Vector2u(
+            tile_rect.min[0] > m_radius ? tile_rect.min[0] - m_radius : 0,
+            tile_rect.min[1] > m_radius ? tile_rect.min[1] - m_radius : 0),
+        Vector2u(
+            min(tile_rect.max[0] + m_radius, props.m_canvas_width - 1),
+            min(tile_rect.max[1] + m_radius, props.m_canvas_height - 1)));
+
+    Deepimf num_samples, histograms, covariances;
+    m_denoiser_aov.extract_region(rect, num_samples, histograms, covariances);
+
+    // Denoise the neighborhood and only keep the pixels of the tile.
+    vector<Deepimf> denoised(m_images.size());
+    for (size_t i = 0, e = m_images.size(); i < e; ++i)
+    {
+        Deepimf region;
+
+        const bool success =
+            i == 0
+                ? denoise_beauty_image_region(
+                      *m_images[i],
+                      rect,
+                      num_samples,
+                      histograms,
+                      covariances,
+                      m_options,
+                      m_abort_switch,
+                      region)
+                : denoise_aov_image_region(
+                      *m_images[i],
+                      rect,
+                      num_samples,
+                      histograms,
+                      covariances,
+                      m_options,
+                      m_abort_switch,
+                      region);
+
+        if (success)
+        {
+            crop(
+                region,
+                tile_rect.min[0] - rect.min[0],
+                tile_rect.min[1] - rect.min[1],
+                tile_rect.extent()[0] + 1,
+                tile_rect.extent()[1] + 1,
+                denoised[i]);
+        }
+    }
+
+    stopwatch.measure();
+
+    // Find the tiles that are no longer needed by any neighborhood.
+    const AABB2u neighborhood = get_tile_neighborhood(tile_x, tile_y);
+    vector<size_t> completed_tiles;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        TileState& tile = m_tiles[tile_y * props.m_tile_count_x + tile_x];
+        tile.m_denoised.swap(denoised);
+        m_pending_memory_size += get_memory_size(tile.m_denoised);
+
+        ++m_denoised_tile_count;
+        m_accumulator_channel_count = 3 + 6 + static_cast<size_t>(histograms.getDepth());
+        m_denoising_time += stopwatch.get_seconds();
+
+        update_peak_memory_size();
+
+        for (size_t ty = neighborhood.min[1]; ty <= neighborhood.max[1]; ++ty)
+        {
+            for (size_t tx = neighborhood.min[0]; tx <= neighborhood.max[0]; ++tx)
+            {
+                const size_t tile_index = ty * props.m_tile_count_x + tx;
+                assert(m_tiles[tile_index].m_user_count > 0);
+
+                if (--m_tiles[tile_index].m_user_count == 0)
+                    completed_tiles.push_back(tile_index);
+            }
+        }
+    }
+
+    for (const size_t tile_index : completed_tiles)
+    {
+        write_tile(
+            tile_index % props.m_tile_count_x,
+            tile_index / props.m_tile_count_x);
+    }
+}
+
+void StreamingDenoiser::write_tile(
+    const size_t                tile_x,
+    const size_t                tile_y)
+{
+    const CanvasProperties& props = m_frame.image().properties();
+    const AABB2u tile_rect = get_tile_rect(props, tile_x, tile_y);
+
+    vector<Deepimf> denoised;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        TileState& tile = m_tiles[tile_y * props.m_tile_count_x + tile_x];
+        denoised.swap(tile.m_denoised);
+        m_pending_memory_size -= get_memory_size(denoised);
+    }
+
+    // No other tile reads the noisy pixels of this tile anymore.
+    for (size_t i = 0, e = denoised.size(); i < e; ++i)
+    {
+        if (denoised[i].getSize() == 0)
+            continue;
+
+        Image& image = *m_images[i];
+
+        for (size_t y = tile_rect.min[1]; y <= tile_rect.max[1]; ++y)
+        {
+            for (size_t x = tile_rect.min[0]; x <= tile_rect.max[0]; ++x)
+            {
+                const int dx = static_cast<int>(x - tile_rect.min[0]);
+                const int dy = static_cast<int>(y - tile_rect.min[1]);
+
+                Color4f c;
+                image.get_pixel(x, y, c);
+
+                c[0] = denoised[i].get(dy, dx, 0);
+                c[1] = denoised[i].get(dy, dx, 1);
+                c[2] = denoised[i].get(dy, dx, 2);
+
+                c.premultiply_in_place();
+                image.set_pixel(x, y, c);
+            }
+        }
+    }
+
+    m_denoiser_aov.release_tile(tile_x, tile_y);
+}
+
+void StreamingDenoiser::update_peak_memory_size()
+{
+    m_peak_memory_size =
+        max(
+            m_peak_memory_size,
+            m_denoiser_aov.get_memory_size() + m_pending_memory_size);
+}
+
+}   // namespace renderer
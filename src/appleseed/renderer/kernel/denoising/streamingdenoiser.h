@@ -0,0 +1,131 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/denoising/denoiser.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+
+// BCD headers.
+#include "bcd/DeepImage.h"
+
+// Boost headers.
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class Image; }
+namespace renderer      { class DenoiserAOV; }
+namespace renderer      { class Frame; }
+
+namespace renderer
+{
+
+//
+// Denoises the tiles of a frame while its last pass is being rendered.
+//
+// A tile is denoised as soon as all the tiles within the denoising radius around it
+// are rendered, using only the pixels of this neighborhood. Denoised pixels are kept
+// aside until every tile whose neighborhood contains the tile is denoised; they are
+// then written to the frame and the denoiser accumulators of the tile are released.
+// Only the band of tiles around the tiles being rendered is thus kept in memory.
+//
+
+class StreamingDenoiser
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. The denoiser AOV must use tiled storage.
+    StreamingDenoiser(
+        const Frame&                frame,
+        DenoiserAOV&                denoiser_aov,
+        const DenoiserOptions&      options,
+        foundation::IAbortSwitch*   abort_switch);
+
+    // Notify the denoiser that a tile was rendered for the last time and denoise
+    // the tiles whose neighborhoods are now complete. Thread-safe.
+    void on_tile_end(
+        const size_t                tile_x,
+        const size_t                tile_y);
+
+    // Return true if all tiles of the frame were denoised.
+    bool is_complete() const;
+
+    // Print denoising statistics.
+    void print_statistics() const;
+
+  private:
+    struct TileState
+    {
+        size_t                      m_missing_tile_count;   // number of tiles of the neighborhood not yet rendered
+        size_t                      m_user_count;           // number of tiles whose neighborhood contains this tile and which are not yet denoised
+        std::vector<bcd::Deepimf>   m_denoised;             // denoised pixels, one image per denoised frame image
+    };
+
+    const Frame&                    m_frame;
+    DenoiserAOV&                    m_denoiser_aov;
+    DenoiserOptions                 m_options;
+    foundation::IAbortSwitch*       m_abort_switch;
+    std::vector<foundation::Image*> m_images;               // main image followed by the AOV images with color data
+    size_t                          m_radius;               // denoising radius, in pixels
+    size_t                          m_tile_radius_x;        // denoising radius, in tiles
+    size_t                          m_tile_radius_y;
+
+    mutable boost::mutex            m_mutex;
+    std::vector<TileState>          m_tiles;
+    size_t                          m_denoised_tile_count;
+    size_t                          m_pending_memory_size;  // size in bytes of the denoised pixels not yet written to the frame
+    size_t                          m_peak_memory_size;
+    size_t                          m_accumulator_channel_count;
+    double                          m_denoising_time;       // cumulated over all threads, in seconds
+
+    // Return the tiles within the denoising radius of a given tile (inclusive on all sides).
+    foundation::AABB2u get_tile_neighborhood(
+        const size_t                tile_x,
+        const size_t                tile_y) const;
+
+    void denoise_tile(
+        const size_t                tile_x,
+        const size_t                tile_y);
+
+    void write_tile(
+        const size_t                tile_x,
+        const size_t                tile_y);
+
+    void update_peak_memory_size();
+};
+
+}   // namespace renderer
@@ -0,0 +1,292 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "alphamask.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/bitmask.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// AlphaMask class implementation.
+//
+
+AlphaMask::AlphaMask(const BitMask2& texels)
+  : m_width(texels.get_width())
+  , m_height(texels.get_height())
+  , m_max_x(static_cast<float>(m_width) - 1.0f)
+  , m_max_y(static_cast<float>(m_height) - 1.0f)
+  , m_block_count_x((m_width + BlockSize - 1) >> BlockSizeLog)
+  , m_block_count_y((m_height + BlockSize - 1) >> BlockSizeLog)
+{
+    assert(m_width > 0);
+    assert(m_height > 0);
+
+    // Build the blocks and the first level of the hierarchy.
+    m_blocks.resize(m_block_count_x * m_block_count_y);
+    m_levels.resize(1);
+    m_levels[0].m_width = m_block_count_x;
+    m_levels[0].m_height = m_block_count_y;
+    m_levels[0].m_coverage.resize(m_blocks.size());
+
+    for (size_t by = 0; by < m_block_count_y; ++by)
+    {
+        for (size_t bx = 0; bx < m_block_count_x; ++bx)
+        {
+            const size_t x0 = bx << BlockSizeLog;
+            const size_t y0 = by << BlockSizeLog;
+            const size_t x1 = min<size_t>(x0 + BlockSize, m_width);
+            const size_t y1 = min<size_t>(y0 + BlockSize, m_height);
+
+            uint64 bits = 0;
+            uint64 texel_mask = 0;
+
+            for (size_t y = y0; y < y1; ++y)
+            {
+                for (size_t x = x0; x < x1; ++x)
+                {
+                    const uint64 bit = uint64(1) << (((y - y0) << BlockSizeLog) + (x - x0));
+                    texel_mask |= bit;
+
+                    if (texels.is_set(x, y))
+                        bits |= bit;
+                }
+            }
+
+            const size_t block_index = by * m_block_count_x + bx;
+            uint8& coverage = m_levels[0].m_coverage[block_index];
+
+            if (bits == 0)
+            {
+                m_blocks[block_index] = TransparentBlock;
+                coverage = Transparent;
+            }
+            else if (bits == texel_mask)
+            {
+                m_blocks[block_index] = OpaqueBlock;
+                coverage = Opaque;
+            }
+            else
+            {
+                m_blocks[block_index] = static_cast<uint32>(m_partial_blocks.size());
+                m_partial_blocks.push_back(bits);
+                coverage = Partial;
+            }
+        }
+    }
+
+    // Build the upper levels of the hierarchy, until a single node covers the whole mask.
+    while (m_levels.back().m_width > 1 || m_levels.back().m_height > 1)
+    {
+        m_levels.push_back(Level());
+
+        const Level& child = m_levels[m_levels.size() - 2];
+        Level& parent = m_levels.back();
+
+        parent.m_width = (child.m_width + 1) / 2;
+        parent.m_height = (child.m_height + 1) / 2;
+        parent.m_coverage.resize(parent.m_width * parent.m_height);
+
+        for (size_t ny = 0; ny < parent.m_height; ++ny)
+        {
+            for (size_t nx = 0; nx < parent.m_width; ++nx)
+            {
+                const size_t cx1 = min<size_t>(2 * nx + 2, child.m_width);
+                const size_t cy1 = min<size_t>(2 * ny + 2, child.m_height);
+
+                uint8 coverage = child.m_coverage[2 * ny * child.m_width + 2 * nx];
+
+                for (size_t cy = 2 * ny; cy < cy1; ++cy)
+                {
+                    for (size_t cx = 2 * nx; cx < cx1; ++cx)
+                    {
+                        if (child.m_coverage[cy * child.m_width + cx] != coverage)
+                            coverage = Partial;
+                    }
+                }
+
+                parent.m_coverage[ny * parent.m_width + nx] = coverage;
+            }
+        }
+    }
+}
+
+AlphaMask::Coverage AlphaMask::get_coverage(
+    const Vector2f&         uv0,
+    const Vector2f&         uv1,
+    const Vector2f&         uv2) const
+{
+    // UV coordinates interpolated at a hit point are not bit-exact with respect to the
+    // vertex UV coordinates, so extend the bounding rectangle by one texel on each side.
+    const size_t x0 = get_texel_x(min(min(uv0[0], uv1[0]), uv2[0]));
+    const size_t y0 = get_texel_y(min(min(uv0[1], uv1[1]), uv2[1]));
+    const size_t x1 = get_texel_x(max(max(uv0[0], uv1[0]), uv2[0]));
+    const size_t y1 = get_texel_y(max(max(uv0[1], uv1[1]), uv2[1]));
+
+    return
+        get_coverage(
+            x0 > 0 ? x0 - 1 : 0,
+            y0 > 0 ? y0 - 1 : 0,
+            min(x1 + 1, m_width - 1),
+            min(y1 + 1, m_height - 1));
+}
+
+AlphaMask::Coverage AlphaMask::get_coverage(
+    const size_t            x0,
+    const size_t            y0,
+    const size_t            x1,
+    const size_t            y1) const
+{
+    assert(x0 <= x1 && x1 < m_width);
+    assert(y0 <= y1 && y1 < m_height);
+
+    return classify_node(m_levels.size() - 1, 0, 0, x0, y0, x1, y1);
+}
+
+size_t AlphaMask::get_memory_size() const
+{
+    size_t size =
+          sizeof(*this)
+        + m_blocks.capacity() * sizeof(uint32)
+        + m_partial_blocks.capacity() * sizeof(uint64)
+        + m_levels.capacity() * sizeof(Level);
+
+    for (size_t i = 0; i < m_levels.size(); ++i)
+        size += m_levels[i].m_coverage.capacity() * sizeof(uint8);
+
+    return size;
+}
+
+AlphaMask::Coverage AlphaMask::classify_node(
+    const size_t            level,
+    const size_t            nx,
+    const size_t            ny,
+    const size_t            x0,
+    const size_t            y0,
+    const size_t            x1,
+    const size_t            y1) const
+{
+    const Level& node_level = m_levels[level];
+    const Coverage coverage =
+        static_cast<Coverage>(node_level.m_coverage[ny * node_level.m_width + nx]);
+
+    if (coverage != Partial)
+        return coverage;
+
+    // Texels covered by this node, clipped to the mask.
+    const size_t shift = level + BlockSizeLog;
+    const size_t node_x0 = nx << shift;
+    const size_t node_y0 = ny << shift;
+    const size_t node_x1 = min(((nx + 1) << shift) - 1, m_width - 1);
+    const size_t node_y1 = min(((ny + 1) << shift) - 1, m_height - 1);
+
+    // A partial node that lies entirely inside the rectangle makes the rectangle partial.
+    if (x0 <= node_x0 && node_x1 <= x1 && y0 <= node_y0 && node_y1 <= y1)
+        return Partial;
+
+    if (level == 0)
+    {
+        return
+            classify_block(
+                nx,
+                ny,
+                max(x0, node_x0),
+                max(y0, node_y0),
+                min(x1, node_x1),
+                min(y1, node_y1));
+    }
+
+    // Recurse into the children that overlap the rectangle.
+    const size_t child_shift = shift - 1;
+    const Level& child_level = m_levels[level - 1];
+    const size_t cx0 = max(x0 >> child_shift, 2 * nx);
+    const size_t cy0 = max(y0 >> child_shift, 2 * ny);
+    const size_t cx1 = min(min(x1 >> child_shift, 2 * nx + 1), child_level.m_width - 1);
+    const size_t cy1 = min(min(y1 >> child_shift, 2 * ny + 1), child_level.m_height - 1);
+
+    Coverage result = classify_node(level - 1, cx0, cy0, x0, y0, x1, y1);
+
+    for (size_t cy = cy0; cy <= cy1; ++cy)
+    {
+        for (size_t cx = cx0; cx <= cx1; ++cx)
+        {
+            if (result == Partial)
+                return Partial;
+
+            if (cx != cx0 || cy != cy0)
+            {
+                if (classify_node(level - 1, cx, cy, x0, y0, x1, y1) != result)
+                    result = Partial;
+            }
+        }
+    }
+
+    return result;
+}
+
+AlphaMask::Coverage AlphaMask::classify_block(
+    const size_t            bx,
+    const size_t            by,
+    const size_t            x0,
+    const size_t            y0,
+    const size_t            x1,
+    const size_t            y1) const
+{
+    const uint32 block = m_blocks[by * m_block_count_x + bx];
+    assert(block != TransparentBlock && block != OpaqueBlock);
+
+    // Build the mask of the block's bits that lie inside the rectangle.
+    const size_t local_x0 = x0 & (BlockSize - 1);
+    const size_t local_y0 = y0 & (BlockSize - 1);
+    const size_t local_x1 = x1 & (BlockSize - 1);
+    const size_t local_y1 = y1 & (BlockSize - 1);
+    const uint64 row_mask = ((uint64(1) << (local_x1 - local_x0 + 1)) - 1) << local_x0;
+
+    uint64 rect_mask = 0;
+    for (size_t y = local_y0; y <= local_y1; ++y)
+        rect_mask |= row_mask << (y << BlockSizeLog);
+
+    const uint64 bits = m_partial_blocks[block] & rect_mask;
+
+    return
+        bits == 0 ? Transparent :
+        bits == rect_mask ? Opaque :
+        Partial;
+}
+
+}   // namespace renderer
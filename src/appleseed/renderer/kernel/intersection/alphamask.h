@@ -0,0 +1,204 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class BitMask2; }
+
+namespace renderer
+{
+
+//
+// A hierarchical, compressed binary alpha mask.
+//
+// Texels are grouped into blocks of 8x8 texels. Blocks that are entirely opaque or
+// entirely transparent are stored as a single tag; only the texels of the remaining
+// (partial) blocks are stored, as one 64-bit word per block. On top of the blocks,
+// a mip-style pyramid of coverage summaries allows to classify large regions of the
+// mask without visiting individual texels.
+//
+
+class AlphaMask
+  : public foundation::NonCopyable
+{
+  public:
+    // Coverage of a region of the mask.
+    enum Coverage
+    {
+        Transparent = 0,                    // all texels of the region are transparent
+        Opaque      = 1,                    // all texels of the region are opaque
+        Partial     = 2                     // the region has both opaque and transparent texels
+    };
+
+    // Constructor, builds the mask from a full-resolution bitmask (set bits are opaque texels).
+    explicit AlphaMask(const foundation::BitMask2& texels);
+
+    size_t get_width() const;
+    size_t get_height() const;
+
+    // Look up the texel at a given UV location.
+    bool is_opaque(const foundation::Vector2f& uv) const;
+    bool is_transparent(const foundation::Vector2f& uv) const;
+
+    // Conservatively classify the texels covered by a triangle, given the UV
+    // coordinates of its vertices. Returns Opaque (resp. Transparent) only if
+    // every UV location inside the triangle is guaranteed to be opaque (resp.
+    // transparent).
+    Coverage get_coverage(
+        const foundation::Vector2f& uv0,
+        const foundation::Vector2f& uv1,
+        const foundation::Vector2f& uv2) const;
+
+    // Classify a rectangle of texels (bounds are inclusive).
+    Coverage get_coverage(
+        const size_t                x0,
+        const size_t                y0,
+        const size_t                x1,
+        const size_t                y1) const;
+
+    size_t get_block_count() const;
+    size_t get_partial_block_count() const;
+
+    size_t get_memory_size() const;
+
+  private:
+    enum { BlockSizeLog = 3, BlockSize = 1 << BlockSizeLog };
+
+    // Tags of uniform blocks; other values are indices into m_partial_blocks.
+    static const foundation::uint32 TransparentBlock = ~foundation::uint32(0);
+    static const foundation::uint32 OpaqueBlock = ~foundation::uint32(0) - 1;
+
+    struct Level
+    {
+        size_t                          m_width;
+        size_t                          m_height;
+        std::vector<foundation::uint8>  m_coverage;
+    };
+
+    const size_t                        m_width;
+    const size_t                        m_height;
+    const float                         m_max_x;
+    const float                         m_max_y;
+    const size_t                        m_block_count_x;
+    const size_t                        m_block_count_y;
+    std::vector<foundation::uint32>     m_blocks;
+    std::vector<foundation::uint64>     m_partial_blocks;
+    std::vector<Level>                  m_levels;       // level 0 summarizes blocks, level i + 1 summarizes 2x2 nodes of level i
+
+    size_t get_texel_x(const float u) const;
+    size_t get_texel_y(const float v) const;
+
+    Coverage classify_node(
+        const size_t                level,
+        const size_t                nx,
+        const size_t                ny,
+        const size_t                x0,
+        const size_t                y0,
+        const size_t                x1,
+        const size_t                y1) const;
+
+    Coverage classify_block(
+        const size_t                bx,
+        const size_t                by,
+        const size_t                x0,
+        const size_t                y0,
+        const size_t                x1,
+        const size_t                y1) const;
+};
+
+
+//
+// AlphaMask class implementation.
+//
+
+inline size_t AlphaMask::get_width() const
+{
+    return m_width;
+}
+
+inline size_t AlphaMask::get_height() const
+{
+    return m_height;
+}
+
+inline size_t AlphaMask::get_texel_x(const float u) const
+{
+    return foundation::truncate<size_t>(foundation::clamp(u * m_width, 0.0f, m_max_x));
+}
+
+inline size_t AlphaMask::get_texel_y(const float v) const
+{
+    return foundation::truncate<size_t>(foundation::clamp(v * m_height, 0.0f, m_max_y));
+}
+
+inline bool AlphaMask::is_opaque(const foundation::Vector2f& uv) const
+{
+    const size_t ix = get_texel_x(uv[0]);
+    const size_t iy = get_texel_y(uv[1]);
+
+    const foundation::uint32 block =
+        m_blocks[(iy >> BlockSizeLog) * m_block_count_x + (ix >> BlockSizeLog)];
+
+    if (block == OpaqueBlock)
+        return true;
+
+    if (block == TransparentBlock)
+        return false;
+
+    const size_t bit = ((iy & (BlockSize - 1)) << BlockSizeLog) + (ix & (BlockSize - 1));
+
+    return ((m_partial_blocks[block] >> bit) & 1) != 0;
+}
+
+inline bool AlphaMask::is_transparent(const foundation::Vector2f& uv) const
+{
+    return !is_opaque(uv);
+}
+
+inline size_t AlphaMask::get_block_count() const
+{
+    return m_blocks.size();
+}
+
+inline size_t AlphaMask::get_partial_block_count() const
+{
+    return m_partial_blocks.size();
+}
+
+}   // namespace renderer
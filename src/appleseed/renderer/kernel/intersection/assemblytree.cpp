@@ -55,8 +55,10 @@
 #include "foundation/platform/timers.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/alignedallocator.h"
+#include "foundation/utility/diskcache.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/lazy.h"
+#include "foundation/utility/makevector.h"
 #include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
@@ -65,7 +67,9 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <memory>
 #include <set>
+#include <string>
 #include <utility>
 
 using namespace foundation;
@@ -81,6 +85,7 @@ namespace renderer
 AssemblyTree::AssemblyTree(const Scene& scene)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_scene(scene)
+  , m_built_sah_cost(0.0)
 #ifdef APPLESEED_WITH_EMBREE
   , m_use_embree(false)
   , m_dirty(false)
@@ -95,10 +100,35 @@ AssemblyTree::~AssemblyTree()
 
 void AssemblyTree::update()
 {
-    rebuild_assembly_tree();
+    // Collect assembly instances and their bounding boxes.
+    RENDERER_LOG_INFO("collecting assembly instances...");
+    ItemVector items;
+    AABBVector assembly_instance_bboxes;
+    collect_assembly_instances(
+        m_scene.assembly_instances(),
+        TransformSequence(),
+        items,
+        assembly_instance_bboxes);
+
+    // Refit the assembly tree when only transforms or bounding boxes changed.
+    if (!refit_assembly_tree(items, assembly_instance_bboxes))
+        rebuild_assembly_tree(items, assembly_instance_bboxes);
+
     update_tree_hierarchy();
 }
 
+void AssemblyTree::set_tree_cache(
+    const string&   directory,
+    const uint64    max_size)
+{
+    if (directory.empty())
+        m_tree_cache.reset();
+    else if (!m_tree_cache ||
+             m_tree_cache->get_directory() != directory ||
+             m_tree_cache->get_max_size() != max_size)
+        m_tree_cache = make_shared<DiskCache>(directory.c_str(), max_size);
+}
+
 size_t AssemblyTree::get_memory_size() const
 {
     return
@@ -106,13 +136,16 @@ size_t AssemblyTree::get_memory_size() const
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
         + m_items.capacity() * sizeof(AssemblyInstance*)
+        + m_item_uids.capacity() * sizeof(UniqueID)
+        + m_item_ordering.capacity() * sizeof(size_t)
         + m_assembly_versions.size() * sizeof(pair<UniqueID, VersionID>);
 }
 
 void AssemblyTree::collect_assembly_instances(
     const AssemblyInstanceContainer&    assembly_instances,
     const TransformSequence&            parent_transform_seq,
-    AABBVector&                         assembly_instance_bboxes)
+    ItemVector&                         items,
+    AABBVector&                         assembly_instance_bboxes) const
 {
     for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
     {
@@ -131,6 +164,7 @@ void AssemblyTree::collect_assembly_instances(
         collect_assembly_instances(
             assembly.assembly_instances(),
             cumulated_transform_seq,
+            items,
             assembly_instance_bboxes);
 
         // Skip empty assemblies.
@@ -138,7 +172,7 @@ void AssemblyTree::collect_assembly_instances(
             continue;
 
         // Create and store an item for this assembly instance.
-        m_items.emplace_back(
+        items.emplace_back(
             &assembly,
             &assembly_instance,
             cumulated_transform_seq);
@@ -152,22 +186,89 @@ void AssemblyTree::collect_assembly_instances(
     }
 }
 
-void AssemblyTree::rebuild_assembly_tree()
+bool AssemblyTree::refit_assembly_tree(
+    const ItemVector&                   items,
+    const AABBVector&                   assembly_instance_bboxes)
+{
+    // The topology of the tree can only be kept if the same assembly instances are found in the same order.
+    if (items.empty() || items.size() != m_item_uids.size())
+        return false;
+
+    for (size_t i = 0, e = items.size(); i < e; ++i)
+    {
+        if (items[i].m_assembly_instance->get_uid() != m_item_uids[i])
+            return false;
+    }
+
+    RENDERER_LOG_INFO(
+        "refitting assembly tree (%s %s)...",
+        pretty_int(items.size()).c_str(),
+        plural(items.size(), "assembly instance").c_str());
+
+    Statistics statistics;
+
+    // Update the items and their bounding boxes, in tree order.
+    AABBVector item_bboxes(items.size());
+    for (size_t i = 0, e = items.size(); i < e; ++i)
+    {
+        m_items[i] = items[m_item_ordering[i]];
+        item_bboxes[i] = assembly_instance_bboxes[m_item_ordering[i]];
+    }
+
+    // Refit the assembly tree.
+    typedef bvh::Refitter<AssemblyTree, AABBVector> Refitter;
+    Refitter refitter;
+    refitter.refit<DefaultWallclockTimer>(*this, item_bboxes);
+    statistics.insert_time("refit time", refitter.get_refit_time());
+
+    // Rebuild the tree if refitting degraded it too much.
+    const double sah_cost =
+        bvh::TreeSAHCost<AssemblyTree>::evaluate(
+            *this,
+            refitter.get_root_bbox(),
+            AssemblyTreeInteriorNodeTraversalCost,
+            AssemblyTreeTriangleIntersectionCost);
+    statistics.insert("sah cost", sah_cost);
+    statistics.insert("built sah cost", m_built_sah_cost);
+
+    if (sah_cost > m_built_sah_cost * AssemblyTreeMaxRefitSAHCostRatio)
+    {
+        RENDERER_LOG_DEBUG(
+            "refitted assembly tree has a sah cost of %f versus %f when built, rebuilding it.",
+            sah_cost,
+            m_built_sah_cost);
+        return false;
+    }
+
+    // Update the items stored in the tree leaves.
+    store_items_in_leaves(statistics);
+
+    // Rebuild wide nodes from the refitted binary nodes.
+    m_wide4_nodes.clear();
+    m_wide8_nodes.clear();
+    build_wide_nodes(statistics);
+
+    // Print assembly tree statistics.
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "assembly tree refit statistics",
+            statistics).to_string().c_str());
+
+    return true;
+}
+
+void AssemblyTree::rebuild_assembly_tree(
+    ItemVector&                         items,
+    const AABBVector&                   assembly_instance_bboxes)
 {
     // Clear the current tree.
     clear();
-    m_items.clear();
+    m_items.swap(items);
+    m_item_uids.clear();
+    m_item_ordering.clear();
 
     Statistics statistics;
 
-    // Collect assembly instances and their bounding boxes.
-    RENDERER_LOG_INFO("collecting assembly instances...");
-    AABBVector assembly_instance_bboxes;
-    collect_assembly_instances(
-        m_scene.assembly_instances(),
-        TransformSequence(),
-        assembly_instance_bboxes);
-
     RENDERER_LOG_INFO(
         "building assembly tree (%s %s)...",
         pretty_int(m_items.size()).c_str(),
@@ -193,6 +294,12 @@ void AssemblyTree::rebuild_assembly_tree()
         const vector<size_t>& ordering = partitioner.get_item_ordering();
         assert(m_items.size() == ordering.size());
 
+        // Remember the order in which assembly instances were collected and where they went in the tree.
+        m_item_uids.reserve(m_items.size());
+        for (const_each<ItemVector> i = m_items; i; ++i)
+            m_item_uids.push_back(i->m_assembly_instance->get_uid());
+        m_item_ordering = ordering;
+
         // Reorder the items according to the tree ordering.
         ItemVector temp_assembly_instances(ordering.size());
         small_item_reorder(
@@ -203,8 +310,19 @@ void AssemblyTree::rebuild_assembly_tree()
 
         // Store the items in the tree leaves whenever possible.
         store_items_in_leaves(statistics);
+
+        // Store the SAH cost of the tree to evaluate the quality of later refits.
+        m_built_sah_cost =
+            bvh::TreeSAHCost<AssemblyTree>::evaluate(
+                *this,
+                AABB3d(partitioner.compute_bbox(0, m_items.size())),
+                AssemblyTreeInteriorNodeTraversalCost,
+                AssemblyTreeTriangleIntersectionCost);
     }
 
+    // Build wide nodes.
+    build_wide_nodes(statistics);
+
     // Print assembly tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -212,6 +330,29 @@ void AssemblyTree::rebuild_assembly_tree()
             statistics).to_string().c_str());
 }
 
+void AssemblyTree::build_wide_nodes(Statistics& statistics)
+{
+    const size_t node_width =
+        m_scene.get_parameters().child("acceleration_structure").get_optional<size_t>(
+            "node_width",
+            AssemblyTreeDefaultNodeWidth,
+            make_vector("2", "4", "8"));
+
+    if (node_width == 4)
+        build_wide_nodes<4>(statistics);
+    else if (node_width == 8)
+        build_wide_nodes<8>(statistics);
+}
+
+template <size_t Width>
+void AssemblyTree::build_wide_nodes(Statistics& statistics)
+{
+    bvh::WideBuilder<AssemblyTree, Width> builder;
+    builder.template build<DefaultWallclockTimer>(*this);
+    statistics.merge(builder.get_statistics());
+    statistics.insert_time("wide nodes build time", builder.get_build_time());
+}
+
 void AssemblyTree::store_items_in_leaves(Statistics& statistics)
 {
     size_t leaf_count = 0;
@@ -411,7 +552,8 @@ void AssemblyTree::create_triangle_tree(const Assembly& assembly)
                     m_scene,
                     assembly.get_uid(),
                     assembly_bbox,
-                    assembly)));
+                    assembly,
+                    m_tree_cache)));
 
         tree = new Lazy<TriangleTree>(move(triangle_tree_factory));
         m_triangle_tree_repository.insert(hash, tree);
@@ -439,7 +581,8 @@ void AssemblyTree::create_curve_tree(const Assembly& assembly)
                     m_scene,
                     assembly.get_uid(),
                     assembly_bbox,
-                    assembly)));
+                    assembly,
+                    m_tree_cache)));
 
         tree = new Lazy<CurveTree>(move(curve_tree_factory));
         m_curve_tree_repository.insert(hash, tree);
@@ -633,11 +776,9 @@ bool AssemblyLeafVisitor::visit(
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
         // Evaluate the transformation of the assembly instance.
-        const TransformSequence* assembly_instance_transform_seq =
-            &item.m_transform_sequence;
         Transformd scratch;
         const Transformd& assembly_instance_transform =
-            assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch);
+            item.m_transform_sequence.evaluate(ray.m_time.m_absolute, scratch);
 
         // Transform the ray to assembly instance space.
         ShadingPoint local_shading_point;
@@ -649,159 +790,179 @@ bool AssemblyLeafVisitor::visit(
             local_shading_point.m_ray);
         const RayInfo3d local_ray_info(local_shading_point.m_ray);
 
+        // Check the intersection between the ray and the assembly.
+        intersect_triangles(item, local_shading_point, local_ray_info);
+        intersect_curves_and_procedurals(
+            item,
+            assembly_instance_transform,
+            local_shading_point,
+            local_ray_info);
+    }
+
+    // Continue traversal.
+    distance = m_shading_point.m_ray.m_tmax;
+    return true;
+}
+
+void AssemblyLeafVisitor::intersect_triangles(
+    const AssemblyTree::Item&           item,
+    ShadingPoint&                       local_shading_point,
+    const RayInfo3d&                    local_ray_info)
+{
 #ifdef APPLESEED_WITH_EMBREE
 
-        if (m_tree.use_embree())
-        {
-            const EmbreeScene& embree_scene =
-                *m_embree_scene_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_embree_scenes);
+    if (m_tree.use_embree())
+    {
+        const EmbreeScene& embree_scene =
+            *m_embree_scene_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_embree_scenes);
 
-            embree_scene.intersect(local_shading_point);
-        }
-        else
+        embree_scene.intersect(local_shading_point);
+        return;
+    }
 
 #endif
-        {
-            // Retrieve the triangle tree of this assembly.
-            const TriangleTree* triangle_tree =
-                m_triangle_tree_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_triangle_trees);
 
-            if (triangle_tree)
-            {
-                // Check the intersection between the ray and the triangle tree.
-                TriangleTreeIntersector intersector;
-                TriangleLeafVisitor visitor(*triangle_tree, local_shading_point);
-                if (triangle_tree->get_moving_triangle_count() > 0)
-                {
-                    intersector.intersect_motion(
-                        *triangle_tree,
-                        local_shading_point.m_ray,
-                        local_ray_info,
-                        local_shading_point.m_ray.m_time.m_normalized,
-                        visitor
-#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
-#endif
-                        );
-                }
-                else
-                {
-                    intersector.intersect_no_motion(
-                        *triangle_tree,
-                        local_shading_point.m_ray,
-                        local_ray_info,
-                        visitor
+    // Retrieve the triangle tree of this assembly.
+    const TriangleTree* triangle_tree =
+        m_triangle_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_triangle_trees);
+
+    if (triangle_tree)
+    {
+        // Check the intersection between the ray and the triangle tree.
+        TriangleTreeIntersector intersector;
+        TriangleLeafVisitor visitor(*triangle_tree, local_shading_point);
+        if (triangle_tree->get_moving_triangle_count() > 0)
+        {
+            intersector.intersect_motion(
+                *triangle_tree,
+                local_shading_point.m_ray,
+                local_ray_info,
+                local_shading_point.m_ray.m_time.m_normalized,
+                visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                , m_triangle_tree_stats
 #endif
-                        );
-                }
-                visitor.read_hit_triangle_data();
-            }
+                );
         }
-
-        // Retrieve the curve tree of this assembly.
-        const CurveTree* curve_tree =
-            m_curve_tree_cache.access(
-                item.m_assembly_uid,
-                m_tree.m_curve_trees);
-
-        if (curve_tree)
+        else
         {
-            // Check the intersection between the ray and the curve tree.
-            const GRay3 ray(local_shading_point.m_ray);
-            const GRayInfo3 ray_info(local_ray_info);
-            CurveMatrixType xfm_matrix;
-            make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafVisitor visitor(*curve_tree, xfm_matrix, local_shading_point);
-            CurveTreeIntersector intersector;
             intersector.intersect_no_motion(
-                *curve_tree,
-                ray,
-                ray_info,
+                *triangle_tree,
+                local_shading_point.m_ray,
+                local_ray_info,
                 visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                , m_curve_tree_stats
+                , m_triangle_tree_stats
 #endif
                 );
         }
+        visitor.read_hit_triangle_data();
+    }
+}
 
-        // Keep track of the closest hit.
-        if (local_shading_point.hit_surface() && local_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
-        {
-            m_shading_point.m_ray.m_tmax = local_shading_point.m_ray.m_tmax;
-            m_shading_point.m_primitive_type = local_shading_point.m_primitive_type;
-            m_shading_point.m_bary = local_shading_point.m_bary;
-            m_shading_point.m_assembly_instance = item.m_assembly_instance;
-            m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-            m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-            m_shading_point.m_object_instance_index = local_shading_point.m_object_instance_index;
-            m_shading_point.m_primitive_index = local_shading_point.m_primitive_index;
-            m_shading_point.m_triangle_support_plane = local_shading_point.m_triangle_support_plane;
-        }
+void AssemblyLeafVisitor::intersect_curves_and_procedurals(
+    const AssemblyTree::Item&           item,
+    const Transformd&                   assembly_instance_transform,
+    ShadingPoint&                       local_shading_point,
+    const RayInfo3d&                    local_ray_info)
+{
+    // Retrieve the curve tree of this assembly.
+    const CurveTree* curve_tree =
+        m_curve_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_curve_trees);
+
+    if (curve_tree)
+    {
+        // Check the intersection between the ray and the curve tree.
+        const GRay3 ray(local_shading_point.m_ray);
+        const GRayInfo3 ray_info(local_ray_info);
+        CurveMatrixType xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+        CurveLeafVisitor visitor(*curve_tree, xfm_matrix, local_shading_point);
+        CurveTreeIntersector intersector;
+        intersector.intersect_no_motion(
+            *curve_tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_curve_tree_stats
+#endif
+            );
+    }
+
+    // Keep track of the closest hit.
+    if (local_shading_point.hit_surface() && local_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
+    {
+        m_shading_point.m_ray.m_tmax = local_shading_point.m_ray.m_tmax;
+        m_shading_point.m_primitive_type = local_shading_point.m_primitive_type;
+        m_shading_point.m_bary = local_shading_point.m_bary;
+        m_shading_point.m_assembly_instance = item.m_assembly_instance;
+        m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
+        m_shading_point.m_assembly_instance_transform_seq = &item.m_transform_sequence;
+        m_shading_point.m_object_instance_index = local_shading_point.m_object_instance_index;
+        m_shading_point.m_primitive_index = local_shading_point.m_primitive_index;
+        m_shading_point.m_triangle_support_plane = local_shading_point.m_triangle_support_plane;
+    }
 
-        // Check the intersection between the ray and procedural objects.
-        if (item.m_assembly->has_render_data())
+    // Check the intersection between the ray and procedural objects.
+    if (item.m_assembly->has_render_data())
+    {
+        const IndexedObjectInstanceArray& procedural_object_instances =
+            item.m_assembly->get_render_data().m_procedural_object_instances;
+
+        for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
         {
-            const IndexedObjectInstanceArray& procedural_object_instances =
-                item.m_assembly->get_render_data().m_procedural_object_instances;
+            // Retrieve the object instance.
+            const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
+            const ObjectInstance* object_instance = object_instance_index_pair.first;
 
-            for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
+            // Skip this object instance if it isn't visible for this ray.
+            if (!(object_instance->get_vis_flags() & local_shading_point.m_ray.m_flags))
+                continue;
+
+            // Transform the ray to object instance space.
+            // todo: transform ray differentials.
+            const Transformd& object_instance_transform = object_instance->get_transform();
+            ShadingRay instance_local_ray;
+            instance_local_ray.m_org = object_instance_transform.point_to_local(local_shading_point.m_ray.m_org);
+            instance_local_ray.m_dir = object_instance_transform.vector_to_local(local_shading_point.m_ray.m_dir);
+            instance_local_ray.m_has_differentials = false;
+            instance_local_ray.m_tmin = local_shading_point.m_ray.m_tmin;
+            instance_local_ray.m_tmax = local_shading_point.m_ray.m_tmax;
+            instance_local_ray.m_time = local_shading_point.m_ray.m_time;
+            instance_local_ray.m_flags = local_shading_point.m_ray.m_flags;
+            instance_local_ray.m_depth = local_shading_point.m_ray.m_depth;
+            instance_local_ray.m_medium_count = local_shading_point.m_ray.m_medium_count;
+
+            // Ask the procedural object to intersect itself against the ray.
+            const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
+            ProceduralObject::IntersectionResult result;
+            object.intersect(instance_local_ray, result);
+
+            // Keep track of the closest hit.
+            if (result.m_hit && result.m_distance < m_shading_point.m_ray.m_tmax)
             {
-                // Retrieve the object instance.
-                const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
-                const ObjectInstance* object_instance = object_instance_index_pair.first;
-
-                // Skip this object instance if it isn't visible for this ray.
-                if (!(object_instance->get_vis_flags() & ray.m_flags))
-                    continue;
-
-                // Transform the ray to object instance space.
-                // todo: transform ray differentials.
-                const Transformd& object_instance_transform = object_instance->get_transform();
-                ShadingRay instance_local_ray;
-                instance_local_ray.m_org = object_instance_transform.point_to_local(local_shading_point.m_ray.m_org);
-                instance_local_ray.m_dir = object_instance_transform.vector_to_local(local_shading_point.m_ray.m_dir);
-                instance_local_ray.m_has_differentials = false;
-                instance_local_ray.m_tmin = local_shading_point.m_ray.m_tmin;
-                instance_local_ray.m_tmax = local_shading_point.m_ray.m_tmax;
-                instance_local_ray.m_time = local_shading_point.m_ray.m_time;
-                instance_local_ray.m_flags = local_shading_point.m_ray.m_flags;
-                instance_local_ray.m_depth = local_shading_point.m_ray.m_depth;
-                instance_local_ray.m_medium_count = local_shading_point.m_ray.m_medium_count;
-
-                // Ask the procedural object to intersect itself against the ray.
-                const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
-                ProceduralObject::IntersectionResult result;
-                object.intersect(instance_local_ray, result);
-
-                // Keep track of the closest hit.
-                if (result.m_hit && result.m_distance < m_shading_point.m_ray.m_tmax)
-                {
-                    m_shading_point.m_ray.m_tmax = result.m_distance;
-                    m_shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
-                    m_shading_point.m_bary = result.m_uv;
-                    m_shading_point.m_assembly_instance = item.m_assembly_instance;
-                    m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-                    m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-                    m_shading_point.m_object_instance_index = object_instance_index_pair.second;
-                    m_shading_point.m_primitive_index = 0;
-                    m_shading_point.m_primitive_pa = result.m_material_slot;
-                    m_shading_point.m_geometric_normal = object_instance_transform.normal_to_parent(result.m_geometric_normal);
-                    m_shading_point.m_original_shading_normal = object_instance_transform.normal_to_parent(result.m_shading_normal);
-                    m_shading_point.m_uv = result.m_uv;
-                }
+                m_shading_point.m_ray.m_tmax = result.m_distance;
+                m_shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
+                m_shading_point.m_bary = result.m_uv;
+                m_shading_point.m_assembly_instance = item.m_assembly_instance;
+                m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
+                m_shading_point.m_assembly_instance_transform_seq = &item.m_transform_sequence;
+                m_shading_point.m_object_instance_index = object_instance_index_pair.second;
+                m_shading_point.m_primitive_index = 0;
+                m_shading_point.m_primitive_pa = result.m_material_slot;
+                m_shading_point.m_geometric_normal = object_instance_transform.normal_to_parent(result.m_geometric_normal);
+                m_shading_point.m_original_shading_normal = object_instance_transform.normal_to_parent(result.m_shading_normal);
+                m_shading_point.m_uv = result.m_uv;
             }
         }
     }
-
-    // Continue traversal.
-    distance = m_shading_point.m_ray.m_tmax;
-    return true;
 }
 
 
@@ -853,148 +1014,473 @@ bool AssemblyLeafProbeVisitor::visit(
             local_ray);
         const RayInfo3d local_ray_info(local_ray);
 
+        // Terminate traversal if there was a hit.
+        if (intersect_triangles(item, local_ray, local_ray_info) ||
+            intersect_curves_and_procedurals(item, local_ray, local_ray_info))
+        {
+            m_hit = true;
+            return false;
+        }
+    }
+
+    // Continue traversal.
+    distance = ray.m_tmax;
+    return true;
+}
+
+bool AssemblyLeafProbeVisitor::intersect_triangles(
+    const AssemblyTree::Item&           item,
+    const ShadingRay&                   local_ray,
+    const RayInfo3d&                    local_ray_info)
+{
 #ifdef APPLESEED_WITH_EMBREE
 
-        if (m_tree.use_embree())
+    if (m_tree.use_embree())
+    {
+        const EmbreeScene& embree_scene =
+            *m_embree_scene_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_embree_scenes);
+
+        return embree_scene.occlude(local_ray);
+    }
+
+#endif
+
+    // Retrieve the triangle tree of this assembly.
+    const TriangleTree* triangle_tree =
+        m_triangle_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_triangle_trees);
+
+    if (!triangle_tree)
+        return false;
+
+    // Check the intersection between the ray and the triangle tree.
+    TriangleTreeProbeIntersector intersector;
+    TriangleLeafProbeVisitor visitor(*triangle_tree, local_ray.m_time.m_normalized, local_ray.m_flags);
+    if (triangle_tree->get_moving_triangle_count() > 0)
+    {
+        intersector.intersect_motion(
+            *triangle_tree,
+            local_ray,
+            local_ray_info,
+            local_ray.m_time.m_normalized,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_stats
+#endif
+            );
+    }
+    else
+    {
+        intersector.intersect_no_motion(
+            *triangle_tree,
+            local_ray,
+            local_ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_stats
+#endif
+            );
+    }
+
+    return visitor.hit();
+}
+
+bool AssemblyLeafProbeVisitor::intersect_curves_and_procedurals(
+    const AssemblyTree::Item&           item,
+    const ShadingRay&                   local_ray,
+    const RayInfo3d&                    local_ray_info)
+{
+    // Retrieve the curve tree of this assembly.
+    const CurveTree* curve_tree =
+        m_curve_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_curve_trees);
+
+    if (curve_tree)
+    {
+        // Check intersection between ray and curve tree.
+        const GRay3 ray(local_ray);
+        const GRayInfo3 ray_info(local_ray_info);
+        CurveMatrixType xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+        CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix);
+        CurveTreeProbeIntersector intersector;
+        intersector.intersect_no_motion(
+            *curve_tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_curve_tree_stats
+#endif
+            );
+
+        if (visitor.hit())
+            return true;
+    }
+
+    // Check the intersection between the ray and procedural objects.
+    if (item.m_assembly->has_render_data())
+    {
+        const IndexedObjectInstanceArray& procedural_object_instances =
+            item.m_assembly->get_render_data().m_procedural_object_instances;
+
+        for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
         {
-            const EmbreeScene& embree_scene =
-                *m_embree_scene_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_embree_scenes);
+            // Retrieve the object and object instance.
+            const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
+            const ObjectInstance* object_instance = object_instance_index_pair.first;
 
-            if (embree_scene.occlude(local_ray))
-            {
-                m_hit = true;
-                return false;
-            }
+            // Skip this object instance if it isn't visible for this ray.
+            if (!(object_instance->get_vis_flags() & local_ray.m_flags))
+                continue;
+
+            // Transform the ray to object instance space.
+            // todo: transform ray differentials.
+            const Transformd& object_instance_transform = object_instance->get_transform();
+            ShadingRay instance_local_ray;
+            instance_local_ray.m_org = object_instance_transform.point_to_local(local_ray.m_org);
+            instance_local_ray.m_dir = object_instance_transform.vector_to_local(local_ray.m_dir);
+            instance_local_ray.m_has_differentials = false;
+            instance_local_ray.m_tmin = local_ray.m_tmin;
+            instance_local_ray.m_tmax = local_ray.m_tmax;
+            instance_local_ray.m_time = local_ray.m_time;
+            instance_local_ray.m_flags = local_ray.m_flags;
+            instance_local_ray.m_depth = local_ray.m_depth;
+            instance_local_ray.m_medium_count = local_ray.m_medium_count;
+
+            // Ask the procedural object to intersect itself against the ray.
+            const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
+            if (object.intersect(instance_local_ray))
+                return true;
         }
-        else
+    }
+
+    return false;
+}
+
 
+//
+// Utility function to find the triangle tree that a packet of rays can traverse together.
+//
+
+namespace
+{
+    const TriangleTree* get_packet_triangle_tree(
+        const bool                          use_embree,
+        const UniqueID                      assembly_uid,
+        TriangleTreeAccessCache&            triangle_tree_cache,
+        const TriangleTreeContainer&        triangle_trees,
+        const uint32                        ray_mask)
+    {
+        // A single ray is better off with the regular (possibly wide) traversal.
+        if (use_embree || (ray_mask & (ray_mask - 1)) == 0)
+            return nullptr;
+
+        const TriangleTree* triangle_tree =
+            triangle_tree_cache.access(assembly_uid, triangle_trees);
+
+        // Packet traversal does not support motion blur.
+        return
+            triangle_tree && triangle_tree->get_moving_triangle_count() == 0
+                ? triangle_tree
+                : nullptr;
+    }
+}
+
+
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
+
+uint32 AssemblyLeafPacketVisitor::visit(
+    const AssemblyTree::NodeType&       node,
+    const uint32                        ray_mask,
+    const ShadingRay*                   rays,
+    const ShadingRay::RayInfoType*      ray_infos,
+    double*                             distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+#ifdef APPLESEED_WITH_EMBREE
+    const bool use_embree = m_tree.use_embree();
+#else
+    const bool use_embree = false;
 #endif
+
+    // Retrieve the assembly instances for this leaf.
+    const size_t assembly_instance_count = node.get_item_count();
+    const AssemblyTree::Item* items =
+        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
+            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            : &m_tree.m_items[node.get_item_index()];       // items are stored in the tree
+
+    ShadingPoint local_shading_points[RayPacketSize];
+    RayInfo3d local_ray_infos[RayPacketSize];
+    Transformd assembly_instance_transforms[RayPacketSize];
+
+    for (size_t i = 0; i < assembly_instance_count; ++i)
+    {
+        // Retrieve the assembly instance.
+        const AssemblyTree::Item& item = items[i];
+        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+
+        // Transform the rays for which this assembly instance is visible to assembly instance space.
+        uint32 item_ray_mask = 0;
+        for (size_t j = 0; j < RayPacketSize; ++j)
         {
-            // Retrieve the triangle tree of this assembly.
-            const TriangleTree* triangle_tree =
-                m_triangle_tree_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_triangle_trees);
+            if (!(ray_mask & (1u << j)) || !(assembly_instance.get_vis_flags() & rays[j].m_flags))
+                continue;
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
-            if (triangle_tree)
+            Transformd scratch;
+            assembly_instance_transforms[j] =
+                item.m_transform_sequence.evaluate(rays[j].m_time.m_absolute, scratch);
+
+            local_shading_points[j].clear();
+            compute_assembly_instance_ray(
+                assembly_instance,
+                assembly_instance_transforms[j],
+                m_parent_shading_point,
+                rays[j],
+                local_shading_points[j].m_ray);
+            local_ray_infos[j] = RayInfo3d(local_shading_points[j].m_ray);
+
+            item_ray_mask |= 1u << j;
+        }
+
+        if (item_ray_mask == 0)
+            continue;
+
+        const TriangleTree* triangle_tree =
+            get_packet_triangle_tree(
+                use_embree,
+                item.m_assembly_uid,
+                m_triangle_tree_cache,
+                m_tree.m_triangle_trees,
+                item_ray_mask);
+
+        if (triangle_tree)
+        {
+            // Gather the rays into a packet and intersect it with the triangle tree.
+            foundation::Ray3d packet_rays[RayPacketSize];
+            RayInfo3d packet_ray_infos[RayPacketSize];
+            ShadingPoint* packet_shading_points[RayPacketSize];
+            size_t packet_size = 0;
+            for (size_t j = 0; j < RayPacketSize; ++j)
             {
-                // Check the intersection between the ray and the triangle tree.
-                TriangleTreeProbeIntersector intersector;
-                TriangleLeafProbeVisitor visitor(*triangle_tree, local_ray.m_time.m_normalized, local_ray.m_flags);
-                if (triangle_tree->get_moving_triangle_count() > 0)
+                if (item_ray_mask & (1u << j))
                 {
-                    intersector.intersect_motion(
-                        *triangle_tree,
-                        local_ray,
-                        local_ray_info,
-                        local_ray.m_time.m_normalized,
-                        visitor
+                    packet_rays[packet_size] = local_shading_points[j].m_ray;
+                    packet_ray_infos[packet_size] = local_ray_infos[j];
+                    packet_shading_points[packet_size] = &local_shading_points[j];
+                    ++packet_size;
+                }
+            }
+
+            TriangleTreePacketIntersector intersector;
+            TriangleLeafPacketVisitor visitor(*triangle_tree, packet_shading_points);
+            intersector.intersect_no_motion(
+                *triangle_tree,
+                packet_rays,
+                packet_ray_infos,
+                packet_size,
+                visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                , m_triangle_tree_stats
 #endif
-                        );
-                }
-                else
-                {
-                    intersector.intersect_no_motion(
-                        *triangle_tree,
-                        local_ray,
-                        local_ray_info,
-                        visitor
+                );
+
+            for (size_t j = 0; j < packet_size; ++j)
+                visitor.read_hit_triangle_data(j);
+        }
+
+        // Intersect the rays one at a time with the rest of the assembly.
+        for (size_t j = 0; j < RayPacketSize; ++j)
+        {
+            if (!(item_ray_mask & (1u << j)))
+                continue;
+
+            AssemblyLeafVisitor ray_visitor(
+                *m_shading_points[j],
+                m_tree,
+                m_triangle_tree_cache,
+                m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+                m_embree_scene_cache,
+#endif
+                m_parent_shading_point
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                , m_triangle_tree_stats
+                , m_curve_tree_stats
 #endif
-                        );
-                }
+                );
 
-                // Terminate traversal if there was a hit.
-                if (visitor.hit())
-                {
-                    m_hit = true;
-                    return false;
-                }
-            }
+            if (!triangle_tree)
+                ray_visitor.intersect_triangles(item, local_shading_points[j], local_ray_infos[j]);
+
+            ray_visitor.intersect_curves_and_procedurals(
+                item,
+                assembly_instance_transforms[j],
+                local_shading_points[j],
+                local_ray_infos[j]);
+        }
+    }
+
+    // Continue traversal for all rays.
+    for (size_t j = 0; j < RayPacketSize; ++j)
+    {
+        if (ray_mask & (1u << j))
+            distances[j] = m_shading_points[j]->m_ray.m_tmax;
+    }
+
+    return ray_mask;
+}
+
+
+//
+// AssemblyLeafProbePacketVisitor class implementation.
+//
+
+uint32 AssemblyLeafProbePacketVisitor::visit(
+    const AssemblyTree::NodeType&       node,
+    const uint32                        ray_mask,
+    const ShadingRay*                   rays,
+    const ShadingRay::RayInfoType*      ray_infos,
+    double*                             distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    const AssemblyTree& tree = m_ray_visitor.m_tree;
+
+#ifdef APPLESEED_WITH_EMBREE
+    const bool use_embree = tree.use_embree();
+#else
+    const bool use_embree = false;
+#endif
+
+    // Retrieve the assembly instances for this leaf.
+    const size_t assembly_instance_count = node.get_item_count();
+    const AssemblyTree::Item* items =
+        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
+            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            : &tree.m_items[node.get_item_index()];         // items are stored in the tree
+
+    ShadingRay local_rays[RayPacketSize];
+    RayInfo3d local_ray_infos[RayPacketSize];
+
+    for (size_t i = 0; i < assembly_instance_count; ++i)
+    {
+        // Retrieve the assembly instance.
+        const AssemblyTree::Item& item = items[i];
+        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+
+        // Transform the rays for which this assembly instance is visible to assembly instance space.
+        uint32 item_ray_mask = 0;
+        for (size_t j = 0; j < RayPacketSize; ++j)
+        {
+            if (!(ray_mask & ~m_hit_mask & (1u << j)) || !(assembly_instance.get_vis_flags() & rays[j].m_flags))
+                continue;
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            Transformd scratch;
+            const Transformd& assembly_instance_transform =
+                item.m_transform_sequence.evaluate(rays[j].m_time.m_absolute, scratch);
+
+            compute_assembly_instance_ray(
+                assembly_instance,
+                assembly_instance_transform,
+                m_ray_visitor.m_parent_shading_point,
+                rays[j],
+                local_rays[j]);
+            local_ray_infos[j] = RayInfo3d(local_rays[j]);
+
+            item_ray_mask |= 1u << j;
         }
 
-        // Retrieve the curve tree of this assembly.
-        const CurveTree* curve_tree =
-            m_curve_tree_cache.access(
+        if (item_ray_mask == 0)
+            continue;
+
+        const TriangleTree* triangle_tree =
+            get_packet_triangle_tree(
+                use_embree,
                 item.m_assembly_uid,
-                m_tree.m_curve_trees);
+                m_ray_visitor.m_triangle_tree_cache,
+                tree.m_triangle_trees,
+                item_ray_mask);
 
-        if (curve_tree)
+        if (triangle_tree)
         {
-            // Check intersection between ray and curve tree.
-            const GRay3 ray(local_ray);
-            const GRayInfo3 ray_info(local_ray_info);
-            CurveMatrixType xfm_matrix;
-            make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix);
-            CurveTreeProbeIntersector intersector;
+            // Gather the rays into a packet and intersect it with the triangle tree.
+            foundation::Ray3d packet_rays[RayPacketSize];
+            RayInfo3d packet_ray_infos[RayPacketSize];
+            double packet_ray_times[RayPacketSize];
+            VisibilityFlags::Type packet_ray_flags[RayPacketSize];
+            size_t packet_ray_indices[RayPacketSize];
+            size_t packet_size = 0;
+            for (size_t j = 0; j < RayPacketSize; ++j)
+            {
+                if (item_ray_mask & (1u << j))
+                {
+                    packet_rays[packet_size] = local_rays[j];
+                    packet_ray_infos[packet_size] = local_ray_infos[j];
+                    packet_ray_times[packet_size] = local_rays[j].m_time.m_normalized;
+                    packet_ray_flags[packet_size] = local_rays[j].m_flags;
+                    packet_ray_indices[packet_size] = j;
+                    ++packet_size;
+                }
+            }
+
+            TriangleTreeProbePacketIntersector intersector;
+            TriangleLeafProbePacketVisitor visitor(*triangle_tree, packet_ray_times, packet_ray_flags);
             intersector.intersect_no_motion(
-                *curve_tree,
-                ray,
-                ray_info,
+                *triangle_tree,
+                packet_rays,
+                packet_ray_infos,
+                packet_size,
                 visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                , m_curve_tree_stats
+                , m_ray_visitor.m_triangle_tree_stats
 #endif
                 );
 
-            // Terminate traversal if there was a hit.
-            if (visitor.hit())
+            const uint32 packet_hit_mask = visitor.get_hit_mask();
+            for (size_t j = 0; j < packet_size; ++j)
             {
-                m_hit = true;
-                return false;
+                if (packet_hit_mask & (1u << j))
+                    m_hit_mask |= 1u << packet_ray_indices[j];
             }
         }
 
-        // Check the intersection between the ray and procedural objects.
-        if (item.m_assembly->has_render_data())
+        // Intersect the rays one at a time with the rest of the assembly.
+        for (size_t j = 0; j < RayPacketSize; ++j)
         {
-            const IndexedObjectInstanceArray& procedural_object_instances =
-                item.m_assembly->get_render_data().m_procedural_object_instances;
+            if (!(item_ray_mask & ~m_hit_mask & (1u << j)))
+                continue;
 
-            for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
-            {
-                // Retrieve the object and object instance.
-                const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
-                const ObjectInstance* object_instance = object_instance_index_pair.first;
-
-                // Skip this object instance if it isn't visible for this ray.
-                if (!(object_instance->get_vis_flags() & ray.m_flags))
-                    continue;
-
-                // Transform the ray to object instance space.
-                // todo: transform ray differentials.
-                const Transformd& object_instance_transform = object_instance->get_transform();
-                ShadingRay instance_local_ray;
-                instance_local_ray.m_org = object_instance_transform.point_to_local(local_ray.m_org);
-                instance_local_ray.m_dir = object_instance_transform.vector_to_local(local_ray.m_dir);
-                instance_local_ray.m_has_differentials = false;
-                instance_local_ray.m_tmin = local_ray.m_tmin;
-                instance_local_ray.m_tmax = local_ray.m_tmax;
-                instance_local_ray.m_time = local_ray.m_time;
-                instance_local_ray.m_flags = local_ray.m_flags;
-                instance_local_ray.m_depth = local_ray.m_depth;
-                instance_local_ray.m_medium_count = local_ray.m_medium_count;
-
-                // Ask the procedural object to intersect itself against the ray.
-                const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
-                if (object.intersect(instance_local_ray))
-                {
-                    m_hit = true;
-                    return false;
-                }
-            }
+            if ((!triangle_tree && m_ray_visitor.intersect_triangles(item, local_rays[j], local_ray_infos[j])) ||
+                m_ray_visitor.intersect_curves_and_procedurals(item, local_rays[j], local_ray_infos[j]))
+                m_hit_mask |= 1u << j;
         }
     }
 
-    // Continue traversal.
-    distance = ray.m_tmax;
-    return true;
+    // Continue traversal for the rays that didn't hit anything.
+    for (size_t j = 0; j < RayPacketSize; ++j)
+    {
+        if (ray_mask & ~m_hit_mask & (1u << j))
+            distances[j] = rays[j].m_tmax;
+    }
+
+    return ray_mask & ~m_hit_mask;
 }
 
 }   // namespace renderer
@@ -34,6 +34,7 @@
 #ifdef APPLESEED_WITH_EMBREE
 #include "renderer/kernel/intersection/embreescene.h"
 #endif
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
 #include "renderer/kernel/intersection/treerepository.h"
 #include "renderer/kernel/intersection/triangletree.h"
@@ -46,6 +47,9 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/transform.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/uid.h"
 #include "foundation/utility/version.h"
@@ -53,9 +57,12 @@
 // Standard headers.
 #include <cstddef>
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 // Forward declarations.
+namespace foundation    { class DiskCache; }
 namespace foundation    { class Statistics; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class Scene; }
@@ -82,12 +89,19 @@ class AssemblyTree
     // Destructor.
     ~AssemblyTree();
 
-    // Update the assembly tree and all the child trees.
+    // Update the assembly tree and all the child trees. The assembly tree is only
+    // refitted if the same assembly instances are found in the same order.
     void update();
 
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
+    // Persist triangle and curve trees in a cache directory, or stop doing so if the
+    // directory is empty. Only affects the trees created by subsequent updates.
+    void set_tree_cache(
+        const std::string&                  directory,
+        const foundation::uint64            max_size);
+
 #ifdef APPLESEED_WITH_EMBREE
 
     bool use_embree() const;
@@ -98,6 +112,8 @@ class AssemblyTree
   private:
     friend class AssemblyLeafVisitor;
     friend class AssemblyLeafProbeVisitor;
+    friend class AssemblyLeafPacketVisitor;
+    friend class AssemblyLeafProbePacketVisitor;
     friend class Intersector;
 
     struct Item
@@ -124,10 +140,14 @@ class AssemblyTree
     typedef std::vector<Item> ItemVector;
     typedef std::vector<foundation::AABB3d> AABBVector;
     typedef std::vector<const Assembly*> AssemblyVector;
+    typedef std::vector<foundation::UniqueID> UniqueIDVector;
     typedef std::map<foundation::UniqueID, foundation::VersionID> AssemblyVersionMap;
 
     const Scene&                    m_scene;
     ItemVector                      m_items;
+    UniqueIDVector                  m_item_uids;        // assembly instances, in collection order
+    std::vector<size_t>             m_item_ordering;    // collection index of each item
+    double                          m_built_sah_cost;   // SAH cost of the tree when it was last built
     AssemblyVersionMap              m_assembly_versions;
 
     TreeRepository<TriangleTree>    m_triangle_tree_repository;
@@ -136,6 +156,8 @@ class AssemblyTree
     TreeRepository<CurveTree>       m_curve_tree_repository;
     CurveTreeContainer              m_curve_trees;
 
+    std::shared_ptr<foundation::DiskCache> m_tree_cache;
+
 #ifdef APPLESEED_WITH_EMBREE
 
     TreeRepository<EmbreeScene>     m_embree_scene_repository;
@@ -148,11 +170,23 @@ class AssemblyTree
     void collect_assembly_instances(
         const AssemblyInstanceContainer&        assembly_instances,
         const TransformSequence&                parent_transform_seq,
-        AABBVector&                             assembly_instance_bboxes);
+        ItemVector&                             items,
+        AABBVector&                             assembly_instance_bboxes) const;
+
+    bool refit_assembly_tree(
+        const ItemVector&                       items,
+        const AABBVector&                       assembly_instance_bboxes);
 
-    void rebuild_assembly_tree();
+    void rebuild_assembly_tree(
+        ItemVector&                             items,
+        const AABBVector&                       assembly_instance_bboxes);
     void store_items_in_leaves(foundation::Statistics& statistics);
 
+    void build_wide_nodes(foundation::Statistics& statistics);
+
+    template <size_t Width>
+    void build_wide_nodes(foundation::Statistics& statistics);
+
     void update_tree_hierarchy();
     void collect_unique_assemblies(AssemblyVector& assemblies) const;
     void delete_unused_child_trees(const AssemblyVector& assemblies);
@@ -212,6 +246,8 @@ class AssemblyLeafVisitor
         );
 
   private:
+    friend class AssemblyLeafPacketVisitor;
+
     ShadingPoint&                                   m_shading_point;
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
@@ -224,6 +260,22 @@ class AssemblyLeafVisitor
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
 #endif
+
+    // Intersect the ray of a shading point expressed in assembly instance space
+    // with the triangles of the assembly.
+    void intersect_triangles(
+        const AssemblyTree::Item&                   item,
+        ShadingPoint&                               local_shading_point,
+        const foundation::RayInfo3d&                local_ray_info);
+
+    // Intersect the ray of a shading point expressed in assembly instance space
+    // with the curves and the procedural objects of the assembly, and keep track
+    // of the closest hit.
+    void intersect_curves_and_procedurals(
+        const AssemblyTree::Item&                   item,
+        const foundation::Transformd&               assembly_instance_transform,
+        ShadingPoint&                               local_shading_point,
+        const foundation::RayInfo3d&                local_ray_info);
 };
 
 
@@ -263,6 +315,76 @@ class AssemblyLeafProbeVisitor
         );
 
   private:
+    friend class AssemblyLeafProbePacketVisitor;
+
+    const AssemblyTree&                             m_tree;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         m_embree_scene_cache;
+#endif
+    const ShadingPoint*                             m_parent_shading_point;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+
+    // Return whether a ray expressed in assembly instance space hits any triangle of the assembly.
+    bool intersect_triangles(
+        const AssemblyTree::Item&                   item,
+        const ShadingRay&                           local_ray,
+        const foundation::RayInfo3d&                local_ray_info);
+
+    // Return whether a ray expressed in assembly instance space hits any curve
+    // or procedural object of the assembly.
+    bool intersect_curves_and_procedurals(
+        const AssemblyTree::Item&                   item,
+        const ShadingRay&                           local_ray,
+        const foundation::RayInfo3d&                local_ray_info);
+};
+
+
+//
+// Assembly leaf visitor for packets of rays, used during tree intersection.
+//
+// Rays of the packet that enter the same assembly instance share a single traversal
+// of its triangle tree; curves and procedural objects are intersected one ray at a time.
+//
+
+class AssemblyLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    AssemblyLeafPacketVisitor(
+        ShadingPoint* const*                        shading_points,     // one per ray of the packet
+        const AssemblyTree&                         tree,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        EmbreeSceneAccessCache&                     embree_scene_cache,
+#endif
+        const ShadingPoint*                         parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf.
+    foundation::uint32 visit(
+        const AssemblyTree::NodeType&               node,
+        const foundation::uint32                    ray_mask,
+        const ShadingRay*                           rays,
+        const ShadingRay::RayInfoType*              ray_infos,
+        double*                                     distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+  private:
+    ShadingPoint* const*                            m_shading_points;
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
     CurveTreeAccessCache&                           m_curve_tree_cache;
@@ -277,21 +399,111 @@ class AssemblyLeafProbeVisitor
 };
 
 
+//
+// Assembly leaf visitor for packets of probe rays, only return boolean answers
+// (whether an intersection was found or not for each ray of the packet).
+//
+
+class AssemblyLeafProbePacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    AssemblyLeafProbePacketVisitor(
+        const AssemblyTree&                         tree,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        EmbreeSceneAccessCache&                     embree_scene_cache,
+#endif
+        const ShadingPoint*                         parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf.
+    foundation::uint32 visit(
+        const AssemblyTree::NodeType&               node,
+        const foundation::uint32                    ray_mask,
+        const ShadingRay*                           rays,
+        const ShadingRay::RayInfoType*              ray_infos,
+        double*                                     distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+    // Return the mask of the rays that hit something.
+    foundation::uint32 get_hit_mask() const;
+
+  private:
+    AssemblyLeafProbeVisitor                        m_ray_visitor;
+    foundation::uint32                              m_hit_mask;
+};
+
+
 //
 // Assembly tree intersectors.
 //
+// The tree is traversed using its wide nodes, if it has any.
+//
+
+template <typename Visitor>
+class AssemblyTreeIntersectorImpl
+  : public foundation::NonCopyable
+{
+  public:
+    void intersect_no_motion(
+        const AssemblyTree&                     tree,
+        const ShadingRay&                       ray,
+        const ShadingRay::RayInfoType&          ray_info,
+        Visitor&                                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        ) const;
+
+  private:
+    typedef foundation::bvh::Intersector<
+        AssemblyTree,
+        Visitor,
+        ShadingRay
+    > BinaryIntersector;
+
+    typedef foundation::bvh::WideIntersector<
+        AssemblyTree,
+        Visitor,
+        ShadingRay,
+        4
+    > Wide4Intersector;
+
+    typedef foundation::bvh::WideIntersector<
+        AssemblyTree,
+        Visitor,
+        ShadingRay,
+        8
+    > Wide8Intersector;
+};
+
+typedef AssemblyTreeIntersectorImpl<AssemblyLeafVisitor> AssemblyTreeIntersector;
+typedef AssemblyTreeIntersectorImpl<AssemblyLeafProbeVisitor> AssemblyTreeProbeIntersector;
 
-typedef foundation::bvh::Intersector<
+// Packets of rays are always traversed using binary nodes.
+typedef foundation::bvh::PacketIntersector<
     AssemblyTree,
-    AssemblyLeafVisitor,
-    ShadingRay
-> AssemblyTreeIntersector;
+    AssemblyLeafPacketVisitor,
+    ShadingRay,
+    RayPacketSize
+> AssemblyTreePacketIntersector;
 
-typedef foundation::bvh::Intersector<
+typedef foundation::bvh::PacketIntersector<
     AssemblyTree,
-    AssemblyLeafProbeVisitor,
-    ShadingRay
-> AssemblyTreeProbeIntersector;
+    AssemblyLeafProbePacketVisitor,
+    ShadingRay,
+    RayPacketSize
+> AssemblyTreeProbePacketIntersector;
 
 
 //
@@ -359,4 +571,134 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
 {
 }
 
+
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
+
+inline AssemblyLeafPacketVisitor::AssemblyLeafPacketVisitor(
+    ShadingPoint* const*                            shading_points,
+    const AssemblyTree&                             tree,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         embree_scene_cache,
+#endif
+    const ShadingPoint*                             parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_shading_points(shading_points)
+  , m_tree(tree)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+#ifdef APPLESEED_WITH_EMBREE
+  , m_embree_scene_cache(embree_scene_cache)
+#endif
+  , m_parent_shading_point(parent_shading_point)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+{
+}
+
+
+//
+// AssemblyLeafProbePacketVisitor class implementation.
+//
+
+inline AssemblyLeafProbePacketVisitor::AssemblyLeafProbePacketVisitor(
+    const AssemblyTree&                             tree,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         embree_scene_cache,
+#endif
+    const ShadingPoint*                             parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_ray_visitor(
+        tree,
+        triangle_tree_cache,
+        curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        embree_scene_cache,
+#endif
+        parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , triangle_tree_stats
+        , curve_tree_stats
+#endif
+        )
+  , m_hit_mask(0)
+{
+}
+
+inline foundation::uint32 AssemblyLeafProbePacketVisitor::get_hit_mask() const
+{
+    return m_hit_mask;
+}
+
+
+//
+// AssemblyTreeIntersectorImpl class implementation.
+//
+
+template <typename Visitor>
+inline void AssemblyTreeIntersectorImpl<Visitor>::intersect_no_motion(
+    const AssemblyTree&                         tree,
+    const ShadingRay&                           ray,
+    const ShadingRay::RayInfoType&              ray_info,
+    Visitor&                                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    ) const
+{
+    switch (tree.get_node_width())
+    {
+      case 4:
+        Wide4Intersector().intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+        break;
+
+      case 8:
+        Wide8Intersector().intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+        break;
+
+      default:
+        BinaryIntersector().intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+        break;
+    }
+}
+
 }   // namespace renderer
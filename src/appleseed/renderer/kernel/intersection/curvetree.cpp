@@ -31,6 +31,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/treecache.h"
 #include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/scene/assembly.h"
@@ -48,8 +49,10 @@
 #include "foundation/platform/system.h"
 #include "foundation/utility/alignedallocator.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/diskcache.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/memory.h"
+#include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
@@ -73,22 +76,40 @@ CurveTree::Arguments::Arguments(
     const Scene&            scene,
     const UniqueID          curve_tree_uid,
     const GAABB3&           bbox,
-    const Assembly&         assembly)
+    const Assembly&         assembly,
+    shared_ptr<DiskCache>   cache)
   : m_scene(scene)
   , m_curve_tree_uid(curve_tree_uid)
   , m_bbox(bbox)
   , m_assembly(assembly)
+  , m_cache(cache)
 {
 }
 
 CurveTree::CurveTree(const Arguments& arguments)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_arguments(arguments)
+{
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+
+    if (m_arguments.m_cache)
+    {
+        const uint64 cache_key = compute_cache_key(params);
+
+        if (!load_from_cache(cache_key))
+        {
+            build(params);
+            save_to_cache(cache_key);
+        }
+    }
+    else build(params);
+}
+
+void CurveTree::build(const ParamArray& params)
 {
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building curve tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
-    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
     const string algorithm = params.get_optional<string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
 
@@ -302,6 +323,134 @@ void CurveTree::reorder_curve_keys_in_leaf_nodes()
     }
 }
 
+namespace
+{
+    // Version of the layout of cached curve trees.
+    // Must be incremented whenever the layout of nodes, curves or curve keys changes.
+    const uint32 CurveTreeCacheFormat = 1;
+
+    enum CurveTreeCacheSection
+    {
+        NodesSection,
+        NodeBBoxesSection,
+        Wide4NodesSection,
+        Wide8NodesSection,
+        Curves1Section,
+        Curves3Section,
+        CurveKeysSection,
+        CurveTreeCacheSectionCount
+    };
+}
+
+uint64 CurveTree::compute_cache_key(const ParamArray& params) const
+{
+    SipHashAccumulator hash;
+
+    // Layout of the tree, which also depends on build options.
+    uint32 layout_flags = 0;
+#ifdef APPLESEED_USE_SSE
+    layout_flags |= 1UL << 0;       // node bounding boxes are swizzled
+#endif
+    hash.append(CurveTreeCacheFormat);
+    hash.append(layout_flags);
+    hash.append(static_cast<uint32>(sizeof(GScalar)));
+    hash.append(static_cast<uint32>(sizeof(NodeType)));
+
+    // Construction parameters and bounding box of the tree.
+    hash_tree_parameters(hash, params);
+    hash.append(m_arguments.m_bbox);
+
+    // Curve object instances and their geometry.
+    const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
+    for (size_t i = 0, e = object_instances.size(); i < e; ++i)
+    {
+        const ObjectInstance* object_instance = object_instances.get_by_index(i);
+        assert(object_instance);
+
+        const Object& object = object_instance->get_object();
+        if (strcmp(object.get_model(), CurveObjectFactory().get_model()) != 0)
+            continue;
+
+        hash_object_instance(hash, i, *object_instance);
+
+        const CurveObject& curve_object = static_cast<const CurveObject&>(object);
+        const size_t curve1_count = curve_object.get_curve1_count();
+        const size_t curve3_count = curve_object.get_curve3_count();
+
+        hash.append(static_cast<uint64>(curve1_count));
+        hash.append(static_cast<uint64>(curve3_count));
+
+        for (size_t j = 0; j < curve1_count; ++j)
+            hash.append(curve_object.get_curve1(j));
+
+        for (size_t j = 0; j < curve3_count; ++j)
+            hash.append(curve_object.get_curve3(j));
+    }
+
+    return hash.get_hash();
+}
+
+bool CurveTree::load_from_cache(const uint64 key)
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    const unique_ptr<DiskCache::Entry> entry =
+        m_arguments.m_cache->load(key, CurveTreeCacheFormat);
+
+    if (!entry || entry->get_section_count() != CurveTreeCacheSectionCount)
+        return false;
+
+    if (!read_tree_cache_section(entry->get_section(NodesSection), m_nodes) ||
+        !read_tree_cache_section(entry->get_section(NodeBBoxesSection), m_node_bboxes) ||
+        !read_tree_cache_section(entry->get_section(Wide4NodesSection), m_wide4_nodes) ||
+        !read_tree_cache_section(entry->get_section(Wide8NodesSection), m_wide8_nodes) ||
+        !read_tree_cache_section(entry->get_section(Curves1Section), m_curves1) ||
+        !read_tree_cache_section(entry->get_section(Curves3Section), m_curves3) ||
+        !read_tree_cache_section(entry->get_section(CurveKeysSection), m_curve_keys) ||
+        m_nodes.empty())
+    {
+        clear();
+        m_node_bboxes.clear();
+        m_curves1.clear();
+        m_curves3.clear();
+        m_curve_keys.clear();
+        return false;
+    }
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "loaded curve tree #" FMT_UNIQUE_ID " for assembly \"%s\" from cache in %s.",
+        m_arguments.m_curve_tree_uid,
+        m_arguments.m_assembly.get_path().c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    return true;
+}
+
+void CurveTree::save_to_cache(const uint64 key) const
+{
+    const DiskCache::Section sections[CurveTreeCacheSectionCount] =
+    {
+        make_tree_cache_section(m_nodes),
+        make_tree_cache_section(m_node_bboxes),
+        make_tree_cache_section(m_wide4_nodes),
+        make_tree_cache_section(m_wide8_nodes),
+        make_tree_cache_section(m_curves1),
+        make_tree_cache_section(m_curves3),
+        make_tree_cache_section(m_curve_keys)
+    };
+
+    if (!m_arguments.m_cache->store(key, CurveTreeCacheFormat, sections, CurveTreeCacheSectionCount))
+    {
+        RENDERER_LOG_WARNING(
+            "could not store curve tree #" FMT_UNIQUE_ID " in cache directory %s.",
+            m_arguments.m_curve_tree_uid,
+            m_arguments.m_cache->get_directory().c_str());
+    }
+}
+
 
 //
 // CurveTreeFactory class implementation.
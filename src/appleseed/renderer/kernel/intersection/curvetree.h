@@ -52,6 +52,7 @@
 #include <vector>
 
 // Forward declarations.
+namespace foundation    { class DiskCache; }
 namespace foundation    { class Statistics; }
 namespace renderer      { class Assembly; }
 namespace renderer      { class ParamArray; }
@@ -79,16 +80,19 @@ class CurveTree
         const foundation::UniqueID              m_curve_tree_uid;
         const GAABB3                            m_bbox;
         const Assembly&                         m_assembly;
+        std::shared_ptr<foundation::DiskCache>  m_cache;
 
         // Constructor.
         Arguments(
             const Scene&                        scene,
             const foundation::UniqueID          curve_tree_uid,
             const GAABB3&                       bbox,
-            const Assembly&                     assembly);
+            const Assembly&                     assembly,
+            std::shared_ptr<foundation::DiskCache> cache = std::shared_ptr<foundation::DiskCache>());
     };
 
-    // Constructor, builds the tree for a given assembly.
+    // Constructor, builds the tree for a given assembly, or loads it
+    // from the cache of the arguments if it was built before.
     explicit CurveTree(const Arguments& arguments);
 
   private:
@@ -108,6 +112,8 @@ class CurveTree
     std::vector<Curve3Type> m_curves3;
     std::vector<CurveKey>   m_curve_keys;
 
+    void build(const ParamArray& params);
+
     void collect_curves(std::vector<GAABB3>& curve_bboxes);
 
     void build_bvh(
@@ -123,6 +129,10 @@ class CurveTree
 
     // Reorder curve keys in leaf nodes so that all degree-1 curve keys come before degree-3 ones.
     void reorder_curve_keys_in_leaf_nodes();
+
+    foundation::uint64 compute_cache_key(const ParamArray& params) const;
+    bool load_from_cache(const foundation::uint64 key);
+    void save_to_cache(const foundation::uint64 key) const;
 };
 
 
@@ -41,7 +41,8 @@
 #include "renderer/modeling/scene/objectinstance.h"
 
 // appleseed.foundation headers.
-#include "foundation/utility/foreach.h"
+#include "foundation/utility/bitmask.h"
+#include "foundation/utility/otherwise.h"
 
 // Standard headers.
 #include <cassert>
@@ -55,16 +56,15 @@ namespace renderer
 
 namespace
 {
-    size_t get_triangle_count(Object& object)
+    const StaticTriangleTess& get_static_triangle_tess(const Object& object)
     {
         const MeshObject& mesh = static_cast<const MeshObject&>(object);
-        const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
-        return tess.m_primitives.size();
+        return mesh.get_static_triangle_tess();
     }
 
     void copy_uv_coordinates(const StaticTriangleTess& tess, vector<Vector2f>& uv)
     {
-        for (const_each<StaticTriangleTess::PrimitiveArray> i = tess.m_primitives; i; ++i)
+        for (const Triangle* i = tess.m_primitives.begin(), *e = tess.m_primitives.end(); i != e; ++i)
         {
             if (i->has_vertex_attributes() && tess.get_tex_coords_count() > 0)
             {
@@ -85,12 +85,6 @@ namespace
         }
     }
 
-    void copy_uv_coordinates(Object& object, vector<Vector2f>& uv)
-    {
-        const MeshObject& mesh = static_cast<const MeshObject&>(object);
-        const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
-        copy_uv_coordinates(tess, uv);
-    }
 }
 
 IntersectionFilter::IntersectionFilter(
@@ -99,20 +93,25 @@ IntersectionFilter::IntersectionFilter(
     TextureCache&           texture_cache)
   : m_obj_alpha_mask(nullptr)
   , m_obj_alpha_map_signature(0)
+  , m_opaque_triangle_count(0)
+  , m_transparent_triangle_count(0)
+  , m_partial_triangle_count(0)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_accept_call_count(0)
+  , m_mask_lookup_count(0)
+#endif
 {
     // Initialize the material -> alpha mask mapping.
     m_material_alpha_map_signatures.assign(materials.size(), 0);
     m_material_alpha_masks.assign(materials.size(), nullptr);
 
-    // Create alpha masks.
-    update(object, materials, texture_cache);
+    // Make a local copy of the object's UV coordinates, needed to classify triangles.
+    const StaticTriangleTess& tess = get_static_triangle_tess(object);
+    m_uv.reserve(tess.m_primitives.size() * 3);
+    copy_uv_coordinates(tess, m_uv);
 
-    if (has_alpha_masks())
-    {
-        // Make a local copy of the object's UV coordinates.
-        m_uv.reserve(get_triangle_count(object) * 3);
-        copy_uv_coordinates(object, m_uv);
-    }
+    // Create alpha masks and classify triangles.
+    update(object, materials, texture_cache);
 }
 
 IntersectionFilter::~IntersectionFilter()
@@ -137,7 +136,7 @@ template <typename EntityType>
 void IntersectionFilter::do_update(
     const EntityType&               entity,
     TextureCache&                   texture_cache,
-    IntersectionFilter::AlphaMask*& mask,
+    AlphaMask*&                     mask,
     uint64&                         signature)
 {
     // Use the uncached version of get_alpha_map() since at this point
@@ -201,6 +200,56 @@ void IntersectionFilter::update(
         else
             delete_and_clear(m_material_alpha_masks[i]);
     }
+
+    classify_triangles(object);
+}
+
+void IntersectionFilter::classify_triangles(const Object& object)
+{
+    const StaticTriangleTess& tess = get_static_triangle_tess(object);
+    const size_t triangle_count = tess.m_primitives.size();
+
+    m_triangle_coverage.resize(triangle_count);
+    m_opaque_triangle_count = 0;
+    m_transparent_triangle_count = 0;
+    m_partial_triangle_count = 0;
+
+    assert(m_uv.size() == triangle_count * 3);
+
+    // Classify triangles against the object's alpha mask and the alpha mask of their material.
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        const AlphaMask* mtl_alpha_mask = m_material_alpha_masks[tess.m_primitives[i].m_pa];
+
+        AlphaMask::Coverage coverage = AlphaMask::Opaque;
+
+        if (m_obj_alpha_mask || mtl_alpha_mask)
+        {
+            const Vector2f& uv0 = m_uv[i * 3 + 0];
+            const Vector2f& uv1 = m_uv[i * 3 + 1];
+            const Vector2f& uv2 = m_uv[i * 3 + 2];
+
+            if (m_obj_alpha_mask)
+                coverage = m_obj_alpha_mask->get_coverage(uv0, uv1, uv2);
+
+            if (mtl_alpha_mask && coverage != AlphaMask::Transparent)
+            {
+                const AlphaMask::Coverage mtl_coverage = mtl_alpha_mask->get_coverage(uv0, uv1, uv2);
+                if (mtl_coverage != AlphaMask::Opaque)
+                    coverage = mtl_coverage;
+            }
+        }
+
+        m_triangle_coverage[i] = static_cast<uint8>(coverage);
+
+        switch (coverage)
+        {
+          case AlphaMask::Opaque: ++m_opaque_triangle_count; break;
+          case AlphaMask::Transparent: ++m_transparent_triangle_count; break;
+          case AlphaMask::Partial: ++m_partial_triangle_count; break;
+          assert_otherwise;
+        }
+    }
 }
 
 bool IntersectionFilter::has_alpha_masks() const
@@ -217,6 +266,11 @@ bool IntersectionFilter::has_alpha_masks() const
     return false;
 }
 
+bool IntersectionFilter::accepts_all_triangles() const
+{
+    return m_transparent_triangle_count == 0 && m_partial_triangle_count == 0;
+}
+
 size_t IntersectionFilter::get_masks_memory_size() const
 {
     size_t size = 0;
@@ -235,19 +289,44 @@ size_t IntersectionFilter::get_masks_memory_size() const
 
 size_t IntersectionFilter::get_uv_memory_size() const
 {
-    return m_uv.capacity() * sizeof(Vector2f);
+    return
+          m_uv.capacity() * sizeof(Vector2f)
+        + m_triangle_coverage.capacity() * sizeof(uint8);
+}
+
+Statistics IntersectionFilter::get_statistics() const
+{
+    Statistics stats;
+    stats.insert<uint64>("opaque triangles", m_opaque_triangle_count);
+    stats.insert<uint64>("transparent triangles", m_transparent_triangle_count);
+    stats.insert<uint64>("partial triangles", m_partial_triangle_count);
+    stats.insert_percent<uint64>(
+        "resolved w/o lookup",
+        m_opaque_triangle_count + m_transparent_triangle_count,
+        m_triangle_coverage.size());
+    stats.insert_size("masks", get_masks_memory_size());
+    stats.insert_size("uvs", get_uv_memory_size());
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    const uint64 accept_call_count = m_accept_call_count;
+    const uint64 mask_lookup_count = m_mask_lookup_count;
+    stats.insert<uint64>("filter calls", accept_call_count);
+    stats.insert_percent<uint64>("avoided lookups", accept_call_count - mask_lookup_count, accept_call_count);
+#endif
+
+    return stats;
 }
 
-IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
+AlphaMask* IntersectionFilter::create_alpha_mask(
     const Source*           alpha_map,
     TextureCache&           texture_cache,
     double&                 transparency)
 {
     assert(alpha_map);
 
-    // Create and initialize the alpha mask.
+    // Create the full-resolution bitmask.
     const Source::Hints hints = alpha_map->get_hints();
-    AlphaMask* alpha_mask = new AlphaMask(hints.m_width, hints.m_height);
+    BitMask2 texels(hints.m_width, hints.m_height);
 
     const float rcp_width = 1.0f / hints.m_width;
     const float rcp_height = 1.0f / hints.m_height;
@@ -267,7 +346,7 @@ IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
 
             // Mark this texel as opaque or transparent in the alpha mask.
             const bool opaque = alpha[0] > 0.0f;
-            alpha_mask->set_opaque(x, y, opaque);
+            texels.set(x, y, opaque);
 
             // Keep track of the number of transparent texels.
             transparent_texel_count += opaque ? 0 : 1;
@@ -277,7 +356,8 @@ IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
     // Compute the ratio of transparent texels to the total number of texels.
     transparency = static_cast<double>(transparent_texel_count) / (hints.m_width * hints.m_height);
 
-    return alpha_mask;
+    // Build the hierarchical alpha mask.
+    return new AlphaMask(texels);
 }
 
 }   // namespace renderer
@@ -30,14 +30,17 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/alphamask.h"
 #include "renderer/kernel/intersection/trianglekey.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
-#include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
-#include "foundation/utility/bitmask.h"
+#include "foundation/utility/statistics.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
 
 // Standard headers.
 #include <cstddef>
@@ -70,74 +73,42 @@ class IntersectionFilter
 
     bool has_alpha_masks() const;
 
+    // Return true if the alpha masks are opaque over every triangle of the object.
+    bool accepts_all_triangles() const;
+
     size_t get_masks_memory_size() const;
     size_t get_uv_memory_size() const;
 
+    foundation::Statistics get_statistics() const;
+
     bool accept(
         const TriangleKey&      triangle_key,
         const double            u,
         const double            v) const;
 
   private:
-    class AlphaMask
-      : public foundation::NonCopyable
-    {
-      public:
-        AlphaMask(
-            const size_t        width,
-            const size_t        height)
-          : m_max_x(static_cast<float>(width) - 1.0f)
-          , m_max_y(static_cast<float>(height) - 1.0f)
-          , m_bitmask(width, height)
-        {
-        }
-
-        void set_opaque(
-            const size_t        x,
-            const size_t        y,
-            const bool          opaque)
-        {
-            m_bitmask.set(x, y, opaque);
-        }
-
-        bool is_opaque(const foundation::Vector2f& uv) const
-        {
-            const float fx = foundation::clamp(uv[0] * m_bitmask.get_width(), 0.0f, m_max_x);
-            const float fy = foundation::clamp(uv[1] * m_bitmask.get_height(), 0.0f, m_max_y);
-
-            const size_t ix = foundation::truncate<size_t>(fx);
-            const size_t iy = foundation::truncate<size_t>(fy);
-
-            return m_bitmask.is_set(ix, iy);
-        }
-
-        bool is_transparent(const foundation::Vector2f& uv) const
-        {
-            return !is_opaque(uv);
-        }
-
-        size_t get_memory_size() const
-        {
-            return m_bitmask.get_memory_size();
-        }
-
-      private:
-        const float             m_max_x;
-        const float             m_max_y;
-        foundation::BitMask2    m_bitmask;
-    };
-
     foundation::uint64                  m_obj_alpha_map_signature;
     AlphaMask*                          m_obj_alpha_mask;
     std::vector<foundation::uint64>     m_material_alpha_map_signatures;
     std::vector<AlphaMask*>             m_material_alpha_masks;
     std::vector<foundation::Vector2f>   m_uv;
+    std::vector<foundation::uint8>      m_triangle_coverage;            // AlphaMask::Coverage of each triangle
+    size_t                              m_opaque_triangle_count;
+    size_t                              m_transparent_triangle_count;
+    size_t                              m_partial_triangle_count;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    mutable boost::atomic<foundation::uint64>   m_accept_call_count;
+    mutable boost::atomic<foundation::uint64>   m_mask_lookup_count;
+#endif
+
+    void classify_triangles(const Object& object);
 
     template <typename EntityType>
     static void do_update(
         const EntityType&               entity,
         TextureCache&                   texture_cache,
-        IntersectionFilter::AlphaMask*& mask,
+        AlphaMask*&                     mask,
         foundation::uint64&             signature);
 
     static AlphaMask* create_alpha_mask(
@@ -165,12 +136,25 @@ inline bool IntersectionFilter::accept(
     if (u != u || v != v)
         return true;
 
+    const size_t triangle_index = triangle_key.get_triangle_index();
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    ++m_accept_call_count;
+#endif
+
+    // Most triangles are entirely on one side of the alpha masks and don't require any lookup.
+    const foundation::uint8 coverage = m_triangle_coverage[triangle_index];
+    if (coverage != AlphaMask::Partial)
+        return coverage == AlphaMask::Opaque;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    ++m_mask_lookup_count;
+#endif
+
     const AlphaMask* mtl_alpha_mask = m_material_alpha_masks[triangle_key.get_triangle_pa()];
 
     if (m_obj_alpha_mask || mtl_alpha_mask)
     {
-        const size_t triangle_index = triangle_key.get_triangle_index();
-
         const float fu = static_cast<float>(u);
         const float fv = static_cast<float>(v);
 
@@ -35,6 +35,7 @@
 // appleseed.foundation headers.
 #include "foundation/math/beziercurve.h"
 #include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/intersection/raytrianglemtgroup.h"
 #include "foundation/math/matrix.h"
 
 // Standard headers.
@@ -56,6 +57,13 @@ const double AssemblyTreeInteriorNodeTraversalCost = 1.0;
 // Relative cost of intersecting an assembly.
 const double AssemblyTreeTriangleIntersectionCost = 10.0;
 
+// Number of children per node used during traversal (2, 4 or 8).
+const size_t AssemblyTreeDefaultNodeWidth = 2;
+
+// Maximum ratio between the SAH cost of a refitted tree and its cost when it was built.
+// Beyond this ratio, the tree is rebuilt rather than refitted.
+const double AssemblyTreeMaxRefitSAHCostRatio = 1.5;
+
 
 //
 // Triangle tree settings.
@@ -68,9 +76,18 @@ typedef foundation::TriangleMT<GScalar> GTriangleType;
 typedef foundation::TriangleMT<double> TriangleType;
 typedef foundation::TriangleMTSupportPlane<double> TriangleSupportPlaneType;
 
+// Number of static triangles per group in SIMD leaves.
+const size_t TriangleTreeGroupSize = 4;
+
+// Triangle group format used for storage and intersection in SIMD leaves.
+typedef foundation::TriangleMTGroup<GScalar, TriangleTreeGroupSize> GTriangleGroupType;
+
 // Maximum number of triangles per leaf.
 const size_t TriangleTreeDefaultMaxLeafSize = 2;
 
+// Maximum number of triangles per leaf in trees with SIMD leaves.
+const size_t TriangleTreeDefaultSIMDMaxLeafSize = TriangleTreeGroupSize;
+
 // Relative cost of traversing an interior node.
 const GScalar TriangleTreeDefaultInteriorNodeTraversalCost(1.0);
 
@@ -80,6 +97,16 @@ const GScalar TriangleTreeDefaultTriangleIntersectionCost(1.0);
 // Number of bins used during SBVH construction.
 const size_t TriangleTreeDefaultBinCount = 256;
 
+// Number of bins per dimension used during binned BVH construction.
+const size_t TriangleTreeDefaultBinnedBVHBinCount = 32;
+
+// Number of triangles below which subtrees are built by worker threads during binned BVH construction.
+const size_t TriangleTreeDefaultMinParallelSubtreeSize = 16 * 1024;
+
+// Number of children per node used during traversal (2, 4 or 8).
+// Trees with motion are always traversed using binary nodes.
+const size_t TriangleTreeDefaultNodeWidth = 2;
+
 // Define this symbol to enable reordering the nodes of triangle trees for better
 // locality of reference. Requires a lot of temporary memory for minimal results.
 #undef RENDERER_TRIANGLE_TREE_REORDER_NODES
@@ -139,6 +166,14 @@ const size_t EmbreeSceneAccessCacheWays = 2;
 
 #endif
 
+//
+// Ray packet settings.
+//
+
+// Maximum number of rays traced together with a single traversal of the scene.
+const size_t RayPacketSize = 8;
+
+
 //
 // Miscellaneous settings.
 //
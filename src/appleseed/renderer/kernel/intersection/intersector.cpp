@@ -47,6 +47,7 @@
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <memory>
@@ -67,6 +68,7 @@ Intersector::Intersector(
   , m_report_self_intersections(report_self_intersections)
   , m_shading_ray_count(0)
   , m_probe_ray_count(0)
+  , m_packet_ray_count(0)
 {
 }
 
@@ -351,6 +353,181 @@ bool Intersector::trace_probe(
     return visitor.hit();
 }
 
+void Intersector::trace(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    ShadingPoint*                       shading_points,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    for (size_t i = 0; i < ray_count; i += RayPacketSize)
+    {
+        const size_t packet_size = min(ray_count - i, RayPacketSize);
+
+        if (packet_size == 1)
+            trace(rays[i], shading_points[i], parent_shading_point);
+        else trace_packet(rays + i, packet_size, shading_points + i, parent_shading_point);
+    }
+}
+
+void Intersector::trace_probe(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    bool*                               hits,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    for (size_t i = 0; i < ray_count; i += RayPacketSize)
+    {
+        const size_t packet_size = min(ray_count - i, RayPacketSize);
+
+        if (packet_size == 1)
+            hits[i] = trace_probe(rays[i], parent_shading_point);
+        else trace_probe_packet(rays + i, packet_size, hits + i, parent_shading_point);
+    }
+}
+
+void Intersector::trace_packet(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    ShadingPoint*                       shading_points,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    assert(ray_count <= RayPacketSize);
+
+    // Update ray casting statistics.
+    m_shading_ray_count += ray_count;
+    m_packet_ray_count += ray_count;
+
+    // Initialize the shading points and compute ray infos once for the entire traversal.
+    ShadingPoint* packet_shading_points[RayPacketSize];
+    ShadingRay::RayInfoType ray_infos[RayPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        ShadingPoint& shading_point = shading_points[i];
+
+        assert(is_normalized(rays[i].m_dir));
+        assert(shading_point.m_scene == nullptr);
+        assert(!shading_point.is_valid());
+        assert(parent_shading_point != &shading_point);
+
+        shading_point.m_texture_cache = &m_texture_cache;
+        shading_point.m_scene = &m_trace_context.get_scene();
+        shading_point.m_ray = rays[i];
+
+        packet_shading_points[i] = &shading_point;
+        ray_infos[i] = ShadingRay::RayInfoType(rays[i]);
+    }
+
+    // Refine and offset the previous intersection point.
+    if (parent_shading_point &&
+        parent_shading_point->hit_surface() &&
+        !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+        parent_shading_point->refine_and_offset();
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    // Check the intersection between the rays and the assembly tree.
+    AssemblyTreePacketIntersector intersector;
+    AssemblyLeafPacketVisitor visitor(
+        packet_shading_points,
+        assembly_tree,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        m_embree_scene_cache,
+#endif
+        parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
+#endif
+        );
+    intersector.intersect_no_motion(
+        assembly_tree,
+        rays,
+        ray_infos,
+        ray_count,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_assembly_tree_traversal_stats
+#endif
+        );
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        ShadingPoint& shading_point = shading_points[i];
+
+        // Detect and report self-intersections.
+        if (m_report_self_intersections)
+            report_self_intersection(shading_point, parent_shading_point);
+
+        const ShadingRay::Medium* medium = rays[i].get_current_medium();
+        if (!shading_point.hit_surface() && medium != nullptr && medium->get_volume() != nullptr)
+            shading_point.m_primitive_type = ShadingPoint::PrimitiveVolume;
+    }
+}
+
+void Intersector::trace_probe_packet(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    bool*                               hits,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    assert(ray_count <= RayPacketSize);
+    assert(parent_shading_point == 0 || parent_shading_point->hit_surface());
+
+    // Update ray casting statistics.
+    m_probe_ray_count += ray_count;
+    m_packet_ray_count += ray_count;
+
+    // Compute ray infos once for the entire traversal.
+    ShadingRay::RayInfoType ray_infos[RayPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        assert(is_normalized(rays[i].m_dir));
+        ray_infos[i] = ShadingRay::RayInfoType(rays[i]);
+    }
+
+    // Refine and offset the previous intersection point.
+    if (parent_shading_point &&
+        parent_shading_point->hit_surface() &&
+        !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+        parent_shading_point->refine_and_offset();
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    // Check the intersection between the rays and the assembly tree.
+    AssemblyTreeProbePacketIntersector intersector;
+    AssemblyLeafProbePacketVisitor visitor(
+        assembly_tree,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        m_embree_scene_cache,
+#endif
+        parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
+#endif
+        );
+    intersector.intersect_no_motion(
+        assembly_tree,
+        rays,
+        ray_infos,
+        ray_count,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_assembly_tree_traversal_stats
+#endif
+        );
+
+    const uint32 hit_mask = visitor.get_hit_mask();
+    for (size_t i = 0; i < ray_count; ++i)
+        hits[i] = (hit_mask & (1u << i)) != 0;
+}
+
 void Intersector::make_triangle_shading_point(
     ShadingPoint&                       shading_point,
     const ShadingRay&                   shading_ray,
@@ -384,63 +561,63 @@ void Intersector::make_triangle_shading_point(
     shading_point.m_members = 0;
 }
 
-void Intersector::make_procedural_surface_shading_point(
-    ShadingPoint&                       shading_point,
-    const ShadingRay&                   shading_ray,
-    const Vector2f&                     uv,
-    const AssemblyInstance*             assembly_instance,
-    const Transformd&                   assembly_instance_transform,
-    const size_t                        object_instance_index,
-    const size_t                        primitive_index,
-    const Vector3d&                     point,
-    const Vector3d&                     normal,
-    const Vector3d&                     dpdu,
-    const Vector3d&                     dpdv) const
-{
-    // This helps finding bugs if make_surface_shading_point()
-    // is called on a previously used shading point.
-    debug_poison(shading_point);
-
-    shading_point.m_texture_cache = &m_texture_cache;
-    shading_point.m_scene = &m_trace_context.get_scene();
-
-    assert(shading_ray.m_has_differentials == false);
-    shading_point.m_ray = shading_ray;
-
-    shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
-
-    shading_point.m_bary = uv;
-    shading_point.m_assembly_instance = assembly_instance;
-    shading_point.m_assembly_instance_transform = assembly_instance_transform;
-    shading_point.m_assembly_instance_transform_seq = &assembly_instance->transform_sequence();
-    shading_point.m_object_instance_index = object_instance_index;
-    shading_point.m_primitive_index = primitive_index;
-
-    shading_point.m_point = point;
-    shading_point.m_members |= ShadingPoint::HasPoint;
-
-    assert(is_normalized(normal));
-    shading_point.m_geometric_normal = shading_point.m_original_shading_normal = normal;
-    shading_point.m_members |= ShadingPoint::HasGeometricNormal | ShadingPoint::HasOriginalShadingNormal;
-
-    shading_point.m_shading_basis = Basis3d(
-        normal,
-        normalize(dpdu),
-        normalize(dpdv));
-    shading_point.m_members |= ShadingPoint::HasShadingBasis;
-
-    shading_point.m_uv = uv;
-    shading_point.m_members = ShadingPoint::HasUV0;
-
-    shading_point.m_dpdu = dpdu;
-    shading_point.m_dpdu = dpdv;
-    shading_point.m_members |= ShadingPoint::HasWorldSpaceDerivatives;
-
-    shading_point.m_dpdx = Vector3d(0.0);
-    shading_point.m_dpdy = Vector3d(0.0);
-    shading_point.m_duvdx = Vector2f(0.0);
-    shading_point.m_duvdy = Vector2f(0.0);
-    shading_point.m_members = ShadingPoint::HasScreenSpaceDerivatives;
+void Intersector::make_procedural_surface_shading_point(
+    ShadingPoint&                       shading_point,
+    const ShadingRay&                   shading_ray,
+    const Vector2f&                     uv,
+    const AssemblyInstance*             assembly_instance,
+    const Transformd&                   assembly_instance_transform,
+    const size_t                        object_instance_index,
+    const size_t                        primitive_index,
+    const Vector3d&                     point,
+    const Vector3d&                     normal,
+    const Vector3d&                     dpdu,
+    const Vector3d&                     dpdv) const
+{
+    // This helps finding bugs if make_surface_shading_point()
+    // is called on a previously used shading point.
+    debug_poison(shading_point);
+
+    shading_point.m_texture_cache = &m_texture_cache;
+    shading_point.m_scene = &m_trace_context.get_scene();
+
+    assert(shading_ray.m_has_differentials == false);
+    shading_point.m_ray = shading_ray;
+
+    shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
+
+    shading_point.m_bary = uv;
+    shading_point.m_assembly_instance = assembly_instance;
+    shading_point.m_assembly_instance_transform = assembly_instance_transform;
+    shading_point.m_assembly_instance_transform_seq = &assembly_instance->transform_sequence();
+    shading_point.m_object_instance_index = object_instance_index;
+    shading_point.m_primitive_index = primitive_index;
+
+    shading_point.m_point = point;
+    shading_point.m_members |= ShadingPoint::HasPoint;
+
+    assert(is_normalized(normal));
+    shading_point.m_geometric_normal = shading_point.m_original_shading_normal = normal;
+    shading_point.m_members |= ShadingPoint::HasGeometricNormal | ShadingPoint::HasOriginalShadingNormal;
+
+    shading_point.m_shading_basis = Basis3d(
+        normal,
+        normalize(dpdu),
+        normalize(dpdv));
+    shading_point.m_members |= ShadingPoint::HasShadingBasis;
+
+    shading_point.m_uv = uv;
+    shading_point.m_members = ShadingPoint::HasUV0;
+
+    shading_point.m_dpdu = dpdu;
+    shading_point.m_dpdu = dpdv;
+    shading_point.m_members |= ShadingPoint::HasWorldSpaceDerivatives;
+
+    shading_point.m_dpdx = Vector3d(0.0);
+    shading_point.m_dpdy = Vector3d(0.0);
+    shading_point.m_duvdx = Vector2f(0.0);
+    shading_point.m_duvdy = Vector2f(0.0);
+    shading_point.m_members = ShadingPoint::HasScreenSpaceDerivatives;
 }
 
 void Intersector::make_volume_shading_point(
@@ -525,6 +702,12 @@ StatisticsVector Intersector::get_statistics() const
                 "probe rays",
                 m_probe_ray_count,
                 total_ray_count)));
+    intersection_stats.insert(
+        unique_ptr<RayCountStatisticsEntry>(
+            new RayCountStatisticsEntry(
+                "rays traced in packets",
+                m_packet_ray_count,
+                total_ray_count)));
 
     StatisticsVector vec;
 
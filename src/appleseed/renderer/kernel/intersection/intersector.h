@@ -103,6 +103,23 @@ class Intersector
         const ShadingRay&                   ray,
         const ShadingPoint*                 parent_shading_point = nullptr) const;
 
+    // Trace a batch of world space rays through the scene. Rays are traced in packets of
+    // up to RayPacketSize rays sharing a single traversal of the scene, which pays off
+    // when the rays are coherent (e.g. camera rays of a pixel or shadow rays of a point).
+    void trace(
+        const ShadingRay*                   rays,
+        const size_t                        ray_count,
+        ShadingPoint*                       shading_points,
+        const ShadingPoint*                 parent_shading_point = nullptr) const;
+
+    // Trace a batch of world space probe rays through the scene.
+    // On return, hits[i] tells whether rays[i] hit something.
+    void trace_probe(
+        const ShadingRay*                   rays,
+        const size_t                        ray_count,
+        bool*                               hits,
+        const ShadingPoint*                 parent_shading_point = nullptr) const;
+
     // Manufacture a triangle hit "by hand".
     // There is no restriction placed on the shading point passed to this method.
     // For instance it may have been previously initialized and used.
@@ -116,20 +133,20 @@ class Intersector
         const size_t                        primitive_index,
         const TriangleSupportPlaneType&     triangle_support_plane) const;
 
-    // Manufacture a procedural surface hit "by hand".
-    // There is no restriction placed on the shading point passed to this method.
-    // For instance it may have been previously initialized and used.
-    void make_procedural_surface_shading_point(
-        ShadingPoint&                       shading_point,
-        const ShadingRay&                   shading_ray,
-        const foundation::Vector2f&         uv,
-        const AssemblyInstance*             assembly_instance,
-        const foundation::Transformd&       assembly_instance_transform,
-        const size_t                        object_instance_index,
-        const size_t                        primitive_index,
-        const foundation::Vector3d&         point,
-        const foundation::Vector3d&         normal,
-        const foundation::Vector3d&         dpdu,
+    // Manufacture a procedural surface hit "by hand".
+    // There is no restriction placed on the shading point passed to this method.
+    // For instance it may have been previously initialized and used.
+    void make_procedural_surface_shading_point(
+        ShadingPoint&                       shading_point,
+        const ShadingRay&                   shading_ray,
+        const foundation::Vector2f&         uv,
+        const AssemblyInstance*             assembly_instance,
+        const foundation::Transformd&       assembly_instance_transform,
+        const size_t                        object_instance_index,
+        const size_t                        primitive_index,
+        const foundation::Vector3d&         point,
+        const foundation::Vector3d&         normal,
+        const foundation::Vector3d&         dpdu,
         const foundation::Vector3d&         dpdv) const;
 
     // Manufacture a volume shading point "by hand".
@@ -157,11 +174,24 @@ class Intersector
     // Intersection statistics.
     mutable foundation::uint64                      m_shading_ray_count;
     mutable foundation::uint64                      m_probe_ray_count;
+    mutable foundation::uint64                      m_packet_ray_count;
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     mutable foundation::bvh::TraversalStatistics    m_assembly_tree_traversal_stats;
     mutable foundation::bvh::TraversalStatistics    m_triangle_tree_traversal_stats;
     mutable foundation::bvh::TraversalStatistics    m_curve_tree_traversal_stats;
 #endif
+
+    void trace_packet(
+        const ShadingRay*                   rays,
+        const size_t                        ray_count,
+        ShadingPoint*                       shading_points,
+        const ShadingPoint*                 parent_shading_point) const;
+
+    void trace_probe_packet(
+        const ShadingRay*                   rays,
+        const size_t                        ray_count,
+        bool*                               hits,
+        const ShadingPoint*                 parent_shading_point) const;
 };
 
 }   // namespace renderer
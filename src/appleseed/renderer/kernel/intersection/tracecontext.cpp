@@ -48,6 +48,7 @@
 #include <string>
 
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
@@ -86,6 +87,13 @@ void TraceContext::update()
     m_assembly_tree->update();
 }
 
+void TraceContext::set_tree_cache(
+    const string&   directory,
+    const uint64    max_size)
+{
+    m_assembly_tree->set_tree_cache(directory, max_size);
+}
+
 #ifdef APPLESEED_WITH_EMBREE
 
 void TraceContext::set_use_embree(const bool value)
@@ -31,10 +31,14 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <string>
+
 // Forward declarations.
 namespace renderer  { class AssemblyTree; }
 namespace renderer  { class Scene; }
@@ -68,6 +72,12 @@ class APPLESEED_DLLSYMBOL TraceContext
     // Synchronize the trace context with the scene.
     void update();
 
+    // Persist ray tracing acceleration structures in a cache directory,
+    // or stop doing so if the directory is empty.
+    void set_tree_cache(
+        const std::string&      directory,
+        const foundation::uint64 max_size);
+
 #ifdef APPLESEED_WITH_EMBREE
     void set_use_embree(const bool value);
 #endif
@@ -0,0 +1,73 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "treecache.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/scene/objectinstance.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/transform.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
+
+using namespace foundation;
+
+namespace renderer
+{
+
+void hash_tree_parameters(
+    SipHashAccumulator&     hash,
+    const ParamArray&       params)
+{
+    for (const_each<StringDictionary> i = params.strings(); i; ++i)
+    {
+        hash.append(i->key());
+        hash.append(i->value());
+    }
+
+    for (const_each<DictionaryDictionary> i = params.dictionaries(); i; ++i)
+    {
+        hash.append(i->key());
+        hash_tree_parameters(hash, static_cast<const ParamArray&>(i->value()));
+    }
+}
+
+void hash_object_instance(
+    SipHashAccumulator&     hash,
+    const size_t            object_instance_index,
+    const ObjectInstance&   object_instance)
+{
+    hash.append(static_cast<uint64>(object_instance_index));
+    hash.append(object_instance.get_transform().get_local_to_parent());
+    hash.append(static_cast<uint32>(object_instance.get_vis_flags()));
+}
+
+}   // namespace renderer
@@ -0,0 +1,119 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/diskcache.h"
+#include "foundation/utility/siphash.h"
+
+// Standard headers.
+#include <cstddef>
+#include <type_traits>
+
+// Forward declarations.
+namespace renderer  { class ObjectInstance; }
+
+namespace renderer
+{
+
+//
+// Helpers to persist ray tracing acceleration structures in a foundation::DiskCache.
+//
+// Cache keys must capture everything a tree is derived from: its parameters,
+// the placement of the object instances and the geometry of the objects.
+//
+
+// Hash the construction parameters of a tree, including nested parameters.
+void hash_tree_parameters(
+    foundation::SipHashAccumulator&         hash,
+    const ParamArray&                       params);
+
+// Hash the index, transform and visibility flags of an object instance.
+void hash_object_instance(
+    foundation::SipHashAccumulator&         hash,
+    const size_t                            object_instance_index,
+    const ObjectInstance&                   object_instance);
+
+// Return a cache section referencing the elements of a vector.
+template <typename Vector>
+foundation::DiskCache::Section make_tree_cache_section(const Vector& vec);
+
+// Replace the elements of a vector by the content of a cache section.
+// Returns false if the section doesn't contain a whole number of elements.
+template <typename Vector>
+bool read_tree_cache_section(
+    const foundation::DiskCache::Section&   section,
+    Vector&                                 vec);
+
+
+//
+// Implementation.
+//
+
+template <typename Vector>
+foundation::DiskCache::Section make_tree_cache_section(const Vector& vec)
+{
+    typedef typename Vector::value_type ValueType;
+
+    static_assert(
+        std::is_trivially_copyable<ValueType>::value,
+        "Only vectors of trivially copyable elements can be cached");
+
+    return
+        foundation::DiskCache::Section(
+            vec.empty() ? nullptr : &vec[0],
+            vec.size() * sizeof(ValueType));
+}
+
+template <typename Vector>
+bool read_tree_cache_section(
+    const foundation::DiskCache::Section&   section,
+    Vector&                                 vec)
+{
+    typedef typename Vector::value_type ValueType;
+
+    static_assert(
+        std::is_trivially_copyable<ValueType>::value,
+        "Only vectors of trivially copyable elements can be cached");
+
+    if (section.m_size % sizeof(ValueType) != 0)
+        return false;
+
+    const ValueType* begin = static_cast<const ValueType*>(section.m_data);
+    vec.assign(begin, begin + section.m_size / sizeof(ValueType));
+
+    return true;
+}
+
+}   // namespace renderer
@@ -44,6 +44,89 @@ using namespace std;
 namespace renderer
 {
 
+namespace
+{
+    size_t compute_triangle_size(const TriangleVertexInfo& vertex_info)
+    {
+        size_t size = 0;
+
+        size += sizeof(uint32);         // visibility flags
+        size += sizeof(uint32);         // motion segment count
+
+        if (vertex_info.m_motion_segment_count == 0)
+            size += sizeof(GTriangleType);
+        else size += (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3);
+
+        return size;
+    }
+
+    size_t compute_indexed_triangle_size(const TriangleVertexInfo& vertex_info)
+    {
+        return
+            vertex_info.m_motion_segment_count == 0
+                ? 2 * sizeof(uint32) + 3 * sizeof(uint32)   // visibility flags, motion segment count, vertex indices
+                : compute_triangle_size(vertex_info);
+    }
+
+    void encode_triangle(
+        const TriangleVertexInfo&       vertex_info,
+        const vector<GVector3>&         triangle_vertices,
+        MemoryWriter&                   writer)
+    {
+        writer.write(vertex_info.m_vis_flags);
+        writer.write(static_cast<uint32>(vertex_info.m_motion_segment_count));
+
+        if (vertex_info.m_motion_segment_count == 0)
+        {
+            writer.write(
+                GTriangleType(
+                    triangle_vertices[vertex_info.m_vertex_index + 0],
+                    triangle_vertices[vertex_info.m_vertex_index + 1],
+                    triangle_vertices[vertex_info.m_vertex_index + 2]));
+        }
+        else
+        {
+            writer.write(
+                &triangle_vertices[vertex_info.m_vertex_index],
+                (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3));
+        }
+    }
+
+    void encode_group(
+        const TriangleVertexInfo* const*    vertex_infos,
+        const size_t                        triangle_count,
+        const vector<GVector3>&             triangle_vertices,
+        MemoryWriter&                       writer)
+    {
+        uint32 vis_flags[TriangleTreeGroupSize];
+        GTriangleGroupType group;
+
+        for (size_t i = 0; i < TriangleTreeGroupSize; ++i)
+        {
+            if (i < triangle_count)
+            {
+                const TriangleVertexInfo& vertex_info = *vertex_infos[i];
+                vis_flags[i] = vertex_info.m_vis_flags;
+                group.set(
+                    i,
+                    GTriangleType(
+                        triangle_vertices[vertex_info.m_vertex_index + 0],
+                        triangle_vertices[vertex_info.m_vertex_index + 1],
+                        triangle_vertices[vertex_info.m_vertex_index + 2]));
+            }
+            else
+            {
+                // Unused slots are invisible to all rays.
+                vis_flags[i] = 0;
+                group.clear(i);
+            }
+        }
+
+        writer.write(vis_flags, sizeof(vis_flags));
+        writer.write(group);
+    }
+}
+
 size_t TriangleEncoder::compute_size(
     const vector<TriangleVertexInfo>&   triangle_vertex_infos,
     const vector<size_t>&               triangle_indices,
@@ -55,20 +138,55 @@ size_t TriangleEncoder::compute_size(
     for (size_t i = 0; i < item_count; ++i)
     {
         const size_t triangle_index = triangle_indices[item_begin + i];
-        const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+        size += compute_triangle_size(triangle_vertex_infos[triangle_index]);
+    }
 
-        size += sizeof(uint32);         // visibility flags
-        size += sizeof(uint32);         // motion segment count
+    return size;
+}
+
+void TriangleEncoder::encode(
+    const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+    const vector<GVector3>&             triangle_vertices,
+    const vector<size_t>&               triangle_indices,
+    const size_t                        item_begin,
+    const size_t                        item_count,
+    MemoryWriter&                       writer)
+{
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const size_t triangle_index = triangle_indices[item_begin + i];
+        encode_triangle(triangle_vertex_infos[triangle_index], triangle_vertices, writer);
+    }
+}
+
+size_t TriangleEncoder::compute_grouped_size(
+    const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+    const vector<size_t>&               triangle_indices,
+    const size_t                        item_begin,
+    const size_t                        item_count)
+{
+    const size_t GroupSize = TriangleTreeGroupSize * sizeof(uint32) + sizeof(GTriangleGroupType);
+
+    size_t size = sizeof(uint32);       // static triangle count
+    size_t static_triangle_count = 0;
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const size_t triangle_index = triangle_indices[item_begin + i];
+        const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
 
         if (vertex_info.m_motion_segment_count == 0)
-            size += sizeof(GTriangleType);
-        else size += (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3);
+            ++static_triangle_count;
+        else size += compute_triangle_size(vertex_info);
     }
 
+    const size_t group_count = (static_triangle_count + TriangleTreeGroupSize - 1) / TriangleTreeGroupSize;
+    size += group_count * GroupSize;
+
     return size;
 }
 
-void TriangleEncoder::encode(
+void TriangleEncoder::encode_grouped(
     const vector<TriangleVertexInfo>&   triangle_vertex_infos,
     const vector<GVector3>&             triangle_vertices,
     const vector<size_t>&               triangle_indices,
@@ -76,28 +194,92 @@ void TriangleEncoder::encode(
     const size_t                        item_count,
     MemoryWriter&                       writer)
 {
+    size_t static_triangle_count = 0;
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const size_t triangle_index = triangle_indices[item_begin + i];
+        if (triangle_vertex_infos[triangle_index].m_motion_segment_count == 0)
+            ++static_triangle_count;
+    }
+
+    writer.write(static_cast<uint32>(static_triangle_count));
+
+    // Write groups of static triangles.
+    const TriangleVertexInfo* group_vertex_infos[TriangleTreeGroupSize];
+    size_t group_triangle_count = 0;
+
     for (size_t i = 0; i < item_count; ++i)
     {
         const size_t triangle_index = triangle_indices[item_begin + i];
         const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
 
-        writer.write(vertex_info.m_vis_flags);
-        writer.write(static_cast<uint32>(vertex_info.m_motion_segment_count));
+        if (vertex_info.m_motion_segment_count > 0)
+            continue;
 
-        if (vertex_info.m_motion_segment_count == 0)
+        group_vertex_infos[group_triangle_count++] = &vertex_info;
+
+        if (group_triangle_count == TriangleTreeGroupSize)
         {
-            writer.write(
-                GTriangleType(
-                    triangle_vertices[vertex_info.m_vertex_index + 0],
-                    triangle_vertices[vertex_info.m_vertex_index + 1],
-                    triangle_vertices[vertex_info.m_vertex_index + 2]));
+            encode_group(group_vertex_infos, group_triangle_count, triangle_vertices, writer);
+            group_triangle_count = 0;
         }
-        else
+    }
+
+    if (group_triangle_count > 0)
+        encode_group(group_vertex_infos, group_triangle_count, triangle_vertices, writer);
+
+    // Write moving triangles.
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const size_t triangle_index = triangle_indices[item_begin + i];
+        const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+        if (vertex_info.m_motion_segment_count > 0)
+            encode_triangle(vertex_info, triangle_vertices, writer);
+    }
+}
+
+size_t TriangleEncoder::compute_indexed_size(
+    const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+    const vector<size_t>&               triangle_indices,
+    const size_t                        item_begin,
+    const size_t                        item_count)
+{
+    size_t size = 0;
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const size_t triangle_index = triangle_indices[item_begin + i];
+        size += compute_indexed_triangle_size(triangle_vertex_infos[triangle_index]);
+    }
+
+    return size;
+}
+
+void TriangleEncoder::encode_indexed(
+    const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+    const vector<GVector3>&             triangle_vertices,
+    const vector<uint32>&               vertex_indices,
+    const vector<size_t>&               triangle_indices,
+    const size_t                        item_begin,
+    const size_t                        item_count,
+    MemoryWriter&                       writer)
+{
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const size_t triangle_index = triangle_indices[item_begin + i];
+        const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+        if (vertex_info.m_motion_segment_count == 0)
         {
-            writer.write(
-                &triangle_vertices[vertex_info.m_vertex_index],
-                (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3));
+            writer.write(vertex_info.m_vis_flags);
+            writer.write(static_cast<uint32>(0));
+            writer.write(vertex_indices[vertex_info.m_vertex_index + 0]);
+            writer.write(vertex_indices[vertex_info.m_vertex_index + 1]);
+            writer.write(vertex_indices[vertex_info.m_vertex_index + 2]);
         }
+        else encode_triangle(vertex_info, triangle_vertices, writer);
     }
 }
 
@@ -32,6 +32,9 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+
 // Standard headers.
 #include <cstddef>
 #include <vector>
@@ -59,6 +62,40 @@ class TriangleEncoder
         const size_t                            item_begin,
         const size_t                            item_count,
         foundation::MemoryWriter&               writer);
+
+    // Leaves with static triangles packed into groups of TriangleTreeGroupSize triangles.
+    // Static triangles are stored first, in the order of the leaf, followed by moving triangles.
+    static size_t compute_grouped_size(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count);
+
+    static void encode_grouped(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count,
+        foundation::MemoryWriter&               writer);
+
+    // Leaves with static triangles referencing their vertices by index into a vertex array
+    // shared by all leaves. vertex_indices maps triangle_vertices to that shared array.
+    // Moving triangles are stored as in regular leaves.
+    static size_t compute_indexed_size(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count);
+
+    static void encode_indexed(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<foundation::uint32>&  vertex_indices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count,
+        foundation::MemoryWriter&               writer);
 };
 
 }   // namespace renderer
@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/intersection/intersectionfilter.h"
+#include "renderer/kernel/intersection/treecache.h"
 #include "renderer/kernel/intersection/triangleencoder.h"
 #include "renderer/kernel/intersection/triangleitemhandler.h"
 #include "renderer/kernel/intersection/trianglevertexinfo.h"
@@ -55,6 +56,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/area.h"
+#include "foundation/math/hash.h"
 #include "foundation/math/intersection/aabbtriangle.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/transform.h"
@@ -64,16 +66,23 @@
 #include "foundation/platform/timers.h"
 #include "foundation/utility/alignedallocator.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/countof.h"
+#include "foundation/utility/diskcache.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/memory.h"
+#include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/unordered_map.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <set>
 #include <string>
 
@@ -386,23 +395,54 @@ TriangleTree::Arguments::Arguments(
     const Scene&            scene,
     const UniqueID          triangle_tree_uid,
     const GAABB3&           bbox,
-    const Assembly&         assembly)
+    const Assembly&         assembly,
+    shared_ptr<DiskCache>   cache)
   : m_scene(scene)
   , m_triangle_tree_uid(triangle_tree_uid)
   , m_bbox(bbox)
   , m_assembly(assembly)
+  , m_cache(cache)
 {
 }
 
 TriangleTree::TriangleTree(const Arguments& arguments)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_arguments(arguments)
+{
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+
+    // Compact leaves take precedence over SIMD leaves since triangle groups cannot reference shared vertices.
+    m_compact_leaves = params.get_optional<bool>("compact_leaves", false);
+    m_simd_leaves = !m_compact_leaves && params.get_optional<bool>("simd_leaves", false);
+
+    if (m_arguments.m_cache)
+    {
+        const uint64 cache_key = compute_cache_key(params);
+
+        if (!load_from_cache(cache_key))
+        {
+            build(params);
+            save_to_cache(cache_key);
+        }
+    }
+    else build(params);
+}
+
+TriangleTree::~TriangleTree()
+{
+    RENDERER_LOG_INFO(
+        "deleting triangle tree #" FMT_UNIQUE_ID "...",
+        m_arguments.m_triangle_tree_uid);
+
+    delete_intersection_filters();
+}
+
+void TriangleTree::build(const ParamArray& params)
 {
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building triangle tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
-    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
-    const string algorithm = params.get_optional<string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
+    const string algorithm = params.get_optional<string>("algorithm", "bvh", make_vector("bvh", "sbvh", "binned_bvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
     const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
 
@@ -414,8 +454,11 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     Statistics statistics;
     if (algorithm == "bvh")
         build_bvh(params, time, save_memory, statistics);
-    else build_sbvh(params, time, save_memory, statistics);
+    else if (algorithm == "sbvh")
+        build_sbvh(params, time, save_memory, statistics);
+    else build_binned_bvh(params, time, save_memory, statistics);
     statistics.insert_time("total build time", stopwatch.measure().get_seconds());
+    statistics.insert("sah cost", bvh::TreeSAHCost<TriangleTree>::evaluate(*this, AABB3d(m_arguments.m_bbox)));
     statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
 
 #ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
@@ -425,6 +468,23 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     assert(m_nodes.size() == m_nodes.capacity());
 #endif
 
+    // Build wide nodes. They reference the leaves of the binary tree and must be built after its layout is final.
+    const size_t node_width = params.get_optional<size_t>("node_width", TriangleTreeDefaultNodeWidth, make_vector("2", "4", "8"), message_context);
+    if (m_moving_triangle_count == 0)
+    {
+        if (node_width == 4)
+            build_wide_nodes<4>(statistics);
+        else if (node_width == 8)
+            build_wide_nodes<8>(statistics);
+    }
+
+    // Report the memory footprint of the tree, to help choose leaf formats per assembly.
+    const size_t memory_size = get_memory_size();
+    statistics.insert_size("tree size", memory_size);
+    statistics.insert(
+        "bytes per triangle",
+        static_cast<double>(memory_size) / max<size_t>(m_static_triangle_count + m_moving_triangle_count, 1));
+
     // Print triangle tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -432,15 +492,6 @@ TriangleTree::TriangleTree(const Arguments& arguments)
             statistics).to_string().c_str());
 }
 
-TriangleTree::~TriangleTree()
-{
-    RENDERER_LOG_INFO(
-        "deleting triangle tree #" FMT_UNIQUE_ID "...",
-        m_arguments.m_triangle_tree_uid);
-
-    delete_intersection_filters();
-}
-
 void TriangleTree::update_non_geometry(const bool enable_intersection_filters)
 {
     if (enable_intersection_filters &&
@@ -456,7 +507,8 @@ size_t TriangleTree::get_memory_size() const
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
         + m_triangle_keys.capacity() * sizeof(TriangleKey)
-        + m_leaf_data.capacity() * sizeof(uint8);
+        + m_leaf_data.capacity() * sizeof(uint8)
+        + m_vertices.capacity() * sizeof(GVector3);
 }
 
 namespace
@@ -535,7 +587,10 @@ void TriangleTree::build_bvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_simd_leaves ? TriangleTreeDefaultSIMDMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
 
@@ -638,7 +693,10 @@ void TriangleTree::build_sbvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_simd_leaves ? TriangleTreeDefaultSIMDMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const size_t bin_count = params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
@@ -707,6 +765,127 @@ void TriangleTree::build_sbvh(
     statistics.insert_time("store time", store_time);
 }
 
+void TriangleTree::build_binned_bvh(
+    const ParamArray&   params,
+    const double        time,
+    const bool          save_memory,
+    Statistics&         statistics)
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+
+    // Collect triangles intersecting the bounding box of this tree.
+    RENDERER_LOG_INFO(
+        "collecting geometry for triangle tree #" FMT_UNIQUE_ID " from assembly \"%s\"...",
+        m_arguments.m_triangle_tree_uid,
+        m_arguments.m_assembly.get_path().c_str());
+    stopwatch.start();
+    vector<TriangleKey> triangle_keys;
+    vector<TriangleVertexInfo> triangle_vertex_infos;
+    vector<GAABB3> triangle_bboxes;
+    collect_triangles(
+        m_arguments,
+        time,
+        save_memory,
+        &triangle_keys,
+        &triangle_vertex_infos,
+        nullptr,
+        &triangle_bboxes);
+    const double collection_time = stopwatch.measure().get_seconds();
+
+    // Store the number of static and moving triangles.
+    m_static_triangle_count = count_static_triangles(triangle_vertex_infos);
+    m_moving_triangle_count = triangle_vertex_infos.size() - m_static_triangle_count;
+
+    // Retrieving the partitioner and builder parameters.
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_simd_leaves ? TriangleTreeDefaultSIMDMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
+    const size_t bin_count = params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinnedBVHBinCount);
+    const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
+    const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
+    const size_t thread_count = params.get_optional<size_t>("build_threads", System::get_logical_cpu_core_count());
+    const size_t min_parallel_subtree_size = params.get_optional<size_t>("min_parallel_subtree_size", TriangleTreeDefaultMinParallelSubtreeSize);
+
+    // Print statistics about the input geometry.
+    RENDERER_LOG_INFO(
+        "building triangle tree #" FMT_UNIQUE_ID " (binned bvh, %s %s, %s %s, %s %s)...",
+        m_arguments.m_triangle_tree_uid,
+        pretty_uint(m_static_triangle_count).c_str(),
+        plural(m_static_triangle_count, "static triangle").c_str(),
+        pretty_uint(m_moving_triangle_count).c_str(),
+        plural(m_moving_triangle_count, "moving triangle").c_str(),
+        pretty_uint(thread_count).c_str(),
+        plural(thread_count, "thread").c_str());
+
+    // Create the partitioner.
+    typedef bvh::BinnedSAHPartitioner<vector<GAABB3>> Partitioner;
+    Partitioner partitioner(
+        triangle_bboxes,
+        max_leaf_size,
+        bin_count,
+        interior_node_traversal_cost,
+        triangle_intersection_cost);
+
+    // Build the tree.
+    typedef bvh::ParallelBuilder<TriangleTree, Partitioner> Builder;
+    Builder builder(global_logger(), thread_count, min_parallel_subtree_size);
+    builder.build<DefaultWallclockTimer>(
+        *this,
+        partitioner,
+        triangle_keys.size(),
+        max_leaf_size);
+    statistics.merge(
+        bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
+    statistics.insert("parallel subtrees", builder.get_parallel_subtree_count());
+
+    stopwatch.start();
+
+    // Bounding boxes are no longer needed.
+    clear_release_memory(triangle_bboxes);
+
+    // Collect triangle vertices.
+    vector<GVector3> triangle_vertices;
+    collect_triangles<GAABB3>(
+        m_arguments,
+        time,
+        save_memory,
+        nullptr,
+        nullptr,
+        &triangle_vertices,
+        nullptr);
+
+    // Compute and propagate motion bounding boxes.
+    compute_motion_bboxes(
+        partitioner.get_item_ordering(),
+        triangle_vertex_infos,
+        triangle_vertices,
+        0);
+
+    // Store triangles and triangle keys into the tree.
+    store_triangles(
+        partitioner.get_item_ordering(),
+        triangle_vertex_infos,
+        triangle_vertices,
+        triangle_keys,
+        statistics);
+
+    const double store_time = stopwatch.measure().get_seconds();
+
+    statistics.insert_time("collection time", collection_time);
+    statistics.insert_time("partition time", builder.get_build_time());
+    statistics.insert_time("store time", store_time);
+}
+
+template <size_t Width>
+void TriangleTree::build_wide_nodes(Statistics& statistics)
+{
+    bvh::WideBuilder<TriangleTree, Width> builder;
+    builder.template build<DefaultWallclockTimer>(*this);
+    statistics.merge(builder.get_statistics());
+    statistics.insert_time("wide nodes build time", builder.get_build_time());
+}
+
 namespace
 {
 #ifdef APPLESEED_USE_SSE
@@ -875,6 +1054,108 @@ vector<GAABB3> TriangleTree::compute_motion_bboxes(
     }
 }
 
+namespace
+{
+    // Leaves reference shared vertices if vertex_indices is not null.
+    size_t compute_leaf_size(
+        const bool                          simd_leaves,
+        const vector<uint32>*               vertex_indices,
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count)
+    {
+        if (vertex_indices)
+            return TriangleEncoder::compute_indexed_size(triangle_vertex_infos, triangle_indices, item_begin, item_count);
+
+        return
+            simd_leaves
+                ? TriangleEncoder::compute_grouped_size(triangle_vertex_infos, triangle_indices, item_begin, item_count)
+                : TriangleEncoder::compute_size(triangle_vertex_infos, triangle_indices, item_begin, item_count);
+    }
+
+    void encode_leaf(
+        const bool                          simd_leaves,
+        const vector<uint32>*               vertex_indices,
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<GVector3>&             triangle_vertices,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count,
+        MemoryWriter&                       writer)
+    {
+        if (vertex_indices)
+            TriangleEncoder::encode_indexed(triangle_vertex_infos, triangle_vertices, *vertex_indices, triangle_indices, item_begin, item_count, writer);
+        else if (simd_leaves)
+            TriangleEncoder::encode_grouped(triangle_vertex_infos, triangle_vertices, triangle_indices, item_begin, item_count, writer);
+        else TriangleEncoder::encode(triangle_vertex_infos, triangle_vertices, triangle_indices, item_begin, item_count, writer);
+    }
+
+    // Vertices are welded based on their exact binary representation.
+    struct VertexHash
+    {
+        size_t operator()(const GVector3& v) const
+        {
+            uint32 words[sizeof(GVector3) / sizeof(uint32)];
+            memcpy(words, &v, sizeof(GVector3));
+
+            uint32 h = 0;
+            for (size_t i = 0; i < countof(words); ++i)
+                h = mix_uint32(h, words[i]);
+
+            return h;
+        }
+    };
+
+    struct VertexEqual
+    {
+        bool operator()(const GVector3& lhs, const GVector3& rhs) const
+        {
+            return memcmp(&lhs, &rhs, sizeof(GVector3)) == 0;
+        }
+    };
+
+    // Weld the vertices of static triangles into a shared vertex array, in the order in which
+    // leaves reference them, and map each triangle vertex to its index in the shared array.
+    void weld_static_vertices(
+        const vector<size_t>&               triangle_indices,
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<GVector3>&             triangle_vertices,
+        vector<GVector3>&                   shared_vertices,
+        vector<uint32>&                     vertex_indices)
+    {
+        typedef boost::unordered_map<GVector3, uint32, VertexHash, VertexEqual> VertexMap;
+        VertexMap vertex_map;
+
+        shared_vertices.clear();
+        vertex_indices.assign(triangle_vertices.size(), ~uint32(0));
+
+        for (size_t i = 0; i < triangle_indices.size(); ++i)
+        {
+            const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_indices[i]];
+
+            if (vertex_info.m_motion_segment_count > 0)
+                continue;
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const size_t vertex_index = vertex_info.m_vertex_index + j;
+                const GVector3& vertex = triangle_vertices[vertex_index];
+
+                const pair<VertexMap::iterator, bool> result =
+                    vertex_map.insert(make_pair(vertex, static_cast<uint32>(shared_vertices.size())));
+
+                if (result.second)
+                    shared_vertices.push_back(vertex);
+
+                vertex_indices[vertex_index] = result.first->second;
+            }
+        }
+
+        shrink_to_fit(shared_vertices);
+    }
+}
+
 void TriangleTree::store_triangles(
     const vector<size_t>&               triangle_indices,
     const vector<TriangleVertexInfo>&   triangle_vertex_infos,
@@ -884,11 +1165,30 @@ void TriangleTree::store_triangles(
 {
     const size_t node_count = m_nodes.size();
 
+    // Compact leaves reference vertices shared by all leaves.
+
+    vector<uint32> vertex_indices;
+    const vector<uint32>* vertex_indices_ptr = nullptr;
+
+    if (m_compact_leaves)
+    {
+        weld_static_vertices(
+            triangle_indices,
+            triangle_vertex_infos,
+            triangle_vertices,
+            m_vertices,
+            vertex_indices);
+
+        vertex_indices_ptr = &vertex_indices;
+    }
+
     // Gather statistics.
 
     size_t leaf_count = 0;
     size_t fat_leaf_count = 0;
     size_t leaf_data_size = 0;
+    size_t group_count = 0;
+    size_t grouped_triangle_count = 0;
 
     for (size_t i = 0; i < node_count; ++i)
     {
@@ -902,7 +1202,9 @@ void TriangleTree::store_triangles(
             const size_t item_count = node.get_item_count();
 
             const size_t leaf_size =
-                TriangleEncoder::compute_size(
+                compute_leaf_size(
+                    m_simd_leaves,
+                    vertex_indices_ptr,
                     triangle_vertex_infos,
                     triangle_indices,
                     item_begin,
@@ -911,6 +1213,21 @@ void TriangleTree::store_triangles(
             if (leaf_size < NodeType::MaxUserDataSize)
                 ++fat_leaf_count;
             else leaf_data_size += leaf_size;
+
+            if (m_simd_leaves)
+            {
+                size_t leaf_static_triangle_count = 0;
+
+                for (size_t j = 0; j < item_count; ++j)
+                {
+                    const size_t triangle_index = triangle_indices[item_begin + j];
+                    if (triangle_vertex_infos[triangle_index].m_motion_segment_count == 0)
+                        ++leaf_static_triangle_count;
+                }
+
+                group_count += (leaf_static_triangle_count + TriangleTreeGroupSize - 1) / TriangleTreeGroupSize;
+                grouped_triangle_count += leaf_static_triangle_count;
+            }
         }
     }
 
@@ -932,14 +1249,36 @@ void TriangleTree::store_triangles(
 
             node.set_item_index(m_triangle_keys.size());
 
-            for (size_t j = 0; j < item_count; ++j)
+            if (m_simd_leaves)
+            {
+                // SIMD leaves store static triangles first, followed by moving triangles.
+                for (size_t j = 0; j < item_count; ++j)
+                {
+                    const size_t triangle_index = triangle_indices[item_begin + j];
+                    if (triangle_vertex_infos[triangle_index].m_motion_segment_count == 0)
+                        m_triangle_keys.push_back(triangle_keys[triangle_index]);
+                }
+
+                for (size_t j = 0; j < item_count; ++j)
+                {
+                    const size_t triangle_index = triangle_indices[item_begin + j];
+                    if (triangle_vertex_infos[triangle_index].m_motion_segment_count > 0)
+                        m_triangle_keys.push_back(triangle_keys[triangle_index]);
+                }
+            }
+            else
             {
-                const size_t triangle_index = triangle_indices[item_begin + j];
-                m_triangle_keys.push_back(triangle_keys[triangle_index]);
+                for (size_t j = 0; j < item_count; ++j)
+                {
+                    const size_t triangle_index = triangle_indices[item_begin + j];
+                    m_triangle_keys.push_back(triangle_keys[triangle_index]);
+                }
             }
 
             const size_t leaf_size =
-                TriangleEncoder::compute_size(
+                compute_leaf_size(
+                    m_simd_leaves,
+                    vertex_indices_ptr,
                     triangle_vertex_infos,
                     triangle_indices,
                     item_begin,
@@ -951,7 +1290,9 @@ void TriangleTree::store_triangles(
             {
                 user_data_writer.write<uint32>(~uint32(0));
 
-                TriangleEncoder::encode(
+                encode_leaf(
+                    m_simd_leaves,
+                    vertex_indices_ptr,
                     triangle_vertex_infos,
                     triangle_vertices,
                     triangle_indices,
@@ -963,7 +1304,9 @@ void TriangleTree::store_triangles(
             {
                 user_data_writer.write(static_cast<uint32>(leaf_data_writer.offset()));
 
-                TriangleEncoder::encode(
+                encode_leaf(
+                    m_simd_leaves,
+                    vertex_indices_ptr,
                     triangle_vertex_infos,
                     triangle_vertices,
                     triangle_indices,
@@ -975,6 +1318,185 @@ void TriangleTree::store_triangles(
     }
 
     statistics.insert_percent("fat leaves", fat_leaf_count, leaf_count);
+    statistics.insert_size("leaf data size", m_leaf_data.size());
+
+    if (m_compact_leaves)
+    {
+        statistics.insert("shared vertices", m_vertices.size());
+        statistics.insert_size("shared vertices size", m_vertices.size() * sizeof(GVector3));
+    }
+
+    if (m_simd_leaves)
+    {
+        statistics.insert("triangle groups", group_count);
+        statistics.insert("groups per leaf", static_cast<double>(group_count) / max<size_t>(leaf_count, 1));
+        statistics.insert_percent("group fill rate", grouped_triangle_count, group_count * TriangleTreeGroupSize);
+    }
+}
+
+namespace
+{
+    // Version of the layout of cached triangle trees.
+    // Must be incremented whenever the layout of nodes, triangle keys or leaves changes.
+    const uint32 TriangleTreeCacheFormat = 2;
+
+    struct TriangleTreeCacheHeader
+    {
+        uint64  m_static_triangle_count;
+        uint64  m_moving_triangle_count;
+    };
+
+    enum TriangleTreeCacheSection
+    {
+        HeaderSection,
+        NodesSection,
+        NodeBBoxesSection,
+        Wide4NodesSection,
+        Wide8NodesSection,
+        TriangleKeysSection,
+        LeafDataSection,
+        VerticesSection,
+        TriangleTreeCacheSectionCount
+    };
+}
+
+uint64 TriangleTree::compute_cache_key(const ParamArray& params) const
+{
+    SipHashAccumulator hash;
+
+    // Layout of the tree, which also depends on build options.
+    uint32 layout_flags = 0;
+#ifdef APPLESEED_USE_SSE
+    layout_flags |= 1UL << 0;       // node bounding boxes are swizzled
+#endif
+#ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
+    layout_flags |= 1UL << 1;       // nodes are reordered
+#endif
+    hash.append(TriangleTreeCacheFormat);
+    hash.append(layout_flags);
+    hash.append(static_cast<uint32>(sizeof(GScalar)));
+    hash.append(static_cast<uint32>(sizeof(NodeType)));
+
+    // Construction parameters and bounding box of the tree.
+    hash_tree_parameters(hash, params);
+    hash.append(m_arguments.m_bbox);
+
+    // Mesh object instances and their geometry.
+    const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
+    for (size_t i = 0, e = object_instances.size(); i < e; ++i)
+    {
+        const ObjectInstance* object_instance = object_instances.get_by_index(i);
+        assert(object_instance);
+
+        const Object& object = object_instance->get_object();
+        if (strcmp(object.get_model(), MeshObjectFactory().get_model()) != 0)
+            continue;
+
+        hash_object_instance(hash, i, *object_instance);
+
+        const StaticTriangleTess& tess = static_cast<const MeshObject&>(object).get_static_triangle_tess();
+        const size_t vertex_count = tess.m_vertices.size();
+        const size_t triangle_count = tess.m_primitives.size();
+        const size_t motion_segment_count = tess.get_motion_segment_count();
+
+        hash.append(static_cast<uint64>(vertex_count));
+        hash.append(static_cast<uint64>(triangle_count));
+        hash.append(static_cast<uint64>(motion_segment_count));
+
+        if (vertex_count > 0)
+            hash.append(&tess.m_vertices[0], vertex_count * sizeof(GVector3));
+
+        if (triangle_count > 0)
+            hash.append(&tess.m_primitives[0], triangle_count * sizeof(Triangle));
+
+        if (motion_segment_count > 0)
+        {
+            vector<GVector3> poses(vertex_count);
+
+            for (size_t m = 0; m < motion_segment_count; ++m)
+            {
+                for (size_t v = 0; v < vertex_count; ++v)
+                    poses[v] = tess.get_vertex_pose(v, m);
+
+                hash.append(&poses[0], vertex_count * sizeof(GVector3));
+            }
+        }
+    }
+
+    return hash.get_hash();
+}
+
+bool TriangleTree::load_from_cache(const uint64 key)
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    const unique_ptr<DiskCache::Entry> entry =
+        m_arguments.m_cache->load(key, TriangleTreeCacheFormat);
+
+    if (!entry ||
+        entry->get_section_count() != TriangleTreeCacheSectionCount ||
+        entry->get_section(HeaderSection).m_size != sizeof(TriangleTreeCacheHeader))
+        return false;
+
+    if (!read_tree_cache_section(entry->get_section(NodesSection), m_nodes) ||
+        !read_tree_cache_section(entry->get_section(NodeBBoxesSection), m_node_bboxes) ||
+        !read_tree_cache_section(entry->get_section(Wide4NodesSection), m_wide4_nodes) ||
+        !read_tree_cache_section(entry->get_section(Wide8NodesSection), m_wide8_nodes) ||
+        !read_tree_cache_section(entry->get_section(TriangleKeysSection), m_triangle_keys) ||
+        !read_tree_cache_section(entry->get_section(LeafDataSection), m_leaf_data) ||
+        !read_tree_cache_section(entry->get_section(VerticesSection), m_vertices) ||
+        m_nodes.empty())
+    {
+        clear();
+        m_node_bboxes.clear();
+        m_triangle_keys.clear();
+        m_leaf_data.clear();
+        m_vertices.clear();
+        return false;
+    }
+
+    const TriangleTreeCacheHeader& header =
+        *static_cast<const TriangleTreeCacheHeader*>(entry->get_section(HeaderSection).m_data);
+    m_static_triangle_count = static_cast<size_t>(header.m_static_triangle_count);
+    m_moving_triangle_count = static_cast<size_t>(header.m_moving_triangle_count);
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "loaded triangle tree #" FMT_UNIQUE_ID " for assembly \"%s\" from cache in %s.",
+        m_arguments.m_triangle_tree_uid,
+        m_arguments.m_assembly.get_path().c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    return true;
+}
+
+void TriangleTree::save_to_cache(const uint64 key) const
+{
+    TriangleTreeCacheHeader header;
+    header.m_static_triangle_count = m_static_triangle_count;
+    header.m_moving_triangle_count = m_moving_triangle_count;
+
+    const DiskCache::Section sections[TriangleTreeCacheSectionCount] =
+    {
+        DiskCache::Section(&header, sizeof(header)),
+        make_tree_cache_section(m_nodes),
+        make_tree_cache_section(m_node_bboxes),
+        make_tree_cache_section(m_wide4_nodes),
+        make_tree_cache_section(m_wide8_nodes),
+        make_tree_cache_section(m_triangle_keys),
+        make_tree_cache_section(m_leaf_data),
+        make_tree_cache_section(m_vertices)
+    };
+
+    if (!m_arguments.m_cache->store(key, TriangleTreeCacheFormat, sections, TriangleTreeCacheSectionCount))
+    {
+        RENDERER_LOG_WARNING(
+            "could not store triangle tree #" FMT_UNIQUE_ID " in cache directory %s.",
+            m_arguments.m_triangle_tree_uid,
+            m_arguments.m_cache->get_directory().c_str());
+    }
 }
 
 namespace
@@ -1166,8 +1688,10 @@ namespace
                     filter_key.m_materials,
                     texture_cache));
 
-            // Discard intersection filters that don't have any alpha masks.
-            if (!intersection_filter->has_alpha_masks())
+            // Discard intersection filters that don't have any alpha masks,
+            // or whose alpha masks are opaque over the whole object.
+            if (!intersection_filter->has_alpha_masks() ||
+                intersection_filter->accepts_all_triangles())
                 continue;
 
             RENDERER_LOG_DEBUG(
@@ -1177,7 +1701,7 @@ namespace
                 filter_key.m_materials.size(),
                 filter_key.m_materials.size() > 1 ? "s" : "",
                 pretty_size(intersection_filter->get_masks_memory_size()).c_str(),
-                pretty_size(intersection_filter->get_masks_memory_size()).c_str(),
+                pretty_size(intersection_filter->get_uv_memory_size()).c_str(),
                 filter_key_hash);
 
             // Store this intersection filter.
@@ -1244,6 +1768,22 @@ namespace
             }
         }
     }
+
+    void print_intersection_filters_statistics(const IntersectionFilterRepository& repository)
+    {
+        if (repository.empty())
+            return;
+
+        Statistics stats;
+        stats.insert<uint64>("filters", repository.size());
+
+        for (const_each<IntersectionFilterRepository> i = repository; i; ++i)
+            stats.merge(i->second->get_statistics());
+
+        RENDERER_LOG_DEBUG(
+            "%s",
+            StatisticsVector::make("intersection filters statistics", stats).to_string().c_str());
+    }
 }
 
 void TriangleTree::update_intersection_filters()
@@ -1280,10 +1820,17 @@ void TriangleTree::update_intersection_filters()
         object_instances_to_filter_keys,
         m_intersection_filters_repository,
         m_intersection_filters);
+
+    print_intersection_filters_statistics(m_intersection_filters_repository);
 }
 
 void TriangleTree::delete_intersection_filters()
 {
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    // Report how many filter calls were resolved without any alpha mask lookup.
+    print_intersection_filters_statistics(m_intersection_filters_repository);
+#endif
+
     for (const_each<IntersectionFilterRepository> i = m_intersection_filters_repository; i; ++i)
         delete i->second;
 
@@ -1359,20 +1906,126 @@ bool TriangleLeafVisitor::visit(
 #endif
     )
 {
+    // The ray is the ray of the shading point.
+    assert(&ray == &m_shading_point.m_ray);
+
+    intersect_leaf(
+        m_tree,
+        m_has_intersection_filters,
+        node,
+        m_shading_point,
+        m_hit
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , stats
+#endif
+        );
+
+    // Continue traversal.
+    distance = m_shading_point.m_ray.m_tmax;
+    return true;
+}
+
+void TriangleLeafVisitor::read_hit_triangle_data() const
+{
+    read_hit_triangle_data(m_tree, m_hit, m_shading_point);
+}
+
+void TriangleLeafVisitor::intersect_leaf(
+    const TriangleTree&                     tree,
+    const bool                              has_intersection_filters,
+    const TriangleTree::NodeType&           node,
+    ShadingPoint&                           shading_point,
+    Hit&                                    hit
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    const Ray3d& ray = shading_point.m_ray;
+
     // Retrieve the pointer to the data of this leaf.
     const uint8* user_data = &node.get_user_data<uint8>();
     const uint32 leaf_data_index = *reinterpret_cast<const uint32*>(user_data);
     const uint8* leaf_data =
         leaf_data_index == ~uint32(0)
             ? user_data + sizeof(uint32)                // triangles are stored in the leaf node
-            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+            : &tree.m_leaf_data[leaf_data_index];       // triangles are stored in the tree
     MemoryReader reader(leaf_data);
 
-    // Sequentially intersect all triangles of the leaf.
-    for (size_t triangle_index = node.get_item_index(),
-                triangle_count = node.get_item_count();
-                triangle_count--;
-                triangle_index++)
+    size_t triangle_index = node.get_item_index();
+    size_t triangle_count = node.get_item_count();
+
+    if (tree.m_simd_leaves)
+    {
+        // Intersect groups of static triangles, stored at the beginning of the leaf.
+        const size_t static_triangle_count = reader.read<uint32>();
+
+        for (size_t group_begin = 0; group_begin < static_triangle_count; group_begin += TriangleTreeGroupSize)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            // Check visibility flags.
+            const uint32* vis_flags = static_cast<const uint32*>(reader.read(TriangleTreeGroupSize * sizeof(uint32)));
+            size_t visible_mask = 0;
+            for (size_t i = 0; i < TriangleTreeGroupSize; ++i)
+            {
+                if (vis_flags[i] & shading_point.m_ray.m_flags)
+                    visible_mask |= size_t(1) << i;
+            }
+
+            if (visible_mask == 0)
+            {
+                reader += sizeof(GTriangleGroupType);
+                continue;
+            }
+
+            // Intersect all triangles of the group at once.
+            const GTriangleGroupType& group = reader.read<GTriangleGroupType>();
+            double t[TriangleTreeGroupSize], u[TriangleTreeGroupSize], v[TriangleTreeGroupSize];
+            size_t hit_mask = group.intersect(ray, t, u, v) & visible_mask;
+
+            // Accept the closest hit that passes intersection filters. Ties are broken in favor
+            // of the first triangle of the group, as when triangles are intersected one by one.
+            while (hit_mask != 0)
+            {
+                size_t closest = ~size_t(0);
+                for (size_t i = 0; i < TriangleTreeGroupSize; ++i)
+                {
+                    if ((hit_mask & (size_t(1) << i)) && (closest == ~size_t(0) || t[i] < t[closest]))
+                        closest = i;
+                }
+
+                hit_mask &= ~(size_t(1) << closest);
+
+                const size_t hit_triangle_index = triangle_index + group_begin + closest;
+
+                // Optionally filter intersections.
+                if (has_intersection_filters)
+                {
+                    const TriangleKey& triangle_key = tree.m_triangle_keys[hit_triangle_index];
+                    const IntersectionFilter* filter =
+                        tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                    if (filter && !filter->accept(triangle_key, u[closest], v[closest]))
+                        continue;
+                }
+
+                hit.m_interpolated_triangle = group.get(closest);
+                hit.m_triangle = &hit.m_interpolated_triangle;
+                hit.m_triangle_index = hit_triangle_index;
+                shading_point.m_ray.m_tmax = t[closest];
+                shading_point.m_bary[0] = static_cast<float>(u[closest]);
+                shading_point.m_bary[1] = static_cast<float>(v[closest]);
+                break;
+            }
+        }
+
+        // Moving triangles follow.
+        triangle_index += static_triangle_count;
+        triangle_count -= static_triangle_count;
+    }
+
+    // Sequentially intersect all (remaining) triangles of the leaf.
+    for (; triangle_count--; triangle_index++)
     {
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
@@ -1383,10 +2036,49 @@ bool TriangleLeafVisitor::visit(
         const uint32 motion_segment_count = reader.read<uint32>();
 
         // todo: get rid of this test by sorting triangles by their number of motion segments.
-        if (motion_segment_count == 0)
+        if (motion_segment_count == 0 && tree.m_compact_leaves)
+        {
+            // Check visibility flags.
+            if (!(vis_flags & shading_point.m_ray.m_flags))
+            {
+                reader += 3 * sizeof(uint32);
+                continue;
+            }
+
+            // Build the triangle from its shared vertices and convert it to the right format if necessary.
+            const uint32* vertex_indices = static_cast<const uint32*>(reader.read(3 * sizeof(uint32)));
+            const GTriangleType triangle(
+                tree.m_vertices[vertex_indices[0]],
+                tree.m_vertices[vertex_indices[1]],
+                tree.m_vertices[vertex_indices[2]]);
+            const TriangleReader triangle_reader(triangle);
+
+            // Intersect the triangle.
+            double t, u, v;
+            if (triangle_reader.m_triangle.intersect(ray, t, u, v))
+            {
+                // Optionally filter intersections.
+                if (has_intersection_filters)
+                {
+                    const TriangleKey& triangle_key = tree.m_triangle_keys[triangle_index];
+                    const IntersectionFilter* filter =
+                        tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                    if (filter && !filter->accept(triangle_key, u, v))
+                        continue;
+                }
+
+                hit.m_interpolated_triangle = triangle;
+                hit.m_triangle = &hit.m_interpolated_triangle;
+                hit.m_triangle_index = triangle_index;
+                shading_point.m_ray.m_tmax = t;
+                shading_point.m_bary[0] = static_cast<float>(u);
+                shading_point.m_bary[1] = static_cast<float>(v);
+            }
+        }
+        else if (motion_segment_count == 0)
         {
             // Check visibility flags.
-            if (!(vis_flags & m_shading_point.m_ray.m_flags))
+            if (!(vis_flags & shading_point.m_ray.m_flags))
             {
                 reader += sizeof(GTriangleType);
                 continue;
@@ -1401,20 +2093,20 @@ bool TriangleLeafVisitor::visit(
             if (triangle_reader.m_triangle.intersect(ray, t, u, v))
             {
                 // Optionally filter intersections.
-                if (m_has_intersection_filters)
+                if (has_intersection_filters)
                 {
-                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                    const TriangleKey& triangle_key = tree.m_triangle_keys[triangle_index];
                     const IntersectionFilter* filter =
-                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                        tree.m_intersection_filters[triangle_key.get_object_instance_index()];
                     if (filter && !filter->accept(triangle_key, u, v))
                         continue;
                 }
 
-                m_hit_triangle = &triangle;
-                m_hit_triangle_index = triangle_index;
-                m_shading_point.m_ray.m_tmax = t;
-                m_shading_point.m_bary[0] = static_cast<float>(u);
-                m_shading_point.m_bary[1] = static_cast<float>(v);
+                hit.m_triangle = &triangle;
+                hit.m_triangle_index = triangle_index;
+                shading_point.m_ray.m_tmax = t;
+                shading_point.m_bary[0] = static_cast<float>(u);
+                shading_point.m_bary[1] = static_cast<float>(v);
             }
         }
         else
@@ -1423,14 +2115,14 @@ bool TriangleLeafVisitor::visit(
             const size_t TriangleSize = 3 * sizeof(GVector3);
 
             // Check visibility flags.
-            if (!(vis_flags & m_shading_point.m_ray.m_flags))
+            if (!(vis_flags & shading_point.m_ray.m_flags))
             {
                 reader += (motion_segment_count + 1) * TriangleSize;
                 continue;
             }
 
             // Advance to the motion step immediately before the ray time.
-            const double base_time = m_shading_point.m_ray.m_time.m_normalized * motion_segment_count;
+            const double base_time = shading_point.m_ray.m_time.m_normalized * motion_segment_count;
             const size_t base_index = truncate<size_t>(base_time);
             reader += base_index * TriangleSize;
 
@@ -1456,45 +2148,44 @@ bool TriangleLeafVisitor::visit(
             if (reader.m_triangle.intersect(ray, t, u, v))
             {
                 // Optionally filter intersections.
-                if (m_has_intersection_filters)
+                if (has_intersection_filters)
                 {
-                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                    const TriangleKey& triangle_key = tree.m_triangle_keys[triangle_index];
                     const IntersectionFilter* filter =
-                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                        tree.m_intersection_filters[triangle_key.get_object_instance_index()];
                     if (filter && !filter->accept(triangle_key, u, v))
                         continue;
                 }
 
-                m_interpolated_triangle = triangle;
-                m_hit_triangle = &m_interpolated_triangle;
-                m_hit_triangle_index = triangle_index;
-                m_shading_point.m_ray.m_tmax = t;
-                m_shading_point.m_bary[0] = static_cast<float>(u);
-                m_shading_point.m_bary[1] = static_cast<float>(v);
+                hit.m_interpolated_triangle = triangle;
+                hit.m_triangle = &hit.m_interpolated_triangle;
+                hit.m_triangle_index = triangle_index;
+                shading_point.m_ray.m_tmax = t;
+                shading_point.m_bary[0] = static_cast<float>(u);
+                shading_point.m_bary[1] = static_cast<float>(v);
             }
         }
     }
-
-    // Continue traversal.
-    distance = m_shading_point.m_ray.m_tmax;
-    return true;
 }
 
-void TriangleLeafVisitor::read_hit_triangle_data() const
+void TriangleLeafVisitor::read_hit_triangle_data(
+    const TriangleTree&                     tree,
+    const Hit&                              hit,
+    ShadingPoint&                           shading_point)
 {
-    if (m_hit_triangle)
+    if (hit.m_triangle)
     {
         // Record a hit.
-        m_shading_point.m_primitive_type = ShadingPoint::PrimitiveTriangle;
+        shading_point.m_primitive_type = ShadingPoint::PrimitiveTriangle;
 
         // Copy the triangle key.
-        const TriangleKey& triangle_key = m_tree.m_triangle_keys[m_hit_triangle_index];
-        m_shading_point.m_object_instance_index = triangle_key.get_object_instance_index();
-        m_shading_point.m_primitive_index = triangle_key.get_triangle_index();
+        const TriangleKey& triangle_key = tree.m_triangle_keys[hit.m_triangle_index];
+        shading_point.m_object_instance_index = triangle_key.get_object_instance_index();
+        shading_point.m_primitive_index = triangle_key.get_triangle_index();
 
         // Compute and store the support plane of the hit triangle.
-        const TriangleReader reader(*m_hit_triangle);
-        m_shading_point.m_triangle_support_plane.initialize(reader.m_triangle);
+        const TriangleReader reader(*hit.m_triangle);
+        shading_point.m_triangle_support_plane.initialize(reader.m_triangle);
     }
 }
 
@@ -1512,6 +2203,37 @@ bool TriangleLeafProbeVisitor::visit(
     , bvh::TraversalStatistics&             stats
 #endif
     )
+{
+    if (intersect_leaf(
+            m_tree,
+            node,
+            ray,
+            m_ray_time,
+            m_ray_flags
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            ))
+    {
+        m_hit = true;
+        return false;
+    }
+
+    // Continue traversal.
+    distance = ray.m_tmax;
+    return true;
+}
+
+bool TriangleLeafProbeVisitor::intersect_leaf(
+    const TriangleTree&                     tree,
+    const TriangleTree::NodeType&           node,
+    const Ray3d&                            ray,
+    const double                            ray_time,
+    const VisibilityFlags::Type             ray_flags
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
 {
     // Retrieve the pointer to the data of this leaf.
     const uint8* user_data = &node.get_user_data<uint8>();
@@ -1519,11 +2241,47 @@ bool TriangleLeafProbeVisitor::visit(
     const uint8* leaf_data =
         leaf_data_index == ~uint32(0)
             ? user_data + sizeof(uint32)                // triangles are stored in the leaf node
-            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+            : &tree.m_leaf_data[leaf_data_index];       // triangles are stored in the tree
     MemoryReader reader(leaf_data);
 
-    // Sequentially intersect triangles until a hit is found.
-    for (size_t triangle_count = node.get_item_count(); triangle_count--; )
+    size_t triangle_count = node.get_item_count();
+
+    if (tree.m_simd_leaves)
+    {
+        // Intersect groups of static triangles, stored at the beginning of the leaf.
+        const size_t static_triangle_count = reader.read<uint32>();
+
+        for (size_t group_begin = 0; group_begin < static_triangle_count; group_begin += TriangleTreeGroupSize)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            // Check visibility flags.
+            const uint32* vis_flags = static_cast<const uint32*>(reader.read(TriangleTreeGroupSize * sizeof(uint32)));
+            size_t visible_mask = 0;
+            for (size_t i = 0; i < TriangleTreeGroupSize; ++i)
+            {
+                if (vis_flags[i] & ray_flags)
+                    visible_mask |= size_t(1) << i;
+            }
+
+            if (visible_mask == 0)
+            {
+                reader += sizeof(GTriangleGroupType);
+                continue;
+            }
+
+            // Intersect all triangles of the group at once.
+            const GTriangleGroupType& group = reader.read<GTriangleGroupType>();
+            if (group.intersect(ray) & visible_mask)
+                return true;
+        }
+
+        // Moving triangles follow.
+        triangle_count -= static_triangle_count;
+    }
+
+    // Sequentially intersect (remaining) triangles until a hit is found.
+    for (; triangle_count--; )
     {
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
@@ -1534,10 +2292,31 @@ bool TriangleLeafProbeVisitor::visit(
         const uint32 motion_segment_count = reader.read<uint32>();
 
         // todo: get rid of this test by sorting triangles by their number of motion segments.
-        if (motion_segment_count == 0)
+        if (motion_segment_count == 0 && tree.m_compact_leaves)
+        {
+            // Check visibility flags.
+            if (!(vis_flags & ray_flags))
+            {
+                reader += 3 * sizeof(uint32);
+                continue;
+            }
+
+            // Build the triangle from its shared vertices and convert it to the right format if necessary.
+            const uint32* vertex_indices = static_cast<const uint32*>(reader.read(3 * sizeof(uint32)));
+            const GTriangleType triangle(
+                tree.m_vertices[vertex_indices[0]],
+                tree.m_vertices[vertex_indices[1]],
+                tree.m_vertices[vertex_indices[2]]);
+            const TriangleReader triangle_reader(triangle);
+
+            // Intersect the triangle.
+            if (triangle_reader.m_triangle.intersect(ray))
+                return true;
+        }
+        else if (motion_segment_count == 0)
         {
             // Check visibility flags.
-            if (!(vis_flags & m_ray_flags))
+            if (!(vis_flags & ray_flags))
             {
                 reader += sizeof(GTriangleType);
                 continue;
@@ -1549,10 +2328,7 @@ bool TriangleLeafProbeVisitor::visit(
 
             // Intersect the triangle.
             if (triangle_reader.m_triangle.intersect(ray))
-            {
-                m_hit = true;
-                return false;
-            }
+                return true;
         }
         else
         {
@@ -1560,14 +2336,14 @@ bool TriangleLeafProbeVisitor::visit(
             const size_t TriangleSize = 3 * sizeof(GVector3);
 
             // Check visibility flags.
-            if (!(vis_flags & m_ray_flags))
+            if (!(vis_flags & ray_flags))
             {
                 reader += (motion_segment_count + 1) * TriangleSize;
                 continue;
             }
 
             // Advance to the motion step immediately before the ray time.
-            const double base_time = m_ray_time * motion_segment_count;
+            const double base_time = ray_time * motion_segment_count;
             const size_t base_index = truncate<size_t>(base_time);
             reader += base_index * TriangleSize;
 
@@ -1587,19 +2363,104 @@ bool TriangleLeafProbeVisitor::visit(
 
             // Intersect the triangle.
             if (triangle_reader.m_triangle.intersect(ray))
-            {
-                m_hit = true;
-                return false;
-            }
+                return true;
 
             // Skip the remaining motion steps of this triangle.
             reader += (motion_segment_count - base_index - 1) * TriangleSize;
         }
     }
 
-    // Continue traversal.
-    distance = ray.m_tmax;
-    return true;
+    return false;
+}
+
+
+//
+// TriangleLeafPacketVisitor class implementation.
+//
+
+uint32 TriangleLeafPacketVisitor::visit(
+    const TriangleTree::NodeType&           node,
+    const uint32                            ray_mask,
+    const Ray3d*                            rays,
+    const RayInfo3d*                        ray_infos,
+    double*                                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    for (size_t i = 0; i < RayPacketSize; ++i)
+    {
+        if (!(ray_mask & (1u << i)))
+            continue;
+
+        // Intersect the ray of the shading point, whose m_tmax member is the distance to the closest hit.
+        ShadingPoint& shading_point = *m_shading_points[i];
+        TriangleLeafVisitor::intersect_leaf(
+            m_tree,
+            m_has_intersection_filters,
+            node,
+            shading_point,
+            m_hits[i]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+
+        distances[i] = shading_point.m_ray.m_tmax;
+    }
+
+    // Continue traversal for all rays.
+    return ray_mask;
+}
+
+void TriangleLeafPacketVisitor::read_hit_triangle_data(const size_t ray_index) const
+{
+    assert(ray_index < RayPacketSize);
+
+    TriangleLeafVisitor::read_hit_triangle_data(
+        m_tree,
+        m_hits[ray_index],
+        *m_shading_points[ray_index]);
+}
+
+
+//
+// TriangleLeafProbePacketVisitor class implementation.
+//
+
+uint32 TriangleLeafProbePacketVisitor::visit(
+    const TriangleTree::NodeType&           node,
+    const uint32                            ray_mask,
+    const Ray3d*                            rays,
+    const RayInfo3d*                        ray_infos,
+    double*                                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    for (size_t i = 0; i < RayPacketSize; ++i)
+    {
+        if (!(ray_mask & (1u << i)))
+            continue;
+
+        if (TriangleLeafProbeVisitor::intersect_leaf(
+                m_tree,
+                node,
+                rays[i],
+                m_ray_times[i],
+                m_ray_flags[i]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                ))
+            m_hit_mask |= 1u << i;
+        else distances[i] = rays[i].m_tmax;
+    }
+
+    // Terminate traversal for the rays that hit a triangle.
+    return ray_mask & ~m_hit_mask;
 }
 
 }   // namespace renderer
@@ -55,6 +55,7 @@
 #include <vector>
 
 // Forward declarations.
+namespace foundation    { class DiskCache; }
 namespace foundation    { class Statistics; }
 namespace renderer      { class Assembly; }
 namespace renderer      { class IntersectionFilter; }
@@ -87,16 +88,19 @@ class TriangleTree
         const foundation::UniqueID              m_triangle_tree_uid;
         const GAABB3                            m_bbox;
         const Assembly&                         m_assembly;
+        std::shared_ptr<foundation::DiskCache>  m_cache;
 
         // Constructor.
         Arguments(
             const Scene&                        scene,
             const foundation::UniqueID          triangle_tree_uid,
             const GAABB3&                       bbox,
-            const Assembly&                     assembly);
+            const Assembly&                     assembly,
+            std::shared_ptr<foundation::DiskCache> cache = std::shared_ptr<foundation::DiskCache>());
     };
 
-    // Constructor, builds the tree for a given assembly.
+    // Constructor, builds the tree for a given assembly, or loads it
+    // from the cache of the arguments if it was built before.
     explicit TriangleTree(const Arguments& arguments);
 
     // Destructor.
@@ -115,18 +119,25 @@ class TriangleTree
   private:
     friend class TriangleLeafVisitor;
     friend class TriangleLeafProbeVisitor;
+    friend class TriangleLeafPacketVisitor;
+    friend class TriangleLeafProbePacketVisitor;
 
     const Arguments                             m_arguments;
 
     size_t                                      m_static_triangle_count;
     size_t                                      m_moving_triangle_count;
+    bool                                        m_simd_leaves;      // static triangles are stored in groups
+    bool                                        m_compact_leaves;   // static triangles reference shared vertices
 
     std::vector<TriangleKey>                    m_triangle_keys;
     std::vector<foundation::uint8>              m_leaf_data;
+    std::vector<GVector3>                       m_vertices;         // vertices shared by static triangles of compact leaves
 
     IntersectionFilterRepository                m_intersection_filters_repository;
     std::vector<const IntersectionFilter*>      m_intersection_filters;
 
+    void build(const ParamArray& params);
+
     void build_bvh(
         const ParamArray&                       params,
         const double                            time,
@@ -139,6 +150,15 @@ class TriangleTree
         const bool                              save_memory,
         foundation::Statistics&                 statistics);
 
+    void build_binned_bvh(
+        const ParamArray&                       params,
+        const double                            time,
+        const bool                              save_memory,
+        foundation::Statistics&                 statistics);
+
+    template <size_t Width>
+    void build_wide_nodes(foundation::Statistics& statistics);
+
     std::vector<GAABB3> compute_motion_bboxes(
         const std::vector<size_t>&              triangle_indices,
         const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
@@ -152,6 +172,10 @@ class TriangleTree
         const std::vector<TriangleKey>&         triangle_keys,
         foundation::Statistics&                 statistics);
 
+    foundation::uint64 compute_cache_key(const ParamArray& params) const;
+    bool load_from_cache(const foundation::uint64 key);
+    void save_to_cache(const foundation::uint64 key) const;
+
     void update_intersection_filters();
     void delete_intersection_filters();
 };
@@ -226,12 +250,40 @@ class TriangleLeafVisitor
     void read_hit_triangle_data() const;
 
   private:
+    friend class TriangleLeafPacketVisitor;
+
+    // Closest triangle hit found so far along a ray.
+    struct Hit
+    {
+        GTriangleType           m_interpolated_triangle;
+        const GTriangleType*    m_triangle;
+        size_t                  m_triangle_index;
+
+        Hit();
+    };
+
     const TriangleTree&     m_tree;
     const bool              m_has_intersection_filters;
     ShadingPoint&           m_shading_point;
-    GTriangleType           m_interpolated_triangle;
-    const GTriangleType*    m_hit_triangle;
-    size_t                  m_hit_triangle_index;
+    Hit                     m_hit;
+
+    // Intersect the triangles of a leaf with the ray of a shading point,
+    // keeping track of the closest hit.
+    static void intersect_leaf(
+        const TriangleTree&                     tree,
+        const bool                              has_intersection_filters,
+        const TriangleTree::NodeType&           node,
+        ShadingPoint&                           shading_point,
+        Hit&                                    hit
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    static void read_hit_triangle_data(
+        const TriangleTree&                     tree,
+        const Hit&                              hit,
+        ShadingPoint&                           shading_point);
 };
 
 
@@ -262,30 +314,180 @@ class TriangleLeafProbeVisitor
         );
 
   private:
+    friend class TriangleLeafProbePacketVisitor;
+
     const TriangleTree&         m_tree;
     const double                m_ray_time;
     const VisibilityFlags::Type m_ray_flags;
     const bool                  m_has_intersection_filters;
+
+    // Return whether the ray hits any of the triangles of a leaf.
+    static bool intersect_leaf(
+        const TriangleTree&                     tree,
+        const TriangleTree::NodeType&           node,
+        const foundation::Ray3d&                ray,
+        const double                            ray_time,
+        const VisibilityFlags::Type             ray_flags
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+};
+
+
+//
+// Triangle leaf visitor for packets of rays, used during tree intersection.
+//
+// The rays of the packet are the rays of the shading points passed to the constructor:
+// their m_tmax member is updated as closer hits are found.
+//
+
+class TriangleLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    TriangleLeafPacketVisitor(
+        const TriangleTree&                     tree,
+        ShadingPoint* const*                    shading_points);    // one per ray of the packet
+
+    // Visit a leaf.
+    foundation::uint32 visit(
+        const TriangleTree::NodeType&           node,
+        const foundation::uint32                ray_mask,
+        const foundation::Ray3d*                rays,
+        const foundation::RayInfo3d*            ray_infos,
+        double*                                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    // Read additional data about the triangle that was hit by a given ray, if any.
+    void read_hit_triangle_data(const size_t ray_index) const;
+
+  private:
+    const TriangleTree&                         m_tree;
+    const bool                                  m_has_intersection_filters;
+    ShadingPoint* const*                        m_shading_points;
+    TriangleLeafVisitor::Hit                    m_hits[RayPacketSize];
+};
+
+
+//
+// Triangle leaf visitor for packets of probe rays, only return boolean answers
+// (whether an intersection was found or not for each ray of the packet).
+//
+
+class TriangleLeafProbePacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    TriangleLeafProbePacketVisitor(
+        const TriangleTree&                     tree,
+        const double*                           ray_times,          // one per ray of the packet
+        const VisibilityFlags::Type*            ray_flags);         // one per ray of the packet
+
+    // Visit a leaf.
+    foundation::uint32 visit(
+        const TriangleTree::NodeType&           node,
+        const foundation::uint32                ray_mask,
+        const foundation::Ray3d*                rays,
+        const foundation::RayInfo3d*            ray_infos,
+        double*                                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    // Return the mask of the rays that hit a triangle.
+    foundation::uint32 get_hit_mask() const;
+
+  private:
+    const TriangleTree&                         m_tree;
+    const double*                               m_ray_times;
+    const VisibilityFlags::Type*                m_ray_flags;
+    foundation::uint32                          m_hit_mask;
 };
 
 
 //
 // Triangle tree intersectors.
 //
+// Trees without motion are traversed using their wide nodes, if they have any.
+//
 
-typedef foundation::bvh::Intersector<
+template <typename Visitor>
+class TriangleTreeIntersectorImpl
+  : public foundation::NonCopyable
+{
+  public:
+    void intersect_no_motion(
+        const TriangleTree&                     tree,
+        const foundation::Ray3d&                ray,
+        const foundation::RayInfo3d&            ray_info,
+        Visitor&                                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        ) const;
+
+    void intersect_motion(
+        const TriangleTree&                     tree,
+        const foundation::Ray3d&                ray,
+        const foundation::RayInfo3d&            ray_info,
+        const double                            ray_time,
+        Visitor&                                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        ) const;
+
+  private:
+    typedef foundation::bvh::Intersector<
+        TriangleTree,
+        Visitor,
+        foundation::Ray3d,      // make sure we pick the SSE2-optimized version of foundation::bvh::Intersector
+        TriangleTreeStackSize
+    > BinaryIntersector;
+
+    typedef foundation::bvh::WideIntersector<
+        TriangleTree,
+        Visitor,
+        foundation::Ray3d,
+        4,
+        TriangleTreeStackSize
+    > Wide4Intersector;
+
+    typedef foundation::bvh::WideIntersector<
+        TriangleTree,
+        Visitor,
+        foundation::Ray3d,
+        8,
+        TriangleTreeStackSize
+    > Wide8Intersector;
+};
+
+typedef TriangleTreeIntersectorImpl<TriangleLeafVisitor> TriangleTreeIntersector;
+typedef TriangleTreeIntersectorImpl<TriangleLeafProbeVisitor> TriangleTreeProbeIntersector;
+
+// Packets of rays are always traversed using binary nodes.
+typedef foundation::bvh::PacketIntersector<
     TriangleTree,
-    TriangleLeafVisitor,
-    foundation::Ray3d,          // make sure we pick the SSE2-optimized version of foundation::bvh::Intersector
+    TriangleLeafPacketVisitor,
+    foundation::Ray3d,
+    RayPacketSize,
     TriangleTreeStackSize
-> TriangleTreeIntersector;
+> TriangleTreePacketIntersector;
 
-typedef foundation::bvh::Intersector<
+typedef foundation::bvh::PacketIntersector<
     TriangleTree,
-    TriangleLeafProbeVisitor,
-    foundation::Ray3d,          // make sure we pick the SSE2-optimized version of foundation::bvh::Intersector
+    TriangleLeafProbePacketVisitor,
+    foundation::Ray3d,
+    RayPacketSize,
     TriangleTreeStackSize
-> TriangleTreeProbeIntersector;
+> TriangleTreeProbePacketIntersector;
 
 
 //
@@ -307,13 +509,17 @@ inline size_t TriangleTree::get_moving_triangle_count() const
 // TriangleLeafVisitor class implementation.
 //
 
+inline TriangleLeafVisitor::Hit::Hit()
+  : m_triangle(nullptr)
+{
+}
+
 inline TriangleLeafVisitor::TriangleLeafVisitor(
     const TriangleTree&         tree,
     ShadingPoint&               shading_point)
   : m_tree(tree)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
   , m_shading_point(shading_point)
-  , m_hit_triangle(nullptr)
 {
 }
 
@@ -333,4 +539,119 @@ inline TriangleLeafProbeVisitor::TriangleLeafProbeVisitor(
 {
 }
 
+
+//
+// TriangleLeafPacketVisitor class implementation.
+//
+
+inline TriangleLeafPacketVisitor::TriangleLeafPacketVisitor(
+    const TriangleTree&         tree,
+    ShadingPoint* const*        shading_points)
+  : m_tree(tree)
+  , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_shading_points(shading_points)
+{
+}
+
+
+//
+// TriangleLeafProbePacketVisitor class implementation.
+//
+
+inline TriangleLeafProbePacketVisitor::TriangleLeafProbePacketVisitor(
+    const TriangleTree&             tree,
+    const double*                   ray_times,
+    const VisibilityFlags::Type*    ray_flags)
+  : m_tree(tree)
+  , m_ray_times(ray_times)
+  , m_ray_flags(ray_flags)
+  , m_hit_mask(0)
+{
+}
+
+inline foundation::uint32 TriangleLeafProbePacketVisitor::get_hit_mask() const
+{
+    return m_hit_mask;
+}
+
+
+//
+// TriangleTreeIntersectorImpl class implementation.
+//
+
+template <typename Visitor>
+inline void TriangleTreeIntersectorImpl<Visitor>::intersect_no_motion(
+    const TriangleTree&                         tree,
+    const foundation::Ray3d&                    ray,
+    const foundation::RayInfo3d&                ray_info,
+    Visitor&                                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    ) const
+{
+    switch (tree.get_node_width())
+    {
+      case 4:
+        Wide4Intersector().intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+        break;
+
+      case 8:
+        Wide8Intersector().intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+        break;
+
+      default:
+        BinaryIntersector().intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+        break;
+    }
+}
+
+template <typename Visitor>
+inline void TriangleTreeIntersectorImpl<Visitor>::intersect_motion(
+    const TriangleTree&                         tree,
+    const foundation::Ray3d&                    ray,
+    const foundation::RayInfo3d&                ray_info,
+    const double                                ray_time,
+    Visitor&                                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    ) const
+{
+    BinaryIntersector().intersect_motion(
+        tree,
+        ray,
+        ray_info,
+        ray_time,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , stats
+#endif
+        );
+}
+
 }   // namespace renderer
@@ -39,8 +39,12 @@
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/scene/scene.h"
 
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+
 // Standard headers.
 #include <cassert>
+#include <cmath>
 #include <string>
 
 using namespace foundation;
@@ -79,6 +83,26 @@ Dictionary BackwardLightSampler::get_params_metadata()
                             .insert("label", "Light Tree")
                             .insert("help", "Lights organized in a BVH"))));
 
+    metadata.insert(
+        "lighttree_split_threshold",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.0")
+            .insert("min", "0.0")
+            .insert("max", "1.0")
+            .insert("label", "Light Tree Split Threshold")
+            .insert("help", "Draw several light samples where the importance of light tree nodes is uncertain; 0 disables splitting"));
+
+    metadata.insert(
+        "lighttree_max_split_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "8")
+            .insert("min", "1")
+            .insert("max", "16")
+            .insert("label", "Light Tree Max Split Count")
+            .insert("help", "Maximum number of light samples drawn by light tree splitting"));
+
     metadata.merge(LightSamplerBase::get_params_metadata());
 
     return metadata;
@@ -167,7 +191,12 @@ BackwardLightSampler::BackwardLightSampler(
     if (m_use_light_tree)
     {
         // Initialize the LightTree only after the lights are collected.
-        m_light_tree.reset(new LightTree(m_light_tree_lights, m_emitting_shapes));
+        m_light_tree.reset(
+            new LightTree(
+                m_light_tree_lights,
+                m_emitting_shapes,
+                params.get_optional<float>("lighttree_split_threshold", 0.0f),
+                params.get_optional<size_t>("lighttree_max_split_count", 8)));
 
         // Build the light tree.
         const vector<size_t> tri_index_to_node_index = m_light_tree->build();
@@ -198,20 +227,21 @@ BackwardLightSampler::BackwardLightSampler(
         plural(m_emitting_shapes.size(), "shape").c_str());
 }
 
-void BackwardLightSampler::sample_lightset(
+size_t BackwardLightSampler::sample_lightset(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
     const ShadingPoint&                 shading_point,
-    LightSample&                        light_sample) const
+    LightSample                         light_samples[]) const
 {
     if (m_use_light_tree)
     {
         // Light tree sampling.
-        sample_light_tree(
-            time,
-            s,
-            shading_point,
-            light_sample);
+        return
+            sample_light_tree(
+                time,
+                s,
+                shading_point,
+                light_samples);
     }
     else
     {
@@ -219,7 +249,8 @@ void BackwardLightSampler::sample_lightset(
         sample_emitting_shapes(
             time,
             s,
-            light_sample);
+            light_samples[0]);
+        return 1;
     }
 }
 
@@ -245,7 +276,7 @@ float BackwardLightSampler::evaluate_pdf(
         m_use_light_tree
             ? m_light_tree->evaluate_node_pdf(
                 surface_shading_point,
-                shape->m_light_tree_node_index)
+                shape->m_light_tree_node_index) * shape->get_rcp_area()
             : shape->evaluate_pdf_uniform();
 
     assert(shape_probability >= 0.0f);
@@ -253,49 +284,65 @@ float BackwardLightSampler::evaluate_pdf(
     return shape_probability;
 }
 
-void BackwardLightSampler::sample_light_tree(
+size_t BackwardLightSampler::sample_light_tree(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
     const ShadingPoint&                 shading_point,
-    LightSample&                        light_sample) const
+    LightSample                         light_samples[]) const
 {
     assert(has_lightset());
 
-    LightType light_type;
-    size_t light_index;
-    float light_prob;
-    m_light_tree->sample(
-        shading_point,
-        s[0],
-        light_type,
-        light_index,
-        light_prob);
-
-    if (light_type == NonPhysicalLightType)
-    {
-        // Fetch the light.
-        const NonPhysicalLightInfo& light_info = m_light_tree_lights[light_index];
-        light_sample.m_light = light_info.m_light;
-
-        // Evaluate and store the transform of the light.
-        light_sample.m_light_transform =
-              light_info.m_light->get_transform()
-            * light_info.m_transform_sequence.evaluate(time.m_absolute);
+    LightTree::Sample tree_samples[LightTree::MaxSplitCount];
+    const size_t sample_count =
+        m_light_tree->sample(
+            shading_point,
+            s[0],
+            tree_samples);
 
-        // Store the probability density of this light.
-        light_sample.m_probability = light_prob;
-    }
-    else
+    for (size_t i = 0; i < sample_count; ++i)
     {
-        assert(light_type == EmittingShapeType);
-        sample_emitting_shapes(
-            time,
-            s,
-            light_sample);
+        const LightTree::Sample& tree_sample = tree_samples[i];
+        LightSample& light_sample = light_samples[i];
+
+        if (tree_sample.m_light_type == NonPhysicalLightType)
+        {
+            // Fetch the light.
+            const NonPhysicalLightInfo& light_info = m_light_tree_lights[tree_sample.m_light_index];
+            light_sample.m_shape = nullptr;
+            light_sample.m_light = light_info.m_light;
+
+            // Evaluate and store the transform of the light.
+            light_sample.m_light_transform =
+                  light_info.m_light->get_transform()
+                * light_info.m_transform_sequence.evaluate(time.m_absolute);
+
+            // Store the probability density of this light.
+            light_sample.m_probability = tree_sample.m_probability;
+        }
+        else
+        {
+            assert(tree_sample.m_light_type == EmittingShapeType);
+
+            // Decorrelate the positions sampled on the shapes chosen by a split traversal.
+            const float GoldenRatioConjugate = 0.6180339887f;
+            Vector2f shape_s(s[1], s[2]);
+            shape_s += Vector2f(static_cast<float>(i) * GoldenRatioConjugate);
+            shape_s[0] -= floor(shape_s[0]);
+            shape_s[1] -= floor(shape_s[1]);
+
+            // Uniformly sample the surface of the shape chosen by the light tree.
+            light_sample.m_light = nullptr;
+            m_emitting_shapes[tree_sample.m_light_index].sample_uniform(
+                shape_s,
+                tree_sample.m_probability,
+                light_sample);
+        }
+
+        assert(light_sample.m_light || light_sample.m_shape);
+        assert(light_sample.m_probability > 0.0f);
     }
 
-    assert(light_sample.m_light || light_sample.m_shape);
-    assert(light_sample.m_probability > 0.0f);
+    return sample_count;
 }
 
 }   // namespace renderer
@@ -61,6 +61,9 @@ class BackwardLightSampler
   : public LightSamplerBase
 {
   public:
+    // Maximum number of light samples returned by a single call to sample_lightset().
+    enum { MaxLightSetSampleCount = LightTree::MaxSplitCount };
+
     // Return parameters metadata.
     static foundation::Dictionary get_params_metadata();
 
@@ -78,12 +81,15 @@ class BackwardLightSampler
     // Return true if the light set is not empty.
     bool has_lightset() const;
 
-    // Sample the light set.
-    void sample_lightset(
+    // Sample the light set. More than one light sample may be returned when light
+    // tree splitting is enabled, in which case the contributions of all samples must
+    // be summed. Return the number of samples written to `light_samples`, which must
+    // have room for MaxLightSetSampleCount entries.
+    size_t sample_lightset(
         const ShadingRay::Time&             time,
         const foundation::Vector3f&         s,
         const ShadingPoint&                 shading_point,
-        LightSample&                        light_sample) const;
+        LightSample                         light_samples[]) const;
 
     // Compute the probability density in area measure of a given light sample.
     // Shading points are located on the light (emitting shape) hit by the
@@ -97,11 +103,11 @@ class BackwardLightSampler
     NonPhysicalLightVector                  m_light_tree_lights;
     std::unique_ptr<LightTree>              m_light_tree;
 
-    void sample_light_tree(
+    size_t sample_light_tree(
         const ShadingRay::Time&             time,
         const foundation::Vector3f&         s,
         const ShadingPoint&                 shading_point,
-        LightSample&                        light_sample) const;
+        LightSample                         light_samples[]) const;
 };
 
 
@@ -31,6 +31,7 @@
 #include "directlightingintegrator.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/lighting/backwardlightsampler.h"
 #include "renderer/kernel/lighting/lightpathstream.h"
 #include "renderer/kernel/lighting/tracer.h"
@@ -66,13 +67,40 @@ namespace renderer
 //       take_single_material_sample
 //
 //   compute_outgoing_radiance_light_sampling_low_variance
-//       add_emitting_shape_sample_contribution
-//       add_non_physical_light_sample_contribution
+//       prepare_emitting_shape_sample
+//       prepare_non_physical_light_sample
+//       add_pending_light_sample_contributions
+//           finish_emitting_shape_sample
+//           finish_non_physical_light_sample
 //
 //   compute_outgoing_radiance_combined_sampling_low_variance
 //       compute_outgoing_radiance_material_sampling
 //       compute_outgoing_radiance_light_sampling_low_variance
 //
+//   add_emitting_shape_sample_contribution (used by the volume lighting integrator)
+//       prepare_emitting_shape_sample
+//       finish_emitting_shape_sample
+//
+//   add_non_physical_light_sample_contribution (used by the volume lighting integrator)
+//       prepare_non_physical_light_sample
+//       finish_non_physical_light_sample
+//
+
+struct DirectLightingIntegrator::PendingLightSample
+{
+    LightSample     m_sample;
+    Vector3d        m_target;                       // world space target of the shadow ray
+    Vector3d        m_incoming;                     // world space incoming direction, unit-length
+
+    // Emitting shape samples only.
+    double          m_cos_on;
+    double          m_rcp_sample_square_distance;
+    float           m_contribution_prob;
+
+    // Non-physical light samples only.
+    Spectrum        m_light_value;
+    float           m_light_probability;
+};
 
 DirectLightingIntegrator::DirectLightingIntegrator(
     const ShadingContext&           shading_context,
@@ -138,6 +166,10 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
     if (!m_material_sampler.contributes_to_light_sampling())
         return;
 
+    // Shadow rays are traced in packets of light samples.
+    PendingLightSample pending_samples[RayPacketSize];
+    size_t pending_sample_count = 0;
+
     if (m_light_sample_count > 0)
     {
         // Add contributions from all non-physical light sources that aren't part of the lightset.
@@ -147,14 +179,32 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
             LightSample sample;
             m_light_sampler.sample_non_physical_light(m_time, i, sample);
 
-            // Add the contribution of the chosen light.
-            add_non_physical_light_sample_contribution(
-                sampling_context,
-                sample,
-                outgoing,
-                radiance,
-                light_path_stream);
+            // Queue the contribution of the chosen light.
+            if (prepare_non_physical_light_sample(
+                    sampling_context,
+                    sample,
+                    pending_samples[pending_sample_count]) &&
+                ++pending_sample_count == RayPacketSize)
+            {
+                add_pending_light_sample_contributions(
+                    pending_samples,
+                    pending_sample_count,
+                    mis_heuristic,
+                    outgoing,
+                    radiance,
+                    light_path_stream);
+                pending_sample_count = 0;
+            }
         }
+
+        add_pending_light_sample_contributions(
+            pending_samples,
+            pending_sample_count,
+            mis_heuristic,
+            outgoing,
+            radiance,
+            light_path_stream);
+        pending_sample_count = 0;
     }
 
     // Add contributions from the light set.
@@ -167,35 +217,52 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
         for (size_t i = 0, e = m_light_sample_count; i < e; ++i)
         {
             // Sample the light set.
-            LightSample sample;
-            m_light_sampler.sample_lightset(
-                m_time,
-                sampling_context.next2<Vector3f>(),
-                m_material_sampler.get_shading_point(),
-                sample);
-
-            // Add the contribution of the chosen light.
-            if (sample.m_shape)
-            {
-                add_emitting_shape_sample_contribution(
-                    sampling_context,
-                    sample,
-                    mis_heuristic,
-                    outgoing,
-                    lightset_radiance,
-                    light_path_stream);
-            }
-            else
+            LightSample samples[BackwardLightSampler::MaxLightSetSampleCount];
+            const size_t sample_count =
+                m_light_sampler.sample_lightset(
+                    m_time,
+                    sampling_context.next2<Vector3f>(),
+                    m_material_sampler.get_shading_point(),
+                    samples);
+
+            for (size_t j = 0; j < sample_count; ++j)
             {
-                add_non_physical_light_sample_contribution(
-                    sampling_context,
-                    sample,
-                    outgoing,
-                    lightset_radiance,
-                    light_path_stream);
+                const LightSample& sample = samples[j];
+
+                // Queue the contribution of the chosen light.
+                const bool contributes =
+                    sample.m_shape
+                        ? prepare_emitting_shape_sample(
+                              sampling_context,
+                              sample,
+                              pending_samples[pending_sample_count])
+                        : prepare_non_physical_light_sample(
+                              sampling_context,
+                              sample,
+                              pending_samples[pending_sample_count]);
+
+                if (contributes && ++pending_sample_count == RayPacketSize)
+                {
+                    add_pending_light_sample_contributions(
+                        pending_samples,
+                        pending_sample_count,
+                        mis_heuristic,
+                        outgoing,
+                        lightset_radiance,
+                        light_path_stream);
+                    pending_sample_count = 0;
+                }
             }
         }
 
+        add_pending_light_sample_contributions(
+            pending_samples,
+            pending_sample_count,
+            mis_heuristic,
+            outgoing,
+            lightset_radiance,
+            light_path_stream);
+
         if (m_light_sample_count > 1)
             lightset_radiance /= static_cast<float>(m_light_sample_count);
 
@@ -342,6 +409,57 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     const Dual3d&                   outgoing,
     DirectShadingComponents&        radiance,
     LightPathStream*                light_path_stream) const
+{
+    PendingLightSample pending_sample;
+    if (!prepare_emitting_shape_sample(sampling_context, sample, pending_sample))
+        return;
+
+    // Compute the transmission factor between the light sample and the shading point.
+    Spectrum transmission;
+    m_material_sampler.trace_between(
+        m_shading_context,
+        pending_sample.m_target,
+        transmission);
+
+    finish_emitting_shape_sample(
+        pending_sample,
+        transmission,
+        mis_heuristic,
+        outgoing,
+        radiance,
+        light_path_stream);
+}
+
+void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
+    SamplingContext&                sampling_context,
+    const LightSample&              sample,
+    const Dual3d&                   outgoing,
+    DirectShadingComponents&        radiance,
+    LightPathStream*                light_path_stream) const
+{
+    PendingLightSample pending_sample;
+    if (!prepare_non_physical_light_sample(sampling_context, sample, pending_sample))
+        return;
+
+    // Compute the transmission factor between the light sample and the shading point.
+    Spectrum transmission;
+    m_material_sampler.trace_between(
+        m_shading_context,
+        pending_sample.m_target,
+        transmission);
+
+    finish_non_physical_light_sample(
+        pending_sample,
+        transmission,
+        outgoing,
+        radiance,
+        light_path_stream);
+}
+
+bool DirectLightingIntegrator::prepare_emitting_shape_sample(
+    SamplingContext&                sampling_context,
+    const LightSample&              sample,
+    PendingLightSample&             pending_sample) const
 {
     const Material* material = sample.m_shape->get_material();
     const Material::RenderData& material_data = material->get_render_data();
@@ -349,7 +467,7 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
 
     // No contribution if we are computing indirect lighting but this light does not cast indirect light.
     if (m_indirect && !(edf->get_flags() & EDF::CastIndirectLight))
-        return;
+        return false;
 
     // Compute the incoming direction in world space.
     Vector3d incoming = sample.m_point - m_material_sampler.get_point();
@@ -357,14 +475,14 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     // No contribution if the shading point is behind the light.
     double cos_on = dot(-incoming, sample.m_shading_normal);
     if (cos_on <= 0.0)
-        return;
+        return false;
 
     // Compute the square distance between the light sample and the shading point.
     const double square_distance = square_norm(incoming);
 
     // Don't use this sample if we're closer than the light near start value.
     if (square_distance < square(edf->get_light_near_start()))
-        return;
+        return false;
 
     const double rcp_sample_square_distance = 1.0 / square_distance;
     const double rcp_sample_distance = sqrt(rcp_sample_square_distance);
@@ -396,16 +514,70 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
 
             // Russian Roulette.
             if (!pass_rr(contribution_prob, s))
-                return;
+                return false;
         }
     }
 
-    // Compute the transmission factor between the light sample and the shading point.
-    Spectrum transmission;
-    m_material_sampler.trace_between(
+    pending_sample.m_sample = sample;
+    pending_sample.m_target = sample.m_point;
+    pending_sample.m_incoming = incoming;
+    pending_sample.m_cos_on = cos_on;
+    pending_sample.m_rcp_sample_square_distance = rcp_sample_square_distance;
+    pending_sample.m_contribution_prob = contribution_prob;
+
+    return true;
+}
+
+bool DirectLightingIntegrator::prepare_non_physical_light_sample(
+    SamplingContext&                sampling_context,
+    const LightSample&              sample,
+    PendingLightSample&             pending_sample) const
+{
+    const Light* light = sample.m_light;
+
+    // No contribution if we are computing indirect lighting but this light does not cast indirect light.
+    if (m_indirect && !(light->get_flags() & Light::CastIndirectLight))
+        return false;
+
+    // Generate a uniform sample in [0,1)^2.
+    SamplingContext child_sampling_context = sampling_context.split(2, 1);
+    const Vector2d s = child_sampling_context.next2<Vector2d>();
+
+    // Evaluate the light.
+    Vector3d emission_position, emission_direction;
+    Spectrum light_value(Spectrum::Illuminance);
+    float probability;
+    light->sample(
         m_shading_context,
-        sample.m_point,
-        transmission);
+        sample.m_light_transform,
+        m_material_sampler.get_point(),
+        s,
+        emission_position,
+        emission_direction,
+        light_value,
+        probability);
+
+    pending_sample.m_sample = sample;
+    pending_sample.m_target = emission_position;
+    pending_sample.m_incoming = -emission_direction;
+    pending_sample.m_light_value = light_value;
+    pending_sample.m_light_probability = probability;
+
+    return true;
+}
+
+void DirectLightingIntegrator::finish_emitting_shape_sample(
+    const PendingLightSample&       pending_sample,
+    const Spectrum&                 transmission,
+    const MISHeuristic              mis_heuristic,
+    const Dual3d&                   outgoing,
+    DirectShadingComponents&        radiance,
+    LightPathStream*                light_path_stream) const
+{
+    const LightSample& sample = pending_sample.m_sample;
+    const Material* material = sample.m_shape->get_material();
+    const Material::RenderData& material_data = material->get_render_data();
+    const EDF* edf = material_data.m_edf;
 
     // Discard occluded samples.
     if (is_zero(transmission))
@@ -416,7 +588,7 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     const float material_probability =
         m_material_sampler.evaluate(
             Vector3f(outgoing.get_value()),
-            Vector3f(incoming),
+            Vector3f(pending_sample.m_incoming),
             m_light_sampling_modes,
             material_value);
     assert(material_probability >= 0.0f);
@@ -443,10 +615,10 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
         edf->evaluate_inputs(m_shading_context, light_shading_point),
         Vector3f(sample.m_geometric_normal),
         Basis3f(Vector3f(sample.m_shading_normal)),
-        -Vector3f(incoming),
+        -Vector3f(pending_sample.m_incoming),
         edf_value);
 
-    const float g = static_cast<float>(cos_on * rcp_sample_square_distance);
+    const float g = static_cast<float>(pending_sample.m_cos_on * pending_sample.m_rcp_sample_square_distance);
 
     // Apply MIS weighting.
     const float mis_weight =
@@ -457,7 +629,7 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
 
     // Add the contribution of this sample to the illumination.
     edf_value *= transmission;
-    edf_value *= (mis_weight * g) / (sample.m_probability * contribution_prob);
+    edf_value *= (mis_weight * g) / (sample.m_probability * pending_sample.m_contribution_prob);
     madd(radiance, material_value, edf_value);
 
     // Record light path event.
@@ -471,47 +643,16 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     }
 }
 
-void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
-    SamplingContext&                sampling_context,
-    const LightSample&              sample,
+void DirectLightingIntegrator::finish_non_physical_light_sample(
+    const PendingLightSample&       pending_sample,
+    const Spectrum&                 transmission,
     const Dual3d&                   outgoing,
     DirectShadingComponents&        radiance,
     LightPathStream*                light_path_stream) const
 {
+    const LightSample& sample = pending_sample.m_sample;
     const Light* light = sample.m_light;
 
-    // No contribution if we are computing indirect lighting but this light does not cast indirect light.
-    if (m_indirect && !(light->get_flags() & Light::CastIndirectLight))
-        return;
-
-    // Generate a uniform sample in [0,1)^2.
-    SamplingContext child_sampling_context = sampling_context.split(2, 1);
-    const Vector2d s = child_sampling_context.next2<Vector2d>();
-
-    // Evaluate the light.
-    Vector3d emission_position, emission_direction;
-    Spectrum light_value(Spectrum::Illuminance);
-    float probability;
-    light->sample(
-        m_shading_context,
-        sample.m_light_transform,
-        m_material_sampler.get_point(),
-        s,
-        emission_position,
-        emission_direction,
-        light_value,
-        probability);
-
-    // Compute the incoming direction in world space.
-    const Vector3d incoming = -emission_direction;
-
-    // Compute the transmission factor between the light sample and the shading point.
-    Spectrum transmission;
-    m_material_sampler.trace_between(
-        m_shading_context,
-        emission_position,
-        transmission);
-
     // Discard occluded samples.
     if (is_zero(transmission))
         return;
@@ -521,7 +662,7 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
     const float material_probability =
         m_material_sampler.evaluate(
             Vector3f(outgoing.get_value()),
-            Vector3f(incoming),
+            Vector3f(pending_sample.m_incoming),
             m_light_sampling_modes,
             material_value);
     assert(material_probability >= 0.0f);
@@ -530,9 +671,10 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
 
     // Add the contribution of this sample to the illumination.
     const float attenuation = light->compute_distance_attenuation(
-        m_material_sampler.get_point(), emission_position);
+        m_material_sampler.get_point(), pending_sample.m_target);
+    Spectrum light_value = pending_sample.m_light_value;
     light_value *= transmission;
-    light_value *= attenuation / (sample.m_probability * probability);
+    light_value *= attenuation / (sample.m_probability * pending_sample.m_light_probability);
     madd(radiance, material_value, light_value);
 
     // Record light path event.
@@ -540,10 +682,60 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
     {
         light_path_stream->sampled_non_physical_light(
             *light,
-            emission_position,
+            pending_sample.m_target,
             material_value.m_beauty,
             light_value);
     }
 }
 
+void DirectLightingIntegrator::add_pending_light_sample_contributions(
+    const PendingLightSample*       pending_samples,
+    const size_t                    pending_sample_count,
+    const MISHeuristic              mis_heuristic,
+    const Dual3d&                   outgoing,
+    DirectShadingComponents&        radiance,
+    LightPathStream*                light_path_stream) const
+{
+    assert(pending_sample_count <= RayPacketSize);
+
+    if (pending_sample_count == 0)
+        return;
+
+    // Compute the transmission factors between the light samples and the shading point.
+    Vector3d targets[RayPacketSize];
+    for (size_t i = 0; i < pending_sample_count; ++i)
+        targets[i] = pending_samples[i].m_target;
+
+    Spectrum transmissions[RayPacketSize];
+    m_material_sampler.trace_between(
+        m_shading_context,
+        targets,
+        pending_sample_count,
+        transmissions);
+
+    // Add the contributions of the light samples, in the order they were taken.
+    for (size_t i = 0; i < pending_sample_count; ++i)
+    {
+        if (pending_samples[i].m_sample.m_shape)
+        {
+            finish_emitting_shape_sample(
+                pending_samples[i],
+                transmissions[i],
+                mis_heuristic,
+                outgoing,
+                radiance,
+                light_path_stream);
+        }
+        else
+        {
+            finish_non_physical_light_sample(
+                pending_samples[i],
+                transmissions[i],
+                outgoing,
+                radiance,
+                light_path_stream);
+        }
+    }
+}
+
 }   // namespace renderer
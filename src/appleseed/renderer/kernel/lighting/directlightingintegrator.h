@@ -66,6 +66,7 @@ namespace renderer
 //
 //   The number of shadow rays cast by these functions may be as high as the number of light
 //   samples passed to the constructor plus the number of non-physical lights in the scene.
+//   Since all these shadow rays leave the same point, they are traced in packets.
 //
 
 class DirectLightingIntegrator
@@ -118,6 +119,9 @@ class DirectLightingIntegrator
     const size_t                        m_light_sample_count;
     const bool                          m_indirect;
 
+    // A light sample waiting for its shadow ray to be traced.
+    struct PendingLightSample;
+
     void take_single_material_sample(
         SamplingContext&                sampling_context,
         const foundation::MISHeuristic  mis_heuristic,
@@ -138,6 +142,39 @@ class DirectLightingIntegrator
         const foundation::Dual3d&       outgoing,
         DirectShadingComponents&        radiance,
         LightPathStream*                light_path_stream) const;
+
+    // Return false if the sample does not contribute, without tracing a shadow ray.
+    bool prepare_emitting_shape_sample(
+        SamplingContext&                sampling_context,
+        const LightSample&              sample,
+        PendingLightSample&             pending_sample) const;
+    bool prepare_non_physical_light_sample(
+        SamplingContext&                sampling_context,
+        const LightSample&              sample,
+        PendingLightSample&             pending_sample) const;
+
+    void finish_emitting_shape_sample(
+        const PendingLightSample&       pending_sample,
+        const Spectrum&                 transmission,
+        const foundation::MISHeuristic  mis_heuristic,
+        const foundation::Dual3d&       outgoing,
+        DirectShadingComponents&        radiance,
+        LightPathStream*                light_path_stream) const;
+    void finish_non_physical_light_sample(
+        const PendingLightSample&       pending_sample,
+        const Spectrum&                 transmission,
+        const foundation::Dual3d&       outgoing,
+        DirectShadingComponents&        radiance,
+        LightPathStream*                light_path_stream) const;
+
+    // Trace the shadow rays of a batch of light samples and add their contributions.
+    void add_pending_light_sample_contributions(
+        const PendingLightSample*       pending_samples,
+        const size_t                    pending_sample_count,
+        const foundation::MISHeuristic  mis_heuristic,
+        const foundation::Dual3d&       outgoing,
+        DirectShadingComponents&        radiance,
+        LightPathStream*                light_path_stream) const;
 };
 
 }   // namespace renderer
@@ -0,0 +1,215 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "guidedpath.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/pathvertex.h"
+#include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/sdtree.h"
+#include "renderer/kernel/shading/directshadingcomponents.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/bsdfsample.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/basis.h"
+#include "foundation/math/dual.h"
+
+// Standard headers.
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// GuidedPath class implementation.
+//
+
+GuidedPath::GuidedPath(
+    STree&                          tree,
+    const float                     bsdf_sampling_fraction)
+  : m_tree(tree)
+  , m_bsdf_sampling_fraction(bsdf_sampling_fraction)
+  , m_is_training(tree.is_training())
+  , m_vertex_count(0)
+  , m_guided_bounce_count(0)
+{
+}
+
+void GuidedPath::begin_path()
+{
+    m_is_training = m_tree.is_training();
+    m_vertex_count = 0;
+}
+
+bool GuidedPath::guide_sample(
+    SamplingContext&                sampling_context,
+    const PathVertex&               vertex,
+    const bool                      adjoint,
+    BSDFSample&                     sample,
+    float&                          bsdf_prob)
+{
+    if (!m_tree.is_built())
+        return false;
+
+    // Purely specular BSDFs can't be guided.
+    const BSDF& bsdf = *vertex.m_bsdf;
+    const int guided_modes =
+        vertex.m_scattering_modes &
+        bsdf.get_modes() &
+        (ScatteringMode::Diffuse | ScatteringMode::Glossy);
+    if (guided_modes == 0)
+        return false;
+
+    const Vector3f point(vertex.get_point());
+    const DTree& dtree = m_tree.get_sampling_dtree(point);
+    if (!(dtree.get_total() > 0.0f))
+        return false;
+
+    const float alpha = m_bsdf_sampling_fraction;
+
+    sampling_context.split_in_place(1, 1);
+    const float s = sampling_context.next2<float>();
+
+    if (s < alpha)
+    {
+        // Keep the BSDF sample.
+        if (sample.get_mode() == ScatteringMode::None)
+            return true;
+
+        if (sample.get_probability() == BSDF::DiracDelta)
+        {
+            // Dirac samples can only be generated by BSDF sampling.
+            sample.m_value /= alpha;
+            bsdf_prob = BSDF::DiracDelta;
+            return true;
+        }
+
+        bsdf_prob = sample.get_probability();
+
+        const float guide_prob = dtree.evaluate_pdf(sample.m_incoming.get_value());
+        sample.set_to_scattering(
+            sample.get_mode(),
+            alpha * bsdf_prob + (1.0f - alpha) * guide_prob);
+
+        return true;
+    }
+
+    // Sample the guiding distribution.
+    sampling_context.split_in_place(2, 1);
+    float guide_prob;
+    const Vector3f incoming = dtree.sample(sampling_context.next2<Vector2f>(), guide_prob);
+
+    DirectShadingComponents value;
+    bsdf_prob =
+        bsdf.evaluate(
+            vertex.m_bsdf_data,
+            adjoint,
+            true,                                       // multiply by |cos(incoming, normal)|
+            Vector3f(vertex.get_geometric_normal()),
+            Basis3f(vertex.get_shading_basis()),
+            Vector3f(vertex.m_outgoing.get_value()),
+            incoming,
+            guided_modes,
+            value);
+
+    ++m_guided_bounce_count;
+
+    if (!(bsdf_prob > 0.0f))
+    {
+        sample.set_to_absorption();
+        return true;
+    }
+
+    // The exact BSDF component is unknown; bounce counters treat the event as diffuse if possible.
+    const ScatteringMode::Mode mode =
+        (guided_modes & ScatteringMode::Diffuse) != 0
+            ? ScatteringMode::Diffuse
+            : ScatteringMode::Glossy;
+
+    sample.m_incoming = Dual3f(incoming);
+    sample.m_value = value;
+    sample.set_to_scattering(
+        mode,
+        alpha * bsdf_prob + (1.0f - alpha) * guide_prob);
+
+    return true;
+}
+
+void GuidedPath::add_vertex(
+    const PathVertex&               vertex,
+    const Vector3f&                 incoming,
+    const float                     probability)
+{
+    // Dirac scattering events can't be learned.
+    if (!m_is_training || probability == BSDF::DiracDelta || m_vertex_count == MaxVertexCount)
+        return;
+
+    Vertex& v = m_vertices[m_vertex_count++];
+    v.m_point = Vector3f(vertex.get_point());
+    v.m_direction = incoming;
+    v.m_probability = probability;
+    v.m_throughput = vertex.m_throughput;
+    v.m_radiance.set(0.0f);
+}
+
+void GuidedPath::add_radiance(const Spectrum& radiance)
+{
+    for (size_t i = 0; i < m_vertex_count; ++i)
+    {
+        // Divide by the throughput up to and including the scattering event at this vertex
+        // to get the radiance arriving at this vertex.
+        Vertex& v = m_vertices[i];
+        for (size_t c = 0, e = radiance.size(); c < e; ++c)
+        {
+            if (v.m_throughput[c] > 0.0f)
+                v.m_radiance[c] += radiance[c] / v.m_throughput[c];
+        }
+    }
+}
+
+void GuidedPath::commit()
+{
+    for (size_t i = 0; i < m_vertex_count; ++i)
+    {
+        const Vertex& v = m_vertices[i];
+        m_tree.record(
+            v.m_point,
+            v.m_direction,
+            average_value(v.m_radiance),
+            v.m_probability);
+    }
+
+    m_vertex_count = 0;
+}
+
+}   // namespace renderer
@@ -0,0 +1,128 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class BSDFSample; }
+namespace renderer  { class PathVertex; }
+namespace renderer  { class STree; }
+
+namespace renderer
+{
+
+//
+// Per-thread state of the path guiding machinery, reused from one path to the next.
+//
+// At every bounce, the path tracer lets this object combine BSDF sampling with sampling
+// of the learned directional distribution (one-sample MIS with a fixed BSDF sampling
+// fraction). Path visitors report the radiance they add to the path; when the path is
+// complete, the radiance that arrived at each vertex is recorded into the SD-tree.
+//
+
+class GuidedPath
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    GuidedPath(
+        STree&                      tree,
+        const float                 bsdf_sampling_fraction);
+
+    // Start a new path.
+    void begin_path();
+
+    // Possibly replace a BSDF sample by a direction sampled from the guiding distribution,
+    // and set the probability of the sample to the density of the combined strategy.
+    // bsdf_prob receives the density of BSDF sampling alone, for use in MIS with light sampling.
+    // Return true if guiding was used at this vertex.
+    bool guide_sample(
+        SamplingContext&            sampling_context,
+        const PathVertex&           vertex,
+        const bool                  adjoint,
+        BSDFSample&                 sample,
+        float&                      bsdf_prob);
+
+    // Remember a scattering event. vertex.m_throughput must already include the scattering weight.
+    void add_vertex(
+        const PathVertex&           vertex,
+        const foundation::Vector3f& incoming,
+        const float                 probability);
+
+    // Account for radiance added to the path (already multiplied by the path throughput).
+    void add_radiance(const Spectrum& radiance);
+
+    // Record the radiance arriving at each vertex of the current path into the SD-tree.
+    void commit();
+
+    // Return the total number of bounces sampled from the guiding distribution.
+    foundation::uint64 get_guided_bounce_count() const;
+
+  private:
+    enum { MaxVertexCount = 32 };
+
+    struct Vertex
+    {
+        foundation::Vector3f        m_point;
+        foundation::Vector3f        m_direction;
+        float                       m_probability;
+        Spectrum                    m_throughput;
+        Spectrum                    m_radiance;
+    };
+
+    STree&                          m_tree;
+    const float                     m_bsdf_sampling_fraction;
+    bool                            m_is_training;
+    Vertex                          m_vertices[MaxVertexCount];
+    size_t                          m_vertex_count;
+    foundation::uint64              m_guided_bounce_count;
+};
+
+
+//
+// GuidedPath class implementation.
+//
+
+inline foundation::uint64 GuidedPath::get_guided_bounce_count() const
+{
+    return m_guided_bounce_count;
+}
+
+}   // namespace renderer
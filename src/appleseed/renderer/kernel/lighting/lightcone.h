@@ -0,0 +1,161 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+
+namespace renderer
+{
+
+//
+// A cone bounding the emission directions of a set of lights.
+//
+// The normals of all lights lie within m_theta_o radians of m_axis, and every
+// light only emits within m_theta_e radians of its normal.
+//
+// Reference:
+//
+//   Importance Sampling of Many Lights with Adaptive Tree Splitting
+//   Alejandro Conty Estevez, Christopher Kulla
+//   http://www.aconty.com/pdf/many-lights-hpg2018.pdf
+//
+
+class LightCone
+{
+  public:
+    foundation::Vector3f    m_axis;         // unit-length
+    float                   m_theta_o;      // bound on the normals, in [0, Pi]
+    float                   m_theta_e;      // bound on the emission around each normal, in [0, Pi/2]
+
+    // Constructors.
+    LightCone();                            // cone bounding all directions
+    LightCone(
+        const foundation::Vector3f& axis,
+        const float                 theta_o,
+        const float                 theta_e);
+
+    // Return the smallest cone bounding two cones.
+    static LightCone merge(const LightCone& lhs, const LightCone& rhs);
+
+    // Return an upper bound of the cosine of the emission angle toward a receiver
+    // seen in the unit-length direction `outgoing` from the apex of the cone.
+    // theta_u is the angle subtended by the bounding sphere of the lights.
+    float max_cos_emission(
+        const foundation::Vector3f& outgoing,
+        const float                 theta_u) const;
+
+    // Same as above, but return a lower bound.
+    float min_cos_emission(
+        const foundation::Vector3f& outgoing,
+        const float                 theta_u) const;
+};
+
+
+//
+// LightCone class implementation.
+//
+
+inline LightCone::LightCone()
+  : m_axis(0.0f, 0.0f, 1.0f)
+  , m_theta_o(foundation::Pi<float>())
+  , m_theta_e(foundation::HalfPi<float>())
+{
+}
+
+inline LightCone::LightCone(
+    const foundation::Vector3f&     axis,
+    const float                     theta_o,
+    const float                     theta_e)
+  : m_axis(axis)
+  , m_theta_o(theta_o)
+  , m_theta_e(theta_e)
+{
+}
+
+inline LightCone LightCone::merge(const LightCone& lhs, const LightCone& rhs)
+{
+    // Let a be the widest of the two cones.
+    const LightCone& a = lhs.m_theta_o >= rhs.m_theta_o ? lhs : rhs;
+    const LightCone& b = lhs.m_theta_o >= rhs.m_theta_o ? rhs : lhs;
+
+    const float theta_e = std::max(a.m_theta_e, b.m_theta_e);
+
+    const float cos_theta_d = foundation::clamp(foundation::dot(a.m_axis, b.m_axis), -1.0f, 1.0f);
+    const float theta_d = std::acos(cos_theta_d);
+
+    // The widest cone already bounds the other one.
+    if (std::min(theta_d + b.m_theta_o, foundation::Pi<float>()) <= a.m_theta_o)
+        return LightCone(a.m_axis, a.m_theta_o, theta_e);
+
+    const float theta_o = 0.5f * (a.m_theta_o + theta_d + b.m_theta_o);
+
+    // The axes are (nearly) opposite or the union covers the whole sphere.
+    const foundation::Vector3f w = b.m_axis - cos_theta_d * a.m_axis;
+    const float w_norm = foundation::norm(w);
+    if (theta_o >= foundation::Pi<float>() || w_norm < 1.0e-6f)
+        return LightCone(a.m_axis, foundation::Pi<float>(), theta_e);
+
+    // Rotate the axis of the widest cone toward the axis of the other cone.
+    const float theta_r = theta_o - a.m_theta_o;
+    const foundation::Vector3f axis =
+        foundation::normalize(
+            std::cos(theta_r) * a.m_axis +
+            std::sin(theta_r) / w_norm * w);
+
+    return LightCone(axis, theta_o, theta_e);
+}
+
+inline float LightCone::max_cos_emission(
+    const foundation::Vector3f&     outgoing,
+    const float                     theta_u) const
+{
+    const float theta = std::acos(foundation::clamp(foundation::dot(m_axis, outgoing), -1.0f, 1.0f));
+    const float theta_prime = std::max(theta - m_theta_o - theta_u, 0.0f);
+
+    return theta_prime < m_theta_e ? std::cos(theta_prime) : 0.0f;
+}
+
+inline float LightCone::min_cos_emission(
+    const foundation::Vector3f&     outgoing,
+    const float                     theta_u) const
+{
+    const float theta = std::acos(foundation::clamp(foundation::dot(m_axis, outgoing), -1.0f, 1.0f));
+    const float theta_prime = theta + m_theta_o + theta_u;
+
+    return theta_prime < m_theta_e ? std::cos(theta_prime) : 0.0f;
+}
+
+}   // namespace renderer
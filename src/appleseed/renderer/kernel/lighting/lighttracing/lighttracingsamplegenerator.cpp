@@ -39,9 +39,9 @@
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/lighting/tracer.h"
-#include "renderer/kernel/rendering/globalsampleaccumulationbuffer.h"
 #include "renderer/kernel/rendering/sample.h"
 #include "renderer/kernel/rendering/samplegeneratorbase.h"
+#include "renderer/kernel/rendering/tiledsampleaccumulationbuffer.h"
 #include "renderer/kernel/shading/oslshadergroupexec.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -236,14 +236,14 @@ namespace
 
             if (!abort_switch.is_aborted())
             {
-                // `GlobalSampleAccumulationBuffer::increment_sample_count()` must only be
+                // `TiledSampleAccumulationBuffer::increment_sample_count()` must only be
                 // called if rendering was not aborted. Indeed, when rendering is aborted,
-                // `GlobalSampleAccumulationBuffer::store_samples()` returns before it has
+                // `TiledSampleAccumulationBuffer::store_samples()` returns before it has
                 // stored all the samples rendered by this job. In this case, incrementing
                 // the total number of samples would create an imbalance that would darken
                 // the final render. This is still not 100% correct since some samples may
                 // have been stored.
-                static_cast<GlobalSampleAccumulationBuffer&>(buffer)
+                static_cast<TiledSampleAccumulationBuffer&>(buffer)
                     .increment_sample_count(m_light_sample_count);
             }
         }
@@ -949,9 +949,11 @@ SampleAccumulationBuffer* LightTracingSampleGeneratorFactory::create_sample_accu
     const CanvasProperties& props = m_frame.image().properties();
 
     return
-        new GlobalSampleAccumulationBuffer(
+        new TiledSampleAccumulationBuffer(
             props.m_canvas_width,
-            props.m_canvas_height);
+            props.m_canvas_height,
+            props.m_tile_width,
+            props.m_tile_height);
 }
 
 }   // namespace renderer
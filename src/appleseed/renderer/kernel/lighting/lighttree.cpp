@@ -64,9 +64,13 @@ namespace renderer
 
 LightTree::LightTree(
     const vector<NonPhysicalLightInfo>&      non_physical_lights,
-    const vector<EmittingShape>&             emitting_shapes)
+    const vector<EmittingShape>&             emitting_shapes,
+    const float                              split_threshold,
+    const size_t                             max_split_count)
   : m_non_physical_lights(non_physical_lights)
   , m_emitting_shapes(emitting_shapes)
+  , m_split_threshold(split_threshold)
+  , m_max_split_count(clamp<size_t>(max_split_count, 1, MaxSplitCount))
   , m_tree_depth(0)
   , m_is_built(false)
 {
@@ -170,6 +174,8 @@ float LightTree::recursive_node_update(
     IndexLUT&       tri_index_to_node_index)
 {
     float importance = 0.0f;
+    AABB3d bbox;
+    LightCone cone;
 
     if (!m_nodes[node_index].is_leaf())
     {
@@ -180,6 +186,9 @@ float LightTree::recursive_node_update(
         const float importance2 = recursive_node_update(node_index, child2, node_level + 1, tri_index_to_node_index);
 
         importance = importance1 + importance2;
+        bbox = m_nodes[child1].get_bbox();
+        bbox.insert(m_nodes[child2].get_bbox());
+        cone = LightCone::merge(m_nodes[child1].get_cone(), m_nodes[child2].get_cone());
     }
     else
     {
@@ -187,6 +196,8 @@ float LightTree::recursive_node_update(
         const size_t item_index = m_nodes[node_index].get_item_index();
         const size_t light_index = m_items[item_index].m_light_index;
 
+        bbox = m_items[item_index].m_bbox;
+
         if (m_items[item_index].m_light_type == NonPhysicalLightType)
         {
             const Light* light = m_non_physical_lights[light_index].m_light;
@@ -195,6 +206,9 @@ float LightTree::recursive_node_update(
             Spectrum spectrum;
             light->get_inputs().find("intensity").source()->evaluate_uniform(spectrum);
             importance = average_value(spectrum);
+
+            // Light tree compatible non-physical lights emit in all directions.
+            cone = LightCone(Vector3f(0.0f, 0.0f, 1.0f), Pi<float>(), HalfPi<float>());
         }
         else
         {
@@ -217,6 +231,11 @@ float LightTree::recursive_node_update(
             else
                 importance = max_contribution * edf->get_uncached_importance_multiplier();
 
+            // Weight the emitted radiance by the area of the shape to get its energy.
+            importance *= shape.get_area();
+
+            cone = compute_emitting_shape_cone(shape);
+
             // Save the index of the light tree node containing the EMT in the look up table.
             tri_index_to_node_index[light_index] = node_index;
         }
@@ -231,26 +250,117 @@ float LightTree::recursive_node_update(
     else m_nodes[node_index].set_parent(parent_index);
 
     m_nodes[node_index].set_importance(importance);
+    m_nodes[node_index].set_bbox(bbox);
+    m_nodes[node_index].set_cone(cone);
     m_nodes[node_index].set_level(node_level);
 
     return importance;
 }
 
-void LightTree::sample(
+LightCone LightTree::compute_emitting_shape_cone(const EmittingShape& shape)
+{
+    // Diffuse emission only happens on the side of the shading normal.
+    const float ThetaE = HalfPi<float>();
+
+    switch (shape.get_shape_type())
+    {
+      case EmittingShape::TriangleShape:
+        {
+            // The shading normal is interpolated from the vertex normals, hence it
+            // lies within the cone bounding them.
+            const auto& triangle = shape.m_geom.m_triangle;
+            return
+                LightCone::merge(
+                    LightCone::merge(
+                        LightCone(normalize(Vector3f(triangle.m_n0)), 0.0f, ThetaE),
+                        LightCone(normalize(Vector3f(triangle.m_n1)), 0.0f, ThetaE)),
+                    LightCone(normalize(Vector3f(triangle.m_n2)), 0.0f, ThetaE));
+        }
+
+      case EmittingShape::RectangleShape:
+        return LightCone(Vector3f(shape.m_geom.m_rectangle.m_geometric_normal), 0.0f, ThetaE);
+
+      case EmittingShape::DiskShape:
+        return LightCone(Vector3f(shape.m_geom.m_disk.m_geometric_normal), 0.0f, ThetaE);
+
+      case EmittingShape::SphereShape:
+      default:
+        return LightCone(Vector3f(0.0f, 0.0f, 1.0f), Pi<float>(), ThetaE);
+    }
+}
+
+size_t LightTree::sample(
     const ShadingPoint&     shading_point,
-    float                   s,
-    LightType&              light_type,
-    size_t&                 light_index,
-    float&                  light_probability) const
+    const float             s,
+    Sample                  samples[]) const
 {
     assert(is_built());
 
-    light_probability = 1.0f;
-    size_t node_index = 0;
+    size_t sample_count = 0;
+    sample_subtree(
+        shading_point,
+        0,
+        s,
+        m_max_split_count,
+        1.0f,
+        samples,
+        sample_count);
+
+    return sample_count;
+}
 
+void LightTree::sample_subtree(
+    const ShadingPoint&     shading_point,
+    size_t                  node_index,
+    float                   s,
+    const size_t            split_budget,
+    float                   light_probability,
+    Sample                  samples[],
+    size_t&                 sample_count) const
+{
     while (!m_nodes[node_index].is_leaf())
     {
         const auto& node = m_nodes[node_index];
+        const size_t child_index = node.get_child_node_index();
+
+        if (should_split(node, shading_point, split_budget))
+        {
+            // Visit both children and share the remaining budget between them.
+            // Children with zero importance cannot light the shading point and are skipped.
+            // The second child gets a shifted random number to decorrelate the two samples.
+            const size_t left_budget = split_budget / 2;
+
+            if (compute_node_importance(m_nodes[child_index], shading_point) > 0.0f)
+            {
+                sample_subtree(
+                    shading_point,
+                    child_index,
+                    s,
+                    left_budget,
+                    light_probability,
+                    samples,
+                    sample_count);
+            }
+
+            if (compute_node_importance(m_nodes[child_index + 1], shading_point) > 0.0f)
+            {
+                const float GoldenRatioConjugate = 0.6180339887f;
+                float shifted_s = s + GoldenRatioConjugate;
+                if (shifted_s >= 1.0f)
+                    shifted_s -= 1.0f;
+
+                sample_subtree(
+                    shading_point,
+                    child_index + 1,
+                    shifted_s,
+                    split_budget - left_budget,
+                    light_probability,
+                    samples,
+                    sample_count);
+            }
+
+            return;
+        }
 
         float p1, p2;
         child_node_probabilites(node, shading_point, p1, p2);
@@ -259,150 +369,166 @@ void LightTree::sample(
         {
             light_probability *= p1;
             s /= p1;
-            node_index = node.get_child_node_index();
+            node_index = child_index;
         }
         else
         {
             light_probability *= p2;
             s = (s - p1) / p2;
-            node_index = node.get_child_node_index() + 1;
+            node_index = child_index + 1;
         }
     }
 
+    assert(sample_count < m_max_split_count);
+
     const size_t item_index = m_nodes[node_index].get_item_index();
     const Item& item = m_items[item_index];
-    light_type = item.m_light_type;
-    light_index = item.m_light_index;
+
+    Sample& sample = samples[sample_count++];
+    sample.m_light_type = item.m_light_type;
+    sample.m_light_index = item.m_light_index;
+    sample.m_probability = light_probability;
 }
 
 float LightTree::evaluate_node_pdf(
     const ShadingPoint&     shading_point,
-    size_t                  node_index) const
+    const size_t            node_index) const
 {
-    size_t parent_index = m_nodes[node_index].get_parent();
-    float pdf = 1.0f;
+    size_t split_budget;
+    return evaluate_node_pdf(shading_point, node_index, split_budget);
+}
 
-    do
+float LightTree::evaluate_node_pdf(
+    const ShadingPoint&     shading_point,
+    const size_t            node_index,
+    size_t&                 split_budget) const
+{
+    if (m_nodes[node_index].is_root())
     {
-        const LightTreeNode<AABB3d>& node = m_nodes[parent_index];
+        split_budget = m_max_split_count;
+        return 1.0f;
+    }
 
-        float p1, p2;
-        child_node_probabilites(node, shading_point, p1, p2);
+    // Splitting decisions depend on the budget left by the ancestors of the node,
+    // so the probability is accumulated from the root downward.
+    const size_t parent_index = m_nodes[node_index].get_parent();
+    size_t parent_split_budget;
+    const float parent_pdf = evaluate_node_pdf(shading_point, parent_index, parent_split_budget);
 
-        pdf *= node.get_child_node_index() == node_index ? p1 : p2;
+    const LightTreeNode<AABB3d>& parent = m_nodes[parent_index];
+    const bool is_first_child = parent.get_child_node_index() == node_index;
 
-        // Save the child index to be sure which probability should be taken
-        // into consideration.
-        node_index = parent_index;
-        parent_index = m_nodes[node_index].get_parent();
-    } while (!m_nodes[node_index].is_root());
+    // Both children of a split node are visited, unless they have zero importance.
+    if (should_split(parent, shading_point, parent_split_budget))
+    {
+        const size_t left_budget = parent_split_budget / 2;
+        split_budget = is_first_child ? left_budget : parent_split_budget - left_budget;
+        return
+            compute_node_importance(m_nodes[node_index], shading_point) > 0.0f
+                ? parent_pdf
+                : 0.0f;
+    }
 
-    return pdf;
+    float p1, p2;
+    child_node_probabilites(parent, shading_point, p1, p2);
+
+    split_budget = parent_split_budget;
+    return parent_pdf * (is_first_child ? p1 : p2);
 }
 
 namespace
 {
-    // [1] Section 2.2.
-    float sub_hemispherical_light_source_contribution(
-        const float     cos_omega,
-        const float     cos_sigma)
+    float angle_between(const Vector3f& lhs, const Vector3f& rhs)
     {
-        assert(cos_omega >= -1.0f && cos_omega <= 1.0f);
-        assert(cos_sigma >= 0.0f && cos_sigma <= 1.0f);
-
-        const float sin_omega = sqrt(1.0f - cos_omega * cos_omega);
-
-        const float sin_sigma2 = 1.0f - (cos_sigma * cos_sigma);
-        const float sin_sigma = sqrt(sin_sigma2);
-
-        const float sin_gamma = cos_sigma / sin_omega;
-        const float cos_gamma2 = 1.0f - (sin_gamma * sin_gamma);
-        const float cos_gamma = sqrt(cos_gamma2);
-
-        const float g = -2.0f * sin_omega * cos_sigma * cos_gamma
-                    + HalfPi<float>()
-                    - asin(sin_gamma)
-                    + sin_gamma * cos_gamma;
-
-        const float h =
-            cos_omega * (
-                cos_gamma * sqrt(sin_sigma2 - cos_gamma2)
-                + sin_sigma2 * asin(cos_gamma / sin_sigma));
-
-        const float omega = acos(cos_omega);
-        const float sigma = acos(cos_sigma);
-
-        float contribution;
-        if (omega < (HalfPi<float>() - sigma))
-            contribution = cos_omega * sin_sigma2;
-        else if (omega < HalfPi<float>())
-            contribution = cos_omega * sin_sigma2 + RcpPi<float>() * (g - h);
-        else if (omega < (HalfPi<float>() + sigma))
-            contribution = RcpPi<float>() * (g + h);
-        else
-            contribution = default_eps<float>();
-
-        // Avoid returning zero contribution.
-        if (fz(contribution))
-            return default_eps<float>();
-        else
-            return contribution;
+        return acos(clamp(dot(lhs, rhs), -1.0f, 1.0f));
     }
 }
 
-float LightTree::compute_node_probability(
+float LightTree::compute_node_importance(
     const LightTreeNode<AABB3d>&    node,
-    const AABB3d&                   bbox,
-    const ShadingPoint&             shading_point) const
+    const ShadingPoint&             shading_point,
+    float*                          min_importance,
+    float*                          max_importance) const
 {
-    // Calculate probability of a single node based on its contribution over solid angle.
+    //
+    // Importance of a cluster of lights with respect to a receiver, bounded using
+    // the bounding box and orientation cone of the cluster:
+    //
+    //   Importance Sampling of Many Lights with Adaptive Tree Splitting
+    //   Alejandro Conty Estevez, Christopher Kulla
+    //   http://www.aconty.com/pdf/many-lights-hpg2018.pdf
+    //
+
+    const AABB3d& bbox = node.get_bbox();
+    const LightCone& cone = node.get_cone();
+
+    const Vector3f to_node(bbox.center() - shading_point.get_point());
     const float r2 = static_cast<float>(bbox.square_radius());
-    const float rcp_surface_area = 1.0f / r2;
+    const float d2 = square_norm(to_node);
 
-    // Triangle centroid is a more precise position than the center of the bbox.
-    Vector3d position;
-    if (node.is_leaf())
+    // No orientation bounds are available when the shading point lies within the bounding sphere.
+    if (d2 <= r2)
     {
-        const Item& item = m_items[node.get_item_index()];
-        if (item.m_light_type == EmittingShapeType)
-            position = m_emitting_shapes[item.m_light_index].get_centroid();
-        else position = bbox.center();
+        const float importance = r2 > 0.0f ? node.get_importance() / r2 : 0.0f;
+
+        if (min_importance)
+        {
+            *min_importance = 0.0f;
+            *max_importance = importance;
+        }
+
+        return importance;
     }
-    else position = bbox.center();
 
-    const Vector3d& surface_point = shading_point.get_point();
+    const float d = sqrt(d2);
+    const float r = sqrt(r2);
+    const Vector3f incoming = to_node / d;
 
-    const float distance2 =
-        static_cast<float>(square_distance(surface_point, position));
+    // Angle subtended by the bounding sphere of the node.
+    const float theta_u = asin(r / d);
 
-    // Evaluated point is outside the bbox.
-    // The original Nathan's implementation returns importance divided by the node surface area.
-    // However, replacing the surface area by the square distance showed to result in less noise.
-    if (distance2 <= r2)
-        return node.get_importance() / distance2;
+    // Bound the cosine of the emission angle.
+    const float max_cos_emission = cone.max_cos_emission(-incoming, theta_u);
 
-    //
-    // Implementation of Lambertian lighting model for sub-hemispherical light sources.
-    // Reference:
-    //  [1] Area Light Sources for Real-Time Graphics
-    //      https://www.microsoft.com/en-us/research/wp-content/uploads/1996/03/arealights.pdf
-    //
-    const Vector3d outcoming_light_direction = normalize(bbox.center() - surface_point);
-    const float sin_sigma2 = min(1.0f, (r2 / distance2));
-    const float cos_sigma = sqrt(1.0f - sin_sigma2);
+    // Bound the cosine of the incidence angle. Both sides of the receiver are
+    // considered so that transmission remains possible.
+    const Vector3f n(shading_point.get_shading_normal());
+    float theta_i = angle_between(n, incoming);
+    theta_i = min(theta_i, Pi<float>() - theta_i);
+    const float max_cos_incidence = cos(max(theta_i - theta_u, 0.0f));
+
+    const float energy_times_cos = node.get_importance() * max_cos_emission * max_cos_incidence;
 
-    const Vector3d& incoming_light_direction = shading_point.get_ray().m_dir;
+    if (min_importance)
+    {
+        assert(max_importance);
 
-    // [1] "Arbitrary direction D receives light only if dot(D,L) >= 0".
-    const Vector3d& N = (dot(shading_point.get_geometric_normal(), incoming_light_direction) <= 0.0f)
-        ? shading_point.get_shading_normal()
-        : -shading_point.get_shading_normal();
+        const float min_cos_emission = cone.min_cos_emission(-incoming, theta_u);
+        const float min_cos_incidence =
+            theta_i + theta_u < HalfPi<float>() ? cos(theta_i + theta_u) : 0.0f;
 
-    const float cos_omega = clamp(static_cast<float>(dot(N, outcoming_light_direction)), -1.0f, 1.0f);
-    const float approx_contribution = sub_hemispherical_light_source_contribution(cos_omega, cos_sigma);
+        *min_importance =
+            node.get_importance() * min_cos_emission * min_cos_incidence / square(d + r);
+        *max_importance = energy_times_cos / square(d - r);
+    }
 
-    assert(approx_contribution > 0.0f);
-    return node.get_importance() * rcp_surface_area * approx_contribution;
+    return energy_times_cos / d2;
+}
+
+bool LightTree::should_split(
+    const LightTreeNode<AABB3d>&    node,
+    const ShadingPoint&             shading_point,
+    const size_t                    split_budget) const
+{
+    if (split_budget < 2 || m_split_threshold <= 0.0f)
+        return false;
+
+    float min_importance, max_importance;
+    compute_node_importance(node, shading_point, &min_importance, &max_importance);
+
+    // Split when the importance of the lights below the node varies too much
+    // for a single sample to represent them well.
+    return max_importance > 0.0f && min_importance < m_split_threshold * max_importance;
 }
 
 void LightTree::child_node_probabilites(
@@ -414,14 +540,8 @@ void LightTree::child_node_probabilites(
     const auto& child1 = m_nodes[node.get_child_node_index()];
     const auto& child2 = m_nodes[node.get_child_node_index() + 1];
 
-    // Node has currently no info about its own bbox characteristics.
-    // Hence we have to extract it before from its parent.
-    // todo: make LightTreeNode aware of its bbox!
-    const auto& bbox_left = node.get_left_bbox();
-    const auto& bbox_right = node.get_right_bbox();
-
-    p1 = compute_node_probability(child1, bbox_left, shading_point);
-    p2 = compute_node_probability(child2, bbox_right, shading_point);
+    p1 = compute_node_importance(child1, shading_point);
+    p2 = compute_node_importance(child2, shading_point);
 
     // Normalize probabilities.
     const float total = p1 + p2;
@@ -29,6 +29,7 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/kernel/lighting/lightcone.h"
 #include "renderer/kernel/lighting/lighttree_node.h"
 #include "renderer/kernel/lighting/lighttypes.h"
 
@@ -59,22 +60,39 @@ class LightTree
             >
 {
   public:
+    // Maximum number of lights that a single call to sample() may return.
+    enum { MaxSplitCount = 16 };
+
+    // A light chosen by sample().
+    struct Sample
+    {
+        LightType               m_light_type;
+        size_t                  m_light_index;
+        float                   m_probability;
+    };
+
     // Constructor.
     // Build the tree based on the lights collected by the BackwardLightSampler.
+    // Traversal is split into several samples at nodes whose minimum importance
+    // falls below split_threshold times their maximum importance, up to a total
+    // of max_split_count samples. A split threshold of 0 disables splitting.
     LightTree(
         const std::vector<NonPhysicalLightInfo>&      non_physical_lights,
-        const std::vector<EmittingShape>&             emitting_shapes);
+        const std::vector<EmittingShape>&             emitting_shapes,
+        const float                                   split_threshold = 0.0f,
+        const size_t                                  max_split_count = 1);
 
     std::vector<size_t> build();
 
     bool is_built() const;
 
-    void sample(
+    // Sample the tree. Return the number of lights written to `samples`, which
+    // must have room for MaxSplitCount entries. The contributions of all the
+    // returned lights must be summed; their probabilities account for splitting.
+    size_t sample(
         const ShadingPoint&             shading_point,
         const float                     s,
-        LightType&                      light_type,
-        size_t&                         light_index,
-        float&                          light_probability) const;
+        Sample                          samples[]) const;
 
     // Compute the light probability of a particular tree node. Start from the
     // node and go backwards towards the root node.
@@ -113,6 +131,8 @@ class LightTree
 
     const NonPhysicalLightVector&                   m_non_physical_lights;
     const EmittingShapeVector&                      m_emitting_shapes;
+    const float                                     m_split_threshold;
+    const size_t                                    m_max_split_count;
     ItemVector                                      m_items;
     size_t                                          m_tree_depth;
     bool                                            m_is_built;
@@ -126,10 +146,38 @@ class LightTree
         const size_t                                node_level,
         IndexLUT&                                   tri_index_to_node_index);
 
-    float compute_node_probability(
+    // Compute the cone bounding the emission directions of an emitting shape.
+    static LightCone compute_emitting_shape_cone(const EmittingShape& shape);
+
+    // Compute the importance of a node with respect to a shading point from the
+    // energy, bounding box and orientation cone of the node. If min_importance
+    // and max_importance are provided, also compute bounds of the importance of
+    // any light below the node.
+    float compute_node_importance(
         const LightTreeNode<foundation::AABB3d>&    node,
-        const foundation::AABB3d&                   bbox,
-        const ShadingPoint&                         shading_point) const;
+        const ShadingPoint&                         shading_point,
+        float*                                      min_importance = nullptr,
+        float*                                      max_importance = nullptr) const;
+
+    // Return true if the traversal should visit both children of a node.
+    bool should_split(
+        const LightTreeNode<foundation::AABB3d>&    node,
+        const ShadingPoint&                         shading_point,
+        const size_t                                split_budget) const;
+
+    void sample_subtree(
+        const ShadingPoint&                         shading_point,
+        size_t                                      node_index,
+        float                                       s,
+        const size_t                                split_budget,
+        float                                       light_probability,
+        Sample                                      samples[],
+        size_t&                                     sample_count) const;
+
+    float evaluate_node_pdf(
+        const ShadingPoint&                         shading_point,
+        const size_t                                node_index,
+        size_t&                                     split_budget) const;
 
     void child_node_probabilites(
         const LightTreeNode<foundation::AABB3d>&    node,
@@ -28,6 +28,9 @@
 
 #pragma once
 
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lightcone.h"
+
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
@@ -54,11 +57,24 @@ class LightTreeNode
     {
     }
 
+    // Return the total energy of the lights below this node.
     float get_importance() const
     {
         return m_importance;
     }
 
+    // Return the bounding box of the lights below this node.
+    const AABB& get_bbox() const
+    {
+        return m_bbox;
+    }
+
+    // Return the cone bounding the emission directions of the lights below this node.
+    const LightCone& get_cone() const
+    {
+        return m_cone;
+    }
+
     size_t get_level() const
     {
         return m_tree_level;
@@ -79,6 +95,16 @@ class LightTreeNode
         m_importance = importance;
     }
 
+    void set_bbox(const AABB& bbox)
+    {
+        m_bbox = bbox;
+    }
+
+    void set_cone(const LightCone& cone)
+    {
+        m_cone = cone;
+    }
+
     // todo: set this during the construction
     void set_level(const size_t node_level)
     {
@@ -98,10 +124,12 @@ class LightTreeNode
     }
 
   private:
-    float   m_importance;
-    size_t  m_tree_level;
-    size_t  m_parent;
-    bool    m_root;
+    float       m_importance;
+    AABB        m_bbox;
+    LightCone   m_cone;
+    size_t      m_tree_level;
+    size_t      m_parent;
+    bool        m_root;
 };
 
 }   // namespace renderer
@@ -173,6 +173,7 @@ class EmittingShape
   private:
     friend class LightSamplerBase;
     friend class BackwardLightSampler;
+    friend class LightTree;
 
     struct Triangle
     {
@@ -37,6 +37,9 @@
 #include "foundation/math/dual.h"
 #include "foundation/math/vector.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class BSDF; }
 namespace renderer  { class DirectShadingComponents; }
@@ -78,6 +81,12 @@ class IMaterialSampler
         const foundation::Vector3d&     target_position,
         Spectrum&                       transmission) const = 0;
 
+    virtual void trace_between(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d*     target_positions,
+        const size_t                    target_count,
+        Spectrum*                       transmissions) const = 0;
+
     virtual bool sample(
         SamplingContext&                sampling_context,
         const foundation::Dual3d&       outgoing,
@@ -123,6 +132,12 @@ class BSDFSampler
         const foundation::Vector3d&     target_position,
         Spectrum&                       transmission) const override;
 
+    void trace_between(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d*     target_positions,
+        const size_t                    target_count,
+        Spectrum*                       transmissions) const override;
+
     bool sample(
         SamplingContext&                sampling_context,
         const foundation::Dual3d&       outgoing,
@@ -177,6 +192,12 @@ class VolumeSampler
         const foundation::Vector3d&     target_position,
         Spectrum&                       transmission) const override;
 
+    void trace_between(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d*     target_positions,
+        const size_t                    target_count,
+        Spectrum*                       transmissions) const override;
+
     bool sample(
         SamplingContext&                sampling_context,
         const foundation::Dual3d&       outgoing,
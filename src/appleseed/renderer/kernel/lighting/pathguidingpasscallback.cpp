@@ -0,0 +1,112 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "pathguidingpasscallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/scene/scene.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/string.h"
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// PathGuidingPassCallback class implementation.
+//
+
+PathGuidingPassCallback::PathGuidingPassCallback(
+    const Scene&                    scene,
+    const GuidingParameters&        params)
+  : m_params(params)
+  , m_tree(AABB3f(scene.compute_bbox()), params)
+  , m_pass_number(0)
+{
+}
+
+void PathGuidingPassCallback::release()
+{
+    delete this;
+}
+
+void PathGuidingPassCallback::on_pass_begin(
+    const Frame&                    frame,
+    JobQueue&                       job_queue,
+    IAbortSwitch&                   abort_switch)
+{
+    m_tree.set_training(m_pass_number < m_params.m_training_passes);
+    m_stopwatch.start();
+}
+
+void PathGuidingPassCallback::on_pass_end(
+    const Frame&                    frame,
+    JobQueue&                       job_queue,
+    IAbortSwitch&                   abort_switch)
+{
+    if (m_tree.is_training() && !abort_switch.is_aborted())
+    {
+        m_tree.refine();
+        m_tree.set_training(false);
+
+        m_stopwatch.measure();
+
+        const StatisticsVector stats = m_tree.get_statistics();
+
+        if (m_params.m_report_statistics)
+        {
+            RENDERER_LOG_INFO(
+                "path guiding training pass %s of %s completed in %s.\n%s",
+                pretty_uint(m_pass_number + 1).c_str(),
+                pretty_uint(m_params.m_training_passes).c_str(),
+                pretty_time(m_stopwatch.get_seconds()).c_str(),
+                stats.to_string().c_str());
+        }
+        else
+        {
+            RENDERER_LOG_DEBUG(
+                "path guiding training pass %s of %s completed in %s.\n%s",
+                pretty_uint(m_pass_number + 1).c_str(),
+                pretty_uint(m_params.m_training_passes).c_str(),
+                pretty_time(m_stopwatch.get_seconds()).c_str(),
+                stats.to_string().c_str());
+        }
+    }
+
+    ++m_pass_number;
+}
+
+}   // namespace renderer
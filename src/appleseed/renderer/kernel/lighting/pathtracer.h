@@ -34,6 +34,7 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovcomponents.h"
 #include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/lighting/guidedpath.h"
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -114,7 +115,8 @@ class PathTracer
         const size_t            max_volume_bounces,
         const bool              clamp_roughness,
         const size_t            max_iterations = 1000,
-        const double            near_start = 0.0);          // abort tracing if the first ray is shorter than this
+        const double            near_start = 0.0,           // abort tracing if the first ray is shorter than this
+        GuidedPath*             guided_path = nullptr);     // optional path guiding state
 
     size_t trace(
         SamplingContext&        sampling_context,
@@ -143,6 +145,7 @@ class PathTracer
     const bool                  m_clamp_roughness;
     const size_t                m_max_iterations;
     const double                m_near_start;
+    GuidedPath*                 m_guided_path;
     size_t                      m_diffuse_bounces;
     size_t                      m_glossy_bounces;
     size_t                      m_specular_bounces;
@@ -196,7 +199,8 @@ inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
     const size_t                max_volume_bounces,
     const bool                  clamp_roughness,
     const size_t                max_iterations,
-    const double                near_start)
+    const double                near_start,
+    GuidedPath*                 guided_path)
   : m_path_visitor(path_visitor)
   , m_volume_visitor(volume_visitor)
   , m_rr_min_path_length(rr_min_path_length)
@@ -208,6 +212,7 @@ inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
   , m_clamp_roughness(clamp_roughness)
   , m_max_iterations(max_iterations)
   , m_near_start(near_start)
+  , m_guided_path(guided_path)
 {
 }
 
@@ -699,6 +704,11 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     if (vertex.m_scattering_modes == ScatteringMode::None)
         return false;
 
+    // When path guiding is used, the BSDF sample probability is the density of the combined
+    // sampling strategy while MIS with light sampling must keep using the BSDF density alone.
+    bool guided = false;
+    float bsdf_prob = 0.0f;
+
     // Above-surface scattering.
     if (vertex.m_bssrdf == nullptr)
     {
@@ -718,6 +728,17 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
             vertex.m_albedo_saved = true;
             m_path_visitor.on_first_diffuse_bounce(vertex);
         }
+
+        if (m_guided_path != nullptr)
+        {
+            guided =
+                m_guided_path->guide_sample(
+                    sampling_context,
+                    vertex,
+                    Adjoint,
+                    sample,
+                    bsdf_prob);
+        }
     }
     else
     {
@@ -737,7 +758,7 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
 
     // Save the scattering properties for MIS at light-emitting vertices.
     vertex.m_prev_mode = sample.get_mode();
-    vertex.m_prev_prob = sample.get_probability();
+    vertex.m_prev_prob = guided ? bsdf_prob : sample.get_probability();
 
     // Update the AOV scattering mode only for the first bounce.
     if (vertex.m_path_length == 1)
@@ -763,6 +784,15 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     next_ray.m_flags = ScatteringMode::get_vis_flags(sample.get_mode()),
     next_ray.m_depth = ray.m_depth + 1;
 
+    // Let path guiding learn from this scattering event.
+    if (m_guided_path != nullptr && vertex.m_bssrdf == nullptr)
+    {
+        m_guided_path->add_vertex(
+            vertex,
+            foundation::Vector3f(next_ray.m_dir),
+            sample.get_probability());
+    }
+
     // Compute scattered ray differentials.
     if (sample.m_incoming.has_derivatives())
     {
@@ -843,49 +873,119 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
             break;
         }
 
-        // Retrieve extinction spectrum.
-        const Spectrum& extinction_coef =
-            volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+        float distance_sample;
+        Spectrum scattering_weight;
+        bool scattering_weight_valid = true;
 
-        // Sample channel uniformly at random.
-        sampling_context.split_in_place(1, 1);
-        const float s = sampling_context.next2<float>();
-        const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
-        const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
-
-        // Sample distance.
-        float distance_sample, distance_pdf;
-        if (extinction_is_null)
+        if (!volume->is_homogeneous())
         {
-            distance_sample = 0.0f;
-            distance_pdf = 0.0f;
+            // Heterogeneous volumes sample distances by tracking against their majorant;
+            // the returned weight accounts for both the transmission and the scattering.
+            if (!volume->sample_distance(
+                    sampling_context,
+                    vertex.m_volume_data,
+                    volume_ray,
+                    distance_sample,
+                    scattering_weight))
+            {
+                // The path either escaped the volume or was absorbed.
+                vertex.m_throughput *= scattering_weight;
+                if (foundation::is_zero(scattering_weight))
+                    return false;
+                break;
+            }
         }
         else
         {
+            // Retrieve extinction spectrum.
+            const Spectrum& extinction_coef =
+                volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Sample channel uniformly at random.
             sampling_context.split_in_place(1, 1);
-            distance_sample =
-                foundation::sample_exponential_distribution(
-                    sampling_context.next2<float>(),
-                    extinction_coef[channel]);
-            distance_pdf =
-                foundation::exponential_distribution_pdf(
-                    distance_sample,
-                    extinction_coef[channel]);
-        }
+            const float s = sampling_context.next2<float>();
+            const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
+            const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
 
-        // Continue path tracing if sampled distance exceeds total length of the ray,
-        // otherwise process the scattering event.
-        if (extinction_is_null || volume_ray.m_tmax < distance_sample)
-        {
+            // Sample distance.
+            float distance_pdf;
+            if (extinction_is_null)
+            {
+                distance_sample = 0.0f;
+                distance_pdf = 0.0f;
+            }
+            else
+            {
+                sampling_context.split_in_place(1, 1);
+                distance_sample =
+                    foundation::sample_exponential_distribution(
+                        sampling_context.next2<float>(),
+                        extinction_coef[channel]);
+                distance_pdf =
+                    foundation::exponential_distribution_pdf(
+                        distance_sample,
+                        extinction_coef[channel]);
+            }
+
+            // Continue path tracing if sampled distance exceeds total length of the ray,
+            // otherwise process the scattering event.
+            if (extinction_is_null || volume_ray.m_tmax < distance_sample)
+            {
+                Spectrum transmission;
+                volume->evaluate_transmission(
+                    vertex.m_volume_data,
+                    volume_ray,
+                    transmission);
+                vertex.m_throughput *= transmission;
+                vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
+                    foundation::average_value(transmission); // and then dividing by transmission[channel]
+                break;
+            }
+
+            // Retrieve scattering spectrum.
+            const Spectrum& scattering_coef =
+                volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Evaluate transmission between the origin and the sampled distance.
             Spectrum transmission;
             volume->evaluate_transmission(
                 vertex.m_volume_data,
                 volume_ray,
+                distance_sample,
                 transmission);
-            vertex.m_throughput *= transmission;
-            vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
-                foundation::average_value(transmission); // and then dividing by transmission[channel]
-            break;
+
+            // Compute MIS weight.
+            // MIS terms are:
+            //  - scattering albedo,
+            //  - throughput of the entire path up to the sampled point.
+            // Reference: "Practical and Controllable Subsurface Scattering
+            // for Production Path Tracing", p. 1 [ACM 2016 Article].
+            float mis_weights_sum = 0.0f;
+            for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+            {
+                if (extinction_coef[i] > 1.0e-6f)
+                {
+                    const float probability =
+                        foundation::exponential_distribution_pdf(
+                            distance_sample,
+                            extinction_coef[i]);
+                    mis_weights_sum += foundation::square(probability);
+                }
+            }
+
+            if (mis_weights_sum < 1.0e-6f)
+                scattering_weight_valid = false;
+            else
+            {
+                const float current_mis_weight =
+                    Spectrum::size() *
+                    foundation::square(distance_pdf) /
+                    mis_weights_sum;
+
+                scattering_weight = scattering_coef;
+                scattering_weight *= transmission;
+                scattering_weight *= current_mis_weight / distance_pdf;
+            }
         }
 
         //
@@ -909,46 +1009,10 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
         if (vertex.m_scattering_modes == ScatteringMode::None)
             return false;
 
-        // Retrieve scattering spectrum.
-        const Spectrum& scattering_coef =
-            volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
-
-        // Evaluate transmission between the origin and the sampled distance.
-        Spectrum transmission;
-        volume->evaluate_transmission(
-            vertex.m_volume_data,
-            volume_ray,
-            distance_sample,
-            transmission);
-        
-        // Compute MIS weight.
-        // MIS terms are:
-        //  - scattering albedo,
-        //  - throughput of the entire path up to the sampled point.
-        // Reference: "Practical and Controllable Subsurface Scattering
-        // for Production Path Tracing", p. 1 [ACM 2016 Article].
-        float mis_weights_sum = 0.0f;
-        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
-        {
-            if (extinction_coef[i] > 1.0e-6f)
-            {
-                const float probability =
-                    foundation::exponential_distribution_pdf(
-                        distance_sample,
-                        extinction_coef[i]);
-                mis_weights_sum += foundation::square(probability);
-            }
-        }
-        if (mis_weights_sum < 1.0e-6f)
+        if (!scattering_weight_valid)
             return false;  // no scattering
-        const float current_mis_weight =
-            Spectrum::size() *
-            foundation::square(distance_pdf) /
-            mis_weights_sum;
-
-        vertex.m_throughput *= scattering_coef;
-        vertex.m_throughput *= transmission;
-        vertex.m_throughput *= current_mis_weight / distance_pdf;
+
+        vertex.m_throughput *= scattering_weight;
 
         // Sample phase function.
         foundation::Vector3f incoming;
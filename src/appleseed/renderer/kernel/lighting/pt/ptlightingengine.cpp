@@ -35,12 +35,14 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovcomponents.h"
 #include "renderer/kernel/lighting/directlightingintegrator.h"
+#include "renderer/kernel/lighting/guidedpath.h"
 #include "renderer/kernel/lighting/imagebasedlighting.h"
 #include "renderer/kernel/lighting/lightpathrecorder.h"
 #include "renderer/kernel/lighting/lightpathstream.h"
 #include "renderer/kernel/lighting/pathtracer.h"
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/sdtree.h"
 #include "renderer/kernel/lighting/volumelightingintegrator.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -67,6 +69,7 @@
 #include <cassert>
 #include <cstddef>
 #include <limits>
+#include <memory>
 #include <string>
 
 // Forward declarations.
@@ -85,12 +88,17 @@ namespace
     //
     // Path Tracing lighting engine.
     //
-    // Implementation of Monte Carlo backward path tracing with and without next event estimation.
+    // Implementation of Monte Carlo backward path tracing with and without next event estimation,
+    // optionally guided by a learned spatio-directional radiance distribution.
     //
-    // Reference:
+    // References:
     //
     //   http://citeseer.ist.psu.edu/344088.html
     //
+    //   Thomas Müller, Markus Gross, Jan Novák
+    //   Practical Path Guiding for Efficient Light-Transport Simulation
+    //   https://tom94.net/data/publications/mueller17practical/mueller17practical.pdf
+    //
 
     class PTLightingEngine
       : public ILightingEngine
@@ -99,6 +107,7 @@ namespace
         PTLightingEngine(
             const BackwardLightSampler&     light_sampler,
             LightPathRecorder&              light_path_recorder,
+            STree*                          sd_tree,
             const ParamArray&               params)
           : m_params(params)
           , m_light_sampler(light_sampler)
@@ -109,6 +118,11 @@ namespace
           , m_path_count(0)
           , m_inf_volume_ray_warnings(0)
         {
+            if (m_params.m_guiding.m_enabled && sd_tree != nullptr)
+            {
+                m_guided_path.reset(
+                    new GuidedPath(*sd_tree, m_params.m_guiding.m_bsdf_sampling_fraction));
+            }
         }
 
         void release() override
@@ -136,7 +150,10 @@ namespace
                 "  max ray intensity             %s\n"
                 "  volume distance samples       %s\n"
                 "  equiangular sampling          %s\n"
-                "  clamp roughness               %s",
+                "  clamp roughness               %s\n"
+                "  path guiding                  %s\n"
+                "  guiding training passes       %s\n"
+                "  guiding bsdf fraction         %s",
                 m_params.m_enable_dl ? "on" : "off",
                 m_params.m_enable_ibl ? "on" : "off",
                 m_params.m_enable_caustics ? "on" : "off",
@@ -153,7 +170,10 @@ namespace
                 m_params.m_has_max_ray_intensity ? pretty_scalar(m_params.m_max_ray_intensity).c_str() : "unlimited",
                 pretty_int(m_params.m_distance_sample_count).c_str(),
                 m_params.m_enable_equiangular_sampling ? "on" : "off",
-                m_params.m_clamp_roughness ? "on" : "off");
+                m_params.m_clamp_roughness ? "on" : "off",
+                m_guided_path ? "on" : "off",
+                pretty_uint(m_params.m_guiding.m_training_passes).c_str(),
+                pretty_scalar(m_params.m_guiding.m_bsdf_sampling_fraction, 2).c_str());
         }
 
         void compute_lighting(
@@ -203,6 +223,9 @@ namespace
             ShadingComponents&      radiance,               // output radiance, in W.sr^-1.m^-2
             AOVComponents&          aov_components)
         {
+            if (m_guided_path)
+                m_guided_path->begin_path();
+
             PathVisitor path_visitor(
                 m_params,
                 m_light_sampler,
@@ -211,7 +234,8 @@ namespace
                 shading_point.get_scene(),
                 radiance,
                 aov_components,
-                m_light_path_stream);
+                m_light_path_stream,
+                m_guided_path.get());
 
             VolumeVisitor volume_visitor(
                 m_params,
@@ -232,7 +256,9 @@ namespace
                 m_params.m_max_specular_bounces,
                 m_params.m_max_volume_bounces,
                 m_params.m_clamp_roughness,
-                shading_context.get_max_iterations());
+                shading_context.get_max_iterations(),
+                0.0,                                                        // near start
+                m_guided_path.get());
 
             const size_t path_length =
                 path_tracer.trace(
@@ -240,6 +266,10 @@ namespace
                     shading_context,
                     shading_point);
 
+            // Record the radiance arriving at the vertices of this path.
+            if (m_guided_path)
+                m_guided_path->commit();
+
             // Update statistics.
             ++m_path_count;
             m_path_length.insert(path_length);
@@ -251,6 +281,9 @@ namespace
             stats.insert("path count", m_path_count);
             stats.insert("path length", m_path_length);
 
+            if (m_guided_path)
+                stats.insert("guided bounces", m_guided_path->get_guided_bounce_count());
+
             return StatisticsVector::make("path tracing statistics", stats);
         }
 
@@ -286,6 +319,8 @@ namespace
 
             const bool      m_record_light_paths;
 
+            const GuidingParameters m_guiding;              // path guiding parameters
+
             explicit Parameters(const ParamArray& params)
               : m_enable_dl(params.get_optional<bool>("enable_dl", true))
               , m_enable_ibl(params.get_optional<bool>("enable_ibl", true))
@@ -306,6 +341,7 @@ namespace
               , m_distance_sample_count(params.get_optional<size_t>("volume_distance_samples", 2))
               , m_enable_equiangular_sampling(!params.get_optional<bool>("optimize_for_lights_outside_volumes", false))
               , m_record_light_paths(params.get_optional<bool>("record_light_paths", false))
+              , m_guiding(params)
             {
                 // Precompute the reciprocal of the number of light samples.
                 m_rcp_dl_light_sample_count =
@@ -334,6 +370,7 @@ namespace
         const Parameters                m_params;
         const BackwardLightSampler&     m_light_sampler;
         LightPathStream*                m_light_path_stream;
+        unique_ptr<GuidedPath>          m_guided_path;
 
         uint64                          m_path_count;
         Population<uint64>              m_path_length;
@@ -384,6 +421,7 @@ namespace
             ShadingComponents&                  m_path_radiance;
             AOVComponents&                      m_aov_components;
             LightPathStream*                    m_light_path_stream;
+            GuidedPath*                         m_guided_path;
             bool                                m_omit_emitted_light;
 
             PathVisitorBase(
@@ -394,7 +432,8 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                GuidedPath*                     guided_path)
               : m_params(params)
               , m_light_sampler(light_sampler)
               , m_sampling_context(sampling_context)
@@ -403,9 +442,16 @@ namespace
               , m_path_radiance(path_radiance)
               , m_aov_components(aov_components)
               , m_light_path_stream(light_path_stream)
+              , m_guided_path(guided_path)
               , m_omit_emitted_light(false)
             {
             }
+
+            void add_guided_radiance(const Spectrum& radiance)
+            {
+                if (m_guided_path)
+                    m_guided_path->add_radiance(radiance);
+            }
         };
 
         //
@@ -424,7 +470,8 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                GuidedPath*                     guided_path)
               : PathVisitorBase(
                     params,
                     light_sampler,
@@ -433,7 +480,8 @@ namespace
                     scene,
                     path_radiance,
                     aov_components,
-                    light_path_stream)
+                    light_path_stream,
+                    guided_path)
             {
             }
 
@@ -464,6 +512,7 @@ namespace
                     vertex.m_path_length,
                     vertex.m_aov_mode,
                     env_radiance);
+                add_guided_radiance(env_radiance);
             }
 
             void on_hit(const PathVertex& vertex)
@@ -491,6 +540,7 @@ namespace
                         vertex.m_path_length,
                         vertex.m_aov_mode,
                         emitted_radiance);
+                    add_guided_radiance(emitted_radiance);
                 }
                 else
                 {
@@ -529,7 +579,8 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                GuidedPath*                     guided_path)
               : PathVisitorBase(
                     params,
                     light_sampler,
@@ -538,7 +589,8 @@ namespace
                     scene,
                     path_radiance,
                     aov_components,
-                    light_path_stream)
+                    light_path_stream,
+                    guided_path)
               , m_is_indirect_lighting(false)
             {
             }
@@ -593,6 +645,7 @@ namespace
                     vertex.m_path_length,
                     vertex.m_aov_mode,
                     env_radiance);
+                add_guided_radiance(env_radiance);
             }
 
             void on_hit(const PathVertex& vertex)
@@ -624,6 +677,7 @@ namespace
                         vertex.m_path_length,
                         vertex.m_aov_mode,
                         emitted_radiance);
+                    add_guided_radiance(emitted_radiance);
                 }
                 else
                 {
@@ -719,6 +773,7 @@ namespace
                     vertex.m_path_length,
                     vertex.m_aov_mode,
                     vertex_radiance);
+                add_guided_radiance(vertex_radiance.m_beauty);
             }
 
           private:
@@ -1217,16 +1272,90 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Record Light Paths")
             .insert("help", "Record light paths in memory to later allow visualizing them or saving them to disk"));
 
+    metadata.dictionaries().insert(
+        "enable_path_guiding",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Path Guiding")
+            .insert("help", "Learn the distribution of incoming light during the first passes and use it to guide diffuse and glossy bounces"));
+
+    metadata.dictionaries().insert(
+        "guiding_training_passes",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4")
+            .insert("min", "1")
+            .insert("label", "Training Passes")
+            .insert("help", "Number of passes during which the guiding distribution is learned"));
+
+    metadata.dictionaries().insert(
+        "guiding_bsdf_sampling_fraction",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.5")
+            .insert("min", "0.01")
+            .insert("max", "1.0")
+            .insert("label", "BSDF Sampling Fraction")
+            .insert("help", "Probability of sampling the BSDF instead of the guiding distribution"));
+
+    metadata.dictionaries().insert(
+        "guiding_spatial_threshold",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "12000.0")
+            .insert("min", "1.0")
+            .insert("label", "Spatial Threshold")
+            .insert("help", "Number of samples per pass above which a spatial cell of the guiding structure is subdivided"));
+
+    metadata.dictionaries().insert(
+        "guiding_directional_threshold",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.01")
+            .insert("min", "0.0001")
+            .insert("max", "1.0")
+            .insert("label", "Directional Threshold")
+            .insert("help", "Fraction of the incoming energy above which a directional cell of the guiding structure is subdivided"));
+
+    metadata.dictionaries().insert(
+        "guiding_max_dtree_depth",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "20")
+            .insert("min", "1")
+            .insert("label", "Max Directional Depth")
+            .insert("help", "Maximum depth of the directional distributions"));
+
+    metadata.dictionaries().insert(
+        "guiding_max_memory",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "256")
+            .insert("min", "1")
+            .insert("label", "Max Memory")
+            .insert("help", "Memory budget of the guiding structure, in megabytes"));
+
+    metadata.dictionaries().insert(
+        "guiding_report_statistics",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Report Guiding Statistics")
+            .insert("help", "Print statistics about the guiding structure after every training pass"));
+
     return metadata;
 }
 
 PTLightingEngineFactory::PTLightingEngineFactory(
     const BackwardLightSampler&     light_sampler,
     LightPathRecorder&              light_path_recorder,
-    const ParamArray&               params)
+    const ParamArray&               params,
+    STree*                          sd_tree)
   : m_light_sampler(light_sampler)
   , m_light_path_recorder(light_path_recorder)
   , m_params(params)
+  , m_sd_tree(sd_tree)
 {
 }
 
@@ -1241,6 +1370,7 @@ ILightingEngine* PTLightingEngineFactory::create()
         new PTLightingEngine(
             m_light_sampler,
             m_light_path_recorder,
+            m_sd_tree,
             m_params);
 }
 
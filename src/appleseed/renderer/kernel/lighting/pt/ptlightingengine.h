@@ -40,6 +40,7 @@
 namespace foundation    { class Dictionary; }
 namespace renderer      { class BackwardLightSampler; }
 namespace renderer      { class LightPathRecorder; }
+namespace renderer      { class STree; }
 
 namespace renderer
 {
@@ -55,11 +56,12 @@ class PTLightingEngineFactory
     // Return parameters metadata.
     static foundation::Dictionary get_params_metadata();
 
-    // Constructor.
+    // Constructor. The SD-tree is only required when path guiding is enabled.
     PTLightingEngineFactory(
         const BackwardLightSampler&     light_sampler,
         LightPathRecorder&              light_path_recorder,
-        const ParamArray&               params);
+        const ParamArray&               params,
+        STree*                          sd_tree = nullptr);
 
     // Delete this instance.
     void release() override;
@@ -71,6 +73,7 @@ class PTLightingEngineFactory
     const BackwardLightSampler&         m_light_sampler;
     LightPathRecorder&                  m_light_path_recorder;
     ParamArray                          m_params;
+    STree*                              m_sd_tree;
 };
 
 }   // namespace renderer
@@ -0,0 +1,534 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sdtree.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// GuidingParameters class implementation.
+//
+
+GuidingParameters::GuidingParameters(const ParamArray& params)
+  : m_enabled(params.get_optional<bool>("enable_path_guiding", false))
+  , m_training_passes(params.get_optional<size_t>("guiding_training_passes", 4))
+  , m_bsdf_sampling_fraction(clamp(params.get_optional<float>("guiding_bsdf_sampling_fraction", 0.5f), 0.01f, 1.0f))
+  , m_spatial_threshold(params.get_optional<float>("guiding_spatial_threshold", 12000.0f))
+  , m_directional_threshold(params.get_optional<float>("guiding_directional_threshold", 0.01f))
+  , m_max_dtree_depth(params.get_optional<size_t>("guiding_max_dtree_depth", 20))
+  , m_max_memory(params.get_optional<size_t>("guiding_max_memory", 256) * 1024 * 1024)
+  , m_report_statistics(params.get_optional<bool>("guiding_report_statistics", false))
+{
+}
+
+
+//
+// DTree class implementation.
+//
+
+DTree::DTree()
+  : m_nodes(1, make_leaf_node())
+  , m_depth(1)
+{
+}
+
+Vector2f DTree::dir_to_canonical(const Vector3f& d)
+{
+    const float cos_theta = clamp(d.z, -1.0f, 1.0f);
+
+    float phi = atan2(d.y, d.x);
+    if (phi < 0.0f)
+        phi += TwoPi<float>();
+
+    return
+        Vector2f(
+            saturate((cos_theta + 1.0f) * 0.5f),
+            saturate(phi * RcpTwoPi<float>()));
+}
+
+Vector3f DTree::canonical_to_dir(const Vector2f& p)
+{
+    const float cos_theta = 2.0f * p.x - 1.0f;
+    const float sin_theta = sqrt(max(1.0f - cos_theta * cos_theta, 0.0f));
+    const float phi = TwoPi<float>() * p.y;
+
+    return
+        Vector3f(
+            sin_theta * cos(phi),
+            sin_theta * sin(phi),
+            cos_theta);
+}
+
+void DTree::record(
+    const Vector3f&             direction,
+    const float                 value)
+{
+    if (!(value > 0.0f))
+        return;
+
+    Vector2f p = dir_to_canonical(direction);
+    size_t node_index = 0;
+
+    while (true)
+    {
+        Node& node = m_nodes[node_index];
+
+        const size_t qx = p.x >= 0.5f ? 1 : 0;
+        const size_t qy = p.y >= 0.5f ? 1 : 0;
+        const size_t q = qx + 2 * qy;
+
+        atomic_add(&node.m_sums[q], value);
+
+        if (node.m_children[q] == 0)
+            break;
+
+        node_index = node.m_children[q];
+        p.x = 2.0f * p.x - static_cast<float>(qx);
+        p.y = 2.0f * p.y - static_cast<float>(qy);
+    }
+}
+
+Vector3f DTree::sample(
+    const Vector2f&             s,
+    float&                      pdf) const
+{
+    assert(get_total() > 0.0f);
+
+    const float OneMinusEps = 1.0f - 1.0e-6f;
+
+    Vector2f origin(0.0f);
+    float size = 1.0f;
+    float sx = min(s.x, OneMinusEps);
+    float sy = min(s.y, OneMinusEps);
+    size_t node_index = 0;
+
+    pdf = 1.0f;
+
+    while (true)
+    {
+        const Node& node = m_nodes[node_index];
+
+        // Choose the left or right half, then the top or bottom quadrant within that half.
+        const float left = node.m_sums[0] + node.m_sums[2];
+        const float right = node.m_sums[1] + node.m_sums[3];
+        const float total = left + right;
+
+        size_t qx;
+        const float px = left / total;
+        if (sx < px)
+        {
+            qx = 0;
+            sx = min(sx / px, OneMinusEps);
+        }
+        else
+        {
+            qx = 1;
+            sx = min((sx - px) / (1.0f - px), OneMinusEps);
+        }
+
+        size_t qy;
+        const float py = node.m_sums[qx] / (node.m_sums[qx] + node.m_sums[qx + 2]);
+        if (sy < py)
+        {
+            qy = 0;
+            sy = min(sy / py, OneMinusEps);
+        }
+        else
+        {
+            qy = 1;
+            sy = min((sy - py) / (1.0f - py), OneMinusEps);
+        }
+
+        const size_t q = qx + 2 * qy;
+
+        pdf *= 4.0f * node.m_sums[q] / total;
+
+        size *= 0.5f;
+        origin.x += static_cast<float>(qx) * size;
+        origin.y += static_cast<float>(qy) * size;
+
+        if (node.m_children[q] == 0)
+            break;
+
+        node_index = node.m_children[q];
+    }
+
+    pdf *= RcpFourPi<float>();
+
+    return canonical_to_dir(origin + Vector2f(sx, sy) * size);
+}
+
+float DTree::evaluate_pdf(const Vector3f& direction) const
+{
+    if (!(get_total() > 0.0f))
+        return 0.0f;
+
+    Vector2f p = dir_to_canonical(direction);
+    size_t node_index = 0;
+    float pdf = RcpFourPi<float>();
+
+    while (true)
+    {
+        const Node& node = m_nodes[node_index];
+
+        const size_t qx = p.x >= 0.5f ? 1 : 0;
+        const size_t qy = p.y >= 0.5f ? 1 : 0;
+        const size_t q = qx + 2 * qy;
+
+        if (!(node.m_sums[q] > 0.0f))
+            return 0.0f;
+
+        const float total = node.m_sums[0] + node.m_sums[1] + node.m_sums[2] + node.m_sums[3];
+        pdf *= 4.0f * node.m_sums[q] / total;
+
+        if (node.m_children[q] == 0)
+            break;
+
+        node_index = node.m_children[q];
+        p.x = 2.0f * p.x - static_cast<float>(qx);
+        p.y = 2.0f * p.y - static_cast<float>(qy);
+    }
+
+    return pdf;
+}
+
+void DTree::refine_from(
+    const DTree&                other,
+    const float                 threshold,
+    const size_t                max_depth,
+    const size_t                max_memory_size)
+{
+    struct Entry
+    {
+        size_t  m_node_index;
+        size_t  m_other_index;      // ~0 if the other tree has no node here
+        float   m_sums[4];
+        size_t  m_depth;
+    };
+
+    const size_t max_node_count = max<size_t>(max_memory_size / sizeof(Node), 1);
+    const size_t NoNode = ~size_t(0);
+
+    m_nodes.assign(1, make_leaf_node());
+    m_depth = 1;
+
+    const float total = other.get_total();
+    if (!(total > 0.0f))
+        return;
+
+    vector<Entry> stack;
+
+    Entry root;
+    root.m_node_index = 0;
+    root.m_other_index = 0;
+    copy(other.m_nodes[0].m_sums, other.m_nodes[0].m_sums + 4, root.m_sums);
+    root.m_depth = 1;
+    stack.push_back(root);
+
+    while (!stack.empty())
+    {
+        const Entry entry = stack.back();
+        stack.pop_back();
+
+        for (size_t q = 0; q < 4; ++q)
+        {
+            // Only split cells that hold a large enough fraction of the energy.
+            if (entry.m_sums[q] <= threshold * total ||
+                entry.m_depth >= max_depth ||
+                m_nodes.size() >= max_node_count)
+                continue;
+
+            const size_t child_index = m_nodes.size();
+            m_nodes.push_back(make_leaf_node());
+            m_nodes[entry.m_node_index].m_children[q] = static_cast<uint32>(child_index);
+
+            Entry child;
+            child.m_node_index = child_index;
+            child.m_depth = entry.m_depth + 1;
+
+            if (entry.m_other_index != NoNode && other.m_nodes[entry.m_other_index].m_children[q] != 0)
+            {
+                // The other tree is already subdivided here: follow its energy distribution.
+                child.m_other_index = other.m_nodes[entry.m_other_index].m_children[q];
+                copy(
+                    other.m_nodes[child.m_other_index].m_sums,
+                    other.m_nodes[child.m_other_index].m_sums + 4,
+                    child.m_sums);
+            }
+            else
+            {
+                // Assume the energy of a leaf is uniformly spread over its quadrants.
+                child.m_other_index = NoNode;
+                fill(child.m_sums, child.m_sums + 4, entry.m_sums[q] * 0.25f);
+            }
+
+            m_depth = max(m_depth, child.m_depth);
+            stack.push_back(child);
+        }
+    }
+}
+
+size_t DTree::get_memory_size() const
+{
+    return sizeof(*this) + m_nodes.capacity() * sizeof(Node);
+}
+
+DTree::Node DTree::make_leaf_node()
+{
+    Node node;
+    fill(node.m_sums, node.m_sums + 4, 0.0f);
+    fill(node.m_children, node.m_children + 4, 0);
+    return node;
+}
+
+
+//
+// STree class implementation.
+//
+
+STree::STree(
+    const AABB3f&               scene_bbox,
+    const GuidingParameters&    params)
+  : m_params(params)
+  , m_is_built(false)
+  , m_is_training(false)
+{
+    // Use a slightly enlarged cube so that all cells are cubes or half cubes.
+    Vector3f center(0.0f);
+    float half_size = 1.0f;
+    if (scene_bbox.is_valid())
+    {
+        center = scene_bbox.center();
+        half_size = max(0.5f * max_value(scene_bbox.extent()) * 1.01f, 1.0e-6f);
+    }
+
+    m_bbox = AABB3f(center - Vector3f(half_size), center + Vector3f(half_size));
+    m_rcp_extent = Vector3f(0.5f / half_size);
+
+    Node root;
+    root.m_children[0] = root.m_children[1] = 0;
+    root.m_leaf = 0;
+    root.m_axis = 0;
+    m_nodes.push_back(root);
+
+    Leaf leaf;
+    leaf.m_sample_count = 0.0f;
+    m_leaves.push_back(leaf);
+}
+
+size_t STree::find_leaf(const Vector3f& point) const
+{
+    Vector3f p = (point - m_bbox.min) * m_rcp_extent;
+    p = Vector3f(saturate(p.x), saturate(p.y), saturate(p.z));
+
+    size_t node_index = 0;
+
+    while (true)
+    {
+        const Node& node = m_nodes[node_index];
+
+        if (node.m_children[0] == 0)
+            return node.m_leaf;
+
+        float& x = p[node.m_axis];
+        if (x < 0.5f)
+        {
+            x = 2.0f * x;
+            node_index = node.m_children[0];
+        }
+        else
+        {
+            x = 2.0f * x - 1.0f;
+            node_index = node.m_children[1];
+        }
+    }
+}
+
+void STree::record(
+    const Vector3f&             point,
+    const Vector3f&             direction,
+    const float                 radiance,
+    const float                 pdf)
+{
+    if (!(pdf > 0.0f))
+        return;
+
+    Leaf& leaf = m_leaves[find_leaf(point)];
+
+    atomic_add(&leaf.m_sample_count, 1.0f);
+    leaf.m_building.record(direction, radiance / pdf);
+}
+
+void STree::refine()
+{
+    m_leaf_sample_counts = Population<uint64>();
+    for (size_t i = 0, e = m_leaves.size(); i < e; ++i)
+        m_leaf_sample_counts.insert(static_cast<uint64>(m_leaves[i].m_sample_count));
+
+    // Split spatial cells that received many samples.
+    size_t memory_size = get_memory_size();
+    subdivide(memory_size);
+
+    // Turn the distributions learned during the last pass into sampling distributions,
+    // and prepare refined empty distributions for the next pass.
+    const size_t max_dtree_memory = m_params.m_max_memory / (2 * m_leaves.size());
+    bool is_built = false;
+
+    for (size_t i = 0, e = m_leaves.size(); i < e; ++i)
+    {
+        Leaf& leaf = m_leaves[i];
+
+        // Keep the previous sampling distribution of cells that didn't receive any energy.
+        if (leaf.m_building.get_total() > 0.0f)
+            swap(leaf.m_sampling, leaf.m_building);
+
+        leaf.m_building.refine_from(
+            leaf.m_sampling,
+            m_params.m_directional_threshold,
+            m_params.m_max_dtree_depth,
+            max_dtree_memory);
+
+        leaf.m_sample_count = 0.0f;
+
+        if (leaf.m_sampling.get_total() > 0.0f)
+            is_built = true;
+    }
+
+    m_is_built = is_built;
+}
+
+void STree::subdivide(size_t& memory_size)
+{
+    vector<size_t> stack;
+
+    for (size_t i = 0, e = m_nodes.size(); i < e; ++i)
+    {
+        if (m_nodes[i].m_children[0] == 0)
+            stack.push_back(i);
+    }
+
+    while (!stack.empty())
+    {
+        const size_t node_index = stack.back();
+        stack.pop_back();
+
+        const size_t leaf_index = m_nodes[node_index].m_leaf;
+
+        if (!(m_leaves[leaf_index].m_sample_count > m_params.m_spatial_threshold))
+            continue;
+
+        // Respect the memory budget.
+        const size_t leaf_memory_size =
+            m_leaves[leaf_index].m_sampling.get_memory_size() +
+            m_leaves[leaf_index].m_building.get_memory_size() +
+            2 * sizeof(Node);
+        if (memory_size + leaf_memory_size > m_params.m_max_memory)
+            continue;
+        memory_size += leaf_memory_size;
+
+        // Both children inherit the distributions of their parent and half of its samples.
+        m_leaves[leaf_index].m_sample_count *= 0.5f;
+        const size_t new_leaf_index = m_leaves.size();
+        m_leaves.push_back(m_leaves[leaf_index]);
+
+        const uint8 axis = static_cast<uint8>((m_nodes[node_index].m_axis + 1) % 3);
+
+        Node child;
+        child.m_children[0] = child.m_children[1] = 0;
+        child.m_axis = axis;
+
+        const size_t child_index = m_nodes.size();
+
+        child.m_leaf = static_cast<uint32>(leaf_index);
+        m_nodes.push_back(child);
+
+        child.m_leaf = static_cast<uint32>(new_leaf_index);
+        m_nodes.push_back(child);
+
+        m_nodes[node_index].m_children[0] = static_cast<uint32>(child_index);
+        m_nodes[node_index].m_children[1] = static_cast<uint32>(child_index + 1);
+
+        stack.push_back(child_index);
+        stack.push_back(child_index + 1);
+    }
+}
+
+size_t STree::get_memory_size() const
+{
+    size_t size = m_nodes.capacity() * sizeof(Node);
+
+    for (size_t i = 0, e = m_leaves.size(); i < e; ++i)
+        size += m_leaves[i].m_sampling.get_memory_size() + m_leaves[i].m_building.get_memory_size();
+
+    return size;
+}
+
+StatisticsVector STree::get_statistics() const
+{
+    Population<uint64> dtree_node_counts;
+    Population<uint64> dtree_depths;
+
+    for (size_t i = 0, e = m_leaves.size(); i < e; ++i)
+    {
+        dtree_node_counts.insert(m_leaves[i].m_sampling.get_node_count());
+        dtree_depths.insert(m_leaves[i].m_sampling.get_depth());
+    }
+
+    Statistics stats;
+    stats.insert("spatial nodes", m_nodes.size());
+    stats.insert("spatial leaves", m_leaves.size());
+    stats.insert("samples per leaf", m_leaf_sample_counts);
+    stats.insert("directional nodes", dtree_node_counts);
+    stats.insert("directional depth", dtree_depths);
+    stats.insert_size("size", get_memory_size());
+    stats.insert_size("memory budget", m_params.m_max_memory);
+
+    return StatisticsVector::make("sd-tree statistics", stats);
+}
+
+}   // namespace renderer
@@ -0,0 +1,257 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/population.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// Path guiding parameters, shared by the path tracer and the SD-tree.
+//
+
+struct GuidingParameters
+{
+    const bool      m_enabled;                      // is path guiding enabled?
+    const size_t    m_training_passes;              // number of passes during which the guiding distribution is learned
+    const float     m_bsdf_sampling_fraction;       // probability of sampling the BSDF rather than the guiding distribution
+    const float     m_spatial_threshold;            // number of samples per pass above which a spatial cell is split
+    const float     m_directional_threshold;        // fraction of energy above which a directional cell is split
+    const size_t    m_max_dtree_depth;              // maximum depth of the directional quadtrees
+    const size_t    m_max_memory;                   // memory budget of the SD-tree, in bytes
+    const bool      m_report_statistics;            // print SD-tree statistics after every training pass
+
+    explicit GuidingParameters(const ParamArray& params);
+};
+
+
+//
+// Directional distribution, stored as a quadtree over the cylindrical mapping of the sphere
+// (z = cos(theta), phi) which preserves areas, so that a uniform density over the unit square
+// maps to a uniform density over the sphere.
+//
+// Recording is thread-safe as long as the structure of the tree does not change.
+//
+
+class DTree
+{
+  public:
+    // Constructor. The tree initially has a single level and a zero distribution.
+    DTree();
+
+    // Mappings between directions and the unit square.
+    static foundation::Vector2f dir_to_canonical(const foundation::Vector3f& d);
+    static foundation::Vector3f canonical_to_dir(const foundation::Vector2f& p);
+
+    // Add some energy in a given direction. Thread-safe.
+    void record(
+        const foundation::Vector3f& direction,
+        const float                 value);
+
+    // Return the total energy recorded in this tree.
+    float get_total() const;
+
+    // Sample a direction proportionally to the recorded energy.
+    // The tree must contain some energy.
+    foundation::Vector3f sample(
+        const foundation::Vector2f& s,
+        float&                      pdf) const;
+
+    // Return the solid angle density of sampling a given direction.
+    float evaluate_pdf(const foundation::Vector3f& direction) const;
+
+    // Replace the structure of this tree by a refined version of the structure of
+    // another tree: cells holding more than a given fraction of the energy are split,
+    // the others are merged. All energies are reset to zero.
+    void refine_from(
+        const DTree&                other,
+        const float                 threshold,
+        const size_t                max_depth,
+        const size_t                max_memory_size);
+
+    size_t get_node_count() const;
+    size_t get_depth() const;
+    size_t get_memory_size() const;
+
+  private:
+    struct Node
+    {
+        float               m_sums[4];      // energy of each quadrant
+        foundation::uint32  m_children[4];  // index of the child of each quadrant, 0 for leaves
+    };
+
+    std::vector<Node>       m_nodes;
+    size_t                  m_depth;
+
+    static Node make_leaf_node();
+};
+
+
+//
+// Spatio-directional tree (SD-tree): a binary tree subdividing the scene bounding box,
+// with a pair of directional distributions in each leaf. The sampling distribution is
+// used to guide paths while the building distribution learns from new samples.
+//
+// Reference:
+//
+//   Thomas Müller, Markus Gross, Jan Novák
+//   Practical Path Guiding for Efficient Light-Transport Simulation
+//   https://tom94.net/data/publications/mueller17practical/mueller17practical.pdf
+//
+
+class STree
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    STree(
+        const foundation::AABB3f&   scene_bbox,
+        const GuidingParameters&    params);
+
+    // Return true if a sampling distribution is available.
+    bool is_built() const;
+
+    // Return true if samples should be recorded.
+    bool is_training() const;
+
+    // Enable or disable the recording of samples.
+    void set_training(const bool training);
+
+    // Return the sampling distribution at a given point.
+    const DTree& get_sampling_dtree(const foundation::Vector3f& point) const;
+
+    // Record the radiance arriving at a given point from a given direction,
+    // as well as the density with which this direction was sampled. Thread-safe.
+    void record(
+        const foundation::Vector3f& point,
+        const foundation::Vector3f& direction,
+        const float                 radiance,
+        const float                 pdf);
+
+    // Refine the tree using the samples recorded during the last pass and make them the
+    // new sampling distribution. Must not be called while samples are being recorded.
+    void refine();
+
+    // Return statistics about the tree.
+    foundation::StatisticsVector get_statistics() const;
+
+  private:
+    struct Leaf
+    {
+        DTree               m_sampling;
+        DTree               m_building;
+        float               m_sample_count;
+    };
+
+    struct Node
+    {
+        foundation::uint32  m_children[2];  // 0 for leaves
+        foundation::uint32  m_leaf;         // index of the leaf, for leaves only
+        foundation::uint8   m_axis;
+    };
+
+    const GuidingParameters m_params;
+    foundation::AABB3f      m_bbox;         // cubic version of the scene bounding box
+    foundation::Vector3f    m_rcp_extent;
+    std::vector<Node>       m_nodes;
+    std::vector<Leaf>       m_leaves;
+    bool                    m_is_built;
+    bool                    m_is_training;
+    foundation::Population<foundation::uint64>
+                            m_leaf_sample_counts;   // samples recorded in each leaf during the last training pass
+
+    size_t find_leaf(const foundation::Vector3f& point) const;
+
+    size_t get_memory_size() const;
+
+    void subdivide(size_t& memory_size);
+};
+
+
+//
+// DTree class implementation.
+//
+
+inline float DTree::get_total() const
+{
+    const Node& root = m_nodes[0];
+    return root.m_sums[0] + root.m_sums[1] + root.m_sums[2] + root.m_sums[3];
+}
+
+inline size_t DTree::get_node_count() const
+{
+    return m_nodes.size();
+}
+
+inline size_t DTree::get_depth() const
+{
+    return m_depth;
+}
+
+
+//
+// STree class implementation.
+//
+
+inline bool STree::is_built() const
+{
+    return m_is_built;
+}
+
+inline bool STree::is_training() const
+{
+    return m_is_training;
+}
+
+inline void STree::set_training(const bool training)
+{
+    m_is_training = training;
+}
+
+inline const DTree& STree::get_sampling_dtree(const foundation::Vector3f& point) const
+{
+    return m_leaves[find_leaf(point)].m_sampling;
+}
+
+}   // namespace renderer
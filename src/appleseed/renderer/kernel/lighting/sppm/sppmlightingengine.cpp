@@ -39,6 +39,8 @@
 #include "renderer/kernel/lighting/sppm/sppmpasscallback.h"
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
+#include "renderer/kernel/lighting/sppm/sppmpixelstatistics.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -171,6 +173,7 @@ namespace
                 sampling_context,
                 shading_context,
                 shading_point.get_scene(),
+                pixel_context.get_pixel_coords(),
                 m_answer,
                 radiance);
 
@@ -226,8 +229,10 @@ namespace
             SamplingContext&                m_sampling_context;
             const ShadingContext&           m_shading_context;
             const EnvironmentEDF*           m_env_edf;
+            const Vector2i&                 m_pixel_coords;
             knn::Answer<float>&             m_answer;
             ShadingComponents&              m_path_radiance;
+            bool                            m_recorded_photon_count;
 
             PathVisitor(
                 const SPPMParameters&           params,
@@ -237,6 +242,7 @@ namespace
                 SamplingContext&                sampling_context,
                 const ShadingContext&           shading_context,
                 const Scene&                    scene,
+                const Vector2i&                 pixel_coords,
                 knn::Answer<float>&             answer,
                 ShadingComponents&              path_radiance)
               : m_params(params)
@@ -246,8 +252,10 @@ namespace
               , m_sampling_context(sampling_context)
               , m_shading_context(shading_context)
               , m_env_edf(scene.get_environment()->get_environment_edf())
+              , m_pixel_coords(pixel_coords)
               , m_answer(answer)
               , m_path_radiance(path_radiance)
+              , m_recorded_photon_count(false)
             {
             }
 
@@ -401,13 +409,25 @@ namespace
                     return;
 
                 const Vector3f point(vertex.get_point());
-                const float radius = m_pass_callback.get_lookup_radius();
+                const bool per_pixel_radius = m_params.m_radius_mode == SPPMParameters::PerPixelRadius;
+                const float radius =
+                    per_pixel_radius
+                        ? m_pass_callback.get_pixel_statistics().get_radius(
+                              m_pixel_coords,
+                              m_pass_callback.get_lookup_radius())
+                        : m_pass_callback.get_lookup_radius();
 
                 // Find the nearby photons around the path vertex.
-                const knn::Query3f query(photon_map, m_answer);
-                query.run(point, radius * radius);
+                photon_map.query(point, radius * radius, m_answer);
                 const size_t photon_count = m_answer.size();
 
+                // The radius of a pixel only depends on the photons found at its first visible point.
+                if (per_pixel_radius && !m_recorded_photon_count)
+                {
+                    m_pass_callback.get_pixel_statistics().record(m_pixel_coords, photon_count);
+                    m_recorded_photon_count = true;
+                }
+
                 // Compute the square radius of the lookup disk.
                 float max_square_dist;
                 if (photon_count < m_params.m_max_photons_per_estimate)
@@ -619,11 +639,11 @@ namespace
             Spectrum&               radiance)
         {
             const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
-            const knn::Query3f query(photon_map, m_answer);
 
-            query.run(
+            photon_map.query(
                 Vector3f(shading_point.get_point()),
-                square(m_params.m_view_photons_radius));
+                square(m_params.m_view_photons_radius),
+                m_answer);
 
             radiance.set(0.0f);
 
@@ -817,6 +837,50 @@ Dictionary SPPMLightingEngineFactory::get_params_metadata()
             .insert("label", "Alpha")
             .insert("help", "Evolution rate of photon gathering radius"));
 
+    metadata.dictionaries().insert(
+        "radius_mode",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "global|per_pixel")
+            .insert("default", "global")
+            .insert("label", "Radius Mode")
+            .insert("help", "Photon gathering radius reduction")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "global",
+                        Dictionary()
+                            .insert("label", "Global")
+                            .insert("help", "Shrink a single radius shared by all pixels"))
+                    .insert(
+                        "per_pixel",
+                        Dictionary()
+                            .insert("label", "Per Pixel")
+                            .insert("help", "Shrink the radius of each pixel according to the photons it gathers"))));
+
+    metadata.dictionaries().insert(
+        "photon_map",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "kdtree|hashgrid")
+            .insert("default", "kdtree")
+            .insert("label", "Photon Map")
+            .insert("help", "Spatial structure used to look up photons")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "kdtree",
+                        Dictionary()
+                            .insert("label", "Kd-Tree")
+                            .insert("help", "Store photons in a kd-tree"))
+                    .insert(
+                        "hashgrid",
+                        Dictionary()
+                            .insert("label", "Hash Grid")
+                            .insert("help", "Store photons in a hashed grid built in parallel"))));
+
     return metadata;
 }
 
@@ -93,6 +93,40 @@ namespace
             value == "rt" ? SPPMParameters::RayTraced :
             SPPMParameters::Off;
     }
+
+    SPPMParameters::PhotonMapType get_photon_map_type(
+        const ParamArray&   params,
+        const char*         name,
+        const char*         default_value)
+    {
+        const string value =
+            params.get_optional<string>(
+                name,
+                default_value,
+                make_vector("kdtree", "hashgrid"));
+
+        return
+            value == "kdtree"
+                ? SPPMParameters::KdTree
+                : SPPMParameters::HashGrid;
+    }
+
+    SPPMParameters::RadiusMode get_radius_mode(
+        const ParamArray&   params,
+        const char*         name,
+        const char*         default_value)
+    {
+        const string value =
+            params.get_optional<string>(
+                name,
+                default_value,
+                make_vector("global", "per_pixel"));
+
+        return
+            value == "global"
+                ? SPPMParameters::GlobalRadius
+                : SPPMParameters::PerPixelRadius;
+    }
 }
 
 SPPMParameters::SPPMParameters(const ParamArray& params)
@@ -113,6 +147,8 @@ SPPMParameters::SPPMParameters(const ParamArray& params)
   , m_path_tracing_has_max_ray_intensity(params.strings().exist("path_tracing_max_ray_intensity"))
   , m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
   , m_max_iterations(params.get_optional<size_t>("max_iterations", 100))
+  , m_photon_map_type(get_photon_map_type(params, "photon_map", "kdtree"))
+  , m_radius_mode(get_radius_mode(params, "radius_mode", "global"))
   , m_initial_radius_percents(params.get_optional<float>("initial_radius", 0.1f))
   , m_alpha(params.get_optional<float>("alpha", 0.7f))
   , m_max_photons_per_estimate(params.get_optional<size_t>("max_photons_per_estimate", 100))
@@ -156,6 +192,8 @@ void SPPMParameters::print() const
         "  max bounces                   %s\n"
         "  max ray intensity             %s\n"
         "  russian roulette start bounce %s\n"
+        "  photon map                    %s\n"
+        "  radius mode                   %s\n"
         "  initial radius                %s%%\n"
         "  alpha                         %s\n"
         "  max photons per estimate      %s\n"
@@ -164,6 +202,8 @@ void SPPMParameters::print() const
         m_path_tracing_max_bounces == ~size_t(0) ? "unlimited" : pretty_uint(m_path_tracing_max_bounces).c_str(),
         m_path_tracing_has_max_ray_intensity ? pretty_scalar(m_path_tracing_max_ray_intensity).c_str() : "unlimited",
         m_path_tracing_rr_min_path_length == ~size_t(0) ? "unlimited" : pretty_uint(m_path_tracing_rr_min_path_length).c_str(),
+        m_photon_map_type == KdTree ? "kd-tree" : "hash grid",
+        m_radius_mode == GlobalRadius ? "global" : "per pixel",
         pretty_scalar(m_initial_radius_percents, 3).c_str(),
         pretty_scalar(m_alpha, 1).c_str(),
         pretty_uint(m_max_photons_per_estimate).c_str(),
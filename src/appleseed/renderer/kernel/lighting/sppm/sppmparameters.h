@@ -45,6 +45,8 @@ struct SPPMParameters
 {
     enum PhotonType { Monochromatic, Polychromatic };
     enum Mode { RayTraced, SPPM, Off };
+    enum PhotonMapType { KdTree, HashGrid };
+    enum RadiusMode { GlobalRadius, PerPixelRadius };
 
     const Spectrum::Mode        m_spectrum_mode;
     const SamplingContext::Mode m_sampling_mode;
@@ -70,6 +72,8 @@ struct SPPMParameters
     const float                 m_transparency_threshold;
     const size_t                m_max_iterations;                       // maximum number of iteration during path tracing
 
+    const PhotonMapType         m_photon_map_type;                      // spatial structure used to look up photons
+    const RadiusMode            m_radius_mode;                          // shrink a single lookup radius or one radius per pixel
     const float                 m_initial_radius_percents;              // initial lookup radius as a percentage of the scene diameter
     const float                 m_alpha;                                // radius shrinking control
     const size_t                m_max_photons_per_estimate;             // maximum number of photons per density estimation
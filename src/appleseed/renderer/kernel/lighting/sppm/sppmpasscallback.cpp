@@ -39,6 +39,8 @@
 #include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
 #include "foundation/math/hash.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/job/iabortswitch.h"
@@ -98,12 +100,35 @@ void SPPMPassCallback::on_pass_begin(
     JobQueue&               job_queue,
     IAbortSwitch&           abort_switch)
 {
+    const bool per_pixel_radius = m_params.m_radius_mode == SPPMParameters::PerPixelRadius;
+
+    if (per_pixel_radius && m_pass_number == 0)
+    {
+        const CanvasProperties& props = frame.image().properties();
+        m_pixel_statistics.initialize(
+            props.m_canvas_width,
+            props.m_canvas_height,
+            m_initial_lookup_radius);
+    }
+
     if (m_initial_lookup_radius > 0.0f)
     {
-        RENDERER_LOG_INFO(
-            "sppm lookup radius is %f (%s of initial radius).",
-            m_lookup_radius,
-            pretty_percent(m_lookup_radius, m_initial_lookup_radius, 3).c_str());
+        if (per_pixel_radius)
+        {
+            RENDERER_LOG_INFO(
+                "sppm lookup radii range from %f to %f, average %f (%s of initial radius).",
+                m_pixel_statistics.get_min_radius(),
+                m_pixel_statistics.get_max_radius(),
+                m_pixel_statistics.get_avg_radius(),
+                pretty_percent(m_pixel_statistics.get_avg_radius(), m_initial_lookup_radius, 3).c_str());
+        }
+        else
+        {
+            RENDERER_LOG_INFO(
+                "sppm lookup radius is %f (%s of initial radius).",
+                m_lookup_radius,
+                pretty_percent(m_lookup_radius, m_initial_lookup_radius, 3).c_str());
+        }
     }
 
     m_stopwatch.start();
@@ -121,8 +146,17 @@ void SPPMPassCallback::on_pass_begin(
     if (abort_switch.is_aborted())
         return;
 
-    // Build a new photon map.
-    m_photon_map.reset(new SPPMPhotonMap(m_photons));
+    // Build a new photon map. Queries never use a radius larger than this one.
+    const float max_lookup_radius =
+        per_pixel_radius
+            ? m_pixel_statistics.get_max_radius()
+            : m_lookup_radius;
+    m_photon_map.reset(
+        new SPPMPhotonMap(
+            m_photons,
+            m_params.m_photon_map_type,
+            max_lookup_radius,
+            job_queue));
 }
 
 void SPPMPassCallback::on_pass_end(
@@ -135,6 +169,10 @@ void SPPMPassCallback::on_pass_end(
     assert(k <= 1.0);
     m_lookup_radius *= sqrt(k);
 
+    // Shrink the per-pixel lookup radii according to the photons they gathered.
+    if (m_params.m_radius_mode == SPPMParameters::PerPixelRadius)
+        m_pixel_statistics.update(m_params.m_alpha);
+
     m_stopwatch.measure();
 
     RENDERER_LOG_INFO(
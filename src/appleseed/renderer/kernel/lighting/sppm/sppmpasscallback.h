@@ -34,6 +34,7 @@
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
 #include "renderer/kernel/lighting/sppm/sppmphotontracer.h"
+#include "renderer/kernel/lighting/sppm/sppmpixelstatistics.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
 
 // appleseed.foundation headers.
@@ -99,9 +100,12 @@ class SPPMPassCallback
     // Return the current photon map.
     const SPPMPhotonMap& get_photon_map() const;
 
-    // Return the current lookup radius.
+    // Return the current global lookup radius.
     float get_lookup_radius() const;
 
+    // Return the per-pixel lookup radii and photon statistics.
+    const SPPMPixelStatistics& get_pixel_statistics() const;
+
   private:
     const SPPMParameters                m_params;
     SPPMPhotonTracer                    m_photon_tracer;
@@ -110,6 +114,7 @@ class SPPMPassCallback
     std::unique_ptr<SPPMPhotonMap>      m_photon_map;
     float                               m_initial_lookup_radius;
     float                               m_lookup_radius;
+    SPPMPixelStatistics                 m_pixel_statistics;
     foundation::Stopwatch<foundation::DefaultWallclockTimer>
                                         m_stopwatch;
 };
@@ -139,4 +144,9 @@ inline float SPPMPassCallback::get_lookup_radius() const
     return m_lookup_radius;
 }
 
+inline const SPPMPixelStatistics& SPPMPassCallback::get_pixel_statistics() const
+{
+    return m_pixel_statistics;
+}
+
 }   // namespace renderer
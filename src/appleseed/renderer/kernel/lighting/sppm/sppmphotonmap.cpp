@@ -25,7 +25,6 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
-//
 
 // Interface header.
 #include "sppmphotonmap.h"
@@ -35,47 +34,436 @@
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/population.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/memory.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
 // Standard headers.
-#include <cstddef>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <string>
 
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
 
-SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
+namespace
 {
-    const size_t photon_count = photons.size();
+    //
+    // Hash grid construction helpers.
+    //
+
+    // Number of photons or buckets processed by a single construction job.
+    const size_t HashGridJobSize = 64 * 1024;
 
-    if (photon_count > 0)
+    inline Vector3i compute_cell(
+        const Vector3f&             point,
+        const float                 rcp_cell_size)
     {
-        RENDERER_LOG_INFO(
-            "building sppm photon map from %s %s...",
-            pretty_uint(photon_count).c_str(),
-            photon_count > 1 ? "photons" : "photon");
-
-        knn::Builder3f builder(*this);
-        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions);
-
-        Statistics statistics;
-        statistics.insert_time("build time", builder.get_build_time());
-        statistics.insert_size("size", photons.get_memory_size());
-        statistics.merge(knn::TreeStatistics<knn::Tree3f>(*this));
-
-        RENDERER_LOG_DEBUG("%s",
-            StatisticsVector::make(
-                "sppm photon map statistics",
-                statistics).to_string().c_str());
+        return
+            Vector3i(
+                static_cast<int>(floor(point.x * rcp_cell_size)),
+                static_cast<int>(floor(point.y * rcp_cell_size)),
+                static_cast<int>(floor(point.z * rcp_cell_size)));
     }
-    else
+
+    inline uint32 hash_cell(
+        const Vector3i&             cell,
+        const uint32                bucket_mask)
+    {
+        // Reference: Optimized Spatial Hashing for Collision Detection of Deformable Objects,
+        // Matthias Teschner et al., VMV 2003.
+        return
+            ((static_cast<uint32>(cell.x) * 73856093u) ^
+             (static_cast<uint32>(cell.y) * 19349663u) ^
+             (static_cast<uint32>(cell.z) * 83492791u)) & bucket_mask;
+    }
+
+    // Compute the bucket of each photon and count the photons in each bucket.
+    class CountPhotonsJob
+      : public IJob
+    {
+      public:
+        CountPhotonsJob(
+            const vector<Vector3f>& positions,
+            const float             rcp_cell_size,
+            const uint32            bucket_mask,
+            vector<uint32>&         photon_buckets,
+            vector<uint32>&         bucket_sizes,
+            const size_t            begin,
+            const size_t            end)
+          : m_positions(positions)
+          , m_rcp_cell_size(rcp_cell_size)
+          , m_bucket_mask(bucket_mask)
+          , m_photon_buckets(photon_buckets)
+          , m_bucket_sizes(bucket_sizes)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = m_begin; i < m_end; ++i)
+            {
+                const uint32 bucket =
+                    hash_cell(
+                        compute_cell(m_positions[i], m_rcp_cell_size),
+                        m_bucket_mask);
+
+                m_photon_buckets[i] = bucket;
+                atomic_inc(&m_bucket_sizes[bucket]);
+            }
+        }
+
+      private:
+        const vector<Vector3f>&     m_positions;
+        const float                 m_rcp_cell_size;
+        const uint32                m_bucket_mask;
+        vector<uint32>&             m_photon_buckets;
+        vector<uint32>&             m_bucket_sizes;
+        const size_t                m_begin;
+        const size_t                m_end;
+    };
+
+    // Scatter photon indices to their buckets.
+    class ScatterPhotonsJob
+      : public IJob
+    {
+      public:
+        ScatterPhotonsJob(
+            const vector<uint32>&   photon_buckets,
+            vector<uint32>&         bucket_cursors,
+            vector<uint32>&         indices,
+            const size_t            begin,
+            const size_t            end)
+          : m_photon_buckets(photon_buckets)
+          , m_bucket_cursors(bucket_cursors)
+          , m_indices(indices)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = m_begin; i < m_end; ++i)
+            {
+                const uint32 slot = atomic_inc(&m_bucket_cursors[m_photon_buckets[i]]);
+                m_indices[slot] = static_cast<uint32>(i);
+            }
+        }
+
+      private:
+        const vector<uint32>&       m_photon_buckets;
+        vector<uint32>&             m_bucket_cursors;
+        vector<uint32>&             m_indices;
+        const size_t                m_begin;
+        const size_t                m_end;
+    };
+
+    // Sort the photons of each bucket by index so that the grid doesn't depend on
+    // thread scheduling, then gather their positions.
+    class SortBucketsJob
+      : public IJob
+    {
+      public:
+        SortBucketsJob(
+            const vector<Vector3f>& positions,
+            const vector<uint32>&   bucket_offsets,
+            vector<uint32>&         indices,
+            vector<Vector3f>&       points,
+            const size_t            begin,
+            const size_t            end)
+          : m_positions(positions)
+          , m_bucket_offsets(bucket_offsets)
+          , m_indices(indices)
+          , m_points(points)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t b = m_begin; b < m_end; ++b)
+            {
+                const size_t slot_begin = m_bucket_offsets[b];
+                const size_t slot_end = m_bucket_offsets[b + 1];
+
+                sort(&m_indices[0] + slot_begin, &m_indices[0] + slot_end);
+
+                for (size_t i = slot_begin; i < slot_end; ++i)
+                    m_points[i] = m_positions[m_indices[i]];
+            }
+        }
+
+      private:
+        const vector<Vector3f>&     m_positions;
+        const vector<uint32>&       m_bucket_offsets;
+        vector<uint32>&             m_indices;
+        vector<Vector3f>&           m_points;
+        const size_t                m_begin;
+        const size_t                m_end;
+    };
+
+    inline void insert_photon(
+        knn::Answer<float>&         answer,
+        const size_t                index,
+        const float                 square_dist,
+        float&                      max_square_dist)
+    {
+        if (answer.size() < answer.max_size())
+        {
+            answer.array_insert(index, square_dist);
+
+            if (answer.size() == answer.max_size())
+            {
+                answer.make_heap();
+                max_square_dist = answer.top().m_square_dist;
+            }
+        }
+        else
+        {
+            answer.heap_insert(index, square_dist);
+            max_square_dist = answer.top().m_square_dist;
+        }
+    }
+}
+
+
+//
+// SPPMPhotonMap class implementation.
+//
+
+SPPMPhotonMap::SPPMPhotonMap(
+    SPPMPhotonVector&                   photons,
+    const SPPMParameters::PhotonMapType type,
+    const float                         max_lookup_radius,
+    JobQueue&                           job_queue)
+  : m_type(type)
+  , m_cell_size(0.0f)
+  , m_rcp_cell_size(0.0f)
+  , m_bucket_mask(0)
+{
+    const size_t photon_count = photons.size();
+
+    if (photon_count == 0)
     {
         RENDERER_LOG_WARNING(
             "cannot build sppm photon map because no photon were stored by the photon tracing pass.");
+        return;
+    }
+
+    // The hash grid needs a positive cell size.
+    if (m_type == SPPMParameters::HashGrid && !(max_lookup_radius > 0.0f))
+    {
+        RENDERER_LOG_WARNING("sppm lookup radius is zero, falling back to a kd-tree photon map.");
+        m_type = SPPMParameters::KdTree;
+    }
+
+    RENDERER_LOG_INFO(
+        "building sppm %s from %s %s...",
+        m_type == SPPMParameters::KdTree ? "photon map" : "photon hash grid",
+        pretty_uint(photon_count).c_str(),
+        photon_count > 1 ? "photons" : "photon");
+
+    if (m_type == SPPMParameters::KdTree)
+        build_kdtree(photons);
+    else
+        build_hash_grid(photons, max_lookup_radius, job_queue);
+}
+
+void SPPMPhotonMap::build_kdtree(SPPMPhotonVector& photons)
+{
+    knn::Builder3f builder(m_tree);
+    builder.build_move_points<DefaultWallclockTimer>(photons.m_positions);
+
+    Statistics statistics;
+    statistics.insert_time("build time", builder.get_build_time());
+    statistics.insert_size("size", photons.get_memory_size());
+    statistics.merge(knn::TreeStatistics<knn::Tree3f>(m_tree));
+
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "sppm photon map statistics",
+            statistics).to_string().c_str());
+}
+
+void SPPMPhotonMap::build_hash_grid(
+    SPPMPhotonVector&                   photons,
+    const float                         max_lookup_radius,
+    JobQueue&                           job_queue)
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    const vector<Vector3f>& positions = photons.m_positions;
+    const size_t photon_count = positions.size();
+
+    // A query of radius r centered anywhere touches at most 2x2x2 cells.
+    m_cell_size = 2.0f * max_lookup_radius;
+    m_rcp_cell_size = 1.0f / m_cell_size;
+
+    // Use roughly one bucket per photon.
+    const size_t bucket_count = next_pow2(photon_count);
+    m_bucket_mask = static_cast<uint32>(bucket_count - 1);
+
+    // Compute the bucket of each photon and the size of each bucket.
+    vector<uint32> photon_buckets(photon_count);
+    vector<uint32> bucket_sizes(bucket_count, 0);
+    for (size_t i = 0; i < photon_count; i += HashGridJobSize)
+    {
+        job_queue.schedule(
+            new CountPhotonsJob(
+                positions,
+                m_rcp_cell_size,
+                m_bucket_mask,
+                photon_buckets,
+                bucket_sizes,
+                i,
+                min(i + HashGridJobSize, photon_count)));
+    }
+    job_queue.wait_until_completion();
+
+    // Compute the offset of each bucket.
+    m_bucket_offsets.resize(bucket_count + 1);
+    m_bucket_offsets[0] = 0;
+    for (size_t b = 0; b < bucket_count; ++b)
+        m_bucket_offsets[b + 1] = m_bucket_offsets[b] + bucket_sizes[b];
+
+    // Scatter photon indices to their buckets.
+    vector<uint32>& bucket_cursors = bucket_sizes;
+    copy(m_bucket_offsets.begin(), m_bucket_offsets.end() - 1, bucket_cursors.begin());
+    m_indices.resize(photon_count);
+    for (size_t i = 0; i < photon_count; i += HashGridJobSize)
+    {
+        job_queue.schedule(
+            new ScatterPhotonsJob(
+                photon_buckets,
+                bucket_cursors,
+                m_indices,
+                i,
+                min(i + HashGridJobSize, photon_count)));
+    }
+    job_queue.wait_until_completion();
+
+    // Sort photons within buckets and gather their positions.
+    m_points.resize(photon_count);
+    for (size_t b = 0; b < bucket_count; b += HashGridJobSize)
+    {
+        job_queue.schedule(
+            new SortBucketsJob(
+                positions,
+                m_bucket_offsets,
+                m_indices,
+                m_points,
+                b,
+                min(b + HashGridJobSize, bucket_count)));
+    }
+    job_queue.wait_until_completion();
+
+    // The photon positions now live in the grid.
+    clear_keep_memory(photons.m_positions);
+
+    stopwatch.measure();
+
+    Population<uint64> bucket_occupancy;
+    for (size_t b = 0; b < bucket_count; ++b)
+    {
+        const uint32 size = m_bucket_offsets[b + 1] - m_bucket_offsets[b];
+        if (size > 0)
+            bucket_occupancy.insert(size);
+    }
+
+    Statistics statistics;
+    statistics.insert_time("build time", stopwatch.get_seconds());
+    statistics.insert_size(
+        "size",
+        photons.get_memory_size() +
+        m_points.capacity() * sizeof(Vector3f) +
+        m_indices.capacity() * sizeof(uint32) +
+        m_bucket_offsets.capacity() * sizeof(uint32));
+    statistics.insert("cell size", m_cell_size);
+    statistics.insert("buckets", bucket_count);
+    statistics.insert_percent("occupied buckets", static_cast<uint64>(bucket_occupancy.get_size()), static_cast<uint64>(bucket_count));
+    statistics.insert("photons per bucket", bucket_occupancy);
+
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "sppm photon hash grid statistics",
+            statistics).to_string().c_str());
+}
+
+void SPPMPhotonMap::query_hash_grid(
+    const Vector3f&                     point,
+    const float                         max_square_dist,
+    knn::Answer<float>&                 answer) const
+{
+    answer.clear();
+
+    if (m_points.empty())
+        return;
+
+    const float radius = sqrt(max_square_dist);
+    const Vector3i min_cell = compute_cell(point - Vector3f(radius), m_rcp_cell_size);
+    const Vector3i max_cell = compute_cell(point + Vector3f(radius), m_rcp_cell_size);
+
+    float query_max_square_dist = max_square_dist;
+
+    const Vector3i extent = max_cell - min_cell + Vector3i(1);
+    const size_t cell_count =
+        static_cast<size_t>(extent.x) *
+        static_cast<size_t>(extent.y) *
+        static_cast<size_t>(extent.z);
+
+    if (cell_count > m_points.size())
+    {
+        // Queries much larger than the lookup radius (e.g. when viewing photons)
+        // are cheaper to answer by visiting every photon.
+        for (size_t i = 0, e = m_points.size(); i < e; ++i)
+        {
+            const float square_dist = square_distance(m_points[i], point);
+            if (square_dist < query_max_square_dist)
+                insert_photon(answer, i, square_dist, query_max_square_dist);
+        }
+
+        return;
+    }
+
+    for (int z = min_cell.z; z <= max_cell.z; ++z)
+    {
+        for (int y = min_cell.y; y <= max_cell.y; ++y)
+        {
+            for (int x = min_cell.x; x <= max_cell.x; ++x)
+            {
+                const Vector3i cell(x, y, z);
+                const uint32 bucket = hash_cell(cell, m_bucket_mask);
+
+                for (size_t i = m_bucket_offsets[bucket], e = m_bucket_offsets[bucket + 1]; i < e; ++i)
+                {
+                    const Vector3f& p = m_points[i];
+
+                    // Skip photons of other cells sharing this bucket.
+                    if (compute_cell(p, m_rcp_cell_size) != cell)
+                        continue;
+
+                    const float square_dist = square_distance(p, point);
+                    if (square_dist < query_max_square_dist)
+                        insert_photon(answer, i, square_dist, query_max_square_dist);
+                }
+            }
+        }
     }
 }
 
@@ -25,25 +25,128 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
-//
 
 #pragma once
 
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sppm/sppmparameters.h"
+
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/knn.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
 
 // Forward declarations.
-namespace renderer  { class SPPMPhotonVector; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class SPPMPhotonVector; }
 
 namespace renderer
 {
 
+//
+// The SPPM photon map.
+//
+// Photons are stored either in a kd-tree (best for variable-radius k-nearest
+// neighbor queries) or in a hashed uniform grid whose cells are as large as the
+// lookup diameter (best for the fixed-radius queries SPPM performs once the radius
+// has shrunk). The hash grid is built in parallel using the job queue.
+//
+// Reference for the hash grid:
+//
+//   Toshiya Hachisuka, Henrik Wann Jensen
+//   Stochastic Progressive Photon Mapping
+//   http://graphics.ucsd.edu/~henrik/papers/sppm/stochastic_progressive_photon_mapping.pdf
+//
+
 class SPPMPhotonMap
-  : public foundation::knn::Tree3f
+  : public foundation::NonCopyable
 {
   public:
     // Constructor, *moves* the photon positions into the map.
-    explicit SPPMPhotonMap(SPPMPhotonVector& photons);
+    // max_lookup_radius is the largest radius that will be used in queries.
+    SPPMPhotonMap(
+        SPPMPhotonVector&                   photons,
+        const SPPMParameters::PhotonMapType type,
+        const float                         max_lookup_radius,
+        foundation::JobQueue&               job_queue);
+
+    // Return true if the photon map doesn't contain any photon.
+    bool empty() const;
+
+    // Convert an index returned by a query to an index into the photon vector.
+    size_t remap(const size_t i) const;
+
+    // Find the photons closest to a given point, within a given square distance.
+    void query(
+        const foundation::Vector3f&         point,
+        const float                         max_square_dist,
+        foundation::knn::Answer<float>&     answer) const;
+
+  private:
+    SPPMParameters::PhotonMapType           m_type;
+
+    // Kd-tree.
+    foundation::knn::Tree3f                 m_tree;
+
+    // Hash grid.
+    float                                   m_cell_size;
+    float                                   m_rcp_cell_size;
+    foundation::uint32                      m_bucket_mask;
+    std::vector<foundation::uint32>         m_bucket_offsets;   // bucket_count + 1 entries
+    std::vector<foundation::Vector3f>       m_points;           // photon positions sorted by bucket
+    std::vector<foundation::uint32>         m_indices;          // original index of each sorted photon
+
+    void build_kdtree(SPPMPhotonVector& photons);
+
+    void build_hash_grid(
+        SPPMPhotonVector&                   photons,
+        const float                         max_lookup_radius,
+        foundation::JobQueue&               job_queue);
+
+    void query_hash_grid(
+        const foundation::Vector3f&         point,
+        const float                         max_square_dist,
+        foundation::knn::Answer<float>&     answer) const;
 };
 
+
+//
+// SPPMPhotonMap class implementation.
+//
+
+inline bool SPPMPhotonMap::empty() const
+{
+    return
+        m_type == SPPMParameters::KdTree
+            ? m_tree.empty()
+            : m_points.empty();
+}
+
+inline size_t SPPMPhotonMap::remap(const size_t i) const
+{
+    return
+        m_type == SPPMParameters::KdTree
+            ? m_tree.remap(i)
+            : m_indices[i];
+}
+
+inline void SPPMPhotonMap::query(
+    const foundation::Vector3f&             point,
+    const float                             max_square_dist,
+    foundation::knn::Answer<float>&         answer) const
+{
+    if (m_type == SPPMParameters::KdTree)
+    {
+        const foundation::knn::Query3f query(m_tree, answer);
+        query.run(point, max_square_dist);
+    }
+    else
+        query_hash_grid(point, max_square_dist, answer);
+}
+
 }   // namespace renderer
@@ -0,0 +1,148 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sppmpixelstatistics.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// SPPMPixelStatistics class implementation.
+//
+
+SPPMPixelStatistics::SPPMPixelStatistics()
+  : m_width(0)
+  , m_height(0)
+  , m_min_radius(0.0f)
+  , m_avg_radius(0.0f)
+  , m_max_radius(0.0f)
+{
+}
+
+void SPPMPixelStatistics::initialize(
+    const size_t                    width,
+    const size_t                    height,
+    const float                     initial_radius)
+{
+    const size_t pixel_count = width * height;
+
+    m_width = width;
+    m_height = height;
+
+    m_radii.assign(pixel_count, initial_radius);
+    m_accumulated_photons.assign(pixel_count, 0.0f);
+    m_pass_photons.assign(pixel_count, 0.0f);
+    m_pass_paths.assign(pixel_count, 0.0f);
+
+    m_min_radius = initial_radius;
+    m_avg_radius = initial_radius;
+    m_max_radius = initial_radius;
+}
+
+void SPPMPixelStatistics::record(
+    const Vector2i&                 pi,
+    const size_t                    photon_count) const
+{
+    if (pi.x < 0 || pi.y < 0 ||
+        static_cast<size_t>(pi.x) >= m_width ||
+        static_cast<size_t>(pi.y) >= m_height)
+        return;
+
+    const size_t index = pi.y * m_width + pi.x;
+
+    atomic_add(&m_pass_paths[index], 1.0f);
+
+    if (photon_count > 0)
+        atomic_add(&m_pass_photons[index], static_cast<float>(photon_count));
+}
+
+void SPPMPixelStatistics::update(const float alpha)
+{
+    assert(alpha > 0.0f && alpha <= 1.0f);
+
+    for (size_t i = 0, e = m_radii.size(); i < e; ++i)
+    {
+        const float path_count = m_pass_paths[i];
+
+        if (path_count > 0.0f)
+        {
+            // Average number of photons gathered by a path through this pixel.
+            const float m = m_pass_photons[i] / path_count;
+
+            if (m > 0.0f)
+            {
+                // Keep only a fraction alpha of the new photons and shrink the radius accordingly.
+                const float n = m_accumulated_photons[i];
+                const float new_n = n + alpha * m;
+                m_radii[i] *= sqrt(new_n / (n + m));
+                m_accumulated_photons[i] = new_n;
+            }
+        }
+
+        m_pass_photons[i] = 0.0f;
+        m_pass_paths[i] = 0.0f;
+    }
+
+    update_radius_range();
+}
+
+void SPPMPixelStatistics::update_radius_range()
+{
+    if (m_radii.empty())
+        return;
+
+    float min_radius = m_radii[0];
+    float max_radius = m_radii[0];
+    double sum = 0.0;
+
+    for (size_t i = 0, e = m_radii.size(); i < e; ++i)
+    {
+        min_radius = min(min_radius, m_radii[i]);
+        max_radius = max(max_radius, m_radii[i]);
+        sum += m_radii[i];
+    }
+
+    m_min_radius = min_radius;
+    m_avg_radius = static_cast<float>(sum / m_radii.size());
+    m_max_radius = max_radius;
+}
+
+}   // namespace renderer
@@ -0,0 +1,144 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// Per-pixel lookup radii for SPPM.
+//
+// Each pixel keeps its own lookup radius and accumulated photon count. During a
+// pass, the lighting engine records how many photons each camera path gathered;
+// at the end of the pass, the radius of each pixel is reduced according to the
+// progressive photon mapping rule, so that pixels that receive many photons
+// converge faster than pixels in dimly lit regions.
+//
+// Reference:
+//
+//   Toshiya Hachisuka, Shinji Ogaki, Henrik Wann Jensen
+//   Progressive Photon Mapping
+//   http://graphics.ucsd.edu/~henrik/papers/progressive_photon_mapping/progressive_photon_mapping.pdf
+//
+
+class SPPMPixelStatistics
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    SPPMPixelStatistics();
+
+    // (Re)initialize all pixels with a given radius.
+    void initialize(
+        const size_t                width,
+        const size_t                height,
+        const float                 initial_radius);
+
+    // Return true if the statistics have been initialized.
+    bool is_initialized() const;
+
+    // Return the lookup radius of a given pixel, or fallback_radius if the pixel is outside the frame.
+    float get_radius(
+        const foundation::Vector2i& pi,
+        const float                 fallback_radius) const;
+
+    // Return the smallest, average and largest radii across all pixels.
+    float get_min_radius() const;
+    float get_avg_radius() const;
+    float get_max_radius() const;
+
+    // Record the number of photons gathered by a camera path. Thread-safe.
+    void record(
+        const foundation::Vector2i& pi,
+        const size_t                photon_count) const;
+
+    // Shrink the radius of every pixel that gathered photons during the last pass.
+    void update(const float alpha);
+
+  private:
+    size_t                          m_width;
+    size_t                          m_height;
+    std::vector<float>              m_radii;
+    std::vector<float>              m_accumulated_photons;      // N in the PPM paper
+    mutable std::vector<float>      m_pass_photons;             // photons gathered during the current pass
+    mutable std::vector<float>      m_pass_paths;               // camera paths traced during the current pass
+    float                           m_min_radius;
+    float                           m_avg_radius;
+    float                           m_max_radius;
+
+    void update_radius_range();
+};
+
+
+//
+// SPPMPixelStatistics class implementation.
+//
+
+inline bool SPPMPixelStatistics::is_initialized() const
+{
+    return !m_radii.empty();
+}
+
+inline float SPPMPixelStatistics::get_radius(
+    const foundation::Vector2i&     pi,
+    const float                     fallback_radius) const
+{
+    if (pi.x < 0 || pi.y < 0 ||
+        static_cast<size_t>(pi.x) >= m_width ||
+        static_cast<size_t>(pi.y) >= m_height)
+        return fallback_radius;
+
+    return m_radii[pi.y * m_width + pi.x];
+}
+
+inline float SPPMPixelStatistics::get_min_radius() const
+{
+    return m_min_radius;
+}
+
+inline float SPPMPixelStatistics::get_avg_radius() const
+{
+    return m_avg_radius;
+}
+
+inline float SPPMPixelStatistics::get_max_radius() const
+{
+    return m_max_radius;
+}
+
+}   // namespace renderer
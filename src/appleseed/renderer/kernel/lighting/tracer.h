@@ -31,6 +31,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
@@ -41,6 +42,7 @@
 #include "foundation/math/vector.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 
 // Forward declarations.
@@ -115,6 +117,25 @@ class Tracer
         const ShadingRay::DepthType     ray_depth,
         Spectrum&                       transmission);
 
+    // Compute the transmission between a point and a batch of targets.
+    // Rays toward the targets are traced in packets when possible.
+    void trace_between_simple(
+        const ShadingContext&           shading_context,
+        const ShadingPoint&             origin,
+        const foundation::Vector3d*     targets,
+        const size_t                    target_count,
+        const ShadingRay&               parent_ray,
+        const VisibilityFlags::Type     ray_flags,
+        Spectrum*                       transmissions);
+    void trace_between_simple(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d&     origin,
+        const foundation::Vector3d*     targets,
+        const size_t                    target_count,
+        const ShadingRay&               parent_ray,
+        const VisibilityFlags::Type     ray_flags,
+        Spectrum*                       transmissions);
+
     // Compute the transmission in a given direction.
     // Returns the intersection with the closest fully opaque occluder
     // and the transmission factor up to (but excluding) this occluder,
@@ -188,6 +209,12 @@ class Tracer
         const Material&                 material,
         const ShadingPoint&             shading_point,
         Alpha&                          alpha) const;
+
+    void trace_probe_packet(
+        const ShadingRay*               rays,
+        const size_t                    ray_count,
+        const ShadingPoint*             parent_shading_point,
+        Spectrum*                       transmissions) const;
 };
 
 
@@ -397,6 +424,108 @@ inline void Tracer::trace_between_simple(
     }
 }
 
+inline void Tracer::trace_between_simple(
+    const ShadingContext&               shading_context,
+    const ShadingPoint&                 origin,
+    const foundation::Vector3d*         targets,
+    const size_t                        target_count,
+    const ShadingRay&                   parent_ray,
+    const VisibilityFlags::Type         ray_flags,
+    Spectrum*                           transmissions)
+{
+    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    {
+        ShadingRay rays[RayPacketSize];
+
+        for (size_t i = 0; i < target_count; i += RayPacketSize)
+        {
+            const size_t ray_count = std::min(target_count - i, RayPacketSize);
+
+            for (size_t j = 0; j < ray_count; ++j)
+            {
+                const foundation::Vector3d direction = targets[i + j] - origin.get_point();
+                const double dist = foundation::norm(direction);
+
+                rays[j] =
+                    ShadingRay(
+                        origin.get_biased_point(direction),
+                        direction / dist,
+                        0.0,                        // ray tmin
+                        dist * (1.0 - 1.0e-6),      // ray tmax
+                        parent_ray.m_time,
+                        ray_flags,
+                        parent_ray.m_depth);
+            }
+
+            trace_probe_packet(rays, ray_count, &origin, transmissions + i);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < target_count; ++i)
+        {
+            trace_between_simple(
+                shading_context,
+                origin,
+                targets[i],
+                parent_ray,
+                ray_flags,
+                transmissions[i]);
+        }
+    }
+}
+
+inline void Tracer::trace_between_simple(
+    const ShadingContext&               shading_context,
+    const foundation::Vector3d&         origin,
+    const foundation::Vector3d*         targets,
+    const size_t                        target_count,
+    const ShadingRay&                   parent_ray,
+    const VisibilityFlags::Type         ray_flags,
+    Spectrum*                           transmissions)
+{
+    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    {
+        ShadingRay rays[RayPacketSize];
+
+        for (size_t i = 0; i < target_count; i += RayPacketSize)
+        {
+            const size_t ray_count = std::min(target_count - i, RayPacketSize);
+
+            for (size_t j = 0; j < ray_count; ++j)
+            {
+                const foundation::Vector3d direction = targets[i + j] - origin;
+                const double dist = foundation::norm(direction);
+
+                rays[j] =
+                    ShadingRay(
+                        origin,
+                        direction / dist,
+                        0.0,                        // ray tmin
+                        dist * (1.0 - 1.0e-6),      // ray tmax
+                        parent_ray.m_time,
+                        ray_flags,
+                        parent_ray.m_depth);
+            }
+
+            trace_probe_packet(rays, ray_count, nullptr, transmissions + i);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < target_count; ++i)
+        {
+            trace_between_simple(
+                shading_context,
+                origin,
+                targets[i],
+                parent_ray,
+                ray_flags,
+                transmissions[i]);
+        }
+    }
+}
+
 inline const ShadingPoint& Tracer::trace_full(
     const ShadingContext&               shading_context,
     const ShadingRay&                   ray,
@@ -542,4 +671,17 @@ inline const ShadingPoint& Tracer::trace_between_full(
             nullptr);
 }
 
+inline void Tracer::trace_probe_packet(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    const ShadingPoint*                 parent_shading_point,
+    Spectrum*                           transmissions) const
+{
+    bool hits[RayPacketSize];
+    m_intersector.trace_probe(rays, ray_count, hits, parent_shading_point);
+
+    for (size_t i = 0; i < ray_count; ++i)
+        transmissions[i].set(hits[i] ? 0.0f : 1.0f);
+}
+
 }   // namespace renderer
@@ -226,55 +226,60 @@ void VolumeLightingIntegrator::add_single_distance_sample_contribution(
             draw_exponential_sample(sampling_context, m_volume_ray, extinction_coef[channel]);
         const float exponential_prob =
             evaluate_exponential_sample(exponential_sample, m_volume_ray, extinction_coef[channel]);
-        const float equiangular_prob =
-            equiangular_distance_sampler.evaluate(exponential_sample);
 
-        // Calculate MIS weight for spectral channel sampling (power heuristic).
-        // One-sample estimator is used (Veach: 9.2.4 eq. 9.15).
-        float mis_weights_sum = 0.0f;
-        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+        // The majorant of a heterogeneous volume may vanish along the whole ray.
+        if (exponential_prob > 0.0f)
         {
-            if (extinction_coef[i] > 0.0f)
+            const float equiangular_prob =
+                equiangular_distance_sampler.evaluate(exponential_sample);
+
+            // Calculate MIS weight for spectral channel sampling (power heuristic).
+            // One-sample estimator is used (Veach: 9.2.4 eq. 9.15).
+            float mis_weights_sum = 0.0f;
+            for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
             {
-                const float probability =
-                    evaluate_exponential_sample(
-                        exponential_sample,
-                        m_volume_ray,
-                        extinction_coef[i]);
-                mis_weights_sum += square(probability);
+                if (extinction_coef[i] > 0.0f)
+                {
+                    const float probability =
+                        evaluate_exponential_sample(
+                            exponential_sample,
+                            m_volume_ray,
+                            extinction_coef[i]);
+                    mis_weights_sum += square(probability);
+                }
             }
+            const float mis_weight_channel =
+                Spectrum::size() *
+                square(exponential_prob) /
+                mis_weights_sum;
+
+            // Calculate MIS weight for distance sampling.
+            const float mis_weight_distance = mis(
+                mis_heuristic, exponential_prob, equiangular_prob);
+
+            DirectShadingComponents inscattered;
+            take_single_direction_sample(
+                sample_phase_function,
+                sampling_context,
+                light_sample,
+                exponential_sample,
+                mis_heuristic,
+                inscattered);
+
+            Spectrum transmission;
+            m_volume.evaluate_transmission(
+                m_volume_data,
+                m_volume_ray,
+                exponential_sample,
+                transmission);
+            inscattered *= transmission;
+            inscattered *=
+                m_rcp_distance_sample_count *
+                mis_weight_channel *
+                mis_weight_distance /
+                exponential_prob;
+            radiance += inscattered;
         }
-        const float mis_weight_channel =
-            Spectrum::size() *
-            square(exponential_prob) /
-            mis_weights_sum;
-
-        // Calculate MIS weight for distance sampling.
-        const float mis_weight_distance = mis(
-            mis_heuristic, exponential_prob, equiangular_prob);
-
-        DirectShadingComponents inscattered;
-        take_single_direction_sample(
-            sample_phase_function,
-            sampling_context,
-            light_sample,
-            exponential_sample,
-            mis_heuristic,
-            inscattered);
-
-        Spectrum transmission;
-        m_volume.evaluate_transmission(
-            m_volume_data,
-            m_volume_ray,
-            exponential_sample,
-            transmission);
-        inscattered *= transmission;
-        inscattered *=
-            m_rcp_distance_sample_count *
-            mis_weight_channel *
-            mis_weight_distance /
-            exponential_prob;
-        radiance += inscattered;
     }
 
     //
@@ -333,6 +338,8 @@ void VolumeLightingIntegrator::add_single_distance_sample_contribution_exponenti
         sampling_context, m_volume_ray, extinction_coef[channel]);
     const float exponential_prob = evaluate_exponential_sample(
         exponential_sample, m_volume_ray, extinction_coef[channel]);
+    if (exponential_prob == 0.0f)
+        return;
 
     // Calculate MIS weight for spectral channel sampling (balance heuristic).
     // One-sample estimator is used (Veach: 9.2.4 eq. 9.15).
@@ -419,33 +426,39 @@ void VolumeLightingIntegrator::compute_radiance_combined_sampling(
         for (size_t i = 0; i < m_distance_sample_count; ++i)
         {
             // Sample the light set.
-            LightSample light_sample;
-            m_light_sampler.sample_lightset(
-                m_time,
-                child_sampling_context.next2<Vector3f>(),
-                m_shading_point,
-                light_sample);
-
-            for (size_t j = 0; j < m_light_sample_count; ++j)
+            LightSample light_samples[BackwardLightSampler::MaxLightSetSampleCount];
+            const size_t light_sample_count =
+                m_light_sampler.sample_lightset(
+                    m_time,
+                    child_sampling_context.next2<Vector3f>(),
+                    m_shading_point,
+                    light_samples);
+
+            for (size_t k = 0; k < light_sample_count; ++k)
             {
-                add_single_distance_sample_contribution(
-                    &light_sample,
-                    extinction_coef,
-                    sampling_context,
-                    mis_heuristic,
-                    radiance,
-                    false);
-            }
-
-            if (!ScatteringMode::has_volume(m_scattering_modes))
-            {
-                add_single_distance_sample_contribution(
-                    &light_sample,
-                    extinction_coef,
-                    sampling_context,
-                    mis_heuristic,
-                    radiance,
-                    true);
+                const LightSample& light_sample = light_samples[k];
+
+                for (size_t j = 0; j < m_light_sample_count; ++j)
+                {
+                    add_single_distance_sample_contribution(
+                        &light_sample,
+                        extinction_coef,
+                        sampling_context,
+                        mis_heuristic,
+                        radiance,
+                        false);
+                }
+
+                if (!ScatteringMode::has_volume(m_scattering_modes))
+                {
+                    add_single_distance_sample_contribution(
+                        &light_sample,
+                        extinction_coef,
+                        sampling_context,
+                        mis_heuristic,
+                        radiance,
+                        true);
+                }
             }
         }
     }
@@ -557,20 +570,36 @@ void VolumeLightingIntegrator::take_single_direction_sample(
     else if (light_sample == nullptr || light_sample->m_shape != nullptr)
     {
         sampling_context.split_in_place(3, 1);
-        LightSample light_sample;
-        m_light_sampler.sample_lightset(
-            m_time,
-            sampling_context.next2<Vector3f>(),
-            m_shading_point,
-            light_sample);
-
-        integrator.add_emitting_shape_sample_contribution(
-            sampling_context,
-            light_sample,
-            mis_heuristic,
-            Dual3d(m_volume_ray.m_dir),
-            radiance,
-            nullptr);
+        LightSample light_samples[BackwardLightSampler::MaxLightSetSampleCount];
+        const size_t light_sample_count =
+            m_light_sampler.sample_lightset(
+                m_time,
+                sampling_context.next2<Vector3f>(),
+                m_shading_point,
+                light_samples);
+
+        for (size_t i = 0; i < light_sample_count; ++i)
+        {
+            if (light_samples[i].m_shape != nullptr)
+            {
+                integrator.add_emitting_shape_sample_contribution(
+                    sampling_context,
+                    light_samples[i],
+                    mis_heuristic,
+                    Dual3d(m_volume_ray.m_dir),
+                    radiance,
+                    nullptr);
+            }
+            else
+            {
+                integrator.add_non_physical_light_sample_contribution(
+                    sampling_context,
+                    light_samples[i],
+                    Dual3d(m_volume_ray.m_dir),
+                    radiance,
+                    nullptr);
+            }
+        }
     }
     else
     {
@@ -590,6 +619,19 @@ float VolumeLightingIntegrator::draw_exponential_sample(
 {
     sampling_context.split_in_place(1, 1);
 
+    if (!m_volume.is_homogeneous())
+    {
+        // Sample the majorant of the volume, which skips empty space.
+        float distance;
+        return
+            m_volume.sample_majorant_distance(
+                m_volume_data,
+                volume_ray,
+                extinction,
+                sampling_context.next2<float>(),
+                distance) ? distance : 0.0f;
+    }
+
     if (!volume_ray.is_finite())
     {
         return sample_exponential_distribution(
@@ -610,6 +652,15 @@ float VolumeLightingIntegrator::evaluate_exponential_sample(
 {
     if (extinction == 0.0f)
         return static_cast<float>(1.0 / m_volume_ray.get_length());
+    if (!m_volume.is_homogeneous())
+    {
+        return
+            m_volume.evaluate_majorant_distance_pdf(
+                m_volume_data,
+                volume_ray,
+                extinction,
+                distance);
+    }
     if (!volume_ray.is_finite())
         return exponential_distribution_pdf(distance, extinction);
     else
@@ -0,0 +1,552 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "checkpointjournal.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/tile.h"
+#include "foundation/utility/cc.h"
+#include "foundation/utility/siphash.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace foundation;
+using namespace std;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+namespace
+{
+    const uint32 JournalMagic = CC32('A', 'S', 'C', 'J');
+    const uint32 JournalVersion = 1;
+
+    const uint32 TileRecordType = CC32('T', 'I', 'L', 'E');
+    const uint32 PassRecordType = CC32('P', 'A', 'S', 'S');
+
+    // Compact the journal when it holds that many records per tile on average.
+    const size_t CompactionRatio = 4;
+
+    struct RecordHeader
+    {
+        uint32  m_type;
+        uint32  m_pass;
+        uint32  m_tile_x;
+        uint32  m_tile_y;
+        uint64  m_payload_size;
+    };
+
+    const uint64 RecordOverhead = sizeof(RecordHeader) + sizeof(uint64);
+
+    uint64 compute_checksum(
+        const RecordHeader&     header,
+        const uint8*            payload)
+    {
+        SipHashAccumulator hash;
+        hash.append(header);
+
+        if (header.m_payload_size > 0)
+            hash.append(payload, static_cast<size_t>(header.m_payload_size));
+
+        return hash.get_hash();
+    }
+
+    size_t divide_round_up(const size_t a, const size_t b)
+    {
+        return (a + b - 1) / b;
+    }
+}
+
+
+//
+// CheckpointJournal class implementation.
+//
+
+const size_t CheckpointJournal::NoPass;
+
+CheckpointJournal::CheckpointJournal(
+    const size_t                    canvas_width,
+    const size_t                    canvas_height,
+    const size_t                    tile_width,
+    const size_t                    tile_height,
+    const vector<size_t>&           layer_pixel_sizes)
+  : m_tile_count_x(divide_round_up(canvas_width, tile_width))
+  , m_tile_count_y(divide_round_up(canvas_height, tile_height))
+  , m_layer_count(layer_pixel_sizes.size())
+  , m_writing(false)
+{
+    m_header.push_back(JournalMagic);
+    m_header.push_back(JournalVersion);
+    m_header.push_back(static_cast<uint32>(canvas_width));
+    m_header.push_back(static_cast<uint32>(canvas_height));
+    m_header.push_back(static_cast<uint32>(tile_width));
+    m_header.push_back(static_cast<uint32>(tile_height));
+    m_header.push_back(static_cast<uint32>(m_layer_count));
+
+    for (const size_t pixel_size : layer_pixel_sizes)
+        m_header.push_back(static_cast<uint32>(pixel_size));
+
+    clear_records();
+}
+
+CheckpointJournal::~CheckpointJournal()
+{
+    end_writing();
+}
+
+void CheckpointJournal::clear_records()
+{
+    m_tile_records.clear();
+    m_tile_records.resize(m_tile_count_x * m_tile_count_y);
+    m_last_complete_pass = NoPass;
+    m_record_count = 0;
+    m_size = m_header.size() * sizeof(uint32);
+}
+
+bool CheckpointJournal::read(const char* path)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    assert(!m_writing);
+
+    if (m_file.is_open())
+        m_file.close();
+
+    m_path.clear();
+    clear_records();
+
+    m_file.open(path, ios_base::in | ios_base::binary);
+    if (!m_file.is_open())
+        return false;
+
+    // Check that the journal has the expected layout.
+    vector<uint32> header(m_header.size());
+    m_file.read(reinterpret_cast<char*>(header.data()), header.size() * sizeof(uint32));
+    if (!m_file || header != m_header)
+    {
+        m_file.close();
+        return false;
+    }
+
+    const uint64 file_size = bf::file_size(path);
+    vector<uint8> payload;
+    uint64 offset = m_size;
+
+    while (true)
+    {
+        RecordHeader record_header;
+        uint64 checksum;
+
+        m_file.read(reinterpret_cast<char*>(&record_header), sizeof(RecordHeader));
+        if (!m_file)
+            break;
+
+        // Make sure the record was completely written.
+        if (file_size < offset + RecordOverhead ||
+            record_header.m_payload_size > file_size - offset - RecordOverhead)
+            break;
+
+        payload.resize(static_cast<size_t>(record_header.m_payload_size));
+        m_file.read(reinterpret_cast<char*>(payload.data()), payload.size());
+        m_file.read(reinterpret_cast<char*>(&checksum), sizeof(uint64));
+        if (!m_file || checksum != compute_checksum(record_header, payload.data()))
+            break;
+
+        const uint64 record_size = RecordOverhead + record_header.m_payload_size;
+
+        if (record_header.m_type == TileRecordType)
+        {
+            if (record_header.m_tile_x >= m_tile_count_x ||
+                record_header.m_tile_y >= m_tile_count_y)
+                break;
+
+            const Record record = { record_header.m_pass, offset, record_size };
+            m_tile_records[record_header.m_tile_y * m_tile_count_x + record_header.m_tile_x].push_back(record);
+        }
+        else if (record_header.m_type == PassRecordType)
+            m_last_complete_pass = record_header.m_pass;
+        else break;
+
+        offset += record_size;
+        ++m_record_count;
+    }
+
+    if (offset < file_size)
+    {
+        RENDERER_LOG_WARNING(
+            "ignoring the last %s of checkpoint journal %s because they are incomplete or corrupted.",
+            pretty_size(file_size - offset).c_str(),
+            path);
+    }
+
+    m_file.clear();
+    m_size = offset;
+    m_path = path;
+
+    return true;
+}
+
+size_t CheckpointJournal::get_tile_pass(
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const size_t                    max_pass) const
+{
+    const Record* record = find_tile_record(tile_x, tile_y, max_pass);
+    return record != nullptr ? record->m_pass : NoPass;
+}
+
+bool CheckpointJournal::read_tile(
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const size_t                    max_pass,
+    Tile* const                     layers[]) const
+{
+    const Record* record = find_tile_record(tile_x, tile_y, max_pass);
+    if (record == nullptr)
+        return false;
+
+    // Make sure the record matches the layers.
+    uint64 payload_size = 0;
+    for (size_t i = 0; i < m_layer_count; ++i)
+        payload_size += layers[i]->get_size();
+    if (record->m_size != RecordOverhead + payload_size)
+        return false;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    m_file.clear();
+    m_file.seekg(record->m_offset + sizeof(RecordHeader));
+
+    for (size_t i = 0; i < m_layer_count; ++i)
+        m_file.read(reinterpret_cast<char*>(layers[i]->get_storage()), layers[i]->get_size());
+
+    return !m_file.fail();
+}
+
+bool CheckpointJournal::begin_writing(const char* path)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    assert(!m_writing);
+
+    boost::system::error_code ec;
+    if (!m_path.empty() && bf::equivalent(bf::path(m_path), bf::path(path), ec))
+    {
+        // Resume appending to the journal, after its last valid record.
+        m_file.close();
+        bf::resize_file(path, m_size);
+    }
+    else if (!m_path.empty())
+    {
+        // Copy the records that were read to the new journal.
+        vector<RecordVector> tile_records;
+        size_t record_count;
+        uint64 size;
+        if (!write_compacted(path, tile_records, record_count, size))
+            return false;
+
+        m_file.close();
+        m_tile_records.swap(tile_records);
+        m_record_count = record_count;
+        m_size = size;
+    }
+    else
+    {
+        // Start a new journal.
+        clear_records();
+
+        ofstream file(path, ios_base::out | ios_base::trunc | ios_base::binary);
+        if (!write_header(file))
+            return false;
+    }
+
+    m_file.open(path, ios_base::in | ios_base::out | ios_base::binary);
+    if (!m_file.is_open())
+        return false;
+
+    m_path = path;
+    m_writing = true;
+
+    return true;
+}
+
+void CheckpointJournal::end_writing()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if (m_file.is_open())
+        m_file.close();
+
+    m_writing = false;
+}
+
+void CheckpointJournal::write_tile(
+    const size_t                    pass,
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const Tile* const               layers[])
+{
+    assert(tile_x < m_tile_count_x);
+    assert(tile_y < m_tile_count_y);
+
+    // Gather the layers and compute the checksum outside of the critical section.
+    vector<uint8> payload;
+    for (size_t i = 0; i < m_layer_count; ++i)
+    {
+        const uint8* storage = layers[i]->get_storage();
+        payload.insert(payload.end(), storage, storage + layers[i]->get_size());
+    }
+
+    RecordHeader header;
+    header.m_type = TileRecordType;
+    header.m_pass = static_cast<uint32>(pass);
+    header.m_tile_x = static_cast<uint32>(tile_x);
+    header.m_tile_y = static_cast<uint32>(tile_y);
+    header.m_payload_size = payload.size();
+
+    const uint64 checksum = compute_checksum(header, payload.data());
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if (!m_writing)
+        return;
+
+    m_file.seekp(m_size);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(RecordHeader));
+    m_file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    m_file.write(reinterpret_cast<const char*>(&checksum), sizeof(uint64));
+    m_file.flush();
+
+    if (m_file.fail())
+    {
+        RENDERER_LOG_ERROR("failed to write to checkpoint journal %s, disabling checkpoints.", m_path.c_str());
+        m_writing = false;
+        return;
+    }
+
+    const Record record = { pass, m_size, RecordOverhead + payload.size() };
+    m_tile_records[tile_y * m_tile_count_x + tile_x].push_back(record);
+
+    m_size += record.m_size;
+    ++m_record_count;
+}
+
+void CheckpointJournal::write_pass(const size_t pass)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if (!m_writing)
+        return;
+
+    RecordHeader header;
+    header.m_type = PassRecordType;
+    header.m_pass = static_cast<uint32>(pass);
+    header.m_tile_x = 0;
+    header.m_tile_y = 0;
+    header.m_payload_size = 0;
+
+    const uint64 checksum = compute_checksum(header, nullptr);
+
+    m_file.seekp(m_size);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(RecordHeader));
+    m_file.write(reinterpret_cast<const char*>(&checksum), sizeof(uint64));
+    m_file.flush();
+
+    if (m_file.fail())
+    {
+        RENDERER_LOG_ERROR("failed to write to checkpoint journal %s, disabling checkpoints.", m_path.c_str());
+        m_writing = false;
+        return;
+    }
+
+    m_last_complete_pass = pass;
+    m_size += RecordOverhead;
+    ++m_record_count;
+
+    if (m_record_count >= CompactionRatio * (m_tile_records.size() + 1))
+    {
+        if (!compact())
+        {
+            RENDERER_LOG_ERROR("failed to compact checkpoint journal %s, disabling checkpoints.", m_path.c_str());
+            m_writing = false;
+        }
+    }
+}
+
+const CheckpointJournal::Record* CheckpointJournal::find_tile_record(
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const size_t                    max_pass) const
+{
+    assert(tile_x < m_tile_count_x);
+    assert(tile_y < m_tile_count_y);
+
+    const RecordVector& records = m_tile_records[tile_y * m_tile_count_x + tile_x];
+
+    // Records are in file order: a tile rendered again after a resume supersedes older records.
+    for (size_t i = records.size(); i > 0; --i)
+    {
+        if (max_pass == NoPass || records[i - 1].m_pass <= max_pass)
+            return &records[i - 1];
+    }
+
+    return nullptr;
+}
+
+bool CheckpointJournal::write_header(ostream& file) const
+{
+    file.write(reinterpret_cast<const char*>(m_header.data()), m_header.size() * sizeof(uint32));
+    return !file.fail();
+}
+
+bool CheckpointJournal::write_compacted(
+    const string&                   path,
+    vector<RecordVector>&           tile_records,
+    size_t&                         record_count,
+    uint64&                         size) const
+{
+    ofstream file(path.c_str(), ios_base::out | ios_base::trunc | ios_base::binary);
+    if (!write_header(file))
+        return false;
+
+    tile_records.clear();
+    tile_records.resize(m_tile_records.size());
+    record_count = 0;
+    size = m_header.size() * sizeof(uint32);
+
+    vector<char> buffer;
+
+    for (size_t i = 0, e = m_tile_records.size(); i < e; ++i)
+    {
+        const RecordVector& records = m_tile_records[i];
+        if (records.empty())
+            continue;
+
+        // Keep the latest record of the tile, and the latest record of the last complete pass.
+        RecordVector kept;
+        for (size_t j = records.size(); j > 0; --j)
+        {
+            if (m_last_complete_pass == NoPass || records[j - 1].m_pass <= m_last_complete_pass)
+            {
+                kept.push_back(records[j - 1]);
+                break;
+            }
+        }
+        if (kept.empty() || kept.back().m_offset != records.back().m_offset)
+            kept.push_back(records.back());
+
+        // Copy the records verbatim.
+        for (const Record& record : kept)
+        {
+            buffer.resize(static_cast<size_t>(record.m_size));
+            m_file.clear();
+            m_file.seekg(record.m_offset);
+            m_file.read(buffer.data(), buffer.size());
+            file.write(buffer.data(), buffer.size());
+
+            const Record copy = { record.m_pass, size, record.m_size };
+            tile_records[i].push_back(copy);
+
+            size += record.m_size;
+            ++record_count;
+        }
+    }
+
+    if (m_last_complete_pass != NoPass)
+    {
+        RecordHeader header;
+        header.m_type = PassRecordType;
+        header.m_pass = static_cast<uint32>(m_last_complete_pass);
+        header.m_tile_x = 0;
+        header.m_tile_y = 0;
+        header.m_payload_size = 0;
+
+        const uint64 checksum = compute_checksum(header, nullptr);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(RecordHeader));
+        file.write(reinterpret_cast<const char*>(&checksum), sizeof(uint64));
+
+        size += RecordOverhead;
+        ++record_count;
+    }
+
+    file.close();
+
+    return !m_file.fail() && !file.fail();
+}
+
+bool CheckpointJournal::compact()
+{
+    // Write the compacted journal to a temporary file, then replace the journal with it.
+    const string temp_path = m_path + ".tmp";
+
+    vector<RecordVector> tile_records;
+    size_t record_count;
+    uint64 size;
+    if (!write_compacted(temp_path, tile_records, record_count, size))
+        return false;
+
+    const uint64 old_size = m_size;
+
+    m_file.close();
+
+    boost::system::error_code ec;
+    bf::rename(temp_path, m_path, ec);
+    if (ec)
+        return false;
+
+    m_file.open(m_path.c_str(), ios_base::in | ios_base::out | ios_base::binary);
+    if (!m_file.is_open())
+        return false;
+
+    m_tile_records.swap(tile_records);
+    m_record_count = record_count;
+    m_size = size;
+
+    RENDERER_LOG_DEBUG(
+        "compacted checkpoint journal %s from %s to %s.",
+        m_path.c_str(),
+        pretty_size(old_size).c_str(),
+        pretty_size(m_size).c_str());
+
+    return true;
+}
+
+}   // namespace renderer
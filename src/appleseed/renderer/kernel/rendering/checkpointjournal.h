@@ -0,0 +1,209 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Tile; }
+
+namespace renderer
+{
+
+//
+// An append-only journal of rendered tiles, used to resume interrupted renders.
+//
+// Every time a tile is rendered, its layers (typically the sample accumulation buffer
+// of the tile followed by unfiltered AOV tiles) are appended to the journal as a single
+// record. At the end of each pass, a pass record is appended. When the journal holds too
+// many superseded records, it is compacted by rewriting it with only the records that
+// may still be needed.
+//
+// Since records are only ever appended, a render that is interrupted at any time leaves
+// a journal from which all the tiles that were completed can be restored.
+//
+// File layout (native endianness):
+//
+//   Header:
+//
+//     uint32       magic number ('ASCJ')
+//     uint32       version (1)
+//     uint32       canvas width, canvas height
+//     uint32       tile width, tile height
+//     uint32       layer count
+//     uint32       bytes per pixel, for each layer
+//
+//   Records:
+//
+//     uint32       record type ('TILE' or 'PASS')
+//     uint32       pass
+//     uint32       tile x, tile y (0 for pass records)
+//     uint64       payload size in bytes
+//     uint8        payload (pixels of each layer of the tile, one layer after the other)
+//     uint64       SipHash-2-4 of the preceding fields of the record
+//
+// A pass record for pass N states that all tiles have completed pass N.
+//
+
+class CheckpointJournal
+  : public foundation::NonCopyable
+{
+  public:
+    // Value returned when there is no pass.
+    static const size_t NoPass = ~size_t(0);
+
+    // Constructor.
+    CheckpointJournal(
+        const size_t                    canvas_width,
+        const size_t                    canvas_height,
+        const size_t                    tile_width,
+        const size_t                    tile_height,
+        const std::vector<size_t>&      layer_pixel_sizes);
+
+    // Destructor.
+    ~CheckpointJournal();
+
+    // Read and validate the records of an existing journal.
+    // Records following a truncated or corrupted record are ignored.
+    // Return false if the journal cannot be read or has a different layout.
+    bool read(const char* path);
+
+    // Return the last pass completed by all tiles, or NoPass.
+    size_t get_last_complete_pass() const;
+
+    // Return the last pass not greater than `max_pass` recorded for a given tile, or NoPass.
+    size_t get_tile_pass(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const size_t                    max_pass = NoPass) const;
+
+    // Restore the layers of a tile from its last record not greater than `max_pass`.
+    bool read_tile(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const size_t                    max_pass,
+        foundation::Tile* const         layers[]) const;
+
+    // Start appending records to a journal. If this journal was read from the same
+    // file, its valid records are kept; if it was read from another file, they are
+    // copied over. Otherwise the file is created or overwritten.
+    bool begin_writing(const char* path);
+
+    // Close the journal.
+    void end_writing();
+
+    // Append a record for a rendered tile. Thread-safe.
+    void write_tile(
+        const size_t                    pass,
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const foundation::Tile* const   layers[]);
+
+    // Append a pass record, and compact the journal if needed.
+    void write_pass(const size_t pass);
+
+    // Return the number of records in the journal.
+    size_t get_record_count() const;
+
+    // Return the size in bytes of the valid part of the journal.
+    foundation::uint64 get_size() const;
+
+  private:
+    struct Record
+    {
+        size_t              m_pass;
+        foundation::uint64  m_offset;       // offset of the record in the file
+        foundation::uint64  m_size;         // size of the record in bytes, including header and checksum
+    };
+
+    typedef std::vector<Record> RecordVector;
+
+    std::vector<foundation::uint32>     m_header;
+    const size_t                        m_tile_count_x;
+    const size_t                        m_tile_count_y;
+    const size_t                        m_layer_count;
+
+    std::string                         m_path;
+    mutable std::fstream                m_file;
+    bool                                m_writing;
+    mutable boost::mutex                m_mutex;
+
+    std::vector<RecordVector>           m_tile_records;
+    size_t                              m_last_complete_pass;
+    size_t                              m_record_count;
+    foundation::uint64                  m_size;
+
+    void clear_records();
+
+    const Record* find_tile_record(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const size_t                    max_pass) const;
+
+    bool write_header(std::ostream& file) const;
+
+    bool write_compacted(
+        const std::string&              path,
+        std::vector<RecordVector>&      tile_records,
+        size_t&                         record_count,
+        foundation::uint64&             size) const;
+
+    bool compact();
+};
+
+
+//
+// CheckpointJournal class implementation.
+//
+
+inline size_t CheckpointJournal::get_last_complete_pass() const
+{
+    return m_last_complete_pass;
+}
+
+inline size_t CheckpointJournal::get_record_count() const
+{
+    return m_record_count;
+}
+
+inline foundation::uint64 CheckpointJournal::get_size() const
+{
+    return m_size;
+}
+
+}   // namespace renderer
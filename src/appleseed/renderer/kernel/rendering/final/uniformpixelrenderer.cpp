@@ -35,6 +35,7 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
 #include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/rendering/isamplerenderer.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/rendering/pixelrendererbase.h"
@@ -60,9 +61,12 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
@@ -144,43 +148,57 @@ namespace
                 0,                          // number of samples -- unknown
                 instance);                  // initial instance number
 
-            for (size_t i = 0; i < m_sample_count; ++i)
+            // Render the samples in batches so that their camera rays can be traced together.
+            for (size_t i = 0; i < m_sample_count; i += RayPacketSize)
             {
-                // Generate a uniform sample in [0,1)^2.
-                const Vector2f s =
-                    m_sample_count > 1 || m_params.m_force_aa
-                        ? sampling_context.next2<Vector2f>()
-                        : Vector2f(0.5f);
-
-                // Sample the pixel filter.
-                const auto& filter_table = frame.get_filter_sampling_table();
-                const Vector2d pf(
-                    static_cast<double>(filter_table.sample(s[0]) + 0.5f),
-                    static_cast<double>(filter_table.sample(s[1]) + 0.5f));
-
-                // Compute the sample position in NDC.
-                const Vector2d sample_position = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
-
-                // Create a pixel context that identifies the pixel and sample currently being rendered.
-                const PixelContext pixel_context(pi, sample_position);
-
-                // Render the sample.
-                ShadingResult shading_result(aov_count);
-                SamplingContext child_sampling_context(sampling_context);
-                m_sample_renderer->render_sample(
-                    child_sampling_context,
-                    pixel_context,
-                    sample_position,
+                const size_t sample_count = min(m_sample_count - i, RayPacketSize);
+
+                m_sampling_contexts.clear();
+                m_pixel_contexts.clear();
+
+                for (size_t j = 0; j < sample_count; ++j)
+                {
+                    // Generate a uniform sample in [0,1)^2.
+                    const Vector2f s =
+                        m_sample_count > 1 || m_params.m_force_aa
+                            ? sampling_context.next2<Vector2f>()
+                            : Vector2f(0.5f);
+
+                    // Sample the pixel filter.
+                    const auto& filter_table = frame.get_filter_sampling_table();
+                    const Vector2d pf(
+                        static_cast<double>(filter_table.sample(s[0]) + 0.5f),
+                        static_cast<double>(filter_table.sample(s[1]) + 0.5f));
+
+                    // Compute the sample position in NDC.
+                    m_sample_positions[j] = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
+
+                    // Create a pixel context that identifies the pixel and sample currently being rendered.
+                    m_pixel_contexts.emplace_back(pi, m_sample_positions[j]);
+
+                    m_sampling_contexts.push_back(sampling_context);
+                    m_shading_results[j].reset(aov_count);
+                }
+
+                // Render the samples.
+                m_sample_renderer->render_samples(
+                    sample_count,
+                    &m_sampling_contexts[0],
+                    &m_pixel_contexts[0],
+                    m_sample_positions,
                     aov_accumulators,
-                    shading_result);
-
-                // Update sampling statistics.
-                m_total_sampling_dim.insert(child_sampling_context.get_total_dimension());
-
-                // Merge the sample into the framebuffer.
-                if (shading_result.is_valid())
-                    framebuffer.add(Vector2u(pt), shading_result);
-                else signal_invalid_sample();
+                    m_shading_results);
+
+                for (size_t j = 0; j < sample_count; ++j)
+                {
+                    // Update sampling statistics.
+                    m_total_sampling_dim.insert(m_sampling_contexts[j].get_total_dimension());
+
+                    // Merge the sample into the framebuffer.
+                    if (m_shading_results[j].is_valid())
+                        framebuffer.add(Vector2u(pt), m_shading_results[j]);
+                    else signal_invalid_sample();
+                }
             }
 
             on_pixel_end(frame, pi, pt, tile_bbox, aov_accumulators);
@@ -222,6 +240,12 @@ namespace
         auto_release_ptr<ISampleRenderer>   m_sample_renderer;
         const size_t                        m_sample_count;
         Population<uint64>                  m_total_sampling_dim;
+
+        // Batch of samples being rendered.
+        vector<SamplingContext>             m_sampling_contexts;
+        vector<PixelContext>                m_pixel_contexts;
+        Vector2d                            m_sample_positions[RayPacketSize];
+        ShadingResult                       m_shading_results[RayPacketSize];
     };
 }
 
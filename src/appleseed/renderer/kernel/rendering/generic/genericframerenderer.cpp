@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/denoising/streamingdenoiser.h"
 #include "renderer/kernel/rendering/generic/tilejob.h"
 #include "renderer/kernel/rendering/generic/tilejobfactory.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
@@ -41,6 +42,7 @@
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
 #include "renderer/kernel/rendering/permanentshadingresultframebufferfactory.h"
+#include "renderer/kernel/texturing/textureprefetcher.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/utility/settingsparsing.h"
 
@@ -87,6 +89,7 @@ namespace
             ITileRendererFactory*               tile_renderer_factory,
             ITileCallbackFactory*               tile_callback_factory,
             IPassCallback*                      pass_callback,
+            TextureStore*                       texture_store,
             const ParamArray&                   params)
           : m_frame(frame)
           , m_framebuffer_factory(framebuffer_factory)
@@ -103,7 +106,7 @@ namespace
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                    JobManager::KeepRunningOnEmptyQueue | m_params.m_thread_flags));
 
             // Instantiate tile renderers, one per rendering thread.
             m_tile_renderers.reserve(m_params.m_thread_count);
@@ -117,6 +120,16 @@ namespace
                 for (size_t i = 0; i < m_params.m_thread_count; ++i)
                     m_tile_callbacks.push_back(tile_callback_factory->create());
             }
+
+            // Create the texture prefetcher.
+            if (texture_store && m_params.m_texture_prefetch)
+            {
+                m_texture_prefetcher.reset(
+                    new TexturePrefetcher(
+                        *texture_store,
+                        m_frame.image().properties().m_tile_count,
+                        m_params.m_texture_prefetch_lookahead));
+            }
         }
 
         ~GenericFrameRenderer() override
@@ -149,15 +162,23 @@ namespace
                 "  spectrum mode                 %s\n"
                 "  sampling mode                 %s\n"
                 "  rendering threads             %s\n"
+                "  work stealing                 %s\n"
+                "  pinned rendering threads      %s\n"
                 "  tile ordering                 %s\n"
-                "  passes                        %s",
+                "  passes                        %s\n"
+                "  texture prefetch              %s",
                 get_spectrum_mode_name(m_params.m_spectrum_mode).c_str(),
                 get_sampling_context_mode_name(m_params.m_sampling_mode).c_str(),
                 pretty_uint(m_params.m_thread_count).c_str(),
+                m_params.m_thread_flags & JobManager::WorkStealing ? "on" : "off",
+                m_params.m_thread_flags & JobManager::PinWorkerThreads ? "on" : "off",
                 m_params.m_tile_ordering == TileJobFactory::TileOrdering::LinearOrdering ? "linear" :
                 m_params.m_tile_ordering == TileJobFactory::TileOrdering::SpiralOrdering ? "spiral" :
                 m_params.m_tile_ordering == TileJobFactory::TileOrdering::HilbertOrdering ? "hilbert" : "random",
-                pretty_uint(m_params.m_pass_count).c_str());
+                pretty_uint(m_params.m_pass_count).c_str(),
+                m_texture_prefetcher.get()
+                    ? ("on, " + pretty_uint(m_params.m_texture_prefetch_lookahead) + " tiles ahead").c_str()
+                    : "off");
 
             m_tile_renderers.front()->print_settings();
         }
@@ -197,6 +218,7 @@ namespace
                     m_params.m_pass_count,
                     m_job_queue,
                     m_params.m_thread_count,
+                    m_texture_prefetcher.get(),
                     m_abort_switch,
                     m_is_rendering));
             ThreadFunctionWrapper<PassManagerFunc> wrapper(m_pass_manager_func.get());
@@ -233,6 +255,9 @@ namespace
             stop_rendering();
 
             print_tile_renderers_stats();
+
+            if (m_texture_prefetcher.get())
+                RENDERER_LOG_DEBUG("%s", m_texture_prefetcher->get_statistics().to_string().c_str());
         }
 
       private:
@@ -241,15 +266,21 @@ namespace
             const Spectrum::Mode                m_spectrum_mode;
             const SamplingContext::Mode         m_sampling_mode;
             const size_t                        m_thread_count;     // number of rendering threads
+            const int                           m_thread_flags;     // scheduling flags of the rendering threads
             const TileJobFactory::TileOrdering  m_tile_ordering;    // tile rendering order
             const size_t                        m_pass_count;       // number of rendering passes
+            const bool                          m_texture_prefetch;
+            const size_t                        m_texture_prefetch_lookahead;
 
             explicit Parameters(const ParamArray& params)
               : m_spectrum_mode(get_spectrum_mode(params))
               , m_sampling_mode(get_sampling_context_mode(params))
               , m_thread_count(get_rendering_thread_count(params))
+              , m_thread_flags(get_rendering_thread_flags(params))
               , m_tile_ordering(get_tile_ordering(params))
               , m_pass_count(params.get_optional<size_t>("passes", 1))
+              , m_texture_prefetch(params.get_optional<bool>("texture_prefetch", false))
+              , m_texture_prefetch_lookahead(params.get_optional<size_t>("texture_prefetch_lookahead", 16))
             {
             }
 
@@ -302,6 +333,7 @@ namespace
                 const size_t                        pass_count,
                 JobQueue&                           job_queue,
                 const size_t                        thread_count,
+                TexturePrefetcher*                  texture_prefetcher,
                 IAbortSwitch&                       abort_switch,
                 bool&                               is_rendering)
               : m_frame(frame)
@@ -314,6 +346,7 @@ namespace
               , m_pass_count(pass_count)
               , m_job_queue(job_queue)
               , m_thread_count(thread_count)
+              , m_texture_prefetcher(texture_prefetcher)
               , m_abort_switch(abort_switch)
               , m_is_rendering(is_rendering)
             {
@@ -325,6 +358,9 @@ namespace
 
                 const size_t start_pass = m_frame.get_initial_pass();
 
+                // Denoises tiles while the last pass is rendered, if enabled.
+                unique_ptr<StreamingDenoiser> streaming_denoiser;
+
                 //
                 // Rendering passes.
                 //
@@ -353,6 +389,9 @@ namespace
                     for (auto tile_callback : m_tile_callbacks)
                         tile_callback->on_tiled_frame_begin(&m_frame);
 
+                    if (pass + 1 == m_pass_count && m_frame.is_denoiser_streaming())
+                        streaming_denoiser.reset(m_frame.create_streaming_denoiser(&m_abort_switch));
+
                     // Create tile jobs.
                     const uint32 pass_hash = mix_uint32(m_frame.get_noise_seed(), static_cast<uint32>(pass));
                     TileJobFactory::TileJobVector tile_jobs;
@@ -361,17 +400,38 @@ namespace
                         m_tile_ordering,
                         m_tile_renderers,
                         m_tile_callbacks,
+                        m_framebuffer_factory,
+                        pass,
                         pass_hash,
                         m_spectrum_mode,
+                        m_texture_prefetcher,
+                        streaming_denoiser.get(),
                         tile_jobs,
                         m_abort_switch);
 
+                    // Start prefetching texture tiles in tile rendering order.
+                    if (m_texture_prefetcher)
+                    {
+                        const size_t tile_count_x = m_frame.image().properties().m_tile_count_x;
+                        vector<size_t> image_tile_order;
+                        image_tile_order.reserve(tile_jobs.size());
+
+                        for (const_each<TileJobFactory::TileJobVector> i = tile_jobs; i; ++i)
+                            image_tile_order.push_back((*i)->get_tile_y() * tile_count_x + (*i)->get_tile_x());
+
+                        m_texture_prefetcher->on_pass_begin(image_tile_order);
+                    }
+
                     // Schedule tile jobs.
                     for (const_each<TileJobFactory::TileJobVector> i = tile_jobs; i; ++i)
                         m_job_queue.schedule(*i);
 
                     // Wait until tile jobs have effectively stopped.
                     m_job_queue.wait_until_completion();
+                    const bool pass_completed = !m_abort_switch.is_aborted();
+
+                    if (m_texture_prefetcher)
+                        m_texture_prefetcher->on_pass_end();
 
                     // Invoke on_tiled_frame_end() on tile callbacks.
                     for (auto tile_callback : m_tile_callbacks)
@@ -385,7 +445,9 @@ namespace
                         assert(!m_job_queue.has_scheduled_or_running_jobs());
                     }
 
-                    m_frame.save_checkpoint(m_framebuffer_factory, pass);
+                    // Mark the pass as complete in the checkpoint.
+                    if (pass_completed)
+                        m_frame.save_checkpoint(pass);
                 }
 
                 // Check abort flag.
@@ -402,7 +464,16 @@ namespace
                 // Denoising pass.
                 //
 
-                if (m_frame.get_denoising_mode() == Frame::DenoisingMode::Denoise)
+                if (streaming_denoiser)
+                {
+                    // Tiles were denoised during the last pass.
+                    streaming_denoiser->print_statistics();
+
+                    // Notify tile callbacks that all tiles of the frame changed.
+                    on_tile_begin_whole_frame();
+                    on_tile_end_whole_frame();
+                }
+                else if (m_frame.get_denoising_mode() == Frame::DenoisingMode::Denoise)
                 {
                     if (m_pass_count > 1)
                         RENDERER_LOG_INFO("--- beginning denoising pass ---");
@@ -431,6 +502,7 @@ namespace
             const size_t                            m_pass_count;
             JobQueue&                               m_job_queue;
             const size_t                            m_thread_count;
+            TexturePrefetcher*                      m_texture_prefetcher;
             IAbortSwitch&                           m_abort_switch;
             bool&                                   m_is_rendering;
             TileJobFactory                          m_tile_job_factory;
@@ -479,6 +551,7 @@ namespace
         IPassCallback*                          m_pass_callback;
 
         TileJobFactory                          m_tile_job_factory;
+        unique_ptr<TexturePrefetcher>           m_texture_prefetcher;
 
         bool                                    m_is_rendering;
         unique_ptr<PassManagerFunc>             m_pass_manager_func;
@@ -539,6 +612,22 @@ Dictionary GenericFrameRendererFactory::get_params_metadata()
                             .insert("label", "Random")
                             .insert("help", "Random tile ordering"))));
 
+    metadata.dictionaries().insert(
+        "texture_prefetch",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Texture Prefetch")
+            .insert("help", "Load texture tiles ahead of tile rendering, based on texture accesses of the previous pass"));
+
+    metadata.dictionaries().insert(
+        "texture_prefetch_lookahead",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("label", "Texture Prefetch Lookahead")
+            .insert("help", "Number of image tiles for which texture tiles are prefetched ahead of rendering"));
+
     return metadata;
 }
 
@@ -548,12 +637,14 @@ GenericFrameRendererFactory::GenericFrameRendererFactory(
     ITileRendererFactory*               tile_renderer_factory,
     ITileCallbackFactory*               tile_callback_factory,
     IPassCallback*                      pass_callback,
+    TextureStore*                       texture_store,
     const ParamArray&                   params)
   : m_frame(frame)
   , m_framebuffer_factory(framebuffer_factory)
   , m_tile_renderer_factory(tile_renderer_factory)
   , m_tile_callback_factory(tile_callback_factory)
   , m_pass_callback(pass_callback)
+  , m_texture_store(texture_store)
   , m_params(params)
 {
 }
@@ -572,6 +663,7 @@ IFrameRenderer* GenericFrameRendererFactory::create()
             m_tile_renderer_factory,
             m_tile_callback_factory,
             m_pass_callback,
+            m_texture_store,
             m_params);
 }
 
@@ -581,6 +673,7 @@ IFrameRenderer* GenericFrameRendererFactory::create(
     ITileRendererFactory*               tile_renderer_factory,
     ITileCallbackFactory*               tile_callback_factory,
     IPassCallback*                      pass_callback,
+    TextureStore*                       texture_store,
     const ParamArray&                   params)
 {
     return
@@ -590,6 +683,7 @@ IFrameRenderer* GenericFrameRendererFactory::create(
             tile_renderer_factory,
             tile_callback_factory,
             pass_callback,
+            texture_store,
             params);
 }
 
@@ -34,6 +34,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/ilightingengine.h"
@@ -62,6 +63,7 @@
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <limits>
 #include <string>
@@ -169,13 +171,6 @@ namespace
             AOVAccumulatorContainer&    aov_accumulators,
             ShadingResult&              shading_result) override
         {
-#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
-
-            const uint64 last_texture_cache_hit_count = m_texture_cache.get_hit_count();
-            const uint64 last_texture_cache_miss_count = m_texture_cache.get_miss_count();
-
-#endif
-
             // Construct a primary ray.
             ShadingRay primary_ray;
             m_scene.get_active_camera()->spawn_ray(
@@ -183,6 +178,118 @@ namespace
                 Dual2d(image_point, m_image_point_dx, m_image_point_dy),
                 primary_ray);
 
+            trace_and_shade(
+                sampling_context,
+                pixel_context,
+                primary_ray,
+                nullptr,
+                aov_accumulators,
+                shading_result);
+        }
+
+        void render_samples(
+            const size_t                sample_count,
+            SamplingContext*            sampling_contexts,
+            const PixelContext*         pixel_contexts,
+            const Vector2d*             image_points,
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult*              shading_results) override
+        {
+            ShadingRay primary_rays[RayPacketSize];
+
+            for (size_t i = 0; i < sample_count; i += RayPacketSize)
+            {
+                const size_t packet_size = min(sample_count - i, RayPacketSize);
+
+                // Construct the primary rays.
+                for (size_t j = 0; j < packet_size; ++j)
+                {
+                    m_scene.get_active_camera()->spawn_ray(
+                        sampling_contexts[i + j],
+                        Dual2d(image_points[i + j], m_image_point_dx, m_image_point_dy),
+                        primary_rays[j]);
+
+                    m_first_hits[j].clear();
+                }
+
+                // Find the first intersection along all primary rays at once.
+                m_intersector.trace(primary_rays, packet_size, m_first_hits);
+
+                // Shade the samples.
+                for (size_t j = 0; j < packet_size; ++j)
+                {
+                    trace_and_shade(
+                        sampling_contexts[i + j],
+                        pixel_contexts[i + j],
+                        primary_rays[j],
+                        &m_first_hits[j],
+                        aov_accumulators,
+                        shading_results[i + j]);
+                }
+            }
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            StatisticsVector stats;
+            stats.merge(m_texture_cache.get_statistics());
+            stats.merge(m_intersector.get_statistics());
+            stats.merge(m_lighting_engine->get_statistics());
+            return stats;
+        }
+
+      private:
+        struct Parameters
+        {
+            const float     m_transparency_threshold;
+            const size_t    m_max_iterations;
+            const bool      m_report_self_intersections;
+
+            explicit Parameters(const ParamArray& params)
+              : m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
+              , m_max_iterations(params.get_optional<size_t>("max_iterations", 100))
+              , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
+            {
+            }
+        };
+
+        const Parameters            m_params;
+        const Scene&                m_scene;
+        const float                 m_opacity_threshold;
+        TextureCache                m_texture_cache;
+        ILightingEngine*            m_lighting_engine;
+        ShadingEngine&              m_shading_engine;
+        OIIOTextureSystem&          m_oiio_texture_system;
+        const size_t                m_thread_index;
+
+        Arena                       m_arena;
+        OSLShaderGroupExec          m_shadergroup_exec;
+        const Intersector           m_intersector;
+        Tracer                      m_tracer;
+        const ShadingContext        m_shading_context;
+
+        Vector2d                    m_image_point_dx;
+        Vector2d                    m_image_point_dy;
+
+        ShadingPoint                m_first_hits[RayPacketSize];
+
+        // Trace a primary ray through the scene, shading every intersection along the way
+        // until an opaque surface is found. The first intersection may already be known.
+        void trace_and_shade(
+            SamplingContext&            sampling_context,
+            const PixelContext&         pixel_context,
+            ShadingRay&                 primary_ray,
+            const ShadingPoint*         first_hit,
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult&              shading_result)
+        {
+#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
+
+            const uint64 last_texture_cache_hit_count = m_texture_cache.get_hit_count();
+            const uint64 last_texture_cache_miss_count = m_texture_cache.get_miss_count();
+
+#endif
+
             ShadingPoint shading_points[2];
             size_t shading_point_index = 0;
             const ShadingPoint* shading_point_ptr = nullptr;
@@ -204,16 +311,24 @@ namespace
 
                 m_arena.clear();
 
-                // Trace the ray.
-                shading_points[shading_point_index].clear();
-                m_intersector.trace(
-                    primary_ray,
-                    shading_points[shading_point_index],
-                    shading_point_ptr);
-
-                // Update the pointers to the shading points.
-                shading_point_ptr = &shading_points[shading_point_index];
-                shading_point_index = 1 - shading_point_index;
+                if (iterations == 1 && first_hit)
+                {
+                    // The first intersection was found ahead of time.
+                    shading_point_ptr = first_hit;
+                }
+                else
+                {
+                    // Trace the ray.
+                    shading_points[shading_point_index].clear();
+                    m_intersector.trace(
+                        primary_ray,
+                        shading_points[shading_point_index],
+                        shading_point_ptr);
+
+                    // Update the pointers to the shading points.
+                    shading_point_ptr = &shading_points[shading_point_index];
+                    shading_point_index = 1 - shading_point_index;
+                }
 
                 if (iterations == 1)
                 {
@@ -294,48 +409,6 @@ namespace
 
 #endif
         }
-
-        StatisticsVector get_statistics() const override
-        {
-            StatisticsVector stats;
-            stats.merge(m_texture_cache.get_statistics());
-            stats.merge(m_intersector.get_statistics());
-            stats.merge(m_lighting_engine->get_statistics());
-            return stats;
-        }
-
-      private:
-        struct Parameters
-        {
-            const float     m_transparency_threshold;
-            const size_t    m_max_iterations;
-            const bool      m_report_self_intersections;
-
-            explicit Parameters(const ParamArray& params)
-              : m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
-              , m_max_iterations(params.get_optional<size_t>("max_iterations", 100))
-              , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
-            {
-            }
-        };
-
-        const Parameters            m_params;
-        const Scene&                m_scene;
-        const float                 m_opacity_threshold;
-        TextureCache                m_texture_cache;
-        ILightingEngine*            m_lighting_engine;
-        ShadingEngine&              m_shading_engine;
-        OIIOTextureSystem&          m_oiio_texture_system;
-        const size_t                m_thread_index;
-
-        Arena                       m_arena;
-        OSLShaderGroupExec          m_shadergroup_exec;
-        const Intersector           m_intersector;
-        Tracer                      m_tracer;
-        const ShadingContext        m_shading_context;
-
-        Vector2d                    m_image_point_dx;
-        Vector2d                    m_image_point_dy;
     };
 }
 
@@ -31,8 +31,10 @@
 #include "tilejob.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/denoising/streamingdenoiser.h"
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
+#include "renderer/kernel/texturing/textureprefetcher.h"
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
@@ -57,19 +59,27 @@ namespace renderer
 TileJob::TileJob(
     const TileRendererVector&   tile_renderers,
     const TileCallbackVector&   tile_callbacks,
+    IShadingResultFrameBufferFactory* framebuffer_factory,
     const Frame&                frame,
     const size_t                tile_x,
     const size_t                tile_y,
+    const size_t                pass,
     const uint32                pass_hash,
     const Spectrum::Mode        spectrum_mode,
+    TexturePrefetcher*          texture_prefetcher,
+    StreamingDenoiser*          streaming_denoiser,
     IAbortSwitch&               abort_switch)
   : m_tile_renderers(tile_renderers)
   , m_tile_callbacks(tile_callbacks)
+  , m_framebuffer_factory(framebuffer_factory)
   , m_frame(frame)
   , m_tile_x(tile_x)
   , m_tile_y(tile_y)
+  , m_pass(pass)
   , m_pass_hash(pass_hash)
   , m_spectrum_mode(spectrum_mode)
+  , m_texture_prefetcher(texture_prefetcher)
+  , m_streaming_denoiser(streaming_denoiser)
   , m_abort_switch(abort_switch)
 {
     // Either there is no tile callback, or there is the same number
@@ -138,6 +148,11 @@ void TileJob::execute(const size_t thread_index)
     if (tile_callback)
         tile_callback->on_tile_begin(&m_frame, m_tile_x, m_tile_y);
 
+    // Record texture tiles accessed while rendering this tile.
+    const TexturePrefetcher::ImageTileScope texture_prefetch_scope(
+        m_texture_prefetcher,
+        m_tile_y * m_frame.image().properties().m_tile_count_x + m_tile_x);
+
     try
     {
         // Render the tile.
@@ -158,9 +173,17 @@ void TileJob::execute(const size_t thread_index)
         throw;
     }
 
+    // Append the tile to the checkpoint, unless it was only partially rendered.
+    if (!m_abort_switch.is_aborted())
+        m_frame.save_tile_checkpoint(m_framebuffer_factory, m_tile_x, m_tile_y, m_pass);
+
     // Call the post-render tile callback.
     if (tile_callback)
         tile_callback->on_tile_end(&m_frame, m_tile_x, m_tile_y);
+
+    // Denoise the tiles whose neighborhoods are now complete.
+    if (m_streaming_denoiser && !m_abort_switch.is_aborted())
+        m_streaming_denoiser->on_tile_end(m_tile_x, m_tile_y);
 }
 
 }   // namespace renderer
@@ -42,8 +42,11 @@
 
 // Forward declarations.
 namespace renderer  { class Frame; }
+namespace renderer  { class IShadingResultFrameBufferFactory; }
 namespace renderer  { class ITileCallback; }
 namespace renderer  { class ITileRenderer; }
+namespace renderer  { class StreamingDenoiser; }
+namespace renderer  { class TexturePrefetcher; }
 
 namespace renderer
 {
@@ -63,25 +66,52 @@ class TileJob
     TileJob(
         const TileRendererVector&   tile_renderers,
         const TileCallbackVector&   tile_callbacks,
+        IShadingResultFrameBufferFactory* framebuffer_factory,
         const Frame&                frame,
         const size_t                tile_x,
         const size_t                tile_y,
+        const size_t                pass,
         const foundation::uint32    pass_hash,
         const Spectrum::Mode        spectrum_mode,
+        TexturePrefetcher*          texture_prefetcher,     // may be nullptr
+        StreamingDenoiser*          streaming_denoiser,     // may be nullptr
         foundation::IAbortSwitch&   abort_switch);
 
+    // Return the coordinates of the tile rendered by this job.
+    size_t get_tile_x() const;
+    size_t get_tile_y() const;
+
     // Execute the job.
     void execute(const size_t thread_index) override;
 
   private:
     const TileRendererVector&       m_tile_renderers;
     const TileCallbackVector&       m_tile_callbacks;
+    IShadingResultFrameBufferFactory* m_framebuffer_factory;
     const Frame&                    m_frame;
     const size_t                    m_tile_x;
     const size_t                    m_tile_y;
+    const size_t                    m_pass;
     const foundation::uint32        m_pass_hash;
     const Spectrum::Mode            m_spectrum_mode;
+    TexturePrefetcher*              m_texture_prefetcher;
+    StreamingDenoiser*              m_streaming_denoiser;
     foundation::IAbortSwitch&       m_abort_switch;
 };
 
+
+//
+// TileJob class implementation.
+//
+
+inline size_t TileJob::get_tile_x() const
+{
+    return m_tile_x;
+}
+
+inline size_t TileJob::get_tile_y() const
+{
+    return m_tile_y;
+}
+
 }   // namespace renderer
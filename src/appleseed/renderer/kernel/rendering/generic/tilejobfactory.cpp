@@ -57,8 +57,12 @@ void TileJobFactory::create(
     const TileOrdering                  tile_ordering,
     const TileJob::TileRendererVector&  tile_renderers,
     const TileJob::TileCallbackVector&  tile_callbacks,
+    IShadingResultFrameBufferFactory*   framebuffer_factory,
+    const size_t                        pass,
     const uint32                        pass_hash,
     const Spectrum::Mode                spectrum_mode,
+    TexturePrefetcher*                  texture_prefetcher,
+    StreamingDenoiser*                  streaming_denoiser,
     TileJobVector&                      tile_jobs,
     IAbortSwitch&                       abort_switch)
 {
@@ -72,7 +76,7 @@ void TileJobFactory::create(
     // Make sure the right number of tiles was created.
     assert(tiles.size() == props.m_tile_count);
 
-    // Create tile jobs, one per tile.
+    // Create tile jobs, at most one per tile.
     for (size_t i = 0; i < props.m_tile_count; ++i)
     {
         // Compute coordinates of the tile in the frame.
@@ -82,16 +86,24 @@ void TileJobFactory::create(
         assert(tile_x < props.m_tile_count_x);
         assert(tile_y < props.m_tile_count_y);
 
+        // Skip tiles that were already rendered for this pass.
+        if (frame.has_checkpointed_tile(tile_x, tile_y, pass))
+            continue;
+
         // Create the tile job.
         tile_jobs.push_back(
             new TileJob(
                 tile_renderers,
                 tile_callbacks,
+                framebuffer_factory,
                 frame,
                 tile_x,
                 tile_y,
+                pass,
                 pass_hash,
                 spectrum_mode,
+                texture_prefetcher,
+                streaming_denoiser,
                 abort_switch));
     }
 }
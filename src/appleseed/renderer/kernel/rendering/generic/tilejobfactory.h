@@ -45,6 +45,9 @@
 namespace foundation    { class CanvasProperties; }
 namespace foundation    { class IAbortSwitch; }
 namespace renderer      { class Frame; }
+namespace renderer      { class IShadingResultFrameBufferFactory; }
+namespace renderer      { class StreamingDenoiser; }
+namespace renderer      { class TexturePrefetcher; }
 namespace renderer      { class TileJob; }
 
 namespace renderer
@@ -68,14 +71,19 @@ class TileJobFactory
         RandomOrdering
     };
 
-    // Create tile jobs for a given frame.
+    // Create tile jobs for a given pass of a given frame. Tiles that were
+    // restored from a checkpoint at this pass or later are skipped.
     void create(
         const Frame&                        frame,
         const TileOrdering                  tile_ordering,
         const TileJob::TileRendererVector&  tile_renderers,
         const TileJob::TileCallbackVector&  tile_callbacks,
+        IShadingResultFrameBufferFactory*   framebuffer_factory,
+        const size_t                        pass,
         const foundation::uint32            pass_hash,
         const Spectrum::Mode                spectrum_mode,
+        TexturePrefetcher*                  texture_prefetcher,     // may be nullptr
+        StreamingDenoiser*                  streaming_denoiser,     // may be nullptr
         TileJobVector&                      tile_jobs,
         foundation::IAbortSwitch&           abort_switch);
 
@@ -31,6 +31,8 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/shading/shadingresult.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/iunknown.h"
@@ -42,8 +44,6 @@
 // Forward declarations.
 namespace foundation    { class StatisticsVector; }
 namespace renderer      { class AOVAccumulatorContainer; }
-namespace renderer      { class PixelContext; }
-namespace renderer      { class ShadingResult; }
 
 namespace renderer
 {
@@ -68,11 +68,46 @@ class ISampleRenderer
         AOVAccumulatorContainer&        aov_accumulators,
         ShadingResult&                  shading_result) = 0;
 
+    // Render a batch of samples, typically belonging to the same pixel. The default
+    // implementation renders the samples one by one; sample renderers may override it
+    // to trace the camera rays of the batch together.
+    virtual void render_samples(
+        const size_t                    sample_count,
+        SamplingContext*                sampling_contexts,
+        const PixelContext*             pixel_contexts,
+        const foundation::Vector2d*     image_points,
+        AOVAccumulatorContainer&        aov_accumulators,
+        ShadingResult*                  shading_results);
+
     // Retrieve performance statistics.
     virtual foundation::StatisticsVector get_statistics() const = 0;
 };
 
 
+//
+// ISampleRenderer class implementation.
+//
+
+inline void ISampleRenderer::render_samples(
+    const size_t                        sample_count,
+    SamplingContext*                    sampling_contexts,
+    const PixelContext*                 pixel_contexts,
+    const foundation::Vector2d*         image_points,
+    AOVAccumulatorContainer&            aov_accumulators,
+    ShadingResult*                      shading_results)
+{
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        render_sample(
+            sampling_contexts[i],
+            pixel_contexts[i],
+            image_points[i],
+            aov_accumulators,
+            shading_results[i]);
+    }
+}
+
+
 //
 // Interface of a ISampleRenderer factory.
 //
@@ -66,11 +66,13 @@
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
+#include "foundation/utility/uid.h"
 
 // Standard headers.
 #include <algorithm>
 #include <cassert>
 #include <exception>
+#include <memory>
 #include <new>
 #include <string>
 #include <vector>
@@ -121,6 +123,10 @@ struct MasterRenderer::Impl
 
     OIIOTextureSystem*                  m_texture_system;
 
+    unique_ptr<TextureStore>            m_texture_store;
+    UniqueID                            m_texture_store_scene_uid;
+    ParamArray                          m_texture_store_params;
+
     RendererServices*                   m_renderer_services;
     OSLShadingSystem*                   m_shading_system;
     auto_release_ptr<ShaderCompiler>    m_osl_compiler;
@@ -142,6 +148,7 @@ struct MasterRenderer::Impl
       : m_project(project)
       , m_params(params)
       , m_resource_search_paths(resource_search_paths)
+      , m_texture_store_scene_uid(~UniqueID(0))
       , m_serial_renderer_controller(nullptr)
       , m_serial_tile_callback_factory(nullptr)
       , m_display(nullptr)
@@ -198,6 +205,9 @@ struct MasterRenderer::Impl
         delete m_serial_tile_callback_factory;
         delete m_serial_renderer_controller;
 
+        // The texture store refers to the scene, destroy it first.
+        m_texture_store.reset();
+
         RENDERER_LOG_DEBUG("destroying osl shading system...");
         m_project.get_scene()->release_optimized_osl_shader_groups();
         m_shading_system->release();
@@ -242,6 +252,11 @@ struct MasterRenderer::Impl
             m_texture_system->invalidate_all(true);
             m_texture_system->attribute("searchpath", project_search_paths);
         }
+        else
+        {
+            // Only forget about the texture files that changed on disk since the last render.
+            m_texture_system->invalidate_all(false);
+        }
 
         // Also use the project search paths to look for OpenImageIO plugins.
         m_texture_system->attribute("plugin_searchpath", project_search_paths);
@@ -423,10 +438,22 @@ struct MasterRenderer::Impl
         // Construct an abort switch that will allow to abort initialization or rendering.
         RendererControllerAbortSwitch abort_switch(*m_renderer_controller);
 
-        // Create the texture store.
-        TextureStore texture_store(
-            *m_project.get_scene(),
-            m_params.child("texture_store"));
+        // Create the texture store, or reuse the one from the previous render of the same scene.
+        const Scene& scene = *m_project.get_scene();
+        const ParamArray& texture_store_params = m_params.child("texture_store");
+        if (m_texture_store.get() == nullptr ||
+            m_texture_store_scene_uid != scene.get_uid() ||
+            m_texture_store_params != texture_store_params)
+        {
+            m_texture_store.reset();    // release the old tiles before creating the new store
+            m_texture_store.reset(new TextureStore(scene, texture_store_params));
+            m_texture_store_scene_uid = scene.get_uid();
+            m_texture_store_params = texture_store_params;
+        }
+
+        // Drop the tiles of textures that changed since the previous render.
+        m_texture_store->update(m_project.search_paths());
+        TextureStore& texture_store = *m_texture_store;
 
         // Initialize OSL's shading system.
         if (!initialize_osl_shading_system(texture_store, abort_switch) ||
@@ -475,6 +502,12 @@ struct MasterRenderer::Impl
              RENDERER_LOG_INFO("using Intel Embree ray tracing kernel.");
         else RENDERER_LOG_INFO("using built-in ray tracing kernel.");
 
+        // Persist ray tracing acceleration structures across renders if a cache directory is set.
+        const ParamArray& tree_cache_params = m_params.child("tree_cache");
+        m_project.set_tree_cache(
+            tree_cache_params.get_optional<string>("directory", "").c_str(),
+            tree_cache_params.get_optional<uint64>("max_size", 8ULL * 1024 * 1024 * 1024));
+
         // Updating the trace context causes ray tracing acceleration structures to be updated or rebuilt.
         m_project.update_trace_context();
 
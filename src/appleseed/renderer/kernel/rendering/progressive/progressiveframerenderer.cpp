@@ -121,7 +121,7 @@ namespace
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                    JobManager::KeepRunningOnEmptyQueue | m_params.m_thread_flags));
 
             // Instantiate sample generators, one per rendering thread.
             m_sample_generators.reserve(m_params.m_thread_count);
@@ -196,6 +196,8 @@ namespace
                 "  spectrum mode                 %s\n"
                 "  sampling mode                 %s\n"
                 "  rendering threads             %s\n"
+                "  work stealing                 %s\n"
+                "  pinned rendering threads      %s\n"
                 "  max average samples per pixel %s\n"
                 "  max fps                       %f\n"
                 "  collect performance stats     %s\n"
@@ -203,6 +205,8 @@ namespace
                 get_spectrum_mode_name(m_params.m_spectrum_mode).c_str(),
                 get_sampling_context_mode_name(m_params.m_sampling_mode).c_str(),
                 pretty_uint(m_params.m_thread_count).c_str(),
+                m_params.m_thread_flags & JobManager::WorkStealing ? "on" : "off",
+                m_params.m_thread_flags & JobManager::PinWorkerThreads ? "on" : "off",
                 m_params.m_max_average_spp == numeric_limits<uint64>::max()
                     ? "unlimited"
                     : pretty_uint(m_params.m_max_average_spp).c_str(),
@@ -365,6 +369,7 @@ namespace
             const Spectrum::Mode        m_spectrum_mode;
             const SamplingContext::Mode m_sampling_mode;
             const size_t                m_thread_count;       // number of rendering threads
+            const int                   m_thread_flags;       // scheduling flags of the rendering threads
             const uint64                m_max_average_spp;    // maximum average number of samples to compute per pixel
             const double                m_max_fps;            // maximum display frequency in frames/second
             const bool                  m_perf_stats;         // collect and print performance statistics?
@@ -374,6 +379,7 @@ namespace
               : m_spectrum_mode(get_spectrum_mode(params))
               , m_sampling_mode(get_sampling_context_mode(params))
               , m_thread_count(get_rendering_thread_count(params))
+              , m_thread_flags(get_rendering_thread_flags(params))
               , m_max_average_spp(params.get_optional<uint64>("max_average_spp", numeric_limits<uint64>::max()))
               , m_max_fps(params.get_optional<double>("max_fps", 30.0))
               , m_perf_stats(params.get_optional<bool>("performance_statistics", false))
@@ -33,7 +33,9 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/lighting/bdpt/bdptlightingengine.h"
 #include "renderer/kernel/lighting/lighttracing/lighttracingsamplegenerator.h"
+#include "renderer/kernel/lighting/pathguidingpasscallback.h"
 #include "renderer/kernel/lighting/pt/ptlightingengine.h"
+#include "renderer/kernel/lighting/sdtree.h"
 #include "renderer/kernel/lighting/sppm/sppmlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
 #include "renderer/kernel/lighting/sppm/sppmpasscallback.h"
@@ -95,6 +97,8 @@ namespace
         copy_param(child, source, "spectrum_mode");
         copy_param(child, source, "sampling_mode");
         copy_param(child, source, "rendering_threads");
+        copy_param(child, source, "work_stealing");
+        copy_param(child, source, "pin_rendering_threads");
         return child;
     }
 }
@@ -188,11 +192,22 @@ bool RendererComponents::create_lighting_engine_factory()
                 m_scene,
                 get_child_and_inherit_globals(m_params, "light_sampler")));
 
+        const ParamArray pt_params = get_child_and_inherit_globals(m_params, "pt");    // todo: change to "pt_lighting_engine"?
+        const GuidingParameters guiding_params(pt_params);
+
+        PathGuidingPassCallback* guiding_pass_callback = nullptr;
+        if (guiding_params.m_enabled)
+        {
+            guiding_pass_callback = new PathGuidingPassCallback(m_scene, guiding_params);
+            m_pass_callback.reset(guiding_pass_callback);
+        }
+
         m_lighting_engine_factory.reset(
             new PTLightingEngineFactory(
                 *m_backward_light_sampler,
                 m_project.get_light_path_recorder(),
-                get_child_and_inherit_globals(m_params, "pt")));    // todo: change to "pt_lighting_engine"?
+                pt_params,
+                guiding_pass_callback ? &guiding_pass_callback->get_tree() : nullptr));
 
         return true;
     }
@@ -549,6 +564,7 @@ bool RendererComponents::create_frame_renderer_factory()
                 m_tile_renderer_factory.get(),
                 m_tile_callback_factory,
                 m_pass_callback.get(),
+                &m_texture_store,
                 get_child_and_inherit_globals(m_params, "generic_frame_renderer")));
 
         return true;
@@ -567,6 +583,9 @@ bool RendererComponents::create_frame_renderer_factory()
             return false;
         }
 
+        if (dynamic_cast<PathGuidingPassCallback*>(m_pass_callback.get()) != nullptr)
+            RENDERER_LOG_WARNING("path guiding is not supported by the progressive frame renderer and will be disabled.");
+
         m_frame_renderer.reset(
             ProgressiveFrameRendererFactory::create(
                 m_project,
@@ -0,0 +1,321 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "streamingexrtilecallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/rendering/tilecallbackbase.h"
+#include "renderer/modeling/aov/aov.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/filesystem.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tiledexrimagefilewriter.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    //
+    // StreamingEXRTileCallback.
+    //
+
+    class StreamingEXRTileCallback
+      : public TileCallbackBase
+    {
+      public:
+        StreamingEXRTileCallback(
+            const char*     file_path,
+            const size_t    pass_count)
+          : m_file_path(file_path)
+          , m_pass_count(pass_count)
+          , m_frame_begun(false)
+          , m_tile_count_x(0)
+          , m_tile_count(0)
+          , m_written_tile_count(0)
+          , m_failed(false)
+        {
+        }
+
+        void release() override
+        {
+            // The factory always return the same tile callback instance.
+            // Prevent this instance from being destroyed by doing nothing here.
+        }
+
+        void on_tiled_frame_begin(const Frame* frame) override
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            // This method is called on the tile callback of each rendering thread, before each pass.
+            if (m_frame_begun)
+                return;
+
+            m_frame_begun = true;
+
+            if (can_stream(*frame))
+                open(*frame);
+        }
+
+        void on_tile_end(
+            const Frame*    frame,
+            const size_t    tile_x,
+            const size_t    tile_y) override
+        {
+            if (m_writer.get() == nullptr || m_failed)
+                return;
+
+            // Only write the tile once it is final.
+            const size_t tile_index = tile_y * m_tile_count_x + tile_x;
+            if (atomic_dec(&m_remaining_tile_ends[tile_index]) != 1)
+                return;
+
+            write_tile(*frame, tile_x, tile_y);
+        }
+
+        bool is_complete() const
+        {
+            return m_tile_count > 0 && m_written_tile_count == m_tile_count;
+        }
+
+      private:
+        const string                                m_file_path;
+        const size_t                                m_pass_count;
+        boost::mutex                                m_mutex;
+        bool                                        m_frame_begun;
+        unique_ptr<TiledEXRImageFileWriter>         m_writer;
+        size_t                                      m_tile_count_x;
+        size_t                                      m_tile_count;
+        vector<uint32>                              m_remaining_tile_ends;
+        boost::atomic<size_t>                       m_written_tile_count;
+        boost::atomic<bool>                         m_failed;
+        Stopwatch<DefaultWallclockTimer>            m_stopwatch;
+
+        bool can_stream(const Frame& frame) const
+        {
+            const char* reason = nullptr;
+
+            if (frame.get_denoising_mode() == Frame::DenoisingMode::WriteOutputs)
+                reason = "denoiser outputs are written separately";
+            else if (!frame.post_processing_stages().empty())
+                reason = "post-processing stages are applied after rendering";
+            else
+            {
+                for (const AOV& aov : frame.aovs())
+                {
+                    if (aov.is_image_post_processed())
+                    {
+                        reason = "some aovs are post-processed after rendering";
+                        break;
+                    }
+                }
+            }
+
+            if (reason == nullptr)
+                return true;
+
+            RENDERER_LOG_WARNING(
+                "cannot write %s while rendering because %s.",
+                m_file_path.c_str(),
+                reason);
+
+            return false;
+        }
+
+        void open(const Frame& frame)
+        {
+            const CanvasProperties& props = frame.image().properties();
+
+            m_stopwatch.start();
+
+            try
+            {
+                create_parent_directories(m_file_path.c_str());
+
+                m_writer.reset(new TiledEXRImageFileWriter(m_file_path.c_str()));
+                frame.append_main_and_aov_parts(*m_writer);
+                m_writer->open();
+            }
+            catch (const ExceptionIOError& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "failed to open image file %s for writing: %s.",
+                    m_file_path.c_str(),
+                    e.what());
+
+                m_writer.reset();
+                return;
+            }
+
+            // Count how many times on_tile_end() will be called on each tile. Tiles restored
+            // from a checkpoint skip passes, and the denoiser notifies all tiles once more.
+            const size_t initial_pass = frame.get_initial_pass();
+            const bool denoising = frame.get_denoising_mode() == Frame::DenoisingMode::Denoise;
+
+            m_tile_count_x = props.m_tile_count_x;
+            m_tile_count = props.m_tile_count;
+            m_remaining_tile_ends.assign(m_tile_count, 0);
+
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                {
+                    uint32 tile_end_count = denoising ? 1 : 0;
+
+                    for (size_t pass = initial_pass; pass < m_pass_count; ++pass)
+                    {
+                        if (!frame.has_checkpointed_tile(tx, ty, pass))
+                            ++tile_end_count;
+                    }
+
+                    m_remaining_tile_ends[ty * m_tile_count_x + tx] = tile_end_count;
+                }
+            }
+
+            // Tiles that are not rendered anymore are already final.
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                {
+                    if (m_remaining_tile_ends[ty * m_tile_count_x + tx] == 0)
+                        write_tile(frame, tx, ty);
+                }
+            }
+        }
+
+        void write_tile(
+            const Frame&    frame,
+            const size_t    tile_x,
+            const size_t    tile_y)
+        {
+            try
+            {
+                const Image& image = frame.image();
+                m_writer->write_tile(0, tile_x, tile_y, image.tile(tile_x, tile_y));
+
+                size_t part_index = 1;
+                for (const AOV& aov : frame.aovs())
+                {
+                    const Image& aov_image = aov.get_image();
+                    m_writer->write_tile(part_index++, tile_x, tile_y, aov_image.tile(tile_x, tile_y));
+                }
+            }
+            catch (const ExceptionIOError& e)
+            {
+                // Report the first failure only and stop writing.
+                if (!m_failed.exchange(true))
+                {
+                    RENDERER_LOG_ERROR(
+                        "failed to write tile (" FMT_SIZE_T ", " FMT_SIZE_T ") to image file %s: %s.",
+                        tile_x,
+                        tile_y,
+                        m_file_path.c_str(),
+                        e.what());
+                }
+
+                return;
+            }
+
+            // The thread that writes the last tile closes the file.
+            if (++m_written_tile_count == m_tile_count)
+            {
+                m_writer->close();
+
+                m_stopwatch.measure();
+
+                RENDERER_LOG_INFO(
+                    "wrote multipart exr image file %s while rendering in %s.",
+                    m_file_path.c_str(),
+                    pretty_time(m_stopwatch.get_seconds()).c_str());
+            }
+        }
+    };
+}
+
+
+//
+// StreamingEXRTileCallbackFactory class implementation.
+//
+
+struct StreamingEXRTileCallbackFactory::Impl
+{
+    unique_ptr<StreamingEXRTileCallback> m_callback;
+};
+
+StreamingEXRTileCallbackFactory::StreamingEXRTileCallbackFactory(
+    const char*     file_path,
+    const size_t    pass_count)
+  : impl(new Impl())
+{
+    impl->m_callback.reset(new StreamingEXRTileCallback(file_path, pass_count));
+}
+
+StreamingEXRTileCallbackFactory::~StreamingEXRTileCallbackFactory()
+{
+    delete impl;
+}
+
+void StreamingEXRTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* StreamingEXRTileCallbackFactory::create()
+{
+    return impl->m_callback.get();
+}
+
+bool StreamingEXRTileCallbackFactory::is_complete() const
+{
+    return impl->m_callback->is_complete();
+}
+
+}   // namespace renderer
@@ -0,0 +1,85 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/itilecallback.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace renderer
+{
+
+//
+// A tile callback factory whose tile callback writes the main image and the AOV images
+// to a tiled multipart OpenEXR file as tiles are rendered, instead of after rendering.
+//
+// A tile is written once it reaches its final state, i.e. after the last rendering pass,
+// or after denoising if the denoiser is enabled. The file remains readable while it is
+// being written, with the tiles that are not rendered yet missing from it.
+//
+// Frames whose images are modified after rendering (by post-processing stages, or by AOVs
+// that post-process their image) cannot be streamed: in that case nothing is written and
+// is_complete() returns false, and the frame must be written after rendering as usual.
+// Only tile-based frame renderers invoke the callback.
+//
+// A factory must only be used for a single render.
+//
+
+class APPLESEED_DLLSYMBOL StreamingEXRTileCallbackFactory
+  : public ITileCallbackFactory
+{
+  public:
+    // Constructor.
+    StreamingEXRTileCallbackFactory(
+        const char*     file_path,
+        const size_t    pass_count);
+
+    // Destructor.
+    ~StreamingEXRTileCallbackFactory() override;
+
+    // Delete this instance.
+    void release() override;
+
+    // Return a new tile callback instance.
+    ITileCallback* create() override;
+
+    // Return true if all tiles of the frame were written to the file.
+    bool is_complete() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace renderer
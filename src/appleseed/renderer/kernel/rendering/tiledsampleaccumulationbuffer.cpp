@@ -0,0 +1,278 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "tiledsampleaccumulationbuffer.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/sample.h"
+#include "renderer/modeling/frame/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/job/iabortswitch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// TiledSampleAccumulationBuffer class implementation.
+//
+
+struct TiledSampleAccumulationBuffer::TileStorage
+{
+    mutable Spinlock    m_lock;
+    size_t              m_width;
+    size_t              m_height;
+    vector<float>       m_pixels;       // RGB, unnormalized
+};
+
+TiledSampleAccumulationBuffer::TiledSampleAccumulationBuffer(
+    const size_t    width,
+    const size_t    height,
+    const size_t    tile_width,
+    const size_t    tile_height)
+  : m_width(width)
+  , m_height(height)
+  , m_tile_width(tile_width)
+  , m_tile_height(tile_height)
+  , m_tile_count_x((width + tile_width - 1) / tile_width)
+  , m_tile_count_y((height + tile_height - 1) / tile_height)
+  , m_tiles(new TileStorage[m_tile_count_x * m_tile_count_y])
+  , m_radix_pass_count(1)
+{
+    // Number of bytes needed to represent the largest tile index.
+    for (size_t i = (m_tile_count_x * m_tile_count_y - 1) >> 8; i > 0; i >>= 8)
+        ++m_radix_pass_count;
+
+    for (size_t ty = 0; ty < m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < m_tile_count_x; ++tx)
+        {
+            TileStorage& storage = m_tiles[ty * m_tile_count_x + tx];
+            storage.m_width = min(m_tile_width, m_width - tx * m_tile_width);
+            storage.m_height = min(m_tile_height, m_height - ty * m_tile_height);
+            storage.m_pixels.resize(storage.m_width * storage.m_height * 3);
+        }
+    }
+
+    clear();
+}
+
+TiledSampleAccumulationBuffer::~TiledSampleAccumulationBuffer()
+{
+    delete[] m_tiles;
+}
+
+void TiledSampleAccumulationBuffer::clear()
+{
+    m_sample_count = 0;
+
+    for (size_t i = 0, e = m_tile_count_x * m_tile_count_y; i < e; ++i)
+    {
+        TileStorage& storage = m_tiles[i];
+        Spinlock::ScopedLock lock(storage.m_lock);
+        fill(storage.m_pixels.begin(), storage.m_pixels.end(), 0.0f);
+    }
+}
+
+void TiledSampleAccumulationBuffer::store_samples(
+    const size_t    sample_count,
+    const Sample    samples[],
+    IAbortSwitch&   abort_switch)
+{
+    // Bin the samples by tile in chunks small enough to be sorted on the stack: storing
+    // samples never allocates memory and costs nothing for tiles that receive no sample.
+    const size_t ChunkSize = 256;
+    uint64 keys[ChunkSize];     // tile index in the high 32 bits, sample index in the low 32 bits
+    uint64 temp[ChunkSize];
+
+    assert(sample_count <= 0xFFFFFFFFu);
+
+    for (size_t chunk_begin = 0; chunk_begin < sample_count; chunk_begin += ChunkSize)
+    {
+        const size_t chunk_size = min(ChunkSize, sample_count - chunk_begin);
+
+        for (size_t i = 0; i < chunk_size; ++i)
+        {
+            const Vector2i& p = samples[chunk_begin + i].m_pixel_coords;
+            assert(p.x >= 0 && static_cast<size_t>(p.x) < m_width);
+            assert(p.y >= 0 && static_cast<size_t>(p.y) < m_height);
+
+            const size_t tile_index =
+                  (static_cast<size_t>(p.y) / m_tile_height) * m_tile_count_x
+                + static_cast<size_t>(p.x) / m_tile_width;
+
+            keys[i] = (static_cast<uint64>(tile_index) << 32) | static_cast<uint64>(chunk_begin + i);
+        }
+
+        // Radix sort the keys on the bytes of their tile index. Each pass is stable,
+        // so the samples of a given tile remain in their original order.
+        uint64* sorted_keys = keys;
+        uint64* other_keys = temp;
+
+        for (size_t pass = 0; pass < m_radix_pass_count; ++pass)
+        {
+            const size_t shift = 32 + pass * 8;
+
+            size_t offsets[257];
+            fill(offsets, offsets + 257, 0);
+
+            for (size_t i = 0; i < chunk_size; ++i)
+                ++offsets[((sorted_keys[i] >> shift) & 0xFF) + 1];
+
+            for (size_t i = 0; i < 256; ++i)
+                offsets[i + 1] += offsets[i];
+
+            for (size_t i = 0; i < chunk_size; ++i)
+                other_keys[offsets[(sorted_keys[i] >> shift) & 0xFF]++] = sorted_keys[i];
+
+            std::swap(sorted_keys, other_keys);
+        }
+
+        // Merge each run of samples into its tile, taking the tile's lock only once per run.
+        size_t run_begin = 0;
+
+        while (run_begin < chunk_size)
+        {
+            if (abort_switch.is_aborted())
+                return;
+
+            const size_t t = static_cast<size_t>(sorted_keys[run_begin] >> 32);
+
+            size_t run_end = run_begin + 1;
+            while (run_end < chunk_size && static_cast<size_t>(sorted_keys[run_end] >> 32) == t)
+                ++run_end;
+
+            const size_t origin_x = (t % m_tile_count_x) * m_tile_width;
+            const size_t origin_y = (t / m_tile_count_x) * m_tile_height;
+
+            TileStorage& storage = m_tiles[t];
+            Spinlock::ScopedLock lock(storage.m_lock);
+
+            for (size_t i = run_begin; i < run_end; ++i)
+            {
+                const Sample& s = samples[sorted_keys[i] & 0xFFFFFFFFu];
+
+                const size_t x = static_cast<size_t>(s.m_pixel_coords.x) - origin_x;
+                const size_t y = static_cast<size_t>(s.m_pixel_coords.y) - origin_y;
+
+                float* ptr = &storage.m_pixels[(y * storage.m_width + x) * 3];
+                ptr[0] += s.m_color[0];
+                ptr[1] += s.m_color[1];
+                ptr[2] += s.m_color[2];
+            }
+
+            run_begin = run_end;
+        }
+    }
+}
+
+void TiledSampleAccumulationBuffer::develop_to_frame(
+    Frame&          frame,
+    IAbortSwitch&   abort_switch)
+{
+    Image& image = frame.image();
+    const CanvasProperties& frame_props = image.properties();
+
+    assert(frame_props.m_canvas_width == m_width);
+    assert(frame_props.m_canvas_height == m_height);
+    assert(frame_props.m_tile_width == m_tile_width);
+    assert(frame_props.m_tile_height == m_tile_height);
+    assert(frame_props.m_channel_count == 4);
+
+    const uint64 sample_count = m_sample_count;
+    const float scale = sample_count > 0 ? 1.0f / sample_count : 0.0f;
+
+    for (size_t ty = 0; ty < m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < m_tile_count_x; ++tx)
+        {
+            if (abort_switch.is_aborted())
+                return;
+
+            develop_to_tile(
+                image.tile(tx, ty),
+                m_tiles[ty * m_tile_count_x + tx],
+                scale);
+        }
+    }
+}
+
+void TiledSampleAccumulationBuffer::increment_sample_count(const uint64 delta_sample_count)
+{
+    m_sample_count += delta_sample_count;
+}
+
+void TiledSampleAccumulationBuffer::develop_to_tile(
+    Tile&               tile,
+    const TileStorage&  storage,
+    const float         scale) const
+{
+    assert(tile.get_width() == storage.m_width);
+    assert(tile.get_height() == storage.m_height);
+
+    // Take a snapshot of the tile so that its lock is only held during a plain copy.
+    // The conversion to the frame's pixel format then happens outside of the lock.
+    vector<float> pixels;
+    {
+        Spinlock::ScopedLock lock(storage.m_lock);
+        pixels = storage.m_pixels;
+    }
+
+    const float* ptr = &pixels[0];
+
+    for (size_t y = 0; y < storage.m_height; ++y)
+    {
+        for (size_t x = 0; x < storage.m_width; ++x, ptr += 3)
+        {
+            const Color4f color(
+                ptr[0] * scale,
+                ptr[1] * scale,
+                ptr[2] * scale,
+                1.0f);
+
+            tile.set_pixel(x, y, color);
+        }
+    }
+}
+
+}   // namespace renderer
@@ -54,6 +54,9 @@ OSLShaderGroupExec::OSLShaderGroupExec(OSLShadingSystem& shading_system, Arena&
   , m_arena(arena)
   , m_osl_thread_info(shading_system.create_thread_info())
   , m_osl_shading_context(shading_system.get_context(m_osl_thread_info))
+  , m_last_shading_point(nullptr)
+  , m_last_shader_group(nullptr)
+  , m_last_ray_flags(0)
 {
 }
 
@@ -192,6 +195,9 @@ Color3f OSLShaderGroupExec::execute_background(
     sg.renderer = m_osl_shading_system.renderer();
     sg.raytype = VisibilityFlags::CameraRay;
 
+    // This execution overwrites the closures of the last shading point.
+    m_last_shading_point = nullptr;
+
     m_osl_shading_system.execute(
         m_osl_shading_context,
         *reinterpret_cast<OSL::ShaderGroup*>(shader_group.osl_shader_group()),
@@ -208,6 +214,12 @@ void OSLShaderGroupExec::do_execute(
     assert(m_osl_shading_context);
     assert(m_osl_thread_info);
 
+    // The same shading point is commonly shaded several times in a row with
+    // different ray types, e.g. for transparency, then for its BSDF, then for
+    // its emission. Skip the execution if it cannot change the closures.
+    if (can_reuse_last_execution(shader_group, shading_point, ray_flags))
+        return;
+
     shading_point.initialize_osl_shader_globals(
         shader_group,
         ray_flags,
@@ -217,6 +229,36 @@ void OSLShaderGroupExec::do_execute(
         m_osl_shading_context,
         *reinterpret_cast<OSL::ShaderGroup*>(shader_group.osl_shader_group()),
         shading_point.get_osl_shader_globals());
+
+    shading_point.m_members |= ShadingPoint::HasOSLShadingResult;
+    m_last_shading_point = &shading_point;
+    m_last_shader_group = &shader_group;
+    m_last_ray_flags = ray_flags;
+}
+
+bool OSLShaderGroupExec::can_reuse_last_execution(
+    const ShaderGroup&              shader_group,
+    const ShadingPoint&             shading_point,
+    const VisibilityFlags::Type     ray_flags) const
+{
+    // The closures live in the OSL shading context and are overwritten by any
+    // other execution. Shading points are recycled, so also make sure this one
+    // was not cleared since it was shaded.
+    if (m_last_shading_point != &shading_point ||
+        m_last_shader_group != &shader_group ||
+        !shading_point.has_osl_shading_result())
+        return false;
+
+    // The shader group must not be able to tell the two ray types apart.
+    if ((m_last_ray_flags ^ ray_flags) & shader_group.get_raytype_queries())
+        return false;
+
+    // The surface area global is only set for light rays on emissive groups.
+    if (shader_group.has_emission() &&
+        (m_last_ray_flags == VisibilityFlags::LightRay) != (ray_flags == VisibilityFlags::LightRay))
+        return false;
+
+    return true;
 }
 
 void OSLShaderGroupExec::choose_bsdf_closure_shading_basis(
@@ -77,6 +77,11 @@ class OSLShaderGroupExec
     char*                               m_osl_mem_pool_start;
     mutable size_t                      m_osl_mem_used;
 
+    // Last shader group execution, whose closures are still valid.
+    mutable const ShadingPoint*         m_last_shading_point;
+    mutable const ShaderGroup*          m_last_shader_group;
+    mutable VisibilityFlags::Type       m_last_ray_flags;
+
     void execute_shading(
         const ShaderGroup&              shader_group,
         const ShadingPoint&             shading_point) const;
@@ -121,6 +126,11 @@ class OSLShaderGroupExec
         const ShadingPoint&             shading_point,
         const VisibilityFlags::Type     ray_flags) const;
 
+    bool can_reuse_last_execution(
+        const ShaderGroup&              shader_group,
+        const ShadingPoint&             shading_point,
+        const VisibilityFlags::Type     ray_flags) const;
+
     void choose_bsdf_closure_shading_basis(
         const ShadingPoint&             shading_point,
         const foundation::Vector2f&     s) const;
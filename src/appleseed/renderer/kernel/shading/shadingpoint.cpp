@@ -80,7 +80,8 @@ void ShadingPoint::flip_side()
     //      could have consequences if not taken into account.
     //
     //   2. All precomputed values are lost and will need to be recomputed
-    //      if they are needed.
+    //      if they are needed. This includes the results of the last OSL
+    //      shader group execution, which were computed on the other side.
     //
 
     const double t = 2.0 * m_ray.m_tmax;
@@ -149,6 +150,9 @@ void ShadingPoint::flip_side()
         m_shader_globals.backfacing = 1 - m_shader_globals.backfacing;
     }
 
+    // The closures of the last OSL shader group execution were computed on the other side.
+    m_members &= ~HasOSLShadingResult;
+
 #endif
 }
 
@@ -134,6 +134,10 @@ class ShadingPoint
     // Return true if the shading point is located inside a participating medium.
     bool hit_volume() const;
 
+    // Return true if the OSL closures of the last shader group execution were computed at
+    // this shading point and are still valid, i.e. its geometry did not change since then.
+    bool has_osl_shading_result() const;
+
     // Return the type of the hit primitive.
     PrimitiveType get_primitive_type() const;
     bool is_triangle_primitive() const;
@@ -272,6 +276,7 @@ class ShadingPoint
     };
 
   private:
+    friend class AssemblyLeafPacketVisitor;
     friend class AssemblyLeafProbeVisitor;
     friend class AssemblyLeafVisitor;
     friend class CurveLeafVisitor;
@@ -281,6 +286,7 @@ class ShadingPoint
     friend class OSLShaderGroupExec;
     friend class RendererServices;
     friend class ShadingPointBuilder;
+    friend class TriangleLeafPacketVisitor;
     friend class TriangleLeafVisitor;
     friend class foundation::PoisonImpl<ShadingPoint>;
 
@@ -323,7 +329,8 @@ class ShadingPoint
         HasAlpha                        = 1UL << 14,
         HasPerVertexColor               = 1UL << 15,
         HasScreenSpaceDerivatives       = 1UL << 16,
-        HasOSLShaderGlobals             = 1UL << 17
+        HasOSLShaderGlobals             = 1UL << 17,
+        HasOSLShadingResult             = 1UL << 18
     };
     mutable foundation::uint32          m_members;
 
@@ -472,6 +479,9 @@ inline void ShadingPoint::set_ray(const ShadingRay& ray)
 {
     assert(foundation::is_normalized(ray.m_dir));
     m_ray = ray;
+
+    // The incoming direction and possibly the side of the shading point changed.
+    m_members &= ~HasOSLShadingResult;
 }
 
 inline const ShadingRay& ShadingPoint::get_ray() const
@@ -494,6 +504,11 @@ inline bool ShadingPoint::hit_surface() const
     return is_valid() && !hit_volume();
 }
 
+inline bool ShadingPoint::has_osl_shading_result() const
+{
+    return (m_members & HasOSLShadingResult) != 0;
+}
+
 inline bool ShadingPoint::hit_volume() const
 {
     return m_primitive_type == PrimitiveVolume;
@@ -735,6 +750,9 @@ inline void ShadingPoint::set_shading_basis(const foundation::Basis3d& basis) co
     m_shading_basis = basis;
     m_members |= HasShadingBasis;
     m_members &= ~HasScreenSpaceDerivatives;
+
+    // Closures computed with the previous shading normal are no longer valid (e.g. after bump mapping).
+    m_members &= ~HasOSLShadingResult;
 }
 
 inline const foundation::Basis3d& ShadingPoint::get_shading_basis() const
@@ -38,6 +38,8 @@ namespace renderer
 ShadingPointBuilder::ShadingPointBuilder(ShadingPoint& shading_point)
   : m_shading_point(shading_point)
 {
+    // The geometry of the shading point is about to change.
+    m_shading_point.m_members &= ~ShadingPoint::HasOSLShadingResult;
 }
 
 void ShadingPointBuilder::set_scene(const Scene* scene)
@@ -94,4 +96,9 @@ void ShadingPointBuilder::set_uvs(const Vector2f& uv)
     m_shading_point.m_members |= ShadingPoint::HasUV0;
 }
 
+void ShadingPointBuilder::set_osl_shading_result()
+{
+    m_shading_point.m_members |= ShadingPoint::HasOSLShadingResult;
+}
+
 }   // namespace renderer
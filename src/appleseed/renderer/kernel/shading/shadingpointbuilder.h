@@ -66,6 +66,9 @@ class ShadingPointBuilder
     void set_shading_basis(const foundation::Basis3d& basis);
     void set_uvs(const foundation::Vector2f& uv);
 
+    // Mark the shading point as if a shader group had just been executed on it.
+    void set_osl_shading_result();
+
   private:
     ShadingPoint& m_shading_point;
 };
@@ -35,6 +35,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/aliasablevector.h"
 #include "foundation/utility/attributeset.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/numerictype.h"
@@ -61,9 +62,10 @@ class StaticTessellation
     typedef Primitive PrimitiveType;
 
     // Vertex and primitive array types.
+    // These arrays may alias external storage such as a memory-mapped mesh file.
     // todo: use paged arrays?
-    typedef std::vector<GVector3> VectorArray;
-    typedef std::vector<PrimitiveType> PrimitiveArray;
+    typedef foundation::AliasableVector<GVector3> VectorArray;
+    typedef foundation::AliasableVector<PrimitiveType> PrimitiveArray;
 
     // Primary features.
     VectorArray                 m_vertices;
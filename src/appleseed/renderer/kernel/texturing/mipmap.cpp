@@ -0,0 +1,150 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "mipmap.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+size_t get_mip_level_count(const CanvasProperties& props)
+{
+    size_t level_count = 1;
+
+    for (size_t size = max(props.m_canvas_width, props.m_canvas_height); size > 1; size /= 2)
+        ++level_count;
+
+    return level_count;
+}
+
+CanvasProperties get_mip_level_properties(
+    const CanvasProperties&     props,
+    const size_t                level)
+{
+    assert(level < get_mip_level_count(props));
+
+    return
+        CanvasProperties(
+            max<size_t>(props.m_canvas_width >> level, 1),
+            max<size_t>(props.m_canvas_height >> level, 1),
+            props.m_tile_width,
+            props.m_tile_height,
+            props.m_channel_count,
+            props.m_pixel_format);
+}
+
+Tile* downsample_mip_tile(
+    const CanvasProperties&     fine_level_props,
+    const CanvasProperties&     coarse_level_props,
+    const size_t                tile_x,
+    const size_t                tile_y,
+    const Tile* const           fine_tiles[4])
+{
+    assert(fine_tiles[0] != nullptr);
+    assert(tile_x < coarse_level_props.m_tile_count_x);
+    assert(tile_y < coarse_level_props.m_tile_count_y);
+
+    const size_t channel_count = fine_tiles[0]->get_channel_count();
+
+    const size_t tile_width = coarse_level_props.get_tile_width(tile_x);
+    const size_t tile_height = coarse_level_props.get_tile_height(tile_y);
+
+    Tile* tile =
+        new Tile(
+            tile_width,
+            tile_height,
+            channel_count,
+            fine_tiles[0]->get_pixel_format());
+
+    // Origin of the block of tiles of the finer level, in the pixel space of that level.
+    const size_t fine_org_x = 2 * tile_x * fine_level_props.m_tile_width;
+    const size_t fine_org_y = 2 * tile_y * fine_level_props.m_tile_height;
+
+    const size_t fine_max_x = fine_level_props.m_canvas_width - 1;
+    const size_t fine_max_y = fine_level_props.m_canvas_height - 1;
+
+    // Tiles may have any number of channels.
+    vector<float> sum(channel_count);
+    vector<float> value(channel_count);
+
+    for (size_t y = 0; y < tile_height; ++y)
+    {
+        for (size_t x = 0; x < tile_width; ++x)
+        {
+            fill(sum.begin(), sum.end(), 0.0f);
+
+            for (size_t j = 0; j < 2; ++j)
+            {
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    // Coordinates of the fine pixel relative to the block of fine tiles.
+                    // Pixels past the edges of the finer level are clamped to these edges.
+                    const size_t fx = min(fine_org_x + 2 * x + i, fine_max_x) - fine_org_x;
+                    const size_t fy = min(fine_org_y + 2 * y + j, fine_max_y) - fine_org_y;
+
+                    const size_t dx = fx >= fine_level_props.m_tile_width ? 1 : 0;
+                    const size_t dy = fy >= fine_level_props.m_tile_height ? 1 : 0;
+
+                    const Tile* fine_tile = fine_tiles[dy * 2 + dx];
+                    assert(fine_tile != nullptr);
+
+                    fine_tile->get_pixel(
+                        fx - dx * fine_level_props.m_tile_width,
+                        fy - dy * fine_level_props.m_tile_height,
+                        &value[0],
+                        channel_count);
+
+                    for (size_t c = 0; c < channel_count; ++c)
+                        sum[c] += value[c];
+                }
+            }
+
+            for (size_t c = 0; c < channel_count; ++c)
+                sum[c] *= 0.25f;
+
+            tile->set_pixel(x, y, &sum[0], channel_count);
+        }
+    }
+
+    return tile;
+}
+
+}   // namespace renderer
@@ -0,0 +1,72 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class Tile; }
+
+namespace renderer
+{
+
+//
+// MIP pyramids of textures.
+//
+// Level 0 is the texture itself. Each subsequent level halves the resolution of the
+// previous one (rounding down, but never below one pixel) and is split into tiles of
+// the same size as those of level 0, so that the tile (x, y) of level n + 1 covers
+// the tiles (2x, 2y) to (2x + 1, 2y + 1) of level n.
+//
+
+// Return the number of levels in the MIP pyramid of a texture.
+size_t get_mip_level_count(const foundation::CanvasProperties& props);
+
+// Return the canvas properties of a given level of the MIP pyramid of a texture.
+foundation::CanvasProperties get_mip_level_properties(
+    const foundation::CanvasProperties& props,
+    const size_t                        level);
+
+// Compute the tile (tile_x, tile_y) of a MIP level by applying a 2x2 box filter to the
+// (up to) four tiles of the next finer level that it covers. Missing tiles past the edges
+// of the finer level may be nullptr. The new tile has the pixel format and the channel
+// count of the finer tiles.
+foundation::Tile* downsample_mip_tile(
+    const foundation::CanvasProperties& fine_level_props,
+    const foundation::CanvasProperties& coarse_level_props,
+    const size_t                        tile_x,
+    const size_t                        tile_y,
+    const foundation::Tile* const       fine_tiles[4]);     // tiles (2x, 2y), (2x + 1, 2y), (2x, 2y + 1), (2x + 1, 2y + 1)
+
+}   // namespace renderer
@@ -30,6 +30,7 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/kernel/texturing/textureprefetcher.h"
 #include "renderer/kernel/texturing/texturestore.h"
 
 // appleseed.foundation headers.
@@ -42,9 +43,6 @@
 // Standard headers.
 #include <cstddef>
 
-// Forward declarations.
-namespace foundation    { class Tile; }
-
 namespace renderer
 {
 
@@ -59,12 +57,14 @@ class TextureCache
     // Constructor.
     explicit TextureCache(TextureStore& store);
 
-    // Get a tile from the cache.
-    foundation::Tile& get(
+    // Get a tile of a given MIP level from the cache.
+    // The tile is either stored in record.m_tile or, if compressed, in record.m_compressed_tile.
+    const TextureStore::TileRecord& get(
         const foundation::UniqueID  assembly_uid,
         const foundation::UniqueID  texture_uid,
         const size_t                tile_x,
-        const size_t                tile_y);
+        const size_t                tile_y,
+        const size_t                level = 0);
 
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
@@ -119,14 +119,15 @@ inline TextureCache::TextureCache(TextureStore& store)
 {
 }
 
-inline foundation::Tile& TextureCache::get(
+inline const TextureStore::TileRecord& TextureCache::get(
     const foundation::UniqueID      assembly_uid,
     const foundation::UniqueID      texture_uid,
     const size_t                    tile_x,
-    const size_t                    tile_y)
+    const size_t                    tile_y,
+    const size_t                    level)
 {
-    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y);
-    return *m_tile_cache.get(key)->m_tile;
+    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y, level);
+    return *m_tile_cache.get(key);
 }
 
 inline foundation::StatisticsVector TextureCache::get_statistics() const
@@ -159,6 +160,7 @@ inline TextureCache::TileRecordSwapper::TileRecordSwapper(TextureStore& store)
 
 inline void TextureCache::TileRecordSwapper::load(const TileKey& key, TileRecordPtr& record)
 {
+    TexturePrefetcher::record_access(key);
     record = &m_store.acquire(key);
 }
 
@@ -0,0 +1,254 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "textureprefetcher.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/foreach.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <unordered_set>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// TexturePrefetcher class implementation.
+//
+
+APPLESEED_TLS TexturePrefetcher::TileKeyVector* TexturePrefetcher::s_current_keys = nullptr;
+
+class TexturePrefetcher::IOThreadFunc
+  : public NonCopyable
+{
+  public:
+    explicit IOThreadFunc(TexturePrefetcher& prefetcher)
+      : m_prefetcher(prefetcher)
+    {
+    }
+
+    void operator()()
+    {
+        set_current_thread_name("texture_prefetch");
+        m_prefetcher.run_io_thread();
+    }
+
+  private:
+    TexturePrefetcher& m_prefetcher;
+};
+
+TexturePrefetcher::TexturePrefetcher(
+    TextureStore&               texture_store,
+    const size_t                image_tile_count,
+    const size_t                lookahead)
+  : m_texture_store(texture_store)
+  , m_lookahead(max<size_t>(lookahead, 1))
+  , m_recorded_keys(image_tile_count)
+  , m_prefetch_keys(image_tile_count)
+  , m_started_tile_count(0)
+  , m_pass_active(false)
+  , m_io_thread_busy(false)
+  , m_stop(false)
+  , m_prefetched_tile_count(0)
+  , m_skipped_tile_count(0)
+{
+    m_io_thread_func.reset(new IOThreadFunc(*this));
+    ThreadFunctionWrapper<IOThreadFunc> wrapper(m_io_thread_func.get());
+    m_io_thread.reset(new boost::thread(wrapper));
+}
+
+TexturePrefetcher::~TexturePrefetcher()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stop = true;
+        m_event.notify_all();
+    }
+
+    m_io_thread->join();
+}
+
+void TexturePrefetcher::on_pass_begin(const vector<size_t>& image_tile_order)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    assert(!m_pass_active);
+
+    for (each<vector<TileKeyVector>> i = m_recorded_keys; i; ++i)
+        i->clear();
+
+    m_image_tile_order = image_tile_order;
+    m_started_tile_count = 0;
+    m_pass_active = true;
+    m_event.notify_all();
+}
+
+void TexturePrefetcher::on_pass_end()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        assert(m_pass_active);
+
+        // Wait until the I/O thread is done with the prefetch lists.
+        m_pass_active = false;
+        m_event.notify_all();
+        while (m_io_thread_busy)
+            m_event.wait(lock);
+    }
+
+    // The I/O thread won't touch the prefetch lists until the next pass begins,
+    // so they can be rebuilt without holding the lock.
+    typedef unordered_set<TextureStore::TileKey, TextureStore::TileKeyHasher> TileKeySet;
+    TileKeySet seen_keys;
+
+    // Keep each texture tile only once per image tile, in first access order.
+    for (size_t i = 0; i < m_recorded_keys.size(); ++i)
+    {
+        TileKeyVector& recorded = m_recorded_keys[i];
+        TileKeyVector& prefetch = m_prefetch_keys[i];
+
+        prefetch.clear();
+        seen_keys.clear();
+
+        for (const_each<TileKeyVector> k = recorded; k; ++k)
+        {
+            if (seen_keys.insert(*k).second)
+                prefetch.push_back(*k);
+        }
+
+        recorded.clear();
+    }
+}
+
+TexturePrefetcher::ImageTileScope::ImageTileScope(
+    TexturePrefetcher*          prefetcher,
+    const size_t                image_tile_index)
+{
+    if (prefetcher)
+    {
+        assert(image_tile_index < prefetcher->m_recorded_keys.size());
+        s_current_keys = &prefetcher->m_recorded_keys[image_tile_index];
+        prefetcher->on_tile_job_begin();
+    }
+}
+
+TexturePrefetcher::ImageTileScope::~ImageTileScope()
+{
+    s_current_keys = nullptr;
+}
+
+StatisticsVector TexturePrefetcher::get_statistics() const
+{
+    Statistics stats;
+    stats.insert("prefetched tiles", m_prefetched_tile_count);
+    stats.insert("skipped tiles", m_skipped_tile_count);
+
+    return StatisticsVector::make("texture prefetcher statistics", stats);
+}
+
+void TexturePrefetcher::on_tile_job_begin()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    ++m_started_tile_count;
+    m_event.notify_all();
+}
+
+void TexturePrefetcher::run_io_thread()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    while (true)
+    {
+        // Wait for the beginning of a pass.
+        while (!m_stop && !m_pass_active)
+            m_event.wait(lock);
+
+        if (m_stop)
+            return;
+
+        m_io_thread_busy = true;
+
+        for (size_t i = 0; i < m_image_tile_order.size(); ++i)
+        {
+            // Don't run too far ahead of the tile jobs.
+            while (!m_stop && m_pass_active && i >= m_started_tile_count + m_lookahead)
+                m_event.wait(lock);
+
+            if (m_stop || !m_pass_active)
+                break;
+
+            const TileKeyVector& keys = m_prefetch_keys[m_image_tile_order[i]];
+
+            // Load texture tiles without holding the lock.
+            lock.unlock();
+
+            size_t prefetched = 0;
+            size_t skipped = 0;
+
+            for (const_each<TileKeyVector> k = keys; k; ++k)
+            {
+                try
+                {
+                    if (m_texture_store.prefetch(*k))
+                        ++prefetched;
+                    else ++skipped;
+                }
+                catch (...)
+                {
+                    // The tile failed to load: the tile job that needs it will report the error.
+                    ++skipped;
+                }
+            }
+
+            lock.lock();
+
+            m_prefetched_tile_count += prefetched;
+            m_skipped_tile_count += skipped;
+        }
+
+        m_io_thread_busy = false;
+        m_event.notify_all();
+
+        // Wait for the end of the pass.
+        while (!m_stop && m_pass_active)
+            m_event.wait(lock);
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,154 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/texturing/texturestore.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/statistics.h"
+
+// Boost headers.
+#include "boost/thread/condition_variable.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// Warms up the texture store ahead of tile jobs.
+//
+// While image tiles are being rendered, the texture tiles fetched by each image tile are
+// recorded. During the next pass, a dedicated I/O thread walks the image tiles in rendering
+// order, staying a few image tiles ahead of the tile jobs, and loads the texture tiles they
+// touched in the previous pass into the texture store. Prefetching never evicts tiles: it
+// stops loading tiles into shards of the store that are already full.
+//
+
+class TexturePrefetcher
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    TexturePrefetcher(
+        TextureStore&               texture_store,
+        const size_t                image_tile_count,
+        const size_t                lookahead);     // number of image tiles to prefetch ahead of tile jobs
+
+    // Destructor.
+    ~TexturePrefetcher();
+
+    // Begin a rendering pass in which image tiles will be rendered in a given order.
+    void on_pass_begin(const std::vector<size_t>& image_tile_order);
+
+    // End a rendering pass. Texture tiles recorded during this pass will be prefetched during the next one.
+    void on_pass_end();
+
+    // Record the texture tiles accessed by the current thread while it renders a given image tile.
+    class ImageTileScope
+      : public foundation::NonCopyable
+    {
+      public:
+        ImageTileScope(
+            TexturePrefetcher*      prefetcher,     // may be nullptr
+            const size_t            image_tile_index);
+
+        ~ImageTileScope();
+    };
+
+    // Record an access to a texture tile by the current thread. Does nothing outside of an ImageTileScope.
+    static void record_access(const TextureStore::TileKey& key);
+
+    typedef std::vector<TextureStore::TileKey> TileKeyVector;
+
+    // Return the texture tiles that will be prefetched for a given image tile during the next pass.
+    // Must not be called during a pass.
+    const TileKeyVector& get_prefetch_keys(const size_t image_tile_index) const;
+
+    // Retrieve performance statistics.
+    foundation::StatisticsVector get_statistics() const;
+
+  private:
+
+    class IOThreadFunc;
+
+    TextureStore&                           m_texture_store;
+    const size_t                            m_lookahead;
+
+    std::vector<TileKeyVector>              m_recorded_keys;    // texture tiles accessed during the current pass
+    std::vector<TileKeyVector>              m_prefetch_keys;    // texture tiles accessed during the previous pass
+
+    boost::mutex                            m_mutex;
+    boost::condition_variable_any           m_event;
+    std::vector<size_t>                     m_image_tile_order;
+    size_t                                  m_started_tile_count;
+    bool                                    m_pass_active;
+    bool                                    m_io_thread_busy;
+    bool                                    m_stop;
+
+    foundation::uint64                      m_prefetched_tile_count;
+    foundation::uint64                      m_skipped_tile_count;
+
+    std::unique_ptr<IOThreadFunc>           m_io_thread_func;
+    std::unique_ptr<boost::thread>          m_io_thread;
+
+    static APPLESEED_TLS TileKeyVector*     s_current_keys;
+
+    void on_tile_job_begin();
+    void run_io_thread();
+};
+
+
+//
+// TexturePrefetcher class implementation.
+//
+
+inline void TexturePrefetcher::record_access(const TextureStore::TileKey& key)
+{
+    if (s_current_keys)
+        s_current_keys->push_back(key);
+}
+
+inline const TexturePrefetcher::TileKeyVector& TexturePrefetcher::get_prefetch_keys(const size_t image_tile_index) const
+{
+    assert(image_tile_index < m_prefetch_keys.size());
+    return m_prefetch_keys[image_tile_index];
+}
+
+}   // namespace renderer
@@ -32,28 +32,44 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/texturing/mipmap.h"
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/texture/texture.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#include "foundation/image/compressedtile.h"
 #include "foundation/image/tile.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/memory.h"
+#include "foundation/utility/searchpaths.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+#include "boost/system/error_code.hpp"
+
 // Standard headers.
 #include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <set>
 #include <string>
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -73,6 +89,22 @@ Dictionary TextureStore::get_params_metadata()
             .insert("label", "Texture Cache Size")
             .insert("help", "Texture cache size in bytes"));
 
+    metadata.dictionaries().insert(
+        "shard_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", get_default_shard_count())
+            .insert("label", "Texture Cache Shards")
+            .insert("help", "Number of independently locked partitions of the texture cache"));
+
+    metadata.dictionaries().insert(
+        "compress_tiles",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Compress Texture Tiles")
+            .insert("help", "Keep 8-bit texture tiles block-compressed in the texture cache"));
+
     return metadata;
 }
 
@@ -81,22 +113,531 @@ size_t TextureStore::get_default_size()
     return 1024 * 1024 * 1024;
 }
 
+size_t TextureStore::get_default_shard_count()
+{
+    return 64;
+}
+
 TextureStore::TextureStore(
     const Scene&        scene,
     const ParamArray&   params)
-  : m_tile_swapper(scene, params)
-  , m_tile_cache(m_tile_key_hasher, m_tile_swapper)
+  : m_scene(scene)
+{
+    gather_assemblies(scene.assemblies());
+
+    const size_t shard_count =
+        max<size_t>(params.get_optional<size_t>("shard_count", get_default_shard_count()), 1);
+
+    // The memory limit is evenly split between shards.
+    const size_t memory_limit = params.get_optional<size_t>("max_size", 256 * 1024 * 1024);
+    const size_t shard_memory_limit = max<size_t>(memory_limit / shard_count, 1);
+
+    m_shards.reserve(shard_count);
+
+    for (size_t i = 0; i < shard_count; ++i)
+    {
+        m_shards.push_back(
+            new Shard(
+                scene,
+                m_assemblies,
+                params,
+                shard_memory_limit,
+                m_tile_key_hasher));
+    }
+}
+
+TextureStore::~TextureStore()
 {
+    for (each<vector<Shard*>> i = m_shards; i; ++i)
+        delete *i;
+}
+
+TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
+{
+    Shard& shard = get_shard(key);
+
+    // Query the texture before taking the shard lock since this may open its file.
+    const bool built = is_built_mip_tile(key);
+
+    TileRecord* record;
+    bool persistent = false;
+    shared_future<void> loaded_future;
+    unique_ptr<promise<void>> loaded;
+
+    {
+        boost::mutex::scoped_lock lock(shard.m_mutex, boost::try_to_lock);
+
+        if (!lock.owns_lock())
+        {
+            // The shard is busy: measure how long we wait for it.
+            DefaultWallclockTimer timer;
+            const uint64 start = timer.read();
+            lock.lock();
+            ++shard.m_lock_contention_count;
+            shard.m_lock_wait_ticks += timer.read() - start;
+        }
+
+        if (built)
+        {
+            // Keep built tiles out of the LRU cache while there is room for them.
+            const TileRecordMap::iterator it = shard.m_built_tiles.find(key);
+            if (it != shard.m_built_tiles.end())
+            {
+                record = &it->second;
+                persistent = true;
+            }
+            else if (shard.m_built_tile_memory_size < shard.m_built_tile_memory_limit)
+            {
+                record = &shard.m_built_tiles[key];
+                shard.m_tile_swapper.load(key, *record);
+                persistent = true;
+            }
+        }
+
+        if (!persistent)
+            record = &shard.m_tile_cache.get(key);
+
+        // Prevent the record from being evicted while we're using it.
+        atomic_inc(&record->m_owners);
+
+        // If nobody is loading this tile yet, we're responsible for loading it.
+        if (!record->m_loaded.valid())
+        {
+            loaded.reset(new promise<void>());
+            record->m_loaded = loaded->get_future().share();
+        }
+
+        // Keep our own copy of the future: the record's one is reset if loading fails.
+        loaded_future = record->m_loaded;
+    }
+
+    if (loaded.get())
+    {
+        // Load the tile without holding the shard lock.
+        try
+        {
+            if (built)
+                build_mip_tile(key, *record);
+            else shard.m_tile_swapper.load_tile(key, *record);
+        }
+        catch (...)
+        {
+            {
+                // Leave the record empty so that the next thread acquiring it retries loading the tile.
+                boost::mutex::scoped_lock lock(shard.m_mutex);
+                record->m_loaded = shared_future<void>();
+                release(*record);
+            }
+
+            // Report the failure to threads waiting for this tile.
+            loaded->set_exception(current_exception());
+            throw;
+        }
+
+        {
+            boost::mutex::scoped_lock lock(shard.m_mutex);
+            shard.m_tile_swapper.insert_tile(*record);
+
+            if (persistent)
+                shard.m_built_tile_memory_size += record->get_memory_size();
+        }
+
+        // Wake up threads waiting for this tile.
+        loaded->set_value();
+    }
+    else
+    {
+        const bool wait = loaded_future.wait_for(chrono::seconds(0)) != future_status::ready;
+
+        DefaultWallclockTimer timer;
+        const uint64 start = wait ? timer.read() : 0;
+
+        // Always retrieve the result of the load so that failures are reported to every thread.
+        try
+        {
+            loaded_future.get();
+        }
+        catch (...)
+        {
+            release(*record);
+            throw;
+        }
+
+        if (wait)
+        {
+            // Another thread was loading this tile and we had to wait until it was available.
+            ++shard.m_tile_wait_count;
+            shard.m_tile_wait_ticks += timer.read() - start;
+        }
+    }
+
+    return *record;
+}
+
+bool TextureStore::prefetch(const TileKey& key)
+{
+    Shard& shard = get_shard(key);
+
+    {
+        boost::mutex::scoped_lock lock(shard.m_mutex);
+
+        // Never evict tiles to make room for prefetched ones.
+        if (shard.m_tile_swapper.is_full(0))
+            return false;
+    }
+
+    release(acquire(key));
+
+    return true;
 }
 
 StatisticsVector TextureStore::get_statistics() const
 {
-    Statistics stats = make_single_stage_cache_stats(m_tile_cache);
-    stats.insert_size("peak size", m_tile_swapper.get_peak_memory_size());
+    Statistics stats;
+    size_t peak_memory_size = 0;
+    size_t built_tile_memory_size = 0;
+    uint64 lock_contention_count = 0;
+    uint64 lock_wait_ticks = 0;
+    uint64 tile_wait_count = 0;
+    uint64 tile_wait_ticks = 0;
+
+    for (const_each<vector<Shard*>> i = m_shards; i; ++i)
+    {
+        const Shard& shard = **i;
+        stats.merge(make_single_stage_cache_stats(shard.m_tile_cache));
+        peak_memory_size += shard.m_tile_swapper.get_peak_memory_size();
+        built_tile_memory_size += shard.m_built_tile_memory_size;
+        lock_contention_count += shard.m_lock_contention_count;
+        lock_wait_ticks += shard.m_lock_wait_ticks;
+        tile_wait_count += shard.m_tile_wait_count;
+        tile_wait_ticks += shard.m_tile_wait_ticks;
+    }
+
+    DefaultWallclockTimer timer;
+    const double timer_freq = static_cast<double>(timer.frequency());
+
+    stats.insert_size("peak size", peak_memory_size);
+    stats.insert_size("built mip tiles size", built_tile_memory_size);
+    stats.insert("shards", m_shards.size());
+    stats.insert("lock contentions", lock_contention_count);
+    stats.insert_time("lock wait time", lock_wait_ticks / timer_freq);
+    stats.insert("tile waits", tile_wait_count);
+    stats.insert_time("tile wait time", tile_wait_ticks / timer_freq);
 
     return StatisticsVector::make("texture store statistics", stats);
 }
 
+namespace
+{
+    // Set of textures whose tiles must be dropped from the store.
+    class StaleTextureFilter
+    {
+      public:
+        typedef set<pair<UniqueID, UniqueID>> TextureKeySet;
+
+        explicit StaleTextureFilter(const TextureKeySet& textures)
+          : m_textures(textures)
+        {
+        }
+
+        bool operator()(const TextureStore::TileKey& key) const
+        {
+            return m_textures.find(make_pair(key.m_assembly_uid, key.m_texture_uid)) != m_textures.end();
+        }
+
+      private:
+        const TextureKeySet& m_textures;
+    };
+}
+
+void TextureStore::update(const SearchPaths& search_paths)
+{
+    TextureSignatureMap signatures;
+    compute_texture_signatures(search_paths, signatures);
+
+    // Find the textures that were removed or modified since the last update.
+    StaleTextureFilter::TextureKeySet stale_textures;
+    for (const_each<TextureSignatureMap> i = m_texture_signatures; i; ++i)
+    {
+        const TextureSignatureMap::const_iterator it = signatures.find(i->first);
+        if (it == signatures.end() || it->second != i->second)
+            stale_textures.insert(i->first);
+    }
+
+    // Drop their tiles. Tiles are owned by the store so this never touches the textures themselves.
+    if (!stale_textures.empty())
+    {
+        const StaleTextureFilter filter(stale_textures);
+        size_t removed_tile_count = 0;
+
+        for (each<vector<Shard*>> i = m_shards; i; ++i)
+        {
+            Shard& shard = **i;
+            boost::mutex::scoped_lock lock(shard.m_mutex);
+            removed_tile_count += shard.m_tile_cache.remove_if(filter);
+            removed_tile_count += shard.remove_built_tiles_if(filter);
+        }
+
+        RENDERER_LOG_INFO(
+            "texture store: dropped %s %s of %s modified or removed %s.",
+            pretty_uint(removed_tile_count).c_str(),
+            plural(removed_tile_count, "tile").c_str(),
+            pretty_uint(stale_textures.size()).c_str(),
+            plural(stale_textures.size(), "texture").c_str());
+    }
+
+    m_texture_signatures.swap(signatures);
+
+    // Assemblies may have been added or removed.
+    m_assemblies.clear();
+    gather_assemblies(m_scene.assemblies());
+}
+
+void TextureStore::gather_assemblies(const AssemblyContainer& assemblies)
+{
+    for (const_each<AssemblyContainer> i = assemblies; i; ++i)
+    {
+        m_assemblies[i->get_uid()] = &*i;
+        gather_assemblies(i->assemblies());
+    }
+}
+
+namespace
+{
+    // Combine the signature of a texture entity with the modification times of its files.
+    uint64 compute_texture_signature(const Texture& texture, const SearchPaths& search_paths)
+    {
+        uint64 signature = texture.compute_signature();
+
+        StringArray paths;
+        texture.collect_asset_paths(paths);
+
+        for (size_t i = 0, e = paths.size(); i < e; ++i)
+        {
+            boost::system::error_code ec;
+            const time_t write_time =
+                bf::last_write_time(bf::path(search_paths.qualify(paths[i]).c_str()), ec);
+
+            signature =
+                Entity::combine_signatures(
+                    signature,
+                    static_cast<uint64>(ec ? 0 : write_time));
+        }
+
+        return signature;
+    }
+
+    void collect_texture_signatures(
+        const UniqueID                          assembly_uid,
+        const TextureContainer&                 textures,
+        const SearchPaths&                      search_paths,
+        map<pair<UniqueID, UniqueID>, uint64>&  signatures)
+    {
+        for (const_each<TextureContainer> i = textures; i; ++i)
+        {
+            signatures[make_pair(assembly_uid, i->get_uid())] =
+                compute_texture_signature(*i, search_paths);
+        }
+    }
+}
+
+void TextureStore::compute_texture_signatures(
+    const SearchPaths&      search_paths,
+    TextureSignatureMap&    signatures) const
+{
+    // Scene textures are identified by an invalid assembly unique ID, see TileSwapper::get_texture().
+    collect_texture_signatures(~UniqueID(0), m_scene.textures(), search_paths, signatures);
+
+    // Use the current assemblies of the scene rather than the ones known to the store.
+    vector<const AssemblyContainer*> containers(1, &m_scene.assemblies());
+    while (!containers.empty())
+    {
+        const AssemblyContainer& container = *containers.back();
+        containers.pop_back();
+
+        for (const_each<AssemblyContainer> i = container; i; ++i)
+        {
+            collect_texture_signatures(i->get_uid(), i->textures(), search_paths, signatures);
+            containers.push_back(&i->assemblies());
+        }
+    }
+}
+
+
+namespace
+{
+    // Convert the color channels of a tile from the linear RGB color space to the sRGB color space.
+    void convert_tile_linear_rgb_to_srgb(Tile& tile)
+    {
+        const size_t pixel_count = tile.get_pixel_count();
+        const size_t channel_count = tile.get_channel_count();
+
+        // Grey tiles have a single color channel, followed by alpha if they have two channels.
+        const size_t color_channel_count = channel_count < 3 ? 1 : 3;
+
+        for (size_t i = 0; i < pixel_count; ++i)
+        {
+            for (size_t c = 0; c < color_channel_count; ++c)
+            {
+                tile.set_component(
+                    i,
+                    c,
+                    fast_linear_rgb_to_srgb(tile.get_component<float>(i, c)));
+            }
+        }
+    }
+}
+
+bool TextureStore::is_built_mip_tile(const TileKey& key)
+{
+    return
+        key.m_level > 0 &&
+        key.m_level >= get_shard(key).m_tile_swapper.get_texture(key)->get_mip_level_count();
+}
+
+void TextureStore::build_mip_tile(const TileKey& key, TileRecord& record)
+{
+    assert(key.m_level > 0);
+
+    Texture* texture = get_shard(key).m_tile_swapper.get_texture(key);
+    const CanvasProperties& props = texture->properties();
+    const CanvasProperties fine_level_props = get_mip_level_properties(props, key.m_level - 1);
+    const CanvasProperties coarse_level_props = get_mip_level_properties(props, key.m_level);
+
+    const size_t tile_x = key.get_tile_x();
+    const size_t tile_y = key.get_tile_y();
+
+    // Acquire the tiles of the finer level covered by this tile. Tiles of the finer level
+    // that are not yet in the store are loaded (or built) recursively, outside of any lock.
+    TileRecord* fine_records[4] = { nullptr, nullptr, nullptr, nullptr };
+    const Tile* fine_tiles[4] = { nullptr, nullptr, nullptr, nullptr };
+    unique_ptr<Tile> decompressed_tiles[4];
+    Tile* tile;
+
+    try
+    {
+        for (size_t j = 0; j < 2; ++j)
+        {
+            for (size_t i = 0; i < 2; ++i)
+            {
+                const size_t fine_tile_x = 2 * tile_x + i;
+                const size_t fine_tile_y = 2 * tile_y + j;
+
+                if (fine_tile_x < fine_level_props.m_tile_count_x &&
+                    fine_tile_y < fine_level_props.m_tile_count_y)
+                {
+                    TileRecord& fine_record =
+                        acquire(
+                            TileKey(
+                                key.m_assembly_uid,
+                                key.m_texture_uid,
+                                fine_tile_x,
+                                fine_tile_y,
+                                key.m_level - 1));
+
+                    fine_records[j * 2 + i] = &fine_record;
+
+                    if (fine_record.m_compressed_tile)
+                    {
+                        decompressed_tiles[j * 2 + i].reset(fine_record.m_compressed_tile->decompress());
+                        fine_tiles[j * 2 + i] = decompressed_tiles[j * 2 + i].get();
+                    }
+                    else fine_tiles[j * 2 + i] = fine_record.m_tile;
+                }
+            }
+        }
+
+        // Tiles of level 0 have already been converted to the linear RGB color space
+        // so the filtering happens in linear RGB.
+        tile =
+            downsample_mip_tile(
+                fine_level_props,
+                coarse_level_props,
+                tile_x,
+                tile_y,
+                fine_tiles);
+    }
+    catch (...)
+    {
+        // Don't leave the tiles of the finer level pinned in the store.
+        for (size_t i = 0; i < 4; ++i)
+        {
+            if (fine_records[i])
+                release(*fine_records[i]);
+        }
+
+        throw;
+    }
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        if (fine_records[i])
+            release(*fine_records[i]);
+    }
+
+    if (decompressed_tiles[0])
+    {
+        // The finer level is compressed, so the texture is an 8-bit one: compress this level too.
+        // Quantize sRGB textures in sRGB, like their finer levels, to keep the precision of dark values.
+        const ColorSpace color_space = texture->get_color_space();
+        if (color_space == ColorSpaceSRGB)
+            convert_tile_linear_rgb_to_srgb(*tile);
+
+        const Tile tile_8bit(*tile, PixelFormatUInt8);
+        delete tile;
+        record.m_compressed_tile = new CompressedTile(tile_8bit, color_space);
+    }
+    else record.m_tile = tile;
+}
+
+
+//
+// TextureStore::TileRecord class implementation.
+//
+
+size_t TextureStore::TileRecord::get_memory_size() const
+{
+    if (m_compressed_tile)
+        return m_compressed_tile->get_memory_size();
+
+    // Never access tiles owned by textures, which may no longer exist.
+    return m_owns_tile ? m_tile->get_memory_size() : 0;
+}
+
+
+//
+// TextureStore::Shard class implementation.
+//
+
+TextureStore::Shard::Shard(
+    const Scene&            scene,
+    const AssemblyMap&      assemblies,
+    const ParamArray&       params,
+    const size_t            memory_limit,
+    TileKeyHasher&          tile_key_hasher)
+  : m_tile_swapper(scene, assemblies, params, memory_limit)
+  , m_tile_cache(tile_key_hasher, m_tile_swapper)
+  , m_built_tile_memory_size(0)
+  , m_built_tile_memory_limit(memory_limit / 2)
+  , m_lock_contention_count(0)
+  , m_lock_wait_ticks(0)
+  , m_tile_wait_count(0)
+  , m_tile_wait_ticks(0)
+{
+}
+
+TextureStore::Shard::~Shard()
+{
+    for (each<TileRecordMap> i = m_built_tiles; i; ++i)
+    {
+#ifndef NDEBUG
+        const bool success =
+#endif
+        m_tile_swapper.unload(i->first, i->second);
+        assert(success);
+    }
+}
+
 
 //
 // TextureStore::TileSwapper class implementation.
@@ -165,39 +706,71 @@ namespace
 
 TextureStore::TileSwapper::TileSwapper(
     const Scene&        scene,
-    const ParamArray&   params)
+    const AssemblyMap&  assemblies,
+    const ParamArray&   params,
+    const size_t        memory_limit)
   : m_scene(scene)
-  , m_params(params)
+  , m_assemblies(assemblies)
+  , m_params(params, memory_limit)
   , m_memory_size(0)
   , m_peak_memory_size(0)
 {
-    gather_assemblies(scene.assemblies());
 }
 
 void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 {
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    record.m_tile = nullptr;
+    record.m_compressed_tile = nullptr;
+    record.m_owns_tile = true;
+    record.m_owners = 0;
+    record.m_loaded = shared_future<void>();
+}
 
+void TextureStore::TileSwapper::load_tile(const TileKey& key, TileRecord& record) const
+{
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = get_texture(key);
 
     if (m_params.m_track_tile_loading)
     {
         RENDERER_LOG_DEBUG(
-            "loading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") "
+            "loading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") of level " FMT_SIZE_T " "
             "from texture \"%s\"...",
             key.get_tile_x(),
             key.get_tile_y(),
+            static_cast<size_t>(key.m_level),
             texture->get_path().c_str());
     }
 
     // Load the tile.
-    record.m_tile = texture->load_tile(key.get_tile_x(), key.get_tile_y());
-    record.m_owners = 0;
+    const size_t level = key.m_level;
+    Tile* texture_tile =
+        level == 0
+            ? texture->load_tile(key.get_tile_x(), key.get_tile_y())
+            : texture->load_mip_tile(level, key.get_tile_x(), key.get_tile_y());
+
+    // Compress the tile if possible. Compressed tiles are converted to linear RGB when they are decoded.
+    if (m_params.m_compress_tiles &&
+        CompressedTile::is_compressible(*texture_tile, texture->get_color_space()))
+    {
+        record.m_compressed_tile = new CompressedTile(*texture_tile, texture->get_color_space());
+        unload_texture_tile(*texture, key, texture_tile);
+        return;
+    }
+
+    // Refer to tiles that stay valid as long as their texture if they need no conversion.
+    if (level == 0 &&
+        texture->get_color_space() == ColorSpaceLinearRGB &&
+        texture->has_persistent_tiles())
+    {
+        record.m_tile = texture_tile;
+        record.m_owns_tile = false;
+        return;
+    }
+
+    // Otherwise keep a copy of the tile so that the texture never needs to release it.
+    Tile* tile = new Tile(*texture_tile);
+    unload_texture_tile(*texture, key, texture_tile);
 
     // Convert the tile to the linear RGB color space.
     switch (texture->get_color_space())
@@ -206,18 +779,23 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
         break;
 
       case ColorSpaceSRGB:
-        convert_tile_srgb_to_linear_rgb(*record.m_tile);
+        convert_tile_srgb_to_linear_rgb(*tile);
         break;
 
       case ColorSpaceCIEXYZ:
-        convert_tile_ciexyz_to_linear_rgb(*record.m_tile);
+        convert_tile_ciexyz_to_linear_rgb(*tile);
         break;
 
       assert_otherwise;
     }
 
+    record.m_tile = tile;
+}
+
+void TextureStore::TileSwapper::insert_tile(const TileRecord& record)
+{
     // Track the amount of memory used by the tile cache.
-    m_memory_size += record.m_tile->get_memory_size();
+    m_memory_size += record.get_memory_size();
     m_peak_memory_size = max(m_peak_memory_size, m_memory_size);
 
     if (m_params.m_track_store_size)
@@ -225,7 +803,7 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
         if (m_memory_size > m_params.m_memory_limit)
         {
             RENDERER_LOG_DEBUG(
-                "texture store size is %s, exceeding capacity %s by %s",
+                "texture store shard size is %s, exceeding capacity %s by %s",
                 pretty_size(m_memory_size).c_str(),
                 pretty_size(m_params.m_memory_limit).c_str(),
                 pretty_size(m_memory_size - m_params.m_memory_limit).c_str());
@@ -233,7 +811,7 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
         else
         {
             RENDERER_LOG_DEBUG(
-                "texture store size is %s, below capacity %s by %s",
+                "texture store shard size is %s, below capacity %s by %s",
                 pretty_size(m_memory_size).c_str(),
                 pretty_size(m_params.m_memory_limit).c_str(),
                 pretty_size(m_params.m_memory_limit - m_memory_size).c_str());
@@ -247,44 +825,57 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
     if (atomic_read(&record.m_owners) > 0)
         return false;
 
+    // The tile failed to load, there is nothing to unload.
+    if (record.m_tile == nullptr && record.m_compressed_tile == nullptr)
+        return true;
+
     // Track the amount of memory used by the tile cache.
-    const size_t tile_memory_size = record.m_tile->get_memory_size();
+    const size_t tile_memory_size = record.get_memory_size();
     assert(m_memory_size >= tile_memory_size);
     m_memory_size -= tile_memory_size;
 
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
-
-    // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
-
+    // The texture may no longer exist, so only refer to it by its unique ID.
     if (m_params.m_track_tile_unloading)
     {
         RENDERER_LOG_DEBUG(
-            "unloading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") "
-            "from texture \"%s\"...",
+            "unloading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") of level " FMT_SIZE_T " "
+            "from texture #" FMT_UNIQUE_ID "...",
             key.get_tile_x(),
             key.get_tile_y(),
-            texture->get_path().c_str());
+            static_cast<size_t>(key.m_level),
+            key.m_texture_uid);
     }
 
-    // Unload the tile.
-    texture->unload_tile(key.get_tile_x(), key.get_tile_y(), record.m_tile);
+    // Unload the tile, unless it is owned by its texture.
+    if (record.m_compressed_tile)
+        delete record.m_compressed_tile;
+    else if (record.m_owns_tile)
+        delete record.m_tile;
 
     // Successfully unloaded the tile.
     return true;
 }
 
-void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assemblies)
+void TextureStore::TileSwapper::unload_texture_tile(
+    Texture&            texture,
+    const TileKey&      key,
+    const Tile*         tile)
 {
-    for (const_each<AssemblyContainer> i = assemblies; i; ++i)
-    {
-        m_assemblies[i->get_uid()] = &*i;
-        gather_assemblies(i->assemblies());
-    }
+    if (key.m_level == 0)
+        texture.unload_tile(key.get_tile_x(), key.get_tile_y(), tile);
+    else texture.unload_mip_tile(key.m_level, key.get_tile_x(), key.get_tile_y(), tile);
+}
+
+Texture* TextureStore::TileSwapper::get_texture(const TileKey& key) const
+{
+    // Fetch the texture container.
+    const TextureContainer& textures =
+        key.m_assembly_uid == ~UniqueID(0)
+            ? m_scene.textures()
+            : m_assemblies.find(key.m_assembly_uid)->second->textures();
+
+    // Fetch the texture.
+    return textures.get_by_uid(key.m_texture_uid);
 }
 
 
@@ -292,8 +883,11 @@ void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assem
 // TextureStore::TileSwapper::Parameters class implementation.
 //
 
-TextureStore::TileSwapper::Parameters::Parameters(const ParamArray& params)
-  : m_memory_limit(params.get_optional<size_t>("max_size", 256 * 1024 * 1024))
+TextureStore::TileSwapper::Parameters::Parameters(
+    const ParamArray&   params,
+    const size_t        memory_limit)
+  : m_memory_limit(memory_limit)
+  , m_compress_tiles(params.get_optional<bool>("compress_tiles", false))
   , m_track_tile_loading(params.get_optional<bool>("track_tile_loading", false))
   , m_track_tile_unloading(params.get_optional<bool>("track_tile_unloading", false))
   , m_track_store_size(params.get_optional<bool>("track_store_size", false))
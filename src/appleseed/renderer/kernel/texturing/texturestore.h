@@ -41,13 +41,22 @@
 #include "foundation/utility/cache.h"
 #include "foundation/utility/uid.h"
 
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <future>
 #include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Forward declarations.
+namespace foundation    { class CompressedTile; }
 namespace foundation    { class Dictionary; }
+namespace foundation    { class SearchPaths; }
 namespace foundation    { class StatisticsVector; }
 namespace foundation    { class Tile; }
 namespace renderer      { class ParamArray; }
@@ -59,6 +68,22 @@ namespace renderer
 //
 // A shared store for texture tiles (the backend of the thread-local texture cache).
 //
+// The store is partitioned into independently locked shards, each shard being a LRU
+// cache of its own. Tiles are loaded outside of any lock: the first thread to request
+// a tile loads it while other threads requesting the same tile wait on the record's
+// future instead of blocking the whole store.
+//
+// The store owns the tiles it holds, so that it can outlive the textures they come from
+// and be reused across renders of the same scene. The exception are tiles of textures with
+// persistent tiles (such as memory textures) that need no conversion: the store refers to
+// them rather than duplicating them. They are dropped with the other tiles of their texture
+// by update() when the texture is modified or removed, and are never accessed otherwise.
+//
+// MIP levels stored with a texture are read like level 0. Other MIP levels are built by
+// the store from the next finer level. Built tiles are kept apart from the LRU caches and
+// are never evicted (up to half of the capacity of each shard), so that each one is only
+// built once and building a tile costs at most four tiles of the next finer level.
+//
 
 class TextureStore
   : public foundation::NonCopyable
@@ -70,6 +95,7 @@ class TextureStore
         foundation::UniqueID    m_assembly_uid;
         foundation::UniqueID    m_texture_uid;
         foundation::uint32      m_tile_xy;
+        foundation::uint32      m_level;        // MIP level, 0 is the full resolution texture
 
         TileKey();
 
@@ -77,7 +103,8 @@ class TextureStore
             const foundation::UniqueID  assembly_uid,
             const foundation::UniqueID  texture_uid,
             const size_t                tile_x,
-            const size_t                tile_y);
+            const size_t                tile_y,
+            const size_t                level = 0);
 
         TileKey(
             const foundation::UniqueID  assembly_uid,
@@ -105,8 +132,14 @@ class TextureStore
 
     struct TileRecord
     {
-        foundation::Tile*           m_tile;
+        foundation::Tile*           m_tile;             // nullptr if the tile is compressed
+        foundation::CompressedTile* m_compressed_tile;  // nullptr unless the tile is compressed
+        bool                        m_owns_tile;        // false if m_tile belongs to its texture
         volatile foundation::uint32 m_owners;
+        std::shared_future<void>    m_loaded;           // becomes ready once the tile is valid
+
+        // Return the size in bytes of the tile in memory, not counting tiles owned by textures.
+        size_t get_memory_size() const;
     };
 
     // Return parameters metadata.
@@ -115,21 +148,43 @@ class TextureStore
     // Return the default texture store size in bytes.
     static size_t get_default_size();
 
+    // Return the default number of shards.
+    static size_t get_default_shard_count();
+
     // Constructor.
     TextureStore(
         const Scene&        scene,
         const ParamArray&   params = ParamArray());
 
+    // Destructor.
+    ~TextureStore();
+
     // Acquire an element from the store. Thread-safe.
     TileRecord& acquire(const TileKey& key);
 
     // Release a previously-acquired element. Thread-safe.
     void release(TileRecord& record) const;
 
+    // Load a tile into the store unless it is already there or the store is full. Thread-safe.
+    // Return false if the tile could not be loaded because the store is full.
+    bool prefetch(const TileKey& key);
+
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
 
+    // Prepare the store for a new render of its scene: drop the tiles of textures that were
+    // removed, modified, or whose file changed since the previous call, and pick up new
+    // assemblies. Must be called before each render when the store is reused across renders.
+    // Not thread-safe.
+    void update(const foundation::SearchPaths& search_paths);
+
   private:
+    typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
+
+    // Assembly and texture unique IDs of a texture.
+    typedef std::pair<foundation::UniqueID, foundation::UniqueID> TextureKey;
+    typedef std::map<TextureKey, foundation::uint64> TextureSignatureMap;
+
     class TileSwapper
       : public foundation::NonCopyable
     {
@@ -137,9 +192,11 @@ class TextureStore
         // Constructor.
         TileSwapper(
             const Scene&        scene,
-            const ParamArray&   params);
+            const AssemblyMap&  assemblies,
+            const ParamArray&   params,
+            const size_t        memory_limit);
 
-        // Load a cache line.
+        // Load a cache line. The tile itself is loaded later by load_tile(), outside of the shard lock.
         void load(const TileKey& key, TileRecord& record);
 
         // Unload a cache line.
@@ -148,29 +205,45 @@ class TextureStore
         // Return true if the cache is full, false otherwise.
         bool is_full(const size_t element_count) const;
 
-        // Return the peak memory size in bytes of the tile cache.
+        // Load a tile stored with its texture (a tile of level 0 or of a stored MIP level)
+        // into a record, converting or compressing it. Thread-safe.
+        void load_tile(const TileKey& key, TileRecord& record) const;
+
+        // Account for a tile that was just loaded. Must be called with the shard lock held.
+        void insert_tile(const TileRecord& record);
+
+        // Return the current memory size in bytes of the tiles in this cache.
+        size_t get_memory_size() const;
+
+        // Return the peak memory size in bytes of the tiles in this cache.
         size_t get_peak_memory_size() const;
 
+        // Return the texture a given tile belongs to.
+        Texture* get_texture(const TileKey& key) const;
+
       private:
         struct Parameters
         {
             const size_t    m_memory_limit;
+            const bool      m_compress_tiles;
             const bool      m_track_tile_loading;
             const bool      m_track_tile_unloading;
             const bool      m_track_store_size;
 
-            explicit Parameters(const ParamArray& params);
+            Parameters(const ParamArray& params, const size_t memory_limit);
         };
 
-        typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
-
         const Scene&        m_scene;
+        const AssemblyMap&  m_assemblies;
         const Parameters    m_params;
         size_t              m_memory_size;
         size_t              m_peak_memory_size;
-        AssemblyMap         m_assemblies;
 
-        void gather_assemblies(const AssemblyContainer& assemblies);
+        // Give a tile back to the texture it was loaded from.
+        static void unload_texture_tile(
+            Texture&                    texture,
+            const TileKey&              key,
+            const foundation::Tile*     tile);
     };
 
     typedef foundation::LRUCache<
@@ -180,10 +253,60 @@ class TextureStore
         TileSwapper
     > TileCache;
 
-    boost::mutex            m_mutex;
+    typedef std::unordered_map<TileKey, TileRecord, TileKeyHasher> TileRecordMap;
+
+    struct Shard
+      : public foundation::NonCopyable
+    {
+        boost::mutex                        m_mutex;
+        TileSwapper                         m_tile_swapper;
+        TileCache                           m_tile_cache;
+
+        // Tiles of MIP levels built by the store, never evicted.
+        TileRecordMap                       m_built_tiles;
+        size_t                              m_built_tile_memory_size;
+        const size_t                        m_built_tile_memory_limit;
+
+        // Contention statistics, in wallclock timer ticks.
+        boost::atomic<foundation::uint64>   m_lock_contention_count;
+        boost::atomic<foundation::uint64>   m_lock_wait_ticks;
+        boost::atomic<foundation::uint64>   m_tile_wait_count;
+        boost::atomic<foundation::uint64>   m_tile_wait_ticks;
+
+        Shard(
+            const Scene&            scene,
+            const AssemblyMap&      assemblies,
+            const ParamArray&       params,
+            const size_t            memory_limit,
+            TileKeyHasher&          tile_key_hasher);
+
+        ~Shard();
+
+        // Unload and remove the built tiles whose key satisfies a given predicate.
+        // Tiles still in use are kept. Return the number of removed tiles.
+        template <typename Predicate>
+        size_t remove_built_tiles_if(Predicate predicate);
+    };
+
+    const Scene&            m_scene;
     TileKeyHasher           m_tile_key_hasher;
-    TileSwapper             m_tile_swapper;
-    TileCache               m_tile_cache;
+    AssemblyMap             m_assemblies;
+    std::vector<Shard*>     m_shards;
+    TextureSignatureMap     m_texture_signatures;
+
+    void gather_assemblies(const AssemblyContainer& assemblies);
+
+    void compute_texture_signatures(
+        const foundation::SearchPaths&  search_paths,
+        TextureSignatureMap&            signatures) const;
+
+    // Return true if a tile belongs to a MIP level that isn't stored with its texture.
+    bool is_built_mip_tile(const TileKey& key);
+
+    // Build a tile of a MIP level (other than level 0) from the tiles of the next finer level.
+    void build_mip_tile(const TileKey& key, TileRecord& record);
+
+    Shard& get_shard(const TileKey& key);
 };
 
 
@@ -191,14 +314,9 @@ class TextureStore
 // TextureStore class implementation.
 //
 
-inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
+inline TextureStore::Shard& TextureStore::get_shard(const TileKey& key)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
-
-    TileRecord& record = m_tile_cache.get(key);
-    foundation::atomic_inc(&record.m_owners);
-
-    return record;
+    return *m_shards[m_tile_key_hasher(key) % m_shards.size()];
 }
 
 inline void TextureStore::release(TileRecord& record) const
@@ -220,10 +338,12 @@ inline TextureStore::TileKey::TileKey(
     const foundation::UniqueID  assembly_uid,
     const foundation::UniqueID  texture_uid,
     const size_t                tile_x,
-    const size_t                tile_y)
+    const size_t                tile_y,
+    const size_t                level)
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(static_cast<foundation::uint32>((tile_y << 16) | tile_x))
+  , m_level(static_cast<foundation::uint32>(level))
 {
     assert(tile_x < (1UL << 16));
     assert(tile_y < (1UL << 16));
@@ -236,6 +356,7 @@ inline TextureStore::TileKey::TileKey(
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(tile_xy)
+  , m_level(0)
 {
 }
 
@@ -243,6 +364,7 @@ inline TextureStore::TileKey::TileKey(const TileKey& rhs)
   : m_assembly_uid(rhs.m_assembly_uid)
   , m_texture_uid(rhs.m_texture_uid)
   , m_tile_xy(rhs.m_tile_xy)
+  , m_level(rhs.m_level)
 {
 }
 
@@ -269,6 +391,7 @@ inline bool TextureStore::TileKey::operator==(const TileKey& rhs) const
 {
     return
         m_tile_xy == rhs.m_tile_xy &&
+        m_level == rhs.m_level &&
         m_texture_uid == rhs.m_texture_uid &&
         m_assembly_uid == rhs.m_assembly_uid;
 }
@@ -283,7 +406,9 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
     return
         m_assembly_uid == rhs.m_assembly_uid ?
             m_texture_uid == rhs.m_texture_uid ?
-                m_tile_xy < rhs.m_tile_xy :
+                m_level == rhs.m_level ?
+                    m_tile_xy < rhs.m_tile_xy :
+                m_level < rhs.m_level :
             m_texture_uid < rhs.m_texture_uid :
         m_assembly_uid < rhs.m_assembly_uid;
 }
@@ -299,7 +424,8 @@ inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
         foundation::mix_uint32(
             static_cast<foundation::uint32>(key.m_assembly_uid),
             static_cast<foundation::uint32>(key.m_texture_uid),
-            static_cast<foundation::uint32>(key.m_tile_xy));
+            static_cast<foundation::uint32>(key.m_tile_xy),
+            static_cast<foundation::uint32>(key.m_level));
 }
 
 
@@ -312,9 +438,48 @@ inline bool TextureStore::TileSwapper::is_full(const size_t element_count) const
     return m_memory_size >= m_params.m_memory_limit;
 }
 
+inline size_t TextureStore::TileSwapper::get_memory_size() const
+{
+    return m_memory_size;
+}
+
 inline size_t TextureStore::TileSwapper::get_peak_memory_size() const
 {
     return m_peak_memory_size;
 }
 
+
+//
+// TextureStore::Shard class implementation.
+//
+
+template <typename Predicate>
+size_t TextureStore::Shard::remove_built_tiles_if(Predicate predicate)
+{
+    size_t removed_count = 0;
+
+    for (TileRecordMap::iterator i = m_built_tiles.begin(); i != m_built_tiles.end(); )
+    {
+        if (predicate(i->first))
+        {
+            const size_t tile_memory_size =
+                i->second.m_tile || i->second.m_compressed_tile
+                    ? i->second.get_memory_size()
+                    : 0;
+
+            if (m_tile_swapper.unload(i->first, i->second))
+            {
+                m_built_tile_memory_size -= tile_memory_size;
+                i = m_built_tiles.erase(i);
+                ++removed_count;
+                continue;
+            }
+        }
+
+        ++i;
+    }
+
+    return removed_count;
+}
+
 }   // namespace renderer
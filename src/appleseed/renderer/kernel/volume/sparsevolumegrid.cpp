@@ -0,0 +1,550 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sparsevolumegrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/cc.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstdio>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// SparseVolumeGrid class implementation.
+//
+
+namespace
+{
+    // Safety margin applied to majorants to absorb dequantization round-off.
+    const float MajorantMargin = 1.0001f;
+
+    size_t brick_count(const size_t res)
+    {
+        return (res + SparseVolumeGrid::BrickSize - 1) / SparseVolumeGrid::BrickSize;
+    }
+}
+
+const size_t SparseVolumeGrid::BrickSize;
+const size_t SparseVolumeGrid::BrickVoxelCount;
+const uint32 SparseVolumeGrid::EmptyBrick;
+
+SparseVolumeGrid::SparseVolumeGrid(
+    const AABB3f&                   bbox,
+    const size_t                    xres,
+    const size_t                    yres,
+    const size_t                    zres)
+  : m_bbox(bbox)
+{
+    assert(bbox.is_valid());
+    assert(xres > 0 && yres > 0 && zres > 0);
+
+    m_res[0] = xres;
+    m_res[1] = yres;
+    m_res[2] = zres;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        m_brick_res[i] = brick_count(m_res[i]);
+        m_voxel_size[i] = (m_bbox.max[i] - m_bbox.min[i]) / m_res[i];
+        m_rcp_voxel_size[i] = 1.0f / m_voxel_size[i];
+    }
+
+    const size_t cell_count = m_brick_res[0] * m_brick_res[1] * m_brick_res[2];
+    m_brick_indices.assign(cell_count, EmptyBrick);
+    m_majorants.assign(cell_count, 0.0f);
+}
+
+void SparseVolumeGrid::set_brick(
+    const size_t                    bx,
+    const size_t                    by,
+    const size_t                    bz,
+    const float*                    values)
+{
+    float min_value = numeric_limits<float>::max();
+    float max_value = 0.0f;
+
+    for (size_t i = 0; i < BrickVoxelCount; ++i)
+    {
+        const float v = max(values[i], 0.0f);
+        min_value = min(min_value, v);
+        max_value = max(max_value, v);
+    }
+
+    uint32& brick_index = m_brick_indices[get_brick_cell(bx, by, bz)];
+
+    if (max_value == 0.0f)
+    {
+        if (brick_index != EmptyBrick)
+        {
+            Brick& brick = m_bricks[brick_index];
+            brick.m_min = 0.0f;
+            brick.m_scale = 0.0f;
+        }
+
+        return;
+    }
+
+    if (brick_index == EmptyBrick)
+    {
+        brick_index = static_cast<uint32>(m_bricks.size());
+        m_bricks.push_back(Brick());
+    }
+
+    Brick& brick = m_bricks[brick_index];
+    brick.m_min = min_value;
+    brick.m_scale = (max_value - min_value) / 65535.0f;
+
+    const float rcp_scale = brick.m_scale > 0.0f ? 1.0f / brick.m_scale : 0.0f;
+
+    for (size_t i = 0; i < BrickVoxelCount; ++i)
+    {
+        const float q = (max(values[i], 0.0f) - min_value) * rcp_scale;
+        brick.m_values[i] = static_cast<uint16>(min(q + 0.5f, 65535.0f));
+    }
+}
+
+void SparseVolumeGrid::update_majorants()
+{
+    // Maximum value of each brick.
+    vector<float> brick_max(m_brick_indices.size(), 0.0f);
+    for (size_t i = 0, e = m_brick_indices.size(); i < e; ++i)
+    {
+        const uint32 brick_index = m_brick_indices[i];
+        if (brick_index != EmptyBrick)
+        {
+            const Brick& brick = m_bricks[brick_index];
+            brick_max[i] = brick.m_min + 65535.0f * brick.m_scale;
+        }
+    }
+
+    // Trilinear interpolation inside a brick reads voxels from the neighboring bricks,
+    // so the majorant of a brick is the maximum value over its 3x3x3 neighborhood.
+    const int nx = static_cast<int>(m_brick_res[0]);
+    const int ny = static_cast<int>(m_brick_res[1]);
+    const int nz = static_cast<int>(m_brick_res[2]);
+
+    for (int bz = 0; bz < nz; ++bz)
+    {
+        for (int by = 0; by < ny; ++by)
+        {
+            for (int bx = 0; bx < nx; ++bx)
+            {
+                float majorant = 0.0f;
+
+                for (int z = max(bz - 1, 0), ze = min(bz + 1, nz - 1); z <= ze; ++z)
+                {
+                    for (int y = max(by - 1, 0), ye = min(by + 1, ny - 1); y <= ye; ++y)
+                    {
+                        for (int x = max(bx - 1, 0), xe = min(bx + 1, nx - 1); x <= xe; ++x)
+                            majorant = max(majorant, brick_max[get_brick_cell(x, y, z)]);
+                    }
+                }
+
+                m_majorants[get_brick_cell(bx, by, bz)] = majorant * MajorantMargin;
+            }
+        }
+    }
+}
+
+size_t SparseVolumeGrid::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_brick_indices.capacity() * sizeof(uint32) +
+        m_bricks.capacity() * sizeof(Brick) +
+        m_majorants.capacity() * sizeof(float);
+}
+
+float SparseVolumeGrid::lookup(const Vector3f& point) const
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (!(point[i] >= m_bbox.min[i] && point[i] <= m_bbox.max[i]))
+            return 0.0f;
+    }
+
+    size_t i0[3], i1[3];
+    float t[3];
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float g = (point[i] - m_bbox.min[i]) * m_rcp_voxel_size[i] - 0.5f;
+        const float f = std::floor(g);
+        const int n = static_cast<int>(m_res[i]);
+        const int k = static_cast<int>(f);
+        i0[i] = static_cast<size_t>(clamp(k, 0, n - 1));
+        i1[i] = static_cast<size_t>(clamp(k + 1, 0, n - 1));
+        t[i] = g - f;
+    }
+
+    const float v000 = get_voxel(i0[0], i0[1], i0[2]);
+    const float v100 = get_voxel(i1[0], i0[1], i0[2]);
+    const float v010 = get_voxel(i0[0], i1[1], i0[2]);
+    const float v110 = get_voxel(i1[0], i1[1], i0[2]);
+    const float v001 = get_voxel(i0[0], i0[1], i1[2]);
+    const float v101 = get_voxel(i1[0], i0[1], i1[2]);
+    const float v011 = get_voxel(i0[0], i1[1], i1[2]);
+    const float v111 = get_voxel(i1[0], i1[1], i1[2]);
+
+    const float v00 = lerp(v000, v100, t[0]);
+    const float v10 = lerp(v010, v110, t[0]);
+    const float v01 = lerp(v001, v101, t[0]);
+    const float v11 = lerp(v011, v111, t[0]);
+
+    const float v0 = lerp(v00, v10, t[1]);
+    const float v1 = lerp(v01, v11, t[1]);
+
+    return lerp(v0, v1, t[2]);
+}
+
+namespace
+{
+    struct OpticalDepthVisitor
+    {
+        float m_optical_depth;
+
+        OpticalDepthVisitor()
+          : m_optical_depth(0.0f)
+        {
+        }
+
+        bool visit(const float t0, const float t1, const float majorant)
+        {
+            m_optical_depth += majorant * (t1 - t0);
+            return true;
+        }
+    };
+
+    struct MajorantDistanceSamplingVisitor
+    {
+        const float m_target;           // optical depth at which to stop
+        float       m_optical_depth;
+        float       m_distance;
+        bool        m_found;
+
+        explicit MajorantDistanceSamplingVisitor(const float target)
+          : m_target(target)
+          , m_optical_depth(0.0f)
+          , m_distance(0.0f)
+          , m_found(false)
+        {
+        }
+
+        bool visit(const float t0, const float t1, const float majorant)
+        {
+            if (majorant > 0.0f)
+            {
+                const float segment_depth = majorant * (t1 - t0);
+                if (m_optical_depth + segment_depth >= m_target)
+                {
+                    m_distance = min(t0 + (m_target - m_optical_depth) / majorant, t1);
+                    m_found = true;
+                    return false;
+                }
+
+                m_optical_depth += segment_depth;
+                m_distance = t1;    // fallback in case of round-off errors
+            }
+
+            return true;
+        }
+    };
+
+    struct MajorantAtDistanceVisitor
+    {
+        const float m_distance;
+        float       m_optical_depth;
+        float       m_majorant;
+
+        explicit MajorantAtDistanceVisitor(const float distance)
+          : m_distance(distance)
+          , m_optical_depth(0.0f)
+          , m_majorant(0.0f)
+        {
+        }
+
+        bool visit(const float t0, const float t1, const float majorant)
+        {
+            if (m_distance <= t1)
+            {
+                m_optical_depth += majorant * (m_distance - t0);
+                m_majorant = majorant;
+                return false;
+            }
+
+            m_optical_depth += majorant * (t1 - t0);
+            return true;
+        }
+    };
+}
+
+float SparseVolumeGrid::compute_majorant_optical_depth(
+    const Vector3f&                 org,
+    const Vector3f&                 dir,
+    const float                     tmin,
+    const float                     tmax) const
+{
+    OpticalDepthVisitor visitor;
+    traverse(org, dir, tmin, tmax, visitor);
+    return visitor.m_optical_depth;
+}
+
+bool SparseVolumeGrid::sample_majorant_distance(
+    const Vector3f&                 org,
+    const Vector3f&                 dir,
+    const float                     tmax,
+    const float                     scale,
+    const float                     s,
+    float&                          distance) const
+{
+    const float total_depth = scale * compute_majorant_optical_depth(org, dir, 0.0f, tmax);
+    if (!(total_depth > 0.0f))
+        return false;
+
+    // Invert the CDF of first collisions restricted to the segment.
+    const float target = -std::log(1.0f - s * (1.0f - std::exp(-total_depth))) / scale;
+
+    MajorantDistanceSamplingVisitor visitor(target);
+    traverse(org, dir, 0.0f, tmax, visitor);
+
+    distance = visitor.m_distance;
+    return true;
+}
+
+float SparseVolumeGrid::evaluate_majorant_distance_pdf(
+    const Vector3f&                 org,
+    const Vector3f&                 dir,
+    const float                     tmax,
+    const float                     scale,
+    const float                     distance) const
+{
+    const float total_depth = scale * compute_majorant_optical_depth(org, dir, 0.0f, tmax);
+    if (!(total_depth > 0.0f))
+        return 0.0f;
+
+    MajorantAtDistanceVisitor visitor(distance);
+    traverse(org, dir, 0.0f, min(distance, tmax), visitor);
+
+    const float majorant = scale * visitor.m_majorant;
+    const float depth = scale * visitor.m_optical_depth;
+
+    return majorant * std::exp(-depth) / (1.0f - std::exp(-total_depth));
+}
+
+
+//
+// Sparse volume grid I/O.
+//
+
+namespace
+{
+    const uint32 SparseVolumeGridMagic = CC32('A', 'S', 'V', 'G');
+    const uint32 SparseVolumeGridVersion = 1;
+
+    struct SparseVolumeGridFileHeader
+    {
+        uint32  m_magic;
+        uint32  m_version;
+        uint32  m_res[3];
+        float   m_bbox_min[3];
+        float   m_bbox_max[3];
+        uint32  m_brick_count;
+    };
+
+    struct FileCloser
+    {
+        FILE* m_file;
+
+        explicit FileCloser(FILE* file)
+          : m_file(file)
+        {
+        }
+
+        ~FileCloser()
+        {
+            if (m_file)
+                fclose(m_file);
+        }
+    };
+}
+
+unique_ptr<SparseVolumeGrid> read_sparse_volume_grid(const char* filename)
+{
+    assert(filename);
+
+    FILE* file = fopen(filename, "rb");
+
+    if (file == nullptr)
+        return unique_ptr<SparseVolumeGrid>(nullptr);
+
+    FileCloser closer(file);
+
+    // Read and check the file header.
+    SparseVolumeGridFileHeader header;
+    if (fread(&header, sizeof(SparseVolumeGridFileHeader), 1, file) < 1 ||
+        header.m_magic != SparseVolumeGridMagic ||
+        header.m_version != SparseVolumeGridVersion ||
+        header.m_res[0] == 0 || header.m_res[1] == 0 || header.m_res[2] == 0)
+        return unique_ptr<SparseVolumeGrid>(nullptr);
+
+    const AABB3f bbox(
+        Vector3f(header.m_bbox_min[0], header.m_bbox_min[1], header.m_bbox_min[2]),
+        Vector3f(header.m_bbox_max[0], header.m_bbox_max[1], header.m_bbox_max[2]));
+
+    if (!bbox.is_valid() || bbox.rank() < 3)
+        return unique_ptr<SparseVolumeGrid>(nullptr);
+
+    unique_ptr<SparseVolumeGrid> grid(
+        new SparseVolumeGrid(bbox, header.m_res[0], header.m_res[1], header.m_res[2]));
+
+    // Read the bricks.
+    vector<float> values(SparseVolumeGrid::BrickVoxelCount);
+    for (uint32 i = 0; i < header.m_brick_count; ++i)
+    {
+        uint32 coords[3];
+        if (fread(coords, sizeof(uint32), 3, file) < 3)
+            return unique_ptr<SparseVolumeGrid>(nullptr);
+
+        if (coords[0] >= grid->get_brick_xres() ||
+            coords[1] >= grid->get_brick_yres() ||
+            coords[2] >= grid->get_brick_zres())
+            return unique_ptr<SparseVolumeGrid>(nullptr);
+
+        if (fread(&values[0], sizeof(float), values.size(), file) < values.size())
+            return unique_ptr<SparseVolumeGrid>(nullptr);
+
+        grid->set_brick(coords[0], coords[1], coords[2], &values[0]);
+    }
+
+    grid->update_majorants();
+
+    return grid;
+}
+
+bool write_sparse_volume_grid(
+    const char*                     filename,
+    const SparseVolumeGrid&         grid)
+{
+    assert(filename);
+
+    const size_t BrickSize = SparseVolumeGrid::BrickSize;
+
+    // Collect the non-empty bricks.
+    vector<uint32> brick_coords;
+    for (size_t bz = 0; bz < grid.get_brick_zres(); ++bz)
+    {
+        for (size_t by = 0; by < grid.get_brick_yres(); ++by)
+        {
+            for (size_t bx = 0; bx < grid.get_brick_xres(); ++bx)
+            {
+                bool empty = true;
+
+                for (size_t z = bz * BrickSize, ze = min(z + BrickSize, grid.get_zres()); empty && z < ze; ++z)
+                {
+                    for (size_t y = by * BrickSize, ye = min(y + BrickSize, grid.get_yres()); empty && y < ye; ++y)
+                    {
+                        for (size_t x = bx * BrickSize, xe = min(x + BrickSize, grid.get_xres()); empty && x < xe; ++x)
+                            empty = grid.get_voxel(x, y, z) == 0.0f;
+                    }
+                }
+
+                if (!empty)
+                {
+                    brick_coords.push_back(static_cast<uint32>(bx));
+                    brick_coords.push_back(static_cast<uint32>(by));
+                    brick_coords.push_back(static_cast<uint32>(bz));
+                }
+            }
+        }
+    }
+
+    FILE* file = fopen(filename, "wb");
+
+    if (file == nullptr)
+        return false;
+
+    FileCloser closer(file);
+
+    SparseVolumeGridFileHeader header;
+    header.m_magic = SparseVolumeGridMagic;
+    header.m_version = SparseVolumeGridVersion;
+    header.m_res[0] = static_cast<uint32>(grid.get_xres());
+    header.m_res[1] = static_cast<uint32>(grid.get_yres());
+    header.m_res[2] = static_cast<uint32>(grid.get_zres());
+    for (size_t i = 0; i < 3; ++i)
+    {
+        header.m_bbox_min[i] = grid.get_bbox().min[i];
+        header.m_bbox_max[i] = grid.get_bbox().max[i];
+    }
+    header.m_brick_count = static_cast<uint32>(brick_coords.size() / 3);
+
+    if (fwrite(&header, sizeof(SparseVolumeGridFileHeader), 1, file) < 1)
+        return false;
+
+    vector<float> values(SparseVolumeGrid::BrickVoxelCount);
+    for (size_t i = 0, e = brick_coords.size(); i < e; i += 3)
+    {
+        const size_t bx = brick_coords[i + 0];
+        const size_t by = brick_coords[i + 1];
+        const size_t bz = brick_coords[i + 2];
+
+        for (size_t z = 0; z < BrickSize; ++z)
+        {
+            for (size_t y = 0; y < BrickSize; ++y)
+            {
+                for (size_t x = 0; x < BrickSize; ++x)
+                {
+                    const size_t vx = bx * BrickSize + x;
+                    const size_t vy = by * BrickSize + y;
+                    const size_t vz = bz * BrickSize + z;
+
+                    values[(z * BrickSize + y) * BrickSize + x] =
+                        vx < grid.get_xres() && vy < grid.get_yres() && vz < grid.get_zres()
+                            ? grid.get_voxel(vx, vy, vz)
+                            : 0.0f;
+                }
+            }
+        }
+
+        if (fwrite(&brick_coords[i], sizeof(uint32), 3, file) < 3 ||
+            fwrite(&values[0], sizeof(float), values.size(), file) < values.size())
+            return false;
+    }
+
+    return true;
+}
+
+}   // namespace renderer
@@ -0,0 +1,394 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A sparse grid of non-negative scalar values (typically densities) stored in cubic
+// bricks of BrickSize^3 voxels. Only bricks containing at least one non-zero voxel are
+// allocated. Voxels are quantized to 16 bits between the minimum and maximum values of
+// their brick, so that a stored voxel costs a little over two bytes and an empty brick
+// costs a single 32-bit index.
+//
+// The grid also maintains one majorant per brick: an upper bound of the values returned
+// by trilinear interpolation anywhere inside the brick. Ray traversal of the majorant
+// grid is used for delta tracking, ratio tracking and to skip empty space.
+//
+// Voxel centers are located at (i + 0.5) * voxel size from the minimum corner of the
+// bounding box; values are zero outside the bounding box.
+//
+
+class SparseVolumeGrid
+  : public foundation::NonCopyable
+{
+  public:
+    static const size_t BrickSize = 8;
+    static const size_t BrickVoxelCount = BrickSize * BrickSize * BrickSize;
+
+    // Constructor. All voxels are initially zero.
+    SparseVolumeGrid(
+        const foundation::AABB3f&   bbox,
+        const size_t                xres,
+        const size_t                yres,
+        const size_t                zres);
+
+    // Set the voxels of a brick, x varying fastest, then y, then z.
+    // Negative values are clamped to zero. Bricks whose voxels are all zero are not stored.
+    void set_brick(
+        const size_t                bx,
+        const size_t                by,
+        const size_t                bz,
+        const float*                values);
+
+    // Recompute the majorant grid. Must be called after the bricks have been set.
+    void update_majorants();
+
+    // Return the bounding box of the grid.
+    const foundation::AABB3f& get_bbox() const;
+
+    // Return the resolution of the grid, in voxels.
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+
+    // Return the resolution of the grid, in bricks.
+    size_t get_brick_xres() const;
+    size_t get_brick_yres() const;
+    size_t get_brick_zres() const;
+
+    // Return the number of allocated bricks.
+    size_t get_stored_brick_count() const;
+
+    // Return the total memory used by the grid, in bytes.
+    size_t get_memory_size() const;
+
+    // Return the (dequantized) value of a given voxel.
+    float get_voxel(
+        const size_t                x,
+        const size_t                y,
+        const size_t                z) const;
+
+    // Return the trilinearly interpolated value at a given point (in world space).
+    float lookup(const foundation::Vector3f& point) const;
+
+    // Return the majorant of a given brick.
+    float get_majorant(
+        const size_t                bx,
+        const size_t                by,
+        const size_t                bz) const;
+
+    // Visit, in front-to-back order, the bricks crossed by the segment [tmin, tmax] of a ray.
+    // The visitor must provide a method bool visit(float t0, float t1, float majorant)
+    // which is called with the parametric extent of the ray inside each brick;
+    // it returns false to stop the traversal.
+    template <typename Visitor>
+    void traverse(
+        const foundation::Vector3f& org,
+        const foundation::Vector3f& dir,
+        float                       tmin,
+        float                       tmax,
+        Visitor&                    visitor) const;
+
+    // Return the optical depth of the majorant along the segment [tmin, tmax] of a ray.
+    float compute_majorant_optical_depth(
+        const foundation::Vector3f& org,
+        const foundation::Vector3f& dir,
+        const float                 tmin,
+        const float                 tmax) const;
+
+    // Sample a distance on the segment [0, tmax] of a ray proportionally to the density
+    // of first collisions with the majorant (scaled by a given factor), conditioned on a
+    // collision happening before tmax. Return false if the majorant is zero along the segment.
+    bool sample_majorant_distance(
+        const foundation::Vector3f& org,
+        const foundation::Vector3f& dir,
+        const float                 tmax,
+        const float                 scale,
+        const float                 s,
+        float&                      distance) const;
+
+    // Return the probability density of sampling a given distance with sample_majorant_distance().
+    float evaluate_majorant_distance_pdf(
+        const foundation::Vector3f& org,
+        const foundation::Vector3f& dir,
+        const float                 tmax,
+        const float                 scale,
+        const float                 distance) const;
+
+  private:
+    struct Brick
+    {
+        float                       m_min;
+        float                       m_scale;
+        foundation::uint16          m_values[BrickVoxelCount];
+    };
+
+    static const foundation::uint32 EmptyBrick = ~foundation::uint32(0);
+
+    const foundation::AABB3f        m_bbox;
+    size_t                          m_res[3];
+    size_t                          m_brick_res[3];
+    foundation::Vector3f            m_voxel_size;
+    foundation::Vector3f            m_rcp_voxel_size;
+    std::vector<foundation::uint32> m_brick_indices;
+    std::vector<Brick>              m_bricks;
+    std::vector<float>              m_majorants;
+
+    size_t get_brick_cell(
+        const size_t                bx,
+        const size_t                by,
+        const size_t                bz) const;
+};
+
+
+//
+// Sparse volume grid I/O.
+//
+// File format (all values are little-endian):
+//
+//   uint32      magic number, 'ASVG'
+//   uint32      version, currently 1
+//   uint32 x 3  resolution of the grid in voxels (x, y, z)
+//   float  x 6  bounding box of the grid in world space (min x, y, z, max x, y, z)
+//   uint32      number of bricks in the file
+//
+// followed by the bricks, each made of:
+//
+//   uint32 x 3  coordinates of the brick in the brick grid (in units of 8 voxels)
+//   float x 512 voxel values, x varying fastest, then y, then z
+//
+// Bricks that are not present in the file are assumed to be zero. Bricks must lie
+// within the brick grid, i.e. brick coordinates are less than ceil(resolution / 8).
+//
+
+// Read a sparse volume grid from disk. Return nullptr on failure.
+std::unique_ptr<SparseVolumeGrid> read_sparse_volume_grid(const char* filename);
+
+// Write a sparse volume grid to disk. Return true on success.
+bool write_sparse_volume_grid(
+    const char*                 filename,
+    const SparseVolumeGrid&     grid);
+
+
+//
+// SparseVolumeGrid class implementation.
+//
+
+inline const foundation::AABB3f& SparseVolumeGrid::get_bbox() const
+{
+    return m_bbox;
+}
+
+inline size_t SparseVolumeGrid::get_xres() const
+{
+    return m_res[0];
+}
+
+inline size_t SparseVolumeGrid::get_yres() const
+{
+    return m_res[1];
+}
+
+inline size_t SparseVolumeGrid::get_zres() const
+{
+    return m_res[2];
+}
+
+inline size_t SparseVolumeGrid::get_brick_xres() const
+{
+    return m_brick_res[0];
+}
+
+inline size_t SparseVolumeGrid::get_brick_yres() const
+{
+    return m_brick_res[1];
+}
+
+inline size_t SparseVolumeGrid::get_brick_zres() const
+{
+    return m_brick_res[2];
+}
+
+inline size_t SparseVolumeGrid::get_stored_brick_count() const
+{
+    return m_bricks.size();
+}
+
+inline size_t SparseVolumeGrid::get_brick_cell(
+    const size_t                    bx,
+    const size_t                    by,
+    const size_t                    bz) const
+{
+    assert(bx < m_brick_res[0]);
+    assert(by < m_brick_res[1]);
+    assert(bz < m_brick_res[2]);
+
+    return (bz * m_brick_res[1] + by) * m_brick_res[0] + bx;
+}
+
+inline float SparseVolumeGrid::get_voxel(
+    const size_t                    x,
+    const size_t                    y,
+    const size_t                    z) const
+{
+    const foundation::uint32 brick_index =
+        m_brick_indices[get_brick_cell(x / BrickSize, y / BrickSize, z / BrickSize)];
+
+    if (brick_index == EmptyBrick)
+        return 0.0f;
+
+    const Brick& brick = m_bricks[brick_index];
+    const size_t i = ((z % BrickSize) * BrickSize + (y % BrickSize)) * BrickSize + (x % BrickSize);
+
+    return brick.m_min + brick.m_values[i] * brick.m_scale;
+}
+
+inline float SparseVolumeGrid::get_majorant(
+    const size_t                    bx,
+    const size_t                    by,
+    const size_t                    bz) const
+{
+    return m_majorants[get_brick_cell(bx, by, bz)];
+}
+
+template <typename Visitor>
+void SparseVolumeGrid::traverse(
+    const foundation::Vector3f&     org,
+    const foundation::Vector3f&     dir,
+    float                           tmin,
+    float                           tmax,
+    Visitor&                        visitor) const
+{
+    // Clip the segment against the bounding box of the grid.
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (dir[i] != 0.0f)
+        {
+            const float rcp_dir = 1.0f / dir[i];
+            float t0 = (m_bbox.min[i] - org[i]) * rcp_dir;
+            float t1 = (m_bbox.max[i] - org[i]) * rcp_dir;
+            if (t0 > t1)
+                std::swap(t0, t1);
+            tmin = std::max(tmin, t0);
+            tmax = std::min(tmax, t1);
+        }
+        else if (org[i] < m_bbox.min[i] || org[i] > m_bbox.max[i])
+            return;
+    }
+
+    if (!(tmin < tmax))
+        return;
+
+    // Setup the 3D-DDA over the brick grid.
+    const foundation::Vector3f p = org + tmin * dir;
+    int cell[3], step[3], cell_end[3];
+    float t_next[3], t_delta[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float brick_size = BrickSize * m_voxel_size[i];
+        const int n = static_cast<int>(m_brick_res[i]);
+
+        cell[i] =
+            foundation::clamp(
+                foundation::truncate<int>((p[i] - m_bbox.min[i]) / brick_size),
+                0, n - 1);
+
+        if (dir[i] > 0.0f)
+        {
+            step[i] = 1;
+            cell_end[i] = n;
+            t_next[i] = (m_bbox.min[i] + (cell[i] + 1) * brick_size - org[i]) / dir[i];
+            t_delta[i] = brick_size / dir[i];
+        }
+        else if (dir[i] < 0.0f)
+        {
+            step[i] = -1;
+            cell_end[i] = -1;
+            t_next[i] = (m_bbox.min[i] + cell[i] * brick_size - org[i]) / dir[i];
+            t_delta[i] = -brick_size / dir[i];
+        }
+        else
+        {
+            step[i] = 0;
+            cell_end[i] = -1;
+            t_next[i] = std::numeric_limits<float>::max();
+            t_delta[i] = 0.0f;
+        }
+    }
+
+    float t = tmin;
+
+    while (true)
+    {
+        const size_t axis =
+            t_next[0] < t_next[1]
+                ? (t_next[0] < t_next[2] ? 0 : 2)
+                : (t_next[1] < t_next[2] ? 1 : 2);
+
+        const float t_exit = std::min(t_next[axis], tmax);
+
+        if (t_exit > t)
+        {
+            const float majorant =
+                m_majorants[get_brick_cell(cell[0], cell[1], cell[2])];
+
+            if (!visitor.visit(t, t_exit, majorant))
+                return;
+        }
+
+        if (t_exit >= tmax)
+            return;
+
+        cell[axis] += step[axis];
+        if (cell[axis] == cell_end[axis])
+            return;
+
+        t = t_exit;
+        t_next[axis] += t_delta[axis];
+    }
+}
+
+}   // namespace renderer
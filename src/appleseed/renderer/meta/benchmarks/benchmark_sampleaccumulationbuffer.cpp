@@ -0,0 +1,284 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/globalsampleaccumulationbuffer.h"
+#include "renderer/kernel/rendering/progressive/samplecounter.h"
+#include "renderer/kernel/rendering/progressive/samplegeneratorjob.h"
+#include "renderer/kernel/rendering/sample.h"
+#include "renderer/kernel/rendering/samplegeneratorbase.h"
+#include "renderer/kernel/rendering/tiledsampleaccumulationbuffer.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/math/hash.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+BENCHMARK_SUITE(Renderer_Kernel_Rendering_SampleAccumulationBuffer)
+{
+    // Splat samples at pseudo-random pixels, like the light tracer does.
+    class ScatteringSampleGenerator
+      : public SampleGeneratorBase
+    {
+      public:
+        ScatteringSampleGenerator(
+            const CanvasProperties& props,
+            const size_t            generator_index,
+            const size_t            generator_count)
+          : SampleGeneratorBase(generator_index, generator_count)
+          , m_width(static_cast<uint32>(props.m_canvas_width))
+          , m_height(static_cast<uint32>(props.m_canvas_height))
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        void print_settings() const override
+        {
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            return StatisticsVector();
+        }
+
+      private:
+        const uint32 m_width;
+        const uint32 m_height;
+
+        size_t generate_samples(
+            const size_t            sequence_index,
+            SampleVector&           samples) override
+        {
+            const uint32 h = hash_uint32(static_cast<uint32>(sequence_index));
+
+            Sample sample;
+            sample.m_pixel_coords.x = static_cast<int>(h % m_width);
+            sample.m_pixel_coords.y = static_cast<int>((h / m_width) % m_height);
+            sample.m_color = Color4f(0.5f, 0.5f, 0.5f, 1.0f);
+            samples.push_back(sample);
+
+            return 1;
+        }
+    };
+
+    template <typename Buffer>
+    Buffer* create_buffer(const CanvasProperties& props);
+
+    template <>
+    GlobalSampleAccumulationBuffer* create_buffer(const CanvasProperties& props)
+    {
+        return
+            new GlobalSampleAccumulationBuffer(
+                props.m_canvas_width,
+                props.m_canvas_height);
+    }
+
+    template <>
+    TiledSampleAccumulationBuffer* create_buffer(const CanvasProperties& props)
+    {
+        return
+            new TiledSampleAccumulationBuffer(
+                props.m_canvas_width,
+                props.m_canvas_height,
+                props.m_tile_width,
+                props.m_tile_height);
+    }
+
+    template <typename Buffer, size_t ThreadCount>
+    struct Fixture
+    {
+        // The number of samples divided by the runtime of a case gives the throughput.
+        static const uint64 SampleCount = 4 * 1000 * 1000;
+
+        // Period of the display refresh (30 Hz).
+        static const uint32 DevelopPeriodMs = 33;
+
+        Logger                                  m_logger;
+        JobQueue                                m_job_queue;
+        JobManager                              m_job_manager;
+        AbortSwitch                             m_abort_switch;
+        auto_release_ptr<Frame>                 m_frame;
+        unique_ptr<Buffer>                      m_buffer;
+        SampleCounter                           m_sample_counter;
+        vector<ISampleGenerator*>               m_sample_generators;
+        vector<SampleGeneratorJob*>             m_sample_generator_jobs;
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          , m_frame(
+                FrameFactory::create("frame",
+                    ParamArray()
+                        .insert("resolution", "1280 720")
+                        .insert("tile_size", "64 64")))
+          , m_buffer(create_buffer<Buffer>(m_frame->image().properties()))
+          , m_sample_counter(SampleCount)
+        {
+            for (size_t i = 0; i < ThreadCount; ++i)
+            {
+                m_sample_generators.push_back(
+                    new ScatteringSampleGenerator(
+                        m_frame->image().properties(),
+                        i,
+                        ThreadCount));
+
+                m_sample_generator_jobs.push_back(
+                    new SampleGeneratorJob(
+                        *m_buffer,
+                        m_sample_generators[i],
+                        m_sample_counter,
+                        Spectrum::RGB,
+                        m_job_queue,
+                        i,
+                        m_abort_switch));
+            }
+
+            m_job_manager.start();
+        }
+
+        ~Fixture()
+        {
+            m_job_manager.stop();
+
+            for (size_t i = 0; i < ThreadCount; ++i)
+            {
+                delete m_sample_generator_jobs[i];
+                m_sample_generators[i]->release();
+            }
+        }
+
+        void payload()
+        {
+            m_buffer->clear();
+            m_sample_counter.clear();
+
+            for (size_t i = 0; i < ThreadCount; ++i)
+            {
+                m_sample_generators[i]->reset();
+                m_job_queue.schedule(m_sample_generator_jobs[i], false);
+            }
+
+            // Develop the buffer to the frame at a fixed rate while samples are being generated.
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            double last_develop_time = 0.0;
+
+            while (m_job_queue.has_scheduled_or_running_jobs())
+            {
+                const double time = stopwatch.measure().get_seconds();
+
+                if (time - last_develop_time >= DevelopPeriodMs * 0.001)
+                {
+                    m_buffer->develop_to_frame(m_frame.ref(), m_abort_switch);
+                    last_develop_time = time;
+                }
+
+                foundation::sleep(1);
+            }
+
+            m_job_queue.wait_until_completion();
+        }
+    };
+
+    typedef Fixture<GlobalSampleAccumulationBuffer, 1> Global1ThreadFixture;
+    typedef Fixture<GlobalSampleAccumulationBuffer, 2> Global2ThreadFixture;
+    typedef Fixture<GlobalSampleAccumulationBuffer, 4> Global4ThreadFixture;
+    typedef Fixture<GlobalSampleAccumulationBuffer, 8> Global8ThreadFixture;
+
+    typedef Fixture<TiledSampleAccumulationBuffer, 1> Tiled1ThreadFixture;
+    typedef Fixture<TiledSampleAccumulationBuffer, 2> Tiled2ThreadFixture;
+    typedef Fixture<TiledSampleAccumulationBuffer, 4> Tiled4ThreadFixture;
+    typedef Fixture<TiledSampleAccumulationBuffer, 8> Tiled8ThreadFixture;
+
+    BENCHMARK_CASE_F(Global_StoreSamples_1Thread_Develop30Hz, Global1ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Global_StoreSamples_2Threads_Develop30Hz, Global2ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Global_StoreSamples_4Threads_Develop30Hz, Global4ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Global_StoreSamples_8Threads_Develop30Hz, Global8ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Tiled_StoreSamples_1Thread_Develop30Hz, Tiled1ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Tiled_StoreSamples_2Threads_Develop30Hz, Tiled2ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Tiled_StoreSamples_4Threads_Develop30Hz, Tiled4ThreadFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(Tiled_StoreSamples_8Threads_Develop30Hz, Tiled8ThreadFixture)
+    {
+        payload();
+    }
+}
@@ -0,0 +1,311 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/texture/memorytexture2d.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/compressedtile.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+BENCHMARK_SUITE(Renderer_Kernel_Texturing_TextureStore)
+{
+    // 256 x 256 tiles: many more than a texture cache can hold, so that most lookups reach the store.
+    const size_t TileCountX = 256;
+    const size_t TileCountY = 256;
+    const size_t TileSize = 8;
+
+    const size_t LookupsPerJob = 16 * 1024;
+
+    struct TextureLookupJob
+      : public IJob
+    {
+        TextureCache    m_texture_cache;
+        UniqueID        m_texture_uid;
+        Xorshift32      m_rng;
+
+        TextureLookupJob(
+            TextureStore&   texture_store,
+            const UniqueID  texture_uid,
+            const uint32    seed)
+          : m_texture_cache(texture_store)
+          , m_texture_uid(texture_uid)
+          , m_rng(seed)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = 0; i < LookupsPerJob; ++i)
+            {
+                const size_t tile_x = static_cast<size_t>(rand_int1(m_rng, 0, TileCountX - 1));
+                const size_t tile_y = static_cast<size_t>(rand_int1(m_rng, 0, TileCountY - 1));
+                m_texture_cache.get(~UniqueID(0), m_texture_uid, tile_x, tile_y);
+            }
+        }
+    };
+
+    template <size_t ThreadCount, size_t ShardCount>
+    struct Fixture
+    {
+        auto_release_ptr<Scene>                 m_scene;
+        unique_ptr<TextureStore>                m_texture_store;
+        vector<unique_ptr<TextureLookupJob>>    m_jobs;
+        Logger                                  m_logger;
+        JobQueue                                m_job_queue;
+        JobManager                              m_job_manager;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+        {
+            auto_release_ptr<Image> image(
+                new Image(
+                    TileCountX * TileSize,
+                    TileCountY * TileSize,
+                    TileSize,
+                    TileSize,
+                    1,
+                    PixelFormatUInt8));
+
+            m_scene->textures().insert(
+                MemoryTexture2dFactory().create(
+                    "texture",
+                    ParamArray().insert("color_space", "linear_rgb"),
+                    image));
+
+            const UniqueID texture_uid = m_scene->textures().get_by_name("texture")->get_uid();
+
+            m_texture_store.reset(
+                new TextureStore(
+                    m_scene.ref(),
+                    ParamArray().insert("shard_count", ShardCount)));
+
+            for (size_t i = 0; i < ThreadCount; ++i)
+            {
+                m_jobs.push_back(
+                    unique_ptr<TextureLookupJob>(
+                        new TextureLookupJob(
+                            *m_texture_store,
+                            texture_uid,
+                            static_cast<uint32>(i + 1))));
+            }
+
+            m_job_manager.start();
+        }
+
+        void payload()
+        {
+            for (size_t i = 0; i < ThreadCount; ++i)
+                m_job_queue.schedule(m_jobs[i].get(), false);
+
+            m_job_queue.wait_until_completion();
+        }
+    };
+
+    typedef Fixture<1, 1> Fixture1Thread1Shard;
+    typedef Fixture<8, 1> Fixture8Threads1Shard;
+    typedef Fixture<8, 64> Fixture8Threads64Shards;
+    typedef Fixture<32, 1> Fixture32Threads1Shard;
+    typedef Fixture<32, 64> Fixture32Threads64Shards;
+
+    BENCHMARK_CASE_F(GetTiles_1Thread_1Shard, Fixture1Thread1Shard)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(GetTiles_8Threads_1Shard, Fixture8Threads1Shard)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(GetTiles_8Threads_64Shards, Fixture8Threads64Shards)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(GetTiles_32Threads_1Shard, Fixture32Threads1Shard)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(GetTiles_32Threads_64Shards, Fixture32Threads64Shards)
+    {
+        payload();
+    }
+}
+
+BENCHMARK_SUITE(Renderer_Kernel_Texturing_TextureStore_TileCompression)
+{
+    // A 2048 x 2048 RGB texture (12 MB) looked up through a 4 MB texture store:
+    // uncompressed tiles only partially fit in the store while compressed tiles all fit.
+    const size_t TileCount = 64;
+    const size_t TileSize = 32;
+    const size_t StoreSize = 4 * 1024 * 1024;
+
+    const size_t LookupCount = 64 * 1024;
+
+    template <bool CompressTiles>
+    struct Fixture
+    {
+        auto_release_ptr<Scene>             m_scene;
+        UniqueID                            m_texture_uid;
+        unique_ptr<TextureStore>            m_texture_store;
+        unique_ptr<TextureCache>            m_texture_cache;
+        Xorshift32                          m_rng;
+        Color4f                             m_accumulator;
+        Logger                              m_logger;
+        auto_release_ptr<FileLogTarget>     m_log_target;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_accumulator(0.0f)
+        {
+            const size_t size = TileCount * TileSize;
+
+            auto_release_ptr<Image> image(
+                new Image(size, size, TileSize, TileSize, 3, PixelFormatUInt8));
+
+            // Fill the texture with a smooth pattern plus some noise.
+            Xorshift32 rng;
+            for (size_t y = 0; y < size; ++y)
+            {
+                for (size_t x = 0; x < size; ++x)
+                {
+                    const Color<uint8, 3> color(
+                        static_cast<uint8>(x + rand_int1(rng, 0, 7)),
+                        static_cast<uint8>(y + rand_int1(rng, 0, 7)),
+                        static_cast<uint8>((x + y) / 2));
+                    image->set_pixel(x, y, color);
+                }
+            }
+
+            m_scene->textures().insert(
+                MemoryTexture2dFactory().create(
+                    "texture",
+                    ParamArray().insert("color_space", "linear_rgb"),
+                    image));
+
+            m_texture_uid = m_scene->textures().get_by_name("texture")->get_uid();
+
+            m_texture_store.reset(
+                new TextureStore(
+                    m_scene.ref(),
+                    ParamArray()
+                        .insert("max_size", StoreSize)
+                        .insert("shard_count", 1)
+                        .insert("compress_tiles", CompressTiles)));
+
+            m_texture_cache.reset(new TextureCache(*m_texture_store));
+
+            m_log_target.reset(create_file_log_target());
+            m_log_target->open(
+                (string("unit benchmarks/outputs/benchmark_texturestore_")
+                    + (CompressTiles ? "compressed" : "uncompressed")
+                    + "_stats.txt").c_str());
+            m_logger.add_target(m_log_target.get());
+        }
+
+        ~Fixture()
+        {
+            // Report cache hit rates for comparison between the two residency formats.
+            StatisticsVector stats;
+            stats.merge(m_texture_cache->get_statistics());
+            stats.merge(m_texture_store->get_statistics());
+            LOG_INFO(m_logger, "%s", stats.to_string().c_str());
+        }
+
+        void payload()
+        {
+            const size_t size = TileCount * TileSize;
+
+            for (size_t i = 0; i < LookupCount; ++i)
+            {
+                const size_t x = static_cast<size_t>(rand_int1(m_rng, 0, static_cast<int32>(size - 1)));
+                const size_t y = static_cast<size_t>(rand_int1(m_rng, 0, static_cast<int32>(size - 1)));
+
+                const TextureStore::TileRecord& record =
+                    m_texture_cache->get(
+                        ~UniqueID(0),
+                        m_texture_uid,
+                        x / TileSize,
+                        y / TileSize);
+
+                Color4f texel;
+                if (record.m_compressed_tile)
+                    record.m_compressed_tile->get_pixel(x % TileSize, y % TileSize, texel);
+                else
+                {
+                    Color3f rgb;
+                    record.m_tile->get_pixel(x % TileSize, y % TileSize, rgb);
+                    texel = Color4f(rgb, 1.0f);
+                }
+
+                m_accumulator += texel;
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(LookupTexels_UncompressedTiles, Fixture<false>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(LookupTexels_CompressedTiles, Fixture<true>)
+    {
+        payload();
+    }
+}
@@ -0,0 +1,227 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/containers/dictionary.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+BENCHMARK_SUITE(Renderer_Kernel_Intersection_TriangleTree)
+{
+    // A bumpy sphere made of about 600,000 static triangles.
+    const size_t SegmentCountU = 768;
+    const size_t SegmentCountV = 384;
+
+    // Number of rays traced by each benchmark iteration.
+    const size_t RayCount = 1024;
+
+    template <bool SIMDLeaves, bool CompactLeaves, size_t MaxLeafSize>
+    struct TestScene
+      : public TestSceneBase
+    {
+        TestScene()
+        {
+            ParamArray assembly_params;
+            assembly_params.insert_path("acceleration_structure.simd_leaves", SIMDLeaves);
+            assembly_params.insert_path("acceleration_structure.compact_leaves", CompactLeaves);
+            assembly_params.insert_path("acceleration_structure.max_leaf_size", MaxLeafSize);
+
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", assembly_params));
+
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create("sphere", ParamArray()));
+
+            for (size_t j = 0; j <= SegmentCountV; ++j)
+            {
+                for (size_t i = 0; i < SegmentCountU; ++i)
+                {
+                    const float theta = Pi<float>() * j / SegmentCountV;
+                    const float phi = TwoPi<float>() * i / SegmentCountU;
+                    const float radius = 1.0f + 0.02f * sin(37.0f * theta) * sin(41.0f * phi);
+
+                    mesh_object->push_vertex(
+                        radius * GVector3(
+                            sin(theta) * cos(phi),
+                            cos(theta),
+                            sin(theta) * sin(phi)));
+                }
+            }
+
+            for (size_t j = 0; j < SegmentCountV; ++j)
+            {
+                for (size_t i = 0; i < SegmentCountU; ++i)
+                {
+                    const size_t v0 = j * SegmentCountU + i;
+                    const size_t v1 = j * SegmentCountU + (i + 1) % SegmentCountU;
+                    const size_t v2 = v1 + SegmentCountU;
+                    const size_t v3 = v0 + SegmentCountU;
+
+                    mesh_object->push_triangle(Triangle(v0, v1, v2, 0));
+                    mesh_object->push_triangle(Triangle(v2, v3, v0, 0));
+                }
+            }
+
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "sphere_inst",
+                    ParamArray(),
+                    "sphere",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_inst",
+                    ParamArray(),
+                    "assembly"));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    template <bool SIMDLeaves, bool CompactLeaves, size_t MaxLeafSize>
+    struct Fixture
+      : public StaticTestSceneContext<TestScene<SIMDLeaves, CompactLeaves, MaxLeafSize>>
+    {
+        TraceContext            m_trace_context;
+        TextureStore            m_texture_store;
+        TextureCache            m_texture_cache;
+        Intersector             m_intersector;
+        vector<ShadingRay>      m_rays;
+        size_t                  m_hit_count;
+
+        Fixture()
+          : m_trace_context(TestScene<SIMDLeaves, CompactLeaves, MaxLeafSize>::m_scene)
+          , m_texture_store(TestScene<SIMDLeaves, CompactLeaves, MaxLeafSize>::m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+          , m_hit_count(0)
+        {
+            m_trace_context.update();
+
+            // Rays start on a sphere around the mesh and aim at random points inside it.
+            MersenneTwister rng;
+            m_rays.reserve(RayCount);
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                const Vector3d org = 2.0 * sample_sphere_uniform(rand_vector2<Vector2d>(rng));
+                const Vector3d target = 0.5 * sample_sphere_uniform(rand_vector2<Vector2d>(rng));
+
+                m_rays.emplace_back(
+                    org,
+                    normalize(target - org),
+                    0.0,                                    // tmin
+                    numeric_limits<double>::max(),          // tmax
+                    ShadingRay::Time(),
+                    VisibilityFlags::CameraRay,
+                    0);                                     // depth
+            }
+        }
+
+        void trace_rays()
+        {
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                ShadingPoint shading_point;
+                if (m_intersector.trace(m_rays[i], shading_point))
+                    ++m_hit_count;
+            }
+        }
+    };
+
+    typedef Fixture<false, false, 2> ScalarLeaves2Fixture;
+    typedef Fixture<false, false, 4> ScalarLeaves4Fixture;
+    typedef Fixture<true, false, 4> SIMDLeaves4Fixture;
+    typedef Fixture<true, false, 8> SIMDLeaves8Fixture;
+    typedef Fixture<false, true, 2> CompactLeaves2Fixture;
+
+    BENCHMARK_CASE_F(Trace_ScalarLeaves_MaxLeafSize2, ScalarLeaves2Fixture)
+    {
+        trace_rays();
+    }
+
+    BENCHMARK_CASE_F(Trace_ScalarLeaves_MaxLeafSize4, ScalarLeaves4Fixture)
+    {
+        trace_rays();
+    }
+
+    BENCHMARK_CASE_F(Trace_SIMDLeaves_MaxLeafSize4, SIMDLeaves4Fixture)
+    {
+        trace_rays();
+    }
+
+    BENCHMARK_CASE_F(Trace_SIMDLeaves_MaxLeafSize8, SIMDLeaves8Fixture)
+    {
+        trace_rays();
+    }
+
+    BENCHMARK_CASE_F(Trace_CompactLeaves_MaxLeafSize2, CompactLeaves2Fixture)
+    {
+        trace_rays();
+    }
+}
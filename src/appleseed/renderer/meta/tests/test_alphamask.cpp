@@ -0,0 +1,172 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/alphamask.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/bitmask.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Intersection_AlphaMask)
+{
+    // A 37x21 mask: opaque on the left, transparent on the right, with a noisy band in between.
+    struct Fixture
+    {
+        BitMask2    m_texels;
+
+        Fixture()
+          : m_texels(37, 21)
+        {
+            MersenneTwister rng;
+
+            for (size_t y = 0; y < m_texels.get_height(); ++y)
+            {
+                for (size_t x = 0; x < m_texels.get_width(); ++x)
+                {
+                    const bool opaque =
+                        x < 16 ? true :
+                        x < 20 ? rand_int1(rng, 0, 1) == 1 :
+                        false;
+
+                    m_texels.set(x, y, opaque);
+                }
+            }
+        }
+
+        AlphaMask::Coverage get_reference_coverage(
+            const size_t x0,
+            const size_t y0,
+            const size_t x1,
+            const size_t y1) const
+        {
+            size_t opaque_count = 0;
+
+            for (size_t y = y0; y <= y1; ++y)
+            {
+                for (size_t x = x0; x <= x1; ++x)
+                    opaque_count += m_texels.is_set(x, y) ? 1 : 0;
+            }
+
+            return
+                opaque_count == 0 ? AlphaMask::Transparent :
+                opaque_count == (x1 - x0 + 1) * (y1 - y0 + 1) ? AlphaMask::Opaque :
+                AlphaMask::Partial;
+        }
+    };
+
+    TEST_CASE_F(IsOpaque_MatchesSourceTexels, Fixture)
+    {
+        const AlphaMask mask(m_texels);
+
+        for (size_t y = 0; y < m_texels.get_height(); ++y)
+        {
+            for (size_t x = 0; x < m_texels.get_width(); ++x)
+            {
+                const Vector2f uv(
+                    (x + 0.5f) / m_texels.get_width(),
+                    (y + 0.5f) / m_texels.get_height());
+
+                EXPECT_EQ(m_texels.is_set(x, y), mask.is_opaque(uv));
+            }
+        }
+    }
+
+    TEST_CASE_F(Constructor_StoresOnlyPartialBlocks, Fixture)
+    {
+        const AlphaMask mask(m_texels);
+
+        // 5x3 blocks, the noisy band spans the third column of blocks.
+        EXPECT_EQ(15, mask.get_block_count());
+        EXPECT_EQ(3, mask.get_partial_block_count());
+    }
+
+    TEST_CASE_F(GetCoverage_GivenTexelRectangles_MatchesReference, Fixture)
+    {
+        const AlphaMask mask(m_texels);
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            size_t x0 = rand_int1(rng, 0, 36), x1 = rand_int1(rng, 0, 36);
+            size_t y0 = rand_int1(rng, 0, 20), y1 = rand_int1(rng, 0, 20);
+
+            if (x0 > x1) swap(x0, x1);
+            if (y0 > y1) swap(y0, y1);
+
+            EXPECT_EQ(
+                get_reference_coverage(x0, y0, x1, y1),
+                mask.get_coverage(x0, y0, x1, y1));
+        }
+    }
+
+    TEST_CASE_F(GetCoverage_GivenTriangles_IsConservative, Fixture)
+    {
+        const AlphaMask mask(m_texels);
+
+        EXPECT_EQ(
+            AlphaMask::Opaque,
+            mask.get_coverage(Vector2f(0.05f, 0.1f), Vector2f(0.3f, 0.1f), Vector2f(0.1f, 0.9f)));
+
+        EXPECT_EQ(
+            AlphaMask::Transparent,
+            mask.get_coverage(Vector2f(0.7f, 0.1f), Vector2f(0.95f, 0.1f), Vector2f(0.8f, 0.9f)));
+
+        // Straddles the noisy band.
+        EXPECT_EQ(
+            AlphaMask::Partial,
+            mask.get_coverage(Vector2f(0.3f, 0.1f), Vector2f(0.7f, 0.1f), Vector2f(0.5f, 0.9f)));
+
+        // Ends right next to the noisy band.
+        EXPECT_EQ(
+            AlphaMask::Partial,
+            mask.get_coverage(Vector2f(0.1f, 0.1f), Vector2f(15.9f / 37, 0.1f), Vector2f(0.1f, 0.9f)));
+    }
+
+    TEST_CASE(GetMemorySize_GivenUniformMask_IsSmallerThanBitmask)
+    {
+        BitMask2 texels(1024, 1024);
+        texels.clear();
+
+        const AlphaMask mask(texels);
+
+        EXPECT_EQ(0, mask.get_partial_block_count());
+        EXPECT_LT(texels.get_memory_size(), mask.get_memory_size());
+    }
+}
@@ -0,0 +1,285 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/checkpointjournal.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+namespace bf = boost::filesystem;
+
+TEST_SUITE(Renderer_Kernel_Rendering_CheckpointJournal)
+{
+    const char* JournalPath = "unit tests/outputs/test_checkpointjournal.journal";
+    const char* OtherJournalPath = "unit tests/outputs/test_checkpointjournal_copy.journal";
+
+    // A 10x6 canvas made of 3x2 tiles of at most 4x4 pixels, with two layers.
+    const size_t CanvasWidth = 10;
+    const size_t CanvasHeight = 6;
+    const size_t TileSize = 4;
+    const size_t TileCountX = 3;
+    const size_t TileCountY = 2;
+
+    vector<size_t> make_layer_pixel_sizes()
+    {
+        vector<size_t> sizes;
+        sizes.push_back(5 * sizeof(float));
+        sizes.push_back(3 * sizeof(uint8));
+        return sizes;
+    }
+
+    struct TileLayers
+    {
+        unique_ptr<Tile> m_accumulator;
+        unique_ptr<Tile> m_aov;
+
+        TileLayers(const size_t tile_x, const size_t tile_y)
+        {
+            const size_t width = min(TileSize, CanvasWidth - tile_x * TileSize);
+            const size_t height = min(TileSize, CanvasHeight - tile_y * TileSize);
+            m_accumulator.reset(new Tile(width, height, 5, PixelFormatFloat));
+            m_aov.reset(new Tile(width, height, 3, PixelFormatUInt8));
+        }
+
+        void fill(const size_t pass, const size_t tile_x, const size_t tile_y)
+        {
+            const float value = static_cast<float>(100 * pass + 10 * tile_y + tile_x);
+            float* accumulator = reinterpret_cast<float*>(m_accumulator->get_storage());
+            for (size_t i = 0, e = m_accumulator->get_pixel_count() * 5; i < e; ++i)
+                accumulator[i] = value + static_cast<float>(i);
+
+            uint8* aov = m_aov->get_storage();
+            for (size_t i = 0, e = m_aov->get_size(); i < e; ++i)
+                aov[i] = static_cast<uint8>(pass + i);
+        }
+
+        bool equals(const TileLayers& rhs) const
+        {
+            return
+                equal(
+                    m_accumulator->get_storage(),
+                    m_accumulator->get_storage() + m_accumulator->get_size(),
+                    rhs.m_accumulator->get_storage()) &&
+                equal(
+                    m_aov->get_storage(),
+                    m_aov->get_storage() + m_aov->get_size(),
+                    rhs.m_aov->get_storage());
+        }
+    };
+
+    void write_tile(
+        CheckpointJournal&  journal,
+        const size_t        pass,
+        const size_t        tile_x,
+        const size_t        tile_y)
+    {
+        TileLayers layers(tile_x, tile_y);
+        layers.fill(pass, tile_x, tile_y);
+
+        const Tile* tiles[] = { layers.m_accumulator.get(), layers.m_aov.get() };
+        journal.write_tile(pass, tile_x, tile_y, tiles);
+    }
+
+    void write_pass(CheckpointJournal& journal, const size_t pass)
+    {
+        for (size_t tile_y = 0; tile_y < TileCountY; ++tile_y)
+        {
+            for (size_t tile_x = 0; tile_x < TileCountX; ++tile_x)
+                write_tile(journal, pass, tile_x, tile_y);
+        }
+
+        journal.write_pass(pass);
+    }
+
+    bool check_tile(
+        const CheckpointJournal&    journal,
+        const size_t                max_pass,
+        const size_t                expected_pass,
+        const size_t                tile_x,
+        const size_t                tile_y)
+    {
+        TileLayers expected(tile_x, tile_y);
+        expected.fill(expected_pass, tile_x, tile_y);
+
+        TileLayers actual(tile_x, tile_y);
+        Tile* tiles[] = { actual.m_accumulator.get(), actual.m_aov.get() };
+
+        return
+            journal.read_tile(tile_x, tile_y, max_pass, tiles) &&
+            actual.equals(expected);
+    }
+
+    struct Fixture
+    {
+        CheckpointJournal m_journal;
+
+        Fixture()
+          : m_journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes())
+        {
+        }
+    };
+
+    TEST_CASE_F(Read_GivenPartialPass_RestoresLatestTileRecords, Fixture)
+    {
+        m_journal.begin_writing(JournalPath);
+        write_pass(m_journal, 0);
+        write_tile(m_journal, 1, 2, 1);
+        m_journal.end_writing();
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes());
+        ASSERT_TRUE(journal.read(JournalPath));
+
+        EXPECT_EQ(0, journal.get_last_complete_pass());
+        EXPECT_EQ(1, journal.get_tile_pass(2, 1));
+        EXPECT_EQ(0, journal.get_tile_pass(1, 1));
+        EXPECT_TRUE(check_tile(journal, CheckpointJournal::NoPass, 1, 2, 1));
+        EXPECT_TRUE(check_tile(journal, CheckpointJournal::NoPass, 0, 1, 1));
+    }
+
+    TEST_CASE_F(Read_GivenMaxPass_RestoresRecordsOfThatPass, Fixture)
+    {
+        m_journal.begin_writing(JournalPath);
+        write_pass(m_journal, 0);
+        write_tile(m_journal, 1, 0, 0);
+        m_journal.end_writing();
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes());
+        ASSERT_TRUE(journal.read(JournalPath));
+
+        EXPECT_EQ(0, journal.get_tile_pass(0, 0, 0));
+        EXPECT_TRUE(check_tile(journal, 0, 0, 0, 0));
+    }
+
+    TEST_CASE_F(Read_GivenTruncatedJournal_IgnoresIncompleteRecord, Fixture)
+    {
+        m_journal.begin_writing(JournalPath);
+        write_pass(m_journal, 0);
+        write_tile(m_journal, 1, 0, 0);
+        m_journal.end_writing();
+
+        bf::resize_file(JournalPath, m_journal.get_size() - 7);
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes());
+        ASSERT_TRUE(journal.read(JournalPath));
+
+        EXPECT_EQ(0, journal.get_tile_pass(0, 0));
+        EXPECT_EQ(TileCountX * TileCountY + 1, journal.get_record_count());
+        EXPECT_TRUE(check_tile(journal, CheckpointJournal::NoPass, 0, 0, 0));
+    }
+
+    TEST_CASE_F(Read_GivenDifferentLayout_ReturnsFalse, Fixture)
+    {
+        m_journal.begin_writing(JournalPath);
+        write_pass(m_journal, 0);
+        m_journal.end_writing();
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, vector<size_t>(1, 4));
+
+        EXPECT_FALSE(journal.read(JournalPath));
+    }
+
+    TEST_CASE_F(BeginWriting_GivenJournalThatWasRead_AppendsToIt, Fixture)
+    {
+        m_journal.begin_writing(JournalPath);
+        write_pass(m_journal, 0);
+        write_tile(m_journal, 1, 1, 0);
+        m_journal.end_writing();
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes());
+        ASSERT_TRUE(journal.read(JournalPath));
+        journal.begin_writing(JournalPath);
+        write_tile(journal, 1, 2, 0);
+        journal.end_writing();
+
+        ASSERT_TRUE(journal.read(JournalPath));
+        EXPECT_EQ(1, journal.get_tile_pass(1, 0));
+        EXPECT_EQ(1, journal.get_tile_pass(2, 0));
+        EXPECT_TRUE(check_tile(journal, CheckpointJournal::NoPass, 1, 2, 0));
+    }
+
+    TEST_CASE_F(BeginWriting_GivenJournalReadFromAnotherFile_CopiesLatestRecords, Fixture)
+    {
+        m_journal.begin_writing(JournalPath);
+        write_pass(m_journal, 0);
+        write_tile(m_journal, 1, 1, 1);
+        m_journal.end_writing();
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes());
+        ASSERT_TRUE(journal.read(JournalPath));
+        journal.begin_writing(OtherJournalPath);
+        journal.end_writing();
+
+        ASSERT_TRUE(journal.read(OtherJournalPath));
+        EXPECT_EQ(0, journal.get_last_complete_pass());
+        EXPECT_EQ(1, journal.get_tile_pass(1, 1));
+        EXPECT_EQ(0, journal.get_tile_pass(1, 1, 0));
+        EXPECT_TRUE(check_tile(journal, CheckpointJournal::NoPass, 1, 1, 1));
+        EXPECT_TRUE(check_tile(journal, 0, 0, 1, 1));
+    }
+
+    TEST_CASE_F(WritePass_GivenManyPasses_CompactsJournal, Fixture)
+    {
+        const size_t PassCount = 10;
+
+        m_journal.begin_writing(JournalPath);
+        for (size_t pass = 0; pass < PassCount; ++pass)
+            write_pass(m_journal, pass);
+        m_journal.end_writing();
+
+        EXPECT_GT(0, m_journal.get_record_count());
+        EXPECT_LT(4 * (TileCountX * TileCountY + 1), m_journal.get_record_count());
+
+        CheckpointJournal journal(CanvasWidth, CanvasHeight, TileSize, TileSize, make_layer_pixel_sizes());
+        ASSERT_TRUE(journal.read(JournalPath));
+
+        EXPECT_EQ(PassCount - 1, journal.get_last_complete_pass());
+        EXPECT_EQ(m_journal.get_record_count(), journal.get_record_count());
+
+        for (size_t tile_y = 0; tile_y < TileCountY; ++tile_y)
+        {
+            for (size_t tile_x = 0; tile_x < TileCountX; ++tile_x)
+                EXPECT_TRUE(check_tile(journal, CheckpointJournal::NoPass, PassCount - 1, tile_x, tile_y));
+        }
+    }
+}
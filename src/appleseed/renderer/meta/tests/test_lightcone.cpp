@@ -0,0 +1,113 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lightcone.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightCone)
+{
+    TEST_CASE(Merge_GivenIdenticalCones_ReturnsSameCone)
+    {
+        const LightCone cone(Vector3f(0.0f, 0.0f, 1.0f), 0.5f, HalfPi<float>());
+
+        const LightCone result = LightCone::merge(cone, cone);
+
+        EXPECT_FEQ(cone.m_axis, result.m_axis);
+        EXPECT_FEQ(cone.m_theta_o, result.m_theta_o);
+        EXPECT_FEQ(cone.m_theta_e, result.m_theta_e);
+    }
+
+    TEST_CASE(Merge_GivenConeContainedInOther_ReturnsWiderCone)
+    {
+        const LightCone wide(Vector3f(0.0f, 0.0f, 1.0f), 1.0f, HalfPi<float>());
+        const LightCone narrow(normalize(Vector3f(0.1f, 0.0f, 1.0f)), 0.1f, 0.2f);
+
+        const LightCone result = LightCone::merge(narrow, wide);
+
+        EXPECT_FEQ(wide.m_axis, result.m_axis);
+        EXPECT_FEQ(wide.m_theta_o, result.m_theta_o);
+        EXPECT_FEQ(HalfPi<float>(), result.m_theta_e);
+    }
+
+    TEST_CASE(Merge_GivenOrthogonalDirections_ReturnsConeBoundingBoth)
+    {
+        const LightCone a(Vector3f(1.0f, 0.0f, 0.0f), 0.0f, HalfPi<float>());
+        const LightCone b(Vector3f(0.0f, 1.0f, 0.0f), 0.0f, HalfPi<float>());
+
+        const LightCone result = LightCone::merge(a, b);
+
+        EXPECT_FEQ_EPS(normalize(Vector3f(1.0f, 1.0f, 0.0f)), result.m_axis, 1.0e-5f);
+        EXPECT_FEQ_EPS(Pi<float>() / 4.0f, result.m_theta_o, 1.0e-5f);
+    }
+
+    TEST_CASE(Merge_GivenOppositeDirections_ReturnsConeBoundingAllDirections)
+    {
+        const LightCone a(Vector3f(0.0f, 0.0f, 1.0f), 0.0f, HalfPi<float>());
+        const LightCone b(Vector3f(0.0f, 0.0f, -1.0f), 0.0f, HalfPi<float>());
+
+        const LightCone result = LightCone::merge(a, b);
+
+        EXPECT_FEQ(Pi<float>(), result.m_theta_o);
+    }
+
+    TEST_CASE(MaxCosEmission_GivenReceiverBehindOneSidedLight_ReturnsZero)
+    {
+        const LightCone cone(Vector3f(0.0f, 0.0f, 1.0f), 0.0f, HalfPi<float>());
+
+        EXPECT_EQ(0.0f, cone.max_cos_emission(Vector3f(0.0f, 0.0f, -1.0f), 0.1f));
+    }
+
+    TEST_CASE(MaxCosEmission_GivenReceiverWithinNormalBound_ReturnsOne)
+    {
+        const LightCone cone(Vector3f(0.0f, 0.0f, 1.0f), 0.5f, HalfPi<float>());
+
+        EXPECT_FEQ(1.0f, cone.max_cos_emission(normalize(Vector3f(0.3f, 0.0f, 1.0f)), 0.0f));
+    }
+
+    TEST_CASE(MinCosEmission_IsNotGreaterThanMaxCosEmission)
+    {
+        const LightCone cone(Vector3f(0.0f, 0.0f, 1.0f), 0.2f, HalfPi<float>());
+        const Vector3f outgoing = normalize(Vector3f(1.0f, 0.0f, 1.0f));
+
+        const float min_cos = cone.min_cos_emission(outgoing, 0.1f);
+        const float max_cos = cone.max_cos_emission(outgoing, 0.1f);
+
+        EXPECT_LT(max_cos, min_cos);
+        EXPECT_GT(0.0f, min_cos);
+    }
+}
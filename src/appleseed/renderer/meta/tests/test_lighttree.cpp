@@ -0,0 +1,208 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lighttree.h"
+#include "renderer/kernel/lighting/lighttypes.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingpointbuilder.h"
+#include "renderer/modeling/edf/diffuseedf.h"
+#include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/basis.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightTree)
+{
+    struct TestScene
+      : public TestSceneBase
+    {
+        const Material* m_material;
+
+        TestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            assembly->edfs().insert(
+                DiffuseEDFFactory().create(
+                    "edf",
+                    ParamArray().insert("radiance", 1.0f)));
+
+            assembly->materials().insert(
+                GenericMaterialFactory().create(
+                    "material",
+                    ParamArray().insert("edf", "edf")));
+
+            m_material = assembly->materials().get_by_name("material");
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    struct Fixture
+      : public StaticTestSceneContext<TestScene>
+    {
+        static const size_t LightCount = 8;
+
+        vector<NonPhysicalLightInfo>    m_non_physical_lights;
+        vector<EmittingShape>           m_emitting_shapes;
+        ShadingPoint                    m_shading_point;
+
+        Fixture()
+        {
+            // A row of small triangles above the shading point, with different
+            // energies. Every other triangle faces away from the shading point,
+            // so that split nodes have children that cannot light it.
+            for (size_t i = 0; i < LightCount; ++i)
+            {
+                const Vector3d center(static_cast<double>(i) - 3.5, 0.0, 2.0);
+                const Vector3d n(0.0, 0.0, i % 2 == 0 ? -1.0 : 1.0);
+
+                m_emitting_shapes.push_back(
+                    EmittingShape::create_triangle_shape(
+                        nullptr,
+                        0,
+                        i,
+                        m_material,
+                        static_cast<double>(i + 1),
+                        center + Vector3d(-0.1, -0.1, 0.0),
+                        center + Vector3d(+0.1, -0.1, 0.0),
+                        center + Vector3d(0.0, +0.1, 0.0),
+                        n, n, n,
+                        n));
+            }
+
+            ShadingPointBuilder builder(m_shading_point);
+            builder.set_primitive_type(ShadingPoint::PrimitiveTriangle);
+            builder.set_point(Vector3d(0.5, 0.0, 0.0));
+            builder.set_shading_basis(Basis3d(Vector3d(0.0, 0.0, 1.0)));
+        }
+
+        // Draw stratified samples from a tree over the lights. Return the fraction
+        // of the calls to sample() that chose each light, the probability that
+        // evaluate_node_pdf() computes for each light, and the largest relative
+        // difference between the probability of a sample and that of its light.
+        void sample_lights(
+            const float     split_threshold,
+            const size_t    max_split_count,
+            vector<float>&  frequencies,
+            vector<float>&  pdfs,
+            float&          max_probability_error) const
+        {
+            LightTree light_tree(
+                m_non_physical_lights,
+                m_emitting_shapes,
+                split_threshold,
+                max_split_count);
+            const vector<size_t> light_to_node = light_tree.build();
+
+            pdfs.resize(LightCount);
+            for (size_t i = 0; i < LightCount; ++i)
+                pdfs[i] = light_tree.evaluate_node_pdf(m_shading_point, light_to_node[i]);
+
+            const size_t SampleCount = 100000;
+            vector<size_t> hit_counts(LightCount, 0);
+            max_probability_error = 0.0f;
+
+            for (size_t i = 0; i < SampleCount; ++i)
+            {
+                const float s = (static_cast<float>(i) + 0.5f) / SampleCount;
+
+                LightTree::Sample samples[LightTree::MaxSplitCount];
+                const size_t sample_count = light_tree.sample(m_shading_point, s, samples);
+
+                for (size_t j = 0; j < sample_count; ++j)
+                {
+                    const size_t light_index = samples[j].m_light_index;
+                    ++hit_counts[light_index];
+
+                    const float pdf = pdfs[light_index];
+                    const float error =
+                        pdf > 0.0f ? abs(samples[j].m_probability - pdf) / pdf : 1.0f;
+                    max_probability_error = max(max_probability_error, error);
+                }
+            }
+
+            frequencies.resize(LightCount);
+            for (size_t i = 0; i < LightCount; ++i)
+                frequencies[i] = static_cast<float>(hit_counts[i]) / SampleCount;
+        }
+    };
+
+    TEST_CASE_F(EvaluateNodePdf_WithoutSplitting_MatchesSamplingFrequencies, Fixture)
+    {
+        vector<float> frequencies, pdfs;
+        float max_probability_error;
+        sample_lights(0.0f, 1, frequencies, pdfs, max_probability_error);
+
+        for (size_t i = 0; i < LightCount; ++i)
+            EXPECT_FEQ_EPS(pdfs[i], frequencies[i], 1.0e-2f);
+
+        EXPECT_LT(1.0e-4f, max_probability_error);
+    }
+
+    TEST_CASE_F(EvaluateNodePdf_WithSplitting_MatchesSamplingFrequencies, Fixture)
+    {
+        vector<float> frequencies, pdfs;
+        float max_probability_error;
+        sample_lights(1.0f, LightTree::MaxSplitCount, frequencies, pdfs, max_probability_error);
+
+        for (size_t i = 0; i < LightCount; ++i)
+            EXPECT_FEQ_EPS(pdfs[i], frequencies[i], 1.0e-2f);
+
+        EXPECT_LT(1.0e-4f, max_probability_error);
+
+        // Lights facing away from the shading point are skipped by split nodes.
+        for (size_t i = 1; i < LightCount; i += 2)
+            EXPECT_EQ(0.0f, pdfs[i]);
+    }
+}
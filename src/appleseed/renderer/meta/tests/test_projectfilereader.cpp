@@ -28,9 +28,14 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/project/projectfilereader.h"
 #include "renderer/modeling/project/projectfilewriter.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
 #include "foundation/utility/autoreleaseptr.h"
@@ -41,10 +46,13 @@
 #include "boost/filesystem.hpp"
 
 // Standard headers.
+#include <cstddef>
 #include <exception>
+#include <string>
 
 using namespace foundation;
 using namespace renderer;
+using namespace std;
 namespace bf = boost::filesystem;
 
 TEST_SUITE(Renderer_Modeling_Project_ProjectFileReader)
@@ -100,6 +108,44 @@ TEST_SUITE(Renderer_Modeling_Project_ProjectFileReader)
         }
     }
 
+    TEST_CASE(Read_GivenParallelObjectLoading_CreatesSameObjectsInSameOrderAsSerialLoading)
+    {
+        ProjectFileReader reader;
+
+        auto_release_ptr<Project> serial_project =
+            reader.read(
+                "unit tests/inputs/test_projectfilereader_objects.appleseed",
+                "../../../schemas/project.xsd",             // path relative to input file
+                ProjectFileReader::OmitProjectFileUpdate | ProjectFileReader::OmitParallelLoading);
+
+        auto_release_ptr<Project> parallel_project =
+            reader.read(
+                "unit tests/inputs/test_projectfilereader_objects.appleseed",
+                "../../../schemas/project.xsd",             // path relative to input file
+                ProjectFileReader::OmitProjectFileUpdate);
+
+        ASSERT_NEQ(0, serial_project.get());
+        ASSERT_NEQ(0, parallel_project.get());
+
+        const ObjectContainer& serial_objects =
+            serial_project->get_scene()->assemblies().get_by_name("assembly")->objects();
+        const ObjectContainer& parallel_objects =
+            parallel_project->get_scene()->assemblies().get_by_name("assembly")->objects();
+
+        ASSERT_EQ(6, serial_objects.size());
+        ASSERT_EQ(serial_objects.size(), parallel_objects.size());
+
+        for (size_t i = 0; i < serial_objects.size(); ++i)
+        {
+            const MeshObject* serial_object = static_cast<const MeshObject*>(serial_objects.get_by_index(i));
+            const MeshObject* parallel_object = static_cast<const MeshObject*>(parallel_objects.get_by_index(i));
+
+            EXPECT_EQ(string(serial_object->get_name()), string(parallel_object->get_name()));
+            EXPECT_EQ(serial_object->get_vertex_count(), parallel_object->get_vertex_count());
+            EXPECT_EQ(serial_object->get_triangle_count(), parallel_object->get_triangle_count());
+        }
+    }
+
 #if 0
     // Test waits for a brilliant solution of how to invoke it without emitting error message
 
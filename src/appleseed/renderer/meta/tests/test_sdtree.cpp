@@ -0,0 +1,176 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sdtree.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SDTree)
+{
+    // Fill a tree with energy concentrated around the +Z axis.
+    void fill_dtree(DTree& tree, const size_t sample_count)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < sample_count; ++i)
+        {
+            const Vector3f d = sample_sphere_uniform(rand_vector2<Vector2f>(rng));
+            tree.record(d, d.z > 0.8f ? 10.0f : 0.1f);
+        }
+    }
+
+    TEST_CASE(DirToCanonical_CanonicalToDir_Roundtrip)
+    {
+        const Vector3f d = normalize(Vector3f(0.3f, -0.5f, 0.7f));
+
+        const Vector3f result = DTree::canonical_to_dir(DTree::dir_to_canonical(d));
+
+        EXPECT_FEQ_EPS(d, result, 1.0e-5f);
+    }
+
+    TEST_CASE(RefineFrom_SplitsCellsHoldingMostEnergy)
+    {
+        DTree learned;
+        fill_dtree(learned, 10000);
+
+        DTree tree;
+        tree.refine_from(learned, 0.01f, 20, 1024 * 1024);
+
+        EXPECT_GT(1, tree.get_node_count());
+        EXPECT_GT(1, tree.get_depth());
+        EXPECT_EQ(0.0f, tree.get_total());
+    }
+
+    TEST_CASE(RefineFrom_HonorsMaxDepth)
+    {
+        DTree learned;
+        fill_dtree(learned, 10000);
+
+        DTree tree;
+        tree.refine_from(learned, 0.0001f, 3, 1024 * 1024);
+
+        EXPECT_TRUE(tree.get_depth() <= 3);
+    }
+
+    TEST_CASE(EvaluatePDF_IntegratesToOne)
+    {
+        DTree learned;
+        fill_dtree(learned, 10000);
+
+        DTree tree;
+        tree.refine_from(learned, 0.01f, 20, 1024 * 1024);
+        fill_dtree(tree, 10000);
+
+        // Monte Carlo estimate of the integral of the pdf over the sphere.
+        MersenneTwister rng;
+        const size_t SampleCount = 100000;
+        double integral = 0.0;
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const Vector3f d = sample_sphere_uniform(rand_vector2<Vector2f>(rng));
+            integral += tree.evaluate_pdf(d) / RcpFourPi<double>();
+        }
+        integral /= SampleCount;
+
+        EXPECT_FEQ_EPS(1.0, integral, 0.02);
+    }
+
+    TEST_CASE(Sample_ReturnsPDFMatchingEvaluatePDF)
+    {
+        DTree learned;
+        fill_dtree(learned, 10000);
+
+        DTree tree;
+        tree.refine_from(learned, 0.01f, 20, 1024 * 1024);
+        fill_dtree(tree, 10000);
+
+        MersenneTwister rng;
+        size_t up_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            float pdf;
+            const Vector3f d = tree.sample(rand_vector2<Vector2f>(rng), pdf);
+
+            EXPECT_FEQ_EPS(1.0f, norm(d), 1.0e-4f);
+            EXPECT_FEQ_EPS(tree.evaluate_pdf(d), pdf, 1.0e-3f * pdf);
+
+            if (d.z > 0.8f)
+                ++up_count;
+        }
+
+        // About 92% of the energy comes from directions with z > 0.8; the piecewise
+        // constant approximation of the distribution blurs the boundary somewhat.
+        EXPECT_GT(700, up_count);
+    }
+
+    TEST_CASE(STree_Refine_BuildsSamplingDistribution)
+    {
+        ParamArray params;
+        params.insert("guiding_spatial_threshold", 100.0f);
+
+        STree tree(AABB3f(Vector3f(-1.0f), Vector3f(1.0f)), GuidingParameters(params));
+        EXPECT_FALSE(tree.is_built());
+
+        MersenneTwister rng;
+        tree.set_training(true);
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            const Vector3f p = rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f);
+            const Vector3f d = sample_sphere_uniform(rand_vector2<Vector2f>(rng));
+            tree.record(p, d, d.z > 0.8f ? 10.0f : 0.1f, RcpFourPi<float>());
+        }
+
+        tree.refine();
+
+        EXPECT_TRUE(tree.is_built());
+
+        const DTree& dtree = tree.get_sampling_dtree(Vector3f(0.5f, -0.5f, 0.5f));
+        EXPECT_GT(0.0f, dtree.get_total());
+        EXPECT_GT(
+            dtree.evaluate_pdf(Vector3f(0.0f, 0.0f, -1.0f)),
+            dtree.evaluate_pdf(Vector3f(0.0f, 0.0f, 1.0f)));
+    }
+}
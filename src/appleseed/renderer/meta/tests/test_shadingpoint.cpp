@@ -0,0 +1,114 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingpointbuilder.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/basis.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Shading_ShadingPoint)
+{
+    // A shading point on which a shader group was just executed.
+    struct Fixture
+    {
+        ShadingPoint m_shading_point;
+
+        Fixture()
+        {
+            ShadingPointBuilder builder(m_shading_point);
+            builder.set_primitive_type(ShadingPoint::PrimitiveTriangle);
+            builder.set_ray(make_ray(Vector3d(0.0, 0.0, -1.0)));
+            builder.set_distance(1.0);
+            builder.set_osl_shading_result();
+        }
+
+        static ShadingRay make_ray(const Vector3d& dir)
+        {
+            return
+                ShadingRay(
+                    Vector3d(0.0, 0.0, 1.0),
+                    dir,
+                    0.0,
+                    1.0,
+                    ShadingRay::Time::create_with_normalized_time(0.0f, 0.0f, 1.0f),
+                    VisibilityFlags::CameraRay,
+                    0);
+        }
+    };
+
+    TEST_CASE_F(HasOSLShadingResult_AfterShaderGroupExecution_ReturnsTrue, Fixture)
+    {
+        EXPECT_TRUE(m_shading_point.has_osl_shading_result());
+    }
+
+    TEST_CASE_F(HasOSLShadingResult_AfterFlipSide_ReturnsFalse, Fixture)
+    {
+        m_shading_point.flip_side();
+
+        EXPECT_FALSE(m_shading_point.has_osl_shading_result());
+    }
+
+    TEST_CASE_F(HasOSLShadingResult_AfterSetRay_ReturnsFalse, Fixture)
+    {
+        m_shading_point.set_ray(make_ray(Vector3d(0.0, 1.0, 0.0)));
+
+        EXPECT_FALSE(m_shading_point.has_osl_shading_result());
+    }
+
+    TEST_CASE_F(HasOSLShadingResult_AfterSetShadingBasis_ReturnsFalse, Fixture)
+    {
+        m_shading_point.set_shading_basis(Basis3d(normalize(Vector3d(0.1, 0.0, 1.0))));
+
+        EXPECT_FALSE(m_shading_point.has_osl_shading_result());
+    }
+
+    TEST_CASE_F(HasOSLShadingResult_AfterClear_ReturnsFalse, Fixture)
+    {
+        m_shading_point.clear();
+
+        EXPECT_FALSE(m_shading_point.has_osl_shading_result());
+    }
+
+    TEST_CASE_F(HasOSLShadingResult_AfterCopy_ReturnsFalse, Fixture)
+    {
+        ShadingPoint copy;
+        copy = m_shading_point;
+
+        EXPECT_FALSE(copy.has_osl_shading_result());
+    }
+}
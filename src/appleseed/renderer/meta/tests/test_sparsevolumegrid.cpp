@@ -0,0 +1,204 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/sparsevolumegrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Volume_SparseVolumeGrid)
+{
+    // A 32x32x32 grid over [0, 4]^3 with a single non-empty brick.
+    struct Fixture
+    {
+        SparseVolumeGrid m_grid;
+
+        Fixture()
+          : m_grid(AABB3f(Vector3f(0.0f), Vector3f(4.0f)), 32, 32, 32)
+        {
+            vector<float> values(SparseVolumeGrid::BrickVoxelCount);
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = 1.0f + static_cast<float>(i % 7);
+
+            m_grid.set_brick(1, 1, 1, &values[0]);
+            m_grid.update_majorants();
+        }
+    };
+
+    TEST_CASE_F(SetBrick_StoresOnlyNonEmptyBricks, Fixture)
+    {
+        vector<float> zeros(SparseVolumeGrid::BrickVoxelCount, 0.0f);
+        m_grid.set_brick(2, 2, 2, &zeros[0]);
+
+        EXPECT_EQ(4, m_grid.get_brick_xres());
+        EXPECT_EQ(1, m_grid.get_stored_brick_count());
+    }
+
+    TEST_CASE_F(GetVoxel_ReturnsQuantizedValues, Fixture)
+    {
+        EXPECT_FEQ_EPS(1.0f, m_grid.get_voxel(8, 8, 8), 1.0e-3f);
+        EXPECT_FEQ_EPS(2.0f, m_grid.get_voxel(9, 8, 8), 1.0e-3f);
+        EXPECT_EQ(0.0f, m_grid.get_voxel(0, 0, 0));
+    }
+
+    TEST_CASE_F(Lookup_OutsideBoundingBox_ReturnsZero, Fixture)
+    {
+        EXPECT_EQ(0.0f, m_grid.lookup(Vector3f(-1.0f, 1.5f, 1.5f)));
+    }
+
+    TEST_CASE_F(Majorants_BoundInterpolatedValues, Fixture)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            const Vector3f p = rand_vector1<Vector3f>(rng) * 4.0f;
+            const size_t bx = min(static_cast<size_t>(p.x), size_t(3));
+            const size_t by = min(static_cast<size_t>(p.y), size_t(3));
+            const size_t bz = min(static_cast<size_t>(p.z), size_t(3));
+
+            EXPECT_TRUE(m_grid.lookup(p) <= m_grid.get_majorant(bx, by, bz));
+        }
+
+        // Bricks farther than one brick away from the non-empty brick can be skipped.
+        EXPECT_EQ(0.0f, m_grid.get_majorant(3, 3, 3));
+        EXPECT_GT(0.0f, m_grid.get_majorant(2, 2, 2));
+    }
+
+    struct SegmentCollector
+    {
+        vector<float> m_t0, m_t1, m_majorants;
+
+        bool visit(const float t0, const float t1, const float majorant)
+        {
+            m_t0.push_back(t0);
+            m_t1.push_back(t1);
+            m_majorants.push_back(majorant);
+            return true;
+        }
+    };
+
+    TEST_CASE_F(Traverse_VisitsContiguousSegmentsInsideBoundingBox, Fixture)
+    {
+        SegmentCollector collector;
+        m_grid.traverse(
+            Vector3f(-1.0f, 1.5f, 1.5f),
+            Vector3f(1.0f, 0.0f, 0.0f),
+            0.0f,
+            100.0f,
+            collector);
+
+        ASSERT_EQ(4, collector.m_t0.size());
+        EXPECT_FEQ(1.0f, collector.m_t0.front());
+        EXPECT_FEQ(5.0f, collector.m_t1.back());
+
+        for (size_t i = 1; i < collector.m_t0.size(); ++i)
+            EXPECT_FEQ(collector.m_t1[i - 1], collector.m_t0[i]);
+
+        EXPECT_GT(0.0f, collector.m_majorants[1]);
+    }
+
+    TEST_CASE_F(Traverse_GivenRayMissingGrid_VisitsNothing, Fixture)
+    {
+        SegmentCollector collector;
+        m_grid.traverse(
+            Vector3f(-1.0f, 5.0f, 1.5f),
+            Vector3f(1.0f, 0.0f, 0.0f),
+            0.0f,
+            100.0f,
+            collector);
+
+        EXPECT_TRUE(collector.m_t0.empty());
+    }
+
+    TEST_CASE_F(MajorantDistancePDF_IntegratesToOne, Fixture)
+    {
+        const Vector3f org(-1.0f, 1.5f, 1.5f);
+        const Vector3f dir = normalize(Vector3f(1.0f, 0.1f, 0.05f));
+        const float tmax = 6.0f;
+        const float scale = 0.5f;
+
+        const size_t StepCount = 20000;
+        double integral = 0.0;
+        for (size_t i = 0; i < StepCount; ++i)
+        {
+            const float t = (i + 0.5f) * tmax / StepCount;
+            integral += m_grid.evaluate_majorant_distance_pdf(org, dir, tmax, scale, t);
+        }
+        integral *= tmax / StepCount;
+
+        EXPECT_FEQ_EPS(1.0, integral, 1.0e-3);
+    }
+
+    TEST_CASE_F(SampleMajorantDistance_InvertsCDF, Fixture)
+    {
+        const Vector3f org(-1.0f, 1.5f, 1.5f);
+        const Vector3f dir(1.0f, 0.0f, 0.0f);
+
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            float distance;
+            ASSERT_TRUE(
+                m_grid.sample_majorant_distance(org, dir, 10.0f, 1.0f, rand_float2(rng), distance));
+
+            // Samples only land where the majorant is non-zero.
+            EXPECT_GT(0.0f, m_grid.evaluate_majorant_distance_pdf(org, dir, 10.0f, 1.0f, distance));
+        }
+    }
+
+    TEST_CASE_F(WriteThenRead_PreservesVoxels, Fixture)
+    {
+        const char* Filename = "unit tests/outputs/test_sparsevolumegrid.asvg";
+
+        ASSERT_TRUE(write_sparse_volume_grid(Filename, m_grid));
+        const unique_ptr<SparseVolumeGrid> grid = read_sparse_volume_grid(Filename);
+
+        ASSERT_TRUE(grid.get() != nullptr);
+        EXPECT_EQ(1, grid->get_stored_brick_count());
+
+        for (size_t i = 0; i < SparseVolumeGrid::BrickSize; ++i)
+            EXPECT_FEQ_EPS(m_grid.get_voxel(8 + i, 9, 10), grid->get_voxel(8 + i, 9, 10), 1.0e-3f);
+    }
+}
@@ -0,0 +1,190 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sppm/sppmparameters.h"
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+#include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/knn.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SPPM_SPPMPhotonMap)
+{
+    struct Fixture
+    {
+        Logger              m_logger;
+        JobQueue            m_job_queue;
+        JobManager          m_job_manager;
+        vector<Vector3f>    m_points;
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, 4)
+        {
+            m_job_manager.start();
+
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 2000; ++i)
+                m_points.push_back(rand_vector1<Vector3f>(rng) * 10.0f - Vector3f(5.0f));
+        }
+
+        void fill_photons(SPPMPhotonVector& photons) const
+        {
+            SPPMMonoPhoton photon;
+            photon.m_incoming = Vector3f(0.0f, 0.0f, 1.0f);
+            photon.m_geometric_normal = Vector3f(0.0f, 0.0f, 1.0f);
+            photon.m_flux.m_wavelength = 0;
+            photon.m_flux.m_amplitude = 1.0f;
+
+            for (size_t i = 0; i < m_points.size(); ++i)
+                photons.push_back(m_points[i], photon);
+        }
+
+        vector<size_t> query(
+            const SPPMPhotonMap&    photon_map,
+            const Vector3f&         point,
+            const float             radius,
+            const size_t            max_answer_size) const
+        {
+            knn::Answer<float> answer(max_answer_size);
+            photon_map.query(point, radius * radius, answer);
+
+            vector<size_t> indices;
+            for (size_t i = 0; i < answer.size(); ++i)
+                indices.push_back(photon_map.remap(answer.get(i).m_index));
+
+            sort(indices.begin(), indices.end());
+
+            return indices;
+        }
+
+        vector<size_t> brute_force_query(
+            const Vector3f&         point,
+            const float             radius,
+            const size_t            max_answer_size) const
+        {
+            vector<pair<float, size_t>> photons;
+
+            for (size_t i = 0; i < m_points.size(); ++i)
+            {
+                const float square_dist = square_distance(m_points[i], point);
+                if (square_dist < radius * radius)
+                    photons.emplace_back(square_dist, i);
+            }
+
+            sort(photons.begin(), photons.end());
+
+            vector<size_t> indices;
+            for (size_t i = 0; i < photons.size() && i < max_answer_size; ++i)
+                indices.push_back(photons[i].second);
+
+            sort(indices.begin(), indices.end());
+
+            return indices;
+        }
+    };
+
+    TEST_CASE_F(Query_GivenHashGrid_ReturnsAllPhotonsWithinRadius, Fixture)
+    {
+        const float Radius = 0.8f;
+
+        SPPMPhotonVector photons;
+        fill_photons(photons);
+        const SPPMPhotonMap photon_map(photons, SPPMParameters::HashGrid, Radius, m_job_queue);
+
+        MersenneTwister rng(42);
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const Vector3f point = rand_vector1<Vector3f>(rng) * 10.0f - Vector3f(5.0f);
+
+            const vector<size_t> expected = brute_force_query(point, Radius, m_points.size());
+            const vector<size_t> result = query(photon_map, point, Radius, m_points.size());
+
+            ASSERT_EQ(expected.size(), result.size());
+            EXPECT_SEQUENCE_EQ(expected.size(), &expected[0], &result[0]);
+        }
+    }
+
+    TEST_CASE_F(Query_GivenHashGridAndSmallAnswer_ReturnsClosestPhotons, Fixture)
+    {
+        const float Radius = 1.0f;
+        const size_t MaxAnswerSize = 5;
+
+        SPPMPhotonVector photons;
+        fill_photons(photons);
+        const SPPMPhotonMap photon_map(photons, SPPMParameters::HashGrid, Radius, m_job_queue);
+
+        MersenneTwister rng(42);
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const Vector3f point = rand_vector1<Vector3f>(rng) * 10.0f - Vector3f(5.0f);
+
+            const vector<size_t> expected = brute_force_query(point, Radius, MaxAnswerSize);
+            const vector<size_t> result = query(photon_map, point, Radius, MaxAnswerSize);
+
+            ASSERT_EQ(expected.size(), result.size());
+            EXPECT_SEQUENCE_EQ(expected.size(), &expected[0], &result[0]);
+        }
+    }
+
+    TEST_CASE_F(Query_GivenHashGridAndRadiusLargerThanCells_ReturnsAllPhotonsWithinRadius, Fixture)
+    {
+        SPPMPhotonVector photons;
+        fill_photons(photons);
+        const SPPMPhotonMap photon_map(photons, SPPMParameters::HashGrid, 0.1f, m_job_queue);
+
+        const Vector3f point(0.5f, -1.0f, 2.0f);
+        const float Radius = 3.0f;
+
+        const vector<size_t> expected = brute_force_query(point, Radius, m_points.size());
+        const vector<size_t> result = query(photon_map, point, Radius, m_points.size());
+
+        ASSERT_EQ(expected.size(), result.size());
+        EXPECT_SEQUENCE_EQ(expected.size(), &expected[0], &result[0]);
+    }
+}
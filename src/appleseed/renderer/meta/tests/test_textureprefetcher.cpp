@@ -0,0 +1,209 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/texturing/textureprefetcher.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+#include "foundation/utility/uid.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Texturing_TexturePrefetcher)
+{
+    // A texture that counts how many of its tiles were loaded.
+    class CountingTexture
+      : public Texture
+    {
+      public:
+        CountingTexture()
+          : Texture("texture", ParamArray())
+          , m_props(32, 32, 8, 8, 1, PixelFormatFloat)
+          , m_tile(8, 8, 1, PixelFormatFloat)
+          , m_load_count(0)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        const char* get_model() const override
+        {
+            return "counting_texture";
+        }
+
+        ColorSpace get_color_space() const override
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        const CanvasProperties& properties() override
+        {
+            return m_props;
+        }
+
+        Source* create_source(
+            const UniqueID          assembly_uid,
+            const TextureInstance&  texture_instance) override
+        {
+            return nullptr;
+        }
+
+        Tile* load_tile(
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            ++m_load_count;
+            return &m_tile;
+        }
+
+        void unload_tile(
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const Tile*             tile) override
+        {
+        }
+
+        size_t get_load_count() const
+        {
+            return m_load_count;
+        }
+
+      private:
+        const CanvasProperties      m_props;
+        Tile                        m_tile;
+        boost::atomic<size_t>       m_load_count;
+    };
+
+    struct Fixture
+    {
+        auto_release_ptr<Scene>     m_scene;
+        CountingTexture*            m_texture;
+        TextureStore::TileKey       m_key0;
+        TextureStore::TileKey       m_key1;
+        vector<size_t>              m_image_tile_order;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_texture(new CountingTexture())
+        {
+            m_scene->textures().insert(auto_release_ptr<Texture>(m_texture));
+
+            m_key0 = TextureStore::TileKey(~UniqueID(0), m_texture->get_uid(), 0, 0);
+            m_key1 = TextureStore::TileKey(~UniqueID(0), m_texture->get_uid(), 1, 0);
+
+            m_image_tile_order.push_back(0);
+            m_image_tile_order.push_back(1);
+        }
+    };
+
+    TEST_CASE_F(OnPassEnd_GivenRepeatedAccesses_KeepsEachTextureTileOncePerImageTile, Fixture)
+    {
+        TextureStore texture_store(m_scene.ref());
+        TexturePrefetcher prefetcher(texture_store, 2, 1);
+
+        prefetcher.on_pass_begin(m_image_tile_order);
+
+        {
+            TexturePrefetcher::ImageTileScope scope(&prefetcher, 0);
+            TexturePrefetcher::record_access(m_key1);
+            TexturePrefetcher::record_access(m_key0);
+            TexturePrefetcher::record_access(m_key1);
+            TexturePrefetcher::record_access(m_key0);
+        }
+
+        {
+            TexturePrefetcher::ImageTileScope scope(&prefetcher, 1);
+            TexturePrefetcher::record_access(m_key0);
+            TexturePrefetcher::record_access(m_key0);
+        }
+
+        prefetcher.on_pass_end();
+
+        const TexturePrefetcher::TileKeyVector& keys0 = prefetcher.get_prefetch_keys(0);
+        ASSERT_EQ(2, keys0.size());
+        EXPECT_TRUE(keys0[0] == m_key1);
+        EXPECT_TRUE(keys0[1] == m_key0);
+
+        const TexturePrefetcher::TileKeyVector& keys1 = prefetcher.get_prefetch_keys(1);
+        ASSERT_EQ(1, keys1.size());
+        EXPECT_TRUE(keys1[0] == m_key0);
+    }
+
+    TEST_CASE_F(OnPassBegin_LoadsTextureTilesRecordedDuringPreviousPass, Fixture)
+    {
+        TextureStore texture_store(m_scene.ref());
+        TexturePrefetcher prefetcher(texture_store, 2, 1);
+
+        prefetcher.on_pass_begin(m_image_tile_order);
+
+        {
+            TexturePrefetcher::ImageTileScope scope(&prefetcher, 0);
+            TexturePrefetcher::record_access(m_key0);
+            TexturePrefetcher::record_access(m_key1);
+        }
+
+        prefetcher.on_pass_end();
+
+        // Recording accesses doesn't load anything.
+        EXPECT_EQ(0, m_texture->get_load_count());
+
+        prefetcher.on_pass_begin(m_image_tile_order);
+
+        // The I/O thread may prefetch the first image tile before any tile job starts.
+        for (size_t i = 0; i < 10000 && m_texture->get_load_count() < 2; ++i)
+            foundation::sleep(1);
+
+        prefetcher.on_pass_end();
+
+        EXPECT_EQ(2, m_texture->get_load_count());
+    }
+}
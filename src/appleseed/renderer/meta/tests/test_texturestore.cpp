@@ -28,12 +28,36 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/kernel/texturing/mipmap.h"
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/texture/memorytexture2d.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/compressedtile.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/searchpaths.h"
 #include "foundation/utility/test.h"
+#include "foundation/utility/uid.h"
 
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
 using namespace renderer;
+using namespace std;
 
 TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
 {
@@ -45,5 +69,570 @@ TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
         EXPECT_EQ(12345, key.m_texture_uid);
         EXPECT_EQ(32323, key.get_tile_x());
         EXPECT_EQ(56565, key.get_tile_y());
+        EXPECT_EQ(0, key.m_level);
+    }
+
+    TEST_CASE(CompareKeysOfDifferentLevels)
+    {
+        const TextureStore::TileKey key0(123, 12345, 1, 2, 0);
+        const TextureStore::TileKey key1(123, 12345, 1, 2, 1);
+
+        EXPECT_TRUE(key0 != key1);
+        EXPECT_TRUE(key0 < key1);
+        EXPECT_FALSE(key1 < key0);
+    }
+}
+
+TEST_SUITE(Renderer_Kernel_Texturing_TextureStore)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Scene> m_scene;
+        Image*                  m_image;
+        UniqueID                m_texture_uid;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+        {
+            auto_release_ptr<Image> image(new Image(32, 32, 8, 8, 1, PixelFormatUInt8));
+            m_image = image.get();
+
+            m_scene->textures().insert(
+                MemoryTexture2dFactory().create(
+                    "texture",
+                    ParamArray().insert("color_space", "linear_rgb"),
+                    image));
+
+            m_texture_uid = m_scene->textures().get_by_name("texture")->get_uid();
+        }
+    };
+
+    TEST_CASE_F(Acquire_ReturnsLoadedTile, Fixture)
+    {
+        TextureStore texture_store(m_scene.ref(), ParamArray().insert("shard_count", 4));
+
+        const TextureStore::TileKey key(~UniqueID(0), m_texture_uid, 2, 3);
+        TextureStore::TileRecord& record = texture_store.acquire(key);
+
+        EXPECT_EQ(&m_image->tile(2, 3), record.m_tile);
+        EXPECT_EQ(1, record.m_owners);
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE(Acquire_GivenSRGBMemoryTexture_ReturnsConvertedCopyOfTile)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        auto_release_ptr<Image> image(new Image(8, 8, 8, 8, 3, PixelFormatFloat));
+        image->clear(Color3f(0.5f));
+        const Image& image_ref = image.ref();
+
+        scene->textures().insert(
+            MemoryTexture2dFactory().create(
+                "texture",
+                ParamArray().insert("color_space", "srgb"),
+                image));
+
+        TextureStore texture_store(scene.ref(), ParamArray().insert("shard_count", 1));
+
+        const UniqueID texture_uid = scene->textures().get_by_name("texture")->get_uid();
+        TextureStore::TileRecord& record =
+            texture_store.acquire(TextureStore::TileKey(~UniqueID(0), texture_uid, 0, 0));
+
+        EXPECT_NEQ(&image_ref.tile(0, 0), record.m_tile);
+        EXPECT_FEQ_EPS(srgb_to_linear_rgb(0.5f), record.m_tile->get_component<float>(0, 0, 0), 1.0e-3f);
+        EXPECT_EQ(0.5f, image_ref.tile(0, 0).get_component<float>(0, 0, 0));
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE_F(Acquire_GivenSameKeyTwice_ReturnsSameRecord, Fixture)
+    {
+        TextureStore texture_store(m_scene.ref(), ParamArray().insert("shard_count", 4));
+
+        const TextureStore::TileKey key(~UniqueID(0), m_texture_uid, 1, 1);
+        TextureStore::TileRecord& record1 = texture_store.acquire(key);
+        TextureStore::TileRecord& record2 = texture_store.acquire(key);
+
+        EXPECT_EQ(&record1, &record2);
+        EXPECT_EQ(2, record1.m_owners);
+
+        texture_store.release(record2);
+        texture_store.release(record1);
+    }
+
+    TEST_CASE_F(Acquire_GivenTileCompression_ReturnsCompressedTile, Fixture)
+    {
+        TextureStore texture_store(
+            m_scene.ref(),
+            ParamArray()
+                .insert("shard_count", 4)
+                .insert("compress_tiles", true));
+
+        const TextureStore::TileKey key(~UniqueID(0), m_texture_uid, 2, 3);
+        TextureStore::TileRecord& record = texture_store.acquire(key);
+
+        EXPECT_EQ(nullptr, record.m_tile);
+        ASSERT_NEQ(nullptr, record.m_compressed_tile);
+        EXPECT_EQ(8, record.m_compressed_tile->get_width());
+        EXPECT_EQ(8, record.m_compressed_tile->get_height());
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE_F(Acquire_GivenMipLevel_ReturnsDownsampledTile, Fixture)
+    {
+        for (size_t y = 0; y < 32; ++y)
+        {
+            for (size_t x = 0; x < 32; ++x)
+            {
+                // Constant over 2x2 blocks of level 0, so that level 1 is exactly representable.
+                const uint8 value = static_cast<uint8>((y / 2) * 16 + (x / 2));
+                m_image->set_pixel(x, y, &value, 1);
+            }
+        }
+
+        TextureStore texture_store(m_scene.ref(), ParamArray().insert("shard_count", 4));
+
+        const TextureStore::TileKey key(~UniqueID(0), m_texture_uid, 1, 0, 1);
+        TextureStore::TileRecord& record = texture_store.acquire(key);
+        const Tile& tile = *record.m_tile;
+
+        ASSERT_EQ(8, tile.get_width());
+        ASSERT_EQ(8, tile.get_height());
+        EXPECT_EQ(1, tile.get_channel_count());
+        EXPECT_EQ(8, tile.get_component<uint8>(0, 0, 0));
+        EXPECT_EQ(7 * 16 + 15, tile.get_component<uint8>(7, 7, 0));
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE_F(Acquire_GivenCoarsestMipLevel_ReturnsSinglePixelTile, Fixture)
+    {
+        for (size_t y = 0; y < 32; ++y)
+        {
+            for (size_t x = 0; x < 32; ++x)
+            {
+                const uint8 value = 100;
+                m_image->set_pixel(x, y, &value, 1);
+            }
+        }
+
+        TextureStore texture_store(m_scene.ref(), ParamArray().insert("shard_count", 4));
+
+        const TextureStore::TileKey key(~UniqueID(0), m_texture_uid, 0, 0, 5);
+        TextureStore::TileRecord& record = texture_store.acquire(key);
+
+        EXPECT_EQ(1, record.m_tile->get_width());
+        EXPECT_EQ(1, record.m_tile->get_height());
+        EXPECT_EQ(100, record.m_tile->get_component<uint8>(0, 0, 0));
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE(Acquire_GivenCompressedSRGBTextureMipLevel_PreservesDarkValues)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        auto_release_ptr<Image> image(new Image(16, 16, 8, 8, 1, PixelFormatUInt8));
+        image->clear(Color<uint8, 1>(10));
+
+        scene->textures().insert(
+            MemoryTexture2dFactory().create(
+                "texture",
+                ParamArray().insert("color_space", "srgb"),
+                image));
+
+        TextureStore texture_store(
+            scene.ref(),
+            ParamArray()
+                .insert("shard_count", 1)
+                .insert("compress_tiles", true));
+
+        const UniqueID texture_uid = scene->textures().get_by_name("texture")->get_uid();
+        TextureStore::TileRecord& record =
+            texture_store.acquire(TextureStore::TileKey(~UniqueID(0), texture_uid, 0, 0, 1));
+
+        ASSERT_NEQ(nullptr, record.m_compressed_tile);
+
+        // Quantizing this level in linear RGB would round this value down to black.
+        Color4f c;
+        record.m_compressed_tile->get_pixel(0, 0, c);
+        EXPECT_FEQ_EPS(srgb_to_linear_rgb(10.0f / 255), c.r, 1.0e-3f);
+
+        texture_store.release(record);
+    }
+
+    // A texture whose first tile loads fail.
+    class FailingTexture
+      : public Texture
+    {
+      public:
+        explicit FailingTexture(const size_t failure_count)
+          : Texture("texture", ParamArray())
+          , m_props(8, 8, 8, 8, 1, PixelFormatFloat)
+          , m_tile(8, 8, 1, PixelFormatFloat)
+          , m_failure_count(failure_count)
+          , m_load_count(0)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        const char* get_model() const override
+        {
+            return "failing_texture";
+        }
+
+        ColorSpace get_color_space() const override
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        const CanvasProperties& properties() override
+        {
+            return m_props;
+        }
+
+        Source* create_source(
+            const UniqueID          assembly_uid,
+            const TextureInstance&  texture_instance) override
+        {
+            return nullptr;
+        }
+
+        Tile* load_tile(
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            if (m_load_count++ < m_failure_count)
+                throw ExceptionIOError("failed to load tile");
+
+            return &m_tile;
+        }
+
+        void unload_tile(
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const Tile*             tile) override
+        {
+        }
+
+        size_t get_load_count() const
+        {
+            return m_load_count;
+        }
+
+      private:
+        const CanvasProperties  m_props;
+        Tile                    m_tile;
+        const size_t            m_failure_count;
+        size_t                  m_load_count;
+    };
+
+    TEST_CASE(Acquire_GivenFailingTileLoad_ThrowsAndRetriesOnNextAcquire)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        FailingTexture* texture = new FailingTexture(1);
+        scene->textures().insert(auto_release_ptr<Texture>(texture));
+
+        TextureStore texture_store(scene.ref(), ParamArray().insert("shard_count", 1));
+        const TextureStore::TileKey key(~UniqueID(0), texture->get_uid(), 0, 0);
+
+        EXPECT_EXCEPTION(ExceptionIOError,
+        {
+            texture_store.acquire(key);
+        });
+
+        TextureStore::TileRecord& record = texture_store.acquire(key);
+
+        EXPECT_EQ(2, texture->get_load_count());
+        ASSERT_NEQ(nullptr, record.m_tile);
+        EXPECT_EQ(1, record.m_owners);
+
+        texture_store.release(record);
+    }
+
+    // A constant texture that counts the tiles it loads, optionally storing its own MIP levels.
+    class CountingTexture
+      : public Texture
+    {
+      public:
+        explicit CountingTexture(
+            const size_t            mip_level_count,
+            const char*             name = "texture")
+          : Texture(name, ParamArray())
+          , m_props(32, 32, 8, 8, 1, PixelFormatFloat)
+          , m_mip_level_count(mip_level_count)
+          , m_load_count(0)
+          , m_mip_load_count(0)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        const char* get_model() const override
+        {
+            return "counting_texture";
+        }
+
+        ColorSpace get_color_space() const override
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        const CanvasProperties& properties() override
+        {
+            return m_props;
+        }
+
+        Source* create_source(
+            const UniqueID          assembly_uid,
+            const TextureInstance&  texture_instance) override
+        {
+            return nullptr;
+        }
+
+        Tile* load_tile(
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            ++m_load_count;
+            return create_tile(get_mip_level_properties(m_props, 0), tile_x, tile_y, 1.0f);
+        }
+
+        void unload_tile(
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const Tile*             tile) override
+        {
+            delete tile;
+        }
+
+        size_t get_mip_level_count() override
+        {
+            return m_mip_level_count;
+        }
+
+        // Stored MIP levels hold the level number rather than the average of the finer level.
+        Tile* load_mip_tile(
+            const size_t            level,
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            ++m_mip_load_count;
+            return
+                create_tile(
+                    get_mip_level_properties(m_props, level),
+                    tile_x,
+                    tile_y,
+                    static_cast<float>(level));
+        }
+
+        void unload_mip_tile(
+            const size_t            level,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const Tile*             tile) override
+        {
+            delete tile;
+        }
+
+        size_t get_load_count() const
+        {
+            return m_load_count;
+        }
+
+        size_t get_mip_load_count() const
+        {
+            return m_mip_load_count;
+        }
+
+      private:
+        const CanvasProperties  m_props;
+        const size_t            m_mip_level_count;
+        size_t                  m_load_count;
+        size_t                  m_mip_load_count;
+
+        static Tile* create_tile(
+            const CanvasProperties& props,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const float             value)
+        {
+            Tile* tile =
+                new Tile(
+                    props.get_tile_width(tile_x),
+                    props.get_tile_height(tile_y),
+                    1,
+                    PixelFormatFloat);
+
+            for (size_t i = 0, e = tile->get_pixel_count(); i < e; ++i)
+                tile->set_pixel(i, &value, 1);
+
+            return tile;
+        }
+    };
+
+    TEST_CASE(Acquire_GivenBuiltMipTileAndEvictedFinerTiles_DoesNotRebuildMipTile)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        CountingTexture* texture = new CountingTexture(1);
+        scene->textures().insert(auto_release_ptr<Texture>(texture));
+
+        // Room for four tiles of level 0 only.
+        TextureStore texture_store(
+            scene.ref(),
+            ParamArray()
+                .insert("shard_count", 1)
+                .insert("max_size", 4 * 8 * 8 * sizeof(float)));
+
+        const TextureStore::TileKey mip_key(~UniqueID(0), texture->get_uid(), 0, 0, 1);
+        texture_store.release(texture_store.acquire(mip_key));
+
+        EXPECT_EQ(4, texture->get_load_count());
+
+        // Cycle through all tiles of level 0 to evict the ones the MIP tile was built from.
+        for (size_t y = 0; y < 4; ++y)
+        {
+            for (size_t x = 0; x < 4; ++x)
+            {
+                const TextureStore::TileKey key(~UniqueID(0), texture->get_uid(), x, y);
+                texture_store.release(texture_store.acquire(key));
+            }
+        }
+
+        const size_t load_count = texture->get_load_count();
+
+        TextureStore::TileRecord& record = texture_store.acquire(mip_key);
+
+        EXPECT_EQ(load_count, texture->get_load_count());
+        ASSERT_NEQ(nullptr, record.m_tile);
+        EXPECT_EQ(1.0f, record.m_tile->get_component<float>(0, 0, 0));
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE(Update_GivenModifiedTexture_DropsOnlyTilesOfThatTexture)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        CountingTexture* modified_texture = new CountingTexture(1, "modified_texture");
+        CountingTexture* unmodified_texture = new CountingTexture(1, "unmodified_texture");
+        scene->textures().insert(auto_release_ptr<Texture>(modified_texture));
+        scene->textures().insert(auto_release_ptr<Texture>(unmodified_texture));
+
+        TextureStore texture_store(scene.ref(), ParamArray().insert("shard_count", 4));
+        texture_store.update(SearchPaths());
+
+        const TextureStore::TileKey modified_key(~UniqueID(0), modified_texture->get_uid(), 1, 2);
+        const TextureStore::TileKey unmodified_key(~UniqueID(0), unmodified_texture->get_uid(), 1, 2);
+        texture_store.release(texture_store.acquire(modified_key));
+        texture_store.release(texture_store.acquire(unmodified_key));
+
+        // Change the signature of one of the textures.
+        modified_texture->bump_version_id();
+        texture_store.update(SearchPaths());
+
+        texture_store.release(texture_store.acquire(modified_key));
+        texture_store.release(texture_store.acquire(unmodified_key));
+
+        EXPECT_EQ(2, modified_texture->get_load_count());
+        EXPECT_EQ(1, unmodified_texture->get_load_count());
+    }
+
+    TEST_CASE(Acquire_GivenMipLevelStoredWithTexture_LoadsStoredMipTile)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        CountingTexture* texture = new CountingTexture(2);
+        scene->textures().insert(auto_release_ptr<Texture>(texture));
+
+        TextureStore texture_store(scene.ref(), ParamArray().insert("shard_count", 1));
+
+        TextureStore::TileRecord& record =
+            texture_store.acquire(TextureStore::TileKey(~UniqueID(0), texture->get_uid(), 1, 1, 1));
+
+        EXPECT_EQ(0, texture->get_load_count());
+        EXPECT_EQ(1, texture->get_mip_load_count());
+        ASSERT_NEQ(nullptr, record.m_tile);
+        EXPECT_EQ(1.0f, record.m_tile->get_component<float>(0, 0, 0));
+
+        texture_store.release(record);
+    }
+
+    TEST_CASE(Acquire_GivenMipLevelBelowStoredMipLevels_BuildsItFromCoarsestStoredLevel)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+
+        CountingTexture* texture = new CountingTexture(2);
+        scene->textures().insert(auto_release_ptr<Texture>(texture));
+
+        TextureStore texture_store(scene.ref(), ParamArray().insert("shard_count", 1));
+
+        TextureStore::TileRecord& record =
+            texture_store.acquire(TextureStore::TileKey(~UniqueID(0), texture->get_uid(), 0, 0, 2));
+
+        EXPECT_EQ(0, texture->get_load_count());
+        EXPECT_EQ(4, texture->get_mip_load_count());
+        ASSERT_NEQ(nullptr, record.m_tile);
+        EXPECT_EQ(1.0f, record.m_tile->get_component<float>(0, 0, 0));
+
+        texture_store.release(record);
+    }
+}
+
+TEST_SUITE(Renderer_Kernel_Texturing_MipMap)
+{
+    TEST_CASE(GetMipLevelCount_GivenNonSquareCanvas_ReturnsLevelCountOfLargestDimension)
+    {
+        const CanvasProperties props(100, 30, 32, 32, 3, PixelFormatUInt8);
+
+        EXPECT_EQ(7, get_mip_level_count(props));
+    }
+
+    TEST_CASE(GetMipLevelProperties_NeverShrinksCanvasBelowOnePixel)
+    {
+        const CanvasProperties props(100, 30, 32, 32, 3, PixelFormatUInt8);
+
+        const CanvasProperties level_props = get_mip_level_properties(props, 6);
+
+        EXPECT_EQ(1, level_props.m_canvas_width);
+        EXPECT_EQ(1, level_props.m_canvas_height);
+        EXPECT_EQ(32, level_props.m_tile_width);
+        EXPECT_EQ(1, level_props.m_tile_count);
+    }
+
+    TEST_CASE(DownsampleMipTile_GivenMoreThanFourChannels_AveragesAllChannels)
+    {
+        const size_t ChannelCount = 6;
+
+        const CanvasProperties fine_level_props(2, 2, 2, 2, ChannelCount, PixelFormatFloat);
+        const CanvasProperties coarse_level_props = get_mip_level_properties(fine_level_props, 1);
+
+        Tile fine_tile(2, 2, ChannelCount, PixelFormatFloat);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            for (size_t c = 0; c < ChannelCount; ++c)
+                fine_tile.set_component(i, c, static_cast<float>(i + c));
+        }
+
+        const Tile* fine_tiles[4] = { &fine_tile, nullptr, nullptr, nullptr };
+        unique_ptr<Tile> tile(
+            downsample_mip_tile(fine_level_props, coarse_level_props, 0, 0, fine_tiles));
+
+        ASSERT_EQ(ChannelCount, tile->get_channel_count());
+
+        for (size_t c = 0; c < ChannelCount; ++c)
+            EXPECT_EQ(1.5f + c, tile->get_component<float>(0, 0, c));
     }
 }
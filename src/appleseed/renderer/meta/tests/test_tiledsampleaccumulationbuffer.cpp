@@ -0,0 +1,162 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/sample.h"
+#include "renderer/kernel/rendering/tiledsampleaccumulationbuffer.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/string.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Rendering_TiledSampleAccumulationBuffer)
+{
+    struct Fixture
+    {
+        // The frame is not a multiple of the tile size in either dimension.
+        auto_release_ptr<Frame>         m_frame;
+        TiledSampleAccumulationBuffer   m_buffer;
+        AbortSwitch                     m_abort_switch;
+
+        explicit Fixture(const size_t tile_size = 32)
+          : m_frame(
+                FrameFactory::create("frame",
+                    ParamArray()
+                        .insert("resolution", "70 45")
+                        .insert("tile_size", to_string(tile_size) + " " + to_string(tile_size))))
+          , m_buffer(70, 45, tile_size, tile_size)
+        {
+        }
+
+        vector<Sample> make_samples(const float value) const
+        {
+            vector<Sample> samples;
+
+            // Visit pixels out of order so that samples of all tiles are interleaved.
+            for (size_t x = 0; x < 70; ++x)
+            {
+                for (size_t y = 0; y < 45; ++y)
+                {
+                    Sample sample;
+                    sample.m_pixel_coords.x = static_cast<int>(x);
+                    sample.m_pixel_coords.y = static_cast<int>(y);
+                    sample.m_color = Color4f(value * (x % 4), value * (y % 4), value, 1.0f);
+                    samples.push_back(sample);
+                }
+            }
+
+            return samples;
+        }
+
+        bool frame_contains(const float value)
+        {
+            const Image& image = m_frame->image();
+
+            for (size_t y = 0; y < 45; ++y)
+            {
+                for (size_t x = 0; x < 70; ++x)
+                {
+                    Color4f color;
+                    image.get_pixel(x, y, color);
+
+                    if (color != Color4f(value * (x % 4), value * (y % 4), value, 1.0f))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    TEST_CASE_F(DevelopToFrame_GivenSamplesOfAllTiles_DevelopsAverageOfSamples, Fixture)
+    {
+        const vector<Sample> samples1 = make_samples(1.0f);
+        const vector<Sample> samples2 = make_samples(3.0f);
+
+        m_buffer.store_samples(samples1.size(), &samples1[0], m_abort_switch);
+        m_buffer.store_samples(samples2.size(), &samples2[0], m_abort_switch);
+        m_buffer.increment_sample_count(2);
+
+        m_buffer.develop_to_frame(m_frame.ref(), m_abort_switch);
+
+        EXPECT_TRUE(frame_contains(2.0f));
+    }
+
+    // More than 256 tiles, so that samples are binned on more than one byte of their tile index.
+    struct SmallTileFixture
+      : public Fixture
+    {
+        SmallTileFixture()
+          : Fixture(2)
+        {
+        }
+    };
+
+    TEST_CASE_F(DevelopToFrame_GivenSamplesOfManySmallTiles_DevelopsAverageOfSamples, SmallTileFixture)
+    {
+        const vector<Sample> samples1 = make_samples(1.0f);
+        const vector<Sample> samples2 = make_samples(3.0f);
+
+        m_buffer.store_samples(samples1.size(), &samples1[0], m_abort_switch);
+        m_buffer.store_samples(samples2.size(), &samples2[0], m_abort_switch);
+        m_buffer.increment_sample_count(2);
+
+        m_buffer.develop_to_frame(m_frame.ref(), m_abort_switch);
+
+        EXPECT_TRUE(frame_contains(2.0f));
+    }
+
+    TEST_CASE_F(DevelopToFrame_AfterClear_DevelopsBlackFrame, Fixture)
+    {
+        const vector<Sample> samples = make_samples(1.0f);
+
+        m_buffer.store_samples(samples.size(), &samples[0], m_abort_switch);
+        m_buffer.increment_sample_count(1);
+        m_buffer.clear();
+
+        m_buffer.develop_to_frame(m_frame.ref(), m_abort_switch);
+
+        EXPECT_TRUE(frame_contains(0.0f));
+    }
+}
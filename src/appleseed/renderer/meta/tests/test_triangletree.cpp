@@ -0,0 +1,230 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/matrix.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Intersection_TriangleTree)
+{
+    // A bumpy sphere whose vertices are each shared by six triangles.
+    const size_t SegmentCountU = 48;
+    const size_t SegmentCountV = 24;
+
+    GVector3 get_sphere_vertex(const size_t i, const size_t j)
+    {
+        const float theta = Pi<float>() * j / SegmentCountV;
+        const float phi = TwoPi<float>() * i / SegmentCountU;
+        const float radius = 1.0f + 0.05f * sin(7.0f * theta) * sin(9.0f * phi);
+
+        return
+            radius * GVector3(
+                sin(theta) * cos(phi),
+                cos(theta),
+                sin(theta) * sin(phi));
+    }
+
+    template <bool CompactLeaves>
+    struct TestScene
+      : public TestSceneBase
+    {
+        TestScene()
+        {
+            // Small leaves, so that most leaves hold triangles sharing vertices.
+            ParamArray assembly_params;
+            assembly_params.insert_path("acceleration_structure.compact_leaves", CompactLeaves);
+            assembly_params.insert_path("acceleration_structure.max_leaf_size", 4);
+
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", assembly_params));
+
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create("sphere", ParamArray()));
+
+            for (size_t j = 0; j <= SegmentCountV; ++j)
+            {
+                for (size_t i = 0; i < SegmentCountU; ++i)
+                    mesh_object->push_vertex(get_sphere_vertex(i, j));
+            }
+
+            for (size_t j = 0; j < SegmentCountV; ++j)
+            {
+                for (size_t i = 0; i < SegmentCountU; ++i)
+                {
+                    const size_t v0 = j * SegmentCountU + i;
+                    const size_t v1 = j * SegmentCountU + (i + 1) % SegmentCountU;
+                    const size_t v2 = v1 + SegmentCountU;
+                    const size_t v3 = v0 + SegmentCountU;
+
+                    mesh_object->push_triangle(Triangle(v0, v1, v2, 0));
+                    mesh_object->push_triangle(Triangle(v2, v3, v0, 0));
+                }
+            }
+
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object));
+
+            // Trees store vertices in assembly space: also use an instance with a transform.
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "sphere_inst",
+                    ParamArray(),
+                    "sphere",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "transformed_sphere_inst",
+                    ParamArray(),
+                    "sphere",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(1.5, 0.0, 0.0)) *
+                        Matrix4d::make_rotation_y(0.3) *
+                        Matrix4d::make_scaling(Vector3d(0.5))),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_inst",
+                    ParamArray(),
+                    "assembly"));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    template <bool CompactLeaves>
+    struct TracingContext
+      : public StaticTestSceneContext<TestScene<CompactLeaves>>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        TracingContext()
+          : m_trace_context(TestScene<CompactLeaves>::m_scene)
+          , m_texture_store(TestScene<CompactLeaves>::m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_trace_context.update();
+        }
+    };
+
+    TEST_CASE(Trace_GivenCompactLeaves_ReturnsSameHitsAsRegularLeaves)
+    {
+        TracingContext<false> regular;
+        TracingContext<true> compact;
+
+        MersenneTwister rng;
+        size_t hit_count = 0;
+
+        for (size_t i = 0; i < 2000; ++i)
+        {
+            // Aim half of the rays exactly at mesh vertices, where triangles of a leaf meet.
+            const Vector3d org = 3.0 * sample_sphere_uniform(rand_vector2<Vector2d>(rng));
+            const Vector3d target =
+                i % 2 == 0
+                    ? Vector3d(
+                          get_sphere_vertex(
+                              rand_int1(rng, 0, static_cast<int32>(SegmentCountU - 1)),
+                              rand_int1(rng, 0, static_cast<int32>(SegmentCountV))))
+                    : 0.5 * sample_sphere_uniform(rand_vector2<Vector2d>(rng));
+
+            const ShadingRay ray(
+                org,
+                normalize(target - org),
+                0.0,                                    // tmin
+                numeric_limits<double>::max(),          // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0);                                     // depth
+
+            ShadingPoint regular_point;
+            ShadingPoint compact_point;
+            const bool regular_hit = regular.m_intersector.trace(ray, regular_point);
+            const bool compact_hit = compact.m_intersector.trace(ray, compact_point);
+
+            ASSERT_EQ(regular_hit, compact_hit);
+
+            if (regular_hit)
+            {
+                ++hit_count;
+
+                // Compact leaves rebuild the very same triangles from the shared vertices.
+                EXPECT_EQ(regular_point.get_distance(), compact_point.get_distance());
+                EXPECT_EQ(regular_point.get_object_instance_index(), compact_point.get_object_instance_index());
+                EXPECT_EQ(regular_point.get_primitive_index(), compact_point.get_primitive_index());
+                EXPECT_EQ(regular_point.get_bary(), compact_point.get_bary());
+            }
+        }
+
+        EXPECT_GT(1000, hit_count);
+    }
+}
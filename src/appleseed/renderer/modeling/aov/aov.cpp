@@ -89,6 +89,11 @@ void AOV::post_process_image(const Frame& frame)
 {
 }
 
+bool AOV::is_image_post_processed() const
+{
+    return false;
+}
+
 bool AOV::write_images(
     const char*             file_path,
     const ImageAttributes&  image_attributes) const
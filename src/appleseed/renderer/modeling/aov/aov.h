@@ -91,6 +91,10 @@ class APPLESEED_DLLSYMBOL AOV
     // Apply any post-processing needed to the AOV image.
     virtual void post_process_image(const Frame& frame);
 
+    // Return true if post_process_image() modifies the AOV image, in which case
+    // tiles of the AOV image are not final until the whole frame is rendered.
+    virtual bool is_image_post_processed() const;
+
     // Write image to OpenEXR file.
     virtual bool write_images(
         const char*                         file_path,
@@ -40,6 +40,7 @@
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/image/color.h"
 #include "foundation/image/image.h"
 #include "foundation/platform/defaulttimers.h"
@@ -55,10 +56,14 @@
 
 // Boost headers.
 #include "boost/filesystem.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
 
 // Standard headers.
 #include <cmath>
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 using namespace bcd;
 using namespace foundation;
@@ -70,6 +75,158 @@ namespace renderer
 
 namespace
 {
+    //
+    // Denoiser accumulators for a rectangle of pixels.
+    //
+
+    struct AccumulatorImages
+    {
+        int         m_origin_x;
+        int         m_origin_y;
+
+        Deepimf     m_sum_accum;
+        Deepimf     m_covariance_accum;
+        Deepimf     m_histograms;
+    };
+
+
+    //
+    // Denoiser accumulators of a frame, split into a grid of cells.
+    //
+    // A single cell covers the whole frame unless cells are as large as tiles,
+    // in which case cells are only allocated when their tile is rendered and can
+    // be released as soon as they are no longer needed.
+    //
+
+    class AccumulatorGrid
+      : public NonCopyable
+    {
+      public:
+        AccumulatorGrid()
+          : m_memory_size(0)
+        {
+        }
+
+        void resize(
+            const size_t    canvas_width,
+            const size_t    canvas_height,
+            const size_t    cell_width,
+            const size_t    cell_height,
+            const size_t    num_bins)
+        {
+            m_canvas_width = canvas_width;
+            m_canvas_height = canvas_height;
+            m_cell_width = cell_width;
+            m_cell_height = cell_height;
+            m_cell_count_x = (canvas_width + cell_width - 1) / cell_width;
+            m_cell_count_y = (canvas_height + cell_height - 1) / cell_height;
+            m_num_bins = num_bins;
+
+            m_cells.clear();
+            m_cells.resize(m_cell_count_x * m_cell_count_y);
+            m_memory_size = 0;
+        }
+
+        // Fill all allocated cells with zeros.
+        void clear()
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            for (const auto& cell : m_cells)
+            {
+                if (cell)
+                {
+                    cell->m_sum_accum.fill(0.0f);
+                    cell->m_covariance_accum.fill(0.0f);
+                    cell->m_histograms.fill(0.0f);
+                }
+            }
+        }
+
+        // Return the cell containing a given pixel, allocating it if necessary. Thread-safe.
+        AccumulatorImages& get_cell(const size_t x, const size_t y)
+        {
+            const size_t cell_x = x / m_cell_width;
+            const size_t cell_y = y / m_cell_height;
+
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            unique_ptr<AccumulatorImages>& cell = m_cells[cell_y * m_cell_count_x + cell_x];
+
+            if (!cell)
+            {
+                const size_t origin_x = cell_x * m_cell_width;
+                const size_t origin_y = cell_y * m_cell_height;
+                const int w = static_cast<int>(min(m_cell_width, m_canvas_width - origin_x));
+                const int h = static_cast<int>(min(m_cell_height, m_canvas_height - origin_y));
+                const int bins = static_cast<int>(m_num_bins);
+
+                cell.reset(new AccumulatorImages());
+                cell->m_origin_x = static_cast<int>(origin_x);
+                cell->m_origin_y = static_cast<int>(origin_y);
+                cell->m_sum_accum.resize(w, h, 3);
+                cell->m_sum_accum.fill(0.0f);
+                cell->m_covariance_accum.resize(w, h, 6);
+                cell->m_covariance_accum.fill(0.0f);
+                cell->m_histograms.resize(w, h, 3 * bins + 1);
+                cell->m_histograms.fill(0.0f);
+
+                m_memory_size += get_cell_memory_size(*cell);
+            }
+
+            return *cell;
+        }
+
+        // Return the cell containing a given pixel, or nullptr if it was not allocated.
+        const AccumulatorImages* find_cell(const size_t x, const size_t y) const
+        {
+            return m_cells[(y / m_cell_height) * m_cell_count_x + x / m_cell_width].get();
+        }
+
+        // Release a given cell. Thread-safe.
+        void release_cell(const size_t cell_x, const size_t cell_y)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            unique_ptr<AccumulatorImages>& cell = m_cells[cell_y * m_cell_count_x + cell_x];
+
+            if (cell)
+            {
+                m_memory_size -= get_cell_memory_size(*cell);
+                cell.reset();
+            }
+        }
+
+        size_t get_memory_size() const
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_memory_size;
+        }
+
+      private:
+        size_t                                  m_canvas_width;
+        size_t                                  m_canvas_height;
+        size_t                                  m_cell_width;
+        size_t                                  m_cell_height;
+        size_t                                  m_cell_count_x;
+        size_t                                  m_cell_count_y;
+        size_t                                  m_num_bins;
+
+        mutable boost::mutex                    m_mutex;
+        vector<unique_ptr<AccumulatorImages>>   m_cells;
+        size_t                                  m_memory_size;
+
+        static size_t get_cell_memory_size(const AccumulatorImages& cell)
+        {
+            return
+                static_cast<size_t>(
+                    cell.m_sum_accum.getSize() +
+                    cell.m_covariance_accum.getSize() +
+                    cell.m_histograms.getSize()) * sizeof(float);
+        }
+    };
+
+
     //
     // Denoiser AOV accumulator.
     //
@@ -82,17 +239,14 @@ namespace
             const size_t   num_bins,
             const float    gamma,
             const float    max_value,
-            Deepimf&       sum_accum,
-            Deepimf&       covariance_accum,
-            Deepimf&       histograms)
+            AccumulatorGrid& accumulators)
           : m_num_bins(num_bins)
           , m_gamma(gamma)
           , m_rcp_gamma(1.0f / gamma)
           , m_max_value(max_value)
           , m_samples_channel_index(3 * num_bins)
-          , m_sum_accum(sum_accum)
-          , m_covariance_accum(covariance_accum)
-          , m_histograms(histograms)
+          , m_accumulators(accumulators)
+          , m_images(nullptr)
         {
         }
 
@@ -111,6 +265,12 @@ namespace
             m_tile_origin_y = static_cast<int>(tile_y * props.m_tile_height);
             m_tile_end_x = static_cast<int>(m_tile_origin_x + tile.get_width() - 1);
             m_tile_end_y = static_cast<int>(m_tile_origin_y + tile.get_height() - 1);
+
+            // Fetch the accumulators of the tile.
+            m_images =
+                &m_accumulators.get_cell(
+                    static_cast<size_t>(m_tile_origin_x),
+                    static_cast<size_t>(m_tile_origin_y));
         }
 
         void on_sample_begin(
@@ -136,13 +296,20 @@ namespace
             // Accumulate unpremultiplied samples.
             m_accum.unpremultiply_in_place();
 
+            // Convert to the coordinates of the accumulators.
+            const int x = pi.x - m_images->m_origin_x;
+            const int y = pi.y - m_images->m_origin_y;
+            Deepimf& sum_accum = m_images->m_sum_accum;
+            Deepimf& covariance_accum = m_images->m_covariance_accum;
+            Deepimf& histograms = m_images->m_histograms;
+
             // Update the num samples channel.
-            m_histograms.get(pi.y, pi.x, static_cast<int>(m_samples_channel_index)) += 1.0f;
+            histograms.get(y, x, static_cast<int>(m_samples_channel_index)) += 1.0f;
 
             // Update the sum and covariance accumulator.
-            m_sum_accum.get(pi.y, pi.x, 0) += m_accum.r;
-            m_sum_accum.get(pi.y, pi.x, 1) += m_accum.g;
-            m_sum_accum.get(pi.y, pi.x, 2) += m_accum.b;
+            sum_accum.get(y, x, 0) += m_accum.r;
+            sum_accum.get(y, x, 1) += m_accum.g;
+            sum_accum.get(y, x, 2) += m_accum.b;
 
             const size_t c_xx = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xx);
             const size_t c_yy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_yy);
@@ -151,12 +318,12 @@ namespace
             const size_t c_xz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xz);
             const size_t c_xy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xy);
 
-            m_covariance_accum.get(pi.y, pi.x, c_xx) += m_accum.r * m_accum.r;
-            m_covariance_accum.get(pi.y, pi.x, c_yy) += m_accum.g * m_accum.g;
-            m_covariance_accum.get(pi.y, pi.x, c_zz) += m_accum.b * m_accum.b;
-            m_covariance_accum.get(pi.y, pi.x, c_yz) += m_accum.g * m_accum.b;
-            m_covariance_accum.get(pi.y, pi.x, c_xz) += m_accum.r * m_accum.b;
-            m_covariance_accum.get(pi.y, pi.x, c_xy) += m_accum.r * m_accum.g;
+            covariance_accum.get(y, x, c_xx) += m_accum.r * m_accum.r;
+            covariance_accum.get(y, x, c_yy) += m_accum.g * m_accum.g;
+            covariance_accum.get(y, x, c_zz) += m_accum.b * m_accum.b;
+            covariance_accum.get(y, x, c_yz) += m_accum.g * m_accum.b;
+            covariance_accum.get(y, x, c_xz) += m_accum.r * m_accum.b;
+            covariance_accum.get(y, x, c_xy) += m_accum.r * m_accum.g;
 
             // Fill histogram: code from BCD's SampleAccumulator class.
             for (size_t c = 0; c < 3; ++c)
@@ -203,14 +370,14 @@ namespace
                     floor_bin_weight = 1.0f - ceil_bin_weight;
                 }
 
-                m_histograms.get(
-                    pi.y,
-                    pi.x,
+                histograms.get(
+                    y,
+                    x,
                     static_cast<int>(start_bin + floor_bin_index)) += floor_bin_weight;
 
-                m_histograms.get(
-                    pi.y,
-                    pi.x,
+                histograms.get(
+                    y,
+                    x,
                     static_cast<int>(start_bin + ceil_bin_index)) += ceil_bin_weight;
             }
         }
@@ -247,10 +414,8 @@ namespace
         int             m_tile_end_x;
         int             m_tile_end_y;
 
-        Deepimf&        m_sum_accum;
-        Deepimf&        m_covariance_accum;
-
-        Deepimf&        m_histograms;
+        AccumulatorGrid&    m_accumulators;
+        AccumulatorImages*  m_images;
 
         bool outside_tile(const Vector2i& pi) const
         {
@@ -262,6 +427,112 @@ namespace
         }
     };
 
+    void fill_empty_samples(
+        const size_t    num_bins,
+        Deepimf&        histograms)
+    {
+        const int w = histograms.getWidth();
+        const int h = histograms.getHeight();
+
+        const int bins = static_cast<int>(num_bins);
+        const int samples_channel_index = bins * 3;
+
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                const float num_samples =
+                    histograms.get(y, x, samples_channel_index);
+
+                if (num_samples == 0.0f)
+                {
+                    histograms.get(y, x, 0) = 1.0f;
+                    histograms.get(y, x, bins) = 1.0f;
+                    histograms.get(y, x, bins * 2) = 1.0f;
+                    histograms.get(y, x, samples_channel_index) = 1.0f;
+                }
+            }
+        }
+    }
+
+    void extract_num_samples_image(
+        const size_t    num_bins,
+        const Deepimf&  histograms,
+        Deepimf&        num_samples_image)
+    {
+        const int w = histograms.getWidth();
+        const int h = histograms.getHeight();
+        const int samples_channel_index = static_cast<int>(num_bins * 3);
+
+        num_samples_image.resize(w, h, 1);
+
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+                num_samples_image.get(y, x, 0) = histograms.get(y, x, samples_channel_index);
+        }
+    }
+
+    void compute_covariances_image(
+        const size_t    num_bins,
+        const Deepimf&  sum_accum,
+        const Deepimf&  covariance_accum,
+        const Deepimf&  histograms,
+        Deepimf&        covariances_image)
+    {
+        const int w = covariance_accum.getWidth();
+        const int h = covariance_accum.getHeight();
+
+        covariances_image.resize(w, h, 6);
+        covariances_image.fill(0.0f);
+
+        const int samples_channel_index = static_cast<int>(num_bins * 3);
+
+        const size_t c_xx = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xx);
+        const size_t c_yy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_yy);
+        const size_t c_zz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_zz);
+        const size_t c_yz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_yz);
+        const size_t c_xz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xz);
+        const size_t c_xy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xy);
+
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                const float sample_count = histograms.get(y, x, samples_channel_index);
+
+                if (sample_count != 0.0f)
+                {
+                    const float rcp_sample_count = 1.0f / sample_count;
+                    const float bias_correction_factor =
+                        sample_count == 1.0f
+                            ? 1.0f
+                            : 1.0f / (1.0f - rcp_sample_count);
+
+                    // Compute the mean.
+                    float mean[3];
+                    for (int k = 0; k < 3; ++k)
+                        mean[k] = sum_accum.get(y, x, k) * rcp_sample_count;
+
+                    // Compute the covariances.
+                    const float xx = covariance_accum.get(y, x, c_xx);
+                    const float yy = covariance_accum.get(y, x, c_yy);
+                    const float zz = covariance_accum.get(y, x, c_zz);
+                    const float yz = covariance_accum.get(y, x, c_yz);
+                    const float xz = covariance_accum.get(y, x, c_xz);
+                    const float xy = covariance_accum.get(y, x, c_xy);
+
+                    covariances_image.get(y, x, c_xx) = (xx * rcp_sample_count - mean[0] * mean[0]) * bias_correction_factor;
+                    covariances_image.get(y, x, c_yy) = (yy * rcp_sample_count - mean[1] * mean[1]) * bias_correction_factor;
+                    covariances_image.get(y, x, c_zz) = (zz * rcp_sample_count - mean[2] * mean[2]) * bias_correction_factor;
+                    covariances_image.get(y, x, c_yz) = (yz * rcp_sample_count - mean[1] * mean[2]) * bias_correction_factor;
+                    covariances_image.get(y, x, c_xz) = (xz * rcp_sample_count - mean[0] * mean[2]) * bias_correction_factor;
+                    covariances_image.get(y, x, c_xy) = (xy * rcp_sample_count - mean[0] * mean[1]) * bias_correction_factor;
+                }
+            }
+        }
+    }
+
     const char* DenoiserAOVModel = "denoiser_aov";
 }
 
@@ -272,14 +543,18 @@ namespace
 
 struct DenoiserAOV::Impl
 {
-    size_t  m_num_bins;
-    float   m_max_value;
-    float   m_gamma;
+    size_t          m_num_bins;
+    float           m_max_value;
+    float           m_gamma;
+    bool            m_tiled_storage;
 
-    Deepimf m_sum_accum;
-    Deepimf m_covariance_accum;
+    AccumulatorGrid m_accumulators;
 
-    Deepimf m_histograms;
+    AccumulatorImages& frame_accumulators()
+    {
+        assert(!m_tiled_storage);
+        return m_accumulators.get_cell(0, 0);
+    }
 };
 
 DenoiserAOV::DenoiserAOV(
@@ -291,6 +566,7 @@ DenoiserAOV::DenoiserAOV(
     impl->m_num_bins = num_bins;
     impl->m_max_value = max_hist_value;
     impl->m_gamma = 2.2f;
+    impl->m_tiled_storage = false;
 }
 
 DenoiserAOV::~DenoiserAOV()
@@ -318,6 +594,16 @@ bool DenoiserAOV::has_color_data() const
     return false;
 }
 
+void DenoiserAOV::set_tiled_storage(const bool enabled)
+{
+    impl->m_tiled_storage = enabled;
+}
+
+bool DenoiserAOV::has_tiled_storage() const
+{
+    return impl->m_tiled_storage;
+}
+
 void DenoiserAOV::create_image(
     const size_t    canvas_width,
     const size_t    canvas_height,
@@ -325,148 +611,159 @@ void DenoiserAOV::create_image(
     const size_t    tile_height,
     ImageStack&     aov_images)
 {
-    const int w = static_cast<int>(canvas_width);
-    const int h = static_cast<int>(canvas_height);
-    const int bins = static_cast<int>(impl->m_num_bins);
-
-    impl->m_sum_accum.resize(w, h, 3);
-    impl->m_covariance_accum.resize(w, h, 6);
-    impl->m_histograms.resize(w, h, 3 * bins + 1);
+    if (impl->m_tiled_storage)
+    {
+        impl->m_accumulators.resize(
+            canvas_width,
+            canvas_height,
+            tile_width,
+            tile_height,
+            impl->m_num_bins);
+    }
+    else
+    {
+        impl->m_accumulators.resize(
+            canvas_width,
+            canvas_height,
+            canvas_width,
+            canvas_height,
+            impl->m_num_bins);
+
+        // Allocate the whole-frame accumulators.
+        impl->frame_accumulators();
+    }
 
     clear_image();
 }
 
 void DenoiserAOV::clear_image()
 {
-    impl->m_sum_accum.fill(0.0f);
-    impl->m_covariance_accum.fill(0.0f);
-    impl->m_histograms.fill(0.0f);
+    impl->m_accumulators.clear();
 }
 
 void DenoiserAOV::fill_empty_samples() const
 {
-    const int w = impl->m_histograms.getWidth();
-    const int h = impl->m_histograms.getHeight();
-
-    const int num_bins = static_cast<int>(impl->m_num_bins);
-    const int samples_channel_index = num_bins * 3;
-
-    for (int y = 0; y < h; ++y)
-    {
-        for (int x = 0; x < w; ++x)
-        {
-            const float num_samples =
-                impl->m_histograms.get(y, x, samples_channel_index);
-
-            if (num_samples == 0.0f)
-            {
-                impl->m_histograms.get(y, x, 0) = 1.0f;
-                impl->m_histograms.get(y, x, num_bins) = 1.0f;
-                impl->m_histograms.get(y, x, num_bins * 2) = 1.0f;
-                impl->m_histograms.get(y, x, samples_channel_index) = 1.0f;
-            }
-        }
-    }
+    renderer::fill_empty_samples(
+        impl->m_num_bins,
+        impl->frame_accumulators().m_histograms);
 }
 
 const Deepimf& DenoiserAOV::histograms_image() const
 {
-    return impl->m_histograms;
+    return impl->frame_accumulators().m_histograms;
 }
 
 Deepimf& DenoiserAOV::histograms_image()
 {
-    return impl->m_histograms;
+    return impl->frame_accumulators().m_histograms;
 }
 
 const Deepimf& DenoiserAOV::covariance_image() const
 {
-    return impl->m_covariance_accum;
+    return impl->frame_accumulators().m_covariance_accum;
 }
 
 Deepimf& DenoiserAOV::covariance_image()
 {
-    return impl->m_covariance_accum;
+    return impl->frame_accumulators().m_covariance_accum;
 }
 
 const Deepimf& DenoiserAOV::sum_image() const
 {
-    return impl->m_sum_accum;
+    return impl->frame_accumulators().m_sum_accum;
 }
 
 Deepimf& DenoiserAOV::sum_image()
 {
-    return impl->m_sum_accum;
+    return impl->frame_accumulators().m_sum_accum;
 }
 
 void DenoiserAOV::extract_num_samples_image(bcd::Deepimf& num_samples_image) const
 {
-    const int w = impl->m_histograms.getWidth();
-    const int h = impl->m_histograms.getHeight();
-    const int samples_channel_index = static_cast<int>(impl->m_num_bins * 3);
-
-    num_samples_image.resize(w, h, 1);
-
-    for (int y = 0; y < h; ++y)
-    {
-        for (int x = 0; x < w; ++x)
-            num_samples_image.get(y, x, 0) = impl->m_histograms.get(y, x, samples_channel_index);
-    }
+    renderer::extract_num_samples_image(
+        impl->m_num_bins,
+        impl->frame_accumulators().m_histograms,
+        num_samples_image);
 }
 
 void DenoiserAOV::compute_covariances_image(Deepimf& covariances_image) const
 {
-    const int w = impl->m_covariance_accum.getWidth();
-    const int h = impl->m_covariance_accum.getHeight();
+    const AccumulatorImages& accumulators = impl->frame_accumulators();
+
+    renderer::compute_covariances_image(
+        impl->m_num_bins,
+        accumulators.m_sum_accum,
+        accumulators.m_covariance_accum,
+        accumulators.m_histograms,
+        covariances_image);
+}
 
-    covariances_image.resize(w, h, 6);
-    covariances_image.fill(0.0f);
+void DenoiserAOV::extract_region(
+    const AABB2u&   rect,
+    Deepimf&        num_samples_image,
+    Deepimf&        histograms_image,
+    Deepimf&        covariances_image) const
+{
+    const int w = static_cast<int>(rect.extent()[0] + 1);
+    const int h = static_cast<int>(rect.extent()[1] + 1);
+    const int bins = static_cast<int>(impl->m_num_bins);
 
-    const int samples_channel_index = static_cast<int>(impl->m_num_bins * 3);
+    Deepimf sum_accum(w, h, 3);
+    Deepimf covariance_accum(w, h, 6);
+    histograms_image.resize(w, h, 3 * bins + 1);
 
-    const size_t c_xx = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xx);
-    const size_t c_yy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_yy);
-    const size_t c_zz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_zz);
-    const size_t c_yz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_yz);
-    const size_t c_xz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xz);
-    const size_t c_xy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xy);
+    sum_accum.fill(0.0f);
+    covariance_accum.fill(0.0f);
+    histograms_image.fill(0.0f);
 
+    // Gather the accumulators of the region.
     for (int y = 0; y < h; ++y)
     {
         for (int x = 0; x < w; ++x)
         {
-            const float sample_count = impl->m_histograms.get(y, x, samples_channel_index);
+            const size_t px = rect.min[0] + x;
+            const size_t py = rect.min[1] + y;
 
-            if (sample_count != 0.0f)
-            {
-                const float rcp_sample_count = 1.0f / sample_count;
-                const float bias_correction_factor =
-                    sample_count == 1.0f
-                        ? 1.0f
-                        : 1.0f / (1.0f - rcp_sample_count);
-
-                // Compute the mean.
-                float mean[3];
-                for (int k = 0; k < 3; ++k)
-                    mean[k] = impl->m_sum_accum.get(y, x, k) * rcp_sample_count;
-
-                // Compute the covariances.
-                const float xx = impl->m_covariance_accum.get(y, x, c_xx);
-                const float yy = impl->m_covariance_accum.get(y, x, c_yy);
-                const float zz = impl->m_covariance_accum.get(y, x, c_zz);
-                const float yz = impl->m_covariance_accum.get(y, x, c_yz);
-                const float xz = impl->m_covariance_accum.get(y, x, c_xz);
-                const float xy = impl->m_covariance_accum.get(y, x, c_xy);
-
-                covariances_image.get(y, x, c_xx) = (xx * rcp_sample_count - mean[0] * mean[0]) * bias_correction_factor;
-                covariances_image.get(y, x, c_yy) = (yy * rcp_sample_count - mean[1] * mean[1]) * bias_correction_factor;
-                covariances_image.get(y, x, c_zz) = (zz * rcp_sample_count - mean[2] * mean[2]) * bias_correction_factor;
-                covariances_image.get(y, x, c_yz) = (yz * rcp_sample_count - mean[1] * mean[2]) * bias_correction_factor;
-                covariances_image.get(y, x, c_xz) = (xz * rcp_sample_count - mean[0] * mean[2]) * bias_correction_factor;
-                covariances_image.get(y, x, c_xy) = (xy * rcp_sample_count - mean[0] * mean[1]) * bias_correction_factor;
-            }
+            const AccumulatorImages* cell = impl->m_accumulators.find_cell(px, py);
+            if (cell == nullptr)
+                continue;
+
+            const int cx = static_cast<int>(px) - cell->m_origin_x;
+            const int cy = static_cast<int>(py) - cell->m_origin_y;
+
+            sum_accum.set(y, x, &cell->m_sum_accum.get(cy, cx, 0));
+            covariance_accum.set(y, x, &cell->m_covariance_accum.get(cy, cx, 0));
+            histograms_image.set(y, x, &cell->m_histograms.get(cy, cx, 0));
         }
     }
+
+    renderer::fill_empty_samples(impl->m_num_bins, histograms_image);
+
+    renderer::extract_num_samples_image(
+        impl->m_num_bins,
+        histograms_image,
+        num_samples_image);
+
+    renderer::compute_covariances_image(
+        impl->m_num_bins,
+        sum_accum,
+        covariance_accum,
+        histograms_image,
+        covariances_image);
+}
+
+void DenoiserAOV::release_tile(
+    const size_t    tile_x,
+    const size_t    tile_y)
+{
+    assert(impl->m_tiled_storage);
+
+    impl->m_accumulators.release_cell(tile_x, tile_y);
+}
+
+size_t DenoiserAOV::get_memory_size() const
+{
+    return impl->m_accumulators.get_memory_size();
 }
 
 bool DenoiserAOV::write_images(
@@ -542,9 +839,7 @@ auto_release_ptr<AOVAccumulator> DenoiserAOV::create_accumulator() const
             impl->m_num_bins,
             impl->m_gamma,
             impl->m_max_value,
-            impl->m_sum_accum,
-            impl->m_covariance_accum,
-            impl->m_histograms));
+            impl->m_accumulators));
 }
 
 
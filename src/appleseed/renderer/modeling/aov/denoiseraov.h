@@ -32,6 +32,7 @@
 #include "renderer/modeling/aov/aov.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/utility/autoreleaseptr.h"
 
 // BCD headers.
@@ -66,6 +67,12 @@ class DenoiserAOV
 
     bool has_color_data() const override;
 
+    // Store the accumulators per tile rather than for the whole frame, so that
+    // they can be released as soon as they are no longer needed. Whole-frame
+    // accessors are unavailable in this case. Must be called before create_image().
+    void set_tiled_storage(const bool enabled);
+    bool has_tiled_storage() const;
+
     void create_image(
         const size_t    canvas_width,
         const size_t    canvas_height,
@@ -89,6 +96,22 @@ class DenoiserAOV
     void extract_num_samples_image(bcd::Deepimf& num_samples_image) const;
     void compute_covariances_image(bcd::Deepimf& covariances_image) const;
 
+    // Compute the denoiser's inputs for a rectangle of pixels (inclusive on all sides).
+    // Available with both whole-frame and tiled storage. Thread-safe.
+    void extract_region(
+        const foundation::AABB2u&   rect,
+        bcd::Deepimf&               num_samples_image,
+        bcd::Deepimf&               histograms_image,
+        bcd::Deepimf&               covariances_image) const;
+
+    // Release the accumulators of a tile. Only valid with tiled storage. Thread-safe.
+    void release_tile(
+        const size_t                tile_x,
+        const size_t                tile_y);
+
+    // Return the size in bytes of the accumulators currently allocated.
+    size_t get_memory_size() const;
+
     bool write_images(
         const char*                         file_path,
         const foundation::ImageAttributes&  image_attributes) const override;
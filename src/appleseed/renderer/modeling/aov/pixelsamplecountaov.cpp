@@ -104,6 +104,11 @@ void PixelSampleCountAOV::post_process_image(const Frame& frame)
     color_map.remap_red_channel(*m_image, crop_window, min_spp, max_spp);
 }
 
+bool PixelSampleCountAOV::is_image_post_processed() const
+{
+    return true;
+}
+
 void PixelSampleCountAOV::set_normalization_range(
     const size_t        min_spp,
     const size_t        max_spp)
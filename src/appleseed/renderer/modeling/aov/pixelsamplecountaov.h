@@ -66,6 +66,8 @@ class PixelSampleCountAOV
 
     void post_process_image(const Frame& frame) override;
 
+    bool is_image_post_processed() const override;
+
     void set_normalization_range(const size_t min_spp, const size_t max_spp);
 
   private:
@@ -34,7 +34,10 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/aov/aovsettings.h"
 #include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/aov/tilestack.h"
 #include "renderer/kernel/denoising/denoiser.h"
+#include "renderer/kernel/denoising/streamingdenoiser.h"
+#include "renderer/kernel/rendering/checkpointjournal.h"
 #include "renderer/kernel/rendering/ishadingresultframebufferfactory.h"
 #include "renderer/kernel/rendering/shadingresultframebuffer.h"
 #include "renderer/modeling/aov/aov.h"
@@ -53,11 +56,11 @@
 #include "foundation/image/conversion.h"
 #include "foundation/image/genericimagefilereader.h"
 #include "foundation/image/genericimagefilewriter.h"
-#include "foundation/image/genericprogressiveimagefilereader.h"
 #include "foundation/image/image.h"
 #include "foundation/image/imageattributes.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/image/tiledexrimagefilewriter.h"
 #include "foundation/math/filtersamplingtable.h"
 #include "foundation/math/scalar.h"
 #include "foundation/platform/defaulttimers.h"
@@ -81,7 +84,6 @@
 #include <exception>
 #include <memory>
 #include <string>
-#include <tuple>
 #include <vector>
 
 using namespace bcd;
@@ -119,10 +121,15 @@ struct Frame::Impl
     bool                            m_enable_dithering;
     uint32                          m_noise_seed;
     DenoisingMode                   m_denoising_mode;
+    bool                            m_streaming_denoiser;
     bool                            m_checkpoint_create;
     string                          m_checkpoint_create_path;
     bool                            m_checkpoint_resume;
     string                          m_checkpoint_resume_path;
+    unique_ptr<CheckpointJournal>   m_checkpoint_journal;
+
+    // Pass of each tile restored from the checkpoint, or CheckpointJournal::NoPass.
+    vector<size_t>                  m_checkpoint_tile_passes;
 
     // When resuming a render, first pass index should be
     // the number of the resumed render's pass + 1.
@@ -246,6 +253,7 @@ Frame::Frame(
     {
         auto_release_ptr<DenoiserAOV> aov = DenoiserAOVFactory::create();
         aov->set_parent(this);
+        aov->set_tiled_storage(impl->m_streaming_denoiser);
 
         aov->create_image(
             impl->m_frame_width,
@@ -288,6 +296,7 @@ void Frame::print_settings()
         "  dithering                     %s\n"
         "  noise seed                    %s\n"
         "  denoising mode                %s\n"
+        "  streaming denoiser            %s\n"
         "  create checkpoint             %s\n"
         "  resume checkpoint             %s\n"
         "  reference image path          %s",
@@ -308,6 +317,7 @@ void Frame::print_settings()
         pretty_uint(impl->m_noise_seed).c_str(),
         impl->m_denoising_mode == DenoisingMode::Off ? "off" :
         impl->m_denoising_mode == DenoisingMode::WriteOutputs ? "write outputs" : "denoise",
+        impl->m_streaming_denoiser ? "on" : "off",
         impl->m_checkpoint_create ? impl->m_checkpoint_create_path.c_str() : "off",
         impl->m_checkpoint_resume ? impl->m_checkpoint_resume_path.c_str() : "off",
         impl->m_ref_image_path.empty() ? "n/a" : impl->m_ref_image_path.c_str());
@@ -464,45 +474,56 @@ Frame::DenoisingMode Frame::get_denoising_mode() const
     return impl->m_denoising_mode;
 }
 
-void Frame::denoise(
-    const size_t                                thread_count,
-    IAbortSwitch*                               abort_switch) const
+namespace
 {
-    DenoiserOptions options;
+    DenoiserOptions get_denoiser_options(
+        const ParamArray&                       params,
+        const size_t                            thread_count)
+    {
+        DenoiserOptions options;
 
-    const bool skip_denoised = m_params.get_optional<bool>("skip_denoised", true);
-    options.m_marked_pixels_skipping_probability = skip_denoised ? 1.0f : 0.0f;
+        const bool skip_denoised = params.get_optional<bool>("skip_denoised", true);
+        options.m_marked_pixels_skipping_probability = skip_denoised ? 1.0f : 0.0f;
 
-    options.m_use_random_pixel_order = m_params.get_optional<bool>("random_pixel_order", true);
+        options.m_use_random_pixel_order = params.get_optional<bool>("random_pixel_order", true);
 
-    options.m_prefilter_spikes = m_params.get_optional<bool>("prefilter_spikes", true);
+        options.m_prefilter_spikes = params.get_optional<bool>("prefilter_spikes", true);
 
-    options.m_prefilter_threshold_stddev_factor =
-        m_params.get_optional<float>(
-            "spike_threshold",
-            options.m_prefilter_threshold_stddev_factor);
+        options.m_prefilter_threshold_stddev_factor =
+            params.get_optional<float>(
+                "spike_threshold",
+                options.m_prefilter_threshold_stddev_factor);
 
-    options.m_prefilter_threshold_stddev_factor =
-        m_params.get_optional<float>(
-            "spike_threshold",
-            options.m_prefilter_threshold_stddev_factor);
+        options.m_histogram_patch_distance_threshold =
+            params.get_optional<float>(
+                "patch_distance_threshold",
+                options.m_histogram_patch_distance_threshold);
 
-    options.m_histogram_patch_distance_threshold =
-        m_params.get_optional<float>(
-            "patch_distance_threshold",
-            options.m_histogram_patch_distance_threshold);
+        options.m_num_scales =
+            params.get_optional<size_t>(
+                "denoise_scales",
+                options.m_num_scales);
 
-    options.m_num_scales =
-        m_params.get_optional<size_t>(
-            "denoise_scales",
-            options.m_num_scales);
+        options.m_num_cores = thread_count;
 
-    options.m_num_cores = thread_count;
+        options.m_mark_invalid_pixels =
+            params.get_optional<bool>("mark_invalid_pixels", false);
 
-    options.m_mark_invalid_pixels =
-        m_params.get_optional<bool>("mark_invalid_pixels", false);
+        return options;
+    }
+}
+
+void Frame::denoise(
+    const size_t                                thread_count,
+    IAbortSwitch*                               abort_switch) const
+{
+    const DenoiserOptions options = get_denoiser_options(m_params, thread_count);
 
     assert(impl->m_denoiser_aov);
+    assert(!impl->m_denoiser_aov->has_tiled_storage());
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
 
     impl->m_denoiser_aov->fill_empty_samples();
 
@@ -535,103 +556,102 @@ void Frame::denoise(
                 abort_switch);
         }
     }
-}
 
-namespace
-{
-    size_t get_checkpoint_total_channel_count(const size_t aov_count)
-    {
-        // The beauty image plus the shading result framebuffer.
-        return ShadingResultFrameBuffer::get_total_channel_count(aov_count) + 1;
-    }
+    stopwatch.measure();
 
-    typedef vector<tuple<string, CanvasProperties, ImageAttributes>> CheckpointProperties;
+    // Accumulators, sample counts, covariances, and noisy and denoised colors.
+    const size_t pixel_count = impl->m_frame_width * impl->m_frame_height;
+    const size_t memory_size =
+        impl->m_denoiser_aov->get_memory_size() +
+        pixel_count * (1 + 6 + 3 + 3) * sizeof(float);
 
+    RENDERER_LOG_INFO(
+        "denoised frame \"%s\" in %s, using at least %s of memory.",
+        get_path().c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str(),
+        pretty_size(memory_size).c_str());
+}
 
-    //
-    // Interface used to save the rendering buffer in checkpoints.
-    //
+bool Frame::is_denoiser_streaming() const
+{
+    return impl->m_denoiser_aov != nullptr && impl->m_streaming_denoiser;
+}
 
-    class ShadingBufferCanvas
-      : public ICanvas
-    {
-      public:
-        ShadingBufferCanvas(
-            const Frame&                                frame,
-            IShadingResultFrameBufferFactory*           buffer_factory)
-          : m_buffer_factory(buffer_factory)
-          , m_frame(frame)
-          , m_props(
-                m_frame.image().properties().m_canvas_width,
-                m_frame.image().properties().m_canvas_height,
-                m_frame.image().properties().m_tile_width,
-                m_frame.image().properties().m_tile_height,
-                get_checkpoint_total_channel_count(m_frame.aov_images().size()),
-                PixelFormatFloat)
-        {
-            assert(buffer_factory);
-        }
+StreamingDenoiser* Frame::create_streaming_denoiser(IAbortSwitch* abort_switch) const
+{
+    assert(is_denoiser_streaming());
 
-        const CanvasProperties& properties() const override
-        {
-            return m_props;
-        }
+    return
+        new StreamingDenoiser(
+            *this,
+            *impl->m_denoiser_aov,
+            get_denoiser_options(m_params, 1),
+            abort_switch);
+}
 
-        Tile& tile(
-            const size_t            tile_x,
-            const size_t            tile_y) override
-        {
-            ShadingResultFrameBuffer* tile_buffer = m_buffer_factory->create(
-                m_frame,
-                tile_x,
-                tile_y,
-                get_tile_bbox(tile_x, tile_y));
-
-            assert(tile_buffer);
-            return *tile_buffer;
-        }
+namespace
+{
+    // Return the AOVs whose images are rendered directly rather than developed
+    // from the shading result framebuffers.
+    vector<const UnfilteredAOV*> get_unfiltered_aovs(const Frame& frame)
+    {
+        vector<const UnfilteredAOV*> unfiltered_aovs;
 
-        const Tile& tile(
-            const size_t            tile_x,
-            const size_t            tile_y) const override
+        for (const AOV& aov : frame.aovs())
         {
-            const ShadingResultFrameBuffer* tile_buffer = m_buffer_factory->create(
-                m_frame,
-                tile_x,
-                tile_y,
-                get_tile_bbox(tile_x, tile_y));
-
-            assert(tile_buffer);
-            return *tile_buffer;
+            const UnfilteredAOV* unfiltered_aov = dynamic_cast<const UnfilteredAOV*>(&aov);
+            if (unfiltered_aov != nullptr)
+                unfiltered_aovs.push_back(unfiltered_aov);
         }
 
-      private:
-        IShadingResultFrameBufferFactory*           m_buffer_factory;
-        const Frame&                                m_frame;
-        const CanvasProperties                      m_props;
-
-        AABB2i get_tile_bbox(
-            const size_t            tile_x,
-            const size_t            tile_y) const
-        {
-            const Image& image = m_frame.image();
-            const CanvasProperties& props = image.properties();
+        return unfiltered_aovs;
+    }
 
-            // Compute the image space bounding box of the tile.
-            const size_t tile_origin_x = props.m_tile_width * tile_x;
-            const size_t tile_origin_y = props.m_tile_height * tile_y;
+    unique_ptr<CheckpointJournal> create_checkpoint_journal(const Frame& frame)
+    {
+        const CanvasProperties& props = frame.image().properties();
+
+        // The first layer of a tile is its shading result framebuffer, which holds
+        // the accumulated samples of the main image and of the filtered AOVs.
+        vector<size_t> layer_pixel_sizes;
+        layer_pixel_sizes.push_back(
+            (ShadingResultFrameBuffer::get_total_channel_count(frame.aov_images().size()) + 1) * sizeof(float));
+
+        // The following layers are the tiles of the unfiltered AOVs.
+        for (const UnfilteredAOV* aov : get_unfiltered_aovs(frame))
+            layer_pixel_sizes.push_back(aov->get_image().properties().m_pixel_size);
+
+        return
+            unique_ptr<CheckpointJournal>(
+                new CheckpointJournal(
+                    props.m_canvas_width,
+                    props.m_canvas_height,
+                    props.m_tile_width,
+                    props.m_tile_height,
+                    layer_pixel_sizes));
+    }
 
-            const Tile& frame_tile = image.tile(tile_x, tile_y);
+    ShadingResultFrameBuffer* get_tile_framebuffer(
+        const Frame&                        frame,
+        IShadingResultFrameBufferFactory*   buffer_factory,
+        const size_t                        tile_x,
+        const size_t                        tile_y)
+    {
+        const Image& image = frame.image();
+        const CanvasProperties& props = image.properties();
+        const Tile& frame_tile = image.tile(tile_x, tile_y);
 
-            // Compute the tile space bounding box of the pixels to render.
-            return compute_tile_space_bbox(
-                tile_origin_x,
-                tile_origin_y,
+        // Compute the tile space bounding box of the pixels to render.
+        const AABB2i tile_bbox =
+            compute_tile_space_bbox(
+                props.m_tile_width * tile_x,
+                props.m_tile_height * tile_y,
                 frame_tile.get_width(),
                 frame_tile.get_height(),
-                m_frame.get_crop_window());
-        }
-    };
+                frame.get_crop_window());
+
+        return buffer_factory->create(frame, tile_x, tile_y, tile_bbox);
+    }
 
     void get_denoiser_checkpoint_paths(
         const string&                   checkpoint_path,
@@ -642,99 +662,30 @@ namespace
         const bf::path boost_file_path(checkpoint_path);
         const bf::path directory = boost_file_path.parent_path();
         const string base_file_name = boost_file_path.stem().string() + ".denoiser";
-        const string extension = boost_file_path.extension().string();
 
-        const string hist_file_name = base_file_name + ".hist" + extension;
+        const string hist_file_name = base_file_name + ".hist.exr";
         hist_path = (directory / hist_file_name).string();
 
-        const string cov_file_name = base_file_name + ".cov" + extension;
+        const string cov_file_name = base_file_name + ".cov.exr";
         cov_path = (directory / cov_file_name).string();
 
-        const string sum_file_name = base_file_name + ".sum" + extension;
+        const string sum_file_name = base_file_name + ".sum.exr";
         sum_path = (directory / sum_file_name).string();
     }
 
-    bool is_checkpoint_compatible(
-        const string&                   checkpoint_path,
-        const Frame&                    frame,
-        const CheckpointProperties&     checkpoint_props)
+    bool denoiser_checkpoint_exists(const string& checkpoint_path)
     {
-        const Image& frame_image = frame.image();
-        const CanvasProperties& frame_props = frame_image.properties();
-        const CanvasProperties& beauty_props = get<1>(checkpoint_props[0]);
-        const ImageAttributes& exr_attributes = get<2>(checkpoint_props[0]);
-        const string initial_layer_name = get<0>(checkpoint_props[0]);
-
-        // Check for atttributes.
-        if (!exr_attributes.exist("appleseed:LastPass"))
-        {
-            RENDERER_LOG_ERROR("incorrect checkpoint: some attributes are missing.");
-            return false;
-        }
-
-        // Check for beauty layer.
-        if (initial_layer_name != "beauty")
-        {
-            RENDERER_LOG_ERROR("incorrect checkpoint: beauty layer is missing.");
-            return false;
-        }
-
-        // Check for shading buffer layer.
-        const string second_layer_name = get<0>(checkpoint_props[1]);
-        if (second_layer_name != "appleseed:RenderingBuffer")
-        {
-            RENDERER_LOG_ERROR("incorrect checkpoint: rendering buffer layer is missing.");
-            return false;
-        }
-
-        // Check that the shading buffer layer has correct amount of channel.
-        // The checkpoint should contain the beauty image and the shading buffer.
-        const size_t expect_channel_count = get_checkpoint_total_channel_count(frame.aov_images().size());
-        if (get<1>(checkpoint_props[1]).m_channel_count != expect_channel_count)
-        {
-            RENDERER_LOG_ERROR("incorrect checkpoint: the shading buffer doesn't contain the correct number of channels.");
-            return false;
-        }
-
-        // Check canvas properties.
-        if (frame_props.m_canvas_width != beauty_props.m_canvas_width ||
-            frame_props.m_canvas_height != beauty_props.m_canvas_height ||
-            frame_props.m_tile_width != beauty_props.m_tile_width ||
-            frame_props.m_tile_height != beauty_props.m_tile_height ||
-            frame_props.m_channel_count != beauty_props.m_channel_count ||
-            frame_props.m_pixel_format != beauty_props.m_pixel_format)
-        {
-            RENDERER_LOG_ERROR("incorrect checkpoint: the beauty layer properties doesn't match the renderer properties.");
-            return false;
-        }
-
-        // Check if AOVs are here.
-        if (checkpoint_props.size() < frame.aovs().size() + 2)
-        {
-            RENDERER_LOG_ERROR("incorrect checkpoint: some aovs are missing.");
-            return false;
-        }
-
-        // Check if denoising is enabled and pass exists.
-        if (frame.get_denoising_mode() != Frame::DenoisingMode::Off)
-        {
-            string hist_file_path, cov_file_path, sum_file_path;
-            get_denoiser_checkpoint_paths(
-                checkpoint_path,
-                hist_file_path,
-                cov_file_path,
-                sum_file_path);
-
-            if (!bf::exists(bf::path(hist_file_path.c_str())) ||
-                !bf::exists(bf::path(cov_file_path.c_str())) ||
-                !bf::exists(bf::path(sum_file_path.c_str())))
-            {
-                RENDERER_LOG_ERROR("cannot load denoiser's checkpoint from disk because one or several files are missing.");
-                return false;
-            }
-        }
-
-        return true;
+        string hist_file_path, cov_file_path, sum_file_path;
+        get_denoiser_checkpoint_paths(
+            checkpoint_path,
+            hist_file_path,
+            cov_file_path,
+            sum_file_path);
+
+        return
+            bf::exists(bf::path(hist_file_path.c_str())) &&
+            bf::exists(bf::path(cov_file_path.c_str())) &&
+            bf::exists(bf::path(sum_file_path.c_str()));
     }
 
     bool load_denoiser_checkpoint(
@@ -792,200 +743,198 @@ namespace
 
 bool Frame::load_checkpoint(IShadingResultFrameBufferFactory* buffer_factory)
 {
-    if  (!impl->m_checkpoint_resume)
-        return true;
-
-    bf::path bf_path(impl->m_checkpoint_resume_path.c_str());
+    impl->m_checkpoint_journal.reset();
+    impl->m_checkpoint_tile_passes.clear();
 
-    // Check if the file exists.
-    if (!bf::exists(bf_path))
-    {
-        RENDERER_LOG_WARNING("no checkpoint found, starting a new render.");
+    if (!impl->m_checkpoint_create && !impl->m_checkpoint_resume)
         return true;
-    }
 
-    // Open the file.
-    GenericProgressiveImageFileReader reader;
-    reader.open(impl->m_checkpoint_resume_path.c_str());
+    impl->m_checkpoint_journal = create_checkpoint_journal(*this);
+    CheckpointJournal& journal = *impl->m_checkpoint_journal;
 
-    // First, read layers name and properties.
-    CheckpointProperties checkpoint_props;
-    size_t layer_index = 0;
-    while (reader.choose_subimage(layer_index))
+    if (impl->m_checkpoint_resume)
     {
-        CanvasProperties layer_canvas_props;
-        ImageAttributes layer_attributes;
+        const string& path = impl->m_checkpoint_resume_path;
 
-        reader.read_canvas_properties(layer_canvas_props);
-        reader.read_image_attributes(layer_attributes);
+        // Check if the file exists.
+        if (!bf::exists(bf::path(path.c_str())))
+            RENDERER_LOG_WARNING("no checkpoint found, starting a new render.");
+        else
+        {
+            if (!journal.read(path.c_str()))
+            {
+                RENDERER_LOG_ERROR("incorrect checkpoint: %s could not be read or does not match the frame.", path.c_str());
+                return false;
+            }
 
-        const string layer_name =
-            layer_attributes.exist("name")
-                ? layer_attributes.get<string>("name")
-                : "undefined";
+            // The denoiser only saves its accumulators at the end of a pass,
+            // so only complete passes can be restored when denoising.
+            const bool denoising = get_denoising_mode() != DenoisingMode::Off;
+            if (denoising && !denoiser_checkpoint_exists(path))
+            {
+                RENDERER_LOG_ERROR("cannot load denoiser's checkpoint from disk because one or several files are missing.");
+                return false;
+            }
 
-        checkpoint_props.emplace_back(
-            layer_name,
-            layer_canvas_props,
-            layer_attributes);
+            const size_t max_pass =
+                denoising ? journal.get_last_complete_pass() : CheckpointJournal::NoPass;
 
-        ++layer_index;
-    }
+            // Resume rendering at the first pass that was not completed by all tiles.
+            const CanvasProperties& props = image().properties();
+            vector<size_t> tile_passes(props.m_tile_count, CheckpointJournal::NoPass);
+            size_t start_pass = ~size_t(0);
+            size_t restored_tile_count = 0;
 
-    // Check checkpoint's compatibility.
-    if (!is_checkpoint_compatible(impl->m_checkpoint_resume_path, *this, checkpoint_props))
-    {
-        return false;
-    }
+            for (size_t tile_y = 0; tile_y < props.m_tile_count_y; ++tile_y)
+            {
+                for (size_t tile_x = 0; tile_x < props.m_tile_count_x; ++tile_x)
+                {
+                    const size_t tile_pass =
+                        denoising && max_pass == CheckpointJournal::NoPass
+                            ? CheckpointJournal::NoPass
+                            : journal.get_tile_pass(tile_x, tile_y, max_pass);
 
-    const size_t start_pass = get<2>(checkpoint_props[0]).get<size_t>("appleseed:LastPass") + 1;
+                    tile_passes[tile_y * props.m_tile_count_x + tile_x] = tile_pass;
+                    start_pass = min(start_pass, tile_pass == CheckpointJournal::NoPass ? 0 : tile_pass + 1);
 
-    // Check if passes have already been rendered.
-    if (impl->m_pass_count <= start_pass)
-    {
-        RENDERER_LOG_WARNING("the requested passes have already been rendered and saved into the checkpoint.");
-        return false;
-    }
+                    if (tile_pass != CheckpointJournal::NoPass)
+                        ++restored_tile_count;
+                }
+            }
 
-    // Interface the shading buffer in a canvas.
-    ShadingBufferCanvas shading_canvas(*this, buffer_factory);
+            // Check if passes have already been rendered.
+            if (impl->m_pass_count <= start_pass)
+            {
+                RENDERER_LOG_WARNING("the requested passes have already been rendered and saved into the checkpoint.");
+                return false;
+            }
 
-    // Load tiles from the checkpoint.
-    const CanvasProperties& beauty_props = get<1>(checkpoint_props[0]);
+            // Restore the tiles and develop them into the frame, since some of them
+            // may not be rendered again during the first resumed pass.
+            const vector<const UnfilteredAOV*> unfiltered_aovs = get_unfiltered_aovs(*this);
+            vector<Tile*> layers(1 + unfiltered_aovs.size());
 
-    for (size_t tile_y = 0; tile_y < beauty_props.m_tile_count_y; ++tile_y)
-    {
-        for (size_t tile_x = 0; tile_x < beauty_props.m_tile_count_x; ++tile_x)
-        {
-            // Read shading buffer.
-            reader.choose_subimage(1);
-            Tile& shading_tile = shading_canvas.tile(tile_x, tile_y);
-            reader.read_tile(tile_x, tile_y, &shading_tile);
-
-            // No need to read beauty and filtered AOVs because they
-            // are in the shading buffer.
-
-            // Read unfiltered AOV layers.
-            vector<unique_ptr<Tile>> aov_tiles;
-            vector<const float*> aov_ptrs;
-            for (size_t i = 0; i < aovs().size(); ++i)
+            for (size_t tile_y = 0; tile_y < props.m_tile_count_y; ++tile_y)
             {
-                UnfilteredAOV* aov = dynamic_cast<UnfilteredAOV*>(
-                    aovs().get_by_index(i));
+                for (size_t tile_x = 0; tile_x < props.m_tile_count_x; ++tile_x)
+                {
+                    if (tile_passes[tile_y * props.m_tile_count_x + tile_x] == CheckpointJournal::NoPass)
+                        continue;
 
-                if (aov == nullptr)
-                    continue;
+                    ShadingResultFrameBuffer* framebuffer =
+                        get_tile_framebuffer(*this, buffer_factory, tile_x, tile_y);
 
-                const string aov_name = aov->get_name();
+                    layers[0] = framebuffer;
+                    for (size_t i = 0, e = unfiltered_aovs.size(); i < e; ++i)
+                        layers[i + 1] = &unfiltered_aovs[i]->get_image().tile(tile_x, tile_y);
 
-                // Search layer index in the file.
-                size_t subimage_index(~0);
-                for (size_t s = 0; s < checkpoint_props.size(); ++s)
-                {
-                    if (get<0>(checkpoint_props[s]) == aov_name)
+                    if (!journal.read_tile(tile_x, tile_y, max_pass, layers.data()))
                     {
-                        subimage_index = s;
-                        break;
+                        RENDERER_LOG_ERROR(
+                            "incorrect checkpoint: tile (" FMT_SIZE_T ", " FMT_SIZE_T ") could not be read.",
+                            tile_x,
+                            tile_y);
+                        buffer_factory->destroy(framebuffer);
+                        return false;
                     }
+
+                    TileStack aov_tiles = aov_images().tiles(tile_x, tile_y);
+                    framebuffer->develop_to_tile(image().tile(tile_x, tile_y), aov_tiles);
+
+                    buffer_factory->destroy(framebuffer);
                 }
+            }
+
+            // Load internal AOVs (from external files).
+            if (restored_tile_count > 0)
+            {
+                for (size_t i = 0, e = internal_aovs().size(); i < e; ++i)
+                {
+                    AOV* aov = internal_aovs().get_by_index(i);
 
-                assert(subimage_index != size_t(~0));
+                    DenoiserAOV* denoiser_aov = dynamic_cast<DenoiserAOV*>(aov);
 
-                Image& aov_image = aov->get_image();
-                Tile& aov_tile = aov_image.tile(tile_x, tile_y);
-                reader.choose_subimage(subimage_index);
-                reader.read_tile(tile_x, tile_y, &aov_tile);
+                    // Load denoiser checkpoint.
+                    if (denoiser_aov != nullptr)
+                    {
+                        if (!load_denoiser_checkpoint(path, denoiser_aov))
+                            return false;
+                    }
+                }
             }
+
+            RENDERER_LOG_INFO(
+                "read checkpoint file %s, restored %s, resuming rendering at pass %s.",
+                path.c_str(),
+                plural(restored_tile_count, "tile").c_str(),
+                pretty_uint(start_pass + 1).c_str());
+
+            impl->m_initial_pass = start_pass;
+            impl->m_checkpoint_tile_passes.swap(tile_passes);
         }
     }
 
-    // Load internal AOVs (from external files).
-    for (size_t i = 0, e = internal_aovs().size(); i < e; ++i)
+    if (impl->m_checkpoint_create)
     {
-        AOV* aov = internal_aovs().get_by_index(i);
+        const string& path = impl->m_checkpoint_create_path;
 
-        DenoiserAOV* denoiser_aov = dynamic_cast<DenoiserAOV*>(aov);
+        create_parent_directories(path.c_str());
 
-        // Load denoiser checkpoint.
-        if (denoiser_aov != nullptr)
+        if (!journal.begin_writing(path.c_str()))
         {
-            if (!load_denoiser_checkpoint(impl->m_checkpoint_resume_path, denoiser_aov))
-                return false;
+            RENDERER_LOG_ERROR("failed to open checkpoint file %s for writing, disabling checkpoint creation.", path.c_str());
+            impl->m_checkpoint_journal.reset();
         }
     }
 
-    RENDERER_LOG_INFO("read checkpoint file %s, resuming rendering at pass %s.",
-        impl->m_checkpoint_resume_path.c_str(),
-        pretty_uint(start_pass).c_str());
-
-    impl->m_initial_pass = start_pass;
-
     return true;
 }
 
-void Frame::save_checkpoint(
-    IShadingResultFrameBufferFactory*           buffer_factory,
+bool Frame::has_checkpointed_tile(
+    const size_t                                tile_x,
+    const size_t                                tile_y,
     const size_t                                pass) const
 {
-    if (!impl->m_checkpoint_create)
-        return;
-
-    create_parent_directories(impl->m_checkpoint_create_path.c_str());
+    if (impl->m_checkpoint_tile_passes.empty())
+        return false;
 
-    GenericImageFileWriter writer(impl->m_checkpoint_create_path.c_str());
+    const size_t tile_index = tile_y * image().properties().m_tile_count_x + tile_x;
+    const size_t tile_pass = impl->m_checkpoint_tile_passes[tile_index];
 
-    // Add the beauty image.
-    {
-        writer.append_image(&image());
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        image_attributes.insert("appleseed:LastPass", pass);
-        image_attributes.insert("image_name", "beauty");
-        writer.set_image_attributes(image_attributes);
-    }
+    return tile_pass != CheckpointJournal::NoPass && tile_pass >= pass;
+}
 
-    // Buffer containing pixels' weight.
-    ShadingBufferCanvas pixels_weight_buffer(*this, buffer_factory);
-    const size_t shading_channel_count = pixels_weight_buffer.properties().m_channel_count;
+void Frame::save_tile_checkpoint(
+    IShadingResultFrameBufferFactory*           buffer_factory,
+    const size_t                                tile_x,
+    const size_t                                tile_y,
+    const size_t                                pass) const
+{
+    if (!impl->m_checkpoint_create || !impl->m_checkpoint_journal)
+        return;
 
-    // Create channel names.
-    vector<string> shading_channel_names;
-    vector<const char *> shading_channel_names_cstr;
-    {
-        static const string channel_name_prefix = "channel_";
-        for (size_t i = 0; i < shading_channel_count; ++i)
-        {
-            shading_channel_names.push_back(channel_name_prefix + pad_left(to_string(i + 1), '0', 4));
-            shading_channel_names_cstr.push_back(shading_channel_names[i].c_str());
-        }
+    ShadingResultFrameBuffer* framebuffer =
+        get_tile_framebuffer(*this, buffer_factory, tile_x, tile_y);
 
-        assert(shading_channel_names.size() == shading_channel_count);
-    }
+    const vector<const UnfilteredAOV*> unfiltered_aovs = get_unfiltered_aovs(*this);
+    vector<const Tile*> layers(1 + unfiltered_aovs.size());
 
-    // Add the shading buffer.
-    {
-        writer.append_image(&pixels_weight_buffer);
-        writer.set_image_channels(shading_channel_count, shading_channel_names_cstr.data());
+    layers[0] = framebuffer;
+    for (size_t i = 0, e = unfiltered_aovs.size(); i < e; ++i)
+        layers[i + 1] = &unfiltered_aovs[i]->get_image().tile(tile_x, tile_y);
 
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        image_attributes.insert("image_name", "appleseed:RenderingBuffer");
-        writer.set_image_attributes(image_attributes);
-    }
+    impl->m_checkpoint_journal->write_tile(pass, tile_x, tile_y, layers.data());
 
-    // Add AOV images.
-    for (const AOV& aov : aovs())
-    {
-        const char* aov_name = aov.get_name();
-        const Image& aov_image = aov.get_image();
-        writer.append_image(&aov_image);
-        writer.set_image_channels(aov.get_channel_count(), aov.get_channel_names());
+    buffer_factory->destroy(framebuffer);
+}
 
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        image_attributes.insert("image_name", aov_name);
-        writer.set_image_attributes(image_attributes);
-    }
+void Frame::save_checkpoint(const size_t pass) const
+{
+    if (!impl->m_checkpoint_create || !impl->m_checkpoint_journal)
+        return;
 
-    // Write the file.
-    writer.write();
+    // Record that all tiles have completed this pass.
+    impl->m_checkpoint_journal->write_pass(pass);
 
     // Add internal AOVs layers (in external files).
     for (const AOV& aov : internal_aovs())
@@ -996,9 +945,10 @@ void Frame::save_checkpoint(
             save_denoiser_checkpoint(impl->m_checkpoint_create_path, denoiser_aov);
     }
 
-    RENDERER_LOG_INFO("wrote checkpoint file %s for pass %s.",
+    RENDERER_LOG_INFO("updated checkpoint file %s for pass %s (%s).",
         impl->m_checkpoint_create_path.c_str(),
-        pretty_uint(pass + 1).c_str());
+        pretty_uint(pass + 1).c_str(),
+        pretty_size(impl->m_checkpoint_journal->get_size()).c_str());
 }
 
 namespace
@@ -1286,6 +1236,34 @@ void Frame::write_main_and_aov_images_to_multipart_exr(const char* file_path) co
         pretty_time(stopwatch.get_seconds()).c_str());
 }
 
+void Frame::append_main_and_aov_parts(TiledEXRImageFileWriter& writer) const
+{
+    ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+    add_chromaticities_attributes(image_attributes);
+    image_attributes.insert("color_space", "linear");
+
+    // Always save the main image as half floats.
+    writer.append_part(
+        "beauty",
+        impl->m_image->properties(),
+        nullptr,
+        PixelFormatHalf,
+        image_attributes);
+
+    for (const AOV& aov : impl->m_aovs)
+    {
+        const CanvasProperties& props = aov.get_image().properties();
+
+        // If the AOV has color data, assume we can save it as half floats.
+        writer.append_part(
+            aov.get_name(),
+            props,
+            aov.get_channel_names(),
+            aov.has_color_data() ? PixelFormatHalf : props.m_pixel_format,
+            image_attributes);
+    }
+}
+
 bool Frame::archive(
     const char*                                 directory,
     char**                                      output_path) const
@@ -1417,6 +1395,10 @@ void Frame::extract_parameters()
                 "off");
             impl->m_denoising_mode = DenoisingMode::Off;
         }
+
+        impl->m_streaming_denoiser =
+            impl->m_denoising_mode == DenoisingMode::Denoise &&
+            m_params.get_optional<bool>("streaming_denoiser", false);
     }
 
     // Retrieve checkpoint parameters.
@@ -1425,72 +1407,41 @@ void Frame::extract_parameters()
         impl->m_checkpoint_create = m_params.get_optional<bool>("checkpoint_create", false);
         impl->m_checkpoint_create_path = "";
 
-        // Check if the checkpoint create path is valid.
+        // Use the output path with a ".checkpoint" extension by default.
         if (impl->m_checkpoint_create)
         {
             string path = m_params.get_optional<string>("checkpoint_create_path", "");
-            const bool use_default_path = path.empty();
-            if (use_default_path)
-                path = m_params.get_required<string>("output_path");
-
-            bf::path bf_path(path.c_str());
-
-            const string extension = lower_case(bf_path.extension().string());
-
-            if (extension != ".exr")
+            if (path.empty())
             {
-                // Only .exr files are allowed.
-                RENDERER_LOG_ERROR("checkpoint file must be an \".exr\" file, disabling checkpoint creation.");
-                impl->m_checkpoint_create = false;
+                const bf::path output_path(m_params.get_required<string>("output_path").c_str());
+                path = (output_path.parent_path() / (output_path.stem().string() + ".checkpoint")).string();
             }
-            else
-            {
-                // Add ".checkpoint" in the filename.
-                if (use_default_path && !ends_with(path, ".checkpoint.exr"))
-                {
-                    const bf::path directory = bf_path.parent_path();
-                    const string base_file_name = bf_path.stem().string();
-                    path = (directory / (base_file_name + ".checkpoint.exr")).string();
-                }
 
-                impl->m_checkpoint_create_path = path;
-            }
+            impl->m_checkpoint_create_path = path;
         }
 
         // Resume option.
         impl->m_checkpoint_resume = m_params.get_optional<bool>("checkpoint_resume", false);
         impl->m_checkpoint_resume_path = "";
 
-        // Check if the checkpoint resume path is valid.
+        // Use the output path with a ".checkpoint" extension by default.
         if (impl->m_checkpoint_resume)
         {
             string path = m_params.get_optional<string>("checkpoint_resume_path", "");
-            const bool use_default_path = path == "";
-            if (use_default_path)
-                path = m_params.get_required<string>("output_path");
-
-            bf::path bf_path(path.c_str());
-
-            const string extension = lower_case(bf_path.extension().string());
-
-            if (extension != ".exr")
+            if (path.empty())
             {
-                // Only .exr files are allowed.
-                RENDERER_LOG_ERROR("checkpoint file must be an \".exr\" file, disabling checkpoint resuming.");
-                impl->m_checkpoint_resume = false;
+                const bf::path output_path(m_params.get_required<string>("output_path").c_str());
+                path = (output_path.parent_path() / (output_path.stem().string() + ".checkpoint")).string();
             }
-            else
-            {
-                // Add ".checkpoint" in the filename.
-                if (use_default_path && !ends_with(path, ".checkpoint.exr"))
-                {
-                    const bf::path directory = bf_path.parent_path();
-                    const string base_file_name = bf_path.stem().string();
-                    path = (directory / (base_file_name + ".checkpoint.exr")).string();
-                }
 
-                impl->m_checkpoint_resume_path = path;
-            }
+            impl->m_checkpoint_resume_path = path;
+        }
+
+        // Checkpoints save the denoiser accumulators of the whole frame.
+        if (impl->m_streaming_denoiser && (impl->m_checkpoint_create || impl->m_checkpoint_resume))
+        {
+            RENDERER_LOG_WARNING("the streaming denoiser is not compatible with checkpoints, disabling it.");
+            impl->m_streaming_denoiser = false;
         }
     }
 
@@ -1703,6 +1654,17 @@ DictionaryArray FrameFactory::get_input_metadata()
                 Dictionary()
                     .insert("denoiser", "on")));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "streaming_denoiser")
+            .insert("label", "Denoise While Rendering")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("visible_if",
+                Dictionary()
+                    .insert("denoiser", "on")));
+
     return metadata;
 }
 
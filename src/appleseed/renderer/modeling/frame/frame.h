@@ -60,6 +60,7 @@ namespace foundation    { class SearchPaths; }
 namespace foundation    { class StringArray; }
 namespace foundation    { class StringDictionary; }
 namespace foundation    { class Tile; }
+namespace foundation    { class TiledEXRImageFileWriter; }
 namespace renderer      { class BaseGroup; }
 namespace renderer      { class DenoiserAOV; }
 namespace renderer      { class ImageStack; }
@@ -67,6 +68,7 @@ namespace renderer      { class IShadingResultFrameBufferFactory; }
 namespace renderer      { class OnFrameBeginRecorder; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Project; }
+namespace renderer      { class StreamingDenoiser; }
 
 namespace renderer
 {
@@ -184,15 +186,35 @@ class APPLESEED_DLLSYMBOL Frame
         const size_t                                thread_count,
         foundation::IAbortSwitch*                   abort_switch) const;
 
-    // Open the checkpoint if the chekpoint resume option is enabled.
+    // Return true if tiles are denoised while the last pass is rendered
+    // rather than after rendering, using create_streaming_denoiser().
+    bool is_denoiser_streaming() const;
+
+    // Create a denoiser for tiles of the last pass. The caller owns the returned object.
+    StreamingDenoiser* create_streaming_denoiser(
+        foundation::IAbortSwitch*                   abort_switch) const;
+
+    // Restore the tiles saved in the checkpoint if the checkpoint resume option is
+    // enabled, and open the checkpoint for writing if checkpoint creation is enabled.
     // Returns true if successful, false otherwise.
     bool load_checkpoint(IShadingResultFrameBufferFactory*  buffer_factory);
 
-    // Create a checkpoint file for the resuming the render at the current pass.
-    void save_checkpoint(
+    // Return true if a given tile was restored from the checkpoint at a given pass or later.
+    bool has_checkpointed_tile(
+        const size_t                                tile_x,
+        const size_t                                tile_y,
+        const size_t                                pass) const;
+
+    // Append a rendered tile to the checkpoint. Thread-safe.
+    void save_tile_checkpoint(
         IShadingResultFrameBufferFactory*           buffer_factory,
+        const size_t                                tile_x,
+        const size_t                                tile_y,
         const size_t                                pass) const;
 
+    // Mark a pass as complete in the checkpoint and save the denoiser's state.
+    void save_checkpoint(const size_t pass) const;
+
     // Write the main image to disk.
     // Return true if successful, false otherwise.
     bool write_main_image(const char* file_path) const;
@@ -209,6 +231,11 @@ class APPLESEED_DLLSYMBOL Frame
     // Write the main image and the AOV images to a multipart OpenEXR file.
     void write_main_and_aov_images_to_multipart_exr(const char* file_path) const;
 
+    // Add the main image and the AOV images as parts of a tiled multipart OpenEXR file,
+    // laid out like those written by write_main_and_aov_images_to_multipart_exr().
+    // Part 0 is the main image, part i + 1 is the image of the i'th AOV.
+    void append_main_and_aov_parts(foundation::TiledEXRImageFileWriter& writer) const;
+
     // Archive the frame to a given directory on disk. If output_path is provided,
     // the full path to the output file will be returned. The returned string must
     // be freed using foundation::free_string().
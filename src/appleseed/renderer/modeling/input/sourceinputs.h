@@ -44,13 +44,24 @@ class APPLESEED_DLLSYMBOL SourceInputs
     float   m_uv_x;
     float   m_uv_y;
 
+    // Screen space partial derivatives of the texture coordinates from UV set #0.
+    // They are zero when the footprint of the lookup is unknown.
+    float   m_duvdx_x;
+    float   m_duvdx_y;
+    float   m_duvdy_x;
+    float   m_duvdy_y;
+
     // World space intersection point.
     double  m_point_x;
     double  m_point_y;
     double  m_point_z;
 
-    // Constructor.
+    // Constructors.
     explicit SourceInputs(const foundation::Vector2f& uv);
+    SourceInputs(
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy);
 };
 
 }   // namespace renderer
@@ -31,11 +31,13 @@
 #include "texturesource.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/texturing/mipmap.h"
 #include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/modeling/entity/entity.h"
 #include "renderer/modeling/texture/texture.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/compressedtile.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/hash.h"
 #include "foundation/math/scalar.h"
@@ -43,6 +45,7 @@
 
 // Standard headers.
 #include <cassert>
+#include <cmath>
 
 using namespace foundation;
 using namespace std;
@@ -123,6 +126,7 @@ namespace
         TextureCache&               texture_cache,
         const UniqueID              assembly_uid,
         const UniqueID              texture_uid,
+        const size_t                level,
         const size_t                tile_x,
         const size_t                tile_y,
         const size_t                pixel_x,
@@ -130,12 +134,22 @@ namespace
         Color4f&                    sample)
     {
         // Retrieve the tile.
-        const Tile& tile =
+        const TextureStore::TileRecord& record =
             texture_cache.get(
                 assembly_uid,
                 texture_uid,
                 tile_x,
-                tile_y);
+                tile_y,
+                level);
+
+        // Decode compressed tiles.
+        if (record.m_compressed_tile)
+        {
+            record.m_compressed_tile->get_pixel(pixel_x, pixel_y, sample);
+            return;
+        }
+
+        const Tile& tile = *record.m_tile;
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -165,6 +179,17 @@ TextureSource::TextureSource(
   , m_max_x(static_cast<float>(m_texture_props.m_canvas_width - 1))
   , m_max_y(static_cast<float>(m_texture_props.m_canvas_height - 1))
 {
+    // Only trilinear filtering looks up coarser MIP levels.
+    const size_t level_count =
+        texture_instance.get_filtering_mode() == TextureFilteringTrilinear
+            ? get_mip_level_count(m_texture_props)
+            : 1;
+
+    m_level_props.reserve(level_count);
+    m_level_props.push_back(m_texture_props);
+
+    for (size_t i = 1; i < level_count; ++i)
+        m_level_props.push_back(get_mip_level_properties(m_texture_props, i));
 }
 
 uint64 TextureSource::compute_signature() const
@@ -194,17 +219,20 @@ Vector2f TextureSource::apply_transform(const Vector2f& uv) const
 
 Color4f TextureSource::get_texel(
     TextureCache&               texture_cache,
+    const size_t                level,
     const size_t                ix,
     const size_t                iy) const
 {
-    assert(ix < m_texture_props.m_canvas_width);
-    assert(iy < m_texture_props.m_canvas_height);
+    const CanvasProperties& props = m_level_props[level];
+
+    assert(ix < props.m_canvas_width);
+    assert(iy < props.m_canvas_height);
 
     // Compute the coordinates of the tile containing the texel (x, y).
-    const size_t tile_x = truncate<size_t>(ix * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y = truncate<size_t>(iy * m_texture_props.m_rcp_tile_height);
-    assert(tile_x < m_texture_props.m_tile_count_x);
-    assert(tile_y < m_texture_props.m_tile_count_y);
+    const size_t tile_x = truncate<size_t>(ix * props.m_rcp_tile_width);
+    const size_t tile_y = truncate<size_t>(iy * props.m_rcp_tile_height);
+    assert(tile_x < props.m_tile_count_x);
+    assert(tile_y < props.m_tile_count_y);
 
 #ifdef DEBUG_DISPLAY_TEXTURE_TILES
 
@@ -221,10 +249,10 @@ Color4f TextureSource::get_texel(
 #endif
 
     // Compute the tile space coordinates of the texel (x, y).
-    const size_t pixel_x = ix - tile_x * m_texture_props.m_tile_width;
-    const size_t pixel_y = iy - tile_y * m_texture_props.m_tile_height;
-    assert(pixel_x < m_texture_props.m_tile_width);
-    assert(pixel_y < m_texture_props.m_tile_height);
+    const size_t pixel_x = ix - tile_x * props.m_tile_width;
+    const size_t pixel_y = iy - tile_y * props.m_tile_height;
+    assert(pixel_x < props.m_tile_width);
+    assert(pixel_y < props.m_tile_height);
 
     // Sample the tile.
     Color4f sample;
@@ -232,6 +260,7 @@ Color4f TextureSource::get_texel(
         texture_cache,
         m_assembly_uid,
         m_texture_uid,
+        level,
         tile_x,
         tile_y,
         pixel_x,
@@ -243,6 +272,7 @@ Color4f TextureSource::get_texel(
 
 void TextureSource::get_texels_2x2(
     TextureCache&               texture_cache,
+    const size_t                level,
     const int                   ix,
     const int                   iy,
     Color4f&                    t00,
@@ -250,19 +280,21 @@ void TextureSource::get_texels_2x2(
     Color4f&                    t01,
     Color4f&                    t11) const
 {
+    const CanvasProperties& props = m_level_props[level];
+
     const Vector<size_t, 2> p00 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            props.m_canvas_width,
+            props.m_canvas_height,
             ix + 0,
             iy + 0);
 
     const Vector<size_t, 2> p11 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            props.m_canvas_width,
+            props.m_canvas_height,
             ix + 1,
             iy + 1);
 
@@ -270,10 +302,10 @@ void TextureSource::get_texels_2x2(
     const Vector<size_t, 2> p01(p00.x, p11.y);
 
     // Compute the coordinates of the tile containing each texel.
-    const size_t tile_x_00 = truncate<size_t>(p00.x * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y_00 = truncate<size_t>(p00.y * m_texture_props.m_rcp_tile_height);
-    const size_t tile_x_11 = truncate<size_t>(p11.x * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y_11 = truncate<size_t>(p11.y * m_texture_props.m_rcp_tile_height);
+    const size_t tile_x_00 = truncate<size_t>(p00.x * props.m_rcp_tile_width);
+    const size_t tile_y_00 = truncate<size_t>(p00.y * props.m_rcp_tile_height);
+    const size_t tile_x_11 = truncate<size_t>(p11.x * props.m_rcp_tile_width);
+    const size_t tile_y_11 = truncate<size_t>(p11.y * props.m_rcp_tile_height);
 
     // Check whether all four texels are part of the same tile.
     const size_t tile_x_mask = tile_x_00 ^ tile_x_11;
@@ -284,38 +316,51 @@ void TextureSource::get_texels_2x2(
         // Not all four texels are part of the same tile.
 
         // Compute the tile space coordinates of each texel.
-        const size_t pixel_x_00 = p00.x - tile_x_00 * m_texture_props.m_tile_width;
-        const size_t pixel_y_00 = p00.y - tile_y_00 * m_texture_props.m_tile_height;
-        const size_t pixel_x_11 = p11.x - tile_x_11 * m_texture_props.m_tile_width;
-        const size_t pixel_y_11 = p11.y - tile_y_11 * m_texture_props.m_tile_height;
+        const size_t pixel_x_00 = p00.x - tile_x_00 * props.m_tile_width;
+        const size_t pixel_y_00 = p00.y - tile_y_00 * props.m_tile_height;
+        const size_t pixel_x_11 = p11.x - tile_x_11 * props.m_tile_width;
+        const size_t pixel_y_11 = p11.y - tile_y_11 * props.m_tile_height;
 
         // Sample the tile.
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, pixel_x_00, pixel_y_00, t00);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, pixel_x_11, pixel_y_00, t10);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, pixel_x_00, pixel_y_11, t01);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, pixel_x_11, pixel_y_11, t11);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, level, tile_x_00, tile_y_00, pixel_x_00, pixel_y_00, t00);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, level, tile_x_11, tile_y_00, pixel_x_11, pixel_y_00, t10);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, level, tile_x_00, tile_y_11, pixel_x_00, pixel_y_11, t01);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, level, tile_x_11, tile_y_11, pixel_x_11, pixel_y_11, t11);
     }
     else
     {
         // All four texels are part of the same tile.
 
         // Compute the tile space coordinates of each texel.
-        const size_t org_x = tile_x_00 * m_texture_props.m_tile_width;
-        const size_t org_y = tile_y_00 * m_texture_props.m_tile_height;
+        const size_t org_x = tile_x_00 * props.m_tile_width;
+        const size_t org_y = tile_y_00 * props.m_tile_height;
         const size_t pixel_x_00 = p00.x - org_x;
         const size_t pixel_y_00 = p00.y - org_y;
         const size_t pixel_x_11 = p11.x - org_x;
         const size_t pixel_y_11 = p11.y - org_y;
 
         // Retrieve the tile.
-        const Tile& tile =
+        const TextureStore::TileRecord& record =
             texture_cache.get(
                 m_assembly_uid,
                 m_texture_uid,
                 tile_x_00,
-                tile_y_00);
+                tile_y_00,
+                level);
 
         // Sample the tile.
+        if (record.m_compressed_tile)
+        {
+            const CompressedTile& tile = *record.m_compressed_tile;
+            tile.get_pixel(pixel_x_00, pixel_y_00, t00);
+            tile.get_pixel(pixel_x_11, pixel_y_00, t10);
+            tile.get_pixel(pixel_x_00, pixel_y_11, t01);
+            tile.get_pixel(pixel_x_11, pixel_y_11, t11);
+            return;
+        }
+
+        const Tile& tile = *record.m_tile;
+
         if (tile.get_channel_count() == 3)
         {
             Color3f rgb;
@@ -354,12 +399,81 @@ void TextureSource::get_texels_2x2(
     }
 }
 
+Color4f TextureSource::sample_bilinear(
+    TextureCache&               texture_cache,
+    const size_t                level,
+    const Vector2f&             p) const
+{
+    const CanvasProperties& props = m_level_props[level];
+
+    const float x = p.x * static_cast<float>(props.m_canvas_width - 1);
+    const float y = p.y * static_cast<float>(props.m_canvas_height - 1);
+
+    const int ix = truncate<int>(x);
+    const int iy = truncate<int>(y);
+
+    // Retrieve the four surrounding texels.
+    Color4f t00, t10, t01, t11;
+    get_texels_2x2(
+        texture_cache,
+        level,
+        ix, iy,
+        t00, t10, t01, t11);
+
+    // Compute weights.
+    const float wx1 = x - ix;
+    const float wy1 = y - iy;
+    const float wx0 = 1.0f - wx1;
+    const float wy0 = 1.0f - wy1;
+
+    // Apply weights.
+    t00 *= wx0 * wy0;
+    t10 *= wx1 * wy0;
+    t01 *= wx0 * wy1;
+    t11 *= wx1 * wy1;
+
+    // Accumulate.
+    t00 += t10;
+    t00 += t01;
+    t00 += t11;
+
+    return t00;
+}
+
+float TextureSource::compute_mip_level(const SourceInputs& source_inputs) const
+{
+    //
+    // Reference:
+    //
+    //   Physically Based Rendering, second edition, pp. 615-616
+    //
+
+    // Transform the partial derivatives of the texture coordinates like the coordinates themselves.
+    const Vector3f dpdx =
+        m_texture_transform.vector_to_local(
+            Vector3f(source_inputs.m_duvdx_x, source_inputs.m_duvdx_y, 0.0f));
+    const Vector3f dpdy =
+        m_texture_transform.vector_to_local(
+            Vector3f(source_inputs.m_duvdy_x, source_inputs.m_duvdy_y, 0.0f));
+
+    // Compute the width of the footprint of the lookup in texels of level 0.
+    const float dx = norm(Vector2f(dpdx.x * m_scalar_canvas_width, dpdx.y * m_scalar_canvas_height));
+    const float dy = norm(Vector2f(dpdy.x * m_scalar_canvas_width, dpdy.y * m_scalar_canvas_height));
+    const float width = max(dx, dy);
+
+    // Level 0 is used for footprints smaller than one texel, including unknown footprints.
+    if (width <= 1.0f)
+        return 0.0f;
+
+    return min(log2(width), static_cast<float>(m_level_props.size() - 1));
+}
+
 Color4f TextureSource::sample_texture(
     TextureCache&               texture_cache,
-    const Vector2f&             uv) const
+    const SourceInputs&         source_inputs) const
 {
     // Start with the transformed input texture coordinates.
-    Vector2f p = apply_transform(uv);
+    Vector2f p = apply_transform(Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
     p.y = 1.0f - p.y;
 
     // Apply the texture addressing mode.
@@ -375,42 +489,29 @@ Color4f TextureSource::sample_texture(
             const size_t ix = truncate<size_t>(p.x);
             const size_t iy = truncate<size_t>(p.y);
 
-            return get_texel(texture_cache, ix, iy);
+            return get_texel(texture_cache, 0, ix, iy);
         }
 
       case TextureFilteringBilinear:
+        return sample_bilinear(texture_cache, 0, p);
+
+      case TextureFilteringTrilinear:
         {
-            p.x *= m_max_x;
-            p.y *= m_max_y;
-
-            const int ix = truncate<int>(p.x);
-            const int iy = truncate<int>(p.y);
-
-            // Retrieve the four surrounding texels.
-            Color4f t00, t10, t01, t11;
-            get_texels_2x2(
-                texture_cache,
-                ix, iy,
-                t00, t10, t01, t11);
-
-            // Compute weights.
-            const float wx1 = p.x - ix;
-            const float wy1 = p.y - iy;
-            const float wx0 = 1.0f - wx1;
-            const float wy0 = 1.0f - wy1;
-
-            // Apply weights.
-            t00 *= wx0 * wy0;
-            t10 *= wx1 * wy0;
-            t01 *= wx0 * wy1;
-            t11 *= wx1 * wy1;
-
-            // Accumulate.
-            t00 += t10;
-            t00 += t01;
-            t00 += t11;
-
-            return t00;
+            const float level = compute_mip_level(source_inputs);
+            const size_t level0 = truncate<size_t>(level);
+            const float w1 = level - level0;
+
+            Color4f result = sample_bilinear(texture_cache, level0, p);
+
+            // Blend with the next coarser level.
+            if (w1 > 0.0f)
+            {
+                assert(level0 + 1 < m_level_props.size());
+                result *= 1.0f - w1;
+                result += w1 * sample_bilinear(texture_cache, level0 + 1, p);
+            }
+
+            return result;
         }
 
       default:
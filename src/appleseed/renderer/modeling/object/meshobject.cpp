@@ -44,6 +44,7 @@
 
 // Standard headers.
 #include <cassert>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -66,6 +67,7 @@ struct MeshObject::Impl
 {
     StaticTriangleTess          m_tess;
     vector<string>              m_material_slots;
+    vector<shared_ptr<void>>    m_external_storage;
 };
 
 MeshObject::MeshObject(
@@ -277,6 +279,26 @@ void MeshObject::clear_triangles()
     impl->m_tess.m_primitives.clear();
 }
 
+void MeshObject::alias_vertices(GVector3* vertices, const size_t count)
+{
+    impl->m_tess.m_vertices.alias(vertices, count);
+}
+
+void MeshObject::alias_vertex_normals(GVector3* normals, const size_t count)
+{
+    impl->m_tess.m_vertex_normals.alias(normals, count);
+}
+
+void MeshObject::alias_triangles(Triangle* triangles, const size_t count)
+{
+    impl->m_tess.m_primitives.alias(triangles, count);
+}
+
+void MeshObject::retain_external_storage(shared_ptr<void> storage)
+{
+    impl->m_external_storage.push_back(storage);
+}
+
 void MeshObject::set_motion_segment_count(const size_t count)
 {
     impl->m_tess.set_motion_segment_count(count);
@@ -44,6 +44,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <memory>
 
 // Forward declarations.
 namespace foundation    { class Dictionary; }
@@ -120,6 +121,14 @@ class APPLESEED_DLLSYMBOL MeshObject
     Triangle& get_triangle(const size_t index);
     void clear_triangles();
 
+    // Make the vertex, vertex normal and triangle arrays refer to external memory such
+    // as a memory-mapped mesh file instead of storing copies. The object keeps a reference
+    // to the storage owning that memory. Inserting or clearing elements copies the array.
+    void alias_vertices(GVector3* vertices, const size_t count);
+    void alias_vertex_normals(GVector3* normals, const size_t count);  // the normals must be unit-length
+    void alias_triangles(Triangle* triangles, const size_t count);
+    void retain_external_storage(std::shared_ptr<void> storage);
+
     // Set/get the number of motion segments (the number of motion vectors per vertex).
     void set_motion_segment_count(const size_t count);
     size_t get_motion_segment_count() const;
@@ -46,6 +46,7 @@
 #include "foundation/mesh/genericmeshfilereader.h"
 #include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/imeshfilereader.h"
+#include "foundation/mesh/mappedmeshfile.h"
 #include "foundation/mesh/objmeshfilereader.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
@@ -65,7 +66,9 @@
 #include <cstddef>
 #include <exception>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 using namespace foundation;
@@ -291,6 +294,50 @@ namespace
             m_face_material = static_cast<uint32>(material);
         }
 
+        // Make the current mesh object use the geometry of a mesh of a mapped mesh file
+        // in place. Only texture coordinates and material slots are copied.
+        void alias_mesh(
+            const shared_ptr<MappedMeshFile>&   file,
+            const MappedMeshFile::Mesh&         mesh)
+        {
+            MeshObject* object = m_objects.back();
+
+            object->retain_external_storage(file);
+
+            object->alias_vertices(
+                reinterpret_cast<GVector3*>(mesh.m_vertices),
+                mesh.m_vertex_count);
+
+            object->alias_vertex_normals(
+                reinterpret_cast<GVector3*>(mesh.m_vertex_normals),
+                mesh.m_vertex_normal_count);
+            m_normal_count += mesh.m_vertex_normal_count;
+
+            object->reserve_tex_coords(mesh.m_tex_coords_count);
+            for (size_t i = 0; i < mesh.m_tex_coords_count; ++i)
+                object->push_tex_coords(mesh.m_tex_coords[i]);
+
+            for (size_t i = 0; i < mesh.m_material_slots.size(); ++i)
+                object->push_material_slot(mesh.m_material_slots[i]);
+
+            // The mapping is copy-on-write: this only duplicates the pages of the triangle array.
+            if (m_ignore_vertex_normals)
+            {
+                for (size_t i = 0; i < mesh.m_triangle_count; ++i)
+                {
+                    MappedMeshFile::Triangle& triangle = mesh.m_triangles[i];
+                    triangle.m_n0 = Triangle::None;
+                    triangle.m_n1 = Triangle::None;
+                    triangle.m_n2 = Triangle::None;
+                }
+            }
+
+            object->alias_triangles(
+                reinterpret_cast<Triangle*>(mesh.m_triangles),
+                mesh.m_triangle_count);
+            m_face_count += mesh.m_triangle_count;
+        }
+
       private:
         const ParamArray        m_params;
         const bool              m_ignore_vertex_normals;
@@ -394,6 +441,39 @@ namespace
         }
     };
 
+    // The geometry of mapped mesh files is used in place, so the file layout must match
+    // the in-memory layout of the renderer's geometry.
+    static_assert(
+        is_same<GVector3, Vector3f>::value && is_same<GVector2, Vector2f>::value,
+        "MappedMesh files require single-precision geometry");
+    static_assert(
+        sizeof(Triangle) == sizeof(MappedMeshFile::Triangle) &&
+        offsetof(Triangle, m_v0) == offsetof(MappedMeshFile::Triangle, m_v0) &&
+        offsetof(Triangle, m_n0) == offsetof(MappedMeshFile::Triangle, m_n0) &&
+        offsetof(Triangle, m_a0) == offsetof(MappedMeshFile::Triangle, m_a0) &&
+        offsetof(Triangle, m_pa) == offsetof(MappedMeshFile::Triangle, m_material),
+        "Layout of renderer::Triangle does not match the MappedMesh file format");
+
+    bool is_mapped_mesh_file(const char* filename)
+    {
+        return ends_with(lower_case(filename), ".mappedmesh");
+    }
+
+    void read_mapped_mesh_file(
+        const char*             filename,
+        MeshObjectBuilder&      builder)
+    {
+        const shared_ptr<MappedMeshFile> file = make_shared<MappedMeshFile>(filename);
+
+        for (size_t i = 0, e = file->get_mesh_count(); i < e; ++i)
+        {
+            const MappedMeshFile::Mesh& mesh = file->get_mesh(i);
+            builder.begin_mesh(mesh.m_name);
+            builder.alias_mesh(file, mesh);
+            builder.end_mesh();
+        }
+    }
+
     bool read_mesh_object(
         const char*             filename,
         const char*             base_object_name,
@@ -434,7 +514,9 @@ namespace
 
         try
         {
-            reader.read(builder);
+            if (is_mapped_mesh_file(filename))
+                read_mapped_mesh_file(filename, builder);
+            else reader.read(builder);
         }
         catch (const OBJMeshFileReader::ExceptionInvalidFaceDef& e)
         {
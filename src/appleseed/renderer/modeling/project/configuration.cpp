@@ -154,6 +154,22 @@ Dictionary Configuration::get_metadata()
             .insert("label", "Render Threads")
             .insert("help", "Number of threads to use for rendering"));
 
+    metadata.insert(
+        "work_stealing",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Work Stealing")
+            .insert("help", "Give each render thread its own queue of jobs and let idle threads steal jobs from busy ones"));
+
+    metadata.insert(
+        "pin_rendering_threads",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Pin Render Threads")
+            .insert("help", "Bind each render thread to a single logical CPU core"));
+
 #ifdef APPLESEED_WITH_EMBREE
 
     metadata.insert(
@@ -173,6 +189,24 @@ Dictionary Configuration::get_metadata()
         "texture_store",
         TextureStore::get_params_metadata());
 
+    metadata.dictionaries().insert(
+        "tree_cache",
+        Dictionary()
+            .insert(
+                "directory",
+                Dictionary()
+                    .insert("type", "text")
+                    .insert("default", "")
+                    .insert("label", "Acceleration Structures Cache")
+                    .insert("help", "Directory where ray tracing acceleration structures are kept across renders; caching is disabled if empty"))
+            .insert(
+                "max_size",
+                Dictionary()
+                    .insert("type", "int")
+                    .insert("default", "8589934592")
+                    .insert("label", "Acceleration Structures Cache Size")
+                    .insert("help", "Maximum size in bytes of the acceleration structures cache")));
+
     metadata.dictionaries().insert(
         "uniform_pixel_renderer",
         UniformPixelRendererFactory::get_params_metadata());
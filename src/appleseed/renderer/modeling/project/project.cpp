@@ -407,6 +407,14 @@ void Project::update_trace_context()
         impl->m_trace_context->update();
 }
 
+void Project::set_tree_cache(
+    const char*     directory,
+    const uint64    max_size)
+{
+    if (impl->m_trace_context.get() != nullptr)
+        impl->m_trace_context->set_tree_cache(directory, max_size);
+}
+
 #ifdef APPLESEED_WITH_EMBREE
 
 void Project::set_use_embree(const bool value)
@@ -50,6 +50,7 @@
 #include "renderer/modeling/volume/volumetraits.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/uid.h"
 
@@ -178,6 +179,12 @@ class APPLESEED_DLLSYMBOL Project
     // Synchronize the trace context with the scene.
     void update_trace_context();
 
+    // Persist ray tracing acceleration structures in a cache directory,
+    // or stop doing so if the directory is empty.
+    void set_tree_cache(
+        const char*                     directory,
+        const foundation::uint64        max_size);
+
 #ifdef APPLESEED_WITH_EMBREE
     // Set use Embree flag for trace context
     void set_use_embree(const bool value);
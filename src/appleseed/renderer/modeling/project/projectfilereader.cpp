@@ -109,12 +109,14 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apiarray.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/log.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/otherwise.h"
@@ -139,8 +141,10 @@
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <exception>
 #include <map>
 #include <memory>
+#include <new>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -207,6 +211,141 @@ namespace
     };
 
 
+    //
+    // A job that creates the objects defined by an <object> element,
+    // which usually involves reading and decoding geometry files.
+    //
+
+    class ObjectLoadJob
+      : public IJob
+    {
+      public:
+        typedef vector<Object*> ObjectVector;
+
+        ObjectLoadJob(
+            const IObjectFactory&   factory,
+            const string&           name,
+            const ParamArray&       params,
+            const SearchPaths&      search_paths,
+            const bool              omit_loading_assets)
+          : m_factory(factory)
+          , m_name(name)
+          , m_params(params)
+          , m_search_paths(search_paths)
+          , m_omit_loading_assets(omit_loading_assets)
+          , m_error_count(0)
+          , m_loading_time(0.0)
+        {
+        }
+
+        ~ObjectLoadJob() override
+        {
+            for (Object* object : m_objects)
+                object->release();
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            try
+            {
+                ObjectArray objects;
+                if (!m_factory.create(
+                        m_name.c_str(),
+                        m_params,
+                        m_search_paths,
+                        m_omit_loading_assets,
+                        objects))
+                    ++m_error_count;
+
+                m_objects = array_vector<ObjectVector>(objects);
+            }
+            catch (const ExceptionDictionaryKeyNotFound& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "while defining object \"%s\": required parameter \"%s\" missing.",
+                    m_name.c_str(),
+                    e.string());
+                ++m_error_count;
+            }
+            catch (const ExceptionUnknownEntity& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "while defining object \"%s\": unknown entity \"%s\".",
+                    m_name.c_str(),
+                    e.string());
+                ++m_error_count;
+            }
+            catch (const Exception& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "while defining object \"%s\": %s",
+                    m_name.c_str(),
+                    e.what());
+                ++m_error_count;
+            }
+            // Loads may run on worker threads which would swallow any other exception.
+            catch (const bad_alloc&)
+            {
+                RENDERER_LOG_ERROR(
+                    "while defining object \"%s\": ran out of memory.",
+                    m_name.c_str());
+                ++m_error_count;
+            }
+            catch (const exception& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "while defining object \"%s\": %s",
+                    m_name.c_str(),
+                    e.what());
+                ++m_error_count;
+            }
+            catch (...)
+            {
+                RENDERER_LOG_ERROR(
+                    "while defining object \"%s\": unknown exception.",
+                    m_name.c_str());
+                ++m_error_count;
+            }
+
+            stopwatch.measure();
+            m_loading_time = stopwatch.get_seconds();
+        }
+
+        // The following methods must only be called once the job has been executed.
+
+        size_t get_error_count() const
+        {
+            return m_error_count;
+        }
+
+        double get_loading_time() const
+        {
+            return m_loading_time;
+        }
+
+        // Transfer the ownership of the created objects to the caller.
+        ObjectVector release_objects()
+        {
+            ObjectVector objects;
+            objects.swap(m_objects);
+            return objects;
+        }
+
+      private:
+        const IObjectFactory&   m_factory;
+        const string            m_name;
+        const ParamArray        m_params;
+        const SearchPaths       m_search_paths;
+        const bool              m_omit_loading_assets;
+        ObjectVector            m_objects;
+        size_t                  m_error_count;
+        double                  m_loading_time;
+    };
+
+
     //
     // A set of objects that is passed to all element handlers.
     //
@@ -221,9 +360,20 @@ namespace
           : m_project(project)
           , m_options(options)
           , m_event_counters(event_counters)
+          , m_object_wait_time(0.0)
         {
         }
 
+        ~ParseContext()
+        {
+            // Object loads may still be in flight if parsing was interrupted.
+            if (m_job_manager)
+            {
+                m_job_queue.wait_until_completion();
+                m_job_manager->stop();
+            }
+        }
+
         Project& get_project()
         {
             return m_project;
@@ -239,10 +389,78 @@ namespace
             return m_event_counters;
         }
 
+        // Start loading objects. Loads run concurrently on a pool of threads while
+        // parsing continues, unless ProjectFileReader::OmitParallelLoading is set.
+        // The returned job remains valid for the lifetime of the context.
+        ObjectLoadJob* load_objects(unique_ptr<ObjectLoadJob> job)
+        {
+            ObjectLoadJob* job_ptr = job.get();
+            m_object_loads.push_back(move(job));
+
+            if (m_options & ProjectFileReader::OmitParallelLoading)
+                job_ptr->execute(0);
+            else
+            {
+                if (!m_job_manager)
+                {
+                    m_job_manager.reset(
+                        new JobManager(
+                            global_logger(),
+                            m_job_queue,
+                            System::get_logical_cpu_core_count()));
+                    m_job_manager->start();
+                }
+
+                m_job_queue.schedule(job_ptr, false);
+            }
+
+            return job_ptr;
+        }
+
+        // Wait until all objects loads started so far are completed.
+        void wait_for_object_loads()
+        {
+            if (!m_job_manager)
+                return;
+
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            m_job_queue.wait_until_completion();
+
+            stopwatch.measure();
+            m_object_wait_time += stopwatch.get_seconds();
+        }
+
+        // Return statistics about object loads.
+        size_t get_object_load_count() const
+        {
+            return m_object_loads.size();
+        }
+        size_t get_object_loading_thread_count() const
+        {
+            return m_job_manager ? m_job_manager->get_thread_count() : 1;
+        }
+        double get_object_loading_time() const
+        {
+            double loading_time = 0.0;
+            for (const auto& job : m_object_loads)
+                loading_time += job->get_loading_time();
+            return loading_time;
+        }
+        double get_object_wait_time() const
+        {
+            return m_object_wait_time;
+        }
+
       private:
-        Project&            m_project;
-        const int           m_options;
-        EventCounters&      m_event_counters;
+        Project&                            m_project;
+        const int                           m_options;
+        EventCounters&                      m_event_counters;
+        vector<unique_ptr<ObjectLoadJob>>   m_object_loads;
+        JobQueue                            m_job_queue;
+        unique_ptr<JobManager>              m_job_manager;
+        double                              m_object_wait_time;
     };
 
 
@@ -1527,10 +1745,9 @@ namespace
       : public ParametrizedElementHandler
     {
       public:
-        typedef vector<Object*> ObjectVector;
-
         explicit ObjectElementHandler(ParseContext& context)
           : m_context(context)
+          , m_load(nullptr)
         {
         }
 
@@ -1538,7 +1755,7 @@ namespace
         {
             ParametrizedElementHandler::start_element(attrs);
 
-            clear_keep_memory(m_objects);
+            m_load = nullptr;
 
             m_name = get_value(attrs, "name");
             m_model = get_value(attrs, "model");
@@ -1548,67 +1765,40 @@ namespace
         {
             ParametrizedElementHandler::end_element();
 
-            try
-            {
-                const IObjectFactory* factory =
-                    m_context.get_project().get_factory_registrar<Object>().lookup(m_model.c_str());
-
-                if (factory)
-                {
-                    ObjectArray objects;
-                    if (!factory->create(
-                            m_name.c_str(),
-                            m_params,
-                            m_context.get_project().search_paths(),
-                            m_context.get_options() & ProjectFileReader::OmitReadingMeshFiles,
-                            objects))
-                        m_context.get_event_counters().signal_error();
+            const IObjectFactory* factory =
+                m_context.get_project().get_factory_registrar<Object>().lookup(m_model.c_str());
 
-                    m_objects = array_vector<ObjectVector>(objects);
-                }
-                else
-                {
-                    RENDERER_LOG_ERROR(
-                        "while defining object \"%s\": invalid model \"%s\".",
-                        m_name.c_str(),
-                        m_model.c_str());
-                    m_context.get_event_counters().signal_error();
-                }
-            }
-            catch (const ExceptionDictionaryKeyNotFound& e)
-            {
-                RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": required parameter \"%s\" missing.",
-                    m_name.c_str(),
-                    e.string());
-                m_context.get_event_counters().signal_error();
-            }
-            catch (const ExceptionUnknownEntity& e)
+            if (factory)
             {
-                RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": unknown entity \"%s\".",
-                    m_name.c_str(),
-                    e.string());
-                m_context.get_event_counters().signal_error();
+                m_load =
+                    m_context.load_objects(
+                        unique_ptr<ObjectLoadJob>(
+                            new ObjectLoadJob(
+                                *factory,
+                                m_name,
+                                m_params,
+                                m_context.get_project().search_paths(),
+                                (m_context.get_options() & ProjectFileReader::OmitReadingMeshFiles) != 0)));
             }
-            catch (const Exception& e)
+            else
             {
                 RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": %s",
+                    "while defining object \"%s\": invalid model \"%s\".",
                     m_name.c_str(),
-                    e.what());
+                    m_model.c_str());
                 m_context.get_event_counters().signal_error();
             }
         }
 
-        const ObjectVector& get_objects() const
+        // Return the (possibly still running) load of the objects, or nullptr.
+        ObjectLoadJob* get_load() const
         {
-            return m_objects;
+            return m_load;
         }
 
       private:
         ParseContext&   m_context;
-        ObjectVector    m_objects;
+        ObjectLoadJob*  m_load;
         string          m_name;
         string          m_model;
     };
@@ -2090,6 +2280,7 @@ namespace
             m_lights.clear();
             m_materials.clear();
             m_objects.clear();
+            m_object_loads.clear();
             m_object_instances.clear();
             m_volumes.clear();
             m_shader_groups.clear();
@@ -2105,6 +2296,16 @@ namespace
         {
             ParametrizedElementHandler::end_element();
 
+            // Insert objects in declaration order once they are all loaded.
+            m_context.wait_for_object_loads();
+            for (ObjectLoadJob* load : m_object_loads)
+            {
+                m_context.get_event_counters().signal_errors(load->get_error_count());
+
+                for (Object* object : load->release_objects())
+                    insert(m_objects, auto_release_ptr<Object>(object));
+            }
+
             const IAssemblyFactory* factory =
                 m_context.get_project().get_factory_registrar<Assembly>().lookup(m_model.c_str());
 
@@ -2193,8 +2394,8 @@ namespace
                 break;
 
               case ElementObject:
-                for (Object* object : static_cast<ObjectElementHandler*>(handler)->get_objects())
-                    insert(m_objects, auto_release_ptr<Object>(object));
+                if (ObjectLoadJob* load = static_cast<ObjectElementHandler*>(handler)->get_load())
+                    m_object_loads.push_back(load);
                 break;
 
               case ElementObjectInstance:
@@ -2257,6 +2458,7 @@ namespace
         LightContainer              m_lights;
         MaterialContainer           m_materials;
         ObjectContainer             m_objects;
+        vector<ObjectLoadJob*>      m_object_loads;
         ObjectInstanceContainer     m_object_instances;
         VolumeContainer             m_volumes;
         ShaderGroupContainer        m_shader_groups;
@@ -3232,8 +3434,18 @@ auto_release_ptr<Project> ProjectFileReader::read(
             event_counters));
 
     if (project.get())
+    {
+        Stopwatch<DefaultWallclockTimer> postprocessing_stopwatch;
+        postprocessing_stopwatch.start();
+
         postprocess_project(project.ref(), event_counters, options);
 
+        postprocessing_stopwatch.measure();
+        RENDERER_LOG_INFO(
+            "post-processed project in %s.",
+            pretty_time(postprocessing_stopwatch.get_seconds()).c_str());
+    }
+
     stopwatch.measure();
 
     print_loading_results(
@@ -3419,6 +3631,8 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
 
     // Load the project file.
     RENDERER_LOG_INFO("loading project file %s...", project_filepath);
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
     try
     {
         parser->parse(project_filepath);
@@ -3431,6 +3645,27 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
     {
         return auto_release_ptr<Project>(nullptr);
     }
+    stopwatch.measure();
+
+    // Report per-phase timings. Object loads overlap parsing, so only the time
+    // spent waiting for them is included in the parsing time.
+    const size_t object_load_count = context.get_object_load_count();
+    RENDERER_LOG_INFO(
+        "parsed project file %s in %s.",
+        project_filepath,
+        pretty_time(stopwatch.get_seconds()).c_str());
+    if (object_load_count > 0)
+    {
+        const size_t thread_count = context.get_object_loading_thread_count();
+        RENDERER_LOG_INFO(
+            "loaded " FMT_SIZE_T " %s in %s (cumulative) using " FMT_SIZE_T " %s, waited %s for completion.",
+            object_load_count,
+            plural(object_load_count, "object").c_str(),
+            pretty_time(context.get_object_loading_time()).c_str(),
+            thread_count,
+            plural(thread_count, "thread").c_str(),
+            pretty_time(context.get_object_wait_time()).c_str());
+    }
 
     // Report a failure in case of warnings or errors.
     if (error_handler->get_warning_count() > 0 ||
@@ -57,7 +57,8 @@ class APPLESEED_DLLSYMBOL ProjectFileReader
         OmitReadingMeshFiles        = 1UL << 0,     // do not read mesh files from disk
         OmitProjectFileUpdate       = 1UL << 1,     // do not update the project file format to the latest revision
         OmitSearchPaths             = 1UL << 2,     // do not read search paths from the project
-        OmitProjectSchemaValidation = 1UL << 3      // do not validate project against schema
+        OmitProjectSchemaValidation = 1UL << 3,     // do not validate project against schema
+        OmitParallelLoading         = 1UL << 4      // load object geometry sequentially on the calling thread
     };
 
     // Read a project from disk (or load a built-in project).
@@ -125,6 +125,7 @@ void ShaderGroup::clear()
     impl->m_connections.clear();
     impl->m_shader_group_ref.reset();
     m_flags = 0;
+    m_raytype_queries = ~uint32(0);
 }
 
 void ShaderGroup::add_shader(
@@ -256,6 +257,8 @@ bool ShaderGroup::create_optimized_osl_shader_group(
         get_shadergroup_globals_info(shading_system);
         report_uses_global("dPdtime", UsesdPdTime);
 
+        get_shadergroup_raytype_info(shading_system);
+
         return true;
     }
     catch (const exception& e)
@@ -486,6 +489,34 @@ void ShaderGroup::report_uses_global(const char* global_name, const Flags flag)
     }
 }
 
+void ShaderGroup::get_shadergroup_raytype_info(OSLShadingSystem& shading_system)
+{
+    // Assume the shader group queries all ray types.
+    m_raytype_queries = ~uint32(0);
+
+    int raytype_queries = 0;
+    if (!shading_system.getattribute(
+            impl->m_shader_group_ref.get(),
+            "raytype_queries",
+            raytype_queries))
+    {
+        RENDERER_LOG_WARNING(
+            "getattribute: raytype_queries call failed for shader group \"%s\"; "
+            "assuming shader group queries all ray types.",
+            get_path().c_str());
+        return;
+    }
+
+    // A negative value means the ray types could not be determined.
+    if (raytype_queries >= 0)
+        m_raytype_queries = static_cast<uint32>(raytype_queries);
+
+    RENDERER_LOG_DEBUG(
+        "shader group \"%s\" queries ray types 0x%x.",
+        get_path().c_str(),
+        m_raytype_queries);
+}
+
 void ShaderGroup::set_surface_area(
     const AssemblyInstance* assembly_instance,
     const ObjectInstance*   object_instance,
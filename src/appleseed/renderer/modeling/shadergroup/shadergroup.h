@@ -134,6 +134,10 @@ class APPLESEED_DLLSYMBOL ShaderGroup
     // Return true if the shader group uses the dPdtime global.
     bool uses_dPdtime() const;
 
+    // Return the ray types (as VisibilityFlags) queried by the shader group.
+    // Executions that only differ by other ray types yield identical closures.
+    foundation::uint32 get_raytype_queries() const;
+
     // Return the surface area of an object.
     // Can only be called if the shader group has emission closures.
     float get_surface_area(
@@ -174,6 +178,7 @@ class APPLESEED_DLLSYMBOL ShaderGroup
         UsesAllGlobals  = UsesdPdTime
     };
     foundation::uint32 m_flags;
+    foundation::uint32 m_raytype_queries;
 
     // Constructor.
     explicit ShaderGroup(const char* name);
@@ -189,6 +194,8 @@ class APPLESEED_DLLSYMBOL ShaderGroup
     void get_shadergroup_globals_info(OSLShadingSystem& shading_system);
     void report_uses_global(const char* global_name, const Flags flag) const;
 
+    void get_shadergroup_raytype_info(OSLShadingSystem& shading_system);
+
     void set_surface_area(
         const AssemblyInstance* assembly_instance,
         const ObjectInstance*   object_instance,
@@ -263,4 +270,9 @@ inline bool ShaderGroup::uses_dPdtime() const
     return (m_flags & UsesdPdTime) != 0;
 }
 
+inline foundation::uint32 ShaderGroup::get_raytype_queries() const
+{
+    return m_raytype_queries;
+}
+
 }   // namespace renderer
@@ -117,7 +117,10 @@ namespace
             InputValues values;
             m_inputs.evaluate(
                 shading_context.get_texture_cache(),
-                SourceInputs(shading_point.get_uv(0)),
+                SourceInputs(
+                    shading_point.get_uv(0),
+                    shading_point.get_duvdx(0),
+                    shading_point.get_duvdy(0)),
                 &values);
 
             // Initialize the shading result.
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/texturing/mipmap.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/input/texturesource.h"
 #include "renderer/modeling/texture/texture.h"
@@ -39,6 +40,7 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/genericprogressiveimagefilereader.h"
@@ -53,6 +55,7 @@
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 #include <string>
 
@@ -80,6 +83,8 @@ namespace
             const SearchPaths&      search_paths)
           : Texture(name, params)
           , m_reader(&global_logger())
+          , m_mip_level_count(1)
+          , m_current_mip_level(0)
         {
             const EntityDefMessageContext context("texture", this);
 
@@ -163,6 +168,7 @@ namespace
         {
             boost::mutex::scoped_lock lock(m_mutex);
             open_image_file();
+            choose_mip_level(0);
             return m_reader.read_tile(tile_x, tile_y);
         }
 
@@ -174,6 +180,34 @@ namespace
             delete tile;
         }
 
+        size_t get_mip_level_count() override
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            open_image_file();
+            return m_mip_level_count;
+        }
+
+        Tile* load_mip_tile(
+            const size_t            level,
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            open_image_file();
+            assert(level > 0 && level < m_mip_level_count);
+            choose_mip_level(level);
+            return m_reader.read_tile(tile_x, tile_y);
+        }
+
+        void unload_mip_tile(
+            const size_t            level,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const Tile*             tile) override
+        {
+            delete tile;
+        }
+
       private:
         string                              m_filepath;
         ColorSpace                          m_color_space;
@@ -181,6 +215,8 @@ namespace
         mutable boost::mutex                m_mutex;
         GenericProgressiveImageFileReader   m_reader;
         CanvasProperties                    m_props;
+        size_t                              m_mip_level_count;
+        size_t                              m_current_mip_level;
 
         void open_image_file()
         {
@@ -192,6 +228,51 @@ namespace
 
                 m_reader.open(m_filepath.c_str());
                 m_reader.read_canvas_properties(m_props);
+
+                m_current_mip_level = 0;
+                m_mip_level_count = count_mip_levels();
+            }
+        }
+
+        // Count the MIP levels of the file that match the MIP pyramid of the texture store,
+        // stopping at the first one that doesn't.
+        size_t count_mip_levels()
+        {
+            const size_t max_level_count = renderer::get_mip_level_count(m_props);
+
+            size_t level_count = 1;
+
+            while (level_count < max_level_count && m_reader.choose_mip_level(level_count))
+            {
+                CanvasProperties props;
+                m_reader.read_canvas_properties(props);
+
+                const CanvasProperties expected_props = get_mip_level_properties(m_props, level_count);
+
+                if (props.m_canvas_width != expected_props.m_canvas_width ||
+                    props.m_canvas_height != expected_props.m_canvas_height ||
+                    props.m_tile_width != expected_props.m_tile_width ||
+                    props.m_tile_height != expected_props.m_tile_height ||
+                    props.m_channel_count != expected_props.m_channel_count ||
+                    props.m_pixel_format != expected_props.m_pixel_format)
+                    break;
+
+                ++level_count;
+            }
+
+            m_reader.choose_mip_level(0);
+
+            return level_count;
+        }
+
+        void choose_mip_level(const size_t level)
+        {
+            if (level != m_current_mip_level)
+            {
+                if (!m_reader.choose_mip_level(level))
+                    throw ExceptionIOError("failed to seek to MIP level of texture file", m_filepath.c_str());
+
+                m_current_mip_level = level;
             }
         }
     };
@@ -156,6 +156,11 @@ namespace
             // Nothing to do, the tile is owned by `m_image`.
         }
 
+        bool has_persistent_tiles() const override
+        {
+            return true;
+        }
+
       private:
         struct DummyTexture
         {
@@ -30,6 +30,9 @@
 // Interface header.
 #include "texture.h"
 
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionnotimplemented.h"
+
 using namespace foundation;
 
 namespace renderer
@@ -57,4 +60,31 @@ Texture::Texture(
     set_name(name);
 }
 
+bool Texture::has_persistent_tiles() const
+{
+    return false;
+}
+
+size_t Texture::get_mip_level_count()
+{
+    return 1;
+}
+
+Tile* Texture::load_mip_tile(
+    const size_t        level,
+    const size_t        tile_x,
+    const size_t        tile_y)
+{
+    throw ExceptionNotImplemented();
+}
+
+void Texture::unload_mip_tile(
+    const size_t        level,
+    const size_t        tile_x,
+    const size_t        tile_y,
+    const Tile*         tile)
+{
+    throw ExceptionNotImplemented();
+}
+
 }   // namespace renderer
@@ -93,6 +93,31 @@ class APPLESEED_DLLSYMBOL Texture
         const size_t                tile_x,
         const size_t                tile_y,
         const foundation::Tile*     tile) = 0;
+
+    // Return true if the tiles returned by load_tile() stay valid and unmodified for as long
+    // as the texture exists. The texture store then refers to these tiles instead of copying
+    // them when they need no conversion, and never unloads them. The default implementation
+    // returns false.
+    virtual bool has_persistent_tiles() const;
+
+    // Return the number of levels, including level 0, of the MIP pyramid stored with the texture.
+    // Stored levels must follow the layout described in renderer/kernel/texturing/mipmap.h.
+    // The default implementation returns 1: the texture store builds the other levels itself.
+    virtual size_t get_mip_level_count();
+
+    // Load a given tile of a stored MIP level other than level 0.
+    // The tile remains owned by the texture.
+    virtual foundation::Tile* load_mip_tile(
+        const size_t                level,
+        const size_t                tile_x,
+        const size_t                tile_y);
+
+    // Unload a given tile of a stored MIP level other than level 0.
+    virtual void unload_mip_tile(
+        const size_t                level,
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const foundation::Tile*     tile);
 };
 
 }   // namespace renderer
@@ -0,0 +1,789 @@
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "heterogeneousvolume.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/volume/sparsevolumegrid.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/volume/volume.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/hash.h"
+#include "foundation/math/phasefunction.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/casts.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/makevector.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const char* Model = "heterogeneous_volume";
+
+    // Below this transmission, ratio tracking applies Russian Roulette.
+    const float TransmissionRRThreshold = 0.1f;
+
+    Vector3f point_on_ray(const ShadingRay& ray, const float distance)
+    {
+        return Vector3f(ray.m_org + static_cast<double>(distance) * ray.m_dir);
+    }
+
+    float get_ray_extent(const ShadingRay& ray, const float distance)
+    {
+        return std::isinf(distance) ? std::numeric_limits<float>::max() : distance;
+    }
+
+    // Seed a random number generator from the geometry of a ray, for use by
+    // code paths which do not have access to a sampling context.
+    uint32 make_ray_seed(const ShadingRay& ray, const float distance)
+    {
+        const Vector3f org(ray.m_org);
+        const Vector3f dir(ray.m_dir);
+
+        const uint32 seed =
+            mix_uint32(
+                mix_uint32(
+                    binary_cast<uint32>(org.x),
+                    binary_cast<uint32>(org.y),
+                    binary_cast<uint32>(org.z)),
+                mix_uint32(
+                    binary_cast<uint32>(dir.x),
+                    binary_cast<uint32>(dir.y),
+                    binary_cast<uint32>(dir.z)),
+                binary_cast<uint32>(distance));
+
+        return seed != 0 ? seed : 1;
+    }
+
+    float sample_free_flight(Xorshift32& rng, const float majorant)
+    {
+        return -std::log(1.0f - rand_float2(rng)) / majorant;
+    }
+
+    //
+    // Ratio tracking estimator of the transmission along a ray segment.
+    //
+    // Reference:
+    //
+    //   Residual Ratio Tracking for Estimating Attenuation in Participating Media
+    //   Jan Novák, Andrew Selle, Wojciech Jarosz
+    //   https://jannovak.info/publications/RRTracking/RRTracking.pdf
+    //
+
+    struct RatioTrackingVisitor
+    {
+        const SparseVolumeGrid&     m_grid;
+        const Vector3f&             m_org;
+        const Vector3f&             m_dir;
+        const Spectrum&             m_extinction;
+        const float                 m_max_extinction;
+        Xorshift32&                 m_rng;
+        Spectrum                    m_transmission;
+
+        RatioTrackingVisitor(
+            const SparseVolumeGrid& grid,
+            const Vector3f&         org,
+            const Vector3f&         dir,
+            const Spectrum&         extinction,
+            const float             max_extinction,
+            Xorshift32&             rng)
+          : m_grid(grid)
+          , m_org(org)
+          , m_dir(dir)
+          , m_extinction(extinction)
+          , m_max_extinction(max_extinction)
+          , m_rng(rng)
+          , m_transmission(1.0f)
+        {
+        }
+
+        bool visit(const float t0, const float t1, const float majorant)
+        {
+            // Skip empty space.
+            if (majorant == 0.0f)
+                return true;
+
+            const float mu_bar = majorant * m_max_extinction;
+
+            for (float t = t0 + sample_free_flight(m_rng, mu_bar); t < t1; t += sample_free_flight(m_rng, mu_bar))
+            {
+                const float density = m_grid.lookup(m_org + t * m_dir);
+                const float rcp_mu_bar = 1.0f / mu_bar;
+
+                for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+                    m_transmission[i] *= std::max(1.0f - density * m_extinction[i] * rcp_mu_bar, 0.0f);
+
+                // Russian Roulette on low transmission.
+                const float max_transmission = max_value(m_transmission);
+                if (max_transmission < TransmissionRRThreshold)
+                {
+                    if (rand_float2(m_rng) >= max_transmission)
+                    {
+                        m_transmission.set(0.0f);
+                        return false;
+                    }
+
+                    m_transmission /= max_transmission;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    //
+    // Spectral tracking: delta tracking against a scalar majorant with collision
+    // probabilities proportional to the path throughput.
+    //
+    // Reference:
+    //
+    //   Spectral and Decomposition Tracking for Rendering Heterogeneous Volumes
+    //   Peter Kutz, Ralf Habel, Yining Karl Li, Jan Novák
+    //   https://jannovak.info/publications/SDTracking/SDTracking.pdf
+    //
+
+    struct SpectralTrackingVisitor
+    {
+        enum Event { Escaped, Scattered, Absorbed };
+
+        const SparseVolumeGrid&     m_grid;
+        const Vector3f&             m_org;
+        const Vector3f&             m_dir;
+        const Spectrum&             m_absorption;
+        const Spectrum&             m_scattering;
+        const Spectrum&             m_extinction;
+        const float                 m_max_extinction;
+        Xorshift32&                 m_rng;
+        Spectrum                    m_weight;
+        float                       m_distance;
+        Event                       m_event;
+
+        SpectralTrackingVisitor(
+            const SparseVolumeGrid& grid,
+            const Vector3f&         org,
+            const Vector3f&         dir,
+            const Spectrum&         absorption,
+            const Spectrum&         scattering,
+            const Spectrum&         extinction,
+            const float             max_extinction,
+            Xorshift32&             rng)
+          : m_grid(grid)
+          , m_org(org)
+          , m_dir(dir)
+          , m_absorption(absorption)
+          , m_scattering(scattering)
+          , m_extinction(extinction)
+          , m_max_extinction(max_extinction)
+          , m_rng(rng)
+          , m_weight(1.0f)
+          , m_distance(0.0f)
+          , m_event(Escaped)
+        {
+        }
+
+        bool visit(const float t0, const float t1, const float majorant)
+        {
+            // Skip empty space.
+            if (majorant == 0.0f)
+                return true;
+
+            const float mu_bar = majorant * m_max_extinction;
+
+            for (float t = t0 + sample_free_flight(m_rng, mu_bar); t < t1; t += sample_free_flight(m_rng, mu_bar))
+            {
+                const float density = m_grid.lookup(m_org + t * m_dir);
+
+                Spectrum mu_a(m_absorption);
+                mu_a *= density;
+
+                Spectrum mu_s(m_scattering);
+                mu_s *= density;
+
+                Spectrum mu_n(m_extinction);
+                mu_n *= -density;
+                mu_n += Spectrum(mu_bar);
+                for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+                    mu_n[i] = std::max(mu_n[i], 0.0f);
+
+                // Event probabilities, proportional to the throughput-weighted coefficients.
+                Spectrum w(mu_a);
+                w *= m_weight;
+                const float p_a = average_value(w);
+
+                w = mu_s;
+                w *= m_weight;
+                const float p_s = average_value(w);
+
+                w = mu_n;
+                w *= m_weight;
+                const float p_n = average_value(w);
+
+                const float c = p_a + p_s + p_n;
+                if (c <= 0.0f)
+                {
+                    m_event = Absorbed;
+                    return false;
+                }
+
+                const float u = rand_float2(m_rng) * c;
+
+                if (u < p_a)
+                {
+                    m_event = Absorbed;
+                    return false;
+                }
+                else if (u < p_a + p_s)
+                {
+                    m_weight *= mu_s;
+                    m_weight *= c / (mu_bar * p_s);
+                    m_distance = t;
+                    m_event = Scattered;
+                    return false;
+                }
+                else
+                {
+                    m_weight *= mu_n;
+                    m_weight *= c / (mu_bar * p_n);
+                }
+            }
+
+            return true;
+        }
+    };
+}
+
+
+//
+// Heterogeneous volume.
+//
+
+class HeterogeneousVolume
+  : public Volume
+{
+  public:
+    HeterogeneousVolume(
+        const char*         name,
+        const ParamArray&   params)
+      : Volume(name, params)
+    {
+        m_inputs.declare("absorption", InputFormatSpectralReflectance);
+        m_inputs.declare("absorption_multiplier", InputFormatFloat, "1.0");
+        m_inputs.declare("scattering", InputFormatSpectralReflectance);
+        m_inputs.declare("scattering_multiplier", InputFormatFloat, "1.0");
+        m_inputs.declare("average_cosine", InputFormatFloat, "0.0");
+    }
+
+    void release() override
+    {
+        delete this;
+    }
+
+    const char* get_model() const override
+    {
+        return Model;
+    }
+
+    bool on_frame_begin(
+        const Project&          project,
+        const BaseGroup*        parent,
+        OnFrameBeginRecorder&   recorder,
+        IAbortSwitch*           abort_switch) override
+    {
+        if (!Volume::on_frame_begin(project, parent, recorder, abort_switch))
+            return false;
+
+        const OnFrameBeginMessageContext context("volume", this);
+
+        const std::string phase_function =
+            m_params.get_required<std::string>(
+                "phase_function_model",
+                "isotropic",
+                make_vector("isotropic", "henyey"),
+                context);
+
+        if (phase_function == "isotropic")
+            m_phase_function.reset(new IsotropicPhaseFunction());
+        else if (phase_function == "henyey")
+        {
+            const float g =
+                clamp(
+                    m_params.get_optional<float>("average_cosine", 0.0f),
+                    -0.99f, +0.99f);
+            m_phase_function.reset(new HenyeyPhaseFunction(g));
+        }
+        else return false;
+
+        // Load the density grid, unless it was already loaded during a previous frame.
+        const std::string filepath =
+            to_string(
+                project.search_paths().qualify(
+                    m_params.get_required<std::string>("filename", "", context)));
+
+        if (m_grid.get() == nullptr || filepath != m_grid_filepath)
+        {
+            m_grid = read_sparse_volume_grid(filepath.c_str());
+            m_grid_filepath = filepath;
+
+            if (m_grid.get() == nullptr)
+            {
+                RENDERER_LOG_ERROR(
+                    "%sfailed to load sparse volume grid %s.",
+                    context.get(),
+                    filepath.c_str());
+                return false;
+            }
+
+            RENDERER_LOG_INFO(
+                "%sloaded sparse volume grid %s: " FMT_SIZE_T "x" FMT_SIZE_T "x" FMT_SIZE_T " voxels, "
+                "%s of %s bricks stored, %s.",
+                context.get(),
+                filepath.c_str(),
+                m_grid->get_xres(),
+                m_grid->get_yres(),
+                m_grid->get_zres(),
+                pretty_uint(m_grid->get_stored_brick_count()).c_str(),
+                pretty_uint(m_grid->get_brick_xres() * m_grid->get_brick_yres() * m_grid->get_brick_zres()).c_str(),
+                pretty_size(m_grid->get_memory_size()).c_str());
+        }
+
+        return true;
+    }
+
+    bool is_homogeneous() const override
+    {
+        return false;
+    }
+
+    size_t compute_input_data_size() const override
+    {
+        return sizeof(InputValues);
+    }
+
+    void prepare_inputs(
+        Arena&              arena,
+        const ShadingRay&   volume_ray,
+        void*               data) const override
+    {
+        InputValues* values = static_cast<InputValues*>(data);
+
+        values->m_absorption *= values->m_absorption_multiplier;
+        values->m_scattering *= values->m_scattering_multiplier;
+
+        // Precompute extinction.
+        values->m_precomputed.m_extinction = values->m_absorption + values->m_scattering;
+        values->m_precomputed.m_max_extinction = max_value(values->m_precomputed.m_extinction);
+    }
+
+    float sample(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Vector3f&           incoming) const override
+    {
+        sampling_context.split_in_place(2, 1);
+        const Vector2f s = sampling_context.next2<Vector2f>();
+
+        const Vector3f outgoing(normalize(volume_ray.m_dir));
+        return m_phase_function->sample(outgoing, s, incoming);
+    }
+
+    float evaluate(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        const Vector3f&     incoming) const override
+    {
+        const Vector3f outgoing = Vector3f(normalize(volume_ray.m_dir));
+        return m_phase_function->evaluate(outgoing, incoming);
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        if (values->m_precomputed.m_max_extinction == 0.0f)
+        {
+            spectrum.set(1.0f);
+            return;
+        }
+
+        const Vector3f org(volume_ray.m_org);
+        const Vector3f dir(volume_ray.m_dir);
+        Xorshift32 rng(make_ray_seed(volume_ray, distance));
+
+        RatioTrackingVisitor visitor(
+            *m_grid,
+            org,
+            dir,
+            values->m_precomputed.m_extinction,
+            values->m_precomputed.m_max_extinction,
+            rng);
+
+        m_grid->traverse(org, dir, 0.0f, get_ray_extent(volume_ray, distance), visitor);
+
+        spectrum = visitor.m_transmission;
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        Spectrum&           spectrum) const override
+    {
+        // The volume is bounded, so infinite rays are not fully absorbed.
+        const float distance =
+            volume_ray.is_finite()
+                ? static_cast<float>(volume_ray.get_length())
+                : std::numeric_limits<float>::infinity();
+
+        evaluate_transmission(data, volume_ray, distance, spectrum);
+    }
+
+    void scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_scattering;
+        spectrum *= m_grid->lookup(point_on_ray(volume_ray, distance));
+    }
+
+    const Spectrum& scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_scattering;
+    }
+
+    void absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_absorption;
+        spectrum *= m_grid->lookup(point_on_ray(volume_ray, distance));
+    }
+
+    const Spectrum& absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_absorption;
+    }
+
+    void extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_precomputed.m_extinction;
+        spectrum *= m_grid->lookup(point_on_ray(volume_ray, distance));
+    }
+
+    const Spectrum& extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_extinction;
+    }
+
+    bool sample_distance(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        float&              distance,
+        Spectrum&           weight) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        if (values->m_precomputed.m_max_extinction == 0.0f)
+        {
+            weight.set(1.0f);
+            return false;
+        }
+
+        // Seed the random number generator used for tracking.
+        sampling_context.split_in_place(1, 1);
+        const uint32 seed =
+            mix_uint32(
+                truncate<uint32>(sampling_context.next2<float>() * 4294967295.0f),
+                make_ray_seed(volume_ray, 0.0f));
+        Xorshift32 rng(seed != 0 ? seed : 1);
+
+        const Vector3f org(volume_ray.m_org);
+        const Vector3f dir(volume_ray.m_dir);
+
+        SpectralTrackingVisitor visitor(
+            *m_grid,
+            org,
+            dir,
+            values->m_absorption,
+            values->m_scattering,
+            values->m_precomputed.m_extinction,
+            values->m_precomputed.m_max_extinction,
+            rng);
+
+        const float tmax =
+            volume_ray.is_finite()
+                ? static_cast<float>(volume_ray.get_length())
+                : std::numeric_limits<float>::max();
+
+        m_grid->traverse(org, dir, 0.0f, tmax, visitor);
+
+        switch (visitor.m_event)
+        {
+          case SpectralTrackingVisitor::Scattered:
+            distance = visitor.m_distance;
+            weight = visitor.m_weight;
+            return true;
+
+          case SpectralTrackingVisitor::Absorbed:
+            weight.set(0.0f);
+            return false;
+
+          default:
+            weight = visitor.m_weight;
+            return false;
+        }
+    }
+
+    bool sample_majorant_distance(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         extinction,
+        const float         s,
+        float&              distance) const override
+    {
+        if (!(extinction > 0.0f))
+            return false;
+
+        return
+            m_grid->sample_majorant_distance(
+                Vector3f(volume_ray.m_org),
+                Vector3f(volume_ray.m_dir),
+                get_ray_extent(volume_ray, static_cast<float>(volume_ray.m_tmax)),
+                extinction,
+                s,
+                distance);
+    }
+
+    float evaluate_majorant_distance_pdf(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         extinction,
+        const float         distance) const override
+    {
+        if (!(extinction > 0.0f))
+            return 0.0f;
+
+        return
+            m_grid->evaluate_majorant_distance_pdf(
+                Vector3f(volume_ray.m_org),
+                Vector3f(volume_ray.m_dir),
+                get_ray_extent(volume_ray, static_cast<float>(volume_ray.m_tmax)),
+                extinction,
+                distance);
+    }
+
+  private:
+    typedef HeterogeneousVolumeInputValues InputValues;
+
+    std::unique_ptr<PhaseFunction>      m_phase_function;
+    std::unique_ptr<SparseVolumeGrid>   m_grid;
+    std::string                         m_grid_filepath;
+};
+
+
+//
+// HeterogeneousVolumeFactory class implementation.
+//
+
+void HeterogeneousVolumeFactory::release()
+{
+    delete this;
+}
+
+const char* HeterogeneousVolumeFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary HeterogeneousVolumeFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "Heterogeneous Volume");
+}
+
+DictionaryArray HeterogeneousVolumeFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "filename")
+            .insert("label", "Density Grid File")
+            .insert("type", "file")
+            .insert("file_picker_mode", "open")
+            .insert("file_picker_type", "other")
+            .insert("use", "required"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption")
+            .insert("label", "Absorption Coefficient")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption_multiplier")
+            .insert("label", "Absorption Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering")
+            .insert("label", "Scattering Coefficient")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering_multiplier")
+            .insert("label", "Scattering Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "phase_function_model")
+            .insert("label", "Phase Function Model")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Isotropic", "isotropic")
+                    .insert("Henyey-Greenstein", "henyey"))
+            .insert("use", "required")
+            .insert("default", "isotropic")
+            .insert("on_change", "rebuild_form"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "average_cosine")
+            .insert("label", "Average Cosine (g)")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "-1.0")
+                    .insert("type", "soft"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "1.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "0.0")
+            .insert("visible_if",
+                Dictionary().insert("phase_function_model", "henyey")));
+
+    return metadata;
+}
+
+auto_release_ptr<Volume> HeterogeneousVolumeFactory::create(
+    const char*         name,
+    const ParamArray&   params) const
+{
+    return auto_release_ptr<Volume>(new HeterogeneousVolume(name, params));
+}
+
+}   // namespace renderer
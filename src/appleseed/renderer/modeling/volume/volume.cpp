@@ -35,6 +35,7 @@
 #include "renderer/modeling/input/inputarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/sampling/mappings.h"
 #include "foundation/utility/arena.h"
 
 using namespace foundation;
@@ -87,4 +88,50 @@ void Volume::prepare_inputs(
 {
 }
 
+bool Volume::sample_distance(
+    SamplingContext&        sampling_context,
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    float&                  distance,
+    Spectrum&               weight) const
+{
+    evaluate_transmission(data, volume_ray, weight);
+    return false;
+}
+
+bool Volume::sample_majorant_distance(
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    const float             extinction,
+    const float             s,
+    float&                  distance) const
+{
+    if (!(extinction > 0.0f))
+        return false;
+
+    distance =
+        volume_ray.is_finite()
+            ? sample_exponential_distribution_on_segment(
+                  s, extinction, 0.0f, static_cast<float>(volume_ray.get_length()))
+            : sample_exponential_distribution(s, extinction);
+
+    return true;
+}
+
+float Volume::evaluate_majorant_distance_pdf(
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    const float             extinction,
+    const float             distance) const
+{
+    if (!(extinction > 0.0f))
+        return 0.0f;
+
+    return
+        volume_ray.is_finite()
+            ? exponential_distribution_on_segment_pdf(
+                  distance, extinction, 0.0f, static_cast<float>(volume_ray.get_length()))
+            : exponential_distribution_pdf(distance, extinction);
+}
+
 }   // namespace renderer
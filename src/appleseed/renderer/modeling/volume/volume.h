@@ -152,6 +152,43 @@ class APPLESEED_DLLSYMBOL Volume
     virtual const Spectrum& extinction_coefficient(
         const void*                 data,                       // input values
         const ShadingRay&           volume_ray) const = 0;      // ray used for marching inside the volume
+
+    //
+    // The methods below allow to render heterogeneous volumes by tracking: for such volumes,
+    // extinction_coefficient(data, volume_ray) returns the extinction coefficient of the
+    // media at unit density, and distances are sampled against an upper bound (majorant)
+    // of the extinction along the ray.
+    //
+
+    // Sample the distance to the next scattering event along the ray. Return true if a
+    // scattering event was sampled, in which case weight receives the transmission up to
+    // the event times the scattering coefficient at the event, divided by the probability
+    // density of the event. Otherwise, the ray either leaves the volume and weight receives
+    // the transmission of the ray divided by the probability of leaving the volume, or
+    // is absorbed and weight is zero. The default implementation never scatters.
+    virtual bool sample_distance(
+        SamplingContext&            sampling_context,
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        float&                      distance,                   // sampled distance
+        Spectrum&                   weight) const;              // throughput weight of the sampled event
+
+    // Sample a distance on the ray proportionally to the majorant of the extinction, given the
+    // extinction coefficient at unit density of a spectral channel. Return false if the majorant
+    // is zero along the whole ray. The default implementation uses the extinction itself.
+    virtual bool sample_majorant_distance(
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        const float                 extinction,                 // extinction coefficient at unit density
+        const float                 s,                          // uniform sample in [0, 1)
+        float&                      distance) const;            // sampled distance
+
+    // Evaluate the PDF value of sampling a given distance with sample_majorant_distance().
+    virtual float evaluate_majorant_distance_pdf(
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        const float                 extinction,                 // extinction coefficient at unit density
+        const float                 distance) const;            // distance to the point on this volume segment
 };
 
 }   // namespace renderer
@@ -32,6 +32,7 @@
 // appleseed.renderer headers.
 #include "renderer/modeling/entity/entityfactoryregistrar.h"
 #include "renderer/modeling/volume/genericvolume.h"
+#include "renderer/modeling/volume/heterogeneousvolume.h"
 #include "renderer/modeling/volume/volumetraits.h"
 
 // appleseed.foundation headers.
@@ -58,6 +59,7 @@ VolumeFactoryRegistrar::VolumeFactoryRegistrar(const SearchPaths& search_paths)
 {
     // Register built-in factories.
     impl->register_factory(auto_release_ptr<FactoryType>(new GenericVolumeFactory()));
+    impl->register_factory(auto_release_ptr<FactoryType>(new HeterogeneousVolumeFactory()));
 }
 
 VolumeFactoryRegistrar::~VolumeFactoryRegistrar()
@@ -36,6 +36,7 @@
 // appleseed.foundation headers.
 #include "foundation/platform/system.h"
 #include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/string.h"
 
@@ -158,4 +159,17 @@ size_t get_rendering_thread_count(const ParamArray& params)
     return thread_count;
 }
 
+int get_rendering_thread_flags(const ParamArray& params)
+{
+    int flags = 0;
+
+    if (params.get_optional<bool>("work_stealing", false))
+        flags |= JobManager::WorkStealing;
+
+    if (params.get_optional<bool>("pin_rendering_threads", false))
+        flags |= JobManager::PinWorkerThreads;
+
+    return flags;
+}
+
 }   // namespace renderer
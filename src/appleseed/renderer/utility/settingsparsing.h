@@ -55,4 +55,7 @@ std::string get_sampling_context_mode_name(const SamplingContext::Mode mode);
 // Rendering threads.
 APPLESEED_DLLSYMBOL size_t get_rendering_thread_count(const ParamArray& params);
 
+// Scheduling flags of the rendering threads (see foundation::JobManager::Flags).
+APPLESEED_DLLSYMBOL int get_rendering_thread_flags(const ParamArray& params);
+
 }   // namespace renderer